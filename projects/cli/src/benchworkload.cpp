@@ -0,0 +1,383 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "benchworkload.h"
+#include <cmath>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QFile>
+#include <board/board.h>
+#include <board/boardfactory.h>
+#include <pgnstream.h>
+#include <perft.h>
+#include <openingsuite.h>
+#include <polyglotbook.h>
+#include <randomstream.h>
+#include <gamemanager.h>
+#include <tournament.h>
+#include <tournamentfactory.h>
+#include <gameadjudicator.h>
+#include <enginebuilder.h>
+#include <engineconfiguration.h>
+#include <timecontrol.h>
+#include <chessgame.h>
+#include <mockengine.h>
+
+namespace {
+
+// Changing any of these changes the workload, and makes the scores
+// incomparable with those of earlier versions
+const quint64 s_seed = 20181001;
+const int s_maxPlies = 120;
+const int s_openingPicks = 20000;
+const int s_bookPlies = 24;
+
+struct PerftRun
+{
+	const char* variant;
+	int depth;
+};
+
+const PerftRun s_perftRuns[] = {
+	{ "standard", 4 },
+	{ "crazyhouse", 3 },
+	{ "capablanca", 3 },
+	{ "atomic", 3 },
+	{ "seirawan", 3 },
+	{ "horde", 3 },
+	{ "makruk", 3 },
+	{ "3check", 3 }
+};
+
+} // anonymous namespace
+
+double BenchWorkload::Stage::rate() const
+{
+	return work * 1.0e9 / qMax(qint64(1), nsecs);
+}
+
+BenchWorkload::BenchWorkload()
+	: m_corpusSize(500),
+	  m_tournamentGames(20),
+	  m_concurrency(2)
+{
+}
+
+void BenchWorkload::setCorpusSize(int games)
+{
+	m_corpusSize = qMax(1, games);
+}
+
+void BenchWorkload::setTournamentGames(int games)
+{
+	m_tournamentGames = qMax(0, games);
+}
+
+void BenchWorkload::setConcurrency(int concurrency)
+{
+	m_concurrency = qMax(1, concurrency);
+}
+
+QList<BenchWorkload::Stage> BenchWorkload::stages() const
+{
+	return m_stages;
+}
+
+double BenchWorkload::score() const
+{
+	if (m_stages.isEmpty())
+		return 0.0;
+
+	double logSum = 0.0;
+	for (const Stage& stage : m_stages)
+		logSum += std::log(qMax(1.0, stage.rate()));
+	return std::exp(logSum / m_stages.size());
+}
+
+void BenchWorkload::addStage(const QString& name,
+			     qint64 work,
+			     const QString& unit,
+			     qint64 nsecs)
+{
+	const Stage stage = { name, work, unit, nsecs };
+	m_stages.append(stage);
+}
+
+bool BenchWorkload::run()
+{
+	m_stages.clear();
+	m_corpus.clear();
+
+	generateCorpus();
+	if (!runPgn() || !runSan())
+		return false;
+	runPerft();
+	if (!runOpenings() || !runBook())
+		return false;
+	return m_tournamentGames == 0 || runTournament();
+}
+
+void BenchWorkload::generateCorpus()
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	qint64 plies = 0;
+	Chess::MoveList moves;
+	m_corpus.reserve(m_corpusSize);
+	for (int i = 0; i < m_corpusSize; i++)
+	{
+		RandomStream stream(s_seed, quint64(i));
+		QScopedPointer<Chess::Board> board(Chess::BoardFactory::create("standard"));
+		board->reset();
+
+		PgnGame game;
+		game.setEvent("bench");
+		game.setRound(i + 1);
+		game.setPlayerName(Chess::Side::White, "White");
+		game.setPlayerName(Chess::Side::Black, "Black");
+
+		for (int ply = 0; ply < s_maxPlies && board->result().isNone(); ply++)
+		{
+			board->legalMoves(moves);
+			const Chess::Move move(moves.at(int(stream.next() % moves.size())));
+
+			PgnGame::MoveData md;
+			md.key = board->key();
+			md.move = board->genericMove(move);
+			md.moveString = board->moveString(move, Chess::Board::StandardAlgebraic);
+			game.addMove(md);
+
+			board->makeMove(move);
+			plies++;
+		}
+		game.setResult(board->result());
+		m_corpus.append(game);
+	}
+
+	addStage("movegen", plies, "plies", timer.nsecsElapsed());
+}
+
+bool BenchWorkload::runPgn()
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QByteArray data;
+	for (const PgnGame& game : qAsConst(m_corpus))
+		game.write(&data);
+
+	int count = 0;
+	PgnStream in(&data);
+	PgnGame game;
+	while (game.read(in))
+		count++;
+
+	if (count != m_corpus.size())
+	{
+		qWarning("The bench PGN stage read %d games instead of %d",
+			 count, m_corpus.size());
+		return false;
+	}
+
+	addStage("pgn", 2 * count, "games", timer.nsecsElapsed());
+	return true;
+}
+
+bool BenchWorkload::runSan()
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	qint64 count = 0;
+	for (const PgnGame& game : qAsConst(m_corpus))
+	{
+		QScopedPointer<Chess::Board> board(game.createBoard());
+		const auto moves = game.moves();
+		for (const PgnGame::MoveData& md : moves)
+		{
+			const Chess::Move move(board->moveFromString(md.moveString));
+			if (move.isNull()
+			||  board->moveString(move, Chess::Board::StandardAlgebraic) != md.moveString)
+			{
+				qWarning("The bench SAN stage failed at move %s",
+					 qUtf8Printable(md.moveString));
+				return false;
+			}
+			board->makeMove(move);
+			count++;
+		}
+	}
+
+	addStage("san", count, "moves", timer.nsecsElapsed());
+	return true;
+}
+
+void BenchWorkload::runPerft()
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	// One thread keeps the work the same on every host
+	Perft perft;
+	perft.setThreadCount(1);
+	perft.setHashSize(16);
+
+	quint64 nodes = 0;
+	for (const PerftRun& run : s_perftRuns)
+	{
+		if (perft.setPosition(run.variant, QString()))
+			nodes += perft.count(run.depth);
+	}
+
+	addStage("perft", qint64(nodes), "nodes", timer.nsecsElapsed());
+}
+
+bool BenchWorkload::runOpenings()
+{
+	QTemporaryDir dir;
+	const QString fileName(dir.path() + "/bench.epd");
+	QFile file(fileName);
+	if (!dir.isValid() || !file.open(QIODevice::WriteOnly))
+	{
+		qWarning("Can't create the bench opening suite");
+		return false;
+	}
+
+	// Every tenth position of each game, written outside the timer
+	QByteArray epd;
+	for (const PgnGame& game : qAsConst(m_corpus))
+	{
+		QScopedPointer<Chess::Board> board(game.createBoard());
+		const auto moves = game.moves();
+		for (int i = 0; i < moves.size(); i++)
+		{
+			if (i % 10 == 0)
+				epd += board->fenString().toUtf8() + '\n';
+			board->makeMove(board->moveFromGenericMove(moves.at(i).move));
+		}
+	}
+	file.write(epd);
+	file.close();
+
+	QElapsedTimer timer;
+	timer.start();
+
+	OpeningSuite suite(fileName, OpeningSuite::EpdFormat,
+			   OpeningSuite::RandomOrder);
+	if (!suite.initialize())
+	{
+		qWarning("Can't read the bench opening suite");
+		return false;
+	}
+
+	RandomStream stream(s_seed, quint64(m_corpusSize));
+	RandomStream::Scope scope(&stream);
+	for (int i = 0; i < s_openingPicks; i++)
+		suite.nextGame(0);
+
+	addStage("openings", s_openingPicks, "picks", timer.nsecsElapsed());
+	return true;
+}
+
+bool BenchWorkload::runBook()
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	PolyglotBook book;
+	qint64 count = 0;
+	for (const PgnGame& game : qAsConst(m_corpus))
+		count += book.import(game, s_bookPlies);
+
+	for (const PgnGame& game : qAsConst(m_corpus))
+	{
+		const auto moves = game.moves();
+		for (const PgnGame::MoveData& md : moves)
+		{
+			book.move(md.key);
+			count++;
+		}
+	}
+
+	addStage("book", count, "entries", timer.nsecsElapsed());
+	return true;
+}
+
+bool BenchWorkload::runTournament()
+{
+	GameManager manager;
+	manager.setConcurrency(m_concurrency);
+
+	QScopedPointer<Tournament> tournament(
+		TournamentFactory::create("round-robin", &manager));
+	tournament->setGamesPerEncounter(m_tournamentGames);
+
+	GameAdjudicator adjudicator;
+	adjudicator.setMaximumGameLength(MockEngine::MaxGameLength);
+	tournament->setAdjudicator(adjudicator);
+
+	for (int i = 1; i <= 2; i++)
+	{
+		EngineConfiguration config(QString("Mock %1").arg(i),
+					   QCoreApplication::applicationFilePath(),
+					   "uci");
+		config.setArguments(QStringList() << "bench-engine" << "uci");
+		tournament->addPlayer(new EngineBuilder(config), TimeControl("inf"));
+	}
+
+	qint64 plies = 0;
+	QObject::connect(tournament.data(), &Tournament::gameFinished,
+			 [&](ChessGame* game) { plies += game->moves().size(); });
+
+	QEventLoop loop;
+	QObject::connect(tournament.data(), SIGNAL(finished()), &loop, SLOT(quit()));
+
+	QElapsedTimer timer;
+	timer.start();
+	tournament->start();
+	loop.exec();
+	const qint64 nsecs = timer.nsecsElapsed();
+
+	const int finished = tournament->finishedGameCount();
+	tournament.reset();
+
+	// Quit the engines before returning
+	bool quit = false;
+	QObject::connect(&manager, &GameManager::finished, &loop, [&]()
+	{
+		quit = true;
+		loop.quit();
+	});
+	manager.finish();
+	if (!quit)
+		loop.exec();
+
+	if (finished != m_tournamentGames)
+	{
+		qWarning("The bench tournament finished %d games instead of %d",
+			 finished, m_tournamentGames);
+		return false;
+	}
+
+	addStage("games", plies, "plies", nsecs);
+	return true;
+}
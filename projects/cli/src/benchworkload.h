@@ -0,0 +1,86 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHWORKLOAD_H
+#define BENCHWORKLOAD_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <pgngame.h>
+
+/*
+ * A fixed workload over the library's hot paths for the bench command.
+ *
+ * The same seed always gives the same work: a corpus of random games
+ * is generated and then written and parsed as PGN, converted to and
+ * from SAN, indexed as an EPD opening suite, imported into an opening
+ * book and probed. Perft runs over a set of variants, and two mock
+ * engines (copies of cutechess-cli) play a short tournament. Each stage
+ * is timed separately, and the score is the geometric mean of the
+ * stages' throughputs, so it can be compared between builds and hosts.
+ */
+class BenchWorkload
+{
+	public:
+		struct Stage
+		{
+			QString name;
+			// Units of work done, eg. games or nodes
+			qint64 work;
+			QString unit;
+			qint64 nsecs;
+
+			double rate() const;
+		};
+
+		BenchWorkload();
+
+		// Sets the number of games in the corpus (default: 500)
+		void setCorpusSize(int games);
+		// Sets the number of games in the tournament stage
+		// (default: 20)
+		void setTournamentGames(int games);
+		// Sets the number of tournament games played at once
+		// (default: 2)
+		void setConcurrency(int concurrency);
+
+		// Runs every stage. Returns false if a stage fails.
+		bool run();
+		QList<Stage> stages() const;
+		double score() const;
+
+	private:
+		void addStage(const QString& name, qint64 work,
+			      const QString& unit, qint64 nsecs);
+		void generateCorpus();
+		bool runPgn();
+		bool runSan();
+		void runPerft();
+		bool runOpenings();
+		bool runBook();
+		bool runTournament();
+
+		int m_corpusSize;
+		int m_tournamentGames;
+		int m_concurrency;
+		QVector<PgnGame> m_corpus;
+		QList<Stage> m_stages;
+};
+
+#endif // BENCHWORKLOAD_H
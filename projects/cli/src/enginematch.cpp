@@ -17,21 +17,116 @@
 
 #include "enginematch.h"
 #include <QMultiMap>
+#include <QHash>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <chessplayer.h>
 #include <playerbuilder.h>
 #include <chessgame.h>
+#include <pgngame.h>
+#include <board/board.h>
+#include <board/syzygytablebase.h>
 #include <polyglotbook.h>
 #include <tournament.h>
 #include <gamemanager.h>
 #include <sprt.h>
+#include <elo.h>
+#include <memoryaccount.h>
+#include <adaptivemargin.h>
+#include "eventstream.h"
+#include "metricsserver.h"
+#include "startupprofile.h"
+#include "tournamentcoordinator.h"
+#include "tournamentworker.h"
 
+namespace {
+
+QJsonObject latencyObject(const LatencyHistogram& latency)
+{
+	QJsonObject obj;
+	obj["moves"] = latency.count();
+	obj["p50_ns"] = latency.percentile(50);
+	obj["p99_ns"] = latency.percentile(99);
+	obj["max_ns"] = latency.max();
+	return obj;
+}
+
+// Thinking time of one side's moves in a game
+QJsonObject moveTimeObject(const QVector<MoveEvaluation>& evals,
+			   int firstIndex)
+{
+	int moves = 0;
+	qint64 total = 0;
+	qint64 max = 0;
+	for (int i = firstIndex; i < evals.size(); i += 2)
+	{
+		const qint64 time = evals.at(i).time();
+		moves++;
+		total += time;
+		max = qMax(max, time);
+	}
+
+	QJsonObject obj;
+	obj["moves"] = moves;
+	obj["total_ms"] = total;
+	obj["max_ms"] = max;
+	obj["avg_ms"] = moves ? double(total) / moves : 0.0;
+	return obj;
+}
+
+// Pondering of one side in a game. The effective thinking time adds
+// the time pondered before ponder hits to the time on the clock.
+QJsonObject ponderObject(const ChessPlayer::PonderStats& stats,
+			 qint64 moveTime)
+{
+	QJsonObject obj;
+	obj["hits"] = stats.hitTime.count();
+	obj["misses"] = stats.missTime.count();
+	obj["hit_ponder_ms"] = stats.hitTime.sum() / 1000000;
+	obj["miss_ponder_ms"] = stats.missTime.sum() / 1000000;
+	obj["effective_time_ms"] = moveTime + stats.hitTime.sum() / 1000000;
+	obj["ponderhit_latency"] = latencyObject(stats.hitLatency);
+	obj["miss_latency"] = latencyObject(stats.missLatency);
+	return obj;
+}
+
+// Opening books shared by all matches of the process
+struct CachedBook
+{
+	OpeningBook* book;
+	int refCount;
+};
+QHash<QString, CachedBook> s_bookCache;
+
+QString bookCacheKey(const QString& fileName, OpeningBook::AccessMode mode)
+{
+	return QString::number(mode) + ':' + fileName;
+}
+
+} // anonymous namespace
 
 EngineMatch::EngineMatch(Tournament* tournament, QObject* parent)
 	: QObject(parent),
 	  m_tournament(tournament),
 	  m_debug(false),
 	  m_ratingInterval(0),
-	  m_bookMode(OpeningBook::Ram)
+	  m_bookMode(OpeningBook::Ram),
+	  m_bookCacheSize(4096),
+	  m_events(nullptr),
+	  m_pliesSaved(0),
+	  m_gameMemory(0),
+	  m_gameMemoryPlies(0),
+	  m_gameMemoryCount(0),
+	  m_sharedGameManager(false),
+	  m_coordinator(nullptr),
+	  m_worker(nullptr),
+	  m_metrics(nullptr),
+	  m_gamesStarted(0),
+	  m_gamesFinished(0),
+	  m_activeGames(0),
+	  m_pliesPlayed(0),
+	  m_timeForfeits(0)
 {
 	Q_ASSERT(tournament != nullptr);
 
@@ -40,7 +135,17 @@ EngineMatch::EngineMatch(Tournament* tournament, QObject* parent)
 
 EngineMatch::~EngineMatch()
 {
-	qDeleteAll(m_books);
+	for (const QString& key : qAsConst(m_bookKeys))
+	{
+		auto cached = s_bookCache.find(key);
+		Q_ASSERT(cached != s_bookCache.end());
+
+		if (--cached->refCount == 0)
+		{
+			delete cached->book;
+			s_bookCache.erase(cached);
+		}
+	}
 }
 
 OpeningBook* EngineMatch::addOpeningBook(const QString& fileName)
@@ -48,9 +153,21 @@ OpeningBook* EngineMatch::addOpeningBook(const QString& fileName)
 	if (fileName.isEmpty())
 		return nullptr;
 
+	StartupProfile::Timer timer("Opening books");
 	if (m_books.contains(fileName))
 		return m_books[fileName];
 
+	// Matches running in the same process share their books
+	const QString key = bookCacheKey(fileName, m_bookMode);
+	auto cached = s_bookCache.find(key);
+	if (cached != s_bookCache.end())
+	{
+		cached->refCount++;
+		m_bookKeys << key;
+		m_books[fileName] = cached->book;
+		return cached->book;
+	}
+
 	PolyglotBook* book = new PolyglotBook(m_bookMode);
 	if (!book->read(fileName))
 	{
@@ -58,30 +175,63 @@ OpeningBook* EngineMatch::addOpeningBook(const QString& fileName)
 		qWarning("Can't read opening book file %s", qUtf8Printable(fileName));
 		return nullptr;
 	}
+	book->setProbeCacheSize(m_bookCacheSize);
 
+	CachedBook entry = { book, 1 };
+	s_bookCache[key] = entry;
+	m_bookKeys << key;
 	m_books[fileName] = book;
 	return book;
 }
 
 void EngineMatch::start()
 {
+	if (m_debug)
+		connect(m_tournament->gameManager(), SIGNAL(debugMessage(QString)),
+			this, SLOT(print(QString)));
+
+	if (!m_eventOutput.isEmpty() && m_worker == nullptr)
+	{
+		m_events = new EventStream(this);
+		if (!m_events->open(m_eventOutput))
+		{
+			qWarning("Can't open event output %s: %s",
+				 qUtf8Printable(m_eventOutput),
+				 qUtf8Printable(m_events->errorString()));
+			delete m_events;
+			m_events = nullptr;
+		}
+	}
+
+	// A worker plays the games of a remote tournament
+	if (m_worker != nullptr)
+	{
+		connect(m_worker, SIGNAL(finished()), this, SIGNAL(finished()));
+		QMetaObject::invokeMethod(m_worker, "start", Qt::QueuedConnection);
+		return;
+	}
+
 	connect(m_tournament, SIGNAL(finished()),
 		this, SLOT(onTournamentFinished()));
 	connect(m_tournament, SIGNAL(gameStarted(ChessGame*, int, int, int)),
 		this, SLOT(onGameStarted(ChessGame*, int)));
 	connect(m_tournament, SIGNAL(gameFinished(ChessGame*, int, int, int)),
 		this, SLOT(onGameFinished(ChessGame*, int)));
+	connect(m_tournament, SIGNAL(remoteGameFinished(PgnGame*, int, int, int)),
+		this, SLOT(onRemoteGameFinished(PgnGame*, int)));
 
-	if (m_debug)
-		connect(m_tournament->gameManager(), SIGNAL(debugMessage(QString)),
-			this, SLOT(print(QString)));
-
+	m_startupTime.start();
 	QMetaObject::invokeMethod(m_tournament, "start", Qt::QueuedConnection);
+	if (m_coordinator != nullptr)
+		QMetaObject::invokeMethod(m_coordinator, "start", Qt::QueuedConnection);
 }
 
 void EngineMatch::stop()
 {
-	QMetaObject::invokeMethod(m_tournament, "stop", Qt::QueuedConnection);
+	if (m_worker != nullptr)
+		QMetaObject::invokeMethod(m_worker, "stop", Qt::QueuedConnection);
+	else
+		QMetaObject::invokeMethod(m_tournament, "stop", Qt::QueuedConnection);
 }
 
 void EngineMatch::setDebugMode(bool debug)
@@ -100,6 +250,48 @@ void EngineMatch::setBookMode(OpeningBook::AccessMode mode)
 	m_bookMode = mode;
 }
 
+void EngineMatch::setBookCacheSize(int positions)
+{
+	Q_ASSERT(positions >= 0);
+	m_bookCacheSize = positions;
+}
+
+void EngineMatch::setSharedGameManager(bool shared)
+{
+	m_sharedGameManager = shared;
+}
+
+void EngineMatch::setCoordinator(TournamentCoordinator* coordinator)
+{
+	m_coordinator = coordinator;
+}
+
+void EngineMatch::setWorker(TournamentWorker* worker)
+{
+	m_worker = worker;
+}
+
+void EngineMatch::setMetricsServer(MetricsServer* server)
+{
+	m_metrics = server;
+	m_metrics->setExporter([this]() { return exportMetrics(); });
+}
+
+Tournament* EngineMatch::tournament() const
+{
+	return m_tournament;
+}
+
+void EngineMatch::setLatencyFile(const QString& fileName)
+{
+	m_latencyFile = fileName;
+}
+
+void EngineMatch::setEventOutput(const QString& target)
+{
+	m_eventOutput = target;
+}
+
 void EngineMatch::onGameStarted(ChessGame* game, int number)
 {
 	Q_ASSERT(game != nullptr);
@@ -109,6 +301,27 @@ void EngineMatch::onGameStarted(ChessGame* game, int number)
 	      m_tournament->finalGameCount(),
 	      qUtf8Printable(game->player(Chess::Side::White)->name()),
 	      qUtf8Printable(game->player(Chess::Side::Black)->name()));
+
+	// Start-up ends when the engines of the first game are ready
+	if (StartupProfile::isEnabled() && m_startupTime.isValid())
+	{
+		StartupProfile::add("Engine start-up and handshake",
+				    m_startupTime.nsecsElapsed());
+		m_startupTime.invalidate();
+		StartupProfile::print();
+	}
+
+	m_gamesStarted++;
+	m_activeGames++;
+
+	if (m_events != nullptr)
+	{
+		QJsonObject event;
+		event["game"] = number;
+		event["white"] = game->player(Chess::Side::White)->name();
+		event["black"] = game->player(Chess::Side::Black)->name();
+		m_events->write("game_started", event);
+	}
 }
 
 void EngineMatch::onGameFinished(ChessGame* game, int number)
@@ -122,6 +335,178 @@ void EngineMatch::onGameFinished(ChessGame* game, int number)
 	      qUtf8Printable(game->player(Chess::Side::Black)->name()),
 	      qUtf8Printable(result.toVerboseString()));
 
+	const qint64 gameMemory = game->memoryUsage();
+	m_gameMemory += gameMemory;
+	m_gameMemoryPlies += game->moves().size();
+	m_gameMemoryCount++;
+
+	m_activeGames--;
+	countResult(result,
+		    result.loser().isNull() ? QString()
+					    : game->player(result.loser())->name(),
+		    game->moves().size());
+
+	const auto evals = game->evaluations();
+	if (m_events != nullptr)
+	{
+		// The first evaluation belongs to the side that moved first
+		const int whiteIndex = game->board()->startingSide() == Chess::Side::White ? 0 : 1;
+		QJsonObject time;
+		time["white"] = moveTimeObject(evals, whiteIndex);
+		time["black"] = moveTimeObject(evals, 1 - whiteIndex);
+
+		QJsonObject event;
+		event["game"] = number;
+		event["white"] = game->player(Chess::Side::White)->name();
+		event["black"] = game->player(Chess::Side::Black)->name();
+		event["result"] = result.toShortString();
+		event["reason"] = result.description();
+		event["plies"] = evals.size();
+		event["move_time"] = time;
+
+		QJsonObject ponder;
+		for (int i = 0; i < 2; i++)
+		{
+			Chess::Side side = Chess::Side::Type(i);
+			const auto stats = game->ponderStats(side);
+			if (stats.hitTime.isEmpty() && stats.missTime.isEmpty())
+				continue;
+
+			const QString key(side == Chess::Side::White ? "white" : "black");
+			const qint64 moveTime = qint64(time.value(key).toObject()
+							.value("total_ms").toDouble());
+			ponder[key] = ponderObject(stats, moveTime);
+		}
+		if (!ponder.isEmpty())
+			event["ponder"] = ponder;
+		event["memory"] = double(gameMemory);
+		m_events->write("game_finished", event);
+		writeMemoryEvent();
+	}
+	printScore();
+
+	QJsonObject gameLatency;
+	gameLatency["game"] = number;
+	for (int i = 0; i < 2; i++)
+	{
+		Chess::Side side = Chess::Side::Type(i);
+		QString name = game->player(side)->name();
+		LatencyHistogram latency = game->relayLatency(side);
+		LatencyHistogram overhead = game->clockOverhead(side);
+		m_latency[name].merge(latency);
+		m_clockOverhead[name].merge(overhead);
+
+		if (m_debug)
+		{
+			const QString gameName(QString("%1 in game %2")
+					       .arg(name).arg(number));
+			printLatency("Move relay latency", gameName, latency);
+			printLatency("Clock overhead", gameName, overhead);
+		}
+		if (!m_latencyFile.isEmpty())
+		{
+			QJsonObject obj = latencyObject(latency);
+			obj["name"] = name;
+			obj["clock_overhead"] = latencyObject(overhead);
+			gameLatency[side == Chess::Side::White ? "white" : "black"] = obj;
+		}
+	}
+	if (!m_latencyFile.isEmpty())
+		m_gameLatency.append(gameLatency);
+
+	if (result.type() == Chess::Result::Adjudication)
+	{
+		m_adjudications[result.description()]++;
+		m_pliesSaved += game->adjudicator().pliesSaved();
+	}
+
+	// A move into a lost tablebase position. The loser's own
+	// evaluation tells if it saw the loss coming.
+	const Chess::Side lastMover = game->board()->sideToMove().opposite();
+	if (result.type() == Chess::Result::Adjudication
+	&&  result.description().contains("SyzygyTB")
+	&&  result.loser() == lastMover
+	&&  !evals.isEmpty())
+	{
+		TablebaseLosses& losses = m_tbLosses[game->player(lastMover)->name()];
+		losses.moves++;
+		const MoveEvaluation& eval = evals.last();
+		if (eval.depth() > 0 && eval.score() >= 0)
+			losses.misjudged++;
+	}
+
+	// Time spent thinking, for comparing with the CPU time
+	qint64 thinkTime[2] = { 0, 0 };
+	Chess::Side mover = game->board()->startingSide();
+	for (const MoveEvaluation& eval : evals)
+	{
+		thinkTime[mover] += eval.time();
+		mover = mover.opposite();
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		Chess::Side side = Chess::Side::Type(i);
+		ResourceUsage usage = game->resourceUsage(side);
+		if (!usage.isValid())
+			continue;
+
+		EngineResources& resources = m_resources[game->player(side)->name()];
+		resources.usage.add(usage);
+		resources.games++;
+		resources.thinkTime += thinkTime[i];
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		Chess::Side side = Chess::Side::Type(i);
+		const auto stats = game->ponderStats(side);
+		if (stats.hitTime.isEmpty() && stats.missTime.isEmpty())
+			continue;
+
+		PonderTotals& totals = m_ponder[game->player(side)->name()];
+		totals.stats.merge(stats);
+		totals.thinkTime += thinkTime[i];
+	}
+
+	if (m_debug)
+	{
+		printBookStatistics();
+		printOutputStatistics();
+		printMemoryUsage();
+	}
+}
+
+void EngineMatch::onRemoteGameFinished(PgnGame* pgn, int number)
+{
+	Q_ASSERT(pgn != nullptr);
+
+	qInfo("Finished game %d (%s vs %s): %s",
+	      number,
+	      qUtf8Printable(pgn->playerName(Chess::Side::White)),
+	      qUtf8Printable(pgn->playerName(Chess::Side::Black)),
+	      qUtf8Printable(pgn->result().toVerboseString()));
+
+	const Chess::Result result(pgn->result());
+	countResult(result,
+		    result.loser().isNull() ? QString()
+					    : pgn->playerName(result.loser()),
+		    pgn->moves().size());
+
+	if (m_events != nullptr)
+	{
+		QJsonObject event;
+		event["game"] = number;
+		event["white"] = pgn->playerName(Chess::Side::White);
+		event["black"] = pgn->playerName(Chess::Side::Black);
+		event["result"] = pgn->result().toShortString();
+		event["reason"] = pgn->result().description();
+		event["plies"] = pgn->moves().size();
+		m_events->write("game_finished", event);
+	}
+	printScore();
+}
+
+void EngineMatch::printScore()
+{
 	if (m_tournament->playerCount() == 2)
 	{
 		TournamentPlayer fcp = m_tournament->playerAt(0);
@@ -133,24 +518,98 @@ void EngineMatch::onGameFinished(ChessGame* game, int number)
 		      fcp.wins(), scp.wins(), fcp.draws(),
 		      double(fcp.score()) / (totalResults * 2),
 		      totalResults);
+
+		if (m_events != nullptr)
+		{
+			QJsonObject event;
+			event["first"] = fcp.name();
+			event["second"] = scp.name();
+			event["wins"] = fcp.wins();
+			event["losses"] = scp.wins();
+			event["draws"] = fcp.draws();
+			event["games"] = totalResults;
+			m_events->write("score", event);
+		}
+	}
+
+	const Sprt* sprt = m_tournament->sprt();
+	if (m_events != nullptr && !sprt->isNull())
+	{
+		const Sprt::Status status = sprt->status();
+		QJsonObject event;
+		event["llr"] = status.llr;
+		event["lower_bound"] = status.lBound;
+		event["upper_bound"] = status.uBound;
+		event["result"] = status.result == Sprt::AcceptH0 ? "H0"
+				: status.result == Sprt::AcceptH1 ? "H1" : "continue";
+		m_events->write("sprt", event);
 	}
 
 	if (m_ratingInterval != 0
 	&&  (m_tournament->finishedGameCount() % m_ratingInterval) == 0)
+	{
 		printRanking();
+		writeRankingEvent();
+	}
 }
 
 void EngineMatch::onTournamentFinished()
 {
 	if (m_ratingInterval == 0
 	||  m_tournament->finishedGameCount() % m_ratingInterval != 0)
+	{
 		printRanking();
+		writeRankingEvent();
+	}
+	printBookStatistics();
+	printTablebaseStatistics();
+	printOutputStatistics();
+	if (MemoryAccount::budget() > 0)
+		printMemoryUsage();
+	for (auto it = m_adjudications.constBegin(); it != m_adjudications.constEnd(); ++it)
+		qInfo("Adjudicated games: %d, %s",
+		      it.value(), qUtf8Printable(it.key()));
+	if (m_pliesSaved > 0)
+		qInfo("Plies saved by confirmed mates: %lld", m_pliesSaved);
+	for (auto it = m_tbLosses.constBegin(); it != m_tbLosses.constEnd(); ++it)
+		qInfo("Tablebase losses of %s: %d moves into a lost position, "
+		      "%d of them with a non-negative evaluation",
+		      qUtf8Printable(it.key()),
+		      it.value().moves,
+		      it.value().misjudged);
+
+	for (auto it = m_latency.constBegin(); it != m_latency.constEnd(); ++it)
+		printLatency("Move relay latency", it.key(), it.value());
+	for (auto it = m_clockOverhead.constBegin(); it != m_clockOverhead.constEnd(); ++it)
+		printLatency("Clock overhead", it.key(), it.value());
+	printTimeMargins();
+	if (!m_latencyFile.isEmpty())
+		writeLatencyFile();
+	for (auto it = m_resources.constBegin(); it != m_resources.constEnd(); ++it)
+		printResourceUsage(it.key(), it.value());
+	for (auto it = m_ponder.constBegin(); it != m_ponder.constEnd(); ++it)
+		printPonderStatistics(it.key(), it.value());
 
 	QString error = m_tournament->errorString();
 	if (!error.isEmpty())
 		qWarning("%s", qUtf8Printable(error));
 
 	qInfo("Finished match");
+	if (m_events != nullptr)
+	{
+		QJsonObject event;
+		event["games"] = m_tournament->finishedGameCount();
+		if (!error.isEmpty())
+			event["error"] = error;
+		m_events->write("match_finished", event);
+		m_events->flush();
+	}
+	// The owner of a shared game manager finishes it
+	if (m_sharedGameManager)
+	{
+		emit finished();
+		return;
+	}
 	connect(m_tournament->gameManager(), SIGNAL(finished()),
 		this, SIGNAL(finished()));
 	m_tournament->gameManager()->finish();
@@ -165,3 +624,366 @@ void EngineMatch::printRanking()
 {
 	qInfo("%s", qUtf8Printable(m_tournament->results()));
 }
+
+void EngineMatch::writeRankingEvent()
+{
+	if (m_events == nullptr)
+		return;
+
+	// The same ratings as in Tournament::results()
+	const RatingModel& ratings = m_tournament->ratingModel();
+	QJsonArray players;
+	for (int i = 0; i < m_tournament->playerCount(); i++)
+	{
+		const TournamentPlayer& player(m_tournament->playerAt(i));
+		Elo elo(player.wins(), player.losses(), player.draws());
+		const bool rated = (m_tournament->playerCount() > 2
+				    && i < ratings.playerCount());
+
+		QJsonObject obj;
+		obj["name"] = player.name();
+		obj["games"] = player.gamesFinished();
+		obj["wins"] = player.wins();
+		obj["losses"] = player.losses();
+		obj["draws"] = player.draws();
+		obj["elo"] = rated ? ratings.rating(i) : elo.diff();
+		obj["error"] = rated ? ratings.errorMargin(i) : elo.errorMargin();
+		players.append(obj);
+	}
+
+	QJsonObject event;
+	event["games"] = m_tournament->finishedGameCount();
+	event["players"] = players;
+	m_events->write("ratings", event);
+}
+
+void EngineMatch::printBookStatistics()
+{
+	for (const OpeningBook* book : qAsConst(m_books))
+	{
+		const OpeningBook::Statistics stats = book->statistics();
+		if (stats.probes == 0)
+			continue;
+
+		qInfo("Opening book %s: %lld probes, %lld hits (%.1f%%), "
+		      "%.2f entries per hit, %.1f us per probe",
+		      qUtf8Printable(book->fileName()),
+		      stats.probes,
+		      stats.hits,
+		      100.0 * stats.hits / stats.probes,
+		      stats.hits ? double(stats.entries) / stats.hits : 0.0,
+		      stats.probeTime / 1000.0 / stats.probes);
+		if (book->probeCacheSize() > 0)
+			qInfo("Opening book %s: %lld cached probes (%.1f%%)",
+			      qUtf8Printable(book->fileName()),
+			      stats.cacheHits,
+			      100.0 * stats.cacheHits / stats.probes);
+	}
+}
+
+void EngineMatch::printOutputStatistics()
+{
+	const OutputQueue::Statistics stats = m_tournament->outputStatistics();
+	if (stats.jobs == 0)
+		return;
+
+	qInfo("Output queue: %lld writes, max depth %d of %d, "
+	      "%.1f ms waiting for free space",
+	      stats.jobs,
+	      stats.maxDepth,
+	      stats.capacity,
+	      stats.waitTime / 1000000.0);
+}
+
+void EngineMatch::printMemoryUsage()
+{
+	QStringList usage;
+	for (int i = 0; i < MemoryAccount::ComponentCount; i++)
+	{
+		const auto component = MemoryAccount::Component(i);
+		usage << QString("%1 %2 KiB")
+			 .arg(MemoryAccount::componentName(component))
+			 .arg(MemoryAccount::usage(component) / 1024);
+	}
+
+	QString budget("no budget");
+	if (MemoryAccount::budget() > 0)
+		budget = QString("budget %1 MiB")
+			 .arg(MemoryAccount::budget() / (1024 * 1024));
+	qInfo("Memory usage: %s (%s)",
+	      qUtf8Printable(usage.join(", ")),
+	      qUtf8Printable(budget));
+
+	if (m_gameMemoryCount > 0)
+		qInfo("Game memory: %lld bytes per game, %lld bytes per ply "
+		      "on average",
+		      m_gameMemory / m_gameMemoryCount,
+		      m_gameMemory / qMax(Q_INT64_C(1), m_gameMemoryPlies));
+}
+
+void EngineMatch::writeMemoryEvent()
+{
+	if (m_events == nullptr)
+		return;
+
+	QJsonObject event;
+	for (int i = 0; i < MemoryAccount::ComponentCount; i++)
+	{
+		const auto component = MemoryAccount::Component(i);
+		event[MemoryAccount::componentName(component)] =
+			double(MemoryAccount::usage(component));
+	}
+	event["total"] = double(MemoryAccount::totalUsage());
+	event["budget"] = double(MemoryAccount::budget());
+	m_events->write("memory", event);
+}
+
+void EngineMatch::countResult(const Chess::Result& result,
+			      const QString& loserName,
+			      int plies)
+{
+	m_gamesFinished++;
+	m_pliesPlayed += plies;
+
+	if (result.type() == Chess::Result::Timeout)
+		m_timeForfeits++;
+	// With -recover these are the engine restarts
+	else if ((result.type() == Chess::Result::Disconnection
+	     ||   result.type() == Chess::Result::StalledConnection)
+	     &&  !loserName.isEmpty())
+		m_crashes[loserName]++;
+}
+
+QByteArray EngineMatch::exportMetrics() const
+{
+	// Rates such as games or plies per second are left to the
+	// scraper, eg. rate(cutechess_plies_total[1m]) in Prometheus
+	QByteArray out;
+
+	MetricsServer::writeHeader(out, "cutechess_uptime_seconds", "gauge",
+				   "Seconds since the match was created");
+	MetricsServer::writeSample(out, "cutechess_uptime_seconds",
+				   m_startTime.elapsed() / 1000.0);
+
+	MetricsServer::writeHeader(out, "cutechess_games_started_total", "counter",
+				   "Games started by this process");
+	MetricsServer::writeSample(out, "cutechess_games_started_total",
+				   double(m_gamesStarted));
+
+	MetricsServer::writeHeader(out, "cutechess_games_finished_total", "counter",
+				   "Games finished, including games of remote workers");
+	MetricsServer::writeSample(out, "cutechess_games_finished_total",
+				   double(m_gamesFinished));
+
+	MetricsServer::writeHeader(out, "cutechess_active_games", "gauge",
+				   "Games in progress in this process");
+	MetricsServer::writeSample(out, "cutechess_active_games", m_activeGames);
+
+	MetricsServer::writeHeader(out, "cutechess_plies_total", "counter",
+				   "Plies played in finished games");
+	MetricsServer::writeSample(out, "cutechess_plies_total",
+				   double(m_pliesPlayed));
+
+	MetricsServer::writeHeader(out, "cutechess_time_forfeits_total", "counter",
+				   "Games lost on time");
+	MetricsServer::writeSample(out, "cutechess_time_forfeits_total",
+				   double(m_timeForfeits));
+
+	MetricsServer::writeHeader(out, "cutechess_engine_crashes_total", "counter",
+				   "Games lost by engine crashes and stalls");
+	for (auto it = m_crashes.constBegin(); it != m_crashes.constEnd(); ++it)
+		MetricsServer::writeSample(out, "cutechess_engine_crashes_total",
+					   it.value(),
+					   MetricsServer::label("engine", it.key()));
+
+	MetricsServer::writeHeader(out, "cutechess_move_relay_latency_seconds", "summary",
+				   "Time from the opponent's move until the position is sent to the engine");
+	for (auto it = m_latency.constBegin(); it != m_latency.constEnd(); ++it)
+		MetricsServer::writeSummary(out, "cutechess_move_relay_latency_seconds",
+					    it.value(),
+					    MetricsServer::label("engine", it.key()));
+
+	MetricsServer::writeHeader(out, "cutechess_time_margin_seconds", "gauge",
+				   "Adaptive time margin of each engine");
+	for (int i = 0; i < m_tournament->playerCount(); i++)
+	{
+		const TournamentPlayer& player(m_tournament->playerAt(i));
+		const AdaptiveMargin* margin = player.timeControl().adaptiveMargin();
+		if (margin != nullptr)
+			MetricsServer::writeSample(out, "cutechess_time_margin_seconds",
+						   margin->compensationUsec() / 1e6,
+						   MetricsServer::label("engine", player.name()));
+	}
+
+	const Sprt* sprt = m_tournament->sprt();
+	if (!sprt->isNull())
+	{
+		const Sprt::Status status = sprt->status();
+		MetricsServer::writeHeader(out, "cutechess_sprt_llr", "gauge",
+					   "Log-likelihood ratio of the SPRT");
+		MetricsServer::writeSample(out, "cutechess_sprt_llr", status.llr);
+		MetricsServer::writeHeader(out, "cutechess_sprt_lower_bound", "gauge",
+					   "Lower bound of the SPRT");
+		MetricsServer::writeSample(out, "cutechess_sprt_lower_bound", status.lBound);
+		MetricsServer::writeHeader(out, "cutechess_sprt_upper_bound", "gauge",
+					   "Upper bound of the SPRT");
+		MetricsServer::writeSample(out, "cutechess_sprt_upper_bound", status.uBound);
+	}
+
+	MetricsServer::writeHeader(out, "cutechess_memory_bytes", "gauge",
+				   "Accounted memory usage by component");
+	for (int i = 0; i < MemoryAccount::ComponentCount; i++)
+	{
+		const auto component = MemoryAccount::Component(i);
+		MetricsServer::writeSample(out, "cutechess_memory_bytes",
+					   double(MemoryAccount::usage(component)),
+					   MetricsServer::label("component",
+						MemoryAccount::componentName(component)));
+	}
+	MetricsServer::writeHeader(out, "cutechess_memory_budget_bytes", "gauge",
+				   "Memory budget set with -memlimit, or 0");
+	MetricsServer::writeSample(out, "cutechess_memory_budget_bytes",
+				   double(MemoryAccount::budget()));
+
+	return out;
+}
+
+void EngineMatch::printTimeMargins()
+{
+	for (int i = 0; i < m_tournament->playerCount(); i++)
+	{
+		const TournamentPlayer& player(m_tournament->playerAt(i));
+		const AdaptiveMargin* margin = player.timeControl().adaptiveMargin();
+		if (margin == nullptr)
+			continue;
+
+		qInfo("Time margin of %s: %lld ms (cap %lld ms, %lld moves "
+		      "measured), %d moves saved from a time forfeit",
+		      qUtf8Printable(player.name()),
+		      margin->compensationUsec() / 1000,
+		      margin->capUsec() / 1000,
+		      margin->lag().count(),
+		      margin->savedMoves());
+	}
+}
+
+void EngineMatch::printTablebaseStatistics()
+{
+	const qint64 probes = SyzygyTablebase::probeCount();
+	if (probes == 0)
+		return;
+
+	const qint64 hits = SyzygyTablebase::cacheHitCount();
+	QString pageFaults = "n/a";
+	if (SyzygyTablebase::pageFaultCount() >= 0)
+		pageFaults = QString::number(SyzygyTablebase::pageFaultCount());
+	qInfo("Tablebases: %lld probes, %lld cache hits (%.1f%%), "
+	      "%s major page faults",
+	      probes,
+	      hits,
+	      100.0 * hits / probes,
+	      qUtf8Printable(pageFaults));
+	printLatency("Tablebase probe latency", "tablebases",
+		     SyzygyTablebase::probeLatency());
+}
+
+void EngineMatch::printLatency(const QString& title,
+			       const QString& name,
+			       const LatencyHistogram& latency)
+{
+	if (latency.isEmpty())
+		return;
+
+	qInfo("%s of %s: p50 %.3f ms, p99 %.3f ms, "
+	      "max %.3f ms (%lld moves)",
+	      qUtf8Printable(title),
+	      qUtf8Printable(name),
+	      latency.percentile(50) / 1.0e6,
+	      latency.percentile(99) / 1.0e6,
+	      latency.max() / 1.0e6,
+	      latency.count());
+}
+
+EngineMatch::EngineResources::EngineResources()
+	: games(0),
+	  thinkTime(0)
+{
+}
+
+void EngineMatch::printResourceUsage(const QString& name,
+				     const EngineResources& resources)
+{
+	const ResourceUsage& usage = resources.usage;
+	if (resources.games == 0)
+		return;
+
+	// A load much higher than the engine's thread count means
+	// that it uses more threads than it should
+	QString str = QString("Resource usage of %1: CPU time %2 s per game "
+			      "(%3% system), load %4")
+		      .arg(name)
+		      .arg(usage.cpuTime() / 1.0e6 / resources.games, 0, 'f', 2)
+		      .arg(usage.cpuTime() ? 100.0 * usage.systemTime() / usage.cpuTime()
+					   : 0.0, 0, 'f', 1)
+		      .arg(resources.thinkTime ? usage.cpuTime() / 1000.0 / resources.thinkTime
+					       : 0.0, 0, 'f', 2);
+	if (usage.peakMemory() != -1)
+		str += QString(", peak RSS %1 MiB")
+		       .arg(usage.peakMemory() / 1024.0, 0, 'f', 1);
+	if (usage.contextSwitches() != -1)
+		str += QString(", %1 context switches per game")
+		       .arg(usage.contextSwitches() / resources.games);
+	if (usage.involuntaryContextSwitches() != -1)
+		str += QString(" (%1 involuntary)")
+		       .arg(usage.involuntaryContextSwitches() / resources.games);
+
+	qInfo("%s", qUtf8Printable(str));
+}
+
+EngineMatch::PonderTotals::PonderTotals()
+	: thinkTime(0)
+{
+}
+
+void EngineMatch::printPonderStatistics(const QString& name,
+					const PonderTotals& totals)
+{
+	const ChessPlayer::PonderStats& stats = totals.stats;
+	const qint64 hits = stats.hitTime.count();
+	const qint64 misses = stats.missTime.count();
+
+	// Time pondered before a ponder hit counts as thinking time
+	qInfo("Pondering of %s: %lld hits, %lld misses (%.1f%% hits), "
+	      "effective thinking time %.1f s (%.1f s on the clock), "
+	      "%.1f s pondered in vain",
+	      qUtf8Printable(name),
+	      hits,
+	      misses,
+	      100.0 * hits / (hits + misses),
+	      totals.thinkTime / 1000.0 + stats.hitTime.sum() / 1.0e9,
+	      totals.thinkTime / 1000.0,
+	      stats.missTime.sum() / 1.0e9);
+	printLatency("Ponderhit latency", name, stats.hitLatency);
+	printLatency("Ponder miss latency", name, stats.missLatency);
+}
+
+void EngineMatch::writeLatencyFile()
+{
+	QJsonObject engines;
+	for (auto it = m_latency.constBegin(); it != m_latency.constEnd(); ++it)
+	{
+		QJsonObject obj = latencyObject(it.value());
+		obj["clock_overhead"] = latencyObject(m_clockOverhead.value(it.key()));
+		engines[it.key()] = obj;
+	}
+
+	QJsonObject root;
+	root["engines"] = engines;
+	root["games"] = m_gameLatency;
+
+	QFile file(m_latencyFile);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+	||  file.write(QJsonDocument(root).toJson()) == -1)
+		qWarning("Can't write latency statistics to %s",
+			 qUtf8Printable(m_latencyFile));
+}
@@ -22,12 +22,22 @@
 #include <QObject>
 #include <QMap>
 #include <QString>
+#include <QStringList>
 #include <QElapsedTimer>
+#include <QJsonArray>
 #include <openingbook.h>
+#include <latencyhistogram.h>
+#include <resourceusage.h>
+#include <chessplayer.h>
 
 class ChessGame;
+class EventStream;
+class MetricsServer;
 class OpeningBook;
+class PgnGame;
 class Tournament;
+class TournamentCoordinator;
+class TournamentWorker;
 
 
 class EngineMatch : public QObject
@@ -42,6 +52,15 @@ class EngineMatch : public QObject
 		void setDebugMode(bool debug);
 		void setRatingInterval(int interval);
 		void setBookMode(OpeningBook::AccessMode mode);
+		void setBookCacheSize(int positions);
+		void setLatencyFile(const QString& fileName);
+		void setEventOutput(const QString& target);
+		void setSharedGameManager(bool shared);
+		void setCoordinator(TournamentCoordinator* coordinator);
+		void setWorker(TournamentWorker* worker);
+		void setMetricsServer(MetricsServer* server);
+
+		Tournament* tournament() const;
 
 		void start();
 		void stop();
@@ -52,18 +71,93 @@ class EngineMatch : public QObject
 	private slots:
 		void onGameStarted(ChessGame* game, int number);
 		void onGameFinished(ChessGame* game, int number);
+		void onRemoteGameFinished(PgnGame* pgn, int number);
 		void onTournamentFinished();
 		void print(const QString& msg);
 
 	private:
+		struct EngineResources
+		{
+			EngineResources();
+
+			ResourceUsage usage;
+			int games;
+			qint64 thinkTime;
+		};
+		// Pondering of an engine in all games
+		struct PonderTotals
+		{
+			PonderTotals();
+
+			ChessPlayer::PonderStats stats;
+			qint64 thinkTime;
+		};
+		// Moves into lost tablebase positions
+		struct TablebaseLosses
+		{
+			int moves;
+			int misjudged;
+		};
+
+		void printScore();
 		void printRanking();
+		void writeRankingEvent();
+		void writeMemoryEvent();
+		void countResult(const Chess::Result& result,
+				 const QString& loserName,
+				 int plies);
+		QByteArray exportMetrics() const;
+		void printMemoryUsage();
+		void printBookStatistics();
+		void printOutputStatistics();
+		void printTablebaseStatistics();
+		void printLatency(const QString& title,
+				  const QString& name,
+				  const LatencyHistogram& latency);
+		void writeLatencyFile();
+		void printResourceUsage(const QString& name,
+					const EngineResources& resources);
+		void printTimeMargins();
+		void printPonderStatistics(const QString& name,
+					   const PonderTotals& totals);
 
 		Tournament* m_tournament;
 		bool m_debug;
 		int m_ratingInterval;
 		OpeningBook::AccessMode m_bookMode;
+		int m_bookCacheSize;
 		QMap<QString, OpeningBook*> m_books;
+		QStringList m_bookKeys;
+		QString m_latencyFile;
+		QMap<QString, LatencyHistogram> m_latency;
+		QMap<QString, LatencyHistogram> m_clockOverhead;
+		QJsonArray m_gameLatency;
+		QString m_eventOutput;
+		EventStream* m_events;
+		QMap<QString, EngineResources> m_resources;
+		QMap<QString, PonderTotals> m_ponder;
+		QMap<QString, TablebaseLosses> m_tbLosses;
+		// Adjudicated games by reason
+		QMap<QString, int> m_adjudications;
+		qint64 m_pliesSaved;
+		// Memory used by the finished games, in bytes
+		qint64 m_gameMemory;
+		qint64 m_gameMemoryPlies;
+		int m_gameMemoryCount;
+		bool m_sharedGameManager;
+		TournamentCoordinator* m_coordinator;
+		TournamentWorker* m_worker;
+		MetricsServer* m_metrics;
+		// Counters for the metrics server
+		qint64 m_gamesStarted;
+		qint64 m_gamesFinished;
+		int m_activeGames;
+		qint64 m_pliesPlayed;
+		qint64 m_timeForfeits;
+		// Games lost by crashes and stalls, by engine
+		QMap<QString, int> m_crashes;
 		QElapsedTimer m_startTime;
+		QElapsedTimer m_startupTime;
 };
 
 #endif // ENGINEMATCH_H
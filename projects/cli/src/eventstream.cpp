@@ -0,0 +1,96 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "eventstream.h"
+#include <QJsonDocument>
+
+namespace {
+
+const int s_bufferSize = 64 * 1024;
+
+} // anonymous namespace
+
+EventStream::EventStream(QObject* parent)
+	: QObject(parent)
+{
+	m_flushTimer.setSingleShot(true);
+	m_flushTimer.setInterval(100);
+	connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+EventStream::~EventStream()
+{
+	flush();
+}
+
+bool EventStream::open(const QString& target)
+{
+	const QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Unbuffered;
+	bool ok = false;
+	if (target.startsWith("fd:"))
+	{
+		int fd = target.mid(3).toInt(&ok);
+		ok = ok && m_file.open(fd, mode);
+	}
+	else
+	{
+		m_file.setFileName(target);
+		ok = m_file.open(mode | QIODevice::Truncate);
+	}
+
+	if (ok)
+	{
+		m_buffer.reserve(s_bufferSize);
+		m_clock.start();
+	}
+	return ok;
+}
+
+QString EventStream::errorString() const
+{
+	return m_file.errorString();
+}
+
+void EventStream::write(const QString& type, QJsonObject event)
+{
+	if (!m_file.isOpen())
+		return;
+
+	event["event"] = type;
+	event["time_ms"] = m_clock.elapsed();
+	m_buffer += QJsonDocument(event).toJson(QJsonDocument::Compact);
+	m_buffer += '\n';
+
+	if (m_buffer.size() >= s_bufferSize)
+		flush();
+	else if (!m_flushTimer.isActive())
+		m_flushTimer.start();
+}
+
+void EventStream::flush()
+{
+	m_flushTimer.stop();
+	if (m_buffer.isEmpty())
+		return;
+
+	if (m_file.write(m_buffer) != m_buffer.size())
+		qWarning("Can't write events to %s: %s",
+			 qUtf8Printable(m_file.fileName()),
+			 qUtf8Printable(m_file.errorString()));
+	m_buffer.resize(0);
+}
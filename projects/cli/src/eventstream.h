@@ -0,0 +1,66 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVENTSTREAM_H
+#define EVENTSTREAM_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+
+/*
+ * Writes match events as newline-delimited JSON (one object per line)
+ * to a file or an open file descriptor. Every event has an "event"
+ * member with its type and a "time_ms" member with the milliseconds
+ * since the stream was opened.
+ *
+ * Events are buffered and written at most every 100 ms, or when the
+ * buffer grows large, so writing them doesn't slow down the games.
+ */
+class EventStream : public QObject
+{
+	Q_OBJECT
+
+	public:
+		explicit EventStream(QObject* parent = nullptr);
+		virtual ~EventStream();
+
+		/*
+		 * Opens \a target for writing. The target is a file name,
+		 * or "fd:N" for the open file descriptor N.
+		 */
+		bool open(const QString& target);
+		QString errorString() const;
+
+		void write(const QString& type, QJsonObject event);
+
+	public slots:
+		void flush();
+
+	private:
+		QFile m_file;
+		QByteArray m_buffer;
+		QTimer m_flushTimer;
+		QElapsedTimer m_clock;
+};
+
+#endif // EVENTSTREAM_H
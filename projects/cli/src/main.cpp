@@ -25,34 +25,78 @@
 #include <QStringList>
 #include <QFile>
 #include <QMetaType>
+#include <QScopedPointer>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QDir>
 
 #include <mersenne.h>
 #include <enginemanager.h>
 #include <enginebuilder.h>
 #include <gamemanager.h>
+#include <cpuallocator.h>
+#include <loadmonitor.h>
+#include <livegamefeed.h>
 #include <tournament.h>
 #include <tournamentfactory.h>
 #include <board/boardfactory.h>
 #include <enginefactory.h>
 #include <enginetextoption.h>
 #include <openingsuite.h>
+#include <polyglotbookbuilder.h>
+#include <epdextractor.h>
+#include <perft.h>
+#include <pgnextractor.h>
+#include <pgnverifier.h>
+#include <pgnmerger.h>
+#include <adjudicationreplay.h>
+#include <mockengine.h>
+#include <epdtest.h>
+#include <positionanalyzer.h>
+#include <enginebenchmark.h>
+#include <enginerelay.h>
 #include <sprt.h>
+#include <sprtsimulator.h>
+#include <memoryaccount.h>
+#include <tracelog.h>
+#include <compressedfile.h>
 #include <board/syzygytablebase.h>
 #include <board/result.h>
 
 #include "cutechesscoreapp.h"
 #include "matchparser.h"
 #include "enginematch.h"
+#include "matchscheduler.h"
+#include "metricsserver.h"
+#include "benchworkload.h"
+#include "startupprofile.h"
+#include "tournamentcoordinator.h"
+#include "tournamentworker.h"
 
 namespace {
 
 EngineMatch* s_match = nullptr;
+MatchScheduler* s_scheduler = nullptr;
+PositionSearcher* s_searcher = nullptr;
+EngineBenchmark* s_benchmark = nullptr;
+EngineRelay* s_relay = nullptr;
 
 void sigintHandler(int param)
 {
 	Q_UNUSED(param);
 	if (s_match != nullptr)
 		s_match->stop();
+	else if (s_scheduler != nullptr)
+		s_scheduler->stop();
+	else if (s_searcher != nullptr)
+		s_searcher->stop();
+	else if (s_benchmark != nullptr)
+		s_benchmark->stop();
+	else if (s_relay != nullptr)
+		s_relay->stop();
 	else
 		abort();
 }
@@ -68,17 +112,15 @@ struct EngineData
 
 bool readEngineConfig(const QString& name, EngineConfiguration& config)
 {
-	const auto app = CuteChessCoreApplication::instance();
-	const auto engines = app->engineManager()->engines();
-	for (const auto& engine : engines)
-	{
-		if (engine.name() == name)
-		{
-			config = engine;
-			return true;
-		}
-	}
-	return false;
+	// The engine configuration file is loaded on the first call
+	StartupProfile::Timer timer("Engine configurations");
+	const auto manager = CuteChessCoreApplication::instance()->engineManager();
+	const int index = manager->engineIndex(name);
+	if (index == -1)
+		return false;
+
+	config = manager->engineAt(index);
+	return true;
 }
 
 bool parseEngine(const QStringList& args, EngineData& data)
@@ -102,6 +144,10 @@ bool parseEngine(const QStringList& args, EngineData& data)
 			data.config.setName(val);
 		else if (name == "cmd")
 			data.config.setCommand(val);
+		else if (name == "lib")
+			data.config.setLibrary(val);
+		else if (name == "remote")
+			data.config.setRemote(val);
 		else if (name == "dir")
 			data.config.setWorkingDirectory(val);
 		else if (name == "arg")
@@ -138,6 +184,32 @@ bool parseEngine(const QStringList& args, EngineData& data)
 
 			data.config.setRestartMode(mode);
 		}
+		// Maximum number of output lines per second before the
+		// engine's optional output is dropped
+		else if (name == "outputbudget")
+		{
+			bool ok = false;
+			int budget = val.toInt(&ok);
+			if (!ok || budget < 0)
+			{
+				qWarning() << "Invalid output budget:" << val;
+				return false;
+			}
+
+			data.config.setOutputBudget(budget);
+		}
+		else if (name == "outputpolicy")
+		{
+			if (val == "drop")
+				data.config.setOutputPolicy(EngineConfiguration::OutputDrop);
+			else if (val == "sample")
+				data.config.setOutputPolicy(EngineConfiguration::OutputSample);
+			else
+			{
+				qWarning() << "Invalid output policy:" << val;
+				return false;
+			}
+		}
 		// Trust all result claims coming from the engine?
 		else if (name == "trust")
 		{
@@ -162,7 +234,7 @@ bool parseEngine(const QStringList& args, EngineData& data)
 		else if (name == "st")
 		{
 			bool ok = false;
-			int moveTime = val.toDouble(&ok) * 1000.0;
+			int moveTime = qRound(val.toDouble(&ok) * 1000.0);
 			if (!ok || moveTime <= 0)
 			{
 				qWarning() << "Invalid search time:" << val;
@@ -174,13 +246,31 @@ bool parseEngine(const QStringList& args, EngineData& data)
 		else if (name == "timemargin")
 		{
 			bool ok = false;
-			int margin = val.toInt(&ok);
-			if (!ok || margin < 0)
+			// "auto" or "auto:CAP" follows the engine's lag
+			if (val == "auto" || val.startsWith("auto:"))
 			{
-				qWarning() << "Invalid time margin:" << val;
-				return false;
+				int cap = 1000;
+				if (val == "auto")
+					ok = true;
+				else
+					cap = val.mid(5).toInt(&ok);
+				if (!ok || cap < 0)
+				{
+					qWarning() << "Invalid time margin cap:" << val;
+					return false;
+				}
+				data.tc.setAdaptiveMargin(cap);
+			}
+			else
+			{
+				int margin = val.toInt(&ok);
+				if (!ok || margin < 0)
+				{
+					qWarning() << "Invalid time margin:" << val;
+					return false;
+				}
+				data.tc.setExpiryMargin(margin);
 			}
-			data.tc.setExpiryMargin(margin);
 		}
 		else if (name == "book")
 			data.book = val;
@@ -215,6 +305,16 @@ bool parseEngine(const QStringList& args, EngineData& data)
 			}
 			data.tc.setNodeLimit(val.toLongLong());
 		}
+		// Clock charged by nodes searched instead of wall time
+		else if (name == "nodestime")
+		{
+			if (val.toInt() <= 0)
+			{
+				qWarning() << "Invalid nodes per millisecond:" << val;
+				return false;
+			}
+			data.tc.setNodesPerMs(val.toInt());
+		}
 		else if (name == "ponder")
 		{
 			data.config.setPondering(true);
@@ -234,6 +334,98 @@ bool parseEngine(const QStringList& args, EngineData& data)
 	return true;
 }
 
+// Initializes \a sprt from the parameters of a -sprt option
+bool parseSprt(const MatchParser::Option& option, Sprt* sprt)
+{
+	QMap<QString, QString> params = option.toMap("elo0|elo1|alpha|beta|model=trinomial|units=logistic|drawelo=auto");
+	bool ok = true;
+	bool sprtOk[4];
+	double elo0 = params["elo0"].toDouble(sprtOk);
+	double elo1 = params["elo1"].toDouble(sprtOk + 1);
+	double alpha = params["alpha"].toDouble(sprtOk + 2);
+	double beta = params["beta"].toDouble(sprtOk + 3);
+
+	Sprt::Model model = Sprt::Trinomial;
+	if (params["model"] == "pentanomial")
+		model = Sprt::Pentanomial;
+	else if (params["model"] != "trinomial")
+	{
+		qWarning("Invalid SPRT model: %s",
+			 qUtf8Printable(params["model"]));
+		ok = false;
+	}
+
+	Sprt::EloScale eloScale = Sprt::LogisticScale;
+	if (params["units"] == "normalized")
+		eloScale = Sprt::NormalizedScale;
+	else if (params["units"] == "bayes")
+		eloScale = Sprt::BayesScale;
+	else if (params["units"] != "logistic")
+	{
+		qWarning("Invalid SPRT Elo units: %s",
+			 qUtf8Printable(params["units"]));
+		ok = false;
+	}
+
+	// A draw_elo of zero means it's estimated from the games
+	double drawElo = 0.0;
+	if (params["drawelo"] != "auto")
+	{
+		bool drawEloOk = false;
+		drawElo = params["drawelo"].toDouble(&drawEloOk);
+		if (!drawEloOk || drawElo <= 0.0)
+		{
+			qWarning("Invalid SPRT draw_elo: %s",
+				 qUtf8Printable(params["drawelo"]));
+			ok = false;
+		}
+	}
+
+	ok = (ok && sprtOk[0] && sprtOk[1] && sprtOk[2] && sprtOk[3]);
+	if (ok)
+		sprt->initialize(elo0, elo1, alpha, beta,
+				 model, eloScale, drawElo);
+	return ok;
+}
+
+// Fits as many games as possible on the host's physical cores, with
+// one core for each engine thread and one core left for cutechess
+// itself. The games are kept on one NUMA node each, and the engines
+// are pinned to their slot's cores where that's supported.
+void setAutoConcurrency(GameManager* manager,
+			const QList<EngineData>& engines,
+			int coresPerEngine)
+{
+	if (coresPerEngine <= 0)
+	{
+		coresPerEngine = 1;
+		for (const auto& engine : engines)
+			coresPerEngine = qMax(coresPerEngine,
+					      engine.config.threadCount());
+	}
+
+	const auto cpus = CpuAllocator::withoutCpus(
+		CpuAllocator::physicalCores(CpuAllocator::cpuGroups(true)), 1);
+	int coreCount = 0;
+	for (const auto& group : cpus)
+		coreCount += group.size();
+
+	int games = CpuAllocator::gameCapacity(coresPerEngine, cpus);
+	if (games == 0)
+	{
+		games = 1;
+		qWarning("Not enough CPU cores for %d threads per engine",
+			 coresPerEngine);
+	}
+	manager->setConcurrency(games);
+	if (CpuAllocator::hasProcessAffinity())
+		manager->setCpuAffinity(coresPerEngine, cpus);
+
+	qInfo("Concurrency: %d games with %d cores per engine "
+	      "(%d physical cores available)",
+	      games, coresPerEngine, coreCount);
+}
+
 EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 {
 	MatchParser parser(args);
@@ -242,13 +434,22 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 	parser.addOption("-engine", QVariant::StringList, 1, -1, true);
 	parser.addOption("-each", QVariant::StringList, 1);
 	parser.addOption("-variant", QVariant::String, 1, 1);
-	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	parser.addOption("-concurrency", QVariant::String, 1, 1);
+	parser.addOption("-enginepool", QVariant::Int, 1, 1);
+	parser.addOption("-affinity", QVariant::StringList);
+	parser.addOption("-loadcontrol", QVariant::StringList);
+	parser.addOption("-threads", QVariant::String, 1, 1);
 	parser.addOption("-draw", QVariant::StringList);
 	parser.addOption("-resign", QVariant::StringList);
 	parser.addOption("-maxmoves", QVariant::Int, 1, 1);
+	parser.addOption("-agreement", QVariant::StringList);
+	parser.addOption("-confirmmate", QVariant::Bool, 0, 0);
 	parser.addOption("-tb", QVariant::String, 1, 1);
 	parser.addOption("-tbpieces", QVariant::Int, 1, 1);
 	parser.addOption("-tbignore50", QVariant::Bool, 0, 0);
+	parser.addOption("-tbdtz", QVariant::Bool, 0, 0);
+	parser.addOption("-tbprefetch", QVariant::StringList);
+	parser.addOption("-tbstats", QVariant::Bool, 0, 0);
 	parser.addOption("-event", QVariant::String, 1, 1);
 	parser.addOption("-games", QVariant::Int, 1, 1);
 	parser.addOption("-rounds", QVariant::Int, 1, 1);
@@ -257,16 +458,40 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 	parser.addOption("-debug", QVariant::Bool, 0, 0);
 	parser.addOption("-openings", QVariant::StringList);
 	parser.addOption("-bookmode", QVariant::String);
+	parser.addOption("-bookcache", QVariant::Int, 1, 1);
 	parser.addOption("-pgnout", QVariant::StringList, 1, 3);
+	parser.addOption("-pgnsync", QVariant::Int, 1, 1);
+	parser.addOption("-pgnbacklog", QVariant::Int, 1, 1);
+	parser.addOption("-pgnlevel", QVariant::Int, 1, 1);
+	parser.addOption("-pgnshards", QVariant::Int, 1, 1);
 	parser.addOption("-epdout", QVariant::String, 1, 1);
+	parser.addOption("-compactout", QVariant::String, 1, 1);
+	parser.addOption("-trainingout", QVariant::StringList);
+	parser.addOption("-enginelog", QVariant::StringList);
+	parser.addOption("-randomplies", QVariant::Int, 1, 1);
+	parser.addOption("-latencyout", QVariant::String, 1, 1);
+	parser.addOption("-eventsout", QVariant::String, 1, 1);
+	parser.addOption("-metrics-port", QVariant::Int, 1, 1);
+	parser.addOption("-livefeed", QVariant::Int, 1, 1);
+	parser.addOption("-trace", QVariant::String, 1, 1);
 	parser.addOption("-repeat", QVariant::Int, 0, 1);
 	parser.addOption("-noswap", QVariant::Bool, 0, 0);
 	parser.addOption("-recover", QVariant::Bool, 0, 0);
+	parser.addOption("-checkpoint", QVariant::String, 1, 1);
+	parser.addOption("-resume", QVariant::Bool, 0, 0);
 	parser.addOption("-site", QVariant::String, 1, 1);
 	parser.addOption("-wait", QVariant::Int, 1, 1);
 	parser.addOption("-seeds", QVariant::UInt, 1, 1);
-	if (!parser.parse())
-		return nullptr;
+	parser.addOption("-lookahead", QVariant::Int, 1, 1);
+	parser.addOption("-coordinator", QVariant::StringList);
+	parser.addOption("-worker", QVariant::StringList);
+	parser.addOption("-profile-startup", QVariant::Bool, 0, 0);
+	parser.addOption("-memlimit", QVariant::Int, 1, 1);
+	{
+		StartupProfile::Timer timer("Argument parsing");
+		if (!parser.parse())
+			return nullptr;
+	}
 
 	GameManager* manager = CuteChessCoreApplication::instance()->gameManager();
 
@@ -285,6 +510,18 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 	QList<EngineData> engines;
 	QStringList eachOptions;
 	GameAdjudicator adjudicator;
+	// The opening suite is initialized after the players are added
+	// so that its sample size can depend on the number of games
+	QScopedPointer<OpeningSuite> suite;
+	QString suiteSample;
+	// -concurrency auto and -affinity are applied once the engines'
+	// thread counts are known
+	bool autoConcurrency = false;
+	int affinityCores = 0;
+	bool affinityNuma = false;
+	bool suiteUnique = false;
+	bool reproducible = false;
+	int suitePlies = 0;
 
 	const auto options = parser.options();
 	for (const auto& option : options)
@@ -309,15 +546,70 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 		// Chess variant (default: standard chess)
 		else if (name == "-variant")
 		{
-			ok = Chess::BoardFactory::variants().contains(value.toString());
+			ok = Chess::BoardFactory::isVariant(value.toString());
 			if (ok)
 				tournament->setVariant(value.toString());
 		}
 		else if (name == "-concurrency")
 		{
-			ok = value.toInt() > 0;
+			autoConcurrency = value.toString() == "auto";
+			if (!autoConcurrency)
+			{
+				ok = value.toInt() > 0;
+				if (ok)
+					manager->setConcurrency(value.toInt());
+			}
+		}
+		// Number of idle engines kept alive for later games
+		else if (name == "-enginepool")
+		{
+			ok = value.toInt() >= 0;
 			if (ok)
-				manager->setConcurrency(value.toInt());
+				manager->setIdlePlayerLimit(value.toInt());
+		}
+		// Dedicated CPU cores for each engine
+		else if (name == "-affinity")
+		{
+			QMap<QString, QString> params =
+				option.toMap("cores|numa=false");
+			affinityCores = params["cores"].toInt(&ok);
+			affinityNuma = params["numa"] == "true";
+			ok = ok && affinityCores > 0;
+		}
+		// Hold back games while the host is overloaded
+		else if (name == "-loadcontrol")
+		{
+			QMap<QString, QString> params =
+				option.toMap("maxload=1.0|npsdrop=0.5");
+			bool loadOk = false;
+			bool dropOk = false;
+			double maxLoad = params["maxload"].toDouble(&loadOk);
+			double npsDrop = params["npsdrop"].toDouble(&dropOk);
+
+			ok = loadOk && dropOk && maxLoad > 0.0
+			  && npsDrop > 0.0 && npsDrop < 1.0;
+			if (ok)
+			{
+				// Games of earlier jobs may still use the monitor
+				LoadMonitor* monitor = manager->loadMonitor();
+				if (monitor == nullptr)
+				{
+					monitor = new LoadMonitor();
+					manager->setLoadMonitor(monitor);
+				}
+				monitor->setMaxLoad(maxLoad);
+				monitor->setNpsDrop(npsDrop);
+			}
+		}
+		// Shared worker threads for the games
+		else if (name == "-threads")
+		{
+			int count = value.toString() == "auto"
+				    ? QThread::idealThreadCount()
+				    : value.toInt(&ok);
+			ok = ok && count >= 0;
+			if (ok)
+				manager->setWorkerThreadCount(count);
 		}
 		// Threshold for draw adjudication
 		else if (name == "-draw")
@@ -356,12 +648,33 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 			if (ok)
 				adjudicator.setMaximumGameLength(value.toInt());
 		}
+		// Threshold for score agreement adjudication
+		else if (name == "-agreement")
+		{
+			QMap<QString, QString> params =
+				option.toMap("movecount|score|margin");
+			bool countOk = false;
+			bool scoreOk = false;
+			bool marginOk = false;
+			int moveCount = params["movecount"].toInt(&countOk);
+			int score = params["score"].toInt(&scoreOk);
+			int margin = params["margin"].toInt(&marginOk);
+
+			ok = (countOk && scoreOk && marginOk
+			      && moveCount >= 0 && margin >= 0);
+			if (ok)
+				adjudicator.setAgreementThreshold(moveCount, score, margin);
+		}
+		// Adjudicate mate scores confirmed by the opponent
+		else if (name == "-confirmmate")
+			adjudicator.setMateConfirmation(true);
 		// Syzygy tablebase adjudication
 		else if (name == "-tb")
 		{
 			adjudicator.setTablebaseAdjudication(true);
 			QString path = value.toString();
 
+			StartupProfile::Timer timer("Tablebases");
 			ok = SyzygyTablebase::initialize(path) &&
 			     SyzygyTablebase::tbAvailable(3);
 			if (!ok)
@@ -377,6 +690,34 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 		// Syzygy ignore 50-move-rule
 		else if (name == "-tbignore50")
 			SyzygyTablebase::setNoRule50();
+		// Record the DTZ of tablebase adjudications
+		else if (name == "-tbdtz")
+			adjudicator.setTablebaseDtz(true);
+		// Read Syzygy tablebase files into memory before the games
+		else if (name == "-tbprefetch")
+		{
+			QMap<QString, QString> params =
+				option.toMap("materials|maxsize=-1|lock=false");
+			const QStringList materials =
+				params["materials"].split(',', QString::SkipEmptyParts);
+			bool sizeOk = false;
+			const qint64 maxSize = params["maxsize"].toLongLong(&sizeOk);
+
+			ok = sizeOk && !materials.isEmpty();
+			if (ok)
+			{
+				StartupProfile::Timer timer("Tablebases");
+				const qint64 bytes = SyzygyTablebase::prefetch(
+					materials,
+					maxSize < 0 ? -1 : maxSize * 1024 * 1024,
+					params["lock"] == "true");
+				qInfo("Prefetched %lld MiB of tablebases",
+				      bytes / (1024 * 1024));
+			}
+		}
+		// Collect Syzygy tablebase probe statistics
+		else if (name == "-tbstats")
+			SyzygyTablebase::setStatisticsEnabled(true);
 		// Event name
 		else if (name == "-event")
 			tournament->setName(value.toString());
@@ -408,18 +749,7 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 		}
 		// SPRT-based stopping rule
 		else if (name == "-sprt")
-		{
-			QMap<QString, QString> params = option.toMap("elo0|elo1|alpha|beta");
-			bool sprtOk[4];
-			double elo0 = params["elo0"].toDouble(sprtOk);
-			double elo1 = params["elo1"].toDouble(sprtOk + 1);
-			double alpha = params["alpha"].toDouble(sprtOk + 2);
-			double beta = params["beta"].toDouble(sprtOk + 3);
-
-			ok = (sprtOk[0] && sprtOk[1] && sprtOk[2] && sprtOk[3]);
-			if (ok)
-				tournament->sprt()->initialize(elo0, elo1, alpha, beta);
-		}
+			ok = parseSprt(option, tournament->sprt());
 		// Interval for rating list updates
 		else if (name == "-ratinginterval")
 			match->setRatingInterval(value.toInt());
@@ -433,7 +763,7 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 		else if (name == "-openings")
 		{
 			QMap<QString, QString> params =
-				option.toMap("file|format=pgn|order=sequential|plies=1024|start=1|policy=default");
+				option.toMap("file|format=pgn|order=sequential|plies=1024|start=1|policy=default|sample=0|unique=false");
 			ok = !params.isEmpty();
 
 			OpeningSuite::Format format = OpeningSuite::EpdFormat;
@@ -477,6 +807,14 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 
 			int plies = params["plies"].toInt();
 			int start = params["start"].toInt();
+			suiteUnique = params["unique"] == "true";
+			suitePlies = plies;
+			if (!suiteUnique && params["unique"] != "false")
+				ok = false;
+
+			suiteSample = params["sample"];
+			if (suiteSample != "auto" && suiteSample.toInt() < 0)
+				ok = false;
 
 			ok = ok && plies > 0 && start > 0;
 			if (ok)
@@ -484,17 +822,10 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 				tournament->setOpeningDepth(plies);
 				tournament->setOpeningPolicy(policy);
 
-				OpeningSuite* suite = new OpeningSuite(params["file"],
-								       format,
-								       order,
-								       start - 1);
-				if (order == OpeningSuite::RandomOrder)
-					qInfo("Indexing opening suite...");
-				ok = suite->initialize();
-				if (ok)
-					tournament->setOpeningSuite(suite);
-				else
-					delete suite;
+				suite.reset(new OpeningSuite(params["file"],
+							     format,
+							     order,
+							     start - 1));
 			}
 		}
 		else if (name == "-bookmode")
@@ -507,6 +838,15 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 			else
 				ok = false;
 		}
+		// Number of book positions cached across games
+		else if (name == "-bookcache")
+		{
+			const int size = value.toInt();
+			if (size >= 0)
+				match->setBookCacheSize(size);
+			else
+				ok = false;
+		}
 		// PGN file where the games should be saved
 		else if (name == "-pgnout")
 		{
@@ -527,12 +867,165 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 			if (ok)
 				tournament->setPgnOutput(list.at(0), mode);
 		}
+		// Sync the PGN output file to disk every N games
+		else if (name == "-pgnsync")
+		{
+			int games = value.toInt(&ok);
+			if (ok && games >= 0)
+				tournament->setPgnSyncInterval(games);
+			else
+				ok = false;
+		}
+		// Finished games that may wait for an earlier game
+		else if (name == "-pgnbacklog")
+		{
+			int games = value.toInt(&ok);
+			if (ok && games >= 0)
+				tournament->setPgnBacklogLimit(games);
+			else
+				ok = false;
+		}
+		// Compression level of a compressed PGN output file
+		else if (name == "-pgnlevel")
+		{
+			int level = value.toInt(&ok);
+			if (ok && level >= 1)
+				tournament->setPgnCompressionLevel(level);
+			else
+				ok = false;
+		}
+		// Number of PGN output files written in parallel
+		else if (name == "-pgnshards")
+		{
+			int shards = value.toInt(&ok);
+			if (ok && shards >= 1)
+				tournament->setPgnShardCount(shards);
+			else
+				ok = false;
+		}
 		// FEN/EPD output file to save positions
 		else if (name == "-epdout")
 		{
 			QString fileName = value.toString();
 			tournament->setEpdOutput(fileName);
 		}
+		// Output file for games in the compact binary format
+		else if (name == "-compactout")
+			tournament->setCompactOutput(value.toString());
+		// Output file for training data positions
+		else if (name == "-trainingout")
+		{
+			QMap<QString, QString> params =
+				option.toMap("file|skipcaptures=false|skipchecks=false|mindepth=0");
+			ok = !params.isEmpty();
+
+			TrainingDataWriter::Filter filter;
+			filter.skipCaptures = params["skipcaptures"] == "true";
+			filter.skipChecks = params["skipchecks"] == "true";
+			filter.minDepth = params["mindepth"].toInt(&ok);
+			if (!filter.skipCaptures && params["skipcaptures"] != "false")
+				ok = false;
+			if (!filter.skipChecks && params["skipchecks"] != "false")
+				ok = false;
+
+			if (ok && filter.minDepth >= 0)
+				tournament->setTrainingOutput(params["file"], filter);
+			else
+				ok = false;
+		}
+		// Engine traffic of the games that fail
+		else if (name == "-enginelog")
+		{
+			QMap<QString, QString> params =
+				option.toMap("dir|compress=none|buffer=1024");
+			ok = !params.isEmpty();
+
+			QString suffix;
+			const QString compress(params["compress"]);
+			CompressedFile::Compression compression = CompressedFile::NoCompression;
+			if (compress == "gz")
+				compression = CompressedFile::Gzip;
+			else if (compress == "zst")
+				compression = CompressedFile::Zstd;
+			else if (compress != "none")
+				ok = false;
+			if (compression != CompressedFile::NoCompression)
+			{
+				suffix = "." + compress;
+				if (ok && !CompressedFile::isSupported(compression))
+				{
+					qWarning("Compression %s is not supported by this build",
+						 qUtf8Printable(compress));
+					ok = false;
+				}
+			}
+
+			bool bufferOk = false;
+			const int buffer = params["buffer"].toInt(&bufferOk);
+			ok = ok && bufferOk && buffer > 0 && buffer <= 1024 * 1024;
+
+			const QString dir(params["dir"]);
+			if (ok && !QDir().mkpath(dir))
+			{
+				qWarning("Could not create directory %s",
+					 qUtf8Printable(dir));
+				ok = false;
+			}
+			if (ok)
+				tournament->setEngineLogOutput(dir, suffix, buffer * 1024);
+		}
+		// Random plies played after each new opening
+		else if (name == "-randomplies")
+		{
+			ok = value.toInt() >= 0;
+			if (ok)
+				tournament->setRandomOpeningPlies(value.toInt());
+		}
+		// Output file for move relay latency statistics
+		else if (name == "-latencyout")
+			match->setLatencyFile(value.toString());
+		// Output file or descriptor for the match events in JSON
+		else if (name == "-eventsout")
+			match->setEventOutput(value.toString());
+		// Timeline of the match in the Chrome trace event format
+		else if (name == "-trace")
+			ok = TraceLog::open(value.toString());
+		// Port of the HTTP endpoint for live metrics
+		else if (name == "-metrics-port")
+		{
+			int port = value.toInt(&ok);
+
+			ok = ok && port > 0 && port <= 0xffff;
+			if (ok)
+			{
+				auto metrics = new MetricsServer(match);
+				ok = metrics->listen(quint16(port));
+				match->setMetricsServer(metrics);
+			}
+		}
+		// Port of the live game feed for remote GUIs
+		else if (name == "-livefeed")
+		{
+			int port = value.toInt(&ok);
+
+			ok = ok && port > 0 && port <= 0xffff;
+			// Games of earlier jobs may still use the feed
+			if (ok && manager->liveFeed() != nullptr)
+				ok = manager->liveFeed()->serverPort() == port;
+			else if (ok)
+			{
+				auto feed = new LiveGameFeed();
+				ok = feed->listen(QHostAddress::Any, quint16(port));
+				if (ok)
+					manager->setLiveFeed(feed);
+				else
+				{
+					qWarning("Can't start the live game feed: %s",
+						 qUtf8Printable(feed->errorString()));
+					delete feed;
+				}
+			}
+		}
 		// Play every opening twice (default), or multiple times
 		else if (name == "-repeat")
 		{
@@ -559,6 +1052,15 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 		// Recover crashed/stalled engines
 		else if (name == "-recover")
 			tournament->setRecoveryMode(true);
+		// Checkpoint file for resuming an interrupted tournament
+		else if (name == "-checkpoint")
+			tournament->setCheckpointFile(value.toString());
+		// Continue from the games in the checkpoint file
+		else if (name == "-resume")
+		{
+			tournament->setResumeEnabled(true);
+			reproducible = true;
+		}
 		// Site/location name
 		else if (name == "-site")
 			tournament->setSite(value.toString());
@@ -568,6 +1070,7 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 			uint seed = value.toUInt(&ok);
 			if (ok)
 				Mersenne::initialize(seed);
+			reproducible = true;
 		}
 		// Delay between games
 		else if (name == "-wait")
@@ -583,6 +1086,56 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 			if (ok)
 				tournament->setSeedCount(seedCount);
 		}
+		// Start the longest of the upcoming games first
+		else if (name == "-lookahead")
+		{
+			ok = value.toInt() >= 0;
+			if (ok)
+				tournament->setLookahead(value.toInt());
+		}
+		// Hand the games out to remote workers
+		else if (name == "-coordinator")
+		{
+			QMap<QString, QString> params = option.toMap("port");
+			int port = params["port"].toInt(&ok);
+
+			ok = ok && port > 0 && port <= 0xffff;
+			if (ok)
+			{
+				auto coordinator = new TournamentCoordinator(tournament, match);
+				ok = coordinator->listen(quint16(port));
+				match->setCoordinator(coordinator);
+			}
+		}
+		// Play the games of a remote coordinator
+		else if (name == "-worker")
+		{
+			QMap<QString, QString> params =
+				option.toMap("host|port|pgn=true|pgnout=none");
+			int port = params["port"].toInt(&ok);
+
+			ok = ok && port > 0 && port <= 0xffff
+			     && !params["host"].isEmpty();
+			if (ok)
+			{
+				auto worker = new TournamentWorker(tournament, match);
+				worker->setCoordinator(params["host"], quint16(port));
+				worker->setPgnEnabled(params["pgn"] == "true");
+				if (params["pgnout"] != "none")
+					worker->setPgnOutput(params["pgnout"]);
+				match->setWorker(worker);
+			}
+		}
+		// Memory budget in MiB
+		else if (name == "-memlimit")
+		{
+			ok = value.toInt() >= 0;
+			if (ok)
+				MemoryAccount::setBudget(qint64(value.toInt()) * 1024 * 1024);
+		}
+		// Start-up profiling is enabled by main()
+		else if (name == "-profile-startup")
+			;
 		else
 			qFatal("Unknown argument: \"%s\"", qUtf8Printable(name));
 
@@ -632,7 +1185,8 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 			break;
 		}
 
-		if (engine.config.command().isEmpty())
+		if (engine.config.command().isEmpty()
+		&&  engine.config.remote().isEmpty())
 		{
 			ok = false;
 			qCritical("missing chess engine command");
@@ -658,6 +1212,47 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 		ok = false;
 	}
 
+	if (ok && autoConcurrency)
+		setAutoConcurrency(manager, engines, affinityCores);
+	else if (ok && affinityCores > 0)
+		manager->setCpuAffinity(affinityCores, affinityNuma);
+
+	if (ok && suite)
+	{
+		if (suiteSample == "auto")
+			suite->setSampleSize(tournament->openingCount());
+		else
+			suite->setSampleSize(suiteSample.toInt());
+
+		if (suiteUnique)
+			suite->setUniquePositions(tournament->variant(),
+						  suitePlies);
+
+		// Games can start before a random order suite is indexed,
+		// unless the openings must be the same in every run
+		suite->setBackgroundIndexing(!reproducible);
+		if (suiteUnique || (reproducible
+		&&  suite->order() == OpeningSuite::RandomOrder))
+			qInfo("Indexing opening suite...");
+		{
+			StartupProfile::Timer timer("Opening suite");
+			ok = suite->initialize();
+		}
+		if (ok && suiteUnique)
+		{
+			if (suite->duplicateCount() >= 0)
+				qInfo("Opening suite: %d unique positions, "
+				      "%d duplicates skipped",
+				      suite->openingCount(),
+				      suite->duplicateCount());
+			else
+				qInfo("Opening suite: %d unique positions",
+				      suite->openingCount());
+		}
+		if (ok)
+			tournament->setOpeningSuite(suite.take());
+	}
+
 	if (!ok)
 	{
 		delete match;
@@ -670,39 +1265,1406 @@ EngineMatch* parseMatch(const QStringList& args, QObject* parent)
 	return match;
 }
 
-} // anonymous namespace
-
-int main(int argc, char* argv[])
+bool makeBook(const QStringList& args)
 {
-	// Register types for signal / slot connections
-	qRegisterMetaType<Chess::Result>("Chess::Result");
-
-	setvbuf(stdout, nullptr, _IONBF, 0);
-	signal(SIGINT, sigintHandler);
-
-	CuteChessCoreApplication app(argc, argv);
+	MatchParser parser(args);
+	parser.addOption("-pgnin", QVariant::StringList, 1, -1, true);
+	parser.addOption("-bookout", QVariant::String, 1, 1);
+	parser.addOption("-plies", QVariant::Int, 1, 1);
+	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	parser.addOption("-memory", QVariant::Int, 1, 1);
+	if (!parser.parse())
+		return false;
 
-	QStringList arguments = CuteChessCoreApplication::arguments();
-	arguments.takeFirst(); // application name
+	PolyglotBookBuilder builder;
+	QStringList pgnFiles;
+	QString bookFile;
 
-	// Use trivial command-line parsing for now
-	QTextStream out(stdout);
-	const auto& constArguments = arguments;
-	for (const auto& arg : constArguments)
+	const auto options = parser.options();
+	for (const auto& option : options)
 	{
-		if (arg == "-v" || arg == "--version" || arg == "-version")
-		{
-			out << "cutechess-cli " << CUTECHESS_CLI_VERSION << endl;
-			out << "Using Qt version " << qVersion() << endl << endl;
-			out << "Copyright (C) 2008-2018 Ilari Pihlajisto and Arto Jonsson" << endl;
-			out << "This is free software; see the source for copying ";
-			out << "conditions.  There is NO" << endl << "warranty; not even for ";
-			out << "MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.";
-			out << endl << endl;
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
 
-			return 0;
-		}
-		else if (arg == "--engines" || arg == "-engines")
+		if (name == "-pgnin")
+			pgnFiles += value.toStringList();
+		else if (name == "-bookout")
+			bookFile = value.toString();
+		else if (name == "-plies")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				builder.setMaxPlies(value.toInt());
+		}
+		else if (name == "-concurrency")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				builder.setThreadCount(value.toInt());
+		}
+		else if (name == "-memory")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				builder.setMemoryLimit(qint64(value.toInt()) << 20);
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.toString()));
+			return false;
+		}
+	}
+
+	if (pgnFiles.isEmpty() || bookFile.isEmpty())
+	{
+		qWarning("makebook needs a PGN file and a book file");
+		return false;
+	}
+
+	for (const QString& fileName : qAsConst(pgnFiles))
+	{
+		qInfo("Reading %s...", qUtf8Printable(fileName));
+		if (!builder.addPgnFile(fileName))
+			return false;
+	}
+
+	qInfo("Writing %s...", qUtf8Printable(bookFile));
+	if (!builder.write(bookFile))
+		return false;
+
+	qInfo("%lld games, %lld book entries",
+	      builder.gameCount(), builder.entryCount());
+	return true;
+}
+
+bool makeEpd(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-pgnin", QVariant::StringList, 1, -1, true);
+	parser.addOption("-epdout", QVariant::String, 1, 1);
+	parser.addOption("-plies", QVariant::String, 1, 1);
+	parser.addOption("-results", QVariant::StringList, 1, -1);
+	parser.addOption("-maxscore", QVariant::Int, 1, 1);
+	parser.addOption("-unique", QVariant::Bool, 0, 0);
+	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	if (!parser.parse())
+		return false;
+
+	EpdExtractor extractor;
+	QStringList pgnFiles;
+	QString epdFile;
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-pgnin")
+			pgnFiles += value.toStringList();
+		else if (name == "-epdout")
+			epdFile = value.toString();
+		// A single ply or a range, eg. "8" or "8-12"
+		else if (name == "-plies")
+		{
+			const QStringList list(value.toString().split('-'));
+			bool minOk = false;
+			bool maxOk = false;
+			const int minPly = list.first().toInt(&minOk);
+			const int maxPly = list.last().toInt(&maxOk);
+			ok = list.size() <= 2 && minOk && maxOk
+			  && minPly >= 0 && minPly <= maxPly;
+			if (ok)
+				extractor.setPlies(minPly, maxPly);
+		}
+		else if (name == "-results")
+		{
+			const QStringList results(value.toStringList());
+			for (const QString& result : results)
+			{
+				if (result != "1-0" && result != "0-1"
+				&&  result != "1/2-1/2" && result != "*")
+					ok = false;
+			}
+			if (ok)
+				extractor.setResults(results);
+		}
+		else if (name == "-maxscore")
+		{
+			ok = value.toInt() >= 0;
+			if (ok)
+				extractor.setMaxScore(value.toInt());
+		}
+		else if (name == "-unique")
+			extractor.setUnique(true);
+		else if (name == "-concurrency")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				extractor.setThreadCount(value.toInt());
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.toString()));
+			return false;
+		}
+	}
+
+	if (pgnFiles.isEmpty() || epdFile.isEmpty())
+	{
+		qWarning("makeepd needs a PGN file and an EPD file");
+		return false;
+	}
+
+	if (!extractor.open(epdFile))
+		return false;
+	for (const QString& fileName : qAsConst(pgnFiles))
+	{
+		qInfo("Reading %s...", qUtf8Printable(fileName));
+		if (!extractor.addPgnFile(fileName))
+			return false;
+	}
+	if (!extractor.close())
+		return false;
+
+	qInfo("%lld games, %lld positions, %lld duplicates dropped",
+	      extractor.gameCount(), extractor.positionCount(),
+	      extractor.duplicateCount());
+	return true;
+}
+
+bool runPerft(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-depth", QVariant::Int, 1, 1, true);
+	parser.addOption("-variant", QVariant::String, 1, 1);
+	parser.addOption("-fen", QVariant::String, 1, 1);
+	parser.addOption("-divide", QVariant::Bool, 0, 0);
+	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	parser.addOption("-hash", QVariant::Int, 1, 1);
+	if (!parser.parse())
+		return false;
+
+	Perft perft;
+	int depth = 0;
+	QString variant("standard");
+	QString fen;
+	bool divide = false;
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-depth")
+		{
+			depth = value.toInt();
+			ok = depth > 0;
+		}
+		else if (name == "-variant")
+			variant = value.toString();
+		else if (name == "-fen")
+			fen = value.toString();
+		else if (name == "-divide")
+			divide = true;
+		else if (name == "-concurrency")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				perft.setThreadCount(value.toInt());
+		}
+		else if (name == "-hash")
+		{
+			ok = value.toInt() >= 0;
+			if (ok)
+				perft.setHashSize(value.toInt());
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.toString()));
+			return false;
+		}
+	}
+
+	if (!perft.setPosition(variant, fen))
+	{
+		qWarning("%s", qUtf8Printable(perft.errorString()));
+		return false;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	quint64 nodes = 0;
+	if (divide)
+	{
+		const auto moves = perft.divide(depth);
+		for (const Perft::RootMove& move : moves)
+		{
+			qInfo("%s: %llu", qUtf8Printable(move.move), move.nodes);
+			nodes += move.nodes;
+		}
+		qInfo("Moves: %d", moves.size());
+	}
+	else
+		nodes = perft.count(depth);
+
+	const qint64 elapsed = qMax(qint64(1), timer.elapsed());
+	qInfo("Nodes: %llu", nodes);
+	qInfo("Time: %.3f s, %.0f nodes/s", elapsed / 1000.0,
+	      nodes * 1000.0 / elapsed);
+	return true;
+}
+
+// Parses a list of numbers, eg. the values of -elo
+bool parseNumbers(const QStringList& list, QList<double>* numbers)
+{
+	for (const QString& str : list)
+	{
+		bool ok = false;
+		const double number = str.toDouble(&ok);
+		if (!ok)
+			return false;
+		numbers->append(number);
+	}
+	return true;
+}
+
+bool simulateSprt(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-sprt", QVariant::StringList, 1, -1, true);
+	parser.addOption("-elo", QVariant::StringList, 1, -1, true);
+	parser.addOption("-draws", QVariant::StringList, 1, -1);
+	parser.addOption("-runs", QVariant::Int, 1, 1);
+	parser.addOption("-maxgames", QVariant::Int, 1, 1);
+	parser.addOption("-pairbias", QVariant::String, 1, 1);
+	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	parser.addOption("-srand", QVariant::UInt, 1, 1);
+	if (!parser.parse())
+		return false;
+
+	Sprt sprt;
+	QList<double> elos;
+	QList<double> drawRatios;
+	int runs = 1000;
+	int maxGames = 0;
+	double pairBias = 0.0;
+	int threads = QThread::idealThreadCount();
+	uint seed = 0;
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-sprt")
+			ok = parseSprt(option, &sprt);
+		else if (name == "-elo")
+			ok = parseNumbers(value.toStringList(), &elos);
+		else if (name == "-draws")
+		{
+			ok = parseNumbers(value.toStringList(), &drawRatios);
+			for (double ratio : qAsConst(drawRatios))
+				ok = ok && ratio >= 0.0 && ratio < 1.0;
+		}
+		else if (name == "-runs")
+		{
+			runs = value.toInt();
+			ok = runs > 0;
+		}
+		else if (name == "-maxgames")
+		{
+			maxGames = value.toInt();
+			ok = maxGames >= 0;
+		}
+		else if (name == "-pairbias")
+		{
+			pairBias = value.toString().toDouble(&ok);
+			ok = ok && pairBias >= 0.0;
+		}
+		else if (name == "-concurrency")
+		{
+			threads = value.toInt();
+			ok = threads > 0;
+		}
+		else if (name == "-srand")
+			seed = value.toUInt();
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.toString()));
+			return false;
+		}
+	}
+
+	if (drawRatios.isEmpty())
+		drawRatios << 0.5;
+	// The trinomial test needs wins, losses and draws to end
+	if (maxGames == 0 && sprt.model() == Sprt::Trinomial
+	&&  drawRatios.contains(0.0))
+	{
+		qWarning("A draw ratio of 0 needs -maxgames with the trinomial model");
+		return false;
+	}
+
+	SprtSimulator simulator(sprt);
+	simulator.setRunCount(runs);
+	simulator.setMaxGames(maxGames);
+	simulator.setPairBias(pairBias);
+	simulator.setThreadCount(threads);
+	simulator.setSeed(seed);
+
+	qInfo("%d runs per assumption, games needed to stop:", runs);
+	qInfo("%7s %6s %7s %7s %7s %9s %9s %9s %9s %9s",
+	      "Elo", "Draws", "H0", "H1", "Limit",
+	      "Mean", "Median", "90%", "99%", "Max");
+	for (double elo : qAsConst(elos))
+	{
+		for (double drawRatio : qAsConst(drawRatios))
+		{
+			const auto summary = simulator.run(elo, drawRatio);
+			qInfo("%7.2f %6.2f %6.1f%% %6.1f%% %6.1f%% %9.0f %9d %9d %9d %9d",
+			      elo, drawRatio,
+			      100.0 * summary.h0 / summary.runs,
+			      100.0 * summary.h1 / summary.runs,
+			      100.0 * summary.truncated / summary.runs,
+			      summary.meanGames,
+			      summary.percentile(50), summary.percentile(90),
+			      summary.percentile(99), summary.games.last());
+		}
+	}
+
+	return true;
+}
+
+bool runBench(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-corpus", QVariant::Int, 1, 1);
+	parser.addOption("-games", QVariant::Int, 1, 1);
+	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	if (!parser.parse())
+		return false;
+
+	BenchWorkload bench;
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-corpus")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				bench.setCorpusSize(value.toInt());
+		}
+		else if (name == "-games")
+		{
+			ok = value.toInt() >= 0;
+			if (ok)
+				bench.setTournamentGames(value.toInt());
+		}
+		else if (name == "-concurrency")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				bench.setConcurrency(value.toInt());
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.toString()));
+			return false;
+		}
+	}
+
+	if (!bench.run())
+		return false;
+
+	const auto stages = bench.stages();
+	for (const BenchWorkload::Stage& stage : stages)
+	{
+		qInfo("%-10s %10lld %-7s %9.3f s %12.0f %s/s",
+		      qUtf8Printable(stage.name), stage.work,
+		      qUtf8Printable(stage.unit), stage.nsecs / 1.0e9,
+		      stage.rate(), qUtf8Printable(stage.unit));
+	}
+	qInfo("Score: %.0f", bench.score());
+	return true;
+}
+
+bool filterPgn(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-pgnin", QVariant::StringList, 1, -1, true);
+	parser.addOption("-pgnout", QVariant::String, 1, 1);
+	parser.addOption("-event", QVariant::String, 1, 1);
+	parser.addOption("-site", QVariant::String, 1, 1);
+	parser.addOption("-player", QVariant::String, 1, 1);
+	parser.addOption("-opponent", QVariant::String, 1, 1);
+	parser.addOption("-side", QVariant::String, 1, 1);
+	parser.addOption("-result", QVariant::String, 1, 1);
+	parser.addOption("-from", QVariant::String, 1, 1);
+	parser.addOption("-to", QVariant::String, 1, 1);
+	parser.addOption("-minplies", QVariant::Int, 1, 1);
+	parser.addOption("-variant", QVariant::String, 1, 1);
+	if (!parser.parse())
+		return false;
+
+	PgnGameFilter filter;
+	QStringList pgnFiles;
+	QString outFile;
+	QString player;
+	Chess::Side side;
+	int minPlies = 0;
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-pgnin")
+			pgnFiles += value.toStringList();
+		else if (name == "-pgnout")
+			outFile = value.toString();
+		else if (name == "-event")
+			filter.setEvent(value.toString());
+		else if (name == "-site")
+			filter.setSite(value.toString());
+		else if (name == "-player")
+			player = value.toString();
+		else if (name == "-opponent")
+			filter.setOpponent(value.toString());
+		else if (name == "-side")
+		{
+			if (value.toString() == "white")
+				side = Chess::Side::White;
+			else if (value.toString() == "black")
+				side = Chess::Side::Black;
+			else
+				ok = false;
+		}
+		else if (name == "-result")
+		{
+			static const QMap<QString, PgnGameFilter::Result> results = {
+				{ "1-0", PgnGameFilter::WhiteWins },
+				{ "0-1", PgnGameFilter::BlackWins },
+				{ "1/2-1/2", PgnGameFilter::Draw },
+				{ "*", PgnGameFilter::Unfinished },
+				{ "decisive", PgnGameFilter::EitherPlayerWins },
+				{ "win", PgnGameFilter::FirstPlayerWins },
+				{ "loss", PgnGameFilter::FirstPlayerLoses }
+			};
+			ok = results.contains(value.toString());
+			if (ok)
+				filter.setResult(results.value(value.toString()));
+		}
+		else if (name == "-from" || name == "-to")
+		{
+			const QDate date(QDate::fromString(value.toString(), "yyyy.MM.dd"));
+			ok = date.isValid();
+			if (ok && name == "-from")
+				filter.setMinDate(date);
+			else if (ok)
+				filter.setMaxDate(date);
+		}
+		else if (name == "-minplies")
+		{
+			minPlies = value.toInt();
+			ok = minPlies >= 0;
+		}
+		else if (name == "-variant")
+			filter.setVariant(value.toString());
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.toString()));
+			return false;
+		}
+	}
+
+	if (pgnFiles.isEmpty() || outFile.isEmpty())
+	{
+		qWarning("pgnfilter needs an input and an output PGN file");
+		return false;
+	}
+	if (!player.isEmpty() || !side.isNull())
+		filter.setPlayer(player, side);
+
+	PgnExtractor extractor(filter);
+	extractor.setMinPlies(minPlies);
+	if (!extractor.open(outFile))
+		return false;
+	for (const QString& fileName : qAsConst(pgnFiles))
+	{
+		qInfo("Reading %s...", qUtf8Printable(fileName));
+		if (!extractor.addPgnFile(fileName))
+			return false;
+	}
+	if (!extractor.close())
+		return false;
+
+	qInfo("%lld of %lld games copied",
+	      extractor.matchCount(), extractor.gameCount());
+	return true;
+}
+
+bool checkPgn(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-pgnin", QVariant::StringList, 1, -1, true);
+	parser.addOption("-pgnout", QVariant::StringList, 1, 2);
+	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	if (!parser.parse())
+		return false;
+
+	PgnVerifier verifier;
+	QStringList pgnFiles;
+	QString outFile;
+	PgnGame::PgnMode mode = PgnGame::Verbose;
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-pgnin")
+			pgnFiles += value.toStringList();
+		else if (name == "-pgnout")
+		{
+			const QStringList list(value.toStringList());
+			outFile = list.first();
+			if (list.size() == 2)
+			{
+				ok = list.last() == "min";
+				mode = PgnGame::Minimal;
+			}
+		}
+		else if (name == "-concurrency")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				verifier.setThreadCount(value.toInt());
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.toString()));
+			return false;
+		}
+	}
+
+	if (!outFile.isEmpty() && !verifier.open(outFile, mode))
+		return false;
+	for (const QString& fileName : qAsConst(pgnFiles))
+	{
+		qInfo("Reading %s...", qUtf8Printable(fileName));
+		if (!verifier.addPgnFile(fileName))
+			return false;
+	}
+	if (!verifier.close())
+		return false;
+
+	qInfo("%lld games, %lld with errors",
+	      verifier.gameCount(), verifier.errorCount());
+	return verifier.errorCount() == 0;
+}
+
+bool mergePgn(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-pgnin", QVariant::StringList, 1, -1, true);
+	parser.addOption("-pgnout", QVariant::String, 1, 1);
+	parser.addOption("-order", QVariant::String, 1, 1);
+	parser.addOption("-window", QVariant::Int, 1, 1);
+	if (!parser.parse())
+		return false;
+
+	PgnMerger merger;
+	QStringList pgnFiles;
+	QString outFile;
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-pgnin")
+			pgnFiles += value.toStringList();
+		else if (name == "-pgnout")
+			outFile = value.toString();
+		else if (name == "-order")
+		{
+			if (value.toString() == "number")
+				merger.setOrdered(true);
+			else if (value.toString() == "input")
+				merger.setOrdered(false);
+			else
+				ok = false;
+		}
+		else if (name == "-window")
+		{
+			ok = value.toInt() >= 0;
+			if (ok)
+				merger.setWindow(value.toInt());
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.toString()));
+			return false;
+		}
+	}
+
+	if (pgnFiles.isEmpty() || outFile.isEmpty())
+	{
+		qWarning("pgnmerge needs input and output PGN files");
+		return false;
+	}
+	if (!merger.open(outFile)
+	||  !merger.merge(pgnFiles)
+	||  !merger.close())
+		return false;
+
+	qInfo("%lld games merged, %lld duplicates dropped",
+	      merger.gameCount(), merger.duplicateCount());
+	return true;
+}
+
+bool parseCandidate(const MatchParser::Option& option,
+		    QString* name,
+		    GameAdjudicator* adjudicator)
+{
+	QMap<QString, QString> params = option.toMap(
+		"name|draw=none|resign=none|agreement=none|maxmoves=0|"
+		"confirmmate=false|tb=false");
+	if (params.isEmpty())
+		return false;
+
+	// Comma-separated numbers, or "none" to disable a threshold
+	auto numbers = [&](const QString& key, int min, int max, QList<int>* out)
+	{
+		const QString str(params[key]);
+		if (str == "none")
+			return true;
+		const QStringList list(str.split(','));
+		if (list.size() < min || list.size() > max)
+			return false;
+		for (const QString& item : list)
+		{
+			bool ok = false;
+			out->append(item.toInt(&ok));
+			if (!ok)
+				return false;
+		}
+		return true;
+	};
+
+	const bool twoSided = params["resign"].endsWith(",twosided");
+	if (twoSided)
+		params["resign"].chop(9);
+
+	QList<int> draw;
+	QList<int> resign;
+	QList<int> agreement;
+	bool maxOk = false;
+	const int maxMoves = params["maxmoves"].toInt(&maxOk);
+	if (!numbers("draw", 3, 3, &draw)
+	||  !numbers("resign", 2, 2, &resign)
+	||  !numbers("agreement", 3, 3, &agreement)
+	||  !maxOk || maxMoves < 0)
+	{
+		qWarning("Invalid adjudication candidate \"%s\"",
+			 qUtf8Printable(option.value.toStringList().join(' ')));
+		return false;
+	}
+
+	*name = params["name"];
+	if (!draw.isEmpty())
+		adjudicator->setDrawThreshold(draw[0], draw[1], draw[2]);
+	if (!resign.isEmpty())
+		adjudicator->setResignThreshold(resign[0], -resign[1], twoSided);
+	if (!agreement.isEmpty())
+		adjudicator->setAgreementThreshold(agreement[0],
+						   agreement[1],
+						   agreement[2]);
+	adjudicator->setMaximumGameLength(maxMoves);
+	adjudicator->setMateConfirmation(params["confirmmate"] == "true");
+	adjudicator->setTablebaseAdjudication(params["tb"] == "true");
+
+	return true;
+}
+
+bool replayAdjudication(const QStringList& args)
+{
+	MatchParser parser(args);
+	parser.addOption("-pgnin", QVariant::StringList, 1, -1, true);
+	parser.addOption("-candidate", QVariant::StringList, 1, -1, true);
+	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	parser.addOption("-tb", QVariant::String, 1, 1);
+	if (!parser.parse())
+		return false;
+
+	AdjudicationReplay replay;
+	QStringList pgnFiles;
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-pgnin")
+			pgnFiles += value.toStringList();
+		else if (name == "-candidate")
+		{
+			QString candidate;
+			GameAdjudicator adjudicator;
+			if (!parseCandidate(option, &candidate, &adjudicator))
+				return false;
+			replay.addCandidate(candidate, adjudicator);
+		}
+		else if (name == "-concurrency")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				replay.setThreadCount(value.toInt());
+		}
+		else if (name == "-tb")
+		{
+			ok = SyzygyTablebase::initialize(value.toString()) &&
+			     SyzygyTablebase::tbAvailable(3);
+			if (!ok)
+				qWarning("Could not load Syzygy tablebases");
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.toString()));
+			return false;
+		}
+	}
+
+	if (pgnFiles.isEmpty() || replay.candidateCount() == 0)
+	{
+		qWarning("replay needs a PGN file and an adjudication candidate");
+		return false;
+	}
+
+	for (const QString& fileName : qAsConst(pgnFiles))
+	{
+		qInfo("Replaying %s...", qUtf8Printable(fileName));
+		if (!replay.addPgnFile(fileName))
+			return false;
+	}
+
+	qInfo("%lld games replayed", replay.gameCount());
+	for (int i = 0; i < replay.candidateCount(); i++)
+	{
+		const auto stats = replay.statistics(i);
+		const double games = qMax(stats.games, Q_INT64_C(1));
+		const double adjudicated = qMax(stats.adjudicated, Q_INT64_C(1));
+		qInfo("%s: %lld games adjudicated (%.1f%%), %lld plies saved "
+		      "(%.1f per game), %lld wrong results (%.2f%%)",
+		      qUtf8Printable(replay.candidateName(i)),
+		      stats.adjudicated, 100.0 * stats.adjudicated / games,
+		      stats.pliesSaved, stats.pliesSaved / games,
+		      stats.wrongResults, 100.0 * stats.wrongResults / adjudicated);
+	}
+
+	return true;
+}
+
+void printEpdResult(const EpdTest* test, const EpdTest::PositionResult& result)
+{
+	QString status;
+	if (result.solved)
+		status = QString("solved in %1s")
+			 .arg(result.solveTime / 1000.0, 0, 'f', 2);
+	else
+		status = "not solved";
+
+	qInfo("Position %d/%d (%s): %s played %s, %s",
+	      result.position + 1,
+	      test->positionCount(),
+	      qUtf8Printable(test->positionId(result.position)),
+	      qUtf8Printable(test->engineName(result.engine)),
+	      result.move.isEmpty() ? "no move" : qUtf8Printable(result.move),
+	      qUtf8Printable(status));
+}
+
+void printEpdTotals(const EpdTest* test)
+{
+	for (int i = 0; i < test->engineCount(); i++)
+	{
+		const int solved = test->solvedCount(i);
+		const double avgTime = test->totalSolveTime(i)
+				       / 1000.0 / qMax(solved, 1);
+		qInfo("%s: %d/%d solved, %.2fs total solve time, "
+		      "%.2fs per solved position",
+		      qUtf8Printable(test->engineName(i)),
+		      solved, test->searchedCount(i),
+		      test->totalSolveTime(i) / 1000.0, avgTime);
+	}
+}
+
+EpdTest* parseEpdTest(const QStringList& args, QObject* parent)
+{
+	MatchParser parser(args);
+	parser.addOption("-epdin", QVariant::StringList, 1, -1, true);
+	parser.addOption("-engine", QVariant::StringList, 1, -1, true);
+	parser.addOption("-each", QVariant::StringList, 1);
+	parser.addOption("-variant", QVariant::String, 1, 1);
+	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	if (!parser.parse())
+		return nullptr;
+
+	GameManager* manager = CuteChessCoreApplication::instance()->gameManager();
+	QScopedPointer<EpdTest> test(new EpdTest(manager, parent));
+	QList<EngineData> engines;
+	QStringList eachOptions;
+	QStringList epdFiles;
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-epdin")
+			epdFiles += value.toStringList();
+		else if (name == "-engine")
+		{
+			EngineData engine;
+			engine.bookDepth = 0;
+			ok = parseEngine(value.toStringList(), engine);
+			if (ok)
+				engines.append(engine);
+		}
+		else if (name == "-each")
+			eachOptions = value.toStringList();
+		else if (name == "-variant")
+			ok = test->setVariant(value.toString());
+		else if (name == "-concurrency")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				manager->setConcurrency(value.toInt());
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.type() == QVariant::StringList
+						? value.toStringList().join(' ')
+						: value.toString()));
+			return nullptr;
+		}
+	}
+
+	if (epdFiles.isEmpty() || engines.isEmpty())
+	{
+		qWarning("epdtest needs an EPD file and an engine");
+		return nullptr;
+	}
+
+	for (auto& engine : engines)
+	{
+		if (!eachOptions.isEmpty() && !parseEngine(eachOptions, engine))
+			return nullptr;
+		if (!engine.tc.isValid())
+		{
+			qWarning("Invalid or missing time control");
+			return nullptr;
+		}
+		if (engine.config.command().isEmpty()
+		&&  engine.config.remote().isEmpty())
+		{
+			qCritical("missing chess engine command");
+			return nullptr;
+		}
+		if (engine.config.protocol().isEmpty())
+		{
+			qWarning("Missing chess protocol");
+			return nullptr;
+		}
+		test->addEngine(engine.config, engine.tc);
+	}
+
+	for (const QString& fileName : qAsConst(epdFiles))
+	{
+		if (!test->addPositions(fileName))
+		{
+			qWarning("%s", qUtf8Printable(test->errorString()));
+			return nullptr;
+		}
+	}
+	qInfo("%d test positions", test->positionCount());
+
+	const EpdTest* testPtr = test.data();
+	QObject::connect(testPtr, &EpdTest::positionFinished, testPtr,
+			 [=](const EpdTest::PositionResult& result)
+	{
+		printEpdResult(testPtr, result);
+	});
+	QObject::connect(testPtr, &EpdTest::finished, testPtr, [=]()
+	{
+		printEpdTotals(testPtr);
+		if (!testPtr->errorString().isEmpty())
+			qWarning("%s", qUtf8Printable(testPtr->errorString()));
+	});
+
+	return test.take();
+}
+
+PositionAnalyzer* parseAnalysis(const QStringList& args, QObject* parent)
+{
+	MatchParser parser(args);
+	parser.addOption("-epdin", QVariant::StringList, 1, -1, true);
+	parser.addOption("-pgnin", QVariant::StringList, 1, -1, true);
+	parser.addOption("-engine", QVariant::StringList, 1, -1, true);
+	parser.addOption("-each", QVariant::StringList, 1);
+	parser.addOption("-variant", QVariant::String, 1, 1);
+	parser.addOption("-concurrency", QVariant::Int, 1, 1);
+	parser.addOption("-newgame", QVariant::Bool, 0, 0);
+	parser.addOption("-epdout", QVariant::String, 1, 1);
+	if (!parser.parse())
+		return nullptr;
+
+	GameManager* manager = CuteChessCoreApplication::instance()->gameManager();
+	QScopedPointer<PositionAnalyzer> analyzer(
+		new PositionAnalyzer(manager, parent));
+	QList<EngineData> engines;
+	QStringList eachOptions;
+	bool hasInput = false;
+	bool hasOutputFile = false;
+
+	// Engines keep their state between positions unless told otherwise
+	analyzer->setNewGameEnabled(false);
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-epdin")
+		{
+			for (const QString& fileName : value.toStringList())
+				analyzer->addEpdFile(fileName);
+			hasInput = true;
+		}
+		else if (name == "-pgnin")
+		{
+			for (const QString& fileName : value.toStringList())
+				analyzer->addPgnFile(fileName);
+			hasInput = true;
+		}
+		else if (name == "-engine")
+		{
+			EngineData engine;
+			engine.bookDepth = 0;
+			ok = parseEngine(value.toStringList(), engine);
+			if (ok)
+				engines.append(engine);
+		}
+		else if (name == "-each")
+			eachOptions = value.toStringList();
+		else if (name == "-variant")
+			ok = analyzer->setVariant(value.toString());
+		else if (name == "-concurrency")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				manager->setConcurrency(value.toInt());
+		}
+		else if (name == "-newgame")
+			analyzer->setNewGameEnabled(true);
+		else if (name == "-epdout")
+		{
+			ok = analyzer->setOutput(value.toString());
+			hasOutputFile = true;
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.type() == QVariant::StringList
+						? value.toStringList().join(' ')
+						: value.toString()));
+			return nullptr;
+		}
+	}
+
+	if (!hasInput || engines.isEmpty())
+	{
+		qWarning("analyze needs an input file and an engine");
+		return nullptr;
+	}
+
+	for (auto& engine : engines)
+	{
+		if (!eachOptions.isEmpty() && !parseEngine(eachOptions, engine))
+			return nullptr;
+		if (!engine.tc.isValid())
+		{
+			qWarning("Invalid or missing time control");
+			return nullptr;
+		}
+		if (engine.config.command().isEmpty()
+		&&  engine.config.remote().isEmpty())
+		{
+			qCritical("missing chess engine command");
+			return nullptr;
+		}
+		if (engine.config.protocol().isEmpty())
+		{
+			qWarning("Missing chess protocol");
+			return nullptr;
+		}
+		analyzer->addEngine(engine.config, engine.tc);
+	}
+
+	// The results go to the standard output unless there's a file
+	const PositionAnalyzer* analyzerPtr = analyzer.data();
+	QObject::connect(analyzerPtr, &PositionAnalyzer::finished,
+			 analyzerPtr, [=]()
+	{
+		if (hasOutputFile)
+			qInfo("%d positions analyzed", analyzerPtr->analyzedCount());
+		if (!analyzerPtr->errorString().isEmpty())
+			qWarning("%s", qUtf8Printable(analyzerPtr->errorString()));
+	});
+
+	return analyzer.take();
+}
+
+void printBenchmarkResults(const EngineBenchmark* benchmark, int engine)
+{
+	const QString name = benchmark->engineName(engine);
+	for (int i = 0; i < EngineBenchmark::MeasurementCount; i++)
+	{
+		auto measurement = EngineBenchmark::Measurement(i);
+		const auto& latency = benchmark->histogram(engine, measurement);
+		if (latency.isEmpty())
+			continue;
+
+		qInfo("%s of %s: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, "
+		      "max %.3f ms (%lld samples)",
+		      qUtf8Printable(EngineBenchmark::measurementName(measurement)),
+		      qUtf8Printable(name),
+		      latency.percentile(50) / 1e6,
+		      latency.percentile(90) / 1e6,
+		      latency.percentile(99) / 1e6,
+		      latency.max() / 1e6,
+		      latency.count());
+	}
+
+	const auto errors = benchmark->errors(engine);
+	for (const QString& error : errors)
+		qWarning("%s: %s", qUtf8Printable(name), qUtf8Printable(error));
+}
+
+EngineBenchmark* parseEngineBenchmark(const QStringList& args, QObject* parent)
+{
+	MatchParser parser(args);
+	parser.addOption("-engine", QVariant::StringList, 1, -1, true);
+	parser.addOption("-each", QVariant::StringList, 1);
+	parser.addOption("-pings", QVariant::Int, 1, 1);
+	parser.addOption("-searches", QVariant::Int, 1, 1);
+	parser.addOption("-timeout", QVariant::Int, 1, 1);
+	if (!parser.parse())
+		return nullptr;
+
+	QScopedPointer<EngineBenchmark> benchmark(new EngineBenchmark(parent));
+	QList<EngineData> engines;
+	QStringList eachOptions;
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-engine")
+		{
+			EngineData engine;
+			engine.bookDepth = 0;
+			ok = parseEngine(value.toStringList(), engine);
+			if (ok)
+				engines.append(engine);
+		}
+		else if (name == "-each")
+			eachOptions = value.toStringList();
+		else if (name == "-pings")
+		{
+			ok = value.toInt() >= 0;
+			if (ok)
+				benchmark->setPingCount(value.toInt());
+		}
+		else if (name == "-searches")
+		{
+			ok = value.toInt() >= 0;
+			if (ok)
+				benchmark->setSearchCount(value.toInt());
+		}
+		else if (name == "-timeout")
+		{
+			ok = value.toInt() > 0;
+			if (ok)
+				benchmark->setTimeout(value.toInt());
+		}
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.type() == QVariant::StringList
+						? value.toStringList().join(' ')
+						: value.toString()));
+			return nullptr;
+		}
+	}
+
+	if (engines.isEmpty())
+	{
+		qWarning("enginebench needs an engine");
+		return nullptr;
+	}
+
+	for (auto& engine : engines)
+	{
+		if (!eachOptions.isEmpty() && !parseEngine(eachOptions, engine))
+			return nullptr;
+		if (engine.config.command().isEmpty()
+		&&  engine.config.library().isEmpty()
+		&&  engine.config.remote().isEmpty())
+		{
+			qCritical("missing chess engine command");
+			return nullptr;
+		}
+		if (engine.config.protocol().isEmpty())
+		{
+			qWarning("Missing chess protocol");
+			return nullptr;
+		}
+		benchmark->addEngine(engine.config);
+	}
+
+	// The engines are measured one at a time so they don't slow
+	// each other down
+	const EngineBenchmark* benchmarkPtr = benchmark.data();
+	QObject::connect(benchmarkPtr, &EngineBenchmark::engineFinished,
+			 benchmarkPtr, [=](int engine)
+	{
+		printBenchmarkResults(benchmarkPtr, engine);
+	});
+
+	return benchmark.take();
+}
+
+EngineRelay* parseRelay(const QStringList& args, QObject* parent)
+{
+	MatchParser parser(args);
+	parser.addOption("-engine", QVariant::StringList, 1, -1, true);
+	parser.addOption("-port", QVariant::Int, 1, 1, true);
+	parser.addOption("-host", QVariant::String, 1, 1);
+	if (!parser.parse())
+		return nullptr;
+
+	EngineData engine;
+	engine.bookDepth = 0;
+	QHostAddress address(QHostAddress::Any);
+	int port = 0;
+
+	const auto options = parser.options();
+	for (const auto& option : options)
+	{
+		bool ok = true;
+		const QString& name = option.name;
+		const QVariant& value = option.value;
+
+		if (name == "-engine")
+			ok = parseEngine(value.toStringList(), engine);
+		else if (name == "-port")
+		{
+			port = value.toInt(&ok);
+			ok = ok && port > 0 && port <= 0xffff;
+		}
+		else if (name == "-host")
+			ok = address.setAddress(value.toString());
+
+		if (!ok)
+		{
+			qWarning("Invalid value for option \"%s\": \"%s\"",
+				 qUtf8Printable(name),
+				 qUtf8Printable(value.type() == QVariant::StringList
+						? value.toStringList().join(' ')
+						: value.toString()));
+			return nullptr;
+		}
+	}
+
+	if (engine.config.command().isEmpty()
+	&&  engine.config.library().isEmpty())
+	{
+		qCritical("missing chess engine command");
+		return nullptr;
+	}
+	if (engine.config.name().isEmpty())
+		engine.config.setName(engine.config.command().isEmpty()
+				      ? engine.config.library()
+				      : engine.config.command());
+
+	QScopedPointer<EngineRelay> relay(new EngineRelay(engine.config, parent));
+	if (!relay->listen(address, quint16(port)))
+	{
+		qWarning("Cannot relay on port %d: %s", port,
+			 qUtf8Printable(relay->errorString()));
+		return nullptr;
+	}
+
+	qInfo("Relaying %s on port %d",
+	      qUtf8Printable(engine.config.name()), relay->serverPort());
+	return relay.take();
+}
+
+} // anonymous namespace
+
+MatchScheduler* parseJobs(const QString& fileName,
+			  const QStringList& commonArgs,
+			  QObject* parent)
+{
+	QFile file(fileName);
+	bool ok = fileName == "-" ? file.open(stdin, QIODevice::ReadOnly)
+				  : file.open(QIODevice::ReadOnly);
+	if (!ok)
+	{
+		qWarning("Can't open job file %s", qUtf8Printable(fileName));
+		return nullptr;
+	}
+
+	QJsonParseError error;
+	QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+	if (!doc.isArray() || doc.array().isEmpty())
+	{
+		qWarning("Invalid job file %s: %s",
+			 qUtf8Printable(fileName),
+			 error.error != QJsonParseError::NoError
+			 ? qUtf8Printable(error.errorString())
+			 : "expected a non-empty array of jobs");
+		return nullptr;
+	}
+
+	GameManager* manager = CuteChessCoreApplication::instance()->gameManager();
+	MatchScheduler* scheduler = new MatchScheduler(manager, parent);
+
+	const QJsonArray jobs = doc.array();
+	for (int i = 0; i < jobs.size(); i++)
+	{
+		// Each job is an array of command line arguments that
+		// are appended to the arguments shared by all jobs
+		QStringList args = commonArgs;
+		const QJsonArray jobArgs = jobs.at(i).toArray();
+		for (const QJsonValue& arg : jobArgs)
+			args << arg.toString();
+
+		EngineMatch* match = jobArgs.isEmpty() ? nullptr
+						       : parseMatch(args, scheduler);
+		if (match == nullptr)
+		{
+			qWarning("Invalid job %d in %s", i + 1,
+				 qUtf8Printable(fileName));
+			delete scheduler;
+			return nullptr;
+		}
+		scheduler->addMatch(match);
+	}
+
+	return scheduler;
+}
+
+int main(int argc, char* argv[])
+{
+	// Register types for signal / slot connections
+	qRegisterMetaType<Chess::Result>("Chess::Result");
+
+	setvbuf(stdout, nullptr, _IONBF, 0);
+	signal(SIGINT, sigintHandler);
+
+	// The bench command runs copies of cutechess-cli as its engines
+	if (argc == 3 && qstrcmp(argv[1], "bench-engine") == 0)
+		return MockEngine().run(argv[2]);
+
+	CuteChessCoreApplication app(argc, argv);
+
+	QStringList arguments = CuteChessCoreApplication::arguments();
+	arguments.takeFirst(); // application name
+
+	// Enabled before parsing so that the parsing is measured too
+	if (arguments.contains("-profile-startup"))
+		StartupProfile::setEnabled(true);
+
+	// Use trivial command-line parsing for now
+	QTextStream out(stdout);
+	const auto& constArguments = arguments;
+	for (const auto& arg : constArguments)
+	{
+		if (arg == "-v" || arg == "--version" || arg == "-version")
+		{
+			out << "cutechess-cli " << CUTECHESS_CLI_VERSION << endl;
+			out << "Using Qt version " << qVersion() << endl << endl;
+			out << "Copyright (C) 2008-2018 Ilari Pihlajisto and Arto Jonsson" << endl;
+			out << "This is free software; see the source for copying ";
+			out << "conditions.  There is NO" << endl << "warranty; not even for ";
+			out << "MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.";
+			out << endl << endl;
+
+			return 0;
+		}
+		else if (arg == "--engines" || arg == "-engines")
 		{
 			const auto engines = app.engineManager()->engines();
 			for (const auto& engine : engines)
@@ -719,6 +2681,78 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	if (!arguments.isEmpty() && arguments.first() == "makebook")
+		return makeBook(arguments.mid(1)) ? 0 : 1;
+	if (!arguments.isEmpty() && arguments.first() == "makeepd")
+		return makeEpd(arguments.mid(1)) ? 0 : 1;
+	if (!arguments.isEmpty() && arguments.first() == "perft")
+		return runPerft(arguments.mid(1)) ? 0 : 1;
+	if (!arguments.isEmpty() && arguments.first() == "sprtsim")
+		return simulateSprt(arguments.mid(1)) ? 0 : 1;
+	if (!arguments.isEmpty() && arguments.first() == "bench")
+		return runBench(arguments.mid(1)) ? 0 : 1;
+	if (!arguments.isEmpty() && arguments.first() == "pgnfilter")
+		return filterPgn(arguments.mid(1)) ? 0 : 1;
+	if (!arguments.isEmpty() && arguments.first() == "pgncheck")
+		return checkPgn(arguments.mid(1)) ? 0 : 1;
+	if (!arguments.isEmpty() && arguments.first() == "pgnmerge")
+		return mergePgn(arguments.mid(1)) ? 0 : 1;
+	if (!arguments.isEmpty() && arguments.first() == "replay")
+		return replayAdjudication(arguments.mid(1)) ? 0 : 1;
+	if (!arguments.isEmpty()
+	&&  (arguments.first() == "epdtest" || arguments.first() == "analyze"))
+	{
+		if (arguments.first() == "epdtest")
+			s_searcher = parseEpdTest(arguments.mid(1), &app);
+		else
+			s_searcher = parseAnalysis(arguments.mid(1), &app);
+		if (s_searcher == nullptr)
+			return 1;
+		QObject::connect(s_searcher, SIGNAL(finished()), &app, SLOT(quit()));
+
+		s_searcher->start();
+		return app.exec();
+	}
+	if (!arguments.isEmpty() && arguments.first() == "relay")
+	{
+		s_relay = parseRelay(arguments.mid(1), &app);
+		if (s_relay == nullptr)
+			return 1;
+		QObject::connect(s_relay, SIGNAL(finished()), &app, SLOT(quit()));
+
+		return app.exec();
+	}
+	if (!arguments.isEmpty() && arguments.first() == "enginebench")
+	{
+		s_benchmark = parseEngineBenchmark(arguments.mid(1), &app);
+		if (s_benchmark == nullptr)
+			return 1;
+		QObject::connect(s_benchmark, SIGNAL(finished()), &app, SLOT(quit()));
+
+		s_benchmark->start();
+		return app.exec();
+	}
+
+	int jobsIndex = arguments.indexOf("-jobs");
+	if (jobsIndex != -1)
+	{
+		if (jobsIndex + 1 >= arguments.size())
+		{
+			qWarning("Missing job file");
+			return 1;
+		}
+		QString fileName = arguments.takeAt(jobsIndex + 1);
+		arguments.removeAt(jobsIndex);
+
+		s_scheduler = parseJobs(fileName, arguments, &app);
+		if (s_scheduler == nullptr)
+			return 1;
+		QObject::connect(s_scheduler, SIGNAL(finished()), &app, SLOT(quit()));
+
+		s_scheduler->start();
+		return app.exec();
+	}
+
 	s_match = parseMatch(arguments, &app);
 	if (s_match == nullptr)
 		return 1;
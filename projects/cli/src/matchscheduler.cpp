@@ -0,0 +1,112 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "matchscheduler.h"
+#include <algorithm>
+#include <tournament.h>
+#include <gamemanager.h>
+#include "enginematch.h"
+
+MatchScheduler::MatchScheduler(GameManager* manager, QObject* parent)
+	: QObject(parent),
+	  m_manager(manager),
+	  m_next(0)
+{
+	Q_ASSERT(manager != nullptr);
+}
+
+void MatchScheduler::addMatch(EngineMatch* match)
+{
+	Q_ASSERT(match != nullptr);
+	Q_ASSERT(match->tournament()->gameManager() == m_manager);
+
+	match->setSharedGameManager(true);
+	match->tournament()->setExternalScheduling(true);
+	connect(match, SIGNAL(finished()), this, SLOT(onMatchFinished()));
+	m_matches << match;
+}
+
+void MatchScheduler::start()
+{
+	for (EngineMatch* match : qAsConst(m_matches))
+		match->start();
+
+	// The tournaments are started with queued calls, so this
+	// runs after all of them have started their first game
+	QMetaObject::invokeMethod(this, "onStarted", Qt::QueuedConnection);
+}
+
+void MatchScheduler::stop()
+{
+	for (EngineMatch* match : qAsConst(m_matches))
+		match->stop();
+}
+
+void MatchScheduler::onStarted()
+{
+	connect(m_manager, SIGNAL(ready()), this, SLOT(onManagerReady()));
+
+	// Filling one slot makes the manager ask for the rest
+	onManagerReady();
+}
+
+void MatchScheduler::onManagerReady()
+{
+	const int count = m_matches.size();
+	if (count == 0)
+		return;
+
+	// Offer the slot to the matches with the fewest running games
+	// first. Ties are broken round-robin.
+	QList<int> order;
+	for (int i = 0; i < count; i++)
+		order << (m_next + i) % count;
+	std::stable_sort(order.begin(), order.end(), [=](int a, int b)
+	{
+		return m_matches.at(a)->tournament()->activeGameCount()
+		     < m_matches.at(b)->tournament()->activeGameCount();
+	});
+
+	for (int i : qAsConst(order))
+	{
+		Tournament* tournament = m_matches.at(i)->tournament();
+		const int activeGames = tournament->activeGameCount();
+
+		tournament->startNextGame();
+		if (tournament->activeGameCount() > activeGames)
+		{
+			m_next = (i + 1) % count;
+			return;
+		}
+	}
+}
+
+void MatchScheduler::onMatchFinished()
+{
+	EngineMatch* match = qobject_cast<EngineMatch*>(sender());
+	Q_ASSERT(match != nullptr);
+
+	m_matches.removeOne(match);
+	m_next = 0;
+	if (!m_matches.isEmpty())
+		return;
+
+	disconnect(m_manager, SIGNAL(ready()), this, SLOT(onManagerReady()));
+	connect(m_manager, SIGNAL(finished()), this, SIGNAL(finished()));
+	m_manager->finish();
+}
@@ -0,0 +1,60 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MATCHSCHEDULER_H
+#define MATCHSCHEDULER_H
+
+#include <QObject>
+#include <QList>
+
+class EngineMatch;
+class GameManager;
+
+
+/*
+ * Runs several matches in one process. The matches share the game
+ * slots of one GameManager: a free slot goes to the match with the
+ * fewest running games.
+ */
+class MatchScheduler : public QObject
+{
+	Q_OBJECT
+
+	public:
+		MatchScheduler(GameManager* manager, QObject* parent = nullptr);
+
+		void addMatch(EngineMatch* match);
+
+		void start();
+		void stop();
+
+	signals:
+		void finished();
+
+	private slots:
+		void onStarted();
+		void onManagerReady();
+		void onMatchFinished();
+
+	private:
+		GameManager* m_manager;
+		QList<EngineMatch*> m_matches;
+		int m_next;
+};
+
+#endif // MATCHSCHEDULER_H
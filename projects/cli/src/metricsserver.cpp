@@ -0,0 +1,151 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "metricsserver.h"
+#include <QTcpSocket>
+#include <latencyhistogram.h>
+
+MetricsServer::MetricsServer(QObject* parent)
+	: QObject(parent)
+{
+	connect(&m_server, SIGNAL(newConnection()),
+		this, SLOT(onNewConnection()));
+}
+
+void MetricsServer::setExporter(const Exporter& exporter)
+{
+	m_exporter = exporter;
+}
+
+bool MetricsServer::listen(quint16 port)
+{
+	if (!m_server.listen(QHostAddress::Any, port))
+	{
+		qWarning("Cannot serve metrics on port %d: %s", port,
+			 qUtf8Printable(m_server.errorString()));
+		return false;
+	}
+
+	qInfo("Serving metrics on port %d", m_server.serverPort());
+	return true;
+}
+
+void MetricsServer::onNewConnection()
+{
+	while (m_server.hasPendingConnections())
+	{
+		QTcpSocket* socket = m_server.nextPendingConnection();
+		connect(socket, SIGNAL(readyRead()),
+			this, SLOT(onReadyRead()));
+		connect(socket, SIGNAL(disconnected()),
+			socket, SLOT(deleteLater()));
+	}
+}
+
+void MetricsServer::onReadyRead()
+{
+	auto socket = qobject_cast<QTcpSocket*>(sender());
+	Q_ASSERT(socket != nullptr);
+
+	// Only the request line matters, the headers are ignored
+	if (!socket->canReadLine())
+	{
+		if (socket->bytesAvailable() > 8192)
+			socket->abort();
+		return;
+	}
+	const QList<QByteArray> request(socket->readLine().simplified().split(' '));
+	disconnect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+
+	QByteArray status("200 OK");
+	QByteArray body;
+	if (request.size() < 2 || request.at(0) != "GET")
+	{
+		status = "405 Method Not Allowed";
+		body = "Only GET is supported\n";
+	}
+	else if (request.at(1) != "/metrics" && request.at(1) != "/")
+	{
+		status = "404 Not Found";
+		body = "The metrics are at /metrics\n";
+	}
+	else if (m_exporter)
+		body = m_exporter();
+
+	QByteArray response("HTTP/1.0 " + status + "\r\n");
+	response += "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+	response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+	response += "Connection: close\r\n\r\n";
+	response += body;
+	socket->write(response);
+	socket->disconnectFromHost();
+}
+
+void MetricsServer::writeHeader(QByteArray& out,
+				const char* name,
+				const char* type,
+				const char* help)
+{
+	out += "# HELP ";
+	out += name;
+	out += ' ';
+	out += help;
+	out += "\n# TYPE ";
+	out += name;
+	out += ' ';
+	out += type;
+	out += '\n';
+}
+
+void MetricsServer::writeSample(QByteArray& out,
+				const char* name,
+				double value,
+				const QString& labels)
+{
+	out += name;
+	if (!labels.isEmpty())
+		out += '{' + labels.toUtf8() + '}';
+	out += ' ';
+	out += QByteArray::number(value, 'g', 15);
+	out += '\n';
+}
+
+QString MetricsServer::label(const char* name, const QString& value)
+{
+	QString escaped(value);
+	escaped.replace('\\', "\\\\");
+	escaped.replace('"', "\\\"");
+	escaped.replace('\n', "\\n");
+	return QString("%1=\"%2\"").arg(name, escaped);
+}
+
+void MetricsServer::writeSummary(QByteArray& out,
+				 const char* name,
+				 const LatencyHistogram& latency,
+				 const QString& labels)
+{
+	const QString prefix(labels.isEmpty() ? QString() : labels + ',');
+	const double quantiles[] = { 0.5, 0.9, 0.99 };
+	for (double q : quantiles)
+		writeSample(out, name, latency.percentile(q * 100) / 1e9,
+			    prefix + label("quantile", QString::number(q)));
+
+	const QByteArray base(name);
+	writeSample(out, (base + "_sum").constData(), latency.sum() / 1e9, labels);
+	writeSample(out, (base + "_count").constData(), double(latency.count()), labels);
+}
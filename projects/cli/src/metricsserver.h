@@ -0,0 +1,78 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QTcpServer>
+#include <functional>
+
+class LatencyHistogram;
+
+
+/*
+ * Serves live metrics over HTTP in the Prometheus text exposition
+ * format. Every request is answered with the output of the exporter
+ * function, which is called only when a scraper asks for the metrics,
+ * so the server costs nothing between scrapes. The connection is
+ * closed after each response.
+ *
+ * The static helpers format metric families for exporters.
+ */
+class MetricsServer : public QObject
+{
+	Q_OBJECT
+
+	public:
+		typedef std::function<QByteArray()> Exporter;
+
+		explicit MetricsServer(QObject* parent = nullptr);
+
+		void setExporter(const Exporter& exporter);
+		bool listen(quint16 port);
+
+		// Adds the HELP and TYPE lines of metric family \a name
+		static void writeHeader(QByteArray& out,
+					const char* name,
+					const char* type,
+					const char* help);
+		// Adds a sample; \a labels is empty or in the form a="b",c="d"
+		static void writeSample(QByteArray& out,
+					const char* name,
+					double value,
+					const QString& labels = QString());
+		// Returns the label \a name with an escaped \a value
+		static QString label(const char* name, const QString& value);
+		// Adds the quantiles, sum and count of a summary in seconds
+		static void writeSummary(QByteArray& out,
+					 const char* name,
+					 const LatencyHistogram& latency,
+					 const QString& labels);
+
+	private slots:
+		void onNewConnection();
+		void onReadyRead();
+
+	private:
+		QTcpServer m_server;
+		Exporter m_exporter;
+};
+
+#endif // METRICSSERVER_H
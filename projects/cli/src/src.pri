@@ -1,8 +1,22 @@
 DEPENDPATH += $$PWD
 HEADERS += $$PWD/enginematch.h \
+    $$PWD/benchworkload.h \
     $$PWD/cutechesscoreapp.h \
-    $$PWD/matchparser.h
+    $$PWD/eventstream.h \
+    $$PWD/matchparser.h \
+    $$PWD/matchscheduler.h \
+    $$PWD/metricsserver.h \
+    $$PWD/startupprofile.h \
+    $$PWD/tournamentcoordinator.h \
+    $$PWD/tournamentworker.h
 SOURCES += $$PWD/main.cpp \
+    $$PWD/benchworkload.cpp \
     $$PWD/cutechesscoreapp.cpp \
     $$PWD/enginematch.cpp \
-    $$PWD/matchparser.cpp
+    $$PWD/eventstream.cpp \
+    $$PWD/matchparser.cpp \
+    $$PWD/matchscheduler.cpp \
+    $$PWD/metricsserver.cpp \
+    $$PWD/startupprofile.cpp \
+    $$PWD/tournamentcoordinator.cpp \
+    $$PWD/tournamentworker.cpp
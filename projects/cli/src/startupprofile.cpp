@@ -0,0 +1,99 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "startupprofile.h"
+#include <QVector>
+
+namespace {
+
+struct Phase
+{
+	const char* name;
+	qint64 nsecs;
+	int count;
+};
+
+bool s_enabled = false;
+bool s_printed = false;
+QElapsedTimer s_clock;
+QVector<Phase> s_phases;
+
+} // anonymous namespace
+
+StartupProfile::Timer::Timer(const char* phase)
+	: m_phase(phase)
+{
+	if (s_enabled)
+		m_timer.start();
+}
+
+StartupProfile::Timer::~Timer()
+{
+	if (m_timer.isValid())
+		add(m_phase, m_timer.nsecsElapsed());
+}
+
+void StartupProfile::setEnabled(bool enabled)
+{
+	s_enabled = enabled;
+	if (enabled)
+		s_clock.start();
+}
+
+bool StartupProfile::isEnabled()
+{
+	return s_enabled;
+}
+
+void StartupProfile::add(const char* phase, qint64 nsecs)
+{
+	if (!s_enabled || s_printed)
+		return;
+
+	for (Phase& p : s_phases)
+	{
+		if (qstrcmp(p.name, phase) == 0)
+		{
+			p.nsecs += nsecs;
+			p.count++;
+			return;
+		}
+	}
+
+	Phase p = { phase, nsecs, 1 };
+	s_phases.append(p);
+}
+
+void StartupProfile::print()
+{
+	if (!s_enabled || s_printed)
+		return;
+	s_printed = true;
+
+	qInfo("Startup profile:");
+	for (const Phase& p : qAsConst(s_phases))
+	{
+		if (p.count > 1)
+			qInfo("  %-36s %9.1f ms (%d times)",
+			      p.name, p.nsecs / 1000000.0, p.count);
+		else
+			qInfo("  %-36s %9.1f ms", p.name, p.nsecs / 1000000.0);
+	}
+	qInfo("  %-36s %9.1f ms", "Total until the first game",
+	      s_clock.nsecsElapsed() / 1000000.0);
+}
@@ -0,0 +1,54 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+#include <QElapsedTimer>
+
+
+/*
+ * Measures the wall time of cutechess-cli's start-up phases for the
+ * -profile-startup option. A phase that runs many times, eg. once per
+ * engine, is reported with its total time. Nothing is measured unless
+ * profiling is enabled.
+ */
+class StartupProfile
+{
+	public:
+		// Adds the time spent in the enclosing scope to a phase
+		class Timer
+		{
+			public:
+				explicit Timer(const char* phase);
+				~Timer();
+
+			private:
+				const char* m_phase;
+				QElapsedTimer m_timer;
+		};
+
+		static void setEnabled(bool enabled);
+		static bool isEnabled();
+
+		static void add(const char* phase, qint64 nsecs);
+		// Prints the phases in the order they first ran, only once
+		static void print();
+};
+
+#endif // STARTUPPROFILE_H
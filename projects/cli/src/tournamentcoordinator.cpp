@@ -0,0 +1,289 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tournamentcoordinator.h"
+#include <QTcpSocket>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <tournament.h>
+#include <pgngame.h>
+#include <pgnstream.h>
+#include <board/result.h>
+
+namespace {
+
+Chess::Result resultFromMessage(const QJsonObject& message)
+{
+	auto type = Chess::Result::Type(message["resultType"].toInt());
+	Chess::Side winner(message["winner"].toString());
+	QString description(message["description"].toString());
+
+	// Result::description() puts a preset text in front of the
+	// description of most result types
+	const QString preset(Chess::Result(type, winner).description());
+	if (description == preset)
+		description.clear();
+	else if (description.startsWith(preset + ": "))
+		description.remove(0, preset.size() + 2);
+
+	return Chess::Result(type, winner, description);
+}
+
+} // anonymous namespace
+
+TournamentCoordinator::Worker::Worker()
+	: slotCount(0)
+{
+}
+
+TournamentCoordinator::TournamentCoordinator(Tournament* tournament,
+					     QObject* parent)
+	: QObject(parent),
+	  m_tournament(tournament),
+	  m_started(false)
+{
+	Q_ASSERT(tournament != nullptr);
+
+	m_tournament->setRemoteGames(true);
+	m_tournament->setExternalScheduling(true);
+
+	connect(m_tournament, SIGNAL(gameDispatched(int, int, int, QString, QStringList)),
+		this, SLOT(onGameDispatched(int, int, int, QString, QStringList)));
+	connect(m_tournament, SIGNAL(finished()),
+		this, SLOT(onTournamentFinished()));
+	connect(&m_server, SIGNAL(newConnection()),
+		this, SLOT(onNewConnection()));
+}
+
+bool TournamentCoordinator::listen(quint16 port)
+{
+	if (!m_server.listen(QHostAddress::Any, port))
+	{
+		qWarning("Cannot listen on port %d: %s", port,
+			 qUtf8Printable(m_server.errorString()));
+		return false;
+	}
+
+	qInfo("Waiting for workers on port %d", m_server.serverPort());
+	return true;
+}
+
+void TournamentCoordinator::start()
+{
+	m_started = true;
+	assignGames();
+}
+
+void TournamentCoordinator::onNewConnection()
+{
+	while (m_server.hasPendingConnections())
+	{
+		QTcpSocket* socket = m_server.nextPendingConnection();
+		connect(socket, SIGNAL(readyRead()),
+			this, SLOT(onReadyRead()));
+		connect(socket, SIGNAL(disconnected()),
+			this, SLOT(onDisconnected()));
+		m_workers[socket].address = socket->peerAddress().toString();
+	}
+}
+
+void TournamentCoordinator::onReadyRead()
+{
+	auto socket = qobject_cast<QTcpSocket*>(sender());
+	Q_ASSERT(socket != nullptr);
+
+	while (socket->canReadLine() && m_workers.contains(socket))
+	{
+		QJsonParseError error;
+		auto doc = QJsonDocument::fromJson(socket->readLine(), &error);
+		if (!doc.isObject())
+		{
+			qWarning("Invalid message from worker %s: %s",
+				 qUtf8Printable(m_workers[socket].address),
+				 qUtf8Printable(error.errorString()));
+			socket->abort();
+			return;
+		}
+		processMessage(socket, doc.object());
+	}
+}
+
+void TournamentCoordinator::processMessage(QTcpSocket* socket,
+					   const QJsonObject& message)
+{
+	const QString type(message["type"].toString());
+	Worker& worker = m_workers[socket];
+
+	if (type == "hello")
+	{
+		const int players = message["players"].toArray().size();
+		if (players != m_tournament->playerCount())
+		{
+			qWarning("Worker %s has %d players instead of %d",
+				 qUtf8Printable(worker.address), players,
+				 m_tournament->playerCount());
+			socket->abort();
+			return;
+		}
+
+		worker.slotCount = qMax(1, message["slots"].toInt());
+		qInfo("Worker %s joined with %d game slots",
+		      qUtf8Printable(worker.address), worker.slotCount);
+		assignGames();
+	}
+	else if (type == "result")
+	{
+		finishGame(socket, message);
+		assignGames();
+	}
+}
+
+void TournamentCoordinator::finishGame(QTcpSocket* socket,
+				       const QJsonObject& message)
+{
+	Worker& worker = m_workers[socket];
+	const int number = message["number"].toInt();
+	if (!worker.games.remove(number))
+		return;
+	const QJsonObject spec(m_games.take(number));
+
+	const int white = spec["white"].toInt();
+	const int black = spec["black"].toInt();
+	const QString pgnText(message["pgn"].toString());
+
+	PgnGame pgn;
+	bool ok = false;
+	if (!pgnText.isEmpty())
+	{
+		const QByteArray data(pgnText.toUtf8());
+		PgnStream in(&data, m_tournament->variant());
+		ok = pgn.read(in);
+		if (!ok)
+			qWarning("Invalid PGN of game %d from worker %s",
+				 number, qUtf8Printable(worker.address));
+	}
+
+	// Without the PGN the game is recorded with its tags only
+	if (!ok)
+	{
+		pgn = PgnGame();
+		pgn.setVariant(m_tournament->variant());
+		pgn.setEvent(m_tournament->name());
+		pgn.setSite(m_tournament->site());
+		pgn.setRound(spec["round"].toInt());
+		pgn.setPlayerName(Chess::Side::White,
+				  m_tournament->playerAt(white).name());
+		pgn.setPlayerName(Chess::Side::Black,
+				  m_tournament->playerAt(black).name());
+		const QString fen(spec["fen"].toString());
+		if (!fen.isEmpty())
+			pgn.setStartingFenString(Chess::Side(fen.section(' ', 1, 1)),
+						 fen);
+	}
+	pgn.setResult(resultFromMessage(message));
+
+	m_tournament->finishRemoteGame(number, &pgn);
+}
+
+void TournamentCoordinator::onDisconnected()
+{
+	auto socket = qobject_cast<QTcpSocket*>(sender());
+	Q_ASSERT(socket != nullptr);
+
+	// The games of a lost worker are given to the others
+	const Worker worker(m_workers.take(socket));
+	for (int number : worker.games)
+	{
+		if (m_games.contains(number))
+			m_pending.prepend(number);
+	}
+	if (worker.slotCount > 0)
+		qInfo("Worker %s left, %d games reassigned",
+		      qUtf8Printable(worker.address), worker.games.size());
+
+	socket->deleteLater();
+	assignGames();
+}
+
+void TournamentCoordinator::onGameDispatched(int number,
+					     int whiteIndex,
+					     int blackIndex,
+					     const QString& startingFen,
+					     const QStringList& moves)
+{
+	QJsonObject spec;
+	spec["type"] = "game";
+	spec["number"] = number;
+	spec["round"] = m_tournament->currentRound();
+	spec["white"] = whiteIndex;
+	spec["black"] = blackIndex;
+	spec["fen"] = startingFen;
+	spec["moves"] = QJsonArray::fromStringList(moves);
+
+	m_games[number] = spec;
+	m_pending.append(number);
+}
+
+void TournamentCoordinator::assignGames()
+{
+	if (!m_started || m_tournament->isFinished())
+		return;
+
+	for (auto it = m_workers.begin(); it != m_workers.end(); ++it)
+	{
+		Worker& worker = it.value();
+		QByteArray batch;
+
+		while (worker.games.size() < worker.slotCount)
+		{
+			if (m_pending.isEmpty())
+				m_tournament->startNextGame();
+			if (m_pending.isEmpty())
+				break;
+
+			const int number = m_pending.takeFirst();
+			worker.games.insert(number);
+			batch += QJsonDocument(m_games[number])
+				 .toJson(QJsonDocument::Compact);
+			batch += '\n';
+		}
+
+		if (!batch.isEmpty())
+			it.key()->write(batch);
+	}
+}
+
+void TournamentCoordinator::onTournamentFinished()
+{
+	m_server.close();
+
+	QJsonObject quit;
+	quit["type"] = "quit";
+	const QByteArray line(QJsonDocument(quit).toJson(QJsonDocument::Compact) + '\n');
+
+	const auto sockets = m_workers.keys();
+	for (QTcpSocket* socket : sockets)
+	{
+		disconnect(socket, nullptr, this, nullptr);
+		socket->write(line);
+		socket->disconnectFromHost();
+	}
+	m_workers.clear();
+	m_games.clear();
+	m_pending.clear();
+}
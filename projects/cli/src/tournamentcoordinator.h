@@ -0,0 +1,87 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TOURNAMENTCOORDINATOR_H
+#define TOURNAMENTCOORDINATOR_H
+
+#include <QObject>
+#include <QMap>
+#include <QSet>
+#include <QList>
+#include <QJsonObject>
+#include <QTcpServer>
+
+class QTcpSocket;
+class Tournament;
+
+
+/*
+ * Hands the games of a tournament to remote workers (see
+ * TournamentWorker) over TCP. The tournament keeps doing the pairing,
+ * the openings and the scoring, so SPRT and the other stopping
+ * criteria work across all workers.
+ *
+ * The messages are JSON objects, one per line.
+ */
+class TournamentCoordinator : public QObject
+{
+	Q_OBJECT
+
+	public:
+		TournamentCoordinator(Tournament* tournament,
+				      QObject* parent = nullptr);
+
+		bool listen(quint16 port);
+
+	public slots:
+		void start();
+
+	private slots:
+		void onNewConnection();
+		void onReadyRead();
+		void onDisconnected();
+		void onGameDispatched(int number,
+				      int whiteIndex,
+				      int blackIndex,
+				      const QString& startingFen,
+				      const QStringList& moves);
+		void onTournamentFinished();
+
+	private:
+		struct Worker
+		{
+			Worker();
+
+			QString address;
+			int slotCount;
+			QSet<int> games;
+		};
+
+		void processMessage(QTcpSocket* socket, const QJsonObject& message);
+		void finishGame(QTcpSocket* socket, const QJsonObject& message);
+		void assignGames();
+
+		Tournament* m_tournament;
+		QTcpServer m_server;
+		bool m_started;
+		QMap<QTcpSocket*, Worker> m_workers;
+		QMap<int, QJsonObject> m_games;
+		QList<int> m_pending;
+};
+
+#endif // TOURNAMENTCOORDINATOR_H
@@ -0,0 +1,292 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tournamentworker.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <tournament.h>
+#include <gamemanager.h>
+#include <chessgame.h>
+#include <chessplayer.h>
+#include <pgngame.h>
+#include <board/board.h>
+#include <board/boardfactory.h>
+
+TournamentWorker::TournamentWorker(Tournament* tournament, QObject* parent)
+	: QObject(parent),
+	  m_tournament(tournament),
+	  m_port(0),
+	  m_pgnEnabled(true),
+	  m_stopping(false)
+{
+	Q_ASSERT(tournament != nullptr);
+
+	connect(&m_socket, SIGNAL(connected()),
+		this, SLOT(onConnected()));
+	connect(&m_socket, SIGNAL(readyRead()),
+		this, SLOT(onReadyRead()));
+	connect(&m_socket, SIGNAL(disconnected()),
+		this, SLOT(stop()));
+	connect(&m_socket, SIGNAL(error(QAbstractSocket::SocketError)),
+		this, SLOT(onError()));
+}
+
+void TournamentWorker::setCoordinator(const QString& host, quint16 port)
+{
+	m_host = host;
+	m_port = port;
+}
+
+void TournamentWorker::setPgnEnabled(bool enabled)
+{
+	m_pgnEnabled = enabled;
+}
+
+void TournamentWorker::setPgnOutput(const QString& fileName)
+{
+	m_pgnFile.setFileName(fileName);
+}
+
+void TournamentWorker::start()
+{
+	m_socket.connectToHost(m_host, m_port);
+}
+
+void TournamentWorker::stop()
+{
+	if (m_stopping)
+		return;
+	m_stopping = true;
+
+	if (m_games.isEmpty())
+	{
+		finish();
+		return;
+	}
+
+	const auto games = m_games.keys();
+	for (ChessGame* game : games)
+		QMetaObject::invokeMethod(game, "stop", Qt::QueuedConnection);
+}
+
+void TournamentWorker::onConnected()
+{
+	qInfo("Connected to coordinator %s:%d", qUtf8Printable(m_host), m_port);
+
+	QJsonArray players;
+	for (int i = 0; i < m_tournament->playerCount(); i++)
+		players.append(m_tournament->playerAt(i).name());
+
+	QJsonObject hello;
+	hello["type"] = "hello";
+	hello["slots"] = m_tournament->gameManager()->concurrency();
+	hello["players"] = players;
+	send(hello);
+}
+
+void TournamentWorker::onReadyRead()
+{
+	while (m_socket.canReadLine() && !m_stopping)
+	{
+		auto doc = QJsonDocument::fromJson(m_socket.readLine());
+		const QJsonObject message(doc.object());
+		const QString type(message["type"].toString());
+
+		if (type == "game")
+		{
+			if (!startGame(message))
+			{
+				qWarning("Invalid game from coordinator");
+				stop();
+			}
+		}
+		else if (type == "quit")
+			stop();
+	}
+}
+
+void TournamentWorker::onError()
+{
+	qWarning("Coordinator connection: %s",
+		 qUtf8Printable(m_socket.errorString()));
+
+	// A failed connection attempt doesn't emit disconnected()
+	if (m_socket.state() == QAbstractSocket::UnconnectedState)
+		stop();
+}
+
+bool TournamentWorker::startGame(const QJsonObject& spec)
+{
+	const int white = spec["white"].toInt(-1);
+	const int black = spec["black"].toInt(-1);
+	const int count = m_tournament->playerCount();
+	if (white < 0 || white >= count || black < 0 || black >= count)
+		return false;
+
+	const TournamentPlayer& whitePlayer = m_tournament->playerAt(white);
+	const TournamentPlayer& blackPlayer = m_tournament->playerAt(black);
+
+	Chess::Board* board = Chess::BoardFactory::create(m_tournament->variant());
+	Q_ASSERT(board != nullptr);
+	ChessGame* game = new ChessGame(board, new PgnGame());
+
+	// The opening is read on the game's board, which is set
+	// up again when the game starts
+	const QString fen(spec["fen"].toString());
+	bool ok = board->setFenString(fen.isEmpty() ? board->defaultFenString() : fen);
+	QVector<Chess::Move> moves;
+	const QJsonArray moveList(spec["moves"].toArray());
+	for (int i = 0; ok && i < moveList.size(); i++)
+	{
+		Chess::Move move(board->moveFromString(moveList.at(i).toString()));
+		ok = !move.isNull();
+		if (ok)
+		{
+			board->makeMove(move);
+			moves.append(move);
+		}
+	}
+	if (!ok)
+	{
+		delete game->pgn();
+		delete game;
+		return false;
+	}
+
+	game->setStartingFen(fen);
+	game->setMoves(moves);
+	game->setTimeControl(whitePlayer.timeControl(), Chess::Side::White);
+	game->setTimeControl(blackPlayer.timeControl(), Chess::Side::Black);
+	game->setOpeningBook(whitePlayer.book(), Chess::Side::White,
+			     whitePlayer.bookDepth());
+	game->setOpeningBook(blackPlayer.book(), Chess::Side::Black,
+			     blackPlayer.bookDepth());
+	game->setAdjudicator(m_tournament->adjudicator());
+
+	game->pgn()->setEvent(m_tournament->name());
+	game->pgn()->setSite(m_tournament->site());
+	game->pgn()->setRound(spec["round"].toInt());
+
+	connect(game, SIGNAL(finished(ChessGame*)),
+		this, SLOT(onGameFinished(ChessGame*)));
+	connect(game, SIGNAL(startFailed(ChessGame*)),
+		this, SLOT(onGameStartFailed(ChessGame*)));
+
+	m_games[game] = spec["number"].toInt();
+	m_tournament->gameManager()->newGame(game,
+					     whitePlayer.builder(),
+					     blackPlayer.builder(),
+					     GameManager::Enqueue,
+					     GameManager::ReusePlayers);
+	return true;
+}
+
+void TournamentWorker::onGameFinished(ChessGame* game)
+{
+	Q_ASSERT(m_games.contains(game));
+	const int number = m_games.take(game);
+	const Chess::Result result(game->result());
+
+	qInfo("Finished game %d (%s vs %s): %s",
+	      number,
+	      qUtf8Printable(game->player(Chess::Side::White)->name()),
+	      qUtf8Printable(game->player(Chess::Side::Black)->name()),
+	      qUtf8Printable(result.toVerboseString()));
+
+	// The coordinator drops the results of stopped games anyway
+	if (!m_stopping)
+	{
+		QJsonObject message;
+		message["type"] = "result";
+		message["number"] = number;
+		message["result"] = result.toShortString();
+		message["resultType"] = int(result.type());
+		message["winner"] = result.winner().symbol();
+		message["description"] = result.description();
+		if (m_pgnEnabled)
+		{
+			QByteArray pgn;
+			game->pgn()->write(&pgn);
+			message["pgn"] = QString::fromUtf8(pgn);
+		}
+		send(message);
+		savePgn(game->pgn(), number);
+	}
+
+	delete game->pgn();
+	game->deleteLater();
+
+	if (m_stopping && m_games.isEmpty())
+		finish();
+}
+
+void TournamentWorker::onGameStartFailed(ChessGame* game)
+{
+	qWarning("%s", qUtf8Printable(game->errorString()));
+
+	m_games.remove(game);
+	delete game->pgn();
+	game->deleteLater();
+
+	// The coordinator gives the games of a lost worker to others
+	if (!m_stopping)
+		stop();
+	else if (m_games.isEmpty())
+		finish();
+}
+
+void TournamentWorker::send(const QJsonObject& message)
+{
+	if (m_socket.state() != QAbstractSocket::ConnectedState)
+		return;
+
+	m_socket.write(QJsonDocument(message).toJson(QJsonDocument::Compact));
+	m_socket.write("\n");
+}
+
+void TournamentWorker::savePgn(PgnGame* pgn, int number)
+{
+	if (m_pgnFile.fileName().isEmpty())
+		return;
+
+	if (!m_pgnFile.isOpen())
+	{
+		if (!m_pgnFile.open(QIODevice::WriteOnly | QIODevice::Append))
+		{
+			qWarning("Could not open PGN file %s",
+				 qUtf8Printable(m_pgnFile.fileName()));
+			return;
+		}
+		m_pgnWriter.setDevice(&m_pgnFile);
+	}
+
+	// The shards of all workers are merged by game number
+	pgn->setTag(PgnGame::GameNumberTag, QString::number(number));
+	if (!m_pgnWriter.write(*pgn))
+		qWarning("Could not write to PGN file %s",
+			 qUtf8Printable(m_pgnFile.fileName()));
+}
+
+void TournamentWorker::finish()
+{
+	m_socket.disconnectFromHost();
+
+	GameManager* manager = m_tournament->gameManager();
+	connect(manager, SIGNAL(finished()), this, SIGNAL(finished()));
+	manager->finish();
+}
@@ -0,0 +1,83 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TOURNAMENTWORKER_H
+#define TOURNAMENTWORKER_H
+
+#include <QObject>
+#include <QMap>
+#include <QString>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <compressedfile.h>
+#include <pgnwriter.h>
+
+class ChessGame;
+class Tournament;
+
+
+/*
+ * Plays the games handed out by a TournamentCoordinator. The players,
+ * time controls and adjudication come from the worker's own tournament,
+ * which must list the same engines in the same order as the
+ * coordinator's.
+ */
+class TournamentWorker : public QObject
+{
+	Q_OBJECT
+
+	public:
+		TournamentWorker(Tournament* tournament, QObject* parent = nullptr);
+
+		void setCoordinator(const QString& host, quint16 port);
+		void setPgnEnabled(bool enabled);
+		// Saves the games to a local PGN shard with their numbers
+		void setPgnOutput(const QString& fileName);
+
+	public slots:
+		void start();
+		void stop();
+
+	signals:
+		void finished();
+
+	private slots:
+		void onConnected();
+		void onReadyRead();
+		void onError();
+		void onGameFinished(ChessGame* game);
+		void onGameStartFailed(ChessGame* game);
+
+	private:
+		bool startGame(const QJsonObject& spec);
+		void send(const QJsonObject& message);
+		void savePgn(PgnGame* pgn, int number);
+		void finish();
+
+		Tournament* m_tournament;
+		QTcpSocket m_socket;
+		QString m_host;
+		quint16 m_port;
+		bool m_pgnEnabled;
+		CompressedFile m_pgnFile;
+		PgnWriter m_pgnWriter;
+		bool m_stopping;
+		QMap<ChessGame*, int> m_games;
+};
+
+#endif // TOURNAMENTWORKER_H
@@ -25,6 +25,7 @@
 #include <QGraphicsPolygonItem>
 #include <QGraphicsTextItem>
 #include <QSettings>
+#include <QCoreApplication>
 #include <algorithm>
 #include <board/board.h>
 #include "graphicsboard.h"
@@ -36,6 +37,16 @@ namespace {
 
 const qreal s_squareSize = 50;
 
+// All scenes share the renderer, so that GraphicsPiece's pixmap cache
+// can be shared between them too
+QSvgRenderer* sharedRenderer()
+{
+	static QSvgRenderer* renderer =
+		new QSvgRenderer(QString(":/default.svg"),
+				 QCoreApplication::instance());
+	return renderer;
+}
+
 } // anonymous namespace
 
 BoardScene::BoardScene(QObject* parent)
@@ -46,9 +57,12 @@ BoardScene::BoardScene(QObject* parent)
 	  m_reserve(nullptr),
 	  m_chooser(nullptr),
 	  m_anim(nullptr),
-	  m_renderer(new QSvgRenderer(QString(":/default.svg"), this)),
+	  m_renderer(sharedRenderer()),
 	  m_highlightPiece(nullptr),
-	  m_moveArrows(nullptr)
+	  m_moveArrows(nullptr),
+	  m_arrowCount(0),
+	  m_animated(true),
+	  m_movesValid(false)
 {
 }
 
@@ -63,21 +77,41 @@ Chess::Board* BoardScene::board() const
 	return m_board;
 }
 
+void BoardScene::setAnimated(bool enabled)
+{
+	m_animated = enabled;
+}
+
 void BoardScene::setBoard(Chess::Board* board)
 {
 	stopAnimation();
+	const bool sameVariant = m_board != nullptr && board != nullptr
+			      && m_board->variant() == board->variant();
 	if (m_board != board)
 		delete m_board;
 
-	clear();
 	m_history.clear();
 	m_transition.clear();
+	m_board = board;
+	invalidateMoves();
+
+	// The board's size and the pieces' pictures depend on the variant
+	if (sameVariant)
+	{
+		if (m_squares != nullptr)
+			m_squares->setFlipped(false);
+		return;
+	}
+
+	clear();
 	m_squares = nullptr;
 	m_reserve = nullptr;
 	m_chooser = nullptr;
 	m_highlightPiece = nullptr;
+	m_spares.clear();
 	m_moveArrows = nullptr;
-	m_board = board;
+	m_arrows.clear();
+	m_arrowCount = 0;
 }
 
 void BoardScene::populate()
@@ -85,51 +119,70 @@ void BoardScene::populate()
 	Q_ASSERT(m_board != nullptr);
 
 	stopAnimation();
-	clear();
 	m_history.clear();
 	m_transition.clear();
-	m_squares = nullptr;
-	m_reserve = nullptr;
-	m_chooser = nullptr;
+	delete m_chooser;
 	m_highlightPiece = nullptr;
-	m_moveArrows = nullptr;
+	if (mouseGrabberItem() != nullptr)
+		mouseGrabberItem()->ungrabMouse();
 
-	m_squares = new GraphicsBoard(m_board->width(),
-				      m_board->height(),
-				      s_squareSize);
-	addItem(m_squares);
-
-	if (m_board->variantHasDrops())
+	if (m_squares == nullptr)
 	{
-		m_reserve = new GraphicsPieceReserve(s_squareSize);
-		addItem(m_reserve);
-		m_reserve->setX(m_squares->boundingRect().right() +
-				m_reserve->boundingRect().right() + 7);
-
-		const auto types = m_board->reservePieceTypes();
-		for (const auto& piece : types)
+		m_squares = new GraphicsBoard(m_board->width(),
+					      m_board->height(),
+					      s_squareSize);
+		addItem(m_squares);
+		m_moveArrows = new QGraphicsItemGroup(m_squares);
+		m_moveArrows->setZValue(1);
+
+		if (m_board->variantHasDrops())
 		{
-			int count = m_board->reserveCount(piece);
-			for (int i = 0; i < count; i++)
-				m_reserve->addPiece(createPiece(piece));
+			m_reserve = new GraphicsPieceReserve(s_squareSize);
+			addItem(m_reserve);
+			m_reserve->setX(m_squares->boundingRect().right() +
+					m_reserve->boundingRect().right() + 7);
 		}
-	}
 
-	setSceneRect(itemsBoundingRect());
+		setSceneRect(itemsBoundingRect());
+	}
+	else
+		m_squares->clearHighlights();
+	clearMoveArrows();
 
+	// The pieces that don't match the new position are recycled
+	// first, so that they can be reused on other squares
+	QVector<Chess::Square> changed;
 	for (int x = 0; x < m_board->width(); x++)
 	{
 		for (int y = 0; y < m_board->height(); y++)
 		{
 			Chess::Square sq(x, y);
-			GraphicsPiece* piece(createPiece(m_board->pieceAt(sq)));
-
-			if (piece != nullptr)
-				m_squares->setSquare(sq, piece);
+			GraphicsPiece* piece = m_squares->pieceAt(sq);
+
+			if (m_board->pieceAt(sq) != m_squares->pieceTypeAt(sq))
+			{
+				recyclePiece(m_squares->takePieceAt(sq));
+				changed.append(sq);
+			}
+			else if (piece != nullptr)
+			{
+				// The board may have been flipped
+				piece->restoreParent();
+				piece->setPos(m_squares->squarePos(sq));
+			}
 		}
 	}
+	for (const auto& sq : qAsConst(changed))
+		m_squares->setSquare(sq, createPiece(m_board->pieceAt(sq)));
 
-	updateMoves();
+	if (m_reserve != nullptr)
+	{
+		const auto types = m_board->reservePieceTypes();
+		for (const auto& piece : types)
+			updateReserve(piece);
+	}
+
+	invalidateMoves();
 }
 
 void BoardScene::setFenString(const QString& fenString)
@@ -145,9 +198,7 @@ void BoardScene::setFenString(const QString& fenString)
 void BoardScene::makeMove(const Chess::Move& move)
 {
 	stopAnimation();
-	delete m_moveArrows;
-	m_moveArrows = new QGraphicsItemGroup(m_squares);
-	m_moveArrows->setZValue(1);
+	clearMoveArrows();
 
 	Q_ASSERT(!move.isNull());
 	Q_ASSERT(m_board->isLegalMove(move));
@@ -166,8 +217,7 @@ void BoardScene::makeMove(const Chess::GenericMove& move)
 void BoardScene::undoMove()
 {
 	stopAnimation();
-	delete m_moveArrows;
-	m_moveArrows = nullptr;
+	clearMoveArrows();
 
 	m_board->undoMove();
 	applyTransition(m_history.takeLast(), Backward);
@@ -228,6 +278,7 @@ void BoardScene::mouseMoveEvent(QGraphicsSceneMouseEvent* event)
 		return;
 	}
 
+	updateMoves();
 	if (m_targets.contains(piece)
 	&&  QSettings().value("ui/highlight_legal_moves", true).toBool())
 	{
@@ -258,6 +309,7 @@ void BoardScene::mousePressEvent(QGraphicsSceneMouseEvent* event)
 	if (piece == nullptr || event->button() != Qt::LeftButton)
 		return;
 
+	updateMoves();
 	if (m_targets.contains(piece))
 	{
 		piece->setFlag(QGraphicsItem::ItemIsMovable, true);
@@ -285,14 +337,14 @@ void BoardScene::mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
 
 void BoardScene::onTransitionFinished()
 {
-	const auto drops = m_transition.drops();
+	const auto& drops = m_transition.drops();
 	if (m_direction == Backward)
 	{
 		for (const auto& drop : drops)
 			m_reserve->addPiece(m_squares->takePieceAt(drop.target));
 	}
 
-	const auto moves = m_transition.moves();
+	const auto& moves = m_transition.moves();
 	for (const auto& move : moves)
 	{
 		if (m_direction == Forward)
@@ -308,34 +360,23 @@ void BoardScene::onTransitionFinished()
 					     m_reserve->takePiece(drop.piece));
 	}
 
-	const auto squares = m_transition.squares();
+	const auto& squares = m_transition.squares();
 	for (const auto& square : squares)
 	{
 		Chess::Piece type = m_board->pieceAt(square);
 		if (type != m_squares->pieceTypeAt(square))
+		{
+			recyclePiece(m_squares->takePieceAt(square));
 			m_squares->setSquare(square, createPiece(type));
+		}
 	}
 
-	const auto reserve = m_transition.reserve();
+	const auto& reserve = m_transition.reserve();
 	for (const auto& piece : reserve)
-	{
-		int count = m_reserve->pieceCount(piece);
-		int newCount = m_board->reserveCount(piece);
-
-		while (newCount > count)
-		{
-			m_reserve->addPiece(createPiece(piece));
-			count++;
-		}
-		while (newCount < count)
-		{
-			delete m_reserve->takePiece(piece);
-			count--;
-		}
-	}
+		updateReserve(piece);
 
 	m_transition.clear();
-	updateMoves();
+	invalidateMoves();
 }
 
 void BoardScene::onPromotionChosen(const Chess::Piece& promotion)
@@ -421,12 +462,47 @@ GraphicsPiece* BoardScene::createPiece(const Chess::Piece& piece)
 	if (!piece.isValid())
 		return nullptr;
 
+	GraphicsPiece* spare = m_spares.take(piece);
+	if (spare != nullptr)
+	{
+		spare->show();
+		return spare;
+	}
+
 	return new GraphicsPiece(piece,
 				 s_squareSize,
 				 m_board->representation(piece),
 				 m_renderer);
 }
 
+void BoardScene::recyclePiece(GraphicsPiece* piece)
+{
+	if (piece == nullptr)
+		return;
+
+	// Unused pieces stay in the scene as hidden top-level items
+	// until createPiece() needs a piece of the same type
+	piece->hide();
+	m_spares.insert(piece->pieceType(), piece);
+}
+
+void BoardScene::updateReserve(const Chess::Piece& piece)
+{
+	int count = m_reserve->pieceCount(piece);
+	int newCount = m_board->reserveCount(piece);
+
+	while (newCount > count)
+	{
+		m_reserve->addPiece(createPiece(piece));
+		count++;
+	}
+	while (newCount < count)
+	{
+		recyclePiece(m_reserve->takePiece(piece));
+		count--;
+	}
+}
+
 QPropertyAnimation* BoardScene::pieceAnimation(GraphicsPiece* piece,
 					       const QPointF& endPoint) const
 {
@@ -536,12 +612,31 @@ void BoardScene::addMoveArrow(const QPointF& sourcePos,
 	QPolygonF polygon;
 	polygon << l2.p1() << l1.p2() << l2.p2();
 
-	QGraphicsPolygonItem* item = new QGraphicsPolygonItem(polygon);
-	item->setPen(QPen(QBrush(Qt::yellow), 2));
-	item->setBrush(Qt::yellow);
-	item->setOpacity(0.6);
+	if (m_arrowCount == m_arrows.size())
+	{
+		QGraphicsPolygonItem* item = new QGraphicsPolygonItem;
+		item->setPen(QPen(QBrush(Qt::yellow), 2));
+		item->setBrush(Qt::yellow);
+		item->setOpacity(0.6);
 
-	m_moveArrows->addToGroup(item);
+		m_moveArrows->addToGroup(item);
+		m_arrows.append(item);
+	}
+
+	QGraphicsPolygonItem* item = m_arrows.at(m_arrowCount++);
+	item->setPolygon(polygon);
+	item->show();
+}
+
+void BoardScene::clearMoveArrows()
+{
+	for (int i = 0; i < m_arrowCount; i++)
+		m_arrows.at(i)->hide();
+	m_arrowCount = 0;
+
+	// New arrows are placed for the current orientation
+	if (m_moveArrows != nullptr)
+		m_moveArrows->setRotation(0);
 }
 
 void BoardScene::applyTransition(const Chess::BoardTransition& transition,
@@ -554,7 +649,7 @@ void BoardScene::applyTransition(const Chess::BoardTransition& transition,
 	connect(group, SIGNAL(finished()), this, SLOT(onTransitionFinished()));
 	m_anim = group;
 
-	const auto drops = transition.drops();
+	const auto& drops = transition.drops();
 	if (direction == Backward)
 	{
 		for (const auto& drop : drops)
@@ -564,7 +659,7 @@ void BoardScene::applyTransition(const Chess::BoardTransition& transition,
 		}
 	}
 
-	const auto moves = transition.moves();
+	const auto& moves = transition.moves();
 	for (const auto& move : moves)
 	{
 		Chess::Square source = move.source;
@@ -598,12 +693,24 @@ void BoardScene::applyTransition(const Chess::BoardTransition& transition,
 	}
 
 	group->start(QAbstractAnimation::DeleteWhenStopped);
+	if (!m_animated)
+		stopAnimation();
 }
 
-void BoardScene::updateMoves()
+void BoardScene::invalidateMoves()
 {
 	m_targets.clear();
 	m_moves.clear();
+	m_movesValid = false;
+}
+
+void BoardScene::updateMoves()
+{
+	// The moves are generated on the first hover or press after a
+	// position change, so spectator boards never generate them
+	if (m_movesValid)
+		return;
+	m_movesValid = true;
 	if (!m_board->result().isNone())
 		return;
 
@@ -20,6 +20,7 @@
 #define BOARDSCENE_H
 
 #include <QGraphicsScene>
+#include <QList>
 #include <QMultiMap>
 #include <QPointer>
 #include <board/square.h>
@@ -37,6 +38,7 @@ class ChessGame;
 class QSvgRenderer;
 class QAbstractAnimation;
 class QPropertyAnimation;
+class QGraphicsPolygonItem;
 class GraphicsBoard;
 class GraphicsPieceReserve;
 class GraphicsPiece;
@@ -67,21 +69,35 @@ class BoardScene : public QGraphicsScene
 		/*! Returns the current internal board object. */
 		Chess::Board* board() const;
 		/*!
-		 * Clears the scene and sets \a board as the internal board.
+		 * Sets \a board as the internal board, and shows it
+		 * unflipped.
+		 *
+		 * The scene's items are kept for populate() to reuse if
+		 * \a board plays the same variant as the previous board;
+		 * otherwise the scene is cleared.
 		 *
 		 * The scene takes ownership of the board, so it's usually
 		 * best to give the scene its own copy of a board.
 		 */
 		void setBoard(Chess::Board* board);
+		/*!
+		 * Sets move animations to \a enabled (default: true).
+		 *
+		 * If animations are disabled, the pieces of a move jump
+		 * to their new squares at once.
+		 */
+		void setAnimated(bool enabled);
 
 	public slots:
 		/*!
-		 * Clears the scene, creates a new board, and populates
-		 * it with chess pieces.
+		 * Populates the scene with the board and chess pieces.
 		 *
 		 * The scene is populated to match the current FEN string of
 		 * the internal board, so the internal board must be fully
-		 * initialized before calling this function.
+		 * initialized before calling this function. The board and
+		 * the pieces already in the scene are reused: only the
+		 * squares whose piece changed get a new piece, which is
+		 * taken from the unused pieces if possible.
 		 */
 		void populate();
 		/*! Re-populates the scene according to \a fenString. */
@@ -132,6 +148,8 @@ class BoardScene : public QGraphicsScene
 		QPointF squarePos(const Chess::Square& square) const;
 		GraphicsPiece* pieceAt(const QPointF& pos) const;
 		GraphicsPiece* createPiece(const Chess::Piece& piece);
+		void recyclePiece(GraphicsPiece* piece);
+		void updateReserve(const Chess::Piece& piece);
 		QPropertyAnimation* pieceAnimation(GraphicsPiece* piece,
 						   const QPointF& endPoint) const;
 		void stopAnimation();
@@ -140,8 +158,10 @@ class BoardScene : public QGraphicsScene
 				 const char* member);
 		void addMoveArrow(const QPointF& sourcePos,
 				  const QPointF& targetPos);
+		void clearMoveArrows();
 		void applyTransition(const Chess::BoardTransition& transition,
 				     MoveDirection direction);
+		void invalidateMoves();
 		void updateMoves();
 
 		Chess::Board* m_board;
@@ -158,7 +178,12 @@ class BoardScene : public QGraphicsScene
 		QList<Chess::GenericMove> m_moves;
 		Chess::GenericMove m_promotionMove;
 		GraphicsPiece* m_highlightPiece;
+		QMultiMap<Chess::Piece, GraphicsPiece*> m_spares;
 		QGraphicsItemGroup* m_moveArrows;
+		QList<QGraphicsPolygonItem*> m_arrows;
+		int m_arrowCount;
+		bool m_animated;
+		bool m_movesValid;
 };
 
 #endif // BOARDSCENE_H
@@ -20,11 +20,18 @@
 #include <QPainter>
 #include <QResizeEvent>
 #include <QTimer>
+#ifndef QT_NO_OPENGL
+#include <QOpenGLWidget>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#endif
+#include "guiprofiler.h"
 
 
 BoardView::BoardView(QGraphicsScene* scene, QWidget* parent)
 	: QGraphicsView(scene, parent),
 	  m_initialized(false),
+	  m_accelerated(false),
 	  m_resizeTimer(new QTimer(this))
 {
 	setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -45,6 +52,66 @@ BoardView::BoardView(QGraphicsScene* scene, QWidget* parent)
 		this, SLOT(onSceneRectChanged()));
 }
 
+bool BoardView::isAccelerated() const
+{
+	return m_accelerated;
+}
+
+bool BoardView::setAccelerated(bool enabled)
+{
+	if (enabled == m_accelerated)
+		return true;
+	if (enabled && !isAccelerationAvailable())
+		return false;
+
+	#ifndef QT_NO_OPENGL
+	if (enabled)
+	{
+		QSurfaceFormat format(QSurfaceFormat::defaultFormat());
+		format.setSamples(4);
+		QOpenGLWidget* widget = new QOpenGLWidget();
+		widget->setFormat(format);
+		setViewport(widget);
+
+		// A partial update redraws the whole framebuffer anyway
+		setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+	}
+	else
+	{
+		setViewport(new QWidget());
+		setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+	}
+	viewport()->setMouseTracking(true);
+	m_accelerated = enabled;
+	#endif
+
+	return true;
+}
+
+bool BoardView::isAccelerationAvailable()
+{
+	#ifndef QT_NO_OPENGL
+	// A context is created once to see if the platform has OpenGL,
+	// so that the views can fall back to software drawing
+	static int available = -1;
+	if (available == -1)
+	{
+		QOffscreenSurface surface;
+		surface.create();
+		QOpenGLContext context;
+		available = context.create() && context.makeCurrent(&surface);
+		if (available)
+			context.doneCurrent();
+		else
+			qWarning("OpenGL is not available, the boards are "
+				 "drawn in software");
+	}
+	return available == 1;
+	#else
+	return false;
+	#endif
+}
+
 QSize BoardView::sizeHint() const
 {
 	QSize size(sceneRect().size().toSize());
@@ -68,6 +135,9 @@ int BoardView::heightForWidth(int width) const
 
 void BoardView::paintEvent(QPaintEvent* event)
 {
+	if (GuiProfiler::isEnabled())
+		GuiProfiler::instance()->addRepaint(this);
+
 	if (!m_resizePixmap.isNull())
 	{
 		QRect rect(viewport()->rect());
@@ -38,6 +38,18 @@ class BoardView : public QGraphicsView
 		/*! Creates a new BoardView object that displays \a scene. */
 		explicit BoardView(QGraphicsScene* scene, QWidget* parent = nullptr);
 
+		/*! Returns true if the view is drawn with OpenGL. */
+		bool isAccelerated() const;
+		/*!
+		 * Draws the view with OpenGL if \a enabled is true and
+		 * OpenGL is available; otherwise in software.
+		 *
+		 * Returns true if the view is drawn as requested.
+		 */
+		bool setAccelerated(bool enabled);
+		/*! Returns true if OpenGL can be used for drawing. */
+		static bool isAccelerationAvailable();
+
 		// Inherited from QGraphicsView
 		virtual QSize sizeHint() const;
 		virtual int heightForWidth(int width) const;
@@ -53,6 +65,7 @@ class BoardView : public QGraphicsView
 
 	private:
 		bool m_initialized;
+		bool m_accelerated;
 		QTimer* m_resizeTimer;
 		QPixmap m_resizePixmap;
 };
@@ -18,7 +18,31 @@
 
 #include "graphicspiece.h"
 #include <QSvgRenderer>
+#include <QPainter>
+#include <QPixmapCache>
+#include <QHash>
+#include <QStringList>
+#include <QtMath>
+
+namespace {
+
+// The number of cells in a row of a piece atlas
+const int AtlasColumns = 8;
+
+// Returns the size of picture \a elementId of \a renderer when it's
+// scaled to fit in a square that is \a width wide
+QSizeF fittedSize(QSvgRenderer* renderer,
+		  const QString& elementId,
+		  qreal width)
+{
+	const QRectF bounds(renderer->boundsOnElement(elementId));
+	const qreal ar = bounds.width() / bounds.height();
+	if (ar > 1.0)
+		return QSizeF(width, width / ar);
+	return QSizeF(width * ar, width);
+}
 
+} // anonymous namespace
 
 GraphicsPiece::GraphicsPiece(const Chess::Piece& piece,
 			     qreal squareSize,
@@ -34,7 +58,6 @@ GraphicsPiece::GraphicsPiece(const Chess::Piece& piece,
 	  m_container(nullptr)
 {
 	setAcceptedMouseButtons(Qt::LeftButton);
-	setCacheMode(DeviceCoordinateCache);
 }
 
 int GraphicsPiece::type() const
@@ -54,23 +77,75 @@ void GraphicsPiece::paint(QPainter* painter,
 	Q_UNUSED(option);
 	Q_UNUSED(widget);
 
-	QRectF bounds(m_renderer->boundsOnElement(m_elementId));
-	qreal ar = bounds.width() / bounds.height();
-	qreal width = m_rect.width() * 0.8;
+	const qreal width = m_rect.width() * 0.8;
+	QRectF bounds(QPointF(0, 0), fittedSize(m_renderer, m_elementId, width));
+	bounds.moveCenter(m_rect.center());
 
-	if (ar > 1.0)
+	// The pieces are drawn from atlases that are shared by all pieces
+	// with the same renderer and size in device pixels
+	const QTransform& transform = painter->worldTransform();
+	const qreal scale = qSqrt(transform.m11() * transform.m11() +
+				  transform.m12() * transform.m12())
+			  * painter->device()->devicePixelRatioF();
+	const int cellSize = qCeil(width * scale);
+	if (cellSize <= 0)
+		return;
+
+	QRectF source;
+	const QPixmap atlas(pieceAtlas(cellSize, &source));
+	if (atlas.isNull())
+		return;
+
+	painter->setRenderHint(QPainter::SmoothPixmapTransform);
+	painter->drawPixmap(bounds, atlas, source);
+}
+
+QPixmap GraphicsPiece::pieceAtlas(int cellSize, QRectF* source) const
+{
+	// Every picture of a renderer has the same cell in all of its
+	// atlases. A picture that's drawn for the first time gets a new
+	// cell, which changes the atlas keys and renders new atlases.
+	static QHash<QSvgRenderer*, QStringList> s_cells;
+	QStringList& elementIds = s_cells[m_renderer];
+	int index = elementIds.indexOf(m_elementId);
+	if (index == -1)
 	{
-		bounds.setWidth(width);
-		bounds.setHeight(width / ar);
+		index = elementIds.size();
+		elementIds.append(m_elementId);
 	}
-	else
+
+	// One transparent pixel around each cell keeps the pictures
+	// from bleeding into each other when they're smoothly scaled
+	const int cellStride = cellSize + 2;
+	const int columns = qMin(elementIds.size(), AtlasColumns);
+	const int rows = (elementIds.size() + AtlasColumns - 1) / AtlasColumns;
+
+	*source = QRectF(QPointF((index % AtlasColumns) * cellStride + 1,
+				 (index / AtlasColumns) * cellStride + 1),
+			 fittedSize(m_renderer, m_elementId, cellSize));
+
+	const QString key = QString("GraphicsPieceAtlas:%1:%2:%3")
+		.arg(quintptr(m_renderer))
+		.arg(cellSize)
+		.arg(elementIds.size());
+	QPixmap atlas;
+	if (QPixmapCache::find(key, &atlas))
+		return atlas;
+
+	atlas = QPixmap(columns * cellStride, rows * cellStride);
+	atlas.fill(Qt::transparent);
+	QPainter painter(&atlas);
+	for (int i = 0; i < elementIds.size(); i++)
 	{
-		bounds.setHeight(width);
-		bounds.setWidth(width * ar);
+		const QRectF rect(QPointF((i % AtlasColumns) * cellStride + 1,
+					  (i / AtlasColumns) * cellStride + 1),
+				  fittedSize(m_renderer, elementIds.at(i), cellSize));
+		m_renderer->render(&painter, elementIds.at(i), rect);
 	}
-	bounds.moveCenter(m_rect.center());
+	painter.end();
+	QPixmapCache::insert(key, atlas);
 
-	m_renderer->render(painter, m_elementId, bounds);
+	return atlas;
 }
 
 Chess::Piece GraphicsPiece::pieceType() const
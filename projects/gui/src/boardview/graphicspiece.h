@@ -22,6 +22,7 @@
 #include <QGraphicsObject>
 #include <board/piece.h>
 class QSvgRenderer;
+class QPixmap;
 
 /*!
  * \brief A graphical representation of a chess piece.
@@ -29,7 +30,11 @@ class QSvgRenderer;
  * A GraphicsPiece object is a chess piece that can be easily
  * dragged and animated in a QGraphicsScene. Scalable Vector
  * Graphics (SVG) are used to ensure that the pieces look good
- * at any resolution, and a shared SVG renderer is used.
+ * at any resolution, and a shared SVG renderer is used. The
+ * rendered pictures of a renderer are kept in one atlas pixmap per
+ * size in a process-wide pixmap cache, so pieces of the same type
+ * and size on any board are rasterized only once, and an OpenGL
+ * view uploads all of them as a single texture.
  *
  * For convenience reasons the boundingRect() of a piece should
  * be equal to that of a square on the chessboard.
@@ -88,6 +93,11 @@ class GraphicsPiece : public QGraphicsObject
 		void restoreParent();
 
 	private:
+		// Returns the atlas of the piece's pictures with cells that
+		// are \a cellSize pixels wide, and the piece's picture in it
+		// in \a source
+		QPixmap pieceAtlas(int cellSize, QRectF* source) const;
+
 		Chess::Piece m_piece;
 		QRectF m_rect;
 		QString m_elementId;
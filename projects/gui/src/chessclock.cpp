@@ -17,15 +17,15 @@
 */
 
 #include "chessclock.h"
-#include <QTimerEvent>
 #include <QLabel>
 #include <QVBoxLayout>
+#include "clockticker.h"
 
 
 ChessClock::ChessClock(QWidget* parent)
 	: QWidget(parent),
 	  m_totalTime(0),
-	  m_timerId(-1),
+	  m_running(false),
 	  m_infiniteTime(false),
 	  m_nameLabel(new QLabel()),
 	  m_timeLabel(new QLabel())
@@ -45,6 +45,11 @@ ChessClock::ChessClock(QWidget* parent)
 	setLayout(layout);
 }
 
+ChessClock::~ChessClock()
+{
+	stopTimer();
+}
+
 void ChessClock::setPlayerName(const QString& name)
 {
 	if (name.isEmpty())
@@ -95,9 +100,12 @@ void ChessClock::start(int totalTime)
 
 	if (!m_infiniteTime)
 	{
+		// The time is measured from the TimeControl's snapshot in
+		// totalTime, not accumulated tick by tick
 		m_time.start();
 		m_totalTime = totalTime;
-		m_timerId = startTimer(1000);
+		m_running = true;
+		ClockTicker::instance()->addClock(this);
 		setTime(totalTime);
 	}
 }
@@ -106,25 +114,28 @@ void ChessClock::stop()
 {
 	m_timeLabel->setPalette(m_defaultPalette);
 
+	updateTime();
 	stopTimer();
-	if (!m_infiniteTime)
-		setTime(m_totalTime - m_time.elapsed());
 }
 
-void ChessClock::timerEvent(QTimerEvent* event)
+void ChessClock::updateTime()
 {
-	if (!event)
-		return;
-	
-	if (event->timerId() == m_timerId)
-		setTime(m_totalTime - m_time.elapsed());
+	if (m_running)
+		setTime(int(m_totalTime - m_time.elapsed()));
+}
+
+void ChessClock::showEvent(QShowEvent* event)
+{
+	// Hidden clocks are not updated by the ticker
+	updateTime();
+	QWidget::showEvent(event);
 }
 
 void ChessClock::stopTimer()
 {
-	if (m_timerId != -1)
+	if (m_running)
 	{
-		killTimer(m_timerId);
-		m_timerId = -1;
+		ClockTicker::instance()->removeClock(this);
+		m_running = false;
 	}
 }
@@ -20,9 +20,8 @@
 #define CHESSCLOCK_H
 
 #include <QWidget>
-#include <QTime>
+#include <QElapsedTimer>
 
-class QTimerEvent;
 class QLabel;
 
 class ChessClock: public QWidget
@@ -31,6 +30,10 @@ class ChessClock: public QWidget
 	
 	public:
 		ChessClock(QWidget* parent = nullptr);
+		virtual ~ChessClock();
+
+		// Shows the time left of a running clock; called by ClockTicker
+		void updateTime();
 	
 	public slots:
 		void setPlayerName(const QString& name);
@@ -40,15 +43,15 @@ class ChessClock: public QWidget
 		void stop();
 	
 	protected:
-		virtual void timerEvent(QTimerEvent* event);
+		virtual void showEvent(QShowEvent* event);
 	
 	private:
 		void stopTimer();
 
 		int m_totalTime;
-		int m_timerId;
+		bool m_running;
 		bool m_infiniteTime;
-		QTime m_time;
+		QElapsedTimer m_time;
 		QLabel* m_nameLabel;
 		QLabel* m_timeLabel;
 		QPalette m_defaultPalette;
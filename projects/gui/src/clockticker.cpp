@@ -0,0 +1,72 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clockticker.h"
+#include <QCoreApplication>
+#include <QSettings>
+#include "chessclock.h"
+
+ClockTicker::ClockTicker(QObject* parent)
+	: QObject(parent)
+{
+	m_timer.setInterval(QSettings().value("ui/clock_update_interval", 1000).toInt());
+	connect(&m_timer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+ClockTicker* ClockTicker::instance()
+{
+	static ClockTicker* ticker =
+		new ClockTicker(QCoreApplication::instance());
+	return ticker;
+}
+
+int ClockTicker::interval() const
+{
+	return m_timer.interval();
+}
+
+void ClockTicker::setInterval(int msecs)
+{
+	m_timer.setInterval(msecs);
+}
+
+void ClockTicker::addClock(ChessClock* clock)
+{
+	if (m_clocks.contains(clock))
+		return;
+
+	m_clocks.append(clock);
+	if (!m_timer.isActive())
+		m_timer.start();
+}
+
+void ClockTicker::removeClock(ChessClock* clock)
+{
+	m_clocks.removeOne(clock);
+	if (m_clocks.isEmpty())
+		m_timer.stop();
+}
+
+void ClockTicker::tick()
+{
+	for (ChessClock* clock : qAsConst(m_clocks))
+	{
+		if (clock->isVisible())
+			clock->updateTime();
+	}
+}
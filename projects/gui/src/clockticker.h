@@ -0,0 +1,66 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLOCKTICKER_H
+#define CLOCKTICKER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QList>
+class ChessClock;
+
+/*!
+ * \brief The timer that updates all running chess clocks
+ *
+ * Running clocks register themselves with the application-wide
+ * ticker, which updates every visible clock in one pass, so a game
+ * wall full of clocks is repainted at once instead of at many
+ * different moments. Hidden clocks are skipped; they update
+ * themselves when they are shown again.
+ *
+ * The timer runs only while there are running clocks.
+ */
+class ClockTicker : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Returns the application's ticker. */
+		static ClockTicker* instance();
+
+		/*! Returns the update interval in milliseconds. */
+		int interval() const;
+		/*! Sets the update interval to \a msecs milliseconds. */
+		void setInterval(int msecs);
+
+		/*! Starts updating \a clock on every tick. */
+		void addClock(ChessClock* clock);
+		/*! Stops updating \a clock. */
+		void removeClock(ChessClock* clock);
+
+	private slots:
+		void tick();
+
+	private:
+		explicit ClockTicker(QObject* parent);
+
+		QTimer m_timer;
+		QList<ChessClock*> m_clocks;
+};
+
+#endif // CLOCKTICKER_H
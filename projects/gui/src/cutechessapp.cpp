@@ -23,6 +23,8 @@
 #include <QTime>
 #include <QFileInfo>
 #include <QSettings>
+#include <QInputDialog>
+#include <QMessageBox>
 
 #include <mersenne.h>
 #include <enginemanager.h>
@@ -31,6 +33,7 @@
 #include <chessgame.h>
 #include <timecontrol.h>
 #include <humanbuilder.h>
+#include <livegameclient.h>
 
 #include "mainwindow.h"
 #include "settingsdlg.h"
@@ -55,10 +58,14 @@ CuteChessApplication::CuteChessApplication(int& argc, char* argv[])
 	  m_gameDatabaseManager(nullptr),
 	  m_gameDatabaseDialog(nullptr),
 	  m_gameWall(nullptr),
+	  m_remoteGameWall(nullptr),
 	  m_initialWindowCreated(false)
 {
 	Mersenne::initialize(QTime(0,0,0).msecsTo(QTime::currentTime()));
 
+	// The views read the state of running games from their snapshots
+	ChessGame::setSnapshotsEnabled(true);
+
 	// Set the application icon
 	QIcon icon;
 	icon.addFile(":/icons/cutechess_512x512.png");
@@ -96,6 +103,7 @@ CuteChessApplication::~CuteChessApplication()
 	delete m_settingsDialog;
 	delete m_tournamentResultsDialog;
 	delete m_gameWall;
+	delete m_remoteGameWall;
 }
 
 CuteChessApplication* CuteChessApplication::instance()
@@ -251,6 +259,51 @@ void CuteChessApplication::showGameWall()
 	showDialog(m_gameWall);
 }
 
+void CuteChessApplication::showRemoteGameWall()
+{
+	if (m_remoteGameWall == nullptr)
+	{
+		QSettings s;
+		bool ok = false;
+		QString address = QInputDialog::getText(nullptr,
+			tr("Remote Games"),
+			tr("Address of the live game feed (host:port):"),
+			QLineEdit::Normal,
+			s.value("ui/live_feed_address", "localhost:").toString(),
+			&ok).trimmed();
+		if (!ok || address.isEmpty())
+			return;
+
+		int sep = address.lastIndexOf(':');
+		int port = address.mid(sep + 1).toInt(&ok);
+		if (sep <= 0 || !ok || port <= 0 || port > 0xffff)
+		{
+			QMessageBox::warning(nullptr, tr("Remote Games"),
+				tr("Invalid address: %1").arg(address));
+			return;
+		}
+		s.setValue("ui/live_feed_address", address);
+
+		auto client = new LiveGameClient();
+		m_remoteGameWall = new GameWall(client);
+		client->setParent(m_remoteGameWall);
+		auto flags = m_remoteGameWall->windowFlags();
+		m_remoteGameWall->setWindowFlags(flags | Qt::Window);
+		m_remoteGameWall->setAttribute(Qt::WA_DeleteOnClose, true);
+		m_remoteGameWall->setWindowTitle(tr("Remote Games - %1").arg(address));
+
+		QWidget* wall = m_remoteGameWall;
+		connect(client, &LiveGameClient::error, wall, [=](const QString& error)
+		{
+			QMessageBox::warning(wall, tr("Remote Games"),
+				tr("Live game feed error: %1").arg(error));
+		});
+		client->connectToFeed(address.left(sep), quint16(port));
+	}
+
+	showDialog(m_remoteGameWall);
+}
+
 void CuteChessApplication::onQuitAction()
 {
 	closeDialogs();
@@ -300,4 +353,6 @@ void CuteChessApplication::closeDialogs()
 		m_settingsDialog->close();
 	if (m_gameWall)
 		m_gameWall->close();
+	if (m_remoteGameWall)
+		m_remoteGameWall->close();
 }
@@ -59,6 +59,7 @@ class CuteChessApplication : public QApplication
 		void showTournamentResultsDialog();
 		void showGameDatabaseDialog();
 		void showGameWall();
+		void showRemoteGameWall();
 		void closeDialogs();
 		void onQuitAction();
 
@@ -73,6 +74,7 @@ class CuteChessApplication : public QApplication
 		QList<QPointer<MainWindow> > m_gameWindows;
 		GameDatabaseDialog* m_gameDatabaseDialog;
 		QPointer<GameWall> m_gameWall;
+		QPointer<GameWall> m_remoteGameWall;
 		bool m_initialWindowCreated;
 
 	private slots:
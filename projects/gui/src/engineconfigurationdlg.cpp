@@ -30,9 +30,11 @@
 #include <engineoption.h>
 #include <chessplayer.h>
 #include <enginebuilder.h>
+#include <enginemanager.h>
 
 #include "engineoptionmodel.h"
 #include "engineoptiondelegate.h"
+#include "cutechessapp.h"
 
 #ifdef QT_DEBUG
 #include <modeltest.h>
@@ -131,6 +133,7 @@ void EngineConfigurationDialog::applyEngineInformation(
 	ui->m_restoreBtn->setDisabled(m_options.isEmpty());
 
 	m_variants = engine.supportedVariants();
+	m_stamp = engine.detectionStamp();
 
 	m_oldCommand = engine.command();
 	m_oldPath = engine.workingDirectory();
@@ -158,6 +161,7 @@ EngineConfiguration EngineConfigurationDialog::engineConfiguration()
 	engine.setOptions(optionCopies);
 
 	engine.setSupportedVariants(m_variants);
+	engine.setDetectionStamp(m_stamp);
 
 	return engine;
 }
@@ -270,11 +274,16 @@ void EngineConfigurationDialog::detectEngineOptions()
 	if (m_engine != nullptr)
 		return;
 
+	// The options are detected again if the engine's binary has
+	// changed, unless they were never detected
+	const bool forced = QObject::sender() == ui->m_detectBtn;
+	const EngineStamp stamp(EngineStamp::fromConfiguration(engineConfiguration()));
 	if (!m_hasError
-	&&  QObject::sender() != ui->m_detectBtn
+	&&  !forced
 	&&  ui->m_commandEdit->text() == m_oldCommand
 	&&  ui->m_workingDirEdit->text() == m_oldPath
-	&&  ui->m_protocolCombo->currentText() == m_oldProtocol)
+	&&  ui->m_protocolCombo->currentText() == m_oldProtocol
+	&&  (m_stamp.isNull() || m_stamp == stamp))
 	{
 		emit detectionFinished();
 		return;
@@ -285,6 +294,14 @@ void EngineConfigurationDialog::detectEngineOptions()
 	m_oldPath = ui->m_workingDirEdit->text();
 	m_oldProtocol = ui->m_protocolCombo->currentText();
 
+	// Another engine may use the same binary
+	if (!forced && useDetectedOptions(stamp))
+	{
+		emit detectionFinished();
+		return;
+	}
+	m_pendingStamp = stamp;
+
 	ui->m_detectBtn->setEnabled(false);
 	ui->m_restoreBtn->setEnabled(false);
 	ui->m_buttonBox->button(QDialogButtonBox::Ok)->setEnabled(false);
@@ -331,10 +348,41 @@ void EngineConfigurationDialog::onEngineReady()
 
 	m_engineOptionModel->setOptions(m_options);
 	m_variants = m_engine->variants();
+	m_stamp = m_pendingStamp;
 
 	m_engine->quit();
 }
 
+bool EngineConfigurationDialog::useDetectedOptions(const EngineStamp& stamp)
+{
+	const EngineManager* manager = CuteChessApplication::instance()->engineManager();
+	const int index = manager->detectedEngineIndex(
+		stamp, ui->m_protocolCombo->currentText());
+	if (index == -1)
+		return false;
+
+	qDeleteAll(m_options);
+	m_options.clear();
+
+	// The other engine's option values are its own, so only
+	// the defaults are copied
+	const EngineConfiguration engine(manager->engineAt(index));
+	const auto options = engine.options();
+	for (const EngineOption* option : options)
+	{
+		EngineOption* copy = option->copy();
+		copy->setValue(copy->defaultValue());
+		m_options << copy;
+	}
+
+	m_engineOptionModel->setOptions(m_options);
+	ui->m_restoreBtn->setDisabled(m_options.isEmpty());
+	m_variants = engine.supportedVariants();
+	m_stamp = stamp;
+
+	return true;
+}
+
 void EngineConfigurationDialog::onEngineQuit()
 {
 	if (m_engine != nullptr)
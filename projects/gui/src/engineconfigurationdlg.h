@@ -92,6 +92,8 @@ class EngineConfigurationDialog : public QDialog
 		void resizeColumns();
 
 	private:
+		bool useDetectedOptions(const EngineStamp& stamp);
+
 		bool m_hasError;
 		EngineOptionModel* m_engineOptionModel;
 		QString m_oldCommand;
@@ -99,6 +101,8 @@ class EngineConfigurationDialog : public QDialog
 		QString m_oldProtocol;
 		QList<EngineOption*> m_options;
 		QStringList m_variants;
+		EngineStamp m_stamp;
+		EngineStamp m_pendingStamp;
 		ChessEngine* m_engine;
 		Ui::EngineConfigurationDialog* ui;
 		QSet<QString> m_reservedNames;
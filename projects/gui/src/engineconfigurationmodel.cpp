@@ -103,12 +103,8 @@ QVariant EngineConfigurationModel::data(const QModelIndex& index, int role) cons
 		if (!engine.supportsVariant(m_chessVariant))
 			return QBrush(Qt::red);
 
-		int count = 0;
-		const auto& engines = m_engineManager->engines();
-		for (const EngineConfiguration& engine2: engines)
-			if (engine.name() == engine2.name())
-				if (++count > 1)
-					return QBrush(Qt::gray);
+		if (m_engineManager->engineNameCount(engine.name()) > 1)
+			return QBrush(Qt::gray);
 
 		return QVariant();
 	}
@@ -92,7 +92,7 @@ bool EngineManagementWidget::hasConfigChanged() const
 void EngineManagementWidget::saveConfig()
 {
 	QString confPath = CuteChessApplication::instance()->configPath();
-	m_engineManager->saveEngines(confPath + QLatin1String("/engines.json"));
+	m_engineManager->saveEnginesLater(confPath + QLatin1String("/engines.json"));
 }
 
 void EngineManagementWidget::updateUi()
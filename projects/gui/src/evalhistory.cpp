@@ -19,15 +19,31 @@
 #include "evalhistory.h"
 #include <QVBoxLayout>
 #include <QtGlobal>
+#include <QShowEvent>
 #include <qcustomplot.h>
 #include <chessgame.h>
 #include <moveevaluation.h>
 
+namespace {
+
+// The plot is redrawn at most this often (in milliseconds)
+const int s_replotInterval = 100;
+// Longer score series are decimated to about this many points
+const int s_maxPoints = 1000;
+
+} // anonymous namespace
+
 EvalHistory::EvalHistory(QWidget *parent)
 	: QWidget(parent),
 	  m_plot(new QCustomPlot(this)),
-	  m_game(nullptr)
+	  m_game(nullptr),
+	  m_maxPly(-1),
+	  m_replotPending(false)
 {
+	m_replotTimer.setSingleShot(true);
+	m_replotTimer.setInterval(s_replotInterval);
+	connect(&m_replotTimer, SIGNAL(timeout()), this, SLOT(onReplotTimeout()));
+
 	auto x = m_plot->xAxis;
 	auto y = m_plot->yAxis;
 	auto ticker = new QCPAxisTickerFixed;
@@ -65,16 +81,25 @@ void EvalHistory::setGame(ChessGame* game)
 		m_game->disconnect(this);
 	m_game = game;
 	m_plot->clearGraphs();
+	m_scores[0].clear();
+	m_scores[1].clear();
 	if (!game)
 	{
-		replot(0);
+		m_maxPly = 0;
+		replot();
 		return;
 	}
 
 	connect(m_game, SIGNAL(scoreChanged(int,int)),
 		this, SLOT(onScore(int,int)));
 
-	setScores(game->scores());
+	// The scores come in ply order, so onScore() can skip the ones
+	// that are already in the snapshot
+	const ChessGame::SharedSnapshot snapshot(game->snapshot());
+	if (!snapshot.isNull())
+		setScores(snapshot->scores);
+	else
+		setScores(QMap<int,int>());
 }
 
 void EvalHistory::setPgnGame(PgnGame* pgn)
@@ -104,6 +129,8 @@ void EvalHistory::setScores(const QMap< int, int >& scores)
 	cBlack.setAlpha(128);
 	m_plot->graph(1)->setBrush(QBrush(cBlack));
 
+	m_scores[0].clear();
+	m_scores[1].clear();
 	int ply = -1;
 
 	for (auto it = scores.constBegin(); it != scores.constEnd(); ++it)
@@ -111,7 +138,8 @@ void EvalHistory::setScores(const QMap< int, int >& scores)
 		ply = it.key();
 		addData(ply, it.value());
 	}
-	replot(ply);
+	m_maxPly = ply;
+	replot();
 }
 
 void EvalHistory::addData(int ply, int score)
@@ -125,11 +153,64 @@ void EvalHistory::addData(int ply, int score)
 	if (side == 1)
 		y = -y;
 
-	m_plot->graph(side)->addData(x, y);
+	m_scores[side].append(QPointF(x, y));
 }
 
-void EvalHistory::replot(int maxPly)
+void EvalHistory::updateGraph(int side)
 {
+	const QVector<QPointF>& scores = m_scores[side];
+	QVector<double> keys;
+	QVector<double> values;
+
+	// Keep the minimum and maximum of each bucket of scores, so
+	// that long games don't lose their peaks
+	const int bucketSize = (scores.size() + s_maxPoints / 2 - 1)
+			     / (s_maxPoints / 2);
+	if (bucketSize <= 1)
+	{
+		for (const QPointF& point : scores)
+		{
+			keys.append(point.x());
+			values.append(point.y());
+		}
+	}
+	for (int i = 0; bucketSize > 1 && i < scores.size(); i += bucketSize)
+	{
+		const int end = qMin(i + bucketSize, scores.size());
+		int min = i;
+		int max = i;
+		for (int j = i + 1; j < end; j++)
+		{
+			if (scores.at(j).y() < scores.at(min).y())
+				min = j;
+			if (scores.at(j).y() > scores.at(max).y())
+				max = j;
+		}
+
+		const int first = qMin(min, max);
+		keys.append(scores.at(first).x());
+		values.append(scores.at(first).y());
+		if (max != min)
+		{
+			const int second = qMax(min, max);
+			keys.append(scores.at(second).x());
+			values.append(scores.at(second).y());
+		}
+	}
+
+	m_plot->graph(side)->setData(keys, values, true);
+}
+
+void EvalHistory::replot()
+{
+	m_replotPending = false;
+	const int maxPly = m_maxPly;
+	if (m_plot->graphCount() == 2)
+	{
+		updateGraph(0);
+		updateGraph(1);
+	}
+
 	if (maxPly == -1)
 	{
 		auto ticker = new QCPAxisTickerFixed;
@@ -150,6 +231,27 @@ void EvalHistory::replot(int maxPly)
 
 void EvalHistory::onScore(int ply, int score)
 {
+	if (ply <= m_maxPly)
+		return;
+
 	addData(ply, score);
-	replot(ply);
+	m_maxPly = ply;
+
+	// Coalesce the replots, and skip them while the widget is hidden
+	m_replotPending = true;
+	if (isVisible() && !m_replotTimer.isActive())
+		m_replotTimer.start();
+}
+
+void EvalHistory::onReplotTimeout()
+{
+	if (m_replotPending && isVisible())
+		replot();
+}
+
+void EvalHistory::showEvent(QShowEvent* event)
+{
+	QWidget::showEvent(event);
+	if (m_replotPending)
+		replot();
 }
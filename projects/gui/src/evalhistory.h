@@ -21,6 +21,9 @@
 
 #include <QWidget>
 #include <QPointer>
+#include <QTimer>
+#include <QVector>
+#include <QPointF>
 
 class QCustomPlot;
 class ChessGame;
@@ -31,6 +34,10 @@ class PgnGame;
  *
  * The fullmove number is on the X axis and score (from white's
  * perspective) is on the Y axis.
+ *
+ * New scores are plotted at most ten times per second, and not at
+ * all while the widget is hidden. Very long games are plotted with
+ * the minimum and maximum scores of groups of moves.
  */
 class EvalHistory : public QWidget
 {
@@ -47,16 +54,27 @@ class EvalHistory : public QWidget
 		/*! Sets evaluation history from PGN game (pointer) \a pgn */
 		void setPgnGame(PgnGame *pgn);
 
+	protected:
+		// Inherited from QWidget
+		virtual void showEvent(QShowEvent* event);
+
 	private slots:
 		void onScore(int ply, int score);
+		void onReplotTimeout();
 
 	private:
 		void addData(int ply, int score);
-		void replot(int maxPly);
+		void updateGraph(int side);
+		void replot();
 		void setScores(const QMap<int, int> &scores);
 
 		QCustomPlot* m_plot;
 		QPointer<ChessGame> m_game;
+		// The scores of both sides as plot coordinates
+		QVector<QPointF> m_scores[2];
+		int m_maxPly;
+		bool m_replotPending;
+		QTimer m_replotTimer;
 };
 
 #endif // EVALHISTORY_H
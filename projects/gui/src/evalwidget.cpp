@@ -21,8 +21,8 @@
 #include <QTableWidgetItem>
 #include <QHeaderView>
 #include <QVBoxLayout>
-#include <QVector>
 #include <QTime>
+#include <QTimer>
 #include <chessplayer.h>
 
 EvalWidget::EvalWidget(QWidget *parent)
@@ -30,6 +30,8 @@ EvalWidget::EvalWidget(QWidget *parent)
 	  m_player(nullptr),
 	  m_statsTable(new QTableWidget(1, 5, this)),
 	  m_pvTable(new QTableWidget(0, 5, this)),
+	  m_updateTimer(new QTimer(this)),
+	  m_pvHistoryLimit(0),
 	  m_depth(-1)
 {
 	m_statsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -49,6 +51,13 @@ EvalWidget::EvalWidget(QWidget *parent)
 	m_statsTable->setItemPrototype(protoItem);
 	m_statsTable->setWordWrap(false);
 
+	// The statistics items are reused for every evaluation
+	for (int i = 0; i <= TbHeader; i++)
+	{
+		m_statItems[i] = protoItem->clone();
+		m_statsTable->setItem(0, i, m_statItems[i]);
+	}
+
 	m_pvTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
 	m_pvTable->verticalHeader()->hide();
 
@@ -63,6 +72,10 @@ EvalWidget::EvalWidget(QWidget *parent)
 	m_pvTable->horizontalHeader()->setStretchLastSection(true);
 	m_pvTable->setWordWrap(false);
 
+	m_updateTimer->setSingleShot(true);
+	m_updateTimer->setInterval(100);
+	connect(m_updateTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
 	QVBoxLayout* layout = new QVBoxLayout();
 	layout->addWidget(m_statsTable);
 	layout->addWidget(m_pvTable);
@@ -72,7 +85,10 @@ EvalWidget::EvalWidget(QWidget *parent)
 
 void EvalWidget::clear()
 {
-	m_statsTable->clearContents();
+	m_updateTimer->stop();
+	m_pending.clear();
+	for (auto item : m_statItems)
+		item->setText(QString());
 	m_depth = -1;
 	m_pv.clear();
 	m_pvTable->clearContents();
@@ -95,45 +111,93 @@ void EvalWidget::setPlayer(ChessPlayer* player)
 		this, SLOT(onEval(MoveEvaluation)));
 }
 
+void EvalWidget::setPvHistoryLimit(int rows)
+{
+	m_pvHistoryLimit = qMax(rows, 0);
+	if (m_pvHistoryLimit > 0 && m_pvTable->rowCount() > m_pvHistoryLimit)
+		m_pvTable->setRowCount(m_pvHistoryLimit);
+}
+
+void EvalWidget::showEvent(QShowEvent* event)
+{
+	QWidget::showEvent(event);
+	flush();
+}
+
 void EvalWidget::onEval(const MoveEvaluation& eval)
+{
+	const bool newRow = eval.depth() != m_depth
+			 || (eval.pv() != m_pv && !m_pv.isEmpty());
+	m_depth = eval.depth();
+	m_pv = eval.pv();
+
+	// An update of the same row replaces the pending one, but
+	// the statistics it had are kept
+	if (!newRow && !m_pending.isEmpty())
+	{
+		PendingEval& last = m_pending.last();
+		MoveEvaluation merged(last.eval);
+		merged.merge(eval);
+		last.eval = merged;
+	}
+	else
+	{
+		PendingEval pending = { eval, newRow };
+		m_pending.append(pending);
+
+		// Rows that would be pushed out of the history anyway
+		if (m_pvHistoryLimit > 0 && m_pending.size() > m_pvHistoryLimit)
+			m_pending.removeFirst();
+	}
+
+	if (isVisible() && !m_updateTimer->isActive())
+		m_updateTimer->start();
+}
+
+void EvalWidget::flush()
+{
+	if (m_pending.isEmpty() || !isVisible())
+		return;
+
+	for (const PendingEval& pending : qAsConst(m_pending))
+	{
+		updateStats(pending.eval);
+		updatePv(pending.eval, pending.newRow);
+	}
+	m_pending.clear();
+
+	if (m_pvHistoryLimit > 0 && m_pvTable->rowCount() > m_pvHistoryLimit)
+		m_pvTable->setRowCount(m_pvHistoryLimit);
+}
+
+void EvalWidget::updateStats(const MoveEvaluation& eval)
 {
 	auto nps = eval.nps();
 	if (nps)
 	{
 		QString npsStr = nps < 10000 ? QString("%1").arg(nps)
 					     : QString("%1k").arg(nps / 1000);
-		auto item = m_statsTable->itemPrototype()->clone();
-		item->setText(npsStr);
-		m_statsTable->setItem(0, NpsHeader, item);
+		m_statItems[NpsHeader]->setText(npsStr);
 	}
 	if (eval.tbHits())
-	{
-		auto item = m_statsTable->itemPrototype()->clone();
-		item->setText(QString::number(eval.tbHits()));
-		m_statsTable->setItem(0, TbHeader, item);
-	}
+		m_statItems[TbHeader]->setText(QString::number(eval.tbHits()));
 	if (eval.hashUsage())
 	{
 		double usage = double(eval.hashUsage()) / 10.0;
-		auto item = m_statsTable->itemPrototype()->clone();
-		item->setText(QString("%1%").arg(usage, 0, 'f', 1));
-		m_statsTable->setItem(0, HashHeader, item);
+		m_statItems[HashHeader]->setText(QString("%1%").arg(usage, 0, 'f', 1));
 	}
 	auto ponderMove = eval.ponderMove();
 	if (!ponderMove.isEmpty())
-	{
-		auto item = m_statsTable->itemPrototype()->clone();
-		item->setText(ponderMove);
-		m_statsTable->setItem(0, PonderMoveHeader, item);
-	}
+		m_statItems[PonderMoveHeader]->setText(ponderMove);
 	if (eval.ponderhitRate())
 	{
 		double rate = double(eval.ponderhitRate() / 10.0);
-		auto item = m_statsTable->itemPrototype()->clone();
-		item->setText(QString("%1%").arg(rate, 0, 'f', 1));
-		m_statsTable->setItem(0, PonderHitHeader, item);
+		m_statItems[PonderHitHeader]->setText(QString("%1%").arg(rate, 0, 'f', 1));
 	}
+}
 
+void EvalWidget::updatePv(const MoveEvaluation& eval, bool newRow)
+{
 	QString depth;
 	if (eval.depth())
 	{
@@ -157,23 +221,22 @@ void EvalWidget::onEval(const MoveEvaluation& eval)
 	if (eval.nodeCount())
 		nodeCount = QString::number(eval.nodeCount());
 
-	QString score = eval.scoreText();
-
-	QVector<QTableWidgetItem*> items;
-	items << new QTableWidgetItem(depth)
-	      << new QTableWidgetItem(time)
-	      << new QTableWidgetItem(nodeCount)
-	      << new QTableWidgetItem(score)
-	      << new QTableWidgetItem(eval.pv());
+	const QString texts[] = { depth, time, nodeCount,
+				  eval.scoreText(), eval.pv() };
 
-	for (int i = 0; i < 4; i++)
-		items[i]->setTextAlignment(Qt::AlignVCenter | Qt::AlignRight);
-
-	if (eval.depth() != m_depth || (eval.pv() != m_pv && !m_pv.isEmpty()))
+	// The items of the top row are reused until a new row starts
+	if (newRow || m_pvTable->rowCount() == 0)
+	{
 		m_pvTable->insertRow(0);
-	m_depth = eval.depth();
-	m_pv = eval.pv();
+		for (int i = 0; i < 5; i++)
+		{
+			auto item = new QTableWidgetItem;
+			if (i < 4)
+				item->setTextAlignment(Qt::AlignVCenter | Qt::AlignRight);
+			m_pvTable->setItem(0, i, item);
+		}
+	}
 
-	for (int i = 0; i < items.size(); i++)
-		m_pvTable->setItem(0, i, items.at(i));
+	for (int i = 0; i < 5; i++)
+		m_pvTable->item(0, i)->setText(texts[i]);
 }
@@ -21,13 +21,20 @@
 
 #include <QWidget>
 #include <QPointer>
+#include <QVector>
 #include <moveevaluation.h>
 
 class QTableWidget;
+class QTableWidgetItem;
+class QTimer;
 class ChessPlayer;
 
 /*!
  * \brief A widget that shows the engine's thinking in realtime.
+ *
+ * The engine's evaluations are buffered and shown at most ten times
+ * per second, and not at all while the widget is hidden, so a fast
+ * stream of thinking output doesn't keep the GUI busy.
  */
 class EvalWidget : public QWidget
 {
@@ -42,12 +49,30 @@ class EvalWidget : public QWidget
 		 * the previous player (if any).
 		 */
 		void setPlayer(ChessPlayer* player);
+		/*!
+		 * Limits the principal variation history to the
+		 * latest \a rows rows. Older rows are removed as new
+		 * ones are added. Zero (the default) means no limit.
+		 */
+		void setPvHistoryLimit(int rows);
+
+	protected:
+		// Inherited from QWidget
+		virtual void showEvent(QShowEvent* event);
 
 	private slots:
 		void clear();
 		void onEval(const MoveEvaluation& eval);
+		void flush();
 
 	private:
+		// An evaluation that hasn't been shown yet
+		struct PendingEval
+		{
+			MoveEvaluation eval;
+			bool newRow;
+		};
+
 		enum StatHeaders
 		{
 			NpsHeader,
@@ -60,8 +85,15 @@ class EvalWidget : public QWidget
 		QPointer<ChessPlayer> m_player;
 		QTableWidget* m_statsTable;
 		QTableWidget* m_pvTable;
+		QTableWidgetItem* m_statItems[TbHeader + 1];
+		QTimer* m_updateTimer;
+		QVector<PendingEval> m_pending;
+		int m_pvHistoryLimit;
 		int m_depth;
 		QString m_pv;
+
+		void updateStats(const MoveEvaluation& eval);
+		void updatePv(const MoveEvaluation& eval, bool newRow);
 };
 
 #endif // EVALWIDGET_H
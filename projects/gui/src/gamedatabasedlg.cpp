@@ -26,11 +26,14 @@
 #include <QFileDialog>
 #include <QInputDialog>
 #include <QClipboard>
+#include <QHeaderView>
+#include <QtConcurrentRun>
 
 #include <pgnstream.h>
 #include <pgngame.h>
 #include <pgngameentry.h>
 #include <polyglotbook.h>
+#include <positionindex.h>
 
 #include "pgndatabasemodel.h"
 #include "pgngameentrymodel.h"
@@ -132,8 +135,10 @@ class BookExportTask : public ThreadedTask
 			       int maxDepth,
 			       QWidget* parent);
 
+		virtual ~BookExportTask();
+
 	protected:
-		virtual void run();
+		virtual void work();
 
 	private:
 		PgnGameIterator* m_it;
@@ -153,10 +158,15 @@ BookExportTask::BookExportTask(PgnGameIterator* it,
 	  m_file(file),
 	  m_depth(maxDepth)
 {
-	m_file->moveToThread(this);
 }
 
-void BookExportTask::run()
+BookExportTask::~BookExportTask()
+{
+	delete m_it;
+	delete m_file;
+}
+
+void BookExportTask::work()
 {
 	QDataStream out(m_file);
 	PolyglotBook openingBook;
@@ -170,12 +180,9 @@ void BookExportTask::run()
 		if (ok)
 		{
 			openingBook.import(game, m_depth);
-			if (++i % 512 == 0)
-			{
-				if (cancelRequested())
-					break;
-				emit progressValueChanged(i);
-			}
+			setProgress(++i);
+			if (cancelRequested())
+				break;
 		}
 	}
 
@@ -183,11 +190,7 @@ void BookExportTask::run()
 	// even if cancel was requested.
 	emit statusMessageChanged(tr("Writing opening book to disk"));
 	out << &openingBook;
-
-	delete m_it;
-	delete m_file;
-
-	emit progressValueChanged(i);
+	m_file->close();
 }
 
 
@@ -200,8 +203,10 @@ class PgnExportTask : public ThreadedTask
 			      QFile* file,
 			      QWidget* parent);
 
+		virtual ~PgnExportTask();
+
 	protected:
-		virtual void run();
+		virtual void work();
 
 	private:
 		PgnGameIterator* m_it;
@@ -218,10 +223,15 @@ PgnExportTask::PgnExportTask(PgnGameIterator* it,
 	  m_it(it),
 	  m_file(file)
 {
-	m_file->moveToThread(this);
 }
 
-void PgnExportTask::run()
+PgnExportTask::~PgnExportTask()
+{
+	delete m_it;
+	delete m_file;
+}
+
+void PgnExportTask::work()
 {
 	QTextStream out(m_file);
 
@@ -234,19 +244,14 @@ void PgnExportTask::run()
 		if (ok)
 		{
 			out << game;
-			if (++i % 512 == 0)
-			{
-				if (cancelRequested())
-					break;
-				emit progressValueChanged(i);
-			}
+			setProgress(++i);
+			if (cancelRequested())
+				break;
 		}
 	}
 
-	delete m_it;
-	delete m_file;
-
-	emit progressValueChanged(i);
+	out.flush();
+	m_file->close();
 }
 
 
@@ -257,6 +262,9 @@ GameDatabaseDialog::GameDatabaseDialog(GameDatabaseManager* dbManager, QWidget*
 	  m_dbManager(dbManager),
 	  m_pgnDatabaseModel(nullptr),
 	  m_pgnGameEntryModel(nullptr),
+	  m_gameCache(4096),
+	  m_loadingDatabase(-1),
+	  m_loadingRow(-1),
 	  ui(new Ui::GameDatabaseDialog)
 {
 	Q_ASSERT(dbManager != nullptr);
@@ -280,6 +288,9 @@ GameDatabaseDialog::GameDatabaseDialog(GameDatabaseManager* dbManager, QWidget*
 	ui->m_gamesListView->setModel(m_pgnGameEntryModel);
 	ui->m_gamesListView->setAlternatingRowColors(true);
 	ui->m_gamesListView->setUniformRowHeights(true);
+	// Games are listed in their original order until a column is clicked
+	ui->m_gamesListView->header()->setSortIndicator(-1, Qt::AscendingOrder);
+	ui->m_gamesListView->setSortingEnabled(true);
 
 	m_gameViewer = new GameViewer(Qt::Horizontal);
 	ui->m_viewerLayout->insertWidget(0, m_gameViewer);
@@ -318,6 +329,8 @@ GameDatabaseDialog::GameDatabaseDialog(GameDatabaseManager* dbManager, QWidget*
 		ui->m_copyFenBtn->setText(tr("Copy FEN"));
 	});
 
+	connect(ui->m_findPositionBtn, SIGNAL(clicked()), this, SLOT(findPosition()));
+
 	connect(ui->m_databasesListView->selectionModel(),
 		SIGNAL(selectionChanged(const QItemSelection&, const QItemSelection&)),
 		this, SLOT(databaseSelectionChanged(const QItemSelection&, const QItemSelection&)));
@@ -342,16 +355,24 @@ GameDatabaseDialog::GameDatabaseDialog(GameDatabaseManager* dbManager, QWidget*
 
 	m_searchTimer.setSingleShot(true);
 	connect(&m_searchTimer, SIGNAL(timeout()), this, SLOT(onSearchTimeout()));
+
+	connect(&m_loadWatcher, SIGNAL(finished()), this, SLOT(onGameLoaded()));
+	connect(&m_prefetchWatcher, SIGNAL(finished()),
+		this, SLOT(onGamesPrefetched()));
 }
 
 GameDatabaseDialog::~GameDatabaseDialog()
 {
+	cancelLoading();
 	delete ui;
 }
 
 void GameDatabaseDialog::databaseSelectionChanged(const QItemSelection& selected,
                                                   const QItemSelection& deselected)
 {
+	cancelLoading();
+	m_gameCache.clear();
+
 	const auto deselectedIndexes = deselected.indexes();
 	for (const QModelIndex& index : deselectedIndexes)
 		m_selectedDatabases.remove(index.row());
@@ -367,11 +388,15 @@ void GameDatabaseDialog::databaseSelectionChanged(const QItemSelection& selected
 	}
 
 	QList<const PgnGameEntry*> entries;
+	QList<const PgnGameEntryIndex*> indexes;
 	QMap<int, PgnDatabase*>::const_iterator it;
 	for (it = m_selectedDatabases.constBegin(); it != m_selectedDatabases.constEnd(); ++it)
+	{
 		entries.append(it.value()->entries());
+		indexes.append(it.value()->index());
+	}
 
-	m_pgnGameEntryModel->setEntries(entries);
+	m_pgnGameEntryModel->setEntries(entries, indexes);
 	ui->m_advancedSearchBtn->setEnabled(true);
 }
 
@@ -383,73 +408,193 @@ void GameDatabaseDialog::gameSelectionChanged(const QModelIndex& current,
 	if (!current.isValid())
 		return;
 
-	int databaseIndex;
-	if ((databaseIndex = databaseIndexFromGame(current.row())) == -1)
+	const GameSource source(gameSource(current.row()));
+	if (source.first == nullptr)
+		return;
+
+	m_prefetchGeneration.ref();
+	m_loadingRow = current.row();
+	m_loadingDatabase = databaseIndexFromGame(current.row());
+
+	const CompactPgnGame* game = m_gameCache.object(gameKey(source));
+	if (game != nullptr)
+	{
+		m_loadingKey = GameKey();
+		showGame(game->toPgnGame());
+		prefetchGames(current.row());
 		return;
+	}
 
-	PgnDatabase* selectedDatabase = m_dbManager->databases().at(databaseIndex);
+	// The result is ignored if another game is selected before
+	// the game has been read
+	m_loadingKey = gameKey(source);
+	m_loadWatcher.setFuture(QtConcurrent::run(&GameDatabaseDialog::readGame,
+						  source));
+}
 
-	PgnDatabase::Status status;
-	const PgnGameEntry* entry = m_pgnGameEntryModel->entryAt(current.row());
+GameDatabaseDialog::GameKey GameDatabaseDialog::gameKey(const GameSource& source)
+{
+	return qMakePair(source.first->fileName(), source.second->pos());
+}
 
-	if ((status = selectedDatabase->game(entry, &m_game)) != PgnDatabase::Ok)
+GameDatabaseDialog::GameSource GameDatabaseDialog::gameSource(int row) const
+{
+	int databaseIndex = databaseIndexFromGame(row);
+	if (databaseIndex == -1)
+		return GameSource(nullptr, nullptr);
+
+	return qMakePair(m_dbManager->databases().at(databaseIndex),
+			 m_pgnGameEntryModel->entryAt(row));
+}
+
+GameDatabaseDialog::LoadedGame GameDatabaseDialog::readGame(const GameSource& source)
+{
+	LoadedGame loaded;
+	loaded.key = gameKey(source);
+	loaded.status = source.first->game(source.second, &loaded.game);
+	return loaded;
+}
+
+QVector<GameDatabaseDialog::LoadedGame> GameDatabaseDialog::readGames(
+	const QVector<GameSource>& sources,
+	QAtomicInt* generation,
+	int expectedGeneration)
+{
+	QVector<LoadedGame> games;
+	for (const GameSource& source : sources)
+	{
+		if (generation->loadAcquire() != expectedGeneration)
+			break;
+		games.append(readGame(source));
+	}
+	return games;
+}
+
+void GameDatabaseDialog::onGameLoaded()
+{
+	LoadedGame loaded(m_loadWatcher.result());
+	if (loaded.key != m_loadingKey)
+		return;
+	m_loadingKey = GameKey();
+
+	if (loaded.status != PgnDatabase::Ok)
+	{
+		if (m_loadingDatabase != -1)
+			showLoadError(m_loadingDatabase, loaded.status);
+		return;
+	}
+
+	cacheGame(loaded.key, loaded.game);
+	showGame(loaded.game);
+	prefetchGames(m_loadingRow);
+}
+
+void GameDatabaseDialog::prefetchGames(int row)
+{
+	QVector<GameSource> sources;
+	for (int next : { row + 1, row - 1 })
 	{
-		if (status == PgnDatabase::DoesNotExist)
+		if (next < 0 || next >= m_pgnGameEntryModel->entryCount())
+			continue;
+
+		const GameSource source(gameSource(next));
+		if (source.first != nullptr && !m_gameCache.contains(gameKey(source)))
+			sources.append(source);
+	}
+	if (sources.isEmpty())
+		return;
+
+	m_prefetchWatcher.setFuture(QtConcurrent::run(&GameDatabaseDialog::readGames,
+		sources, &m_prefetchGeneration, m_prefetchGeneration.loadAcquire()));
+}
+
+void GameDatabaseDialog::onGamesPrefetched()
+{
+	const QVector<LoadedGame> games(m_prefetchWatcher.result());
+	for (const LoadedGame& loaded : games)
+	{
+		if (loaded.status == PgnDatabase::Ok)
+			cacheGame(loaded.key, loaded.game);
+	}
+}
+
+void GameDatabaseDialog::cacheGame(const GameKey& key, const PgnGame& game)
+{
+	auto compactGame = new CompactPgnGame(game);
+	m_gameCache.insert(key, compactGame,
+			   qMax(1, compactGame->memoryUsage() / 1024));
+}
+
+void GameDatabaseDialog::cancelLoading()
+{
+	m_prefetchGeneration.ref();
+	m_loadingKey = GameKey();
+	m_loadWatcher.waitForFinished();
+	m_prefetchWatcher.waitForFinished();
+}
+
+void GameDatabaseDialog::showLoadError(int databaseIndex, int status)
+{
+	PgnDatabase* database = m_dbManager->databases().at(databaseIndex);
+
+	if (status == PgnDatabase::DoesNotExist)
+	{
+		// Ask the user if the database should be deleted from the
+		// list
+		QMessageBox msgBox(this);
+		QPushButton* removeDbButton = msgBox.addButton(tr("Remove"),
+			QMessageBox::ActionRole);
+		msgBox.addButton(QMessageBox::Cancel);
+
+		msgBox.setText(tr("PGN database does not exist."));
+		msgBox.setInformativeText(tr("Remove %1 from the list of databases?").arg(database->displayName()));
+		msgBox.setDefaultButton(removeDbButton);
+		msgBox.setIcon(QMessageBox::Warning);
+
+		msgBox.exec();
+
+		if (msgBox.clickedButton() == removeDbButton)
+			m_dbManager->removeDatabase(databaseIndex);
+	}
+	else
+	{
+		// Ask the user to re-import the database
+		QMessageBox msgBox(this);
+		QPushButton* importDbButton = msgBox.addButton(tr("Import"),
+			QMessageBox::ActionRole);
+		msgBox.addButton(QMessageBox::Cancel);
+
+		if (status == PgnDatabase::Modified)
 		{
-			// Ask the user if the database should be deleted from the
-			// list
-			QMessageBox msgBox(this);
-			QPushButton* removeDbButton = msgBox.addButton(tr("Remove"),
-				QMessageBox::ActionRole);
-			msgBox.addButton(QMessageBox::Cancel);
-
-			msgBox.setText(tr("PGN database does not exist."));
-			msgBox.setInformativeText(tr("Remove %1 from the list of databases?").arg(selectedDatabase->displayName()));
-			msgBox.setDefaultButton(removeDbButton);
-			msgBox.setIcon(QMessageBox::Warning);
-
-			msgBox.exec();
-
-			if (msgBox.clickedButton() == removeDbButton)
-				m_dbManager->removeDatabase(databaseIndex);
+			msgBox.setText(tr("PGN database has been modified since the last import."));
+			msgBox.setInformativeText(tr("The database must be imported again to read it."));
 		}
 		else
 		{
-			// Ask the user to re-import the database
-			QMessageBox msgBox(this);
-			QPushButton* importDbButton = msgBox.addButton(tr("Import"),
-				QMessageBox::ActionRole);
-			msgBox.addButton(QMessageBox::Cancel);
-
-			if (status == PgnDatabase::Modified)
-			{
-				msgBox.setText(tr("PGN database has been modified since the last import."));
-				msgBox.setInformativeText(tr("The database must be imported again to read it."));
-			}
-			else
-			{
-				msgBox.setText(tr("Error occured while trying to read the PGN database."));
-				msgBox.setInformativeText(tr("Importing the database again may fix this problem."));
-			}
-
-			msgBox.setDefaultButton(importDbButton);
-			msgBox.setIcon(QMessageBox::Warning);
+			msgBox.setText(tr("Error occured while trying to read the PGN database."));
+			msgBox.setInformativeText(tr("Importing the database again may fix this problem."));
+		}
 
-			msgBox.exec();
+		msgBox.setDefaultButton(importDbButton);
+		msgBox.setIcon(QMessageBox::Warning);
 
-			if (msgBox.clickedButton() == importDbButton)
-				m_dbManager->importDatabaseAgain(databaseIndex);
-		}
+		msgBox.exec();
 
-		return;
+		if (msgBox.clickedButton() == importDbButton)
+			m_dbManager->importDatabaseAgain(databaseIndex);
 	}
+}
 
-	ui->m_whiteLabel->setText(m_game.tagValue("White"));
-	ui->m_blackLabel->setText(m_game.tagValue("Black"));
-	ui->m_siteLabel->setText(m_game.tagValue("Site"));
-	ui->m_eventLabel->setText(m_game.tagValue("Event"));
-	ui->m_resultLabel->setText(m_game.tagValue("Result"));
-	ui->m_variantLabel->setText(m_game.tagValue("Variant"));
+void GameDatabaseDialog::showGame(const PgnGame& game)
+{
+	m_game = game;
+
+	ui->m_whiteLabel->setText(m_game.tagValue(PgnGame::WhiteTag));
+	ui->m_blackLabel->setText(m_game.tagValue(PgnGame::BlackTag));
+	ui->m_siteLabel->setText(m_game.tagValue(PgnGame::SiteTag));
+	ui->m_eventLabel->setText(m_game.tagValue(PgnGame::EventTag));
+	ui->m_resultLabel->setText(m_game.tagValue(PgnGame::ResultTag));
+	ui->m_variantLabel->setText(m_game.tagValue(PgnGame::VariantTag));
 	ui->label_variant->setVisible(!ui->m_variantLabel->text().isEmpty());
 
 	m_gameViewer->setGame(&m_game);
@@ -489,7 +634,7 @@ int GameDatabaseDialog::databaseIndexFromGame(int game) const
 	QMap<int, PgnDatabase*>::const_iterator it;
 	for (it = m_selectedDatabases.constBegin(); it != m_selectedDatabases.constEnd(); ++it)
 	{
-		game -= it.value()->entries().count();
+		game -= it.value()->entryCount();
 		if (game < 0)
 			return it.key();
 	}
@@ -572,6 +717,49 @@ void GameDatabaseDialog::copyFen()
 	ui->m_copyFenBtn->setText(tr("Copied"));
 }
 
+void GameDatabaseDialog::findPosition()
+{
+	if (m_game.isNull() || m_gameViewer->board() == nullptr)
+		return;
+
+	const quint64 key = m_gameViewer->board()->key();
+	QVector<int> games;
+	bool indexed = false;
+	int offset = 0;
+
+	QMap<int, PgnDatabase*>::const_iterator it;
+	for (it = m_selectedDatabases.constBegin(); it != m_selectedDatabases.constEnd(); ++it)
+	{
+		const int count = it.value()->entryCount();
+		PositionIndex index(m_dbManager->positionIndexFile(it.value()->fileName()));
+		if (index.isValid())
+		{
+			indexed = true;
+			const QVector<int> dbGames = index.games(key);
+			for (int game : dbGames)
+			{
+				if (game < count)
+					games.append(offset + game);
+			}
+		}
+		offset += count;
+	}
+
+	if (!indexed)
+	{
+		QMessageBox::information(this, tr("Find position"),
+			tr("The positions of the selected databases are not indexed.\n"
+			   "Enable position indexing in the settings and import "
+			   "the databases again."));
+		return;
+	}
+
+	ui->m_searchEdit->setText(tr("[Position search]"));
+	ui->m_searchEdit->setEnabled(false);
+	m_pgnGameEntryModel->setEntrySubset(games);
+	ui->m_clearBtn->setEnabled(true);
+}
+
 void GameDatabaseDialog::updateUi()
 {
 	bool enable = m_pgnGameEntryModel->rowCount() > 0;
@@ -579,6 +767,7 @@ void GameDatabaseDialog::updateUi()
 	ui->m_exportBtn->setEnabled(enable);
 	ui->m_copyGameBtn->setEnabled(enable);
 	ui->m_copyFenBtn->setEnabled(enable);
+	ui->m_findPositionBtn->setEnabled(enable);
 }
 
 #include "gamedatabasedlg.moc"
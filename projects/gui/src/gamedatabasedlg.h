@@ -22,12 +22,18 @@
 #include <QDialog>
 #include <QTimer>
 #include <QItemSelection>
+#include <QFutureWatcher>
+#include <QCache>
+#include <QPair>
+#include <QAtomicInt>
 
 #include <pgngame.h>
+#include <compactpgngame.h>
 
 class GameDatabaseManager;
 class PgnDatabaseModel;
 class PgnGameEntryModel;
+class PgnGameEntry;
 class PgnDatabase;
 class GameViewer;
 
@@ -38,6 +44,9 @@ namespace Ui {
 /*!
  * \brief Dialog for viewing game databases.
  *
+ * The selected game is read from its database in a worker thread,
+ * and the games next to it are read in advance.
+ *
  * \sa GameDatabaseManager
  */
 class GameDatabaseDialog : public QDialog
@@ -63,11 +72,38 @@ class GameDatabaseDialog : public QDialog
 		void createOpeningBook();
 		void copyGame();
 		void copyFen();
+		void findPosition();
 		void updateUi();
+		void onGameLoaded();
+		void onGamesPrefetched();
 
 	private:
 		friend class PgnGameIterator;
+
+		// A game's database and its entry in the database
+		typedef QPair<PgnDatabase*, const PgnGameEntry*> GameSource;
+		// A game's file name and position in the file
+		typedef QPair<QString, qint64> GameKey;
+
+		struct LoadedGame
+		{
+			GameKey key;
+			int status;
+			PgnGame game;
+		};
+
 		int databaseIndexFromGame(int game) const;
+		GameSource gameSource(int row) const;
+		static GameKey gameKey(const GameSource& source);
+		static LoadedGame readGame(const GameSource& source);
+		static QVector<LoadedGame> readGames(const QVector<GameSource>& sources,
+						     QAtomicInt* generation,
+						     int expectedGeneration);
+		void prefetchGames(int row);
+		void cancelLoading();
+		void showLoadError(int databaseIndex, int status);
+		void showGame(const PgnGame& game);
+		void cacheGame(const GameKey& key, const PgnGame& game);
 
 		GameViewer* m_gameViewer;
 		PgnGame m_game;
@@ -80,6 +116,15 @@ class GameDatabaseDialog : public QDialog
 
 		QTimer m_searchTimer;
 		QString m_searchTerms;
+		QFutureWatcher<LoadedGame> m_loadWatcher;
+		QFutureWatcher<QVector<LoadedGame>> m_prefetchWatcher;
+		// Packed games; the cost is their memory usage in KiB
+		QCache<GameKey, CompactPgnGame> m_gameCache;
+		GameKey m_loadingKey;
+		int m_loadingDatabase;
+		int m_loadingRow;
+		// Incremented to cancel prefetching
+		QAtomicInt m_prefetchGeneration;
 		Ui::GameDatabaseDialog* ui;
 };
 
@@ -19,8 +19,11 @@
 #include "gamedatabasemanager.h"
 
 #include <QFileInfo>
+#include <QDir>
 #include <QDataStream>
-#include <QThreadPool>
+#include <QSaveFile>
+#include <QSettings>
+#include <QCryptographicHash>
 
 #include <pgngameentry.h>
 
@@ -28,9 +31,10 @@
 #include "pgnimporter.h"
 #include "importprogressdlg.h"
 #include "cutechessapp.h"
+#include "taskpool.h"
 
 #define GAME_DATABASE_STATE_MAGIC   0xDEADD00D
-#define GAME_DATABASE_STATE_VERSION 1
+#define GAME_DATABASE_STATE_VERSION 3
 
 GameDatabaseManager::GameDatabaseManager(QObject* parent)
 	: QObject(parent),
@@ -50,9 +54,11 @@ QList<PgnDatabase*> GameDatabaseManager::databases() const
 
 bool GameDatabaseManager::writeState(const QString& fileName)
 {
-	QFile stateFile(fileName);
+	// Deferred entries are copied from the old file, so it's
+	// replaced only after the new one is complete
+	QSaveFile stateFile(fileName);
 
-	if (!stateFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	if (!stateFile.open(QIODevice::WriteOnly))
 		return false;
 
 	QDataStream out(&stateFile);
@@ -65,17 +71,38 @@ bool GameDatabaseManager::writeState(const QString& fileName)
 	// Write the number of databases
 	out << (qint32)m_databases.count();
 
-	// Write the contents of the databases
+	// Write the contents of the databases. The entries of each
+	// database are in a block of their own, so that readState()
+	// can skip them.
+	QList<QPair<qint64, qint64>> entryBlocks;
 	for (const PgnDatabase* db : qAsConst(m_databases))
 	{
 		out << db->fileName();
 		out << db->lastModified();
 		out << db->displayName();
-		out << (qint32)db->entries().count();
+		out << db->indexedSize();
+		out << db->nextLineNumber();
+		out << db->tailChecksum();
+		out << (qint32)db->entryCount();
+
+		const QByteArray entryData = db->entryData();
+		out << (qint64)entryData.size();
+		entryBlocks << qMakePair(stateFile.pos(), qint64(entryData.size()));
+		out.writeRawData(entryData.constData(), entryData.size());
+	}
 
-		const auto entries = db->entries();
-		for (const PgnGameEntry* entry : entries)
-			entry->write(out);
+	if (out.status() != QDataStream::Ok || !stateFile.commit())
+		return false;
+
+	// Deferred entries are now read from the new file
+	for (int i = 0; i < m_databases.size(); i++)
+	{
+		PgnDatabase* db = m_databases.at(i);
+		if (db->hasDeferredEntries())
+			db->setDeferredEntries(fileName,
+					       entryBlocks.at(i).first,
+					       entryBlocks.at(i).second,
+					       db->entryCount());
 	}
 
 	m_modified = false;
@@ -107,10 +134,10 @@ bool GameDatabaseManager::readState(const QString& fileName)
 	quint32 version;
 	in >> version;
 
-	if (version < GAME_DATABASE_STATE_VERSION ||
-	    version > GAME_DATABASE_STATE_VERSION)
+	// Version 1 files have no indexed range, so their databases
+	// are imported again in full if they have been modified
+	if (version < 1 || version > GAME_DATABASE_STATE_VERSION)
 	{
-		// TODO: Add backward compatibility
 		qWarning("GameDatabaseManager: state file version mismatch");
 		return false;
 	}
@@ -125,59 +152,110 @@ bool GameDatabaseManager::readState(const QString& fileName)
 	QString dbDisplayName;
 	QList<PgnDatabase*> readDatabases;
 
+	QList<PgnDatabase*> appendedDatabases;
+
 	for (int i = 0; i < dbCount; i++)
 	{
 		in >> dbFileName;
 		in >> dbLastModified;
 		in >> dbDisplayName;
 
+		qint64 dbIndexedSize = 0;
+		qint64 dbNextLineNumber = 1;
+		QByteArray dbTailChecksum;
+		if (version >= 2)
+		{
+			in >> dbIndexedSize;
+			in >> dbNextLineNumber;
+			in >> dbTailChecksum;
+		}
+
+		qint32 dbEntryCount;
+		in >> dbEntryCount;
+
+		PgnDatabase* db = new PgnDatabase(dbFileName);
+
+		// Since version 3 the entries are read when they're first
+		// needed, so startup time doesn't depend on their number
+		if (version >= 3)
+		{
+			qint64 dataSize;
+			in >> dataSize;
+			const qint64 offset = stateFile.pos();
+			if (in.skipRawData(int(dataSize)) != dataSize)
+			{
+				qWarning("GameDatabaseManager: truncated state file");
+				delete db;
+				break;
+			}
+			db->setDeferredEntries(fileName, offset, dataSize,
+					       dbEntryCount);
+		}
+		else
+		{
+			QList<const PgnGameEntry*> entries;
+			for (int j = 0; j < dbEntryCount; j++)
+			{
+				PgnGameEntry* entry = new PgnGameEntry;
+				entry->read(in);
+				entries << entry;
+			}
+			db->setEntries(entries);
+		}
+
+		db->setLastModified(dbLastModified);
+		db->setDisplayName(dbDisplayName);
+		db->setIndexedRange(dbIndexedSize, dbNextLineNumber,
+				    dbTailChecksum);
+
 		// Check if the database exists
 		QFileInfo fileInfo(dbFileName);
 		if (!fileInfo.exists())
 		{
 			m_modified = true;
+			delete db;
 			continue;
 		}
 
-		// Check if the database has been modified
+		// Check if the database has been modified. If games were
+		// only appended to it, index just the new games.
 		if (fileInfo.lastModified() > dbLastModified)
 		{
 			m_modified = true;
-			importPgnFile(dbFileName);
-			continue;
-		}
-
-		qint32 dbEntryCount;
-		in >> dbEntryCount;
-
-		// Read the entries
-		QList<const PgnGameEntry*> entries;
-		for (int j = 0; j < dbEntryCount; j++)
-		{
-			PgnGameEntry* entry = new PgnGameEntry;
-			entry->read(in);
-			entries << entry;
+			if (!db->canAppend())
+			{
+				delete db;
+				importPgnFile(dbFileName);
+				continue;
+			}
+			appendedDatabases << db;
 		}
 
-		PgnDatabase* db = new PgnDatabase(dbFileName);
-		db->setEntries(entries);
-		db->setLastModified(dbLastModified);
-		db->setDisplayName(dbDisplayName);
-
 		readDatabases << db;
 	}
 
-	m_modified = false;
+	// Older files are converted to the current format
+	m_modified = (version < GAME_DATABASE_STATE_VERSION);
 
 	m_databases = readDatabases;
 	emit databasesReset();
 
+	for (PgnDatabase* db : qAsConst(appendedDatabases))
+		importPgnTail(db);
+
 	return true;
 }
 
 void GameDatabaseManager::importPgnFile(const QString& fileName)
 {
 	PgnImporter* pgnImporter = new PgnImporter(fileName);
+
+	const QString indexFile = positionIndexFile(fileName);
+	if (QSettings().value("games/index_positions", false).toBool()
+	&&  QDir().mkpath(QFileInfo(indexFile).absolutePath()))
+		pgnImporter->setPositionIndex(indexFile);
+	else
+		QFile::remove(indexFile);
 	connect(pgnImporter, SIGNAL(databaseRead(PgnDatabase*)),
 		this, SLOT(addDatabase(PgnDatabase*)));
 
@@ -186,7 +264,64 @@ void GameDatabaseManager::importPgnFile(const QString& fileName)
 	dlg->raise();
 	dlg->activateWindow();
 
-	QThreadPool::globalInstance()->start(pgnImporter);
+	TaskPool::start(pgnImporter, TaskPool::Bulk);
+}
+
+void GameDatabaseManager::importPgnTail(const PgnDatabase* database)
+{
+	PgnImporter* pgnImporter = new PgnImporter(database->fileName(),
+						   database->indexedSize(),
+						   database->nextLineNumber());
+
+	// Positions are added to an existing index only, an index
+	// without the earlier games would be incomplete
+	const QString indexFile = positionIndexFile(database->fileName());
+	if (QSettings().value("games/index_positions", false).toBool()
+	&&  QFile::exists(indexFile))
+		pgnImporter->setPositionIndex(indexFile,
+					      database->entryCount());
+	else
+		QFile::remove(indexFile);
+
+	connect(pgnImporter, SIGNAL(databaseRead(PgnDatabase*)),
+		this, SLOT(appendDatabase(PgnDatabase*)));
+
+	auto dlg = new ImportProgressDialog(pgnImporter);
+	dlg->show();
+	dlg->raise();
+	dlg->activateWindow();
+
+	TaskPool::start(pgnImporter, TaskPool::Bulk);
+}
+
+void GameDatabaseManager::appendDatabase(PgnDatabase* tail)
+{
+	int index = -1;
+	for (int i = 0; i < m_databases.count(); i++)
+	{
+		if (m_databases.at(i)->fileName() == tail->fileName())
+		{
+			index = i;
+			break;
+		}
+	}
+	// The database was removed while its new games were indexed
+	if (index == -1)
+	{
+		delete tail;
+		return;
+	}
+
+	PgnDatabase* db = m_databases.at(index);
+	removeDatabase(index);
+
+	db->appendEntries(tail->takeEntries());
+	db->setLastModified(tail->lastModified());
+	db->setIndexedRange(tail->indexedSize(), tail->nextLineNumber(),
+			    tail->tailChecksum());
+	delete tail;
+
+	addDatabase(db);
 }
 
 void GameDatabaseManager::addDatabase(PgnDatabase* database)
@@ -205,7 +340,14 @@ void GameDatabaseManager::removeDatabase(int index)
 
 void GameDatabaseManager::importDatabaseAgain(int index)
 {
-	const QString fileName = m_databases.at(index)->fileName();
+	const PgnDatabase* db = m_databases.at(index);
+	if (db->canAppend())
+	{
+		importPgnTail(db);
+		return;
+	}
+
+	const QString fileName = db->fileName();
 
 	removeDatabase(index);
 	importPgnFile(fileName);
@@ -216,6 +358,18 @@ bool GameDatabaseManager::isModified() const
 	return m_modified;
 }
 
+QString GameDatabaseManager::positionIndexFile(const QString& databaseFileName) const
+{
+	// The index files are named after a hash of the database path
+	const QString path = QFileInfo(databaseFileName).absoluteFilePath();
+	const QByteArray hash = QCryptographicHash::hash(path.toUtf8(),
+		QCryptographicHash::Sha1).toHex();
+
+	return CuteChessApplication::instance()->configPath()
+		+ QLatin1String("/positions/") + QString::fromLatin1(hash)
+		+ QLatin1String(".idx");
+}
+
 void GameDatabaseManager::setModified(bool modified)
 {
 	m_modified = modified;
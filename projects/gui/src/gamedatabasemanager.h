@@ -54,6 +54,10 @@ class GameDatabaseManager : public QObject
 		/*!
 		 * Reads the state from a file pointed by \a fileName.
 		 *
+		 * Only the database headers are read. The game entries of
+		 * each database are read from the file when they're first
+		 * needed, so the file must not be modified by others.
+		 *
 		 * \sa writeState
 		 */
 		bool readState(const QString& fileName);
@@ -64,6 +68,17 @@ class GameDatabaseManager : public QObject
 		/*! Sets the state modified flag to \a modified. */
 		void setModified(bool modified);
 
+		/*!
+		 * Returns the name of the position index file of the
+		 * database whose file name is \a databaseFileName.
+		 *
+		 * The file exists only if the database was imported with
+		 * the "games/index_positions" setting enabled.
+		 *
+		 * \sa PositionIndex
+		 */
+		QString positionIndexFile(const QString& databaseFileName) const;
+
 	public slots:
 		/*! Adds \a database to the list of managed databases. */
 		void addDatabase(PgnDatabase* database);
@@ -75,6 +90,9 @@ class GameDatabaseManager : public QObject
 		/*!
 		 * Re-imports database at \a index from the list of managed
 		 * databases.
+		 *
+		 * If games were only appended to the database file, only
+		 * the new games are imported.
 		 */
 		void importDatabaseAgain(int index);
 		/*!
@@ -108,7 +126,12 @@ class GameDatabaseManager : public QObject
 		 */
 		void databasesReset();
 
+	private slots:
+		void appendDatabase(PgnDatabase* tail);
+
 	private:
+		void importPgnTail(const PgnDatabase* database);
+
 		QList<PgnDatabase*> m_databases;
 		bool m_modified;
 
@@ -22,12 +22,15 @@
 #include <QToolButton>
 #include <QSlider>
 #include <QMessageBox>
+#include <climits>
 #include <pgngame.h>
 #include <chessgame.h>
 #include <chessplayer.h>
+#include <board/board.h>
 #include "boardview/boardscene.h"
 #include "boardview/boardview.h"
 #include "chessclock.h"
+#include "guiprofiler.h"
 
 GameViewer::GameViewer(Qt::Orientation orientation,
                        QWidget* parent,
@@ -38,7 +41,9 @@ GameViewer::GameViewer(Qt::Orientation orientation,
 	  m_viewPreviousMoveBtn(new QToolButton),
 	  m_viewNextMoveBtn(new QToolButton),
 	  m_viewLastMoveBtn(new QToolButton),
-	  m_moveIndex(0)
+	  m_moveIndex(0),
+	  m_baseIndex(0),
+	  m_snapshotBoard(nullptr)
 {
 	#ifdef Q_OS_MAC
 	setStyleSheet("QToolButton:!hover { border: none; }");
@@ -134,6 +139,11 @@ GameViewer::GameViewer(Qt::Orientation orientation,
 	setLayout(layout);
 }
 
+GameViewer::~GameViewer()
+{
+	delete m_snapshotBoard;
+}
+
 ChessClock* GameViewer::chessClock(Chess::Side side)
 {
 	return m_chessClock[side];
@@ -143,13 +153,15 @@ void GameViewer::setGame(ChessGame* game)
 {
 	Q_ASSERT(game != nullptr);
 
-	setGame(game->pgn());
+	disconnectGame();
 	m_game = game;
 
+	// The signals are connected before the game's snapshot is read,
+	// and onMoveMade() skips the moves that are in the snapshot
 	connect(m_game, SIGNAL(fenChanged(QString)),
 		this, SLOT(onFenChanged(QString)));
-	connect(m_game, SIGNAL(moveMade(Chess::GenericMove, QString, QString)),
-		this, SLOT(onMoveMade(Chess::GenericMove)));
+	connect(m_game, SIGNAL(moveMade(MoveEvent)),
+		this, SLOT(onMoveMade(MoveEvent)));
 	connect(m_game, SIGNAL(humanEnabled(bool)),
 		m_boardView, SLOT(setEnabled(bool)));
 
@@ -163,8 +175,21 @@ void GameViewer::setGame(ChessGame* game)
 
 	connect(m_game, SIGNAL(finished(ChessGame*, Chess::Result)),
 		m_boardScene, SLOT(onGameFinished(ChessGame*, Chess::Result)));
-	m_boardView->setEnabled(!m_game->isFinished() &&
-				m_game->playerToMove()->isHuman());
+
+	const ChessGame::SharedSnapshot snapshot(game->snapshot());
+	if (snapshot.isNull())
+	{
+		// The game hasn't started, and fenChanged() will bring
+		// its starting position
+		PgnGame pgn;
+		pgn.setVariant(game->board()->variant());
+		showPgn(&pgn);
+		return;
+	}
+
+	showPgn(&snapshot->pgn);
+	m_boardView->setEnabled(!snapshot->finished &&
+				game->player(snapshot->sideToMove)->isHuman());
 }
 
 void GameViewer::setGame(const PgnGame* pgn)
@@ -172,7 +197,11 @@ void GameViewer::setGame(const PgnGame* pgn)
 	Q_ASSERT(pgn != nullptr);
 
 	disconnectGame();
+	showPgn(pgn);
+}
 
+void GameViewer::showPgn(const PgnGame* pgn)
+{
 	auto board = pgn->createBoard();
 	if (board)
 	{
@@ -186,10 +215,20 @@ void GameViewer::setGame(const PgnGame* pgn)
 			tr("This game is incompatible with Cute Chess and cannot be shown."));
 	}
 	m_moveIndex = 0;
+	m_baseIndex = 0;
 
 	m_moves.clear();
+	m_snapshots.clear();
+	delete m_snapshotBoard;
+	m_snapshotBoard = pgn->createBoard();
+	if (m_snapshotBoard != nullptr)
+		m_snapshots.append(m_snapshotBoard->fenString());
+
 	for (const PgnGame::MoveData& md : pgn->moves())
+	{
 		m_moves.append(md.move);
+		addSnapshotMove(md.move);
+	}
 
 	m_viewFirstMoveBtn->setEnabled(false);
 	m_viewPreviousMoveBtn->setEnabled(false);
@@ -200,7 +239,66 @@ void GameViewer::setGame(const PgnGame* pgn)
 	m_moveNumberSlider->setMaximum(m_moves.count());
 	m_moveNumberSlider->setValue(0);
 
-	viewLastMove();
+	seek(m_moves.count(), false);
+}
+
+void GameViewer::addSnapshotMove(const Chess::GenericMove& move)
+{
+	if (m_snapshotBoard == nullptr)
+		return;
+
+	m_snapshotBoard->makeMove(m_snapshotBoard->moveFromGenericMove(move));
+	if (m_moves.count() % SnapshotInterval == 0)
+		m_snapshots.append(m_snapshotBoard->fenString());
+}
+
+void GameViewer::seek(int index, bool animate)
+{
+	Q_ASSERT(index >= 0 && index <= m_moves.count());
+
+	// Restart from the nearest snapshot if it takes fewer moves
+	// than going back or forth from the current position
+	int snapshot = qMin(index / SnapshotInterval, m_snapshots.count() - 1);
+	int distance = qAbs(index - m_moveIndex);
+	if (index < m_baseIndex)
+		distance = INT_MAX;
+	if (snapshot >= 0 && index - snapshot * SnapshotInterval + 1 < distance)
+	{
+		m_boardScene->setFenString(m_snapshots.at(snapshot));
+		m_moveIndex = m_baseIndex = snapshot * SnapshotInterval;
+		updateControls();
+	}
+
+	// Only the last transition is animated
+	m_boardScene->setAnimated(false);
+	while (index < m_moveIndex)
+	{
+		if (index == m_moveIndex - 1)
+			m_boardScene->setAnimated(animate);
+		viewPreviousMove();
+	}
+	while (index > m_moveIndex)
+	{
+		if (index == m_moveIndex + 1)
+			m_boardScene->setAnimated(animate);
+		viewNextMove();
+	}
+	m_boardScene->setAnimated(true);
+}
+
+void GameViewer::updateControls()
+{
+	bool atStart = m_moveIndex <= 0;
+	bool atEnd = m_moveIndex >= m_moves.count();
+	m_viewFirstMoveBtn->setEnabled(!atStart);
+	m_viewPreviousMoveBtn->setEnabled(!atStart);
+	m_viewNextMoveBtn->setEnabled(!atEnd);
+	m_viewLastMoveBtn->setEnabled(!atEnd);
+
+	m_boardView->setEnabled(atEnd && !m_game.isNull()
+				&& !m_game->isFinished()
+				&& m_game->playerToMove()->isHuman());
+	m_moveNumberSlider->setSliderPosition(m_moveIndex);
 }
 
 void GameViewer::disconnectGame()
@@ -241,8 +339,7 @@ void GameViewer::viewFirstMoveClicked()
 
 void GameViewer::viewFirstMove()
 {
-	while (m_moveIndex > 0)
-		viewPreviousMove();
+	seek(0);
 }
 
 void GameViewer::viewPreviousMoveClicked()
@@ -253,6 +350,14 @@ void GameViewer::viewPreviousMoveClicked()
 
 void GameViewer::viewPreviousMove()
 {
+	// The moves before the scene's first position are not in
+	// its history
+	if (m_moveIndex == m_baseIndex)
+	{
+		seek(m_moveIndex - 1, false);
+		return;
+	}
+
 	m_moveIndex--;
 
 	if (m_moveIndex == 0)
@@ -304,8 +409,7 @@ void GameViewer::viewLastMoveClicked()
 
 void GameViewer::viewLastMove()
 {
-	while (m_moveIndex < m_moves.count())
-		viewNextMove();
+	seek(m_moves.count());
 }
 
 void GameViewer::viewPositionClicked(int index)
@@ -319,10 +423,7 @@ void GameViewer::viewPosition(int index)
 	if (m_moves.isEmpty())
 		return;
 
-	while (index < m_moveIndex)
-		viewPreviousMove();
-	while (index > m_moveIndex)
-		viewNextMove();
+	seek(index);
 }
 
 void GameViewer::viewMove(int index, bool keyLeft)
@@ -336,19 +437,16 @@ void GameViewer::viewMove(int index, bool keyLeft)
 	{
 		// We backtrack one move too far and then make one
 		// move forward to highlight the correct move
-		while (index < m_moveIndex)
-			viewPreviousMove();
+		seek(index, false);
 		viewNextMove();
 	}
 	else
-	{
-		while (index + 1 > m_moveIndex)
-			viewNextMove();
-	}
+		seek(index + 1);
 }
 
 void GameViewer::onFenChanged(const QString& fen)
 {
+	GuiProfilerScope profile("GameViewer::onFenChanged");
 	m_moves.clear();
 	m_moveIndex = 0;
 
@@ -360,11 +458,27 @@ void GameViewer::onFenChanged(const QString& fen)
 	m_moveNumberSlider->setMaximum(0);
 
 	m_boardScene->setFenString(fen);
+
+	m_baseIndex = 0;
+	m_snapshots.clear();
+	if (m_snapshotBoard != nullptr && m_snapshotBoard->setFenString(fen))
+		m_snapshots.append(fen);
+	else
+	{
+		delete m_snapshotBoard;
+		m_snapshotBoard = nullptr;
+	}
 }
 
-void GameViewer::onMoveMade(const Chess::GenericMove& move)
+void GameViewer::onMoveMade(const MoveEvent& event)
 {
+	GuiProfilerScope profile("GameViewer::onMoveMade");
+	if (event.ply() < m_moves.size())
+		return;
+
+	const Chess::GenericMove move(event.move());
 	m_moves.append(move);
+	addSnapshotMove(move);
 
 	m_moveNumberSlider->setEnabled(true);
 	m_moveNumberSlider->setMaximum(m_moves.count());
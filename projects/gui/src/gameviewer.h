@@ -24,6 +24,7 @@
 #include <QPointer>
 #include <board/side.h>
 #include <board/genericmove.h>
+#include <moveevent.h>
 class QToolButton;
 class QSlider;
 class ChessGame;
@@ -44,6 +45,7 @@ class GameViewer : public QWidget
 		explicit GameViewer(Qt::Orientation orientation = Qt::Horizontal,
 		                    QWidget* parent = nullptr,
 		                    bool addChessClock = false);
+		virtual ~GameViewer();
 
 		void setGame(ChessGame* game);
 		void setGame(const PgnGame* pgn);
@@ -66,7 +68,7 @@ class GameViewer : public QWidget
 		void viewPositionClicked(int index);
 
 		void onFenChanged(const QString& fen);
-		void onMoveMade(const Chess::GenericMove& move);
+		void onMoveMade(const MoveEvent& event);
 
 	private:
 		void viewFirstMove();
@@ -74,6 +76,13 @@ class GameViewer : public QWidget
 		void viewNextMove();
 		void viewLastMove();
 		void viewPosition(int index);
+		void seek(int index, bool animate = true);
+		void updateControls();
+		void showPgn(const PgnGame* pgn);
+		void addSnapshotMove(const Chess::GenericMove& move);
+
+		// Number of plies between board snapshots
+		enum { SnapshotInterval = 16 };
 
 		BoardScene* m_boardScene;
 		BoardView* m_boardView;
@@ -88,6 +97,11 @@ class GameViewer : public QWidget
 		QPointer<ChessGame> m_game;
 		QVector<Chess::GenericMove> m_moves;
 		int m_moveIndex;
+		// Ply of the first position in the board scene's history
+		int m_baseIndex;
+		// Positions at every SnapshotInterval plies
+		QVector<QString> m_snapshots;
+		Chess::Board* m_snapshotBoard;
 };
 
 #endif // GAMEVIEWER_H
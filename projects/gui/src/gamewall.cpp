@@ -19,16 +19,21 @@
 #include "gamewall.h"
 
 #include <QPointer>
+#include <QSettings>
 
 #include <chessplayer.h>
 #include <chessgame.h>
 #include <gamemanager.h>
+#include <livegameclient.h>
+#include <board/board.h>
+#include <board/boardfactory.h>
 
 #include "tilelayout.h"
 #include "boardview/boardscene.h"
 #include "boardview/boardview.h"
 #include "chessclock.h"
 #include "cutechessapp.h"
+#include "guiprofiler.h"
 
 
 class GameWallWidget : public QWidget
@@ -40,16 +45,49 @@ class GameWallWidget : public QWidget
 		virtual ~GameWallWidget();
 
 		void setGame(ChessGame* game);
+		// Shows a game of a remote LiveGameFeed. The moves are
+		// added with addRemoteMove().
+		void setRemoteGame(const QString& variant,
+				   const QString& fen,
+				   const QString& white,
+				   const QString& black,
+				   int whiteTime,
+				   int blackTime);
+		void addRemoteMove(const QString& san, int timeLeft);
+		void finishRemoteGame(const QString& result);
+		// Shows the moves made since the last call. Only the
+		// last move is animated, and only if \a animate is true.
+		void showPendingMoves(bool animate);
+
+	signals:
+		void updateNeeded();
+
+	private slots:
+		void onFenChanged(const QString& fenString);
+		void onMoveMade(const MoveEvent& event);
+		void onGameFinished(ChessGame* game, Chess::Result result);
 
 	private:
 		ChessClock* m_clocks[2];
 		BoardScene* m_scene;
 		BoardView* m_view;
 		QPointer<ChessPlayer> m_players[2];
+		QPointer<ChessGame> m_game;
+		// The ply of the next move of m_game; the earlier moves
+		// were read from the game's snapshot
+		int m_nextPly;
+		// The position of a remote game, ahead of the scene's
+		// board by the pending moves
+		Chess::Board* m_remoteBoard;
+		int m_remoteTime[2];
+		QString m_pendingFen;
+		QList<Chess::GenericMove> m_pendingMoves;
 };
 
 GameWallWidget::GameWallWidget(QWidget* parent)
-	: QWidget(parent)
+	: QWidget(parent),
+	  m_nextPly(0),
+	  m_remoteBoard(nullptr)
 {
 	QHBoxLayout* clockLayout = new QHBoxLayout();
 	for (int i = 0; i < 2; i++)
@@ -66,6 +104,8 @@ GameWallWidget::GameWallWidget(QWidget* parent)
 
 	m_scene = new BoardScene(this);
 	m_view = new BoardView(m_scene);
+	if (QSettings().value("ui/game_wall_opengl", false).toBool())
+		m_view->setAccelerated(true);
 
 	QVBoxLayout* mainLayout = new QVBoxLayout();
 	mainLayout->addLayout(clockLayout);
@@ -77,19 +117,28 @@ GameWallWidget::GameWallWidget(QWidget* parent)
 
 GameWallWidget::~GameWallWidget()
 {
+	delete m_remoteBoard;
 }
 
 void GameWallWidget::setGame(ChessGame* game)
 {
-	game->lockThread();
+	if (m_game)
+		m_game->disconnect(this);
+	m_game = game;
+	m_pendingFen.clear();
+	m_pendingMoves.clear();
+
+	// Position changes are collected and shown by showPendingMoves().
+	// The signals are connected before the game's snapshot is read,
+	// so no move is missed and the game's thread isn't paused.
 	connect(game, SIGNAL(fenChanged(QString)),
-		m_scene, SLOT(setFenString(QString)));
-	connect(game, SIGNAL(moveMade(Chess::GenericMove, QString, QString)),
-		m_scene, SLOT(makeMove(Chess::GenericMove)));
+		this, SLOT(onFenChanged(QString)));
+	connect(game, SIGNAL(moveMade(MoveEvent)),
+		this, SLOT(onMoveMade(MoveEvent)));
 	connect(game, SIGNAL(humanEnabled(bool)),
 		m_view, SLOT(setEnabled(bool)));
 	connect(game, SIGNAL(finished(ChessGame*, Chess::Result)),
-		m_scene, SLOT(onGameFinished(ChessGame*, Chess::Result)));
+		this, SLOT(onGameFinished(ChessGame*, Chess::Result)));
 
 	for (int i = 0; i < 2; i++)
 	{
@@ -106,33 +155,168 @@ void GameWallWidget::setGame(ChessGame* game)
 		m_clocks[i]->setPlayerName(player->name());
 		connect(player, SIGNAL(nameChanged(QString)),
 			m_clocks[i], SLOT(setPlayerName(QString)));
-
-		m_clocks[i]->setInfiniteTime(player->timeControl()->isInfinite());
-
-		if (player->state() == ChessPlayer::Thinking)
-			m_clocks[i]->start(player->timeControl()->activeTimeLeft());
-		else
-			m_clocks[i]->setTime(player->timeControl()->timeLeft());
-
 		connect(player, SIGNAL(startedThinking(int)),
 			m_clocks[i], SLOT(start(int)));
 		connect(player, SIGNAL(stoppedThinking()),
 			m_clocks[i], SLOT(stop()));
 	}
 
-	m_scene->setBoard(game->pgn()->createBoard());
+	m_nextPly = 0;
+	const ChessGame::SharedSnapshot snapshot(game->snapshot());
+	if (snapshot.isNull())
+	{
+		// The game hasn't started, and fenChanged() will bring
+		// its starting position
+		Chess::Board* board = Chess::BoardFactory::create(game->board()->variant());
+		board->reset();
+		m_scene->setBoard(board);
+		m_scene->populate();
+		if (game->boardShouldBeFlipped())
+			m_scene->flip();
+		m_view->setEnabled(false);
+		return;
+	}
+
+	m_scene->setBoard(snapshot->pgn.createBoard());
 	m_scene->populate();
 
 	if (game->boardShouldBeFlipped())
 		m_scene->flip();
 
-	for (const Chess::Move& move : game->moves())
-		m_scene->makeMove(move);
+	const auto moves = snapshot->pgn.moves();
+	for (const PgnGame::MoveData& md : moves)
+		m_scene->makeMove(md.move);
+	m_nextPly = moves.size();
+
+	for (int i = 0; i < 2; i++)
+	{
+		Chess::Side side = Chess::Side::Type(i);
+		m_clocks[i]->setPlayerName(snapshot->pgn.playerName(side));
+		m_clocks[i]->setInfiniteTime(snapshot->infiniteTime[i]);
+		if (snapshot->thinkingSide == side)
+			m_clocks[i]->start(snapshot->currentTimeLeft(side));
+		else
+			m_clocks[i]->setTime(snapshot->timeLeft[i]);
+	}
+
+	m_view->setEnabled(!snapshot->finished &&
+			   game->player(snapshot->sideToMove)->isHuman());
+}
+
+void GameWallWidget::setRemoteGame(const QString& variant,
+				   const QString& fen,
+				   const QString& white,
+				   const QString& black,
+				   int whiteTime,
+				   int blackTime)
+{
+	m_pendingFen.clear();
+	m_pendingMoves.clear();
+
+	delete m_remoteBoard;
+	m_remoteBoard = Chess::BoardFactory::create(variant);
+	Chess::Board* board = Chess::BoardFactory::create(variant);
+	if (m_remoteBoard == nullptr || board == nullptr
+	||  !m_remoteBoard->setFenString(fen) || !board->setFenString(fen))
+	{
+		qWarning("Invalid remote game: %s %s",
+			 qUtf8Printable(variant), qUtf8Printable(fen));
+		delete m_remoteBoard;
+		m_remoteBoard = nullptr;
+		delete board;
+		return;
+	}
+
+	m_scene->setBoard(board);
+	m_scene->populate();
+	m_view->setEnabled(false);
+
+	m_remoteTime[Chess::Side::White] = whiteTime;
+	m_remoteTime[Chess::Side::Black] = blackTime;
+	m_clocks[Chess::Side::White]->setPlayerName(white);
+	m_clocks[Chess::Side::Black]->setPlayerName(black);
+	for (int i = 0; i < 2; i++)
+	{
+		m_clocks[i]->stop();
+		m_clocks[i]->setInfiniteTime(m_remoteTime[i] < 0);
+		m_clocks[i]->setTime(qMax(m_remoteTime[i], 0));
+	}
+	int side = m_remoteBoard->sideToMove();
+	m_clocks[side]->start(qMax(m_remoteTime[side], 0));
+}
+
+void GameWallWidget::addRemoteMove(const QString& san, int timeLeft)
+{
+	if (m_remoteBoard == nullptr)
+		return;
+
+	Chess::Move move = m_remoteBoard->moveFromString(san);
+	if (move.isNull())
+	{
+		qWarning("Illegal remote move: %s", qUtf8Printable(san));
+		return;
+	}
+	m_pendingMoves.append(m_remoteBoard->genericMove(move));
+
+	int side = m_remoteBoard->sideToMove();
+	m_remoteBoard->makeMove(move);
+	m_remoteTime[side] = timeLeft;
+	m_clocks[side]->stop();
+	m_clocks[side]->setTime(qMax(timeLeft, 0));
+
+	side = m_remoteBoard->sideToMove();
+	m_clocks[side]->start(qMax(m_remoteTime[side], 0));
+
+	emit updateNeeded();
+}
+
+void GameWallWidget::finishRemoteGame(const QString& result)
+{
+	for (int i = 0; i < 2; i++)
+		m_clocks[i]->stop();
+	onGameFinished(nullptr, Chess::Result(result));
+}
+
+void GameWallWidget::showPendingMoves(bool animate)
+{
+	GuiProfilerScope profile("GameWallWidget::showPendingMoves");
+	if (!m_pendingFen.isEmpty())
+	{
+		m_scene->setFenString(m_pendingFen);
+		m_pendingFen.clear();
+	}
 
-	game->unlockThread();
+	for (int i = 0; i < m_pendingMoves.size(); i++)
+	{
+		m_scene->setAnimated(animate && i == m_pendingMoves.size() - 1);
+		m_scene->makeMove(m_pendingMoves.at(i));
+	}
+	m_pendingMoves.clear();
+}
 
-	m_view->setEnabled(!game->isFinished() &&
-			   game->playerToMove()->isHuman());
+void GameWallWidget::onFenChanged(const QString& fenString)
+{
+	GuiProfilerScope profile("GameWallWidget::onFenChanged");
+	m_pendingFen = fenString;
+	m_pendingMoves.clear();
+	m_nextPly = 0;
+	emit updateNeeded();
+}
+
+void GameWallWidget::onMoveMade(const MoveEvent& event)
+{
+	GuiProfilerScope profile("GameWallWidget::onMoveMade");
+	if (event.ply() < m_nextPly)
+		return;
+	m_nextPly = event.ply() + 1;
+	m_pendingMoves.append(event.move());
+	emit updateNeeded();
+}
+
+void GameWallWidget::onGameFinished(ChessGame* game, Chess::Result result)
+{
+	showPendingMoves(false);
+	m_scene->onGameFinished(game, result);
 }
 
 
@@ -143,6 +327,11 @@ GameWall::GameWall(GameManager* manager, QWidget *parent)
 
 	setLayout(new TileLayout());
 
+	// The boards are repainted at most this many times per second
+	const int fps = qBound(1, QSettings().value("ui/game_wall_fps", 10).toInt(), 60);
+	m_updateTimer.setInterval(1000 / fps);
+	connect(&m_updateTimer, SIGNAL(timeout()), this, SLOT(updateWidgets()));
+
 	const auto activeGames = manager->activeGames();
 	for (ChessGame* game : activeGames)
 	{
@@ -156,6 +345,25 @@ GameWall::GameWall(GameManager* manager, QWidget *parent)
 		this, SLOT(removeGame(ChessGame*)));
 }
 
+GameWall::GameWall(LiveGameClient* client, QWidget* parent)
+	: QWidget(parent)
+{
+	Q_ASSERT(client != nullptr);
+
+	setLayout(new TileLayout());
+
+	const int fps = qBound(1, QSettings().value("ui/game_wall_fps", 10).toInt(), 60);
+	m_updateTimer.setInterval(1000 / fps);
+	connect(&m_updateTimer, SIGNAL(timeout()), this, SLOT(updateWidgets()));
+
+	connect(client, SIGNAL(gameStarted(int, QString, QString, QString, QString, int, int)),
+		this, SLOT(addRemoteGame(int, QString, QString, QString, QString, int, int)));
+	connect(client, SIGNAL(moveMade(int, QString, int, int, int, int)),
+		this, SLOT(onRemoteMove(int, int, QString, int, int, int)));
+	connect(client, SIGNAL(gameFinished(int, QString, QString)),
+		this, SLOT(removeRemoteGame(int, QString)));
+}
+
 GameWallWidget* GameWall::getFreeWidget()
 {
 	if (!m_gamesToRemove.isEmpty())
@@ -163,6 +371,12 @@ GameWallWidget* GameWall::getFreeWidget()
 
 	auto widget = new GameWallWidget(this);
 	layout()->addWidget(widget);
+	connect(widget, &GameWallWidget::updateNeeded, this, [=]()
+	{
+		m_widgetsToUpdate.insert(widget);
+		if (!m_updateTimer.isActive())
+			m_updateTimer.start();
+	});
 
 	return widget;
 }
@@ -187,4 +401,59 @@ void GameWall::removeGame(ChessGame* game)
 	m_gamesToRemove.append(m_games.take(game));
 }
 
+void GameWall::addRemoteGame(int id,
+			     const QString& variant,
+			     const QString& fen,
+			     const QString& white,
+			     const QString& black,
+			     int whiteTime,
+			     int blackTime)
+{
+	GameWallWidget* widget = m_remoteGames.value(id);
+	if (widget == nullptr)
+	{
+		widget = getFreeWidget();
+		m_remoteGames[id] = widget;
+	}
+	widget->setRemoteGame(variant, fen, white, black,
+			      whiteTime, blackTime);
+}
+
+void GameWall::onRemoteMove(int id, int ply, const QString& san,
+			    int score, int depth, int timeLeft)
+{
+	Q_UNUSED(ply);
+	Q_UNUSED(score);
+	Q_UNUSED(depth);
+
+	GameWallWidget* widget = m_remoteGames.value(id);
+	if (widget != nullptr)
+		widget->addRemoteMove(san, timeLeft);
+}
+
+void GameWall::removeRemoteGame(int id, const QString& result)
+{
+	GameWallWidget* widget = m_remoteGames.take(id);
+	if (widget == nullptr)
+		return;
+
+	widget->finishRemoteGame(result);
+	m_gamesToRemove.append(widget);
+}
+
+void GameWall::updateWidgets()
+{
+	if (m_widgetsToUpdate.isEmpty())
+	{
+		m_updateTimer.stop();
+		return;
+	}
+
+	// Only the tile under the mouse cursor is animated
+	const auto widgets = m_widgetsToUpdate;
+	m_widgetsToUpdate.clear();
+	for (GameWallWidget* widget : widgets)
+		widget->showPendingMoves(widget->underMouse());
+}
+
 #include "gamewall.moc"
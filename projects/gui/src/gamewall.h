@@ -22,9 +22,12 @@
 #include <QDialog>
 #include <QMap>
 #include <QList>
+#include <QSet>
+#include <QTimer>
 
 class ChessGame;
 class GameManager;
+class LiveGameClient;
 class GameWallWidget;
 
 class GameWall : public QWidget
@@ -34,16 +37,37 @@ class GameWall : public QWidget
 	public:
 		explicit GameWall(GameManager* manager,
 				  QWidget *parent = nullptr);
+		// Shows the games of a remote LiveGameFeed
+		explicit GameWall(LiveGameClient* client,
+				  QWidget* parent = nullptr);
 
 	public slots:
 		void addGame(ChessGame* game);
 		void removeGame(ChessGame* game);
 
+	private slots:
+		void updateWidgets();
+		void addRemoteGame(int id,
+				   const QString& variant,
+				   const QString& fen,
+				   const QString& white,
+				   const QString& black,
+				   int whiteTime,
+				   int blackTime);
+		void onRemoteMove(int id, int ply, const QString& san,
+				  int score, int depth, int timeLeft);
+		void removeRemoteGame(int id, const QString& result);
+
 	private:
 		GameWallWidget* getFreeWidget();
 
 		QMap<ChessGame*, GameWallWidget*> m_games;
+		QMap<int, GameWallWidget*> m_remoteGames;
 		QList<GameWallWidget*> m_gamesToRemove;
+		// Widgets with position changes to show, updated by
+		// m_updateTimer at a limited frame rate
+		QSet<GameWallWidget*> m_widgetsToUpdate;
+		QTimer m_updateTimer;
 };
 
 #endif // GAMEWALL_H
@@ -0,0 +1,192 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "guiprofiler.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QPointer>
+#include <QWidget>
+#include <chessgame.h>
+#include <gamemanager.h>
+#include "cutechessapp.h"
+
+namespace {
+
+// Interval of the event loop latency timer, in milliseconds
+const int s_tickInterval = 50;
+// Interval of the summaries, in milliseconds
+const int s_reportInterval = 5000;
+
+} // anonymous namespace
+
+bool GuiProfiler::s_enabled = false;
+
+GuiProfiler* GuiProfiler::instance()
+{
+	static GuiProfiler* profiler = new GuiProfiler(QCoreApplication::instance());
+	return profiler;
+}
+
+bool GuiProfiler::isEnabled()
+{
+	return s_enabled;
+}
+
+GuiProfiler::GuiProfiler(QObject* parent)
+	: QObject(parent),
+	  m_ticks(0),
+	  m_totalLatency(0),
+	  m_maxLatency(0)
+{
+	m_latencyTimer.setTimerType(Qt::PreciseTimer);
+	m_latencyTimer.setInterval(s_tickInterval);
+	connect(&m_latencyTimer, SIGNAL(timeout()),
+		this, SLOT(onLatencyTimeout()));
+
+	m_reportTimer.setInterval(s_reportInterval);
+	connect(&m_reportTimer, SIGNAL(timeout()), this, SLOT(report()));
+}
+
+void GuiProfiler::setEnabled(bool enabled)
+{
+	if (enabled == s_enabled)
+		return;
+
+	s_enabled = enabled;
+	reset();
+	if (enabled)
+	{
+		m_lastTick.start();
+		m_latencyTimer.start();
+		m_reportTimer.start();
+		probeGameThreads();
+	}
+	else
+	{
+		m_latencyTimer.stop();
+		m_reportTimer.stop();
+	}
+
+	emit enabledChanged(enabled);
+}
+
+void GuiProfiler::reset()
+{
+	m_ticks = 0;
+	m_totalLatency = 0;
+	m_maxLatency = 0;
+	m_slotTimes.clear();
+	m_repaints.clear();
+
+	QMutexLocker locker(&m_threadMutex);
+	m_threadBacklogs.clear();
+}
+
+void GuiProfiler::addSlotTime(const char* name, qint64 nsecs)
+{
+	SlotTime& time = m_slotTimes[QByteArray::fromRawData(name, int(qstrlen(name)))];
+	time.calls++;
+	time.nsecs += nsecs;
+}
+
+void GuiProfiler::addRepaint(const QWidget* view)
+{
+	auto it = m_repaints.find(view);
+	if (it == m_repaints.end())
+	{
+		Repaints repaints = { view->window()->windowTitle(), 0 };
+		it = m_repaints.insert(view, repaints);
+	}
+	it->count++;
+}
+
+void GuiProfiler::onLatencyTimeout()
+{
+	// The timer is late by as long as the event loop was busy
+	qint64 latency = qMax(qint64(0), m_lastTick.restart() - s_tickInterval);
+	m_ticks++;
+	m_totalLatency += latency;
+	m_maxLatency = qMax(m_maxLatency, latency);
+}
+
+void GuiProfiler::probeGameThreads()
+{
+	const auto games = CuteChessApplication::instance()->gameManager()->activeGames();
+	for (ChessGame* game : games)
+	{
+		QThread* thread = game->thread();
+		if (thread == QThread::currentThread())
+			continue;
+
+		// The call waits behind the events already queued
+		// for the game's thread
+		QElapsedTimer timer;
+		timer.start();
+		QPointer<GuiProfiler> self(this);
+		QTimer::singleShot(0, game, [=]()
+		{
+			qint64 wait = timer.elapsed();
+			if (self.isNull())
+				return;
+
+			QMutexLocker locker(&self->m_threadMutex);
+			qint64& backlog = self->m_threadBacklogs[thread];
+			backlog = qMax(backlog, wait);
+		});
+	}
+}
+
+void GuiProfiler::report()
+{
+	QStringList lines;
+	lines << QString("GUI profile: event loop latency avg %1 ms, max %2 ms")
+		 .arg(m_ticks > 0 ? double(m_totalLatency) / m_ticks : 0.0, 0, 'f', 1)
+		 .arg(m_maxLatency);
+
+	for (auto it = m_slotTimes.constBegin(); it != m_slotTimes.constEnd(); ++it)
+	{
+		lines << QString("  %1: %2 calls, %3 ms")
+			 .arg(QString::fromLatin1(it.key()))
+			 .arg(it.value().calls)
+			 .arg(it.value().nsecs / 1000000.0, 0, 'f', 1);
+	}
+
+	for (auto it = m_repaints.constBegin(); it != m_repaints.constEnd(); ++it)
+	{
+		lines << QString("  BoardView %1 (%2): %3 repaints")
+			 .arg(quintptr(it.key()), 0, 16)
+			 .arg(it.value().window)
+			 .arg(it.value().count);
+	}
+
+	{
+		QMutexLocker locker(&m_threadMutex);
+		for (auto it = m_threadBacklogs.constBegin(); it != m_threadBacklogs.constEnd(); ++it)
+		{
+			lines << QString("  Game thread %1: queued calls waited up to %2 ms")
+				 .arg(quintptr(it.key()), 0, 16)
+				 .arg(it.value());
+		}
+	}
+
+	qInfo("%s", qUtf8Printable(lines.join('\n')));
+
+	reset();
+	m_lastTick.start();
+	probeGameThreads();
+}
@@ -0,0 +1,134 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GUI_PROFILER_H
+#define GUI_PROFILER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QTimer>
+class QThread;
+class QWidget;
+
+/*!
+ * \brief Measures where the GUI spends its time
+ *
+ * When enabled, GuiProfiler records the latency of the main event
+ * loop, the time spent in slots wrapped in a GuiProfilerScope, the
+ * number of repaints of each board view, and how long queued calls
+ * wait in each game thread. A summary is written to the log every
+ * few seconds. The profiler can be switched on and off at any time;
+ * when it is off the hooks cost a single check.
+ */
+class GuiProfiler : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Returns the application's profiler. */
+		static GuiProfiler* instance();
+		/*! Returns true if profiling is enabled. */
+		static bool isEnabled();
+
+		/*! Adds \a nsecs nanoseconds spent in \a name. */
+		void addSlotTime(const char* name, qint64 nsecs);
+		/*! Counts a repaint of \a view. */
+		void addRepaint(const QWidget* view);
+
+	public slots:
+		/*! Enables or disables profiling. */
+		void setEnabled(bool enabled);
+
+	signals:
+		/*! Emitted when profiling is enabled or disabled. */
+		void enabledChanged(bool enabled);
+
+	private slots:
+		void onLatencyTimeout();
+		void report();
+
+	private:
+		struct SlotTime
+		{
+			int calls;
+			qint64 nsecs;
+		};
+		struct Repaints
+		{
+			QString window;
+			int count;
+		};
+
+		explicit GuiProfiler(QObject* parent = nullptr);
+		void probeGameThreads();
+		void reset();
+
+		static bool s_enabled;
+
+		QTimer m_latencyTimer;
+		QTimer m_reportTimer;
+		QElapsedTimer m_lastTick;
+		int m_ticks;
+		qint64 m_totalLatency;
+		qint64 m_maxLatency;
+		QHash<QByteArray, SlotTime> m_slotTimes;
+		QHash<const QObject*, Repaints> m_repaints;
+		// Longest wait of a queued call in each game thread, updated
+		// from the game threads
+		QMutex m_threadMutex;
+		QHash<QThread*, qint64> m_threadBacklogs;
+};
+
+/*!
+ * \brief Adds the time spent in a scope to the GuiProfiler
+ *
+ * Example:
+ * \code
+ * void MoveList::onMoveMade(...)
+ * {
+ *     GuiProfilerScope profile("MoveList::onMoveMade");
+ *     ...
+ * }
+ * \endcode
+ */
+class GuiProfilerScope
+{
+	public:
+		/*! Starts timing \a name if profiling is enabled. */
+		explicit GuiProfilerScope(const char* name)
+			: m_name(name)
+		{
+			if (GuiProfiler::isEnabled())
+				m_timer.start();
+		}
+		/*! Adds the elapsed time to the profiler. */
+		~GuiProfilerScope()
+		{
+			if (m_timer.isValid() && GuiProfiler::isEnabled())
+				GuiProfiler::instance()->addSlotTime(m_name,
+					m_timer.nsecsElapsed());
+		}
+
+	private:
+		const char* m_name;
+		QElapsedTimer m_timer;
+};
+
+#endif // GUI_PROFILER_H
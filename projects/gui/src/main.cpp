@@ -29,6 +29,7 @@
 #include <board/side.h>
 #include <board/result.h>
 #include <moveevaluation.h>
+#include <moveevent.h>
 
 int main(int argc, char* argv[])
 {
@@ -38,9 +39,13 @@ int main(int argc, char* argv[])
 	qRegisterMetaType<Chess::Side>("Chess::Side");
 	qRegisterMetaType<Chess::Result>("Chess::Result");
 	qRegisterMetaType<MoveEvaluation>("MoveEvaluation");
+	qRegisterMetaType<MoveEvent>("MoveEvent");
 
 	QLoggingCategory::defaultCategory()->setEnabled(QtDebugMsg, true);
 
+	// The OpenGL board views share their textures, eg. the pieces
+	QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+
 	CuteChessApplication app(argc, argv);
 
 	QTranslator translator;
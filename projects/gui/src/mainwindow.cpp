@@ -31,6 +31,7 @@
 #include <QWindow>
 #include <QSettings>
 #include <QDesktopWidget>
+#include <QTextStream>
 
 #include <board/boardfactory.h>
 #include <chessgame.h>
@@ -56,6 +57,7 @@
 #include "evalwidget.h"
 #include "boardview/boardscene.h"
 #include "tournamentresultsdlg.h"
+#include "guiprofiler.h"
 
 #ifdef QT_DEBUG
 #include <modeltest.h>
@@ -94,8 +96,12 @@ MainWindow::MainWindow(ChessGame* game)
 	#endif
 
 	m_evalHistory = new EvalHistory(this);
-	m_evalWidgets[0] = new EvalWidget(this);
-	m_evalWidgets[1] = new EvalWidget(this);
+	const int pvHistory = QSettings().value("ui/eval_pv_history", 0).toInt();
+	for (int i = 0; i < 2; i++)
+	{
+		m_evalWidgets[i] = new EvalWidget(this);
+		m_evalWidgets[i]->setPvHistoryLimit(pvHistory);
+	}
 
 	QVBoxLayout* mainLayout = new QVBoxLayout();
 	mainLayout->addWidget(m_gameViewer);
@@ -187,6 +193,13 @@ void MainWindow::createActions()
 
 	m_showGameWallAct = new QAction(tr("&Active Games"), this);
 
+	m_showRemoteGameWallAct = new QAction(tr("&Remote Games..."), this);
+
+	m_profileGuiAct = new QAction(tr("&Profile GUI"), this);
+	m_profileGuiAct->setCheckable(true);
+	m_profileGuiAct->setChecked(GuiProfiler::isEnabled());
+	m_profileGuiAct->setStatusTip(tr("Write GUI performance statistics to the log"));
+
 	m_minimizeAct = new QAction(tr("&Minimize"), this);
 	m_minimizeAct->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_M));
 
@@ -258,6 +271,12 @@ void MainWindow::createActions()
 	connect(m_showSettingsAct, SIGNAL(triggered()),
 		app, SLOT(showSettingsDialog()));
 
+	auto profiler = GuiProfiler::instance();
+	connect(m_profileGuiAct, SIGNAL(toggled(bool)),
+		profiler, SLOT(setEnabled(bool)));
+	connect(profiler, SIGNAL(enabledChanged(bool)),
+		m_profileGuiAct, SLOT(setChecked(bool)));
+
 	connect(m_showTournamentResultsAct, SIGNAL(triggered()),
 		app, SLOT(showTournamentResultsDialog()));
 
@@ -266,6 +285,8 @@ void MainWindow::createActions()
 
 	connect(m_showGameWallAct, SIGNAL(triggered()),
 		app, SLOT(showGameWall()));
+	connect(m_showRemoteGameWallAct, SIGNAL(triggered()),
+		app, SLOT(showRemoteGameWall()));
 
 	connect(m_aboutAct, SIGNAL(triggered()), this, SLOT(showAboutDialog()));
 }
@@ -300,6 +321,8 @@ void MainWindow::createMenus()
 	m_toolsMenu = menuBar()->addMenu(tr("T&ools"));
 	m_toolsMenu->addAction(m_showSettingsAct);
         m_toolsMenu->addAction(m_showGameDatabaseWindowAct);
+	m_toolsMenu->addSeparator();
+	m_toolsMenu->addAction(m_profileGuiAct);
 
 	m_viewMenu = menuBar()->addMenu(tr("&View"));
 	m_viewMenu->addAction(m_flipBoardAct);
@@ -348,6 +371,11 @@ void MainWindow::createDockWindows()
 	QDockWidget* engineDebugDock = new QDockWidget(tr("Engine Debug"), this);
 	engineDebugDock->setObjectName("EngineDebugDock");
 	m_engineDebugLog = new PlainTextLog(engineDebugDock);
+	QSettings s;
+	m_engineDebugLog->setCapacity(
+		s.value("ui/engine_debug_log_lines", 10000).toInt());
+	m_engineDebugLog->setLogFile(
+		s.value("ui/engine_debug_log_file").toString());
 	engineDebugDock->setWidget(m_engineDebugLog);
 	engineDebugDock->close();
 	addDockWidget(Qt::BottomDockWidgetArea, engineDebugDock);
@@ -500,6 +528,40 @@ void MainWindow::destroyGame(ChessGame* game)
 		close();
 }
 
+void MainWindow::packGame(int index)
+{
+	TabData& tab = m_tabs[index];
+	if (tab.m_pgn == nullptr || index == m_tabBar->currentIndex())
+		return;
+
+	// A finished game is kept in a tab after its game object is
+	// gone. The game objects of tournaments are destroyed by the
+	// tournament, and those of other games are released here.
+	if (tab.m_game != nullptr)
+	{
+		if (tab.m_tournament != nullptr || !tab.m_finished)
+			return;
+
+		tab.m_game->disconnect(this);
+		tab.m_game->deleteLater();
+		tab.m_game = nullptr;
+	}
+
+	tab.m_compactPgn = CompactPgnGame(*tab.m_pgn);
+	delete tab.m_pgn;
+	tab.m_pgn = nullptr;
+}
+
+void MainWindow::unpackGame(int index)
+{
+	TabData& tab = m_tabs[index];
+	if (tab.m_pgn != nullptr)
+		return;
+
+	tab.m_pgn = new PgnGame(tab.m_compactPgn.toPgnGame());
+	tab.m_compactPgn = CompactPgnGame();
+}
+
 void MainWindow::setCurrentGame(const TabData& gameData)
 {
 	if (gameData.m_game == m_game && m_game != nullptr)
@@ -543,8 +605,9 @@ void MainWindow::setCurrentGame(const TabData& gameData)
 
 	m_game = gameData.m_game;
 
-	lockCurrentGame();
-
+	// A running game is read from its snapshot, so the game's thread
+	// isn't paused. The views connect to the game's signals before
+	// reading the snapshot, and skip the moves that are in it.
 	m_engineDebugLog->clear();
 
 	m_moveList->setGame(m_game, gameData.m_pgn);
@@ -579,8 +642,14 @@ void MainWindow::setCurrentGame(const TabData& gameData)
 	else
 		m_gameViewer->setGame(m_game);
 
-	m_tagsModel->setTags(gameData.m_pgn->tags());
+	// The tags changed after the snapshot are queued to the model,
+	// so they're set after the snapshot's tags
 	gameData.m_pgn->setTagReceiver(m_tagsModel);
+	const ChessGame::SharedSnapshot snapshot(m_game->snapshot());
+	if (!snapshot.isNull())
+		m_tagsModel->setTags(snapshot->pgn.tags());
+	else
+		m_tagsModel->setTags(QList< QPair<QString, QString> >());
 
 	for (int i = 0; i < 2; i++)
 	{
@@ -589,7 +658,7 @@ void MainWindow::setCurrentGame(const TabData& gameData)
 		m_players[i] = player;
 
 		connect(player, SIGNAL(debugMessage(QString)),
-			m_engineDebugLog, SLOT(appendPlainText(QString)));
+			m_engineDebugLog, SLOT(appendMessage(QString)));
 
 		auto clock = m_gameViewer->chessClock(side);
 
@@ -599,18 +668,25 @@ void MainWindow::setCurrentGame(const TabData& gameData)
 		connect(player, SIGNAL(nameChanged(QString)),
 			clock, SLOT(setPlayerName(QString)));
 
-		clock->setInfiniteTime(player->timeControl()->isInfinite());
-
-		if (player->state() == ChessPlayer::Thinking)
-			clock->start(player->timeControl()->activeTimeLeft());
-		else
-			clock->setTime(player->timeControl()->timeLeft());
-
 		connect(player, SIGNAL(startedThinking(int)),
 			clock, SLOT(start(int)));
 		connect(player, SIGNAL(stoppedThinking()),
 			clock, SLOT(stop()));
 		m_evalWidgets[i]->setPlayer(player);
+
+		if (snapshot.isNull())
+		{
+			// The game hasn't started yet
+			const TimeControl tc(m_game->timeControl(side));
+			clock->setInfiniteTime(tc.isInfinite());
+			clock->setTime(tc.timeLeft());
+			continue;
+		}
+		clock->setInfiniteTime(snapshot->infiniteTime[i]);
+		if (snapshot->thinkingSide == side)
+			clock->start(snapshot->currentTimeLeft(side));
+		else
+			clock->setTime(snapshot->timeLeft[i]);
 	}
 
 	if (m_game->boardShouldBeFlipped())
@@ -618,7 +694,6 @@ void MainWindow::setCurrentGame(const TabData& gameData)
 
 	updateMenus();
 	updateWindowTitle();
-	unlockCurrentGame();
 }
 
 int MainWindow::tabIndex(ChessGame* game) const
@@ -653,9 +728,16 @@ int MainWindow::tabIndex(Tournament* tournament, bool freeTab) const
 void MainWindow::onTabChanged(int index)
 {
 	if (index == -1 || m_closing)
+	{
 		m_game = nullptr;
-	else
-		setCurrentGame(m_tabs.at(index));
+		return;
+	}
+
+	// Only the current tab keeps its finished game expanded
+	unpackGame(index);
+	setCurrentGame(m_tabs.at(index));
+	for (int i = 0; i < m_tabs.size(); i++)
+		packGame(i);
 }
 
 void MainWindow::onTabCloseRequested(int index)
@@ -774,6 +856,8 @@ void MainWindow::onGameFinished(ChessGame* game)
 			game->pgn()->write(fileName);
 			//TODO: reaction on error
 	}
+
+	packGame(tIndex);
 }
 
 void MainWindow::newTournament()
@@ -953,8 +1037,12 @@ void MainWindow::editMoveComment(int ply, const QString& comment)
 		lockCurrentGame();
 		PgnGame* pgn(m_tabs.at(m_tabBar->currentIndex()).m_pgn);
 		PgnGame::MoveData md(pgn->moves().at(ply));
+		// The edited text replaces the evaluation as well
+		md.evaluation = MoveEvaluation();
 		md.comment = text;
 		pgn->setMove(ply, md);
+		if (m_game != nullptr)
+			m_game->updateSnapshot();
 		unlockCurrentGame();
 
 		m_moveList->setMove(ply, md.move, md.moveString, text);
@@ -1195,6 +1283,7 @@ void MainWindow::addDefaultWindowMenu()
 	m_windowMenu->addAction(m_minimizeAct);
 	m_windowMenu->addSeparator();
 	m_windowMenu->addAction(m_showGameWallAct);
+	m_windowMenu->addAction(m_showRemoteGameWallAct);
 	m_windowMenu->addSeparator();
 	m_windowMenu->addAction(m_showPreviousTabAct);
 	m_windowMenu->addAction(m_showNextTabAct);
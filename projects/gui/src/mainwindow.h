@@ -22,6 +22,7 @@
 #include <QMainWindow>
 #include <QPointer>
 #include <board/side.h>
+#include <compactpgngame.h>
 
 namespace Chess {
 	class Board;
@@ -98,7 +99,9 @@ class MainWindow : public QMainWindow
 
 			ChessGame* m_id;
 			QPointer<ChessGame> m_game;
+			// nullptr while the game is packed in m_compactPgn
 			PgnGame* m_pgn;
+			CompactPgnGame m_compactPgn;
 			Tournament* m_tournament;
 			bool m_finished;
 		};
@@ -117,6 +120,8 @@ class MainWindow : public QMainWindow
 		bool askToSave();
 		void setCurrentGame(const TabData& gameData);
 		void removeGame(int index);
+		void packGame(int index);
+		void unpackGame(int index);
 		int tabIndex(ChessGame* game) const;
 		int tabIndex(Tournament* tournament, bool freeTab = false) const;
 		void addDefaultWindowMenu();
@@ -154,6 +159,8 @@ class MainWindow : public QMainWindow
 		QAction* m_minimizeAct;
 		QAction* m_showGameDatabaseWindowAct;
 		QAction* m_showGameWallAct;
+		QAction* m_showRemoteGameWallAct;
+		QAction* m_profileGuiAct;
 		QAction* m_showPreviousTabAct;
 		QAction* m_showNextTabAct;
 		QAction* m_aboutAct;
@@ -18,15 +18,22 @@
 
 #include "movelist.h"
 #include <QTextBrowser>
+#include <QTableWidget>
+#include <QHeaderView>
 #include <QVBoxLayout>
 #include <QScrollBar>
 #include <QTimer>
 #include <QKeyEvent>
+#include <QSettings>
 #include <chessgame.h>
+#include "guiprofiler.h"
 
 
 MoveList::MoveList(QWidget* parent)
 	: QWidget(parent),
+	  m_moveList(nullptr),
+	  m_moveTable(nullptr),
+	  m_insertTimer(new QTimer(this)),
 	  m_game(nullptr),
 	  m_moveCount(0),
 	  m_startingSide(0),
@@ -34,6 +41,40 @@ MoveList::MoveList(QWidget* parent)
 	  m_moveToBeSelected(-1),
 	  m_selectionTimer(new QTimer(this))
 {
+	QVBoxLayout* layout = new QVBoxLayout();
+	layout->setContentsMargins(0, 0, 0, 0);
+	setLayout(layout);
+
+	m_selectionTimer->setSingleShot(true);
+	m_selectionTimer->setInterval(50);
+	connect(m_selectionTimer, SIGNAL(timeout()),
+		this, SLOT(selectChosenMove()));
+
+	// New moves are added in batches
+	m_insertTimer->setSingleShot(true);
+	m_insertTimer->setInterval(50);
+	connect(m_insertTimer, SIGNAL(timeout()),
+		this, SLOT(insertPendingMoves()));
+
+	if (QSettings().value("ui/move_list_table_view", false).toBool())
+	{
+		m_moveTable = new QTableWidget(0, 2, this);
+		m_moveTable->setHorizontalHeaderLabels({ tr("White"), tr("Black") });
+		m_moveTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+		m_moveTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+		m_moveTable->setSelectionMode(QAbstractItemView::SingleSelection);
+		m_moveTable->setSelectionBehavior(QAbstractItemView::SelectItems);
+
+		connect(m_moveTable, SIGNAL(itemClicked(QTableWidgetItem*)),
+			this, SLOT(onItemClicked(QTableWidgetItem*)));
+		connect(m_moveTable, SIGNAL(itemDoubleClicked(QTableWidgetItem*)),
+			this, SLOT(onItemDoubleClicked(QTableWidgetItem*)));
+
+		layout->addWidget(m_moveTable);
+		m_moveTable->installEventFilter(this);
+		return;
+	}
+
 	m_moveList = new QTextBrowser(this);
 	m_moveList->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 	m_moveList->setOpenLinks(false);
@@ -52,15 +93,7 @@ MoveList::MoveList(QWidget* parent)
 	connect(m_moveList, SIGNAL(anchorClicked(const QUrl&)), this,
 	    SLOT(onLinkClicked(const QUrl&)));
 
-	QVBoxLayout* layout = new QVBoxLayout();
 	layout->addWidget(m_moveList);
-	layout->setContentsMargins(0, 0, 0, 0);
-	setLayout(layout);
-
-	m_selectionTimer->setSingleShot(true);
-	m_selectionTimer->setInterval(50);
-	connect(m_selectionTimer, SIGNAL(timeout()),
-		this, SLOT(selectChosenMove()));
 
 	m_moveList->document()->setIndentWidth(18);
 
@@ -106,47 +139,135 @@ void MoveList::setGame(ChessGame* game, PgnGame* pgn)
 		m_game->disconnect(this);
 	m_game = game;
 
-	if (pgn == nullptr)
+	// The moves of a game are read from its snapshot after the
+	// signals are connected, and onMoveMade() skips the moves that
+	// are in the snapshot. A game that hasn't published a snapshot
+	// yet has no moves.
+	ChessGame::SharedSnapshot snapshot;
+	const PgnGame emptyPgn;
+	const PgnGame* source = pgn;
+	if (m_game != nullptr)
 	{
-		Q_ASSERT(game != nullptr);
-		pgn = m_game->pgn();
+		connect(m_game, SIGNAL(moveMade(MoveEvent)),
+			this, SLOT(onMoveMade(MoveEvent)));
+		connect(m_game, SIGNAL(moveChanged(MoveEvent)),
+			this, SLOT(onMoveChanged(MoveEvent)));
+		snapshot = m_game->snapshot();
+		source = snapshot.isNull() ? &emptyPgn : &snapshot->pgn;
 	}
+	Q_ASSERT(source != nullptr);
 
-	m_moveList->clear();
 	m_moves.clear();
+	m_pendingMoves.clear();
 	m_selectedMove = -1;
 	m_moveToBeSelected = -1;
 	m_selectionTimer->stop();
+	m_insertTimer->stop();
 
-	QTextCursor cursor(m_moveList->textCursor());
-	cursor.beginEditBlock();
-	cursor.movePosition(QTextCursor::End);
-
-	m_startingSide = pgn->startingSide();
+	m_startingSide = source->startingSide();
 	m_moveCount = 0;
-	for (const PgnGame::MoveData& md : pgn->moves())
+	if (m_moveTable != nullptr)
 	{
-		insertMove(m_moveCount++, md.moveString, md.comment, cursor);
+		m_moveTable->clearContents();
+		m_moveTable->setRowCount(0);
+		for (const PgnGame::MoveData& md : source->moves())
+			insertTableMove(m_moveCount++, md.moveString,
+					md.commentText());
 	}
-	cursor.endEditBlock();
-
-	if (m_game != nullptr)
+	else
 	{
-		connect(m_game, SIGNAL(moveMade(Chess::GenericMove, QString, QString)),
-			this, SLOT(onMoveMade(Chess::GenericMove, QString, QString)));
-		connect(m_game, SIGNAL(moveChanged(int, Chess::GenericMove, QString, QString)),
-			this, SLOT(setMove(int, Chess::GenericMove, QString, QString)));
+		m_moveList->clear();
+
+		QTextCursor cursor(m_moveList->textCursor());
+		cursor.beginEditBlock();
+		cursor.movePosition(QTextCursor::End);
+
+		for (const PgnGame::MoveData& md : source->moves())
+		{
+			insertMove(m_moveCount++, md.moveString,
+				   md.commentText(), cursor);
+		}
+		cursor.endEditBlock();
 	}
 
-	QScrollBar* sb = m_moveList->verticalScrollBar();
+	QScrollBar* sb = verticalScrollBar();
 	sb->setValue(sb->maximum());
 
 	selectMove(m_moveCount - 1);
 }
 
+QScrollBar* MoveList::verticalScrollBar() const
+{
+	if (m_moveTable != nullptr)
+		return m_moveTable->verticalScrollBar();
+	return m_moveList->verticalScrollBar();
+}
+
+void MoveList::insertTableMove(int ply,
+			       const QString& san,
+			       const QString& comment)
+{
+	const int row = (ply + m_startingSide) / 2;
+	const int column = (ply + m_startingSide) % 2;
+	if (row >= m_moveTable->rowCount())
+	{
+		m_moveTable->setRowCount(row + 1);
+		m_moveTable->setVerticalHeaderItem(row,
+			new QTableWidgetItem(QString::number(row + 1)));
+	}
+
+	auto item = new QTableWidgetItem(san);
+	item->setData(Qt::UserRole, ply);
+	item->setToolTip(comment);
+	m_moveTable->setItem(row, column, item);
+}
+
+QTableWidgetItem* MoveList::tableItem(int ply) const
+{
+	return m_moveTable->item((ply + m_startingSide) / 2,
+				 (ply + m_startingSide) % 2);
+}
+
+void MoveList::insertPendingMoves()
+{
+	if (m_pendingMoves.isEmpty())
+		return;
+	m_insertTimer->stop();
+
+	QScrollBar* sb = verticalScrollBar();
+	bool atEnd = sb->value() == sb->maximum();
+
+	int ply = m_moveCount - m_pendingMoves.size();
+	if (m_moveTable != nullptr)
+	{
+		for (const MoveEvent& move : qAsConst(m_pendingMoves))
+			insertTableMove(ply++, move.san(), move.comment());
+	}
+	else
+	{
+		// One edit block for the whole batch
+		QTextCursor cursor(m_moveList->textCursor());
+		cursor.beginEditBlock();
+		cursor.movePosition(QTextCursor::End);
+		for (const MoveEvent& move : qAsConst(m_pendingMoves))
+			insertMove(ply++, move.san(), move.comment(), cursor);
+		cursor.endEditBlock();
+	}
+	m_pendingMoves.clear();
+
+	if (atEnd)
+		sb->setValue(sb->maximum());
+}
+
+void MoveList::showEvent(QShowEvent* event)
+{
+	QWidget::showEvent(event);
+	insertPendingMoves();
+}
+
 bool MoveList::eventFilter(QObject* obj, QEvent* event)
 {
-	if (obj == m_moveList)
+	if (obj == m_moveList || obj == m_moveTable)
 	{
 		if (event->type() == QEvent::KeyPress)
 		{
@@ -174,16 +295,18 @@ bool MoveList::eventFilter(QObject* obj, QEvent* event)
 	return QWidget::eventFilter(obj, event);
 }
 
-void MoveList::onMoveMade(const Chess::GenericMove& move,
-			  const QString& sanString,
-			  const QString& comment)
+void MoveList::onMoveMade(const MoveEvent& event)
 {
-	Q_UNUSED(move);
-
-	QScrollBar* sb = m_moveList->verticalScrollBar();
-	bool atEnd = sb->value() == sb->maximum();
+	GuiProfilerScope profile("MoveList::onMoveMade");
+	if (event.ply() < m_moveCount)
+		return;
 
-	insertMove(m_moveCount++, sanString, comment);
+	// The move is added to the list by insertPendingMoves(), which
+	// also formats the comment
+	m_pendingMoves.append(event);
+	m_moveCount++;
+	if (isVisible() && !m_insertTimer->isActive())
+		m_insertTimer->start();
 
 	bool atLastMove = false;
 	if (m_selectedMove == -1 || m_moveToBeSelected == m_moveCount - 2)
@@ -193,9 +316,11 @@ void MoveList::onMoveMade(const Chess::GenericMove& move,
 
 	if (atLastMove)
 		selectMove(m_moveCount - 1);
+}
 
-	if (atEnd && atLastMove)
-		sb->setValue(sb->maximum());
+void MoveList::onMoveChanged(const MoveEvent& event)
+{
+	setMove(event.ply(), event.move(), event.san(), event.comment());
 }
 
 // TODO: Handle changes to actual moves (eg. undo), not just comments
@@ -206,8 +331,17 @@ void MoveList::setMove(int ply,
 {
 	Q_UNUSED(move);
 	Q_UNUSED(sanString);
-	Q_ASSERT(ply < m_moves.size());
 
+	insertPendingMoves();
+	if (m_moveTable != nullptr)
+	{
+		QTableWidgetItem* item = tableItem(ply);
+		if (item != nullptr)
+			item->setToolTip(comment);
+		return;
+	}
+
+	Q_ASSERT(ply < m_moves.size());
 	QTextCursor c(m_moveList->textCursor());
 
 	MoveCommentToken& commentToken(m_moves[ply].comment);
@@ -244,6 +378,16 @@ void MoveList::selectChosenMove()
 	m_moveToBeSelected = -1;
 	Q_ASSERT(moveNum >= 0 && moveNum < m_moveCount);
 
+	insertPendingMoves();
+	if (m_moveTable != nullptr)
+	{
+		m_selectedMove = moveNum;
+		QTableWidgetItem* item = tableItem(moveNum);
+		m_moveTable->setCurrentItem(item);
+		m_moveTable->scrollToItem(item);
+		return;
+	}
+
 	QTextCursor c(m_moveList->textCursor());
 	c.beginEditBlock();
 
@@ -307,3 +451,16 @@ void MoveList::onLinkClicked(const QUrl& url)
 
 	selectMove(ply);
 }
+
+void MoveList::onItemClicked(QTableWidgetItem* item)
+{
+	int ply = item->data(Qt::UserRole).toInt();
+	emit moveClicked(ply, false);
+	selectMove(ply);
+}
+
+void MoveList::onItemDoubleClicked(QTableWidgetItem* item)
+{
+	int ply = item->data(Qt::UserRole).toInt();
+	emit commentClicked(ply, item->toolTip());
+}
@@ -27,17 +27,29 @@
 #include <QTextBlockFormat>
 #include <QTextCharFormat>
 #include <QTextCursor>
+#include <moveevent.h>
 #include "movenumbertoken.h"
 #include "movetoken.h"
 #include "movecommenttoken.h"
 
 class QTextBrowser;
+class QTableWidget;
+class QTableWidgetItem;
+class QScrollBar;
 class PgnGame;
 class ChessGame;
 namespace Chess { class GenericMove; }
 class QTimer;
 
 
+/*!
+ * \brief A widget that shows the moves and comments of a game.
+ *
+ * The moves are shown as rich text, or in a table of two columns if
+ * the "ui/move_list_table_view" setting is enabled. New moves are
+ * appended to the end of the list in batches, and not at all while
+ * the widget is hidden.
+ */
 class MoveList : public QWidget
 {
 	Q_OBJECT
@@ -50,7 +62,8 @@ class MoveList : public QWidget
 		 * Associates \a game and \a pgn with this document.
 		 *
 		 * Either \a game or \a pgn must not be NULL.
-		 * If \a pgn is NULL, then the PGN data is retrieved from \a game.
+		 * The moves of \a game are read from its snapshot, so \a pgn
+		 * is only read if \a game is NULL.
 		 */
 		void setGame(ChessGame* game, PgnGame* pgn = nullptr);
 
@@ -82,13 +95,16 @@ class MoveList : public QWidget
 	protected:
 		// Reimplemented from QWidget
 		virtual bool eventFilter(QObject* obj, QEvent* event);
+		virtual void showEvent(QShowEvent* event);
 
 	private slots:
-		void onMoveMade(const Chess::GenericMove& move,
-				const QString& sanString,
-				const QString& comment);
+		void onMoveMade(const MoveEvent& event);
+		void onMoveChanged(const MoveEvent& event);
 		void onLinkClicked(const QUrl& url);
+		void onItemClicked(QTableWidgetItem* item);
+		void onItemDoubleClicked(QTableWidgetItem* item);
 		void selectChosenMove();
+		void insertPendingMoves();
 
 	private:
 		struct Move
@@ -102,8 +118,17 @@ class MoveList : public QWidget
 				const QString& san,
 				const QString& comment,
 				QTextCursor cursor = QTextCursor());
+		void insertTableMove(int ply,
+				     const QString& san,
+				     const QString& comment);
+		QTableWidgetItem* tableItem(int ply) const;
+		QScrollBar* verticalScrollBar() const;
 
 		QTextBrowser* m_moveList;
+		QTableWidget* m_moveTable;
+		// Moves that are not in the list yet
+		QList<MoveEvent> m_pendingMoves;
+		QTimer* m_insertTimer;
 		QPointer<ChessGame> m_game;
 		QList<Move> m_moves;
 		int m_moveCount;
@@ -19,11 +19,19 @@
 #include "pgndatabase.h"
 #include <pgnstream.h>
 #include <QFileInfo>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QBuffer>
 
 PgnDatabase::PgnDatabase(const QString& fileName, QObject* parent)
 	: QObject(parent),
 	  m_fileName(fileName),
-	  m_displayName(QFileInfo(fileName).completeBaseName())
+	  m_displayName(QFileInfo(fileName).completeBaseName()),
+	  m_deferredOffset(0),
+	  m_deferredSize(0),
+	  m_deferredCount(-1),
+	  m_indexedSize(0),
+	  m_nextLineNumber(1)
 {
 }
 
@@ -36,13 +44,155 @@ void PgnDatabase::setEntries(const QList<const PgnGameEntry*>& entries)
 {
 	qDeleteAll(m_entries);
 	m_entries = entries;
+	m_deferredCount = -1;
+	m_index.clear();
 }
 
 QList<const PgnGameEntry*> PgnDatabase::entries() const
 {
+	readDeferredEntries();
 	return m_entries;
 }
 
+int PgnDatabase::entryCount() const
+{
+	if (m_deferredCount != -1)
+		return m_deferredCount;
+	return m_entries.size();
+}
+
+void PgnDatabase::setDeferredEntries(const QString& fileName,
+				     qint64 offset,
+				     qint64 size,
+				     int count)
+{
+	qDeleteAll(m_entries);
+	m_entries.clear();
+	m_index.clear();
+
+	m_deferredFile = fileName;
+	m_deferredOffset = offset;
+	m_deferredSize = size;
+	m_deferredCount = count;
+}
+
+bool PgnDatabase::hasDeferredEntries() const
+{
+	return m_deferredCount != -1;
+}
+
+QByteArray PgnDatabase::entryData() const
+{
+	if (m_deferredCount != -1)
+		return deferredData();
+
+	QByteArray data;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+
+	QDataStream out(&buffer);
+	out.setVersion(QDataStream::Qt_4_6);
+	for (const PgnGameEntry* entry : m_entries)
+		entry->write(out);
+
+	return data;
+}
+
+QByteArray PgnDatabase::deferredData() const
+{
+	QFile file(m_deferredFile);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+
+	// Mapping avoids copying the entries through the file buffer
+	uchar* mapped = file.map(m_deferredOffset, m_deferredSize);
+	if (mapped != nullptr)
+	{
+		QByteArray data(reinterpret_cast<const char*>(mapped),
+				int(m_deferredSize));
+		file.unmap(mapped);
+		return data;
+	}
+
+	if (!file.seek(m_deferredOffset))
+		return QByteArray();
+	return file.read(m_deferredSize);
+}
+
+void PgnDatabase::readDeferredEntries() const
+{
+	if (m_deferredCount == -1)
+		return;
+
+	const int count = m_deferredCount;
+	m_deferredCount = -1;
+
+	// The entries are parsed straight from the mapped file if
+	// possible, otherwise from a copy
+	QFile file(m_deferredFile);
+	uchar* mapped = nullptr;
+	QByteArray data;
+	if (file.open(QIODevice::ReadOnly))
+		mapped = file.map(m_deferredOffset, m_deferredSize);
+	if (mapped != nullptr)
+		data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped),
+					       int(m_deferredSize));
+	else
+		data = deferredData();
+
+	if (data.size() != m_deferredSize)
+	{
+		qWarning("PgnDatabase: cannot read the game entries of %s",
+			 qUtf8Printable(m_fileName));
+		return;
+	}
+
+	QDataStream in(data);
+	in.setVersion(QDataStream::Qt_4_6);
+
+	m_entries.reserve(count);
+	for (int i = 0; i < count; i++)
+	{
+		PgnGameEntry* entry = new PgnGameEntry;
+		if (!entry->read(in))
+		{
+			qWarning("PgnDatabase: corrupted game entries in %s",
+				 qUtf8Printable(m_deferredFile));
+			delete entry;
+			break;
+		}
+		m_entries << entry;
+	}
+
+	if (mapped != nullptr)
+		file.unmap(mapped);
+}
+
+void PgnDatabase::appendEntries(const QList<const PgnGameEntry*>& entries)
+{
+	readDeferredEntries();
+	m_entries.append(entries);
+}
+
+QList<const PgnGameEntry*> PgnDatabase::takeEntries()
+{
+	readDeferredEntries();
+	QList<const PgnGameEntry*> entries;
+	entries.swap(m_entries);
+	m_index.clear();
+	return entries;
+}
+
+const PgnGameEntryIndex* PgnDatabase::index() const
+{
+	readDeferredEntries();
+	const int indexed = m_index.entryCount();
+	if (indexed < m_entries.size())
+		m_index.append(m_entries.mid(indexed));
+
+	return &m_index;
+}
+
 QString PgnDatabase::fileName() const
 {
 	return m_fileName;
@@ -82,6 +232,61 @@ void PgnDatabase::setDisplayName(const QString& displayName)
 	m_displayName = displayName;
 }
 
+qint64 PgnDatabase::indexedSize() const
+{
+	return m_indexedSize;
+}
+
+qint64 PgnDatabase::nextLineNumber() const
+{
+	return m_nextLineNumber;
+}
+
+QByteArray PgnDatabase::tailChecksum() const
+{
+	return m_tailChecksum;
+}
+
+void PgnDatabase::setIndexedRange(qint64 size,
+				  qint64 nextLineNumber,
+				  const QByteArray& tailChecksum)
+{
+	m_indexedSize = size;
+	m_nextLineNumber = nextLineNumber;
+	m_tailChecksum = tailChecksum;
+}
+
+bool PgnDatabase::canAppend() const
+{
+	if (m_indexedSize <= 0 || m_tailChecksum.isEmpty())
+		return false;
+	if (QFileInfo(m_fileName).size() < m_indexedSize)
+		return false;
+
+	return checksumBefore(m_fileName, m_indexedSize) == m_tailChecksum;
+}
+
+QByteArray PgnDatabase::checksumBefore(const QString& fileName, qint64 pos)
+{
+	// Games are only ever appended to the end of the file, so
+	// comparing the last few kilobytes is enough to catch files
+	// that were rewritten or truncated
+	static const qint64 length = 4096;
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+
+	qint64 start = qMax(Q_INT64_C(0), pos - length);
+	if (!file.seek(start))
+		return QByteArray();
+
+	QByteArray data = file.read(pos - start);
+	if (data.size() != pos - start)
+		return QByteArray();
+	return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
 PgnDatabase::Status PgnDatabase::game(const PgnGameEntry* entry,
 				      PgnGame* game)
 {
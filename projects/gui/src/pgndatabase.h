@@ -25,6 +25,7 @@
 #include <QFile>
 #include <pgngame.h>
 #include <pgngameentry.h>
+#include <pgngameentryindex.h>
 class PgnStream;
 
 /*!
@@ -73,6 +74,53 @@ class PgnDatabase : public QObject
 		 * \sa game()
 		 */
 		QList<const PgnGameEntry*> entries() const;
+		/*!
+		 * Returns the number of game entries in this database.
+		 *
+		 * Unlike entries(), this function doesn't read deferred
+		 * entries.
+		 */
+		int entryCount() const;
+		/*!
+		 * Defers reading the \a count game entries of this database
+		 * until they're first needed.
+		 *
+		 * The entries are read from \a size bytes at \a offset in
+		 * \a fileName, where entryData() has written them. The file
+		 * is memory-mapped while the entries are read.
+		 */
+		void setDeferredEntries(const QString& fileName,
+					qint64 offset,
+					qint64 size,
+					int count);
+		/*! Returns true if the game entries haven't been read yet. */
+		bool hasDeferredEntries() const;
+		/*!
+		 * Returns the game entries serialized in the format of
+		 * setDeferredEntries().
+		 *
+		 * Deferred entries are copied without reading them.
+		 */
+		QByteArray entryData() const;
+		/*!
+		 * Appends \a entries to the game entries of this database.
+		 *
+		 * The database takes ownership of the PgnGameEntry objects
+		 * in \a entries.
+		 */
+		void appendEntries(const QList<const PgnGameEntry*>& entries);
+		/*!
+		 * Removes all game entries from this database and returns
+		 * them. The caller takes ownership of the entries.
+		 */
+		QList<const PgnGameEntry*> takeEntries();
+		/*!
+		 * Returns the search index of the game entries.
+		 *
+		 * The index is built when it's first needed, and only new
+		 * entries are added to it after appendEntries().
+		 */
+		const PgnGameEntryIndex* index() const;
 
 		/*! Returns the file name of this database. */
 		QString fileName() const;
@@ -114,6 +162,49 @@ class PgnDatabase : public QObject
 		 */
 		void setDisplayName(const QString& displayName);
 
+		/*!
+		 * Returns the number of bytes from the start of the file
+		 * that were indexed into game entries.
+		 *
+		 * \sa setIndexedRange
+		 */
+		qint64 indexedSize() const;
+		/*!
+		 * Returns the line number at the end of the indexed part
+		 * of the file.
+		 */
+		qint64 nextLineNumber() const;
+		/*!
+		 * Returns the checksum of the last bytes of the indexed part
+		 * of the file.
+		 *
+		 * \sa checksumBefore
+		 */
+		QByteArray tailChecksum() const;
+		/*!
+		 * Records that the first \a size bytes of the file, ending at
+		 * line \a nextLineNumber, have been indexed. \a tailChecksum
+		 * is the checksumBefore() value of \a size.
+		 */
+		void setIndexedRange(qint64 size,
+				     qint64 nextLineNumber,
+				     const QByteArray& tailChecksum);
+		/*!
+		 * Returns true if the database file has only grown since it
+		 * was indexed, ie. games have been appended to it.
+		 *
+		 * Then only the new part of the file needs to be indexed.
+		 */
+		bool canAppend() const;
+		/*!
+		 * Returns a checksum of the bytes just before position \a pos
+		 * in file \a fileName, or an empty array if the file can't
+		 * be read. The checksum is used to detect whether an already
+		 * indexed part of the file was changed.
+		 */
+		static QByteArray checksumBefore(const QString& fileName,
+						 qint64 pos);
+
 		/*!
 		 * Reads \a game from the database using \a entry.
 		 *
@@ -122,10 +213,21 @@ class PgnDatabase : public QObject
 		Status game(const PgnGameEntry* entry, PgnGame* game);
 
 	private:
-		QList<const PgnGameEntry*> m_entries;
+		void readDeferredEntries() const;
+		QByteArray deferredData() const;
+
+		mutable QList<const PgnGameEntry*> m_entries;
+		QString m_deferredFile;
+		qint64 m_deferredOffset;
+		qint64 m_deferredSize;
+		mutable int m_deferredCount;
+		mutable PgnGameEntryIndex m_index;
 		QDateTime m_lastModified;
 		QString m_fileName;
 		QString m_displayName;
+		qint64 m_indexedSize;
+		qint64 m_nextLineNumber;
+		QByteArray m_tailChecksum;
 };
 
 #endif // PGN_DATABASE_H
@@ -18,7 +18,11 @@
 
 #include "pgngameentrymodel.h"
 #include <QtConcurrentFilter>
+#include <QtConcurrentRun>
+#include <algorithm>
 #include <pgngameentry.h>
+#include <pgngameentryindex.h>
+#include <pgntagtable.h>
 
 
 struct EntryContains
@@ -38,22 +42,77 @@ struct EntryContains
 	PgnGameFilter m_filter;
 };
 
+static QVector<int> sortRows(const QList<const PgnGameEntry*>& entries,
+			     const QList<int>& rows,
+			     PgnGameEntry::TagType type,
+			     Qt::SortOrder order)
+{
+	// Rank the distinct tag values, then sort the rows by their
+	// ranks with a stable counting sort
+	QHash<int, int> ranks;
+	for (int row : rows)
+		ranks.insert(entries.at(row)->tagId(type), 0);
+
+	QVector<QPair<QString, int>> values;
+	values.reserve(ranks.size());
+	const PgnTagTable* table = PgnTagTable::instance();
+	for (auto it = ranks.constBegin(); it != ranks.constEnd(); ++it)
+		values.append(qMakePair(QString(table->value(it.key())), it.key()));
+	std::sort(values.begin(), values.end(),
+		  [=](const QPair<QString, int>& a, const QPair<QString, int>& b)
+	{
+		int cmp = a.first.compare(b.first, Qt::CaseInsensitive);
+		if (cmp == 0)
+			cmp = a.first.compare(b.first);
+		return order == Qt::AscendingOrder ? cmp < 0 : cmp > 0;
+	});
+	for (int i = 0; i < values.size(); i++)
+		ranks[values.at(i).second] = i;
+
+	QVector<int> rowRanks;
+	rowRanks.reserve(rows.size());
+	QVector<int> offsets(values.size() + 1, 0);
+	for (int row : rows)
+	{
+		int rank = ranks.value(entries.at(row)->tagId(type));
+		rowRanks.append(rank);
+		offsets[rank + 1]++;
+	}
+	for (int i = 1; i < offsets.size(); i++)
+		offsets[i] += offsets[i - 1];
+
+	QVector<int> sorted(rows.size());
+	for (int i = 0; i < rows.size(); i++)
+		sorted[offsets[rowRanks.at(i)]++] = rows.at(i);
+	return sorted;
+}
+
 
 PgnGameEntryModel::PgnGameEntryModel(QObject* parent)
 	: QAbstractItemModel(parent),
-	  m_entryCount(0)
+	  m_hasSubset(false),
+	  m_entryCount(0),
+	  m_sortColumn(-1),
+	  m_sortOrder(Qt::AscendingOrder),
+	  m_strings(4096)
 {
 	connect(&m_watcher, SIGNAL(resultsReadyAt(int,int)),
 		this, SLOT(onResultsReady()));
+	connect(&m_watcher, SIGNAL(finished()),
+		this, SLOT(onFilterFinished()));
+	connect(&m_sortWatcher, SIGNAL(finished()),
+		this, SLOT(onSortFinished()));
 }
 
 const PgnGameEntry* PgnGameEntryModel::entryAt(int row) const
 {
-	return m_entries.at(m_filtered.resultAt(row));
+	return m_entries.at(sourceIndex(row));
 }
 
 int PgnGameEntryModel::sourceIndex(int row) const
 {
+	if (!m_sortedRows.isEmpty())
+		return m_sortedRows.at(row);
 	return m_filtered.resultAt(row);
 }
 
@@ -62,12 +121,14 @@ int PgnGameEntryModel::entryCount() const
 	return m_filtered.resultCount();
 }
 
-void PgnGameEntryModel::setEntries(const QList<const PgnGameEntry*>& entries)
+void PgnGameEntryModel::setEntries(const QList<const PgnGameEntry*>& entries,
+				   const QList<const PgnGameEntryIndex*>& indexes)
 {
-	m_watcher.cancel();
-	m_watcher.waitForFinished();
+	waitForWorkers();
 
 	m_entries = entries;
+	m_entryIndexes = indexes;
+	m_hasSubset = false;
 
 	if (entries.size() > m_indexes.size())
 	{
@@ -79,34 +140,180 @@ void PgnGameEntryModel::setEntries(const QList<const PgnGameEntry*>& entries)
 	applyFilter(m_filter);
 }
 
+void PgnGameEntryModel::waitForWorkers()
+{
+	m_watcher.cancel();
+	m_watcher.waitForFinished();
+	m_sortWatcher.waitForFinished();
+	// Discards the signals of a finished sort
+	m_sortWatcher.setFuture(QFuture<QVector<int>>());
+}
+
 void PgnGameEntryModel::onResultsReady()
 {
 	if (m_entryCount < 1024)
 		fetchMore(QModelIndex());
 }
 
+void PgnGameEntryModel::onFilterFinished()
+{
+	if (m_sortColumn >= 0 && !m_filtered.isCanceled())
+		startSort();
+}
+
+void PgnGameEntryModel::startSort()
+{
+	auto type = PgnGameEntry::TagType(m_sortColumn);
+	m_sortWatcher.setFuture(QtConcurrent::run(sortRows, m_entries,
+		m_filtered.results(), type, m_sortOrder));
+}
+
+void PgnGameEntryModel::onSortFinished()
+{
+	// Only the results of the current filter and sort order are used
+	if (m_sortWatcher.isCanceled() || m_sortColumn < 0
+	||  !m_filtered.isFinished() || m_filtered.isCanceled())
+		return;
+
+	QVector<int> rows(m_sortWatcher.result());
+	if (rows.size() == m_filtered.resultCount())
+		setSortedRows(rows);
+}
+
+void PgnGameEntryModel::setSortedRows(const QVector<int>& rows)
+{
+	emit layoutAboutToBeChanged();
+
+	const QModelIndexList oldIndexes(persistentIndexList());
+	QVector<int> sources;
+	sources.reserve(oldIndexes.size());
+	for (const QModelIndex& index : oldIndexes)
+		sources.append(sourceIndex(index.row()));
+
+	m_sortedRows = rows;
+
+	if (!oldIndexes.isEmpty())
+	{
+		QHash<int, int> newRows;
+		for (int source : qAsConst(sources))
+			newRows.insert(source, -1);
+		for (int i = 0; i < m_filtered.resultCount(); i++)
+		{
+			auto it = newRows.find(sourceIndex(i));
+			if (it != newRows.end())
+				it.value() = i;
+		}
+
+		QModelIndexList newIndexes;
+		for (int i = 0; i < oldIndexes.size(); i++)
+		{
+			int row = newRows.value(sources.at(i));
+			if (row >= 0 && row < m_entryCount)
+				newIndexes.append(index(row, oldIndexes.at(i).column()));
+			else
+				newIndexes.append(QModelIndex());
+		}
+		changePersistentIndexList(oldIndexes, newIndexes);
+	}
+
+	emit layoutChanged();
+}
+
+void PgnGameEntryModel::sort(int column, Qt::SortOrder order)
+{
+	if (column >= columnCount())
+		return;
+
+	m_sortWatcher.waitForFinished();
+	m_sortColumn = column;
+	m_sortOrder = order;
+
+	if (column < 0)
+	{
+		if (!m_sortedRows.isEmpty())
+			setSortedRows(QVector<int>());
+	}
+	else if (m_filtered.isFinished())
+		startSort();
+}
+
 void PgnGameEntryModel::applyFilter(const PgnGameFilter& filter)
 {
 	beginResetModel();
 	m_entryCount = 0;
-
-	m_filtered = QtConcurrent::filtered(m_indexes.constBegin(),
-					    m_indexes.constBegin() + m_entries.size(),
-					    EntryContains(m_entries, filter));
+	m_sortedRows.clear();
+
+	// Match the search terms against each distinct tag value once,
+	// the copies of the filter used by the worker threads share
+	// the results
+	PgnGameFilter preparedFilter(filter);
+	preparedFilter.prepare();
+
+	if (findCandidates(preparedFilter))
+		m_filtered = QtConcurrent::filtered(m_candidates.constBegin(),
+						    m_candidates.constEnd(),
+						    EntryContains(m_entries, preparedFilter));
+	else
+		m_filtered = QtConcurrent::filtered(m_indexes.constBegin(),
+						    m_indexes.constBegin() + m_entries.size(),
+						    EntryContains(m_entries, preparedFilter));
 
 	m_watcher.setFuture(m_filtered);
 	endResetModel();
 }
 
+bool PgnGameEntryModel::findCandidates(const PgnGameFilter& filter)
+{
+	m_candidates.clear();
+
+	if (m_hasSubset)
+	{
+		m_candidates = m_subset;
+		return true;
+	}
+
+	int count = 0;
+	for (const PgnGameEntryIndex* index : qAsConst(m_entryIndexes))
+		count += index->entryCount();
+	if (m_entryIndexes.isEmpty() || count != m_entries.size())
+		return false;
+
+	int offset = 0;
+	QVector<int> candidates;
+	for (const PgnGameEntryIndex* index : qAsConst(m_entryIndexes))
+	{
+		if (!index->candidates(filter, &candidates))
+		{
+			m_candidates.clear();
+			return false;
+		}
+		for (int candidate : qAsConst(candidates))
+			m_candidates.append(offset + candidate);
+		offset += index->entryCount();
+	}
+
+	return true;
+}
+
 void PgnGameEntryModel::setFilter(const PgnGameFilter& filter)
 {
-	m_watcher.cancel();
-	m_watcher.waitForFinished();
+	waitForWorkers();
 
 	m_filter = filter;
+	m_hasSubset = false;
 	applyFilter(filter);
 }
 
+void PgnGameEntryModel::setEntrySubset(const QVector<int>& entries)
+{
+	waitForWorkers();
+
+	m_filter = PgnGameFilter();
+	m_subset = entries;
+	m_hasSubset = true;
+	applyFilter(m_filter);
+}
+
 QModelIndex PgnGameEntryModel::index(int row, int column,
 				 const QModelIndex& parent) const
 {
@@ -150,7 +357,17 @@ QVariant PgnGameEntryModel::data(const QModelIndex& index, int role) const
 	if (role == Qt::DisplayRole || role == Qt::EditRole)
 	{
 		PgnGameEntry::TagType tagType = PgnGameEntry::TagType(index.column());
-		return entryAt(index.row())->tagValue(tagType);
+		int id = entryAt(index.row())->tagId(tagType);
+		if (id == 0)
+			return QString();
+
+		QString* str = m_strings.object(id);
+		if (str == nullptr)
+		{
+			str = new QString(PgnTagTable::instance()->value(id));
+			m_strings.insert(id, str);
+		}
+		return *str;
 	}
 
 	return QVariant();
@@ -23,11 +23,18 @@
 #include <QList>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QCache>
 #include <pgngamefilter.h>
 class PgnGameEntry;
+class PgnGameEntryIndex;
 
 /*!
  * \brief Supplies PGN game entry information to views.
+ *
+ * Filtering and sorting run in worker threads. The rows matching the
+ * filter are shown as they are found, and are rearranged when they
+ * have been sorted. Sorting uses the interned tag IDs of the entries,
+ * so only the distinct tag values are compared as strings.
  */
 class PgnGameEntryModel : public QAbstractItemModel
 {
@@ -52,8 +59,17 @@ class PgnGameEntryModel : public QAbstractItemModel
 		 * \a row in the model.
 		 */
 		int sourceIndex(int row) const;
-		/*! Associates a list of PGN game entries with this model. */
-		void setEntries(const QList<const PgnGameEntry*>& entries);
+		/*!
+		 * Associates a list of PGN game entries with this model.
+		 *
+		 * \a indexes are the search indexes of consecutive parts of
+		 * \a entries, eg. of each database whose entries are listed.
+		 * If they are given, filtering only matches the entries found
+		 * through the indexes.
+		 */
+		void setEntries(const QList<const PgnGameEntry*>& entries,
+				const QList<const PgnGameEntryIndex*>& indexes =
+					QList<const PgnGameEntryIndex*>());
 
 		// Inherited from QAbstractItemModel
 		virtual QModelIndex index(int row, int column,
@@ -64,10 +80,25 @@ class PgnGameEntryModel : public QAbstractItemModel
 		virtual QVariant data(const QModelIndex& index, int role) const;
 		virtual QVariant headerData(int section, Qt::Orientation orientation,
 					    int role = Qt::DisplayRole) const;
+		/*!
+		 * Sorts the entries by \a column in \a order.
+		 *
+		 * Entries with equal values keep their original order. A
+		 * negative \a column restores the original order.
+		 */
+		virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
 
 	public slots:
 		/*! Sets the filter for filtering the contents of the database. */
 		void setFilter(const PgnGameFilter& filter);
+		/*!
+		 * Shows only the entries whose source indexes are in
+		 * \a entries, which must be in ascending order.
+		 *
+		 * The next call to setFilter() or setEntries() shows
+		 * all entries again.
+		 */
+		void setEntrySubset(const QVector<int>& entries);
 
 	protected:
 		// Inherited from QAbstractItemModel
@@ -76,16 +107,33 @@ class PgnGameEntryModel : public QAbstractItemModel
 
 	private slots:
 		void onResultsReady();
+		void onFilterFinished();
+		void onSortFinished();
 
 	private:
 		void applyFilter(const PgnGameFilter& filter);
+		bool findCandidates(const PgnGameFilter& filter);
+		void startSort();
+		void setSortedRows(const QVector<int>& rows);
+		void waitForWorkers();
 
 		QList<const PgnGameEntry*> m_entries;
+		QList<const PgnGameEntryIndex*> m_entryIndexes;
 		QVector<int> m_indexes;
+		QVector<int> m_candidates;
+		QVector<int> m_subset;
+		bool m_hasSubset;
 		int m_entryCount;
 		QFuture<int> m_filtered;
 		QFutureWatcher<int> m_watcher;
 		PgnGameFilter m_filter;
+		int m_sortColumn;
+		Qt::SortOrder m_sortOrder;
+		// Source indexes of the filtered entries in sorted order
+		QVector<int> m_sortedRows;
+		QFutureWatcher<QVector<int>> m_sortWatcher;
+		// Display strings by tag ID
+		mutable QCache<int, QString> m_strings;
 };
 
 #endif // PGN_GAME_ENTRY_MODEL_H
@@ -20,14 +20,70 @@
 
 #include <QFile>
 #include <QFileInfo>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QtConcurrentRun>
+#include <cstring>
 
 #include <pgnstream.h>
+#include <pgnchunkreader.h>
+#include <pgngame.h>
 #include <pgngameentry.h>
+#include <positionindexwriter.h>
 #include "pgndatabase.h"
+#include "taskpool.h"
 
-PgnImporter::PgnImporter(const QString& fileName)
+namespace {
+
+// Smaller databases are imported by a single thread
+const qint64 s_minParallelSize = 32 * 1024 * 1024;
+// The import status is reported after every this many games
+const int s_updateInterval = 1024;
+
+struct Chunk
+{
+	qint64 start;
+	qint64 end;
+	qint64 lineNumber;
+};
+
+// Returns the chunks of the \a size bytes of PGN \a data for at
+// most \a count threads
+QVector<Chunk> splitPgn(const char* data, qint64 size, int count)
+{
+	QVector<Chunk> chunks;
+	const auto ranges = PgnChunkReader::split(data, size, count);
+	for (const PgnChunkReader::Range& range: ranges)
+	{
+		Chunk chunk = { range.start, range.end, 1 };
+		chunks.append(chunk);
+	}
+	return chunks;
+}
+
+qint64 countLines(const char* data, qint64 start, qint64 end)
+{
+	qint64 count = 0;
+	const char* p = data + start;
+	const char* last = data + end;
+	while ((p = (const char*)memchr(p, '\n', size_t(last - p))) != nullptr)
+	{
+		count++;
+		p++;
+	}
+	return count;
+}
+
+} // anonymous namespace
+
+PgnImporter::PgnImporter(const QString& fileName,
+			 qint64 startPos,
+			 qint64 startLineNumber)
 	: Worker(QString("PGN import: %1").arg(fileName)),
-	  m_fileName(fileName)
+	  m_fileName(fileName),
+	  m_startPos(startPos),
+	  m_startLineNumber(startLineNumber),
+	  m_firstGame(0)
 {
 }
 
@@ -36,11 +92,49 @@ QString PgnImporter::fileName() const
 	return m_fileName;
 }
 
+void PgnImporter::setPositionIndex(const QString& fileName, int firstGame)
+{
+	m_positionIndexFile = fileName;
+	m_firstGame = firstGame;
+}
+
+bool PgnImporter::indexPositions(const QList<const PgnGameEntry*>& games)
+{
+	if (m_positionIndexFile.isEmpty())
+		return true;
+
+	QFile file(m_fileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return false;
+
+	// Only one game is replayed at a time, the positions are
+	// sorted in bounded runs by the writer
+	PgnStream in(&file);
+	PositionIndexWriter writer(m_positionIndexFile);
+	if (m_firstGame > 0)
+		writer.setBaseIndex(m_positionIndexFile);
+
+	quint32 number = quint32(m_firstGame);
+	for (const PgnGameEntry* entry : games)
+	{
+		if (cancelRequested())
+			return false;
+
+		// The stream's board is left in the final position
+		PgnGame game;
+		if (in.seek(entry->pos(), entry->lineNumber())
+		&&  game.read(in, INT_MAX - 1, false))
+			writer.addGame(number, game, in.board()->key());
+		number++;
+	}
+
+	return writer.finish();
+}
+
 void PgnImporter::work()
 {
 	QFile file(m_fileName);
 	QFileInfo fileInfo(m_fileName);
-	static const int updateInterval = 1024;
 	int numReadGames = 0;
 
 	if (!fileInfo.exists())
@@ -55,8 +149,50 @@ void PgnImporter::work()
 		return;
 	}
 
+	int threadCount = TaskPool::pool()->maxThreadCount();
+	if (m_startPos == 0 && threadCount > 1
+	&&  file.size() >= s_minParallelSize)
+	{
+		const qint64 size = file.size();
+		const char* data = (const char*)file.map(0, size);
+		if (data != nullptr)
+		{
+			QList<const PgnGameEntry*> games;
+			qint64 lineNumber = 1;
+			bool ok = readParallel(data, size, threadCount,
+					       &games, &lineNumber);
+			file.unmap((uchar*)data);
+
+			if (!ok)
+			{
+				qDeleteAll(games);
+				if (!cancelRequested())
+					emit error(PgnImporter::IoError);
+				return;
+			}
+
+			if (!indexPositions(games))
+				qWarning("Could not index the positions of %s",
+					 qUtf8Printable(m_fileName));
+
+			PgnDatabase* db = new PgnDatabase(m_fileName);
+			db->setEntries(games);
+			db->setLastModified(fileInfo.lastModified());
+			db->setIndexedRange(size, lineNumber,
+			    PgnDatabase::checksumBefore(m_fileName, size));
+
+			emit databaseRead(db);
+			return;
+		}
+	}
+
 	PgnStream pgnStream(&file);
 	QList<const PgnGameEntry*> games;
+	if (m_startPos > 0 && !pgnStream.seek(m_startPos, m_startLineNumber))
+	{
+		emit error(PgnImporter::IoError);
+		return;
+	}
 
 	for (;;)
 	{
@@ -70,13 +206,99 @@ void PgnImporter::work()
 		games << game;
 		numReadGames++;
 
-		if (numReadGames % updateInterval == 0)
+		if (numReadGames % s_updateInterval == 0)
 			emit databaseReadStatus(startTime(), numReadGames,
 			    pgnStream.pos());
 	}
+	if (!cancelRequested() && !indexPositions(games))
+		qWarning("Could not index the positions of %s",
+			 qUtf8Printable(m_fileName));
+
 	PgnDatabase* db = new PgnDatabase(m_fileName);
 	db->setEntries(games);
 	db->setLastModified(fileInfo.lastModified());
+	db->setIndexedRange(pgnStream.pos(), pgnStream.lineNumber(),
+	    PgnDatabase::checksumBefore(m_fileName, pgnStream.pos()));
 
 	emit databaseRead(db);
 }
+
+bool PgnImporter::readParallel(const char* data,
+			       qint64 size,
+			       int threadCount,
+			       QList<const PgnGameEntry*>* games,
+			       qint64* nextLineNumber)
+{
+	// The chunks are queued to the pool shared with the other
+	// imports, so importing many files at once doesn't start more
+	// threads than there are cores
+	QVector<Chunk> chunks = splitPgn(data, size, threadCount);
+	QThreadPool* pool = TaskPool::pool();
+
+	// The line number of each chunk is the number of lines
+	// in the preceding chunks plus one
+	QList<QFuture<qint64>> lineCounts;
+	for (const Chunk& chunk: qAsConst(chunks))
+		lineCounts << QtConcurrent::run(pool, countLines, data,
+						chunk.start, chunk.end);
+	for (int i = 1; i < chunks.size(); i++)
+		chunks[i].lineNumber = chunks[i - 1].lineNumber
+				     + lineCounts.at(i - 1).result();
+	*nextLineNumber = chunks.last().lineNumber
+			+ lineCounts.last().result();
+
+	QAtomicInt numReadGames(0);
+	QAtomicInteger<qint64> numReadBytes(0);
+	QAtomicInt failed(0);
+	const QString fileName = m_fileName;
+	auto index = [&](const Chunk& chunk)
+	{
+		QList<const PgnGameEntry*> entries;
+		QFile file(fileName);
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		{
+			failed.storeRelease(1);
+			return entries;
+		}
+
+		PgnStream pgnStream(&file);
+		if (!pgnStream.seek(chunk.start, chunk.lineNumber))
+		{
+			failed.storeRelease(1);
+			return entries;
+		}
+
+		qint64 pos = chunk.start;
+		while (!cancelRequested() && !failed.loadAcquire())
+		{
+			PgnGameEntry* game = new PgnGameEntry;
+			if (!game->read(pgnStream) || game->pos() >= chunk.end)
+			{
+				delete game;
+				break;
+			}
+
+			entries << game;
+			const int count = numReadGames.fetchAndAddRelaxed(1) + 1;
+			const qint64 bytes = numReadBytes.fetchAndAddRelaxed(
+				pgnStream.pos() - pos) + pgnStream.pos() - pos;
+			pos = pgnStream.pos();
+
+			if (count % s_updateInterval == 0)
+				emit databaseReadStatus(startTime(), count, bytes);
+		}
+		return entries;
+	};
+
+	QList<QFuture<QList<const PgnGameEntry*>>> results;
+	for (const Chunk& chunk: qAsConst(chunks))
+		results << QtConcurrent::run(pool, index, chunk);
+
+	// Merge the entries in file order. Waiting for a chunk that
+	// hasn't started yet runs it in this thread, so the import
+	// can't stall behind other tasks that are queued to the pool.
+	for (const auto& result: qAsConst(results))
+		*games << result.result();
+
+	return !failed.loadAcquire() && !cancelRequested();
+}
@@ -22,6 +22,7 @@
 #include <worker.h>
 
 class PgnDatabase;
+class PgnGameEntry;
 
 /*!
  * \brief Reads PGN database in a separate thread.
@@ -43,10 +44,28 @@ class PgnImporter : public Worker
 		/*!
 		 * Constructs a PgnImporter with \a fileName as
 		 * database to be imported.
+		 *
+		 * The import starts at byte position \a startPos, which is
+		 * on line \a startLineNumber. A nonzero \a startPos is used
+		 * to index only the games that were appended to a database
+		 * after it was last imported.
 		 */
-		PgnImporter(const QString& fileName);
+		PgnImporter(const QString& fileName,
+			    qint64 startPos = 0,
+			    qint64 startLineNumber = 1);
 		/*! Returns the file name of the database to be imported. */
 		QString fileName() const;
+		/*!
+		 * Makes the importer replay the imported games and write
+		 * their positions to position index file \a fileName.
+		 *
+		 * The first imported game is game number \a firstGame in
+		 * the index. If \a firstGame is nonzero the positions are
+		 * added to the existing index.
+		 *
+		 * \sa PositionIndex
+		 */
+		void setPositionIndex(const QString& fileName, int firstGame = 0);
 
 	protected:
 		void work() override;
@@ -63,7 +82,18 @@ class PgnImporter : public Worker
 		void databaseReadStatus(const QTime& started, int numReadGames, qint64 numReadBytes);
 
 	private:
+		bool indexPositions(const QList<const PgnGameEntry*>& games);
+		bool readParallel(const char* data,
+				  qint64 size,
+				  int threadCount,
+				  QList<const PgnGameEntry*>* games,
+				  qint64* nextLineNumber);
+
 		QString m_fileName;
+		qint64 m_startPos;
+		qint64 m_startLineNumber;
+		QString m_positionIndexFile;
+		int m_firstGame;
 
 };
 
@@ -24,17 +24,118 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QTextStream>
+#include <QTimer>
+#include <QInputDialog>
 
 PlainTextLog::PlainTextLog(QWidget* parent)
 	: QPlainTextEdit(parent)
 {
-	setReadOnly(true);
+	init();
 }
 
 PlainTextLog::PlainTextLog(const QString& text, QWidget* parent)
 	: QPlainTextEdit(text, parent)
+{
+	init();
+}
+
+PlainTextLog::~PlainTextLog()
+{
+	delete m_logFile;
+}
+
+void PlainTextLog::init()
 {
 	setReadOnly(true);
+	setUndoRedoEnabled(false);
+
+	m_logFile = nullptr;
+	m_flushTimer = new QTimer(this);
+	m_flushTimer->setSingleShot(true);
+	m_flushTimer->setInterval(200);
+	connect(m_flushTimer, SIGNAL(timeout()), this, SLOT(flushMessages()));
+}
+
+int PlainTextLog::capacity() const
+{
+	return maximumBlockCount();
+}
+
+void PlainTextLog::setCapacity(int lines)
+{
+	setMaximumBlockCount(qMax(lines, 0));
+}
+
+QString PlainTextLog::filter() const
+{
+	return m_filter;
+}
+
+void PlainTextLog::setFilter(const QString& text)
+{
+	m_filter = text;
+}
+
+bool PlainTextLog::setLogFile(const QString& fileName)
+{
+	delete m_logFile;
+	m_logFile = nullptr;
+	if (fileName.isEmpty())
+		return true;
+
+	m_logFile = new QFile(fileName);
+	if (!m_logFile->open(QFile::WriteOnly | QFile::Append | QFile::Text))
+	{
+		qWarning("Cannot open log file %s: %s",
+			 qUtf8Printable(fileName),
+			 qUtf8Printable(m_logFile->errorString()));
+		delete m_logFile;
+		m_logFile = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void PlainTextLog::appendMessage(const QString& message)
+{
+	if (!m_filter.isEmpty() && !message.contains(m_filter))
+		return;
+
+	if (m_logFile != nullptr)
+	{
+		QByteArray data(message.toUtf8());
+		data.append('\n');
+		m_logFile->write(data);
+	}
+
+	// Lines that would be removed from a full log right away are
+	// not queued at all
+	m_pendingMessages.append(message);
+	const int max = capacity();
+	if (max > 0 && m_pendingMessages.size() > max)
+		m_pendingMessages.removeFirst();
+
+	if (!m_flushTimer->isActive())
+		m_flushTimer->start();
+}
+
+void PlainTextLog::flushMessages()
+{
+	if (m_pendingMessages.isEmpty())
+		return;
+
+	appendPlainText(m_pendingMessages.join('\n'));
+	m_pendingMessages.clear();
+
+	if (m_logFile != nullptr)
+		m_logFile->flush();
+}
+
+void PlainTextLog::clear()
+{
+	m_pendingMessages.clear();
+	m_flushTimer->stop();
+	QPlainTextEdit::clear();
 }
 
 void PlainTextLog::contextMenuEvent(QContextMenuEvent* event)
@@ -44,6 +145,17 @@ void PlainTextLog::contextMenuEvent(QContextMenuEvent* event)
 	menu->addSeparator();
 	menu->addAction(tr("Clear Log"), this, SLOT(clear()));
 
+	auto filterAct = menu->addAction(tr("Filter..."));
+	connect(filterAct, &QAction::triggered, this, [=]()
+	{
+		bool ok;
+		QString text = QInputDialog::getText(this, tr("Filter Log"),
+			tr("Show only lines that contain:"), QLineEdit::Normal,
+			m_filter, &ok);
+		if (ok)
+			setFilter(text);
+	});
+
 	menu->addSeparator();
 	auto saveAct = menu->addAction(tr("Save Log to File..."));
 	connect(saveAct, &QAction::triggered, this, [=]()
@@ -65,6 +177,7 @@ void PlainTextLog::saveLogToFile(const QString& fileName)
 	if (fileName.isEmpty())
 		return;
 
+	flushMessages();
 	QFile file(fileName);
 	if (!file.open(QFile::WriteOnly | QFile::Text))
 	{
@@ -20,12 +20,20 @@
 #define PLAIN_TEXT_LOG_H
 
 #include <QPlainTextEdit>
+#include <QStringList>
 
 class QContextMenuEvent;
 class QAction;
+class QTimer;
+class QFile;
 
 /*!
  * \brief Widget that is used to display log messages in plain text.
+ *
+ * Messages added with appendMessage() are shown in batches a few
+ * times per second. Only the last capacity() lines are kept, but all
+ * of them can be written to a log file as well. A filter can be used
+ * to drop unwanted messages before they reach the widget.
  */
 class PlainTextLog : public QPlainTextEdit
 {
@@ -39,15 +47,60 @@ class PlainTextLog : public QPlainTextEdit
 		 * given \a parent.
 		 */
 		PlainTextLog(const QString& text, QWidget* parent = nullptr);
+		/*! Destroys the log and closes the log file. */
+		virtual ~PlainTextLog();
+
+		/*!
+		 * Returns the maximum number of lines shown.
+		 *
+		 * The default is 0, meaning that there is no limit.
+		 */
+		int capacity() const;
+		/*!
+		 * Sets the maximum number of lines shown to \a lines.
+		 * The oldest lines are removed when the log is full.
+		 */
+		void setCapacity(int lines);
+		/*! Returns the filter text. */
+		QString filter() const;
+		/*!
+		 * Shows only messages that contain \a text.
+		 *
+		 * Engine debug messages start with the engine's name, so
+		 * eg. the name of an engine shows the output of that engine
+		 * only. An empty \a text shows all messages.
+		 */
+		void setFilter(const QString& text);
+		/*!
+		 * Appends all messages that pass the filter to the file
+		 * \a fileName. An empty \a fileName closes the log file.
+		 *
+		 * Returns true if successful.
+		 */
+		bool setLogFile(const QString& fileName);
 
 	public slots:
 		/*! Save the log to file \a filename. */
 		void saveLogToFile(const QString& fileName);
+		/*! Adds \a message to the end of the log. */
+		void appendMessage(const QString& message);
+		/*! Clears the log, including messages that are not shown yet. */
+		void clear();
 
 	protected:
 		// Inherited from QPlainTextEdit
 		virtual void contextMenuEvent(QContextMenuEvent* event);
 
+	private slots:
+		void flushMessages();
+
+	private:
+		void init();
+
+		QStringList m_pendingMessages;
+		QTimer* m_flushTimer;
+		QString m_filter;
+		QFile* m_logFile;
 };
 
 #endif // PLAIN_TEXT_LOG_H
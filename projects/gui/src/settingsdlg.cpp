@@ -23,6 +23,7 @@
 #include <QFileDialog>
 #include <gamemanager.h>
 #include "cutechessapp.h"
+#include "clockticker.h"
 
 SettingsDialog::SettingsDialog(QWidget* parent)
 	: QDialog(parent),
@@ -56,6 +57,18 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 		QSettings().setValue("ui/display_players_sides_on_clocks", checked);
 	});
 
+	connect(ui->m_moveListTableViewCheck, &QCheckBox::toggled,
+		this, [=](bool checked)
+	{
+		QSettings().setValue("ui/move_list_table_view", checked);
+	});
+
+	connect(ui->m_gameWallOpenGlCheck, &QCheckBox::toggled,
+		this, [=](bool checked)
+	{
+		QSettings().setValue("ui/game_wall_opengl", checked);
+	});
+
 
 	connect(ui->m_humanCanPlayAfterTimeoutCheck, &QCheckBox::toggled,
 		[=](bool checked)
@@ -64,6 +77,12 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 				      checked);
 	});
 
+	connect(ui->m_indexPositionsCheck, &QCheckBox::toggled,
+		[=](bool checked)
+	{
+		QSettings().setValue("games/index_positions", checked);
+	});
+
 
 	connect(ui->m_concurrencySpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
 		this, [=](int value)
@@ -90,6 +109,37 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 		QSettings().setValue("ui/tb_path", tbPath);
 	});
 
+	connect(ui->m_gameWallFpsSpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+		this, [=](int value)
+	{
+		QSettings().setValue("ui/game_wall_fps", value);
+	});
+
+	connect(ui->m_engineDebugLogLinesSpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+		this, [=](int value)
+	{
+		QSettings().setValue("ui/engine_debug_log_lines", value);
+	});
+
+	connect(ui->m_evalPvHistorySpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+		this, [=](int value)
+	{
+		QSettings().setValue("ui/eval_pv_history", value);
+	});
+
+	connect(ui->m_clockUpdateIntervalSpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+		this, [=](int value)
+	{
+		QSettings().setValue("ui/clock_update_interval", value);
+		ClockTicker::instance()->setInterval(value);
+	});
+
+	connect(ui->m_engineDebugLogFileEdit, &QLineEdit::textChanged,
+		[=](const QString& fileName)
+	{
+		QSettings().setValue("ui/engine_debug_log_file", fileName);
+	});
+
 	connect(ui->m_tournamentDefaultPgnOutFileEdit, &QLineEdit::textChanged,
 		[=](const QString& tourFile)
 	{
@@ -205,7 +255,19 @@ void SettingsDialog::readSettings()
 		s.value("use_full_user_name", true).toBool());
 	ui->m_playersSidesOnClocksCheck->setChecked(
 		s.value("display_players_sides_on_clocks", false).toBool());
+	ui->m_moveListTableViewCheck->setChecked(
+		s.value("move_list_table_view", false).toBool());
+	ui->m_gameWallOpenGlCheck->setChecked(
+		s.value("game_wall_opengl", false).toBool());
 	ui->m_tbPathEdit->setText(s.value("tb_path").toString());
+	ui->m_gameWallFpsSpin->setValue(s.value("game_wall_fps", 10).toInt());
+	ui->m_engineDebugLogLinesSpin->setValue(
+		s.value("engine_debug_log_lines", 10000).toInt());
+	ui->m_engineDebugLogFileEdit->setText(
+		s.value("engine_debug_log_file").toString());
+	ui->m_evalPvHistorySpin->setValue(s.value("eval_pv_history", 0).toInt());
+	ui->m_clockUpdateIntervalSpin->setValue(
+		s.value("clock_update_interval", 1000).toInt());
 	s.endGroup();
 
 	s.beginGroup("pgn");
@@ -215,6 +277,8 @@ void SettingsDialog::readSettings()
 	s.beginGroup("games");
 	ui->m_humanCanPlayAfterTimeoutCheck
 		->setChecked(s.value("human_can_play_after_timeout", true).toBool());
+	ui->m_indexPositionsCheck
+		->setChecked(s.value("index_positions", false).toBool());
 	ui->m_defaultPgnOutFileEdit
 		->setText(s.value("default_pgn_output_file").toString());
 	s.endGroup();
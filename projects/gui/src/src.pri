@@ -1,6 +1,7 @@
 include(boardview/boardview.pri)
 DEPENDPATH += $$PWD
 HEADERS += $$PWD/chessclock.h \
+    $$PWD/clockticker.h \
     $$PWD/engineconfigurationmodel.h \
     $$PWD/engineconfigurationdlg.h \
     $$PWD/mainwindow.h \
@@ -29,6 +30,7 @@ HEADERS += $$PWD/chessclock.h \
     $$PWD/gameviewer.h \
     $$PWD/pathlineedit.h \
     $$PWD/threadedtask.h \
+    $$PWD/taskpool.h \
     $$PWD/stringvalidator.h \
     $$PWD/pgntoken.h \
     $$PWD/movenumbertoken.h \
@@ -40,10 +42,13 @@ HEADERS += $$PWD/chessclock.h \
     $$PWD/settingsdlg.h \
     $$PWD/enginemanagementwidget.h \
     $$PWD/tournamentresultsdlg.h \
+    $$PWD/tournamentresultsmodel.h \
+    $$PWD/guiprofiler.h \
     $$PWD/gamesettingswidget.h \
     $$PWD/tournamentsettingswidget.h
 SOURCES += $$PWD/main.cpp \
     $$PWD/chessclock.cpp \
+    $$PWD/clockticker.cpp \
     $$PWD/engineconfigurationmodel.cpp \
     $$PWD/engineconfigurationdlg.cpp \
     $$PWD/mainwindow.cpp \
@@ -72,6 +77,7 @@ SOURCES += $$PWD/main.cpp \
     $$PWD/gameviewer.cpp \
     $$PWD/pathlineedit.cpp \
     $$PWD/threadedtask.cpp \
+    $$PWD/taskpool.cpp \
     $$PWD/stringvalidator.cpp \
     $$PWD/pgntoken.cpp \
     $$PWD/movenumbertoken.cpp \
@@ -83,5 +89,7 @@ SOURCES += $$PWD/main.cpp \
     $$PWD/settingsdlg.cpp \
     $$PWD/enginemanagementwidget.cpp \
     $$PWD/tournamentresultsdlg.cpp \
+    $$PWD/tournamentresultsmodel.cpp \
+    $$PWD/guiprofiler.cpp \
     $$PWD/gamesettingswidget.cpp \
     $$PWD/tournamentsettingswidget.cpp
@@ -0,0 +1,31 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "taskpool.h"
+#include <QThreadPool>
+
+QThreadPool* TaskPool::pool()
+{
+	return QThreadPool::globalInstance();
+}
+
+void TaskPool::start(QRunnable* task, Priority priority)
+{
+	// QtConcurrent queues its jobs with priority 0, which makes
+	// them interactive
+	pool()->start(task, priority == Interactive ? 0 : -1);
+}
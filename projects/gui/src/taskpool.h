@@ -0,0 +1,60 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+class QRunnable;
+class QThreadPool;
+
+/*!
+ * \brief The thread pool shared by the GUI's background tasks
+ *
+ * Database imports, exports and game previews all run in the same
+ * pool, which has one thread per core, so running several of them at
+ * once doesn't oversubscribe the CPU. The pool is the global
+ * QThreadPool instance, so work started with QtConcurrent shares it
+ * as well.
+ *
+ * Queued tasks are started in priority order: interactive work, such
+ * as reading the game that is being previewed, goes ahead of bulk work
+ * that is waiting for a thread.
+ */
+class TaskPool
+{
+	public:
+		/*! The priority class of a task. */
+		enum Priority
+		{
+			Bulk,		//!< Long tasks, eg. imports and exports
+			Interactive	//!< Short tasks that the user waits for
+		};
+
+		/*! Returns the shared thread pool. */
+		static QThreadPool* pool();
+		/*!
+		 * Queues \a task to the shared pool with priority
+		 * \a priority. The pool takes ownership of \a task if
+		 * it is auto-deleted.
+		 */
+		static void start(QRunnable* task, Priority priority);
+
+	private:
+		TaskPool();
+};
+
+#endif // TASKPOOL_H
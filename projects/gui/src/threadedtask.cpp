@@ -22,12 +22,21 @@ ThreadedTask::ThreadedTask(const QString& title,
 			   const QString& labelText,
 			   int minimum,
 			   int maximum,
-			   QWidget* parent)
-	: QThread(parent),
-	  m_cancel(false),
+			   QWidget* parent,
+			   TaskPool::Priority priority)
+	: QObject(nullptr),
+	  m_priority(priority),
 	  m_statusMessage(labelText),
-	  m_taskStart(QTime::currentTime())
+	  m_taskStart(QTime::currentTime()),
+	  m_lastUpdate(0),
+	  m_minimum(minimum),
+	  m_progressStep(qMax(1, (maximum - minimum) / 100)),
+	  m_value(minimum),
+	  m_reportedValue(minimum)
 {
+	// The task is deleted in the GUI thread after it has finished
+	setAutoDelete(false);
+
 	m_dlg = new QProgressDialog(tr("%1 - Undefined time remaining").arg(labelText),
 						   tr("Cancel"),
 						   minimum,
@@ -38,8 +47,6 @@ ThreadedTask::ThreadedTask(const QString& title,
 	m_dlg->setMinimumDuration(1000);
 	m_dlg->setValue(0);
 
-	m_lastUpdate = 0;
-
 	connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
 	connect(this, SIGNAL(destroyed()), m_dlg, SLOT(deleteLater()));
 	connect(this, SIGNAL(progressValueChanged(int)),
@@ -53,24 +60,53 @@ ThreadedTask::~ThreadedTask()
 {
 }
 
+void ThreadedTask::start()
+{
+	TaskPool::start(this, m_priority);
+}
+
+void ThreadedTask::run()
+{
+	work();
+	emit progressValueChanged(m_value);
+	emit finished();
+}
+
 void ThreadedTask::cancel()
 {
-	m_cancel = true;
+	m_cancellationToken.cancel();
+}
+
+CancellationToken ThreadedTask::cancellationToken() const
+{
+	return m_cancellationToken;
 }
 
 bool ThreadedTask::cancelRequested() const
 {
-	return m_cancel;
+	return m_cancellationToken.isCancelled();
+}
+
+void ThreadedTask::setProgress(int value)
+{
+	m_value = value;
+	if (value - m_reportedValue >= m_progressStep)
+	{
+		m_reportedValue = value;
+		emit progressValueChanged(value);
+	}
 }
 
 void ThreadedTask::updateProgress(int value)
 {
 	int elapsed = m_taskStart.secsTo(QTime::currentTime());
 
-	if (elapsed > m_lastUpdate)
+	if (elapsed > m_lastUpdate && value > m_minimum)
 	{
 		m_lastUpdate = elapsed;
-		int remainingSecs = (m_dlg->maximum() - value) / (value / elapsed);
+		int done = value - m_minimum;
+		int remainingSecs = int(qint64(m_dlg->maximum() - value)
+					* elapsed / done);
 
 		m_dlg->setLabelText(QString("%1 - %2").arg(m_statusMessage,
 			humaniseTime(remainingSecs)));
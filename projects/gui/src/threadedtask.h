@@ -18,13 +18,16 @@
 #ifndef THREADEDTASK_H
 #define THREADEDTASK_H
 
-#include <QThread>
+#include <QObject>
+#include <QRunnable>
 #include <QTime>
+#include <cancellationtoken.h>
+#include "taskpool.h"
 class QWidget;
 class QProgressDialog;
 
 /*!
- * \brief A long task that is executed in its own thread.
+ * \brief A long task that is executed in the shared task pool.
  *
  * ThreadedTask is the base class for tasks that can take a long
  * time and should be executed in a separate thread. ThreadedTask
@@ -32,14 +35,18 @@ class QProgressDialog;
  * for the task.
  *
  * The ThreadedTask class should be extended by reimplementing
- * QThread::run() and checking for cancellation by calling
- * cancelRequested() periodically. The subclass should also notify
- * the progress dialog by emitting the progressValueChanged() signal.
+ * work() and checking for cancellation by calling cancelRequested()
+ * periodically. The subclass should also report its progress by
+ * calling setProgress(). The task runs in the thread pool shared by
+ * all background tasks of the GUI, so starting many tasks at once
+ * doesn't start more threads than there are cores.
  *
  * ThreadedTask destroys itself and the progress dialog automatically
  * after the task is finished or cancelled.
+ *
+ * \sa TaskPool
  */
-class ThreadedTask : public QThread
+class ThreadedTask : public QObject, public QRunnable
 {
 	Q_OBJECT
 
@@ -52,20 +59,33 @@ class ThreadedTask : public QThread
 		 * \a title, label text \a labelText, and a range from
 		 * \a minimum to \a maximum. The dialog is window modal and
 		 * its parent is set to \a parent.
+		 *
+		 * The task is queued with priority \a priority.
 		 */
 		explicit ThreadedTask(const QString& title,
 				      const QString& labelText,
 				      int minimum,
 				      int maximum,
-				      QWidget* parent);
+				      QWidget* parent,
+				      TaskPool::Priority priority = TaskPool::Bulk);
 		/*! Destroys the task and its progress dialog. */
 		virtual ~ThreadedTask();
 
+		/*! Queues the task to the shared task pool. */
+		void start();
+		/*!
+		 * Returns the task's cancellation token, which is
+		 * cancelled when the user presses the "cancel" button.
+		 */
+		CancellationToken cancellationToken() const;
+
+		// Inherited from QRunnable
+		void run() override;
+
 	signals:
 		/*!
-		 * The reimplementation of QThread::run() should emit this
-		 * signal periodically to keep the progress dialog informed
-		 * of progress.
+		 * Emitted by setProgress() when the progress has moved
+		 * enough to be worth showing.
 		 */
 		void progressValueChanged(int value);
 		/*!
@@ -73,16 +93,34 @@ class ThreadedTask : public QThread
 		 * message (ie. the label text) is changed.
 		 */
 		void statusMessageChanged(const QString& message);
+		/*! Emitted after work() has returned. */
+		void finished();
 
 	protected:
+		/*!
+		 * Performs the task.
+		 *
+		 * The reimplementation should call setProgress() as it
+		 * advances, and return early if cancelRequested() is true.
+		 */
+		virtual void work() = 0;
+
 		/*!
 		 * Returns true if the user had pressed the "cancel" button
 		 * on the progress dialog; otherwise returns false.
 		 *
-		 * The reimplementation of QThread::run() should check this
-		 * value periodically and return if cancel was requested.
+		 * This function is cheap enough to be called for every
+		 * item that the task processes.
 		 */
 		bool cancelRequested() const;
+		/*!
+		 * Sets the progress of the task to \a value.
+		 *
+		 * This function can be called for every item that the task
+		 * processes; the progress dialog is updated only when the
+		 * value has advanced by at least a hundredth of the range.
+		 */
+		void setProgress(int value);
 
 		/*!
 		 * Returns human-readable version of the given time \a
@@ -91,19 +129,20 @@ class ThreadedTask : public QThread
 		QString humaniseTime(int sec) const;
 	
 	private slots:
-		// Yes, QThread subclasses shouldn't normally have slots
-		// because they're executed in the wrong thread. But in this
-		// case it doesn't matter because we're just setting a flag.
 		void cancel();
-
 		void updateProgress(int value);
 		void setStatusMessage(const QString& msg);
 
 	private:
-		bool m_cancel;
+		TaskPool::Priority m_priority;
+		CancellationToken m_cancellationToken;
 		QString m_statusMessage;
 		QTime m_taskStart;
 		int m_lastUpdate;
+		int m_minimum;
+		int m_progressStep;
+		int m_value;
+		int m_reportedValue;
 		QProgressDialog* m_dlg;
 };
 
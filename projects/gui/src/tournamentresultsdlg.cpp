@@ -23,16 +23,46 @@
 #include <QPlainTextEdit>
 #include <QBoxLayout>
 #include <QFont>
+#include <QLabel>
+#include <QTableView>
+#include <QHeaderView>
+#include <QSortFilterProxyModel>
+#include <QTimer>
 
 #include <tournament.h>
+#include <elo.h>
+#include <sprt.h>
+#include "tournamentresultsmodel.h"
 
 TournamentResultsDialog::TournamentResultsDialog(QWidget* parent)
-	: QDialog(parent)
+	: QDialog(parent),
+	  m_resultsModel(new TournamentResultsModel(this)),
+	  m_refreshTimer(new QTimer(this))
 {
 	setWindowTitle(tr("Tournament Results"));
 
+	m_summaryLabel = new QLabel(this);
+	m_summaryLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+	m_summaryLabel->setContentsMargins(6, 6, 6, 6);
+
+	auto proxy = new QSortFilterProxyModel(this);
+	proxy->setSourceModel(m_resultsModel);
+	proxy->setSortRole(Qt::UserRole);
+
+	m_resultsView = new QTableView(this);
+	m_resultsView->setModel(proxy);
+	m_resultsView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	m_resultsView->setAlternatingRowColors(true);
+	m_resultsView->verticalHeader()->hide();
+	m_resultsView->horizontalHeader()->setSectionResizeMode(
+		QHeaderView::ResizeToContents);
+	m_resultsView->setSortingEnabled(true);
+	m_resultsView->sortByColumn(TournamentResultsModel::ScoreColumn,
+				    Qt::DescendingOrder);
+
 	m_resultsEdit = new QPlainTextEdit(this);
 	m_resultsEdit->setReadOnly(true);
+	m_resultsEdit->hide();
 
 	QFont font("Courier New");
 	font.setStyleHint(QFont::Monospace);
@@ -40,11 +70,17 @@ TournamentResultsDialog::TournamentResultsDialog(QWidget* parent)
 	m_resultsEdit->document()->setDefaultFont(font);
 
 	auto layout = new QBoxLayout(QBoxLayout::TopToBottom);
+	layout->addWidget(m_summaryLabel);
+	layout->addWidget(m_resultsView);
 	layout->addWidget(m_resultsEdit);
 	layout->setContentsMargins(0, 0, 0, 0);
 
 	setLayout(layout);
 	resize(700, 400);
+
+	m_refreshTimer->setSingleShot(true);
+	m_refreshTimer->setInterval(250);
+	connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
 }
 
 TournamentResultsDialog::~TournamentResultsDialog()
@@ -54,14 +90,42 @@ TournamentResultsDialog::~TournamentResultsDialog()
 void TournamentResultsDialog::setTournament(Tournament* tournament)
 {
 	setWindowTitle(tournament->name());
-	m_resultsEdit->setPlainText(tournament->results());
+	m_tournament = tournament;
+
+	// Knockout results are shown as a bracket
+	const bool knockout = tournament->type() == "knockout";
+	m_resultsView->setVisible(!knockout);
+	m_resultsEdit->setVisible(knockout);
+	m_resultsModel->setTournament(knockout ? nullptr : tournament);
+
+	refresh();
 }
 
 void TournamentResultsDialog::update()
 {
 	auto tournament = qobject_cast<Tournament*>(QObject::sender());
 	Q_ASSERT(tournament != nullptr);
-	QString text;
+	if (tournament != m_tournament)
+		setTournament(tournament);
+
+	if (!m_refreshTimer->isActive())
+		m_refreshTimer->start();
+}
+
+void TournamentResultsDialog::showEvent(QShowEvent* event)
+{
+	QDialog::showEvent(event);
+	refresh();
+}
+
+void TournamentResultsDialog::refresh()
+{
+	m_refreshTimer->stop();
+	if (m_tournament.isNull() || !isVisible())
+		return;
+
+	Tournament* tournament = m_tournament;
+	QStringList lines;
 
 	// A quick fix, copied from the CLI side.
 	if (tournament->playerCount() == 2 && tournament->type() != "knockout")
@@ -72,18 +136,46 @@ void TournamentResultsDialog::update()
 		double scoreRatio = std::numeric_limits<double>::quiet_NaN();
 		if (totalResults > 0)
 			scoreRatio = double(fcp.score()) / (totalResults * 2);
-		text = tr("Score of %1 vs %2: %3 - %4 - %5 [%6]\n")
-		       .arg(fcp.name())
-		       .arg(scp.name())
-		       .arg(fcp.wins())
-		       .arg(scp.wins())
-		       .arg(fcp.draws())
-		       .arg(scoreRatio, 0, 'f', 3);
+		lines << tr("Score of %1 vs %2: %3 - %4 - %5 [%6]")
+			 .arg(fcp.name())
+			 .arg(scp.name())
+			 .arg(fcp.wins())
+			 .arg(scp.wins())
+			 .arg(fcp.draws())
+			 .arg(scoreRatio, 0, 'f', 3);
+
+		Elo elo(fcp.wins(), fcp.losses(), fcp.draws());
+		lines << tr("Elo difference: %1 +/- %2, LOS: %3 %, DrawRatio: %4 %")
+			 .arg(elo.diff(), 0, 'f', 1)
+			 .arg(elo.errorMargin(), 0, 'f', 1)
+			 .arg(elo.LOS(), 0, 'f', 1)
+			 .arg(elo.drawRatio() * 100, 0, 'f', 1);
 	}
 
-	text += tournament->results();
-	text += tr("\n\n%1 of %2 games finished.")
-		.arg(tournament->finishedGameCount())
-		.arg(tournament->finalGameCount());
-	m_resultsEdit->setPlainText(text);
+	Sprt::Status sprtStatus = tournament->sprt()->status();
+	if (sprtStatus.llr != 0.0
+	||  sprtStatus.lBound != 0.0
+	||  sprtStatus.uBound != 0.0)
+	{
+		QString sprtStr = tr("SPRT: llr %1 (%2%), lbound %3, ubound %4")
+			.arg(sprtStatus.llr, 0, 'g', 3)
+			.arg(sprtStatus.llr / sprtStatus.uBound * 100, 0, 'f', 1)
+			.arg(sprtStatus.lBound, 0, 'g', 3)
+			.arg(sprtStatus.uBound, 0, 'g', 3);
+		if (sprtStatus.result == Sprt::AcceptH0)
+			sprtStr.append(tr(" - H0 was accepted"));
+		else if (sprtStatus.result == Sprt::AcceptH1)
+			sprtStr.append(tr(" - H1 was accepted"));
+		lines << sprtStr;
+	}
+
+	lines << tr("%1 of %2 games finished.")
+		 .arg(tournament->finishedGameCount())
+		 .arg(tournament->finalGameCount());
+	m_summaryLabel->setText(lines.join('\n'));
+
+	if (!m_resultsEdit->isHidden())
+		m_resultsEdit->setPlainText(tournament->results());
+	else
+		m_resultsModel->update();
 }
@@ -20,9 +20,14 @@
 #define TOURNAMENTRESULTSDLG_H
 
 #include <QDialog>
+#include <QPointer>
 
 class QPlainTextEdit;
+class QLabel;
+class QTableView;
+class QTimer;
 class Tournament;
+class TournamentResultsModel;
 
 class TournamentResultsDialog : public QDialog
 {
@@ -39,8 +44,22 @@ class TournamentResultsDialog : public QDialog
 	public slots:
 		void update();
 
+	protected:
+		// Inherited from QDialog
+		virtual void showEvent(QShowEvent* event);
+
+	private slots:
+		void refresh();
+
 	private:
+		QPointer<Tournament> m_tournament;
+		QLabel* m_summaryLabel;
+		QTableView* m_resultsView;
+		TournamentResultsModel* m_resultsModel;
+		// Used by knockout tournaments
 		QPlainTextEdit* m_resultsEdit;
+		// Collects the updates of games that finish close together
+		QTimer* m_refreshTimer;
 };
 
 #endif // TOURNAMENTRESULTSDLG_H
@@ -0,0 +1,211 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tournamentresultsmodel.h"
+#include <tournament.h>
+
+TournamentResultsModel::TournamentResultsModel(QObject* parent)
+	: QAbstractTableModel(parent),
+	  m_playerCount(0)
+{
+}
+
+void TournamentResultsModel::setTournament(Tournament* tournament)
+{
+	beginResetModel();
+	m_tournament = tournament;
+	m_playerCount = 0;
+	m_names.clear();
+	m_cells.clear();
+
+	if (tournament != nullptr)
+	{
+		m_playerCount = tournament->playerCount();
+		for (int i = 0; i < m_playerCount; i++)
+			m_names.append(tournament->playerAt(i).name());
+		readCells(&m_cells);
+	}
+	endResetModel();
+}
+
+void TournamentResultsModel::readCells(QVector<Cell>* cells) const
+{
+	const int columns = columnCount();
+	cells->resize(m_playerCount * columns);
+
+	const RatingModel& ratings = m_tournament->ratingModel();
+	const bool rated = ratings.playerCount() == m_playerCount;
+
+	for (int i = 0; i < m_playerCount; i++)
+	{
+		const TournamentPlayer& player = m_tournament->playerAt(i);
+		Cell* row = cells->data() + i * columns;
+		const int games = player.gamesFinished();
+
+		row[NameColumn].text = player.name();
+		row[NameColumn].sortKey = player.name();
+		row[GamesColumn].text = QString::number(games);
+		row[GamesColumn].sortKey = games;
+
+		if (games > 0 && rated)
+		{
+			qreal elo = ratings.rating(i);
+			qreal margin = ratings.errorMargin(i);
+			row[EloColumn].text = QString::number(elo, 'f', 0);
+			row[EloColumn].sortKey = elo;
+			row[ErrorMarginColumn].text = QString::number(margin, 'f', 0);
+			row[ErrorMarginColumn].sortKey = margin;
+		}
+		else
+		{
+			row[EloColumn] = Cell();
+			row[ErrorMarginColumn] = Cell();
+		}
+
+		if (games > 0)
+		{
+			qreal score = player.score() * 50.0 / games;
+			qreal draws = player.draws() * 100.0 / games;
+			row[ScoreColumn].text = QString("%1%").arg(score, 0, 'f', 1);
+			row[ScoreColumn].sortKey = score;
+			row[DrawsColumn].text = QString("%1%").arg(draws, 0, 'f', 1);
+			row[DrawsColumn].sortKey = draws;
+		}
+		else
+		{
+			row[ScoreColumn] = Cell();
+			row[DrawsColumn] = Cell();
+		}
+
+		// Results against each opponent, eg. "3.5/6"
+		for (int j = 0; j < m_playerCount; j++)
+		{
+			Cell& cell = row[OpponentColumn + j];
+			const int pairGames = rated ? ratings.games(i, j) : 0;
+			if (pairGames == 0)
+			{
+				cell = Cell();
+				continue;
+			}
+
+			const qreal points = ratings.points(i, j) / 2.0;
+			cell.text = QString("%1/%2").arg(points).arg(pairGames);
+			cell.sortKey = points / pairGames;
+		}
+	}
+}
+
+void TournamentResultsModel::update()
+{
+	if (m_tournament.isNull())
+		return;
+	if (m_tournament->playerCount() != m_playerCount)
+	{
+		setTournament(m_tournament);
+		return;
+	}
+
+	QVector<Cell> cells;
+	readCells(&cells);
+
+	// Signal each row's range of changed cells
+	const int columns = columnCount();
+	for (int i = 0; i < m_playerCount; i++)
+	{
+		int first = -1;
+		int last = -1;
+		for (int j = 0; j < columns; j++)
+		{
+			Cell& oldCell = m_cells[i * columns + j];
+			const Cell& newCell = cells.at(i * columns + j);
+			if (oldCell.text == newCell.text)
+				continue;
+
+			oldCell = newCell;
+			if (first == -1)
+				first = j;
+			last = j;
+		}
+
+		if (first != -1)
+			emit dataChanged(index(i, first), index(i, last));
+	}
+}
+
+int TournamentResultsModel::rowCount(const QModelIndex& parent) const
+{
+	if (parent.isValid())
+		return 0;
+
+	return m_playerCount;
+}
+
+int TournamentResultsModel::columnCount(const QModelIndex& parent) const
+{
+	if (parent.isValid())
+		return 0;
+
+	return OpponentColumn + m_playerCount;
+}
+
+QVariant TournamentResultsModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid())
+		return QVariant();
+
+	const Cell& cell = m_cells.at(index.row() * columnCount() + index.column());
+	if (role == Qt::DisplayRole)
+		return cell.text;
+	if (role == Qt::UserRole)
+		return cell.sortKey;
+	if (role == Qt::TextAlignmentRole && index.column() != NameColumn)
+		return int(Qt::AlignRight | Qt::AlignVCenter);
+
+	return QVariant();
+}
+
+QVariant TournamentResultsModel::headerData(int section,
+					    Qt::Orientation orientation,
+					    int role) const
+{
+	if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+		return QVariant();
+
+	switch (section)
+	{
+	case NameColumn:
+		return tr("Name");
+	case EloColumn:
+		return tr("Elo");
+	case ErrorMarginColumn:
+		return tr("+/-");
+	case GamesColumn:
+		return tr("Games");
+	case ScoreColumn:
+		return tr("Score");
+	case DrawsColumn:
+		return tr("Draws");
+	default:
+		break;
+	}
+
+	const int opponent = section - OpponentColumn;
+	if (opponent >= 0 && opponent < m_names.size())
+		return m_names.at(opponent);
+	return QVariant();
+}
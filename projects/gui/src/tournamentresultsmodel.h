@@ -0,0 +1,86 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TOURNAMENT_RESULTS_MODEL_H
+#define TOURNAMENT_RESULTS_MODEL_H
+
+#include <QAbstractTableModel>
+#include <QPointer>
+#include <QVector>
+#include <QStringList>
+class Tournament;
+
+/*!
+ * \brief Supplies the standings of a tournament to views.
+ *
+ * Each row is a player. The first columns have the player's rating
+ * and score, and the rest are the player's results against each
+ * opponent. The model keeps the formatted cells, and update() only
+ * signals the cells whose values have changed.
+ */
+class TournamentResultsModel : public QAbstractTableModel
+{
+	Q_OBJECT
+
+	public:
+		/*! The columns before the opponent columns. */
+		enum Column
+		{
+			NameColumn,
+			EloColumn,
+			ErrorMarginColumn,
+			GamesColumn,
+			ScoreColumn,
+			DrawsColumn,
+			OpponentColumn	//!< The first opponent column
+		};
+
+		/*! Constructs an empty model with the given \a parent. */
+		TournamentResultsModel(QObject* parent = nullptr);
+
+		/*! Shows the standings of \a tournament. */
+		void setTournament(Tournament* tournament);
+
+		// Inherited from QAbstractTableModel
+		virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+		virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+		virtual QVariant data(const QModelIndex& index, int role) const;
+		virtual QVariant headerData(int section, Qt::Orientation orientation,
+					    int role = Qt::DisplayRole) const;
+
+	public slots:
+		/*! Reads the tournament's current results. */
+		void update();
+
+	private:
+		struct Cell
+		{
+			QString text;
+			QVariant sortKey;
+		};
+
+		void readCells(QVector<Cell>* cells) const;
+
+		QPointer<Tournament> m_tournament;
+		int m_playerCount;
+		QStringList m_names;
+		// Player rows of all columns
+		QVector<Cell> m_cells;
+};
+
+#endif // TOURNAMENT_RESULTS_MODEL_H
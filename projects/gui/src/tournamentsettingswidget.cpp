@@ -50,6 +50,10 @@ QString TournamentSettingsWidget::tournamentType() const
 		return "knockout";
 	else if (ui->m_pyramidRadio->isChecked())
 		return "pyramid";
+	else if (ui->m_swissRadio->isChecked())
+		return "swiss";
+	else if (ui->m_adaptiveRadio->isChecked())
+		return "adaptive";
 
 	Q_UNREACHABLE();
 	return QString();
@@ -104,6 +108,10 @@ void TournamentSettingsWidget::readSettings()
 		ui->m_knockoutRadio->setChecked(true);
 	else if (type == "pyramid")
 		ui->m_pyramidRadio->setChecked(true);
+	else if (type == "swiss")
+		ui->m_swissRadio->setChecked(true);
+	else if (type == "adaptive")
+		ui->m_adaptiveRadio->setChecked(true);
 
 	ui->m_seedsSpin->setValue(s.value("seeds", 0).toInt());
 	ui->m_gamesPerEncounterSpin->setValue(s.value("games_per_encounter", 1).toInt());
@@ -140,6 +148,16 @@ void TournamentSettingsWidget::enableSettingsUpdates()
 		if (checked)
 			QSettings().setValue("tournament/type", "pyramid");
 	});
+	connect(ui->m_swissRadio, &QRadioButton::toggled, [=](bool checked)
+	{
+		if (checked)
+			QSettings().setValue("tournament/type", "swiss");
+	});
+	connect(ui->m_adaptiveRadio, &QRadioButton::toggled, [=](bool checked)
+	{
+		if (checked)
+			QSettings().setValue("tournament/type", "adaptive");
+	});
 
 	connect(ui->m_seedsSpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
 		[=](int value)
@@ -7,3 +7,6 @@ include(../lib.pri)
 
 OBJECTS_DIR = .obj
 MOC_DIR = .moc
+
+INCLUDEPATH += $$PWD
+HEADERS += $$PWD/randomplayout.h
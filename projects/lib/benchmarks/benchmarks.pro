@@ -1,2 +1,2 @@
 TEMPLATE = subdirs
-SUBDIRS = pgngame
+SUBDIRS = pgngame perft movestrings games json openingsuite polyglotbook tournamentpairing
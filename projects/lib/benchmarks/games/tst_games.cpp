@@ -0,0 +1,186 @@
+#include <QtTest/QtTest>
+#include <gamemanager.h>
+#include <tournament.h>
+#include <tournamentfactory.h>
+#include <gameadjudicator.h>
+#include <enginebuilder.h>
+#include <engineconfiguration.h>
+#include <chessgame.h>
+#include <timecontrol.h>
+#include <resourceusage.h>
+#include <headlessrunner.h>
+#include <mockengine.h>
+
+
+class tst_Games: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void tournament_data() const;
+		void tournament();
+		void headless_data() const;
+		void headless();
+};
+
+void tst_Games::tournament_data() const
+{
+	QTest::addColumn<QString>("protocol");
+	QTest::addColumn<int>("concurrency");
+	QTest::addColumn<int>("games");
+
+	QList<int> concurrencies;
+	concurrencies << 1;
+	for (int n = 2; n <= 2 * QThread::idealThreadCount(); n *= 2)
+		concurrencies << n;
+
+	for (const QString protocol : { "uci", "xboard" })
+	{
+		for (int concurrency : qAsConst(concurrencies))
+		{
+			QString name = QString("%1 concurrency %2")
+				       .arg(protocol).arg(concurrency);
+			QTest::newRow(qPrintable(name))
+				<< protocol << concurrency << qMax(32, 4 * concurrency);
+		}
+	}
+}
+
+void tst_Games::tournament()
+{
+	QFETCH(QString, protocol);
+	QFETCH(int, concurrency);
+	QFETCH(int, games);
+
+	GameManager manager;
+	manager.setConcurrency(concurrency);
+
+	Tournament* tournament = TournamentFactory::create("round-robin", &manager);
+	QVERIFY(tournament != nullptr);
+	tournament->setGamesPerEncounter(games);
+
+	GameAdjudicator adjudicator;
+	adjudicator.setMaximumGameLength(MockEngine::MaxGameLength);
+	tournament->setAdjudicator(adjudicator);
+
+	for (int i = 1; i <= 2; i++)
+	{
+		EngineConfiguration config(QString("Mock %1").arg(i),
+					   QCoreApplication::applicationFilePath(),
+					   protocol);
+		config.setArguments(QStringList() << "--mock-engine" << protocol);
+		tournament->addPlayer(new EngineBuilder(config), TimeControl("inf"));
+	}
+
+	qint64 plies = 0;
+	connect(tournament, &Tournament::gameFinished,
+		[&](ChessGame* game) { plies += game->moves().size(); });
+
+	QEventLoop loop;
+	connect(tournament, SIGNAL(finished()), &loop, SLOT(quit()));
+
+	const qint64 pid = QCoreApplication::applicationPid();
+	const ResourceUsage usage(ResourceUsage::ofProcess(pid));
+	QElapsedTimer timer;
+
+	QBENCHMARK_ONCE
+	{
+		timer.start();
+		tournament->start();
+		loop.exec();
+	}
+
+	const double elapsed = qMax(qint64(1), timer.nsecsElapsed()) / 1.0e9;
+	const qint64 cpuTime = ResourceUsage::ofProcess(pid).since(usage).cpuTime();
+	const int finished = tournament->finishedGameCount();
+
+	QCOMPARE(finished, games);
+	qInfo("%d games, %lld plies, %.1f games/s, %.0f plies/s, %.1f us CPU/ply",
+	      finished, static_cast<long long>(plies),
+	      finished / elapsed, plies / elapsed,
+	      usage.isValid() ? double(cpuTime) / qMax(qint64(1), plies) : -1.0);
+
+	delete tournament;
+
+	// Quit the engines before the next row starts its own
+	QSignalSpy quitSpy(&manager, SIGNAL(finished()));
+	manager.finish();
+	if (quitSpy.isEmpty())
+		QVERIFY(quitSpy.wait(30000));
+}
+
+void tst_Games::headless_data() const
+{
+	QTest::addColumn<int>("concurrency");
+	QTest::addColumn<int>("games");
+
+	for (int concurrency : { 1, 4, 16 })
+	{
+		QString name = QString("uci concurrency %1").arg(concurrency);
+		QTest::newRow(qPrintable(name))
+			<< concurrency << qMax(32, 4 * concurrency);
+	}
+}
+
+/*
+ * Plays the same games as tournament() with HeadlessRunner, in the
+ * main thread only. The difference is the cost of the ChessGame,
+ * ChessPlayer and game thread machinery.
+ */
+void tst_Games::headless()
+{
+	QFETCH(int, concurrency);
+	QFETCH(int, games);
+
+	EngineConfiguration config[2];
+	for (int i = 0; i < 2; i++)
+	{
+		config[i] = EngineConfiguration(QString("Mock %1").arg(i + 1),
+						QCoreApplication::applicationFilePath(),
+						"uci");
+		config[i].setArguments(QStringList() << "--mock-engine" << "uci");
+	}
+
+	GameAdjudicator adjudicator;
+	adjudicator.setMaximumGameLength(MockEngine::MaxGameLength);
+
+	HeadlessRunner runner(config[0], config[1]);
+	runner.setAdjudicator(adjudicator);
+	runner.setGameCount(games);
+	runner.setConcurrency(concurrency);
+
+	const qint64 pid = QCoreApplication::applicationPid();
+	const ResourceUsage usage(ResourceUsage::ofProcess(pid));
+	QElapsedTimer timer;
+
+	QBENCHMARK_ONCE
+	{
+		timer.start();
+		runner.run();
+	}
+
+	const double elapsed = qMax(qint64(1), timer.nsecsElapsed()) / 1.0e9;
+	const qint64 cpuTime = ResourceUsage::ofProcess(pid).since(usage).cpuTime();
+	const int finished = runner.finishedGameCount();
+	const qint64 plies = runner.plyCount();
+
+	QVERIFY2(runner.errors().isEmpty(), qPrintable(runner.errors().join('\n')));
+	QCOMPARE(finished, games);
+	qInfo("%d games, %lld plies, %.1f games/s, %.0f plies/s, %.1f us CPU/ply",
+	      finished, static_cast<long long>(plies),
+	      finished / elapsed, plies / elapsed,
+	      usage.isValid() ? double(cpuTime) / qMax(qint64(1), plies) : -1.0);
+}
+
+int main(int argc, char* argv[])
+{
+	// The benchmark runs copies of itself as the engines
+	if (argc == 3 && qstrcmp(argv[1], "--mock-engine") == 0)
+		return MockEngine().run(argv[2]);
+
+	QCoreApplication app(argc, argv);
+	tst_Games test;
+	return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_games.moc"
@@ -0,0 +1,6 @@
+include(../benchmarks.pri)
+include(../../libexport.pri)
+
+INCLUDEPATH += $$PWD/../../components/json/src
+TARGET = tst_json
+SOURCES += tst_json.cpp
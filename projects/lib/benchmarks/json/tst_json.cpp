@@ -0,0 +1,155 @@
+#include <QtTest/QtTest>
+#include <QTextStream>
+#include <jsonparser.h>
+#include <jsonreader.h>
+#include <jsonserializer.h>
+
+
+class tst_Json: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void parse_data() const;
+		void parse() const;
+		void read_data() const;
+		void read() const;
+		void serialize_data() const;
+		void serialize() const;
+
+	private:
+		void addDocuments() const;
+};
+
+/*
+ * Returns a list of \a count engine configurations like the ones
+ * in an engines.json file.
+ */
+static QVariant engineList(int count)
+{
+	QVariantList engines;
+	for (int i = 0; i < count; i++)
+	{
+		QVariantMap engine;
+		engine["name"] = QString("Engine %1").arg(i);
+		engine["command"] = QString("./engine%1 --threads 1").arg(i);
+		engine["workingDirectory"] = QString("/home/user/engines/engine%1").arg(i);
+		engine["stderrFile"] = QString();
+		engine["protocol"] = i % 2 ? "uci" : "xboard";
+		engine["initStrings"] = QStringList() << "memory 64" << "cores 1";
+		engine["ponder"] = true;
+
+		QVariantList options;
+		for (int j = 0; j < 10; j++)
+		{
+			QVariantMap option;
+			option["name"] = QString("Option \"%1\"").arg(j);
+			option["type"] = "spin";
+			option["value"] = j * 16;
+			option["default"] = 16;
+			option["min"] = -1000000;
+			option["max"] = 1000000;
+			options << option;
+		}
+		engine["options"] = options;
+
+		engines << engine;
+	}
+
+	return engines;
+}
+
+/*
+ * Returns a document with objects and arrays nested \a depth levels
+ * deep.
+ */
+static QVariant nestedDocument(int depth)
+{
+	QVariant node(1.5);
+	for (int i = 0; i < depth; i++)
+	{
+		QVariantMap map;
+		map["level"] = i;
+		map["child"] = QVariantList() << node << QVariant() << false;
+		node = map;
+	}
+
+	return node;
+}
+
+static QString toJson(const QVariant& data)
+{
+	QString str;
+	QTextStream stream(&str);
+	JsonSerializer serializer(data);
+	serializer.serialize(stream);
+	stream.flush();
+
+	return str;
+}
+
+void tst_Json::addDocuments() const
+{
+	QTest::addColumn<QVariant>("data");
+
+	QTest::newRow("10 engines") << engineList(10);
+	QTest::newRow("1000 engines") << engineList(1000);
+	QTest::newRow("nested 100") << nestedDocument(100);
+	QTest::newRow("nested 400") << nestedDocument(400);
+}
+
+void tst_Json::parse_data() const
+{
+	addDocuments();
+}
+
+void tst_Json::parse() const
+{
+	QFETCH(QVariant, data);
+
+	QString json(toJson(data));
+	QBENCHMARK
+	{
+		QTextStream stream(&json, QIODevice::ReadOnly);
+		JsonParser parser(stream);
+		QVERIFY(!parser.parse().isNull());
+	}
+}
+
+void tst_Json::read_data() const
+{
+	addDocuments();
+}
+
+void tst_Json::read() const
+{
+	QFETCH(QVariant, data);
+
+	const QByteArray json(toJson(data).toUtf8());
+	QBENCHMARK
+	{
+		JsonReader reader(json);
+		QVERIFY(!reader.readVariant().isNull());
+	}
+}
+
+void tst_Json::serialize_data() const
+{
+	addDocuments();
+}
+
+void tst_Json::serialize() const
+{
+	QFETCH(QVariant, data);
+
+	QBENCHMARK
+	{
+		QString str;
+		QTextStream stream(&str);
+		JsonSerializer serializer(data);
+		QVERIFY(serializer.serialize(stream));
+	}
+}
+
+QTEST_MAIN(tst_Json)
+#include "tst_json.moc"
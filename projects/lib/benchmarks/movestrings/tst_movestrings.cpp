@@ -0,0 +1,232 @@
+#include <QtTest/QtTest>
+#include <board/board.h>
+#include <board/boardfactory.h>
+#include <randomplayout.h>
+
+
+class tst_MoveStrings: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void sanParse_data() const;
+		void sanParse();
+		void sanFormat_data() const;
+		void sanFormat();
+		void lanParse_data() const;
+		void lanParse();
+		void lanFormat_data() const;
+		void lanFormat();
+
+		void cleanupTestCase();
+
+	private:
+		void addGames() const;
+		void setGame(const QString& variant,
+			     const QString& fen,
+			     const QStringList& sanMoves);
+
+		Chess::Board* m_board = nullptr;
+		QVector<Chess::Move> m_moves;
+};
+
+/*
+ * Plays a random game of up to \a plies moves in \a variant and
+ * returns its moves in SAN. The starting position is stored in \a fen.
+ */
+static QStringList playoutGame(const QString& variant, int plies, QString* fen)
+{
+	QStringList sanMoves;
+	Chess::Board* board = Chess::BoardFactory::create(variant);
+	if (board == nullptr)
+		return sanMoves;
+
+	*fen = board->defaultFenString();
+	if (board->setFenString(*fen))
+	{
+		RandomStream stream(0x2545F491, 0);
+		sanMoves = randomPlayout(board, &stream, plies);
+	}
+
+	delete board;
+	return sanMoves;
+}
+
+void tst_MoveStrings::addGames() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<QStringList>("moves");
+
+	// Karpov - Kramnik, Linares 1993
+	QTest::newRow("standard game1")
+		<< "standard"
+		<< "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+		<< QString(
+		   "c4 c6 e4 d5 exd5 cxd5 d4 Nf6 Nc3 Nc6 Nf3 Bg4 cxd5 Nxd5 "
+		   "Qb3 Bxf3 gxf3 e6 Qxb7 Nxd4 Bb5+ Nxb5 Qc6+ Ke7 Qxb5 Qd7 "
+		   "Nxd5+ Qxd5 Bg5+ f6 Qxd5 exd5 Be3 Ke6 O-O-O Bb4 Rd3 Rhd8 "
+		   "a3 Rac8+ Kb1 Bc5 Re1 Kd6 Rg1 g6 Rgd1 Ke6 Re1 Bxe3 Rdxe3+ "
+		   "Kf5 Re7 Kf4 R1e3 a5 h3 h5 R7e6 Kg5 Ra6 d4 f4+ Kf5 Rxa5+ "
+		   "Kxf4 Rd3 Ke4 Rd2 g5 Ra6 f5 Re6+ Kf3 Re5 Kf4 Re6 h4 Rd3 g4 "
+		   "Rh6 Kg5 Rh7 Rc6 a4 Rd5 a5 Rcd6 Ra7 gxh3 Rg7+ Kf4 Rh7 Ke4 "
+		   "Rxh3 Rxa5 Kc2 Rb5 Re7+ Kf4 Rxh4+ Kf3 Rh3+ Kxf2 Rd3 Rc6+ "
+		   "Kb1 Rb4 b3 f4 Re4 Rf6 Kb2 f3 Ka3 Rbb6 Rdxd4 Rg6 Rd2+ Kg3 "
+		   "Re3 Rbe6 Rc3 Ra6+ Kb2 Rg4 Rd8 Rf6 Rd2 Rgf4 Ka3 Kg4 Rf2 "
+		   "Ra6+ Kb2 Rh6 Ka3 Rh1 Rd3 Kg3 Rc2 Rhh4 Re3 Rh2 Rc8 Kg2 "
+		   "Rg8+ Kf1 b4 f2 Rb3 Rhh4 Rgg3 Rd4 Ka4 Rhe4 Ka5 Rd2 Rh3 "
+		   "Ke2 Rh2 Ra2+ Kb6 Re6+ Kc5 Rc2+ Kb5 Rh6 Rg2 Rf6 Rh2 Rh6 "
+		   "Rg2 Kf1 Rg5 Rf6 Rc5 Rd2 Rc6 Rf4 Rc1+ Kg2 Rbb1 Rf8 Ka5 "
+		   "Ra2+ Kb6 Rf6+ Kc5 Rf5+ Kb6 Re2 b5 Re6+ Ka5 Rfe5 Ka4 Re4+")
+		   .split(' ');
+
+	// Long pseudo-random games give a per-variant breakdown
+	for (const QString& variant : Chess::BoardFactory::variants())
+	{
+		QString fen;
+		QStringList moves(playoutGame(variant, 300, &fen));
+		if (moves.isEmpty())
+			continue;
+		QTest::newRow(qPrintable(variant + " playout"))
+			<< variant << fen << moves;
+	}
+}
+
+void tst_MoveStrings::setGame(const QString& variant,
+			      const QString& fen,
+			      const QStringList& sanMoves)
+{
+	if (m_board == nullptr || m_board->variant() != variant)
+	{
+		delete m_board;
+		m_board = Chess::BoardFactory::create(variant);
+	}
+	QVERIFY(m_board != nullptr);
+
+	QVERIFY(m_board->setFenString(fen));
+	m_moves.clear();
+	for (const QString& san : sanMoves)
+	{
+		Chess::Move move(m_board->moveFromString(san));
+		QVERIFY2(!move.isNull(), qPrintable("Illegal move: " + san));
+		m_moves << move;
+		m_board->makeMove(move);
+	}
+	while (m_board->plyCount() > 0)
+		m_board->undoMove();
+}
+
+void tst_MoveStrings::cleanupTestCase()
+{
+	delete m_board;
+}
+
+void tst_MoveStrings::sanParse_data() const
+{
+	addGames();
+}
+
+void tst_MoveStrings::sanParse()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(QStringList, moves);
+	setGame(variant, fen, moves);
+	if (QTest::currentTestFailed())
+		return;
+
+	QBENCHMARK
+	{
+		for (const QString& san : qAsConst(moves))
+			m_board->makeMove(m_board->moveFromString(san));
+		while (m_board->plyCount() > 0)
+			m_board->undoMove();
+	}
+}
+
+void tst_MoveStrings::sanFormat_data() const
+{
+	addGames();
+}
+
+void tst_MoveStrings::sanFormat()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(QStringList, moves);
+	setGame(variant, fen, moves);
+	if (QTest::currentTestFailed())
+		return;
+
+	QBENCHMARK
+	{
+		for (const Chess::Move& move : qAsConst(m_moves))
+		{
+			m_board->moveString(move, Chess::Board::StandardAlgebraic);
+			m_board->makeMove(move);
+		}
+		while (m_board->plyCount() > 0)
+			m_board->undoMove();
+	}
+}
+
+void tst_MoveStrings::lanParse_data() const
+{
+	addGames();
+}
+
+void tst_MoveStrings::lanParse()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(QStringList, moves);
+	setGame(variant, fen, moves);
+	if (QTest::currentTestFailed())
+		return;
+
+	QStringList lanMoves;
+	for (const Chess::Move& move : qAsConst(m_moves))
+	{
+		lanMoves << m_board->moveString(move, Chess::Board::LongAlgebraic);
+		m_board->makeMove(move);
+	}
+	while (m_board->plyCount() > 0)
+		m_board->undoMove();
+
+	QBENCHMARK
+	{
+		for (const QString& lan : qAsConst(lanMoves))
+			m_board->makeMove(m_board->moveFromString(lan));
+		while (m_board->plyCount() > 0)
+			m_board->undoMove();
+	}
+}
+
+void tst_MoveStrings::lanFormat_data() const
+{
+	addGames();
+}
+
+void tst_MoveStrings::lanFormat()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(QStringList, moves);
+	setGame(variant, fen, moves);
+	if (QTest::currentTestFailed())
+		return;
+
+	QBENCHMARK
+	{
+		for (const Chess::Move& move : qAsConst(m_moves))
+		{
+			m_board->moveString(move, Chess::Board::LongAlgebraic);
+			m_board->makeMove(move);
+		}
+		while (m_board->plyCount() > 0)
+			m_board->undoMove();
+	}
+}
+
+QTEST_MAIN(tst_MoveStrings)
+#include "tst_movestrings.moc"
@@ -0,0 +1,171 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <board/board.h>
+#include <board/boardfactory.h>
+#include <openingsuite.h>
+#include <openingindex.h>
+#include <mersenne.h>
+#include <randomplayout.h>
+
+
+class tst_OpeningSuite: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+
+		void initialize_data() const;
+		void initialize();
+		void nextGame_data() const;
+		void nextGame();
+
+	private:
+		void addRows() const;
+		QString suiteFile(OpeningSuite::Format format, int count) const;
+		void removeIndex(const QString& fileName) const;
+
+		QTemporaryDir m_dir;
+};
+
+static bool writeSuite(const QString& fileName,
+		       OpeningSuite::Format format,
+		       int count)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+
+	Chess::Board* board = Chess::BoardFactory::create("standard");
+	QTextStream out(&file);
+	for (int i = 0; i < count; i++)
+	{
+		// A random opening of 4 to 15 plies
+		RandomStream stream(0x2545F491, quint64(i));
+		board->setFenString(board->defaultFenString());
+		const int plies = 4 + int(stream.next() % 12);
+		const QStringList moves(randomPlayout(board, &stream, plies));
+		const QString fen(board->fenString());
+
+		if (format == OpeningSuite::EpdFormat)
+		{
+			out << fen.section(' ', 0, 3) << " id \"" << i << "\";\n";
+			continue;
+		}
+
+		out << "[Event \"Opening " << i << "\"]\n"
+		    << "[White \"?\"]\n[Black \"?\"]\n[Result \"*\"]\n\n";
+		for (int j = 0; j < moves.size(); j++)
+		{
+			if (j % 2 == 0)
+				out << j / 2 + 1 << ". ";
+			out << moves.at(j) << ' ';
+		}
+		out << "*\n\n";
+	}
+	delete board;
+
+	return out.status() == QTextStream::Ok;
+}
+
+void tst_OpeningSuite::initTestCase()
+{
+	QVERIFY(m_dir.isValid());
+	Mersenne::initialize(1);
+
+	for (const auto format : { OpeningSuite::EpdFormat, OpeningSuite::PgnFormat })
+	{
+		for (int count : { 10000, 100000 })
+			QVERIFY(writeSuite(suiteFile(format, count), format, count));
+	}
+}
+
+void tst_OpeningSuite::addRows() const
+{
+	QTest::addColumn<int>("format");
+	QTest::addColumn<int>("order");
+	QTest::addColumn<int>("count");
+
+	for (const auto format : { OpeningSuite::EpdFormat, OpeningSuite::PgnFormat })
+	{
+		for (const auto order : { OpeningSuite::SequentialOrder, OpeningSuite::RandomOrder })
+		{
+			for (int count : { 10000, 100000 })
+			{
+				QString name = QString("%1 %2 %3")
+					       .arg(format == OpeningSuite::EpdFormat ? "epd" : "pgn")
+					       .arg(order == OpeningSuite::SequentialOrder ? "sequential" : "random")
+					       .arg(count);
+				QTest::newRow(qPrintable(name)) << int(format) << int(order) << count;
+			}
+		}
+	}
+}
+
+QString tst_OpeningSuite::suiteFile(OpeningSuite::Format format, int count) const
+{
+	return m_dir.filePath(QString("suite%1.%2")
+			      .arg(count)
+			      .arg(format == OpeningSuite::EpdFormat ? "epd" : "pgn"));
+}
+
+void tst_OpeningSuite::removeIndex(const QString& fileName) const
+{
+	const auto names = OpeningIndex::cacheFileNames(fileName);
+	for (const QString& name : names)
+		QFile::remove(name);
+}
+
+void tst_OpeningSuite::initialize_data() const
+{
+	addRows();
+}
+
+void tst_OpeningSuite::initialize()
+{
+	QFETCH(int, format);
+	QFETCH(int, order);
+	QFETCH(int, count);
+
+	// A random order suite is indexed from scratch every time,
+	// without the cached index of an earlier run
+	const QString fileName(suiteFile(OpeningSuite::Format(format), count));
+	QBENCHMARK
+	{
+		removeIndex(fileName);
+		OpeningSuite suite(fileName,
+				   OpeningSuite::Format(format),
+				   OpeningSuite::Order(order));
+		QVERIFY(suite.initialize());
+	}
+	removeIndex(fileName);
+}
+
+void tst_OpeningSuite::nextGame_data() const
+{
+	addRows();
+}
+
+void tst_OpeningSuite::nextGame()
+{
+	QFETCH(int, format);
+	QFETCH(int, order);
+	QFETCH(int, count);
+
+	const QString fileName(suiteFile(OpeningSuite::Format(format), count));
+	OpeningSuite suite(fileName,
+			   OpeningSuite::Format(format),
+			   OpeningSuite::Order(order));
+	QVERIFY(suite.initialize());
+
+	// One batch of openings, as a tournament would read them
+	QBENCHMARK
+	{
+		for (int i = 0; i < 1000; i++)
+			QVERIFY(!suite.nextGame(16).isNull());
+	}
+	removeIndex(fileName);
+}
+
+QTEST_MAIN(tst_OpeningSuite)
+#include "tst_openingsuite.moc"
@@ -0,0 +1,94 @@
+#include <QtTest/QtTest>
+#include <QThread>
+#include <board/boardfactory.h>
+#include <perft.h>
+
+
+class tst_Perft: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void perft_data() const;
+		void perft();
+};
+
+void tst_Perft::perft_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QString>("fen");
+	QTest::addColumn<int>("depth");
+	QTest::addColumn<int>("threads");
+
+	QList<int> threadCounts;
+	threadCounts << 1;
+	if (QThread::idealThreadCount() > 1)
+		threadCounts << QThread::idealThreadCount();
+
+	// A fixed suite of standard chess positions
+	const QList< QPair<QString, QString> > positions = {
+		{ "kiwipete",
+		  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -" },
+		{ "endgame",
+		  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -" },
+		{ "promotions",
+		  "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1" },
+		{ "middlegame",
+		  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10" }
+	};
+
+	for (int threads : qAsConst(threadCounts))
+	{
+		for (const auto& pos : positions)
+		{
+			QString name = QString("standard %1 %2t")
+				       .arg(pos.first).arg(threads);
+			QTest::newRow(qPrintable(name))
+				<< "standard" << pos.second << 4 << threads;
+		}
+
+		// The starting position of every registered variant
+		for (const QString& variant : Chess::BoardFactory::variants())
+		{
+			QString name = QString("%1 startpos %2t")
+				       .arg(variant).arg(threads);
+			QTest::newRow(qPrintable(name))
+				<< variant << QString() << 3 << threads;
+		}
+	}
+}
+
+void tst_Perft::perft()
+{
+	QFETCH(QString, variant);
+	QFETCH(QString, fen);
+	QFETCH(int, depth);
+	QFETCH(int, threads);
+
+	// Without the hash table every iteration walks the whole tree
+	Perft perft;
+	perft.setThreadCount(threads);
+	perft.setHashSize(0);
+	// Random variants may not have a fixed starting position
+	if (!perft.setPosition(variant, fen))
+		QSKIP(qPrintable(perft.errorString()));
+
+	quint64 nodeCount = 0;
+	quint64 totalNodes = 0;
+	QElapsedTimer timer;
+	timer.start();
+
+	QBENCHMARK
+	{
+		nodeCount = perft.count(depth);
+		totalNodes += nodeCount;
+	}
+
+	qint64 elapsed = qMax(qint64(1), timer.elapsed());
+	qInfo("%llu nodes, %.0f knps",
+	      static_cast<unsigned long long>(nodeCount),
+	      double(totalNodes) / elapsed);
+}
+
+QTEST_MAIN(tst_Perft)
+#include "tst_perft.moc"
@@ -10,6 +10,8 @@ class tst_PgnGame: public QObject
 	private slots:
 		void parser_data() const;
 		void parser();
+		void tagParser_data() const;
+		void tagParser();
 };
 
 void tst_PgnGame::parser_data() const
@@ -99,5 +101,23 @@ void tst_PgnGame::parser()
 	}
 }
 
+void tst_PgnGame::tagParser_data() const
+{
+	parser_data();
+}
+
+void tst_PgnGame::tagParser()
+{
+	QFETCH(QByteArray, pgn);
+
+	PgnStream stream(&pgn);
+	PgnGame game;
+	QBENCHMARK
+	{
+		QVERIFY(game.readTags(stream, true));
+		stream.rewind();
+	}
+}
+
 QTEST_MAIN(tst_PgnGame)
 #include "tst_pgngame.moc"
@@ -0,0 +1,5 @@
+include(../benchmarks.pri)
+include(../../libexport.pri)
+
+TARGET = tst_polyglotbook
+SOURCES += tst_polyglotbook.cpp
@@ -0,0 +1,143 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <board/board.h>
+#include <board/boardfactory.h>
+#include <polyglotbook.h>
+#include <pgnstream.h>
+#include <randomplayout.h>
+
+
+class tst_PolyglotBook: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void initTestCase();
+
+		void read_data() const;
+		void read();
+		void probe_data() const;
+		void probe();
+
+	private:
+		QString bookFile() const;
+
+		QTemporaryDir m_dir;
+		QVector<quint64> m_hitKeys;
+		QVector<quint64> m_missKeys;
+};
+
+/*
+ * Plays \a count random games of 24 plies and returns them in PGN.
+ * The keys of the positions are appended to \a keys.
+ */
+static QByteArray playoutGames(int count, QVector<quint64>* keys)
+{
+	QByteArray pgn;
+	Chess::Board* board = Chess::BoardFactory::create("standard");
+
+	for (int i = 0; i < count; i++)
+	{
+		RandomStream stream(0x2545F491, quint64(i));
+		board->setFenString(board->defaultFenString());
+		const QStringList moves(randomPlayout(board, &stream, 24, keys));
+
+		pgn += "[Event \"?\"]\n[Result \"*\"]\n\n";
+		for (int ply = 0; ply < moves.size(); ply++)
+		{
+			if (ply % 2 == 0)
+				pgn += QByteArray::number(ply / 2 + 1) + ". ";
+			pgn += moves.at(ply).toLatin1() + ' ';
+		}
+		pgn += "*\n\n";
+	}
+	delete board;
+
+	return pgn;
+}
+
+void tst_PolyglotBook::initTestCase()
+{
+	QVERIFY(m_dir.isValid());
+
+	QVector<quint64> keys;
+	QByteArray pgn(playoutGames(20000, &keys));
+	PgnStream stream(&pgn);
+
+	PolyglotBook book(OpeningBook::Ram);
+	QVERIFY(book.import(stream, 24) > 0);
+	QVERIFY(book.write(bookFile()));
+
+	// The probes alternate between the positions of the games in
+	// a scattered order, like the openings of a tournament
+	for (int i = 0; i < 4096; i++)
+		m_hitKeys.append(keys.at(int((quint64(i) * 2654435761U) % keys.size())));
+	quint64 key = Q_UINT64_C(0x9E3779B97F4A7C15);
+	for (int i = 0; i < 4096; i++)
+	{
+		key ^= key << 13;
+		key ^= key >> 7;
+		key ^= key << 17;
+		m_missKeys.append(key);
+	}
+}
+
+QString tst_PolyglotBook::bookFile() const
+{
+	return m_dir.filePath("book.bin");
+}
+
+void tst_PolyglotBook::read_data() const
+{
+	QTest::addColumn<int>("mode");
+
+	QTest::newRow("ram") << int(OpeningBook::Ram);
+	QTest::newRow("disk") << int(OpeningBook::Disk);
+}
+
+void tst_PolyglotBook::read()
+{
+	QFETCH(int, mode);
+
+	QBENCHMARK
+	{
+		PolyglotBook book(OpeningBook::AccessMode(mode));
+		QVERIFY(book.read(bookFile()));
+	}
+}
+
+void tst_PolyglotBook::probe_data() const
+{
+	QTest::addColumn<int>("mode");
+	QTest::addColumn<bool>("hits");
+
+	QTest::newRow("ram hits") << int(OpeningBook::Ram) << true;
+	QTest::newRow("ram misses") << int(OpeningBook::Ram) << false;
+	QTest::newRow("disk hits") << int(OpeningBook::Disk) << true;
+	QTest::newRow("disk misses") << int(OpeningBook::Disk) << false;
+}
+
+void tst_PolyglotBook::probe()
+{
+	QFETCH(int, mode);
+	QFETCH(bool, hits);
+
+	PolyglotBook book(OpeningBook::AccessMode(mode));
+	QVERIFY(book.read(bookFile()));
+
+	const QVector<quint64>& keys(hits ? m_hitKeys : m_missKeys);
+	int found = 0;
+	QBENCHMARK
+	{
+		found = 0;
+		for (quint64 key : keys)
+		{
+			if (!book.move(key).isNull())
+				found++;
+		}
+	}
+	QCOMPARE(found > 0, hits);
+}
+
+QTEST_MAIN(tst_PolyglotBook)
+#include "tst_polyglotbook.moc"
@@ -0,0 +1,58 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RANDOMPLAYOUT_H
+#define RANDOMPLAYOUT_H
+
+#include <QStringList>
+#include <QVector>
+#include <board/board.h>
+#include <randomstream.h>
+
+/*
+ * Plays up to \a plies random legal moves on \a board, drawing them
+ * from \a stream, and returns them in SAN. The playout stops early if
+ * the game ends. If \a keys isn't null, the key of each position is
+ * appended to it before the move is made.
+ *
+ * The benchmarks make one stream per game, like BenchWorkload, so
+ * every game is reproducible on its own.
+ */
+inline QStringList randomPlayout(Chess::Board* board,
+				 RandomStream* stream,
+				 int plies,
+				 QVector<quint64>* keys = nullptr)
+{
+	QStringList sanMoves;
+	for (int i = 0; i < plies && board->result().isNone(); i++)
+	{
+		const QVector<Chess::Move> moves(board->legalMoves());
+		if (moves.isEmpty())
+			break;
+
+		if (keys != nullptr)
+			keys->append(board->key());
+		const Chess::Move& move = moves.at(int(stream->next() % moves.size()));
+		sanMoves << board->moveString(move, Chess::Board::StandardAlgebraic);
+		board->makeMove(move);
+	}
+
+	return sanMoves;
+}
+
+#endif // RANDOMPLAYOUT_H
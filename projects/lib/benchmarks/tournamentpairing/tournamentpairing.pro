@@ -0,0 +1,5 @@
+include(../benchmarks.pri)
+include(../../libexport.pri)
+
+TARGET = tst_tournamentpairing
+SOURCES += tst_tournamentpairing.cpp
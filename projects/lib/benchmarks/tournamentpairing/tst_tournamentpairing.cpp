@@ -0,0 +1,114 @@
+#include <QtTest/QtTest>
+#include <gamemanager.h>
+#include <tournament.h>
+#include <tournamentfactory.h>
+#include <enginebuilder.h>
+#include <engineconfiguration.h>
+#include <timecontrol.h>
+#include <pgngame.h>
+#include <board/result.h>
+
+
+class tst_TournamentPairing: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void schedule_data() const;
+		void schedule();
+};
+
+void tst_TournamentPairing::schedule_data() const
+{
+	QTest::addColumn<QString>("type");
+	QTest::addColumn<int>("players");
+
+	for (const QString type : { "round-robin", "gauntlet", "knockout",
+				    "pyramid", "swiss", "adaptive" })
+	{
+		for (int players : { 10, 100, 1000 })
+		{
+			QString name = QString("%1 %2 players").arg(type).arg(players);
+			QTest::newRow(qPrintable(name)) << type << players;
+		}
+	}
+}
+
+/*
+ * Schedules the games of a tournament without playing them.
+ *
+ * The games are remote games, so the tournament only does the pairing,
+ * prepares each game and keeps the score. The results are made up
+ * right away, which lets the pairing of knockout, Swiss and adaptive
+ * tournaments advance. This measures nextPair() in the same path that
+ * starts the games of a real tournament.
+ */
+void tst_TournamentPairing::schedule()
+{
+	QFETCH(QString, type);
+	QFETCH(int, players);
+
+	// The games in progress at a time, and the games scheduled in
+	// total. A full round-robin of 1000 players has 499500 games.
+	const int concurrency = 16;
+	const int maxGames = 5000;
+
+	GameManager manager;
+	Tournament* tournament = TournamentFactory::create(type, &manager);
+	QVERIFY(tournament != nullptr);
+	tournament->setRemoteGames(true);
+	tournament->setExternalScheduling(true);
+
+	for (int i = 0; i < players; i++)
+	{
+		EngineConfiguration config(QString("Player %1").arg(i),
+					   "engine", "uci");
+		tournament->addPlayer(new EngineBuilder(config),
+				      TimeControl("40/60"));
+	}
+
+	QList<int> games;
+	int scheduled = 0;
+	connect(tournament, &Tournament::gameDispatched,
+		[&](int number) { games.append(number); scheduled++; });
+
+	QElapsedTimer timer;
+	QBENCHMARK_ONCE
+	{
+		timer.start();
+		tournament->start();
+		tournament->startNextGames(concurrency - 1);
+
+		while (!games.isEmpty() && scheduled < maxGames)
+		{
+			const int number = games.takeFirst();
+
+			PgnGame pgn;
+			switch (number * 7 % 3)
+			{
+			case 0:
+				pgn.setResult(Chess::Result(Chess::Result::Win,
+							    Chess::Side::White));
+				break;
+			case 1:
+				pgn.setResult(Chess::Result(Chess::Result::Win,
+							    Chess::Side::Black));
+				break;
+			default:
+				pgn.setResult(Chess::Result(Chess::Result::Draw));
+				break;
+			}
+			tournament->finishRemoteGame(number, &pgn);
+			tournament->startNextGame();
+		}
+	}
+
+	const double elapsed = qMax(qint64(1), timer.nsecsElapsed()) / 1.0e3;
+	QVERIFY(scheduled > 0);
+	qInfo("%d games, %.1f us/game", scheduled, elapsed / scheduled);
+
+	delete tournament;
+}
+
+QTEST_MAIN(tst_TournamentPairing)
+#include "tst_tournamentpairing.moc"
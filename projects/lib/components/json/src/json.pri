@@ -1,5 +1,7 @@
 INCLUDEPATH += $$PWD
 HEADERS += $$PWD/jsonparser.h \
+    $$PWD/jsonreader.h \
     $$PWD/jsonserializer.h
 SOURCES += $$PWD/jsonparser.cpp \
+    $$PWD/jsonreader.cpp \
     $$PWD/jsonserializer.cpp
@@ -0,0 +1,586 @@
+/*
+    Copyright (c) 2010 Ilari Pihlajisto
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "jsonreader.h"
+#include <QVector>
+
+namespace {
+
+inline bool isSpace(char c)
+{
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isLiteralChar(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')
+	    || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+int hexValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+// Builds a QVariant tree from the reader's callbacks
+class VariantBuilder : public JsonReader::Handler
+{
+	public:
+		QVariant result;
+
+		virtual JsonReader::Action beginObject()
+		{
+			m_stack.append(Container());
+			m_stack.last().isObject = true;
+			return JsonReader::Continue;
+		}
+
+		virtual JsonReader::Action endObject()
+		{
+			Container container(m_stack.takeLast());
+			add(container.map);
+			return JsonReader::Continue;
+		}
+
+		virtual JsonReader::Action key(const QString& name)
+		{
+			m_stack.last().key = name;
+			return JsonReader::Continue;
+		}
+
+		virtual JsonReader::Action beginArray()
+		{
+			m_stack.append(Container());
+			m_stack.last().isObject = false;
+			return JsonReader::Continue;
+		}
+
+		virtual JsonReader::Action endArray()
+		{
+			Container container(m_stack.takeLast());
+			add(container.list);
+			return JsonReader::Continue;
+		}
+
+		virtual JsonReader::Action value(const QVariant& value)
+		{
+			add(value);
+			return JsonReader::Continue;
+		}
+
+	private:
+		struct Container
+		{
+			bool isObject;
+			QString key;
+			QVariantMap map;
+			QVariantList list;
+		};
+
+		void add(const QVariant& value)
+		{
+			if (m_stack.isEmpty())
+				result = value;
+			else if (m_stack.last().isObject)
+				m_stack.last().map.insert(m_stack.last().key, value);
+			else
+				m_stack.last().list.append(value);
+		}
+
+		QVector<Container> m_stack;
+};
+
+} // anonymous namespace
+
+
+JsonReader::Handler::~Handler()
+{
+}
+
+JsonReader::Action JsonReader::Handler::beginObject()
+{
+	return Continue;
+}
+
+JsonReader::Action JsonReader::Handler::endObject()
+{
+	return Continue;
+}
+
+JsonReader::Action JsonReader::Handler::key(const QString& name)
+{
+	Q_UNUSED(name);
+	return Continue;
+}
+
+JsonReader::Action JsonReader::Handler::beginArray()
+{
+	return Continue;
+}
+
+JsonReader::Action JsonReader::Handler::endArray()
+{
+	return Continue;
+}
+
+JsonReader::Action JsonReader::Handler::value(const QVariant& value)
+{
+	Q_UNUSED(value);
+	return Continue;
+}
+
+
+JsonReader::JsonReader(const char* data, qint64 size)
+	: m_begin(data),
+	  m_pos(data),
+	  m_end(data + size),
+	  m_error(false),
+	  m_errorLine(0)
+{
+}
+
+JsonReader::JsonReader(const QByteArray& data)
+	: m_error(false),
+	  m_errorLine(0),
+	  m_data(data)
+{
+	m_begin = m_pos = m_data.constData();
+	m_end = m_begin + m_data.size();
+}
+
+bool JsonReader::hasError() const
+{
+	return m_error;
+}
+
+QString JsonReader::errorString() const
+{
+	return m_errorString;
+}
+
+qint64 JsonReader::errorLineNumber() const
+{
+	return m_errorLine;
+}
+
+void JsonReader::setError(const QString& message)
+{
+	if (m_error)
+		return;
+
+	m_error = true;
+	m_errorString = message;
+
+	// Lines are counted only when they're needed
+	m_errorLine = 1;
+	for (const char* p = m_begin; p < m_pos && p < m_end; p++)
+	{
+		if (*p == '\n')
+			m_errorLine++;
+	}
+}
+
+bool JsonReader::read(Handler* handler)
+{
+	Q_ASSERT(handler != nullptr);
+
+	// Skip the UTF-8 byte order mark
+	if (m_end - m_pos >= 3 && qstrncmp(m_pos, "\xEF\xBB\xBF", 3) == 0)
+		m_pos += 3;
+
+	parseValue(handler, 0);
+	return !m_error;
+}
+
+QVariant JsonReader::readVariant()
+{
+	VariantBuilder builder;
+	if (!read(&builder))
+		return QVariant();
+	return builder.result;
+}
+
+bool JsonReader::skipSpace()
+{
+	while (m_pos < m_end && isSpace(*m_pos))
+		m_pos++;
+
+	if (m_pos < m_end)
+		return true;
+	setError(tr("Reached EOF unexpectedly"));
+	return false;
+}
+
+bool JsonReader::expect(char c)
+{
+	if (!skipSpace())
+		return false;
+	if (*m_pos == c)
+	{
+		m_pos++;
+		return true;
+	}
+	return false;
+}
+
+JsonReader::Action JsonReader::parseValue(Handler* handler, int depth)
+{
+	if (!skipSpace())
+		return Stop;
+
+	switch (*m_pos)
+	{
+	case '{':
+		return parseObject(handler, depth + 1);
+	case '[':
+		return parseArray(handler, depth + 1);
+	case '\"':
+		{
+			QString str;
+			if (!parseString(&str))
+				return Stop;
+			return handler->value(str);
+		}
+	default:
+		{
+			QVariant value;
+			if (!parseLiteral(&value))
+				return Stop;
+			return handler->value(value);
+		}
+	}
+}
+
+JsonReader::Action JsonReader::parseObject(Handler* handler, int depth)
+{
+	if (depth > MaxDepth)
+	{
+		setError(tr("Too deeply nested data"));
+		return Stop;
+	}
+
+	Action action = handler->beginObject();
+	if (action != Continue)
+		return action == Skip && skipValue(depth) ? Continue : Stop;
+	m_pos++;
+
+	if (expect('}'))
+		return handler->endObject();
+
+	for (;;)
+	{
+		if (m_error || !skipSpace())
+			return Stop;
+		if (*m_pos != '\"')
+		{
+			setError(tr("Invalid key"));
+			return Stop;
+		}
+
+		QString name;
+		if (!parseString(&name))
+			return Stop;
+		if (!expect(':'))
+		{
+			setError(tr("Expected colon after key: %1").arg(name));
+			return Stop;
+		}
+
+		action = handler->key(name);
+		if (action == Skip)
+		{
+			if (!skipSpace() || !skipValue(depth))
+				return Stop;
+		}
+		else if (action == Stop
+		     ||  parseValue(handler, depth) == Stop)
+			return Stop;
+
+		if (expect('}'))
+			return handler->endObject();
+		if (m_error || !expect(','))
+		{
+			setError(tr("Expected comma or closing bracket"));
+			return Stop;
+		}
+	}
+}
+
+JsonReader::Action JsonReader::parseArray(Handler* handler, int depth)
+{
+	if (depth > MaxDepth)
+	{
+		setError(tr("Too deeply nested data"));
+		return Stop;
+	}
+
+	Action action = handler->beginArray();
+	if (action != Continue)
+		return action == Skip && skipValue(depth) ? Continue : Stop;
+	m_pos++;
+
+	if (expect(']'))
+		return handler->endArray();
+
+	for (;;)
+	{
+		if (m_error || parseValue(handler, depth) == Stop)
+			return Stop;
+
+		if (expect(']'))
+			return handler->endArray();
+		if (m_error || !expect(','))
+		{
+			setError(tr("Expected comma or closing bracket"));
+			return Stop;
+		}
+	}
+}
+
+bool JsonReader::parseString(QString* str)
+{
+	Q_ASSERT(*m_pos == '\"');
+	const char* start = ++m_pos;
+
+	// Fast path for strings without escape sequences
+	while (m_pos < m_end && *m_pos != '\"' && *m_pos != '\\')
+		m_pos++;
+	if (m_pos >= m_end)
+	{
+		setError(tr("Reached EOF unexpectedly"));
+		return false;
+	}
+	*str = QString::fromUtf8(start, int(m_pos - start));
+	if (*m_pos == '\"')
+	{
+		m_pos++;
+		return true;
+	}
+
+	while (m_pos < m_end)
+	{
+		char c = *m_pos++;
+		if (c == '\"')
+			return true;
+		if (c != '\\')
+		{
+			start = m_pos - 1;
+			while (m_pos < m_end && *m_pos != '\"' && *m_pos != '\\')
+				m_pos++;
+			str->append(QString::fromUtf8(start, int(m_pos - start)));
+			continue;
+		}
+
+		if (m_pos >= m_end)
+			break;
+		c = *m_pos++;
+		switch (c)
+		{
+		case '\"':
+		case '\\':
+		case '/':
+			str->append(QLatin1Char(c));
+			break;
+		case 'b':
+			str->append(QLatin1Char('\b'));
+			break;
+		case 'f':
+			str->append(QLatin1Char('\f'));
+			break;
+		case 'n':
+			str->append(QLatin1Char('\n'));
+			break;
+		case 'r':
+			str->append(QLatin1Char('\r'));
+			break;
+		case 't':
+			str->append(QLatin1Char('\t'));
+			break;
+		case 'u':
+			{
+				if (m_end - m_pos < 4)
+				{
+					m_pos = m_end;
+					break;
+				}
+				int code = 0;
+				for (int i = 0; i < 4; i++)
+				{
+					int digit = hexValue(*m_pos++);
+					if (digit == -1)
+					{
+						setError(tr("Invalid unicode value: \\u%1")
+							 .arg(QString::fromLatin1(m_pos - i - 1, 4)));
+						return false;
+					}
+					code = code * 16 + digit;
+				}
+				str->append(QChar(ushort(code)));
+			}
+			break;
+		default:
+			setError(tr("Unknown escape sequence: \\%1")
+				 .arg(QLatin1Char(c)));
+			return false;
+		}
+	}
+
+	setError(tr("Reached EOF unexpectedly"));
+	return false;
+}
+
+bool JsonReader::parseLiteral(QVariant* value)
+{
+	const char* start = m_pos;
+	while (m_pos < m_end && isLiteralChar(*m_pos))
+		m_pos++;
+
+	const int size = int(m_pos - start);
+	const QByteArray token(QByteArray::fromRawData(start, size));
+	if (size == 0)
+	{
+		m_pos = start;
+		setError(tr("Invalid value: %1").arg(QLatin1Char(*start)));
+		return false;
+	}
+
+	if (token == "true")
+		*value = true;
+	else if (token == "false")
+		*value = false;
+	else if (token == "null")
+		*value = QVariant();
+	else if ((*start >= '0' && *start <= '9') || *start == '-')
+	{
+		bool ok = false;
+		if (token.contains('.') || token.contains('e') || token.contains('E'))
+		{
+			double val = token.toDouble(&ok);
+			if (ok)
+				*value = val;
+		}
+		else
+		{
+			int val = token.toInt(&ok);
+			if (ok)
+				*value = val;
+			else
+			{
+				qlonglong longVal = token.toLongLong(&ok);
+				if (ok)
+					*value = longVal;
+			}
+		}
+		if (!ok)
+		{
+			setError(tr("Invalid number: %1")
+				 .arg(QString::fromLatin1(start, size)));
+			return false;
+		}
+	}
+	else
+	{
+		setError(tr("Unknown token: %1")
+			 .arg(QString::fromLatin1(start, size)));
+		return false;
+	}
+
+	return true;
+}
+
+bool JsonReader::skipString()
+{
+	Q_ASSERT(*m_pos == '\"');
+	for (m_pos++; m_pos < m_end; m_pos++)
+	{
+		if (*m_pos == '\\')
+			m_pos++;
+		else if (*m_pos == '\"')
+		{
+			m_pos++;
+			return true;
+		}
+	}
+
+	setError(tr("Reached EOF unexpectedly"));
+	return false;
+}
+
+bool JsonReader::skipValue(int depth)
+{
+	if (*m_pos == '\"')
+		return skipString();
+	if (*m_pos != '{' && *m_pos != '[')
+	{
+		QVariant value;
+		return parseLiteral(&value);
+	}
+
+	// Only the brackets are matched, the contents are not validated
+	QVector<char> closing;
+	while (m_pos < m_end)
+	{
+		char c = *m_pos;
+		if (c == '\"')
+		{
+			if (!skipString())
+				return false;
+			continue;
+		}
+
+		m_pos++;
+		if (c == '{' || c == '[')
+		{
+			if (depth + closing.size() > MaxDepth)
+			{
+				setError(tr("Too deeply nested data"));
+				return false;
+			}
+			closing.append(c == '{' ? '}' : ']');
+		}
+		else if (c == '}' || c == ']')
+		{
+			if (c != closing.last())
+			{
+				m_pos--;
+				setError(tr("Mismatched closing bracket: %1")
+					 .arg(QLatin1Char(c)));
+				return false;
+			}
+			closing.removeLast();
+			if (closing.isEmpty())
+				return true;
+		}
+	}
+
+	setError(tr("Reached EOF unexpectedly"));
+	return false;
+}
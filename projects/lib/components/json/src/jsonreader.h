@@ -0,0 +1,154 @@
+/*
+    Copyright (c) 2010 Ilari Pihlajisto
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <QVariant>
+#include <QCoreApplication>
+
+
+/*!
+ * \brief A fast JSON parser for in-memory data.
+ *
+ * JsonReader parses UTF-8 encoded JSON data from a memory buffer, eg.
+ * a QByteArray or a memory-mapped file. Unlike JsonParser it works on
+ * bytes instead of a text stream, and it can report the data to a
+ * Handler as it is read (like a SAX parser) instead of building a
+ * QVariant tree. The handler can skip the values it doesn't need;
+ * skipped values are only scanned for their end.
+ *
+ * readVariant() builds a QVariant tree of the same form as
+ * JsonParser::parse().
+ *
+ * JSON specification: http://json.org/
+ * \sa JsonParser
+ */
+class LIB_EXPORT JsonReader
+{
+	Q_DECLARE_TR_FUNCTIONS(JsonReader)
+
+	public:
+		/*! What the reader should do after a Handler callback. */
+		enum Action
+		{
+			Continue,	//!< Continue normally
+			Skip,		//!< Skip the value that begins
+			Stop		//!< Stop reading without an error
+		};
+
+		/*!
+		 * \brief Receives the JSON data from a JsonReader.
+		 *
+		 * The default implementations of the callbacks return
+		 * Continue.
+		 */
+		class LIB_EXPORT Handler
+		{
+			public:
+				/*! Destroys the handler. */
+				virtual ~Handler();
+
+				/*!
+				 * Called at the beginning of an object. Returning
+				 * Skip skips the object.
+				 */
+				virtual Action beginObject();
+				/*! Called at the end of an object. */
+				virtual Action endObject();
+				/*!
+				 * Called for the key \a name of an object's member.
+				 * Returning Skip skips the member's value.
+				 */
+				virtual Action key(const QString& name);
+				/*!
+				 * Called at the beginning of an array. Returning
+				 * Skip skips the array.
+				 */
+				virtual Action beginArray();
+				/*! Called at the end of an array. */
+				virtual Action endArray();
+				/*!
+				 * Called for a string, number, boolean or null
+				 * \a value.
+				 */
+				virtual Action value(const QVariant& value);
+		};
+
+		/*!
+		 * Creates a new reader for the \a size bytes at \a data.
+		 * The data must stay valid while the reader is used.
+		 */
+		JsonReader(const char* data, qint64 size);
+		/*! Creates a new reader for \a data. */
+		explicit JsonReader(const QByteArray& data);
+
+		/*!
+		 * Reads one JSON value and passes it to \a handler.
+		 *
+		 * Returns false if a parsing error occurs.
+		 */
+		bool read(Handler* handler);
+		/*!
+		 * Reads one JSON value and returns it as a QVariant.
+		 *
+		 * Returns a null QVariant object if a parsing error occurs.
+		 * Use hasError() to check for errors.
+		 */
+		QVariant readVariant();
+
+		/*! Returns true if a parsing error occured. */
+		bool hasError() const;
+		/*! Returns a detailed description of the error. */
+		QString errorString() const;
+		/*! Returns the line number on which the error occured. */
+		qint64 errorLineNumber() const;
+
+	private:
+		enum { MaxDepth = 512 };
+
+		bool skipSpace();
+		bool expect(char c);
+		Action parseValue(Handler* handler, int depth);
+		Action parseObject(Handler* handler, int depth);
+		Action parseArray(Handler* handler, int depth);
+		bool parseString(QString* str);
+		bool parseLiteral(QVariant* value);
+		bool skipValue(int depth);
+		bool skipString();
+		void setError(const QString& message);
+
+		Q_DISABLE_COPY(JsonReader)
+
+		const char* m_begin;
+		const char* m_pos;
+		const char* m_end;
+		bool m_error;
+		QString m_errorString;
+		qint64 m_errorLine;
+		QByteArray m_data;
+};
+
+#endif // JSONREADER_H
@@ -0,0 +1,235 @@
+/*
+    Copyright (c) 2010 Ilari Pihlajisto
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <QtTest/QtTest>
+#include <jsonreader.h>
+
+class tst_JsonReader: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void basics_data() const;
+		void basics() const;
+
+		void invalid_data() const;
+		void invalid() const;
+
+		void skip() const;
+		void stop() const;
+		void errorLine() const;
+};
+Q_DECLARE_METATYPE(QVariant)
+Q_DECLARE_METATYPE(QVariant::Type)
+
+namespace {
+
+// Records the keys it sees and skips the values of "skip" keys
+class KeyRecorder : public JsonReader::Handler
+{
+	public:
+		QStringList keys;
+		int values = 0;
+
+		virtual JsonReader::Action key(const QString& name)
+		{
+			keys << name;
+			return name == "skip" ? JsonReader::Skip
+					      : JsonReader::Continue;
+		}
+
+		virtual JsonReader::Action value(const QVariant& value)
+		{
+			Q_UNUSED(value);
+			values++;
+			return JsonReader::Continue;
+		}
+};
+
+class Stopper : public JsonReader::Handler
+{
+	public:
+		int values = 0;
+
+		virtual JsonReader::Action value(const QVariant& value)
+		{
+			Q_UNUSED(value);
+			return ++values == 2 ? JsonReader::Stop
+					     : JsonReader::Continue;
+		}
+};
+
+} // anonymous namespace
+
+
+void tst_JsonReader::basics_data() const
+{
+	QTest::addColumn<QByteArray>("input");
+	QTest::addColumn<QVariant::Type>("type");
+	QTest::addColumn<QVariant>("expected");
+
+	QTest::newRow("null")
+		<< QByteArray("null")
+		<< QVariant::Invalid
+		<< QVariant();
+	QTest::newRow("true")
+		<< QByteArray("true")
+		<< QVariant::Bool
+		<< QVariant(true);
+	QTest::newRow("int")
+		<< QByteArray("-1234567890")
+		<< QVariant::Int
+		<< QVariant(-1234567890);
+	QTest::newRow("64-bit int")
+		<< QByteArray("3567830610840546163")
+		<< QVariant::LongLong
+		<< QVariant(Q_INT64_C(3567830610840546163));
+	QTest::newRow("double")
+		<< QByteArray("3.71E-05")
+		<< QVariant::Double
+		<< QVariant(0.0000371);
+
+	QTest::newRow("string #1")
+		<< QByteArray("\"\"")
+		<< QVariant::String
+		<< QVariant(QString());
+	QTest::newRow("string #2")
+		<< QByteArray("\"Path = \\\"C:\\\\Program files\\\\foo\\\"\"")
+		<< QVariant::String
+		<< QVariant("Path = \"C:\\Program files\\foo\"");
+	QTest::newRow("string #3")
+		<< QByteArray("\"\\/\\b\\f\\n\\r\\t\"")
+		<< QVariant::String
+		<< QVariant("/\b\f\n\r\t");
+	QTest::newRow("string #4")
+		<< QByteArray("\"\\u2654\xe2\x99\x99\"")
+		<< QVariant::String
+		<< QVariant(QString("%1%2")
+			.arg(QChar(0x2654))
+			.arg(QChar(0x2659)));
+
+	QVariantMap obj;
+	obj["foo"] = "bar";
+	obj["number"] = -25;
+	obj["state"] = QVariant();
+	obj["empty array"] = QVariantList();
+	QTest::newRow("object")
+		<< QByteArray("{\"foo\" : \"bar\", \"number\" : -25, "
+			      "\"state\" : null, \"empty array\" : []}")
+		<< QVariant::Map
+		<< QVariant(obj);
+
+	QVariantList list;
+	list << QVariant() << QVariantMap() << "string data" << 1234567890;
+	QTest::newRow("array")
+		<< QByteArray("\xEF\xBB\xBF[null, {}, \"string data\", 1234567890]")
+		<< QVariant::List
+		<< QVariant(list);
+}
+
+void tst_JsonReader::basics() const
+{
+	QFETCH(QByteArray, input);
+	QFETCH(QVariant::Type, type);
+	QFETCH(QVariant, expected);
+
+	JsonReader reader(input);
+	QVariant data(reader.readVariant());
+
+	QVERIFY(!reader.hasError());
+	QCOMPARE(data.type(), type);
+	QCOMPARE(data, expected);
+}
+
+void tst_JsonReader::invalid_data() const
+{
+	QTest::addColumn<QByteArray>("input");
+
+	QTest::newRow("invalid #1") << QByteArray("random text");
+	QTest::newRow("invalid #2") << QByteArray("\"endquote missing");
+	QTest::newRow("invalid #3") << QByteArray("+256");
+	QTest::newRow("invalid #4") << QByteArray("256x");
+	QTest::newRow("invalid #5") << QByteArray("100.3.4");
+	QTest::newRow("invalid #6") << QByteArray("\"\\u005 \"");
+	QTest::newRow("invalid #7") << QByteArray("\"\\uffgg\"");
+	QTest::newRow("invalid #8") << QByteArray("{");
+	QTest::newRow("invalid #9") << QByteArray("[");
+	QTest::newRow("invalid #10") << QByteArray("}");
+	QTest::newRow("invalid #11") << QByteArray("{ ]");
+	QTest::newRow("invalid #12") << QByteArray("[ }");
+	QTest::newRow("invalid #13") << QByteArray("{ null, null }");
+	QTest::newRow("invalid #14") << QByteArray("{ \"id\" : 1, }");
+	QTest::newRow("invalid #15") << QByteArray("{ \"id\" : ,0 }");
+	QTest::newRow("invalid #16") << QByteArray("[ \"id\" : 1 ]");
+	QTest::newRow("invalid #17") << QByteArray("[ null, ]");
+	QTest::newRow("invalid #18") << QByteArray(2000, '[');
+}
+
+void tst_JsonReader::invalid() const
+{
+	QFETCH(QByteArray, input);
+
+	JsonReader reader(input);
+	QVariant data(reader.readVariant());
+
+	QVERIFY(data.isNull());
+	QVERIFY(reader.hasError());
+}
+
+void tst_JsonReader::skip() const
+{
+	QByteArray input("{ \"a\" : 1, \"skip\" : { \"b\" : [1, \"]}\", {}] },"
+			 " \"c\" : [2, 3], \"skip\" : \"str\" }");
+	JsonReader reader(input);
+	KeyRecorder handler;
+
+	QVERIFY(reader.read(&handler));
+	QCOMPARE(handler.keys, QStringList() << "a" << "skip" << "c" << "skip");
+	QCOMPARE(handler.values, 3);
+
+	JsonReader badReader(QByteArray("{ \"skip\" : [1, 2}, \"c\" : 1 }"));
+	QVERIFY(!badReader.read(&handler));
+}
+
+void tst_JsonReader::stop() const
+{
+	JsonReader reader(QByteArray("[1, 2, 3, garbage"));
+	Stopper handler;
+
+	QVERIFY(reader.read(&handler));
+	QVERIFY(!reader.hasError());
+	QCOMPARE(handler.values, 2);
+}
+
+void tst_JsonReader::errorLine() const
+{
+	JsonReader reader(QByteArray("[\n\t1,\n\t2,\n\tx\n]"));
+
+	QVERIFY(reader.readVariant().isNull());
+	QCOMPARE(reader.errorLineNumber(), qint64(4));
+}
+
+QTEST_MAIN(tst_JsonReader)
+#include "tst_jsonreader.moc"
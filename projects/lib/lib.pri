@@ -1,2 +1,3 @@
 INCLUDEPATH += $$PWD/src
 LIBS += -lcutechess -L$$PWD
+QT += network
@@ -15,3 +15,14 @@ equals(TEMPLATE, "lib") {
     VAL_LIB_EXPORT="__declspec(dllimport)"
 }
 DEFINES += LIB_EXPORT=$$VAL_LIB_EXPORT
+
+# Compressed PGN files are supported with "CONFIG+=gzip" (zlib)
+# and "CONFIG+=zstd" (libzstd 1.4 or later)
+gzip {
+    DEFINES += CUTECHESS_GZIP
+    LIBS += -lz
+}
+zstd {
+    DEFINES += CUTECHESS_ZSTD
+    LIBS += -lzstd
+}
@@ -0,0 +1,63 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "adaptivemargin.h"
+#include <QMutexLocker>
+
+AdaptiveMargin::AdaptiveMargin(qint64 capUsec)
+	: m_cap(qMax(capUsec, Q_INT64_C(0))),
+	  m_savedMoves(0)
+{
+}
+
+qint64 AdaptiveMargin::capUsec() const
+{
+	return m_cap;
+}
+
+qint64 AdaptiveMargin::compensationUsec() const
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_lag.count() < MinSamples)
+		return 0;
+	return qMin(m_lag.percentile(99) / 1000, m_cap);
+}
+
+void AdaptiveMargin::addLag(qint64 usec)
+{
+	QMutexLocker locker(&m_mutex);
+	m_lag.add(qMax(usec, Q_INT64_C(0)) * 1000);
+}
+
+LatencyHistogram AdaptiveMargin::lag() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_lag;
+}
+
+void AdaptiveMargin::addSavedMove()
+{
+	QMutexLocker locker(&m_mutex);
+	m_savedMoves++;
+}
+
+int AdaptiveMargin::savedMoves() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_savedMoves;
+}
@@ -0,0 +1,85 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ADAPTIVEMARGIN_H
+#define ADAPTIVEMARGIN_H
+
+#include <QMutex>
+#include "latencyhistogram.h"
+
+/*!
+ * \brief A time margin that follows an engine's observed lag
+ *
+ * A fixed expiry margin is either too small on a loaded host, which
+ * causes time forfeits that aren't the engine's fault, or so large
+ * that it hides real flagging bugs. AdaptiveMargin instead measures
+ * the lag of every move: the time charged to the engine beyond the
+ * search time the engine reported itself. This lag is caused by I/O,
+ * process scheduling and Cute Chess, not by the engine's time
+ * management. The compensation is the 99th percentile of the lag,
+ * limited to a cap, so an engine that overruns its own reported
+ * search time still loses on time.
+ *
+ * Engines that don't report their search time get no compensation.
+ *
+ * The object is shared by all games of an engine through copies of
+ * its TimeControl. All functions are thread-safe.
+ */
+class LIB_EXPORT AdaptiveMargin
+{
+	public:
+		/*! The number of moves measured before compensating. */
+		static const int MinSamples = 10;
+
+		/*!
+		 * Creates a new adaptive margin that compensates at most
+		 * \a capUsec microseconds.
+		 */
+		explicit AdaptiveMargin(qint64 capUsec);
+
+		/*! Returns the maximum compensation in microseconds. */
+		qint64 capUsec() const;
+		/*!
+		 * Returns the current compensation in microseconds, or 0
+		 * until MinSamples moves have been measured.
+		 */
+		qint64 compensationUsec() const;
+
+		/*! Adds the lag of a move, \a usec microseconds. */
+		void addLag(qint64 usec);
+		/*! Returns the lag of the measured moves. */
+		LatencyHistogram lag() const;
+
+		/*!
+		 * Counts a move that would have lost on time without
+		 * the compensation.
+		 */
+		void addSavedMove();
+		/*! Returns the number of moves saved by the compensation. */
+		int savedMoves() const;
+
+	private:
+		Q_DISABLE_COPY(AdaptiveMargin)
+
+		mutable QMutex m_mutex;
+		qint64 m_cap;
+		LatencyHistogram m_lag;
+		int m_savedMoves;
+};
+
+#endif // ADAPTIVEMARGIN_H
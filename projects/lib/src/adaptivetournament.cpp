@@ -0,0 +1,128 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "adaptivetournament.h"
+#include <QtMath>
+#include <algorithm>
+#include "ratingmodel.h"
+
+AdaptiveTournament::AdaptiveTournament(GameManager* gameManager,
+				       QObject *parent)
+	: Tournament(gameManager, parent),
+	  m_encounterCount(0)
+{
+}
+
+QString AdaptiveTournament::type() const
+{
+	return "adaptive";
+}
+
+void AdaptiveTournament::initializePairing()
+{
+	m_encounterCount = 0;
+	setCurrentRound(1);
+}
+
+int AdaptiveTournament::gamesPerCycle() const
+{
+	return (playerCount() * (playerCount() - 1)) / 2;
+}
+
+QVector<int> AdaptiveTournament::ranking() const
+{
+	const RatingModel& ratings(ratingModel());
+	QVector<int> players(playerCount());
+	for (int i = 0; i < players.size(); i++)
+		players[i] = i;
+
+	std::stable_sort(players.begin(), players.end(), [&](int a, int b)
+	{
+		return ratings.rating(a) > ratings.rating(b);
+	});
+	return players;
+}
+
+qreal AdaptiveTournament::uncertainty(int player1, int player2) const
+{
+	// Positive while the confidence interval of the rating
+	// difference still contains zero
+	const RatingModel& ratings(ratingModel());
+	const qreal margin1 = ratings.errorMargin(player1);
+	const qreal margin2 = ratings.errorMargin(player2);
+	const qreal diff = ratings.rating(player1) - ratings.rating(player2);
+
+	return qSqrt(margin1 * margin1 + margin2 * margin2) - qAbs(diff);
+}
+
+TournamentPair* AdaptiveTournament::nextPair(int gameNumber)
+{
+	if (gameNumber >= finalGameCount())
+		return nullptr;
+	if (gameNumber % gamesPerEncounter() != 0)
+		return currentPair();
+
+	const QVector<int> players(ranking());
+	TournamentPair* next = nullptr;
+	qreal maxPriority = 0.0;
+	for (int i = 0; i + 1 < players.size(); i++)
+	{
+		const int player1 = players.at(i);
+		const int player2 = players.at(i + 1);
+		const qreal value = uncertainty(player1, player2);
+		if (value <= 0.0)
+			continue;
+
+		TournamentPair* candidate = pair(player1, player2);
+		const int gamesInProgress = candidate->gamesStarted()
+			- ratingModel().games(player1, player2);
+		const qreal priority = value / (1 + qMax(gamesInProgress, 0));
+		if (priority > maxPriority)
+		{
+			maxPriority = priority;
+			next = candidate;
+		}
+	}
+	if (next == nullptr)
+		return nullptr;
+
+	// A round has as many encounters as there are games in a
+	// round of a round-robin tournament
+	const int roundSize = qMax(playerCount() / 2, 1);
+	if (m_encounterCount > 0 && m_encounterCount % roundSize == 0)
+		setCurrentRound(currentRound() + 1);
+	m_encounterCount++;
+
+	return next;
+}
+
+bool AdaptiveTournament::areAllGamesFinished() const
+{
+	if (Tournament::areAllGamesFinished())
+		return true;
+	if (gamesInProgress() > 0)
+		return false;
+
+	const QVector<int> players(ranking());
+	for (int i = 0; i + 1 < players.size(); i++)
+	{
+		if (uncertainty(players.at(i), players.at(i + 1)) > 0.0)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,65 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ADAPTIVETOURNAMENT_H
+#define ADAPTIVETOURNAMENT_H
+
+#include "tournament.h"
+
+/*!
+ * \brief Adaptive chess tournament for ranking many players.
+ *
+ * An adaptive tournament picks each pair so that the ranking of the
+ * players becomes clear with as few games as possible. The players
+ * are ranked by the maximum-likelihood ratings of ratingModel(), and
+ * the next game is played between the neighbours in the ranking whose
+ * order is the most uncertain, ie. whose rating difference is the
+ * smallest compared to its 95% confidence interval (an LUCB-style
+ * bandit rule). Games in progress count against a pair, so that
+ * concurrent games are spread over the uncertain pairs.
+ *
+ * The tournament ends when every pair of neighbours is separated, or
+ * when it has played as many games as a round-robin tournament with
+ * the same settings would.
+ */
+class LIB_EXPORT AdaptiveTournament : public Tournament
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new adaptive tournament. */
+		explicit AdaptiveTournament(GameManager* gameManager,
+					    QObject *parent = nullptr);
+		// Inherited from Tournament
+		virtual QString type() const;
+
+	protected:
+		// Inherited from Tournament
+		virtual void initializePairing();
+		virtual int gamesPerCycle() const;
+		virtual TournamentPair* nextPair(int gameNumber);
+		virtual bool areAllGamesFinished() const;
+
+	private:
+		QVector<int> ranking() const;
+		qreal uncertainty(int player1, int player2) const;
+
+		int m_encounterCount;
+};
+
+#endif // ADAPTIVETOURNAMENT_H
@@ -0,0 +1,190 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "adjudicationreplay.h"
+#include <climits>
+#include <QThread>
+#include <QScopedPointer>
+#include "board/board.h"
+#include "moveevaluation.h"
+#include "pgngame.h"
+#include "pgnstream.h"
+#include "pgnchunkreader.h"
+
+namespace {
+
+typedef AdjudicationReplay::Statistics Statistics;
+
+/*! Replays a chunk of PGN games. */
+int replayChunk(const QByteArray& data,
+		const AdjudicationReplay* replay,
+		QVector<Statistics>* stats)
+{
+	int games = 0;
+	PgnStream in(&data);
+	PgnGame game;
+	while (game.read(in, INT_MAX - 1, false))
+	{
+		games++;
+		replay->replayGame(game, stats);
+	}
+	return games;
+}
+
+} // anonymous namespace
+
+AdjudicationReplay::AdjudicationReplay()
+	: m_threadCount(QThread::idealThreadCount()),
+	  m_gameCount(0)
+{
+}
+
+void AdjudicationReplay::addCandidate(const QString& name,
+				      const GameAdjudicator& adjudicator)
+{
+	const Statistics empty = { 0, 0, 0, 0 };
+	m_names.append(name);
+	m_adjudicators.append(adjudicator);
+	m_stats.append(empty);
+}
+
+int AdjudicationReplay::candidateCount() const
+{
+	return m_adjudicators.size();
+}
+
+QString AdjudicationReplay::candidateName(int index) const
+{
+	return m_names.at(index);
+}
+
+AdjudicationReplay::Statistics AdjudicationReplay::statistics(int index) const
+{
+	return m_stats.at(index);
+}
+
+void AdjudicationReplay::setThreadCount(int count)
+{
+	Q_ASSERT(count > 0);
+	m_threadCount = count;
+}
+
+qint64 AdjudicationReplay::gameCount() const
+{
+	return m_gameCount;
+}
+
+void AdjudicationReplay::addStatistics(const QVector<Statistics>& stats)
+{
+	for (int i = 0; i < stats.size(); i++)
+	{
+		Statistics& total = m_stats[i];
+		total.games += stats.at(i).games;
+		total.adjudicated += stats.at(i).adjudicated;
+		total.pliesSaved += stats.at(i).pliesSaved;
+		total.wrongResults += stats.at(i).wrongResults;
+	}
+}
+
+void AdjudicationReplay::replayGame(const PgnGame& game,
+				    QVector<Statistics>* stats) const
+{
+	Q_ASSERT(stats->size() == m_adjudicators.size());
+
+	QScopedPointer<Chess::Board> board(game.createBoard());
+	if (board.isNull())
+		return;
+
+	// Fresh copies of the candidates, and the ply of each adjudication
+	QVector<GameAdjudicator> adjudicators(m_adjudicators);
+	QVector<int> adjudicatedPly(adjudicators.size(), -1);
+	int pending = adjudicators.size();
+
+	const QVector<PgnGame::MoveData>& moves = game.moves();
+	for (int ply = 0; ply < moves.size() && pending > 0; ply++)
+	{
+		const PgnGame::MoveData& md = moves.at(ply);
+		const Chess::Move move(board->moveFromGenericMove(md.move));
+		if (move.isNull())
+			break;
+
+		// Same order as in ChessGame::onMoveMade()
+		board->makeMove(move);
+		if (!board->result().isNone())
+			break;
+
+		const bool reset = board->reversibleMoveCount() == 0;
+		const MoveEvaluation eval(MoveEvaluation::fromPgnComment(md.commentText()));
+		for (int i = 0; i < adjudicators.size(); i++)
+		{
+			if (adjudicatedPly.at(i) != -1)
+				continue;
+
+			GameAdjudicator& adjudicator = adjudicators[i];
+			if (reset)
+				adjudicator.resetDrawMoveCount();
+			adjudicator.addEval(board.data(), eval);
+			if (!adjudicator.result().isNone())
+			{
+				adjudicatedPly[i] = ply + 1;
+				pending--;
+			}
+		}
+	}
+
+	const Chess::Result realResult(game.result());
+	for (int i = 0; i < adjudicators.size(); i++)
+	{
+		Statistics& candidate = (*stats)[i];
+		candidate.games++;
+
+		const int ply = adjudicatedPly.at(i);
+		if (ply == -1)
+			continue;
+
+		candidate.adjudicated++;
+		candidate.pliesSaved += moves.size() - ply;
+		const Chess::Result result(adjudicators.at(i).result());
+		if (!realResult.isNone()
+		&&  (result.winner() != realResult.winner()
+		||   result.isDraw() != realResult.isDraw()))
+			candidate.wrongResults++;
+	}
+}
+
+bool AdjudicationReplay::addPgnFile(const QString& fileName)
+{
+	PgnChunkReader reader;
+	if (!reader.open(fileName, QIODevice::ReadOnly | QIODevice::Text))
+		return false;
+
+	reader.process([this](const PgnChunkReader::Chunk& chunk)
+	{
+		const Statistics empty = { 0, 0, 0, 0 };
+		QVector<Statistics> stats(candidateCount(), empty);
+		const int games = replayChunk(chunk.data, this, &stats);
+
+		return PgnChunkReader::Collector([this, stats, games]()
+		{
+			m_gameCount += games;
+			addStatistics(stats);
+		});
+	}, m_threadCount);
+
+	return true;
+}
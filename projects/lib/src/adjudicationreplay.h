@@ -0,0 +1,115 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ADJUDICATIONREPLAY_H
+#define ADJUDICATIONREPLAY_H
+
+#include <QString>
+#include <QVector>
+#include "gameadjudicator.h"
+class PgnGame;
+
+/*!
+ * \brief Replays finished games through candidate adjudication settings
+ *
+ * AdjudicationReplay reads PGN files written by Cute Chess, restores
+ * the engines' evaluations from the move comments (see
+ * MoveEvaluation::fromPgnComment()) and feeds them to a copy of each
+ * candidate GameAdjudicator, like ChessGame does during a game. This
+ * shows how many games and plies the settings would have saved, and
+ * how often the adjudicated result differs from the one that was
+ * played out.
+ *
+ * The games are replayed by a pool of worker threads. Each game is
+ * replayed once for all of the candidates.
+ *
+ * \note Games that were adjudicated when they were played can only be
+ * adjudicated earlier by a candidate, so the PGN files should be
+ * played with adjudication disabled or with loose settings.
+ */
+class LIB_EXPORT AdjudicationReplay
+{
+	public:
+		/*! The results of a candidate. */
+		struct Statistics
+		{
+			/*! Number of games replayed. */
+			qint64 games;
+			/*! Number of games adjudicated. */
+			qint64 adjudicated;
+			/*! Number of plies played after the adjudications. */
+			qint64 pliesSaved;
+			/*!
+			 * Number of adjudicated games whose real result is
+			 * different from the adjudicated result.
+			 */
+			qint64 wrongResults;
+		};
+
+		/*! Creates a new replay with no candidates. */
+		AdjudicationReplay();
+
+		/*!
+		 * Adds a candidate named \a name, which adjudicates games
+		 * with copies of \a adjudicator.
+		 */
+		void addCandidate(const QString& name,
+				  const GameAdjudicator& adjudicator);
+		/*! Returns the number of candidates. */
+		int candidateCount() const;
+		/*! Returns the name of candidate \a index. */
+		QString candidateName(int index) const;
+		/*! Returns the results of candidate \a index. */
+		Statistics statistics(int index) const;
+
+		/*!
+		 * Sets the number of worker threads to \a count.
+		 * The default is the number of CPU cores.
+		 */
+		void setThreadCount(int count);
+
+		/*!
+		 * Replays the games of PGN file \a fileName. The file may
+		 * be compressed with gzip or Zstandard.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool addPgnFile(const QString& fileName);
+		/*!
+		 * Replays \a game, and adds its results to \a stats,
+		 * which has an entry for each candidate.
+		 *
+		 * This function is thread-safe.
+		 */
+		void replayGame(const PgnGame& game,
+				QVector<Statistics>* stats) const;
+
+		/*! Returns the number of games replayed so far. */
+		qint64 gameCount() const;
+
+	private:
+		void addStatistics(const QVector<Statistics>& stats);
+
+		int m_threadCount;
+		qint64 m_gameCount;
+		QVector<QString> m_names;
+		QVector<GameAdjudicator> m_adjudicators;
+		QVector<Statistics> m_stats;
+};
+
+#endif // ADJUDICATIONREPLAY_H
@@ -89,6 +89,13 @@ void AndernachBoard::vUndoMove(const Move& move)
 	StandardBoard::vUndoMove(move);
 }
 
+bool AndernachBoard::variantHasStandardLegality() const
+{
+	// A capturing piece changes sides and may give check
+	// to its former king.
+	return false;
+}
+
 bool AndernachBoard::switchesSides(const Move& move) const
 {
 	return captureType(move) != Piece::NoPiece
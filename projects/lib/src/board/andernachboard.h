@@ -61,6 +61,7 @@ class LIB_EXPORT AndernachBoard : public StandardBoard
 		virtual bool switchesSides(const Move& move) const;
 
 		// Inherited from StandardBoard
+		virtual bool variantHasStandardLegality() const;
 		virtual Move moveFromSanString(const QString& str);
 		virtual QString sanMoveString(const Move& move);
 		virtual void vMakeMove(const Move& move,
@@ -76,6 +76,11 @@ bool AntiBoard::inCheck(Side, int) const
 	return false;
 }
 
+bool AntiBoard::variantHasStandardLegality() const
+{
+	return false;
+}
+
 bool AntiBoard::vIsLegalMove(const Move& move)
 {
 	if (!StandardBoard::vIsLegalMove(move))
@@ -114,7 +119,7 @@ Result AntiBoard::vResultOfStalemate() const
 	return Result(Result::Win, winner, str);
 }
 
-Result AntiBoard::result()
+Result AntiBoard::vResult()
 {
 	QString str;
 	// stalemate or no pieces left
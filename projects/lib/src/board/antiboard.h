@@ -59,15 +59,16 @@ class LIB_EXPORT AntiBoard : public StandardBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
 
 	protected:
 		// Inherited from StandardBoard
+		virtual Result vResult();
 		virtual bool hasCastling() const;
 		virtual bool kingsCountAssertion(int whiteKings,
 						 int blackKings) const;
 		virtual bool vSetFenString(const QStringList& fen);
 		virtual bool inCheck(Side side, int square = 0) const;
+		virtual bool variantHasStandardLegality() const;
 		virtual bool vIsLegalMove(const Move& move);
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
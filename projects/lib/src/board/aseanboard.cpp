@@ -97,10 +97,10 @@ int AseanBoard::countingLimit() const
 	return 1000; // intentional limit
 }
 
-Result AseanBoard::result()
+Result AseanBoard::vResult()
 {
 	// Use standard chess result
-	Result gameResult = WesternBoard::result();
+	Result gameResult = WesternBoard::vResult();
 	if (!gameResult.isNone())
 	{
 		// In ASEAN-Chess a three-fold repetition is not a draw
@@ -78,7 +78,7 @@ class LIB_EXPORT AseanBoard : public MakrukBoard
 					   QVarLengthArray< Move >& moves) const;
 		virtual int countingLimit() const;
 		virtual CountingRules countingRules() const;
-		virtual Result result();
+		virtual Result vResult();
 };
 
 } // namespace Chess
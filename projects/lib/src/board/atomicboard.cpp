@@ -19,6 +19,7 @@
 #include "atomicboard.h"
 #include "westernzobrist.h"
 #include "boardtransition.h"
+#include "bitboard.h"
 
 
 namespace Chess {
@@ -50,6 +51,17 @@ bool AtomicBoard::kingCanCapture() const
 	return false;
 }
 
+bool AtomicBoard::variantHasBitboards() const
+{
+	return true;
+}
+
+bool AtomicBoard::variantHasStandardLegality() const
+{
+	// Explosions can remove pinned pieces and checkers
+	return false;
+}
+
 void AtomicBoard::vInitialize()
 {
 	int arwidth = width() + 2;
@@ -114,9 +126,91 @@ bool AtomicBoard::vIsLegalMove(const Move& move)
 			return true;
 	}
 
+	bool isLegal;
+	if (isLegalByBitboards(move, &isLegal))
+		return isLegal;
+
 	return WesternBoard::vIsLegalMove(move);
 }
 
+bool AtomicBoard::isLegalByBitboards(const Move& move, bool* isLegal) const
+{
+	Q_ASSERT(isLegal != nullptr);
+
+	const Side side = sideToMove();
+	const Side opSide = side.opposite();
+	const int kingSq = kingSquare(side);
+	const int opKingSq = kingSquare(opSide);
+	const int source = move.sourceSquare();
+	const int target = move.targetSquare();
+
+	if (!hasBitboards() || kingSq == 0 || opKingSq == 0
+	||  source == 0 || target == opKingSq)
+		return false;
+	// Castling and en-passant moves are verified by making them
+	if (pieceAt(target).side() == side)
+		return false;
+	if (pieceAt(source).type() == Pawn && target == enpassantSquare())
+		return false;
+
+	const quint64 sourceMask = Bitboard::squareMask(source);
+	const quint64 targetMask = Bitboard::squareMask(target);
+	quint64 occupied = (sideBitboard(side) | sideBitboard(opSide))
+			 & ~sourceMask;
+	quint64 removed = 0;
+
+	if (captureType(move) != Piece::NoPiece)
+	{
+		if (source == kingSq)
+		{
+			*isLegal = false;
+			return true;
+		}
+
+		// The capturing piece, the captured piece and all pieces
+		// except pawns next to the target square explode
+		const int targetBit = Bitboard::squareBit(target);
+		removed = targetMask | (Bitboard::kingAttacks(targetBit)
+					& ~pieceTypeBitboard(Pawn));
+		occupied &= ~removed;
+	}
+	else
+		occupied |= targetMask;
+
+	const int king = (source == kingSq) ? target : kingSq;
+	const int kingBit = Bitboard::squareBit(king);
+	const quint64 kingMask = Bitboard::squareMask(king);
+
+	// If the kings touch, there's no check
+	if (Bitboard::kingAttacks(kingBit) & Bitboard::squareMask(opKingSq))
+	{
+		*isLegal = true;
+		return true;
+	}
+
+	const quint64 attackers = sideBitboard(opSide) & ~removed;
+	const quint64 fileA = Q_UINT64_C(0x0101010101010101);
+	const quint64 fileH = fileA << 7;
+	quint64 pawnSquares;
+	if (side == Side::White)
+		pawnSquares = ((kingMask << 7) & ~fileH) | ((kingMask << 9) & ~fileA);
+	else
+		pawnSquares = ((kingMask >> 9) & ~fileH) | ((kingMask >> 7) & ~fileA);
+
+	const quint64 checkers =
+		((Bitboard::knightAttacks(kingBit)
+		  & movementBitboard(opSide, KnightMovement))
+		| (Bitboard::bishopAttacks(kingBit, occupied)
+		   & movementBitboard(opSide, BishopMovement))
+		| (Bitboard::rookAttacks(kingBit, occupied)
+		   & movementBitboard(opSide, RookMovement))
+		| (pawnSquares & pieceTypeBitboard(Pawn)))
+		& attackers;
+
+	*isLegal = (checkers == 0);
+	return true;
+}
+
 void AtomicBoard::vMakeMove(const Move& move, BoardTransition* transition)
 {
 	MoveData md;
@@ -169,7 +263,7 @@ void AtomicBoard::vUndoMove(const Move& move)
 	m_history.pop_back();
 }
 
-Result AtomicBoard::result()
+Result AtomicBoard::vResult()
 {
 	Side side(sideToMove());
 	if (pieceAt(kingSquare(side)).isEmpty())
@@ -179,7 +273,7 @@ Result AtomicBoard::result()
 		return Result(Result::Win, winner, str);
 	}
 
-	return WesternBoard::result();
+	return WesternBoard::vResult();
 }
 
 } // namespace Chess
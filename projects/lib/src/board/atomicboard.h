@@ -41,13 +41,15 @@ class LIB_EXPORT AtomicBoard : public WesternBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
 
 	protected:
 		// Inherited from WesternBoard
+		virtual Result vResult();
 		virtual void vInitialize();
 		virtual bool inCheck(Side side, int square = 0) const;
 		virtual bool kingCanCapture() const;
+		virtual bool variantHasBitboards() const;
+		virtual bool variantHasStandardLegality() const;
 		virtual bool vSetFenString(const QStringList& fen);
 		virtual bool vIsLegalMove(const Move& move);
 		virtual void vMakeMove(const Move& move,
@@ -62,7 +64,9 @@ class LIB_EXPORT AtomicBoard : public WesternBoard
 			Piece captures[8];
 		};
 
-		QVector<MoveData> m_history;
+		bool isLegalByBitboards(const Move& move, bool* isLegal) const;
+
+		QVarLengthArray<MoveData, 256> m_history;
 		int m_offsets[8];
 };
 
@@ -0,0 +1,314 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bitboard.h"
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Padded board geometry: 8x8 squares in a 10x12 array
+const int s_arwidth = 10;
+const int s_arraySize = 120;
+
+struct Magic
+{
+	quint64 mask;
+	quint64 magic;
+	quint64* attacks;
+	int shift;
+
+	inline unsigned index(quint64 occupied) const
+	{
+	#ifdef __BMI2__
+		return unsigned(_pext_u64(occupied, mask));
+	#else
+		return unsigned(((occupied & mask) * magic) >> shift);
+	#endif
+	}
+};
+
+class AttackTables
+{
+	public:
+		AttackTables();
+
+		quint64 squareMask[s_arraySize];
+		int squareIndex[64];
+		quint64 knight[64];
+		quint64 king[64];
+		quint64 between[64][64];
+		quint64 line[64][64];
+		Magic bishopMagics[64];
+		Magic rookMagics[64];
+
+	private:
+		void initMagics(Magic* magics,
+				quint64* table,
+				const int (*dirs)[2]);
+
+		quint64 m_bishopTable[0x1480];
+		quint64 m_rookTable[0x19000];
+};
+
+const int s_bishopDirs[4][2] = { {-1, -1}, {-1, 1}, {1, -1}, {1, 1} };
+const int s_rookDirs[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+
+quint64 bitAt(int file, int rank)
+{
+	if (file < 0 || file > 7 || rank < 0 || rank > 7)
+		return 0;
+	return Q_UINT64_C(1) << (rank * 8 + file);
+}
+
+quint64 ray(int bit, int df, int dr)
+{
+	quint64 attacks = 0;
+	quint64 b;
+	for (int file = bit % 8 + df, rank = bit / 8 + dr;
+	     (b = bitAt(file, rank)) != 0; file += df, rank += dr)
+		attacks |= b;
+	return attacks;
+}
+
+quint64 slidingAttacks(int bit, quint64 occupied, const int (*dirs)[2])
+{
+	quint64 attacks = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		int file = bit % 8 + dirs[i][0];
+		int rank = bit / 8 + dirs[i][1];
+		quint64 b;
+		while ((b = bitAt(file, rank)) != 0)
+		{
+			attacks |= b;
+			if (occupied & b)
+				break;
+			file += dirs[i][0];
+			rank += dirs[i][1];
+		}
+	}
+	return attacks;
+}
+
+// xorshift64* generator with fixed per-rank seeds that are known
+// to find the magics quickly, so that the magic numbers (and the
+// startup time) are the same on every run
+#ifndef __BMI2__
+quint64 nextRandom(quint64& state)
+{
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * Q_UINT64_C(2685821657736338717);
+}
+#endif
+
+AttackTables::AttackTables()
+{
+	for (int i = 0; i < s_arraySize; i++)
+		squareMask[i] = 0;
+
+	for (int bit = 0; bit < 64; bit++)
+	{
+		int file = bit % 8;
+		int rank = bit / 8;
+		int index = (7 - rank + 2) * s_arwidth + 1 + file;
+
+		squareIndex[bit] = index;
+		squareMask[index] = Q_UINT64_C(1) << bit;
+
+		knight[bit] = bitAt(file - 2, rank - 1) | bitAt(file - 2, rank + 1)
+			    | bitAt(file - 1, rank - 2) | bitAt(file - 1, rank + 2)
+			    | bitAt(file + 1, rank - 2) | bitAt(file + 1, rank + 2)
+			    | bitAt(file + 2, rank - 1) | bitAt(file + 2, rank + 1);
+		king[bit] = 0;
+		for (int df = -1; df <= 1; df++)
+		{
+			for (int dr = -1; dr <= 1; dr++)
+			{
+				if (df != 0 || dr != 0)
+					king[bit] |= bitAt(file + df, rank + dr);
+			}
+		}
+	}
+
+	for (int bit = 0; bit < 64; bit++)
+	{
+		for (int other = 0; other < 64; other++)
+		{
+			between[bit][other] = 0;
+			line[bit][other] = 0;
+		}
+		for (int i = 0; i < 8; i++)
+		{
+			const int* dir = (i < 4) ? s_bishopDirs[i] : s_rookDirs[i - 4];
+			quint64 axis = (Q_UINT64_C(1) << bit)
+				     | ray(bit, dir[0], dir[1])
+				     | ray(bit, -dir[0], -dir[1]);
+			quint64 path = 0;
+			quint64 b;
+			for (int file = bit % 8 + dir[0], rank = bit / 8 + dir[1];
+			     (b = bitAt(file, rank)) != 0;
+			     file += dir[0], rank += dir[1])
+			{
+				int other = Chess::Bitboard::lsb(b);
+				between[bit][other] = path;
+				line[bit][other] = axis;
+				path |= b;
+			}
+		}
+	}
+
+	initMagics(bishopMagics, m_bishopTable, s_bishopDirs);
+	initMagics(rookMagics, m_rookTable, s_rookDirs);
+}
+
+void AttackTables::initMagics(Magic* magics,
+			      quint64* table,
+			      const int (*dirs)[2])
+{
+	const quint64 rank1 = Q_UINT64_C(0xFF);
+	const quint64 rank8 = rank1 << 56;
+	const quint64 fileA = Q_UINT64_C(0x0101010101010101);
+	const quint64 fileH = fileA << 7;
+
+	quint64 occupancy[4096];
+	quint64 reference[4096];
+	int epoch[4096] = {};
+	int attempt = 0;
+	const quint64 seeds[8] = { 728, 10316, 55013, 32803,
+				   12281, 15100, 16645, 255 };
+
+	for (int bit = 0; bit < 64; bit++)
+	{
+		Magic& m = magics[bit];
+
+		// Board edges are not part of the occupancy mask, unless
+		// the slider itself stands on them.
+		quint64 edges = ((rank1 | rank8) & ~(rank1 << (bit / 8 * 8)))
+			      | ((fileA | fileH) & ~(fileA << (bit % 8)));
+		m.mask = slidingAttacks(bit, 0, dirs) & ~edges;
+		m.shift = 64 - Chess::Bitboard::count(m.mask);
+		m.magic = 0;
+		m.attacks = (bit == 0) ? table
+				       : magics[bit - 1].attacks
+					 + (1 << (64 - magics[bit - 1].shift));
+
+		// Enumerate all subsets of the mask (Carry-Rippler trick)
+		int size = 0;
+		quint64 b = 0;
+		do
+		{
+			occupancy[size] = b;
+			reference[size] = slidingAttacks(bit, b, dirs);
+		#ifdef __BMI2__
+			m.attacks[_pext_u64(b, m.mask)] = reference[size];
+		#endif
+			size++;
+			b = (b - m.mask) & m.mask;
+		} while (b != 0);
+
+	#ifndef __BMI2__
+		quint64 seed = seeds[bit / 8];
+		for (int i = 0; i < size; )
+		{
+			do
+			{
+				m.magic = nextRandom(seed) & nextRandom(seed)
+					& nextRandom(seed);
+			} while (Chess::Bitboard::count((m.magic * m.mask) >> 56) < 6);
+
+			// A magic is valid if every occupancy maps to an
+			// index whose attack set is either unused in this
+			// attempt or identical.
+			attempt++;
+			for (i = 0; i < size; i++)
+			{
+				unsigned idx = m.index(occupancy[i]);
+				if (epoch[idx] < attempt)
+				{
+					epoch[idx] = attempt;
+					m.attacks[idx] = reference[i];
+				}
+				else if (m.attacks[idx] != reference[i])
+					break;
+			}
+		}
+	#else
+		Q_UNUSED(occupancy);
+		Q_UNUSED(epoch);
+		Q_UNUSED(attempt);
+		Q_UNUSED(seeds);
+	#endif
+	}
+}
+
+const AttackTables s_tables;
+
+} // anonymous namespace
+
+namespace Chess {
+namespace Bitboard {
+
+quint64 squareMask(int squareIndex)
+{
+	Q_ASSERT(squareIndex >= 0 && squareIndex < s_arraySize);
+	return s_tables.squareMask[squareIndex];
+}
+
+int squareIndex(int bit)
+{
+	Q_ASSERT(bit >= 0 && bit < 64);
+	return s_tables.squareIndex[bit];
+}
+
+quint64 knightAttacks(int bit)
+{
+	return s_tables.knight[bit];
+}
+
+quint64 kingAttacks(int bit)
+{
+	return s_tables.king[bit];
+}
+
+quint64 between(int bit1, int bit2)
+{
+	return s_tables.between[bit1][bit2];
+}
+
+quint64 line(int bit1, int bit2)
+{
+	return s_tables.line[bit1][bit2];
+}
+
+quint64 bishopAttacks(int bit, quint64 occupied)
+{
+	const Magic& m = s_tables.bishopMagics[bit];
+	return m.attacks[m.index(occupied)];
+}
+
+quint64 rookAttacks(int bit, quint64 occupied)
+{
+	const Magic& m = s_tables.rookMagics[bit];
+	return m.attacks[m.index(occupied)];
+}
+
+} // namespace Bitboard
+} // namespace Chess
@@ -0,0 +1,104 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+
+namespace Chess {
+
+/*!
+ * \brief Bitboard helpers for 8x8 boards
+ *
+ * A bitboard is a 64-bit set of squares on an 8x8 board. Bit 0 is
+ * square a1, bit 7 is h1 and bit 63 is h8.
+ *
+ * The Bitboard namespace provides conversions between the padded
+ * 10x12 square indexes used by Board and bit numbers, and
+ * precomputed attack tables for leapers and sliders. Slider attacks
+ * use PEXT indexing when the library is compiled for BMI2, and
+ * magic multiplication otherwise.
+ *
+ * \note The attack tables are shared by all boards and threads.
+ * They are built once when the library is loaded.
+ */
+namespace Bitboard {
+
+/*! Returns the bitboard of the padded 10x12 \a squareIndex. */
+LIB_EXPORT quint64 squareMask(int squareIndex);
+/*! Converts bit number \a bit into a padded 10x12 square index. */
+LIB_EXPORT int squareIndex(int bit);
+/*! Converts the padded 10x12 \a squareIndex into a bit number. */
+inline int squareBit(int squareIndex);
+
+/*! Returns the squares attacked by a knight on \a bit. */
+LIB_EXPORT quint64 knightAttacks(int bit);
+/*! Returns the squares attacked by a king on \a bit. */
+LIB_EXPORT quint64 kingAttacks(int bit);
+/*!
+ * Returns the squares attacked diagonally from \a bit when the
+ * occupied squares are \a occupied.
+ */
+LIB_EXPORT quint64 bishopAttacks(int bit, quint64 occupied);
+/*!
+ * Returns the squares attacked orthogonally from \a bit when the
+ * occupied squares are \a occupied.
+ */
+LIB_EXPORT quint64 rookAttacks(int bit, quint64 occupied);
+
+/*!
+ * Returns the squares strictly between \a bit1 and \a bit2, or 0 if
+ * they are not on the same rank, file or diagonal.
+ */
+LIB_EXPORT quint64 between(int bit1, int bit2);
+/*!
+ * Returns the full rank, file or diagonal through \a bit1 and
+ * \a bit2, or 0 if they are not aligned.
+ */
+LIB_EXPORT quint64 line(int bit1, int bit2);
+
+/*! Returns the number of the least significant set bit in \a bb. */
+inline int lsb(quint64 bb)
+{
+	Q_ASSERT(bb != 0);
+	return int(qCountTrailingZeroBits(bb));
+}
+
+/*! Clears the least significant set bit of \a bb and returns its number. */
+inline int popLsb(quint64& bb)
+{
+	int bit = lsb(bb);
+	bb &= bb - 1;
+	return bit;
+}
+
+/*! Returns the number of set bits in \a bb. */
+inline int count(quint64 bb)
+{
+	return int(qPopulationCount(bb));
+}
+
+inline int squareBit(int squareIndex)
+{
+	return lsb(squareMask(squareIndex));
+}
+
+} // namespace Bitboard
+} // namespace Chess
+#endif // BITBOARD_H
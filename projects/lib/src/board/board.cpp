@@ -17,8 +17,10 @@
 */
 
 #include "board.h"
+#include <algorithm>
 #include <QStringList>
 #include "zobrist.h"
+#include "boardgeometry.h"
 
 
 namespace Chess {
@@ -61,11 +63,26 @@ Board::Board(Zobrist* zobrist)
 	  m_maxPieceSymbolLength(1),
 	  m_key(0),
 	  m_zobrist(zobrist),
-	  m_sharedZobrist(zobrist)
+	  m_sharedZobrist(zobrist),
+	  m_usedKeyCounts(0),
+	  m_hasBitboards(false),
+	  m_materialKey(0),
+	  m_legalMovesValid(false),
+	  m_legalMovesKey(0),
+	  m_legalMovesPly(0),
+	  m_legalMoveDepth(0),
+	  m_resultValid(false)
 {
 	Q_ASSERT(zobrist != nullptr);
 
 	setPieceType(Piece::NoPiece, QString(), QString());
+
+	m_sideBitboards[Side::White] = 0;
+	m_sideBitboards[Side::Black] = 0;
+	m_reserveTotal[Side::White] = 0;
+	m_reserveTotal[Side::Black] = 0;
+	for (MoveString& entry : m_moveStrings)
+		entry.ply = -1;
 }
 
 Board::~Board()
@@ -127,6 +144,33 @@ void Board::initialize()
 			m_maxPieceSymbolLength = pd.symbol.length();
 
 	m_zobrist->initialize((m_width + 2) * (m_height + 4), m_pieceData.size());
+
+	m_pieceCounts.resize(2 * m_pieceData.size());
+	std::fill(m_pieceCounts.begin(), m_pieceCounts.end(), 0);
+}
+
+void Board::enableBitboards()
+{
+	Q_ASSERT(m_width == 8 && m_height == 8);
+	Q_ASSERT(!variantHasWallSquares());
+
+	m_hasBitboards = true;
+	m_sideBitboards[Side::White] = 0;
+	m_sideBitboards[Side::Black] = 0;
+	m_typeBitboards.resize(m_pieceData.size());
+	for (int i = 0; i < m_typeBitboards.size(); i++)
+		m_typeBitboards[i] = 0;
+}
+
+quint64 Board::movementBitboard(Side side, unsigned movement) const
+{
+	quint64 bb = 0;
+	for (int type = 1; type < m_typeBitboards.size(); type++)
+	{
+		if (m_pieceData[type].movement & movement)
+			bb |= m_typeBitboards[type];
+	}
+	return bb & m_sideBitboards[side];
 }
 
 int Board::maxPieceSymbolLength() const
@@ -217,6 +261,11 @@ int Board::reserveCount(Piece piece) const
 	return m_reserve[piece.side()].at(piece.type());
 }
 
+int Board::reserveTotal(Side side) const
+{
+	return m_reserveTotal[side];
+}
+
 void Board::addToReserve(const Piece& piece, int count)
 {
 	Q_ASSERT(piece.isValid());
@@ -230,6 +279,7 @@ void Board::addToReserve(const Piece& piece, int count)
 	int& oldCount = m_reserve[side][type];
 	for (int i = 1; i <= count; i++)
 		xorKey(m_zobrist->reservePiece(piece, oldCount++));
+	m_reserveTotal[side] += count;
 }
 
 void Board::removeFromReserve(const Piece& piece)
@@ -239,14 +289,13 @@ void Board::removeFromReserve(const Piece& piece)
 
 	int& count = m_reserve[piece.side()][piece.type()];
 	xorKey(m_zobrist->reservePiece(piece, --count));
+	m_reserveTotal[piece.side()]--;
 }
 
 Square Board::chessSquare(int index) const
 {
-	int arwidth = m_width + 2;
-	int file = (index % arwidth) - 1;
-	int rank = (m_height - 1) - ((index / arwidth) - 2);
-	return Square(file, rank);
+	RuntimeBoardGeometry geometry(m_width, m_height);
+	return Square(geometry.file(index), geometry.rank(index));
 }
 
 int Board::squareIndex(const Square& square) const
@@ -346,9 +395,26 @@ QString Board::lanMoveString(const Move& move)
 
 QString Board::moveString(const Move& move, MoveNotation notation)
 {
+	MoveString& entry = m_moveStrings[notation];
+	const int ply = plyCount();
+	if (entry.ply == ply
+	&&  entry.key == m_key
+	&&  entry.move == move
+	&&  (ply == 0 || entry.lastMove == lastMove()))
+		return entry.str;
+
 	if (notation == StandardAlgebraic)
-		return sanMoveString(move);
-	return lanMoveString(move);
+		entry.str = sanMoveString(move);
+	else
+		entry.str = lanMoveString(move);
+
+	entry.move = move;
+	entry.key = m_key;
+	entry.ply = ply;
+	if (ply > 0)
+		entry.lastMove = lastMove();
+
+	return entry.str;
 }
 
 Move Board::moveFromLanString(const QString& istr)
@@ -445,7 +511,10 @@ QStringList Board::pieceList(Side side) const
 
 QString Board::fenString(FenNotation notation) const
 {
+	// The string is built in place, without temporary strings
+	// for the counts of empty squares or the side to move
 	QString fen;
+	fen.reserve(m_width * m_height + 32);
 
 	// Squares
 	int i = (m_width + 2) * 2;
@@ -454,7 +523,7 @@ QString Board::fenString(FenNotation notation) const
 		int nempty = 0;
 		i++;
 		if (y > 0)
-			fen += '/';
+			fen += QLatin1Char('/');
 		for (int x = 0; x < m_width; x++)
 		{
 			Piece pc = m_squares[i];
@@ -467,14 +536,16 @@ QString Board::fenString(FenNotation notation) const
 			if (nempty > 0
 			&&  (!pc.isEmpty() || x == m_width - 1))
 			{
-				fen += QString::number(nempty);
+				if (nempty >= 10)
+					fen += QLatin1Char(char('0' + nempty / 10));
+				fen += QLatin1Char(char('0' + nempty % 10));
 				nempty = 0;
 			}
 
 			if (pc.isValid())
 				fen += pieceSymbol(pc);
 			else if (pc.isWall())
-				fen += "*";
+				fen += QLatin1Char('*');
 
 			i++;
 		}
@@ -484,7 +555,8 @@ QString Board::fenString(FenNotation notation) const
 	// Hand pieces
 	if (variantHasDrops())
 	{
-		QString str;
+		fen += QLatin1Char('[');
+		const int start = fen.size();
 		for (i = Side::White; i <= Side::Black; i++)
 		{
 			Side side = Side::Type(i);
@@ -492,28 +564,35 @@ QString Board::fenString(FenNotation notation) const
 			{
 				int count = m_reserve[i].at(j);
 				for (int k = 0; k < count; k++)
-					str += pieceSymbol(Piece(side, j));
+					fen += pieceSymbol(Piece(side, j));
 			}
 		}
-		if (str.isEmpty())
-			str = "-";
-		fen += QString("[%1]").arg(str);
+		if (fen.size() == start)
+			fen += QLatin1Char('-');
+		fen += QLatin1Char(']');
 	}
 
 	// Side to move
-	fen += QString(" %1 ").arg(m_side.symbol());
+	fen += QLatin1Char(' ');
+	if (m_side == Side::White)
+		fen += QLatin1Char('w');
+	else if (m_side == Side::Black)
+		fen += QLatin1Char('b');
+	fen += QLatin1Char(' ');
 
-	return fen + vFenString(notation);
+	fen += vFenString(notation);
+	return fen;
 }
 
 bool Board::setFenString(const QString& fen)
 {
-	QStringList strList = fen.split(' ');
-	if (strList.isEmpty())
+	// The tokens refer to the FEN string instead of being copies
+	const QVector<QStringRef> tokens(fen.splitRef(QLatin1Char(' ')));
+	if (tokens.isEmpty())
 		return false;
 
-	QStringList::iterator token = strList.begin();
-	if (token->length() < m_height * 2)
+	const QStringRef& token = tokens.first();
+	if (token.length() < m_height * 2)
 		return false;
 
 	initialize();
@@ -526,14 +605,24 @@ bool Board::setFenString(const QString& fen)
 	for (int i = 0; i < m_squares.size(); i++)
 		m_squares[i] = Piece::WallPiece;
 	m_key = 0;
+	std::fill(m_pieceCounts.begin(), m_pieceCounts.end(), 0);
+	m_materialKey = 0;
+	if (m_hasBitboards)
+	{
+		m_sideBitboards[Side::White] = 0;
+		m_sideBitboards[Side::Black] = 0;
+		for (int i = 0; i < m_typeBitboards.size(); i++)
+			m_typeBitboards[i] = 0;
+	}
 
 	// Get the board contents (squares)
 	int handPieceIndex = -1;
 	int maxsymlen = maxPieceSymbolLength();
 	QString pieceStr;
-	for (int i = 0; i < token->length(); i++)
+	pieceStr.reserve(maxsymlen);
+	for (int i = 0; i < token.length(); i++)
 	{
-		QChar c = token->at(i);
+		QChar c = token.at(i);
 
 		// Move to the next rank
 		if (c == '/')
@@ -574,9 +663,10 @@ bool Board::setFenString(const QString& fen)
 
 			int j;
 			int nempty;
-			if (i < (token->length() - 1) && token->at(i + 1).isDigit())
+			if (i < (token.length() - 1) && token.at(i + 1).isDigit())
 			{
-				nempty = token->midRef(i, 2).toInt();
+				nempty = c.digitValue() * 10
+					 + token.at(i + 1).digitValue();
 				i++;
 			}
 			else
@@ -596,15 +686,15 @@ bool Board::setFenString(const QString& fen)
 			return false;
 
 		// read ahead for multi-character symbols
-		for (int l = qMin(maxsymlen, token->length() - i); l > 0; l--)
+		for (int l = qMin(maxsymlen, token.length() - i); l > 0; l--)
 		{
-			pieceStr = token->mid(i, l);
+			pieceStr.setUnicode(token.unicode() + i, l);
 			Piece piece = pieceFromSymbol(pieceStr);
 			if (piece.isValid())
 			{
 				setSquare(k++, piece);
 				i += l - 1;
-				pieceStr.clear();
+				pieceStr.resize(0);
 				square++;
 				break;
 			}
@@ -622,11 +712,13 @@ bool Board::setFenString(const QString& fen)
 	// Hand pieces
 	m_reserve[Side::White].clear();
 	m_reserve[Side::Black].clear();
+	m_reserveTotal[Side::White] = 0;
+	m_reserveTotal[Side::Black] = 0;
 	if (handPieceIndex != -1)
 	{
-		for (int i = handPieceIndex; i < token->length(); i++)
+		for (int i = handPieceIndex; i < token.length(); i++)
 		{
-			QChar c = token->at(i);
+			QChar c = token.at(i);
 			if (c == ']')
 				break;
 			if (c == '-' && i == handPieceIndex)
@@ -639,9 +731,9 @@ bool Board::setFenString(const QString& fen)
 				if (count <= 0)
 					return false;
 				++i;
-				if (i >= token->length() - 1)
+				if (i >= token.length() - 1)
 					return false;
-				c = token->at(i);
+				c = token.at(i);
 			}
 			Piece tmp = pieceFromSymbol(c);
 			if (!tmp.isValid())
@@ -651,20 +743,25 @@ bool Board::setFenString(const QString& fen)
 	}
 
 	// Side to move
-	if (++token == strList.end())
+	if (tokens.size() < 2)
 		return false;
-	m_side = Side(*token);
+	m_side = Side(tokens.at(1).toString());
 	m_startingSide = m_side;
 	if (m_side.isNull())
 		return false;
 
 	m_moveHistory.clear();
+	clearKeyCounts();
+	m_legalMovesValid = false;
+	for (MoveString& entry : m_moveStrings)
+		entry.ply = -1;
+	m_resultValid = false;
 	m_startingFen = fen;
 
 	// Let subclasses handle the rest of the FEN string
-	if (token != strList.end())
-		++token;
-	strList.erase(strList.begin(), token);
+	QStringList strList;
+	for (int i = 2; i < tokens.size(); i++)
+		strList.append(tokens.at(i).toString());
 	if (!vSetFenString(strList))
 		return false;
 
@@ -689,10 +786,17 @@ void Board::makeMove(const Move& move, BoardTransition* transition)
 
 	MoveData md = { move, m_key };
 
+	m_resultValid = false;
 	vMakeMove(move, transition);
 
 	xorKey(m_zobrist->side());
 	m_side = m_side.opposite();
+
+	// Keep at most half of the key count table in use
+	if (2 * (m_usedKeyCounts + 1) > m_keyCounts.size())
+		rebuildKeyCounts(4 * (m_moveHistory.size() + 1));
+	addKeyCount(md.key);
+
 	m_moveHistory << md;
 }
 
@@ -701,11 +805,59 @@ void Board::undoMove()
 	Q_ASSERT(!m_moveHistory.isEmpty());
 	Q_ASSERT(!m_side.isNull());
 
+	m_resultValid = false;
 	m_side = m_side.opposite();
 	vUndoMove(m_moveHistory.last().move);
 
 	m_key = m_moveHistory.last().key;
 	m_moveHistory.pop_back();
+
+	KeyCount& entry = keyCount(m_key);
+	Q_ASSERT(entry.used && entry.count > 0);
+	entry.count--;
+}
+
+Board::KeyCount& Board::keyCount(quint64 key)
+{
+	// Linear probing in a table whose size is a power of two
+	const int mask = m_keyCounts.size() - 1;
+	int i = int(key & quint64(mask));
+	while (m_keyCounts[i].used && m_keyCounts[i].key != key)
+		i = (i + 1) & mask;
+	return m_keyCounts[i];
+}
+
+void Board::rebuildKeyCounts(int size)
+{
+	int capacity = 64;
+	while (capacity < size)
+		capacity *= 2;
+
+	const KeyCount empty = { 0, 0, false };
+	m_keyCounts.resize(capacity);
+	std::fill(m_keyCounts.begin(), m_keyCounts.end(), empty);
+	m_usedKeyCounts = 0;
+
+	for (const MoveData& md : qAsConst(m_moveHistory))
+		addKeyCount(md.key);
+}
+
+void Board::addKeyCount(quint64 key)
+{
+	KeyCount& entry = keyCount(key);
+	if (!entry.used)
+	{
+		entry.used = true;
+		entry.key = key;
+		m_usedKeyCounts++;
+	}
+	entry.count++;
+}
+
+void Board::clearKeyCounts()
+{
+	m_keyCounts.clear();
+	m_usedKeyCounts = 0;
 }
 
 void Board::generateMoves(QVarLengthArray<Move>& moves, int pieceType) const
@@ -748,22 +900,47 @@ void Board::generateDropMoves(QVarLengthArray<Move>& moves, int pieceType) const
 		generateMovesForPiece(moves, pieceType, 0);
 }
 
-void Board::generateHoppingMoves(int sourceSquare,
-				 const QVarLengthArray<int>& offsets,
-				 QVarLengthArray<Move>& moves) const
+template<typename Geometry>
+static void hoppingMoves(const Geometry& geometry,
+			 const QVarLengthArray<Piece>& squares,
+			 Side opSide,
+			 int sourceSquare,
+			 const QVarLengthArray<int>& offsets,
+			 QVarLengthArray<Move>& moves)
 {
-	Side opSide = sideToMove().opposite();
 	for (int i = 0; i < offsets.size(); i++)
 	{
 		int targetSquare = sourceSquare + offsets[i];
-		if (!isValidSquare(chessSquare(targetSquare)))
+		if (!geometry.isValidIndex(targetSquare))
 			continue;
-		Piece capture = pieceAt(targetSquare);
+		Piece capture = squares[targetSquare];
 		if (capture.isEmpty() || capture.side() == opSide)
 			moves.append(Move(sourceSquare, targetSquare));
 	}
 }
 
+void Board::generateHoppingMoves(int sourceSquare,
+				 const QVarLengthArray<int>& offsets,
+				 QVarLengthArray<Move>& moves) const
+{
+	Side opSide = sideToMove().opposite();
+
+	// The common board sizes get a version of the loop where the
+	// square index arithmetic is done with compile-time constants
+	if (m_width == 8 && m_height == 8)
+		hoppingMoves(StandardGeometry(), m_squares, opSide,
+			     sourceSquare, offsets, moves);
+	else if (m_width == 10 && m_height == 8)
+		hoppingMoves(CapablancaGeometry(), m_squares, opSide,
+			     sourceSquare, offsets, moves);
+	else if (m_width == 10 && m_height == 10)
+		hoppingMoves(GrandGeometry(), m_squares, opSide,
+			     sourceSquare, offsets, moves);
+	else
+		hoppingMoves(RuntimeBoardGeometry(m_width, m_height), m_squares,
+			     opSide, sourceSquare, offsets, moves);
+}
+
 void Board::generateSlidingMoves(int sourceSquare,
 				 const QVarLengthArray<int>& offsets,
 				 QVarLengthArray<Move>& moves) const
@@ -833,7 +1010,19 @@ bool Board::vIsLegalMove(const Move& move)
 
 bool Board::isLegalMove(const Move& move)
 {
-	return !move.isNull() && moveExists(move) && vIsLegalMove(move);
+	if (move.isNull())
+		return false;
+	// Called from the legality check of another move
+	if (m_legalMoveDepth > 0)
+		return moveExists(move) && vIsLegalMove(move);
+
+	const MoveList& moves = cachedLegalMoves();
+	for (int i = 0; i < moves.size(); i++)
+	{
+		if (moves[i] == move)
+			return true;
+	}
+	return false;
 }
 
 int Board::repeatCount() const
@@ -841,14 +1030,15 @@ int Board::repeatCount() const
 	if (plyCount() < 4)
 		return 0;
 
-	int repeatCount = 0;
-	for (int i = plyCount() - 1; i >= 0; i--)
+	const int mask = m_keyCounts.size() - 1;
+	for (int i = int(m_key & quint64(mask)); m_keyCounts[i].used;
+	     i = (i + 1) & mask)
 	{
-		if (m_moveHistory.at(i).key == m_key)
-			repeatCount++;
+		if (m_keyCounts[i].key == m_key)
+			return m_keyCounts[i].count;
 	}
 
-	return repeatCount;
+	return 0;
 }
 
 int Board::reversibleMoveCount() const
@@ -869,33 +1059,99 @@ bool Board::isRepetition(const Chess::Move& move)
 
 bool Board::canMove()
 {
-	QVarLengthArray<Move> moves;
-	generateMoves(moves);
-
-	for (int i = 0; i < moves.size(); i++)
+	// Legality checks of the moves being generated may ask whether
+	// the opponent can move (eg. in checkless chess). Those answers
+	// aren't cached, so the search stops at the first legal move.
+	if (m_legalMoveDepth > 0)
 	{
-		if (vIsLegalMove(moves[i]))
-			return true;
+		QVarLengthArray<Move> moves;
+		generateMoves(moves);
+
+		for (int i = 0; i < moves.size(); i++)
+		{
+			if (vIsLegalMove(moves[i]))
+				return true;
+		}
+		return false;
 	}
 
-	return false;
+	return !cachedLegalMoves().isEmpty();
+}
+
+quint64 Board::stateKey() const
+{
+	return 0;
+}
+
+Result Board::result()
+{
+	if (!m_resultValid)
+	{
+		m_result = vResult();
+		m_resultValid = true;
+	}
+	return m_result;
 }
 
 QVector<Move> Board::legalMoves()
 {
-	QVarLengthArray<Move> moves;
+	MoveList moves;
 	QVector<Move> legalMoves;
 
-	generateMoves(moves);
+	this->legalMoves(moves);
 	legalMoves.reserve(moves.size());
 
 	for (int i = moves.size() - 1; i >= 0; i--)
+		legalMoves << moves[i];
+
+	return legalMoves;
+}
+
+void Board::legalMoves(MoveList& moves)
+{
+	if (m_legalMoveDepth > 0)
+		generateLegalMoves(moves);
+	else
+		moves = cachedLegalMoves();
+}
+
+const MoveList& Board::cachedLegalMoves()
+{
+	Q_ASSERT(m_legalMoveDepth == 0);
+
+	const int ply = plyCount();
+	if (m_legalMovesValid
+	&&  m_legalMovesKey == m_key
+	&&  m_legalMovesPly == ply
+	&&  (ply == 0 || m_legalMovesLastMove == lastMove()))
+		return m_legalMoves;
+
+	m_legalMovesValid = false;
+	generateLegalMoves(m_legalMoves);
+
+	m_legalMovesValid = true;
+	m_legalMovesKey = m_key;
+	m_legalMovesPly = ply;
+	if (ply > 0)
+		m_legalMovesLastMove = lastMove();
+
+	return m_legalMoves;
+}
+
+void Board::generateLegalMoves(MoveList& moves)
+{
+	m_legalMoveDepth++;
+	generateMoves(moves);
+
+	// Compact the legal moves to the front of the list
+	int count = 0;
+	for (int i = 0; i < moves.size(); i++)
 	{
 		if (vIsLegalMove(moves[i]))
-			legalMoves << moves[i];
+			moves[count++] = moves[i];
 	}
-
-	return legalMoves;
+	moves.resize(count);
+	m_legalMoveDepth--;
 }
 
 Result Board::tablebaseResult(unsigned int* dtm) const
@@ -31,6 +31,7 @@
 #include "genericmove.h"
 #include "zobrist.h"
 #include "result.h"
+#include "bitboard.h"
 class QStringList;
 
 
@@ -38,6 +39,15 @@ namespace Chess {
 
 class BoardTransition;
 
+/*!
+ * A list of moves.
+ *
+ * The list has room for the moves of a typical position without
+ * heap allocations, so callers that reuse a MoveList (eg. with
+ * Board::legalMoves(MoveList&)) don't allocate memory per position.
+ */
+typedef QVarLengthArray<Move, 256> MoveList;
+
 /*!
  * \brief An internal chessboard class.
  *
@@ -111,7 +121,13 @@ class LIB_EXPORT Board
 		Board(Zobrist* zobrist);
 		/*! Destructs the Board object. */
 		virtual ~Board();
-		/*! Creates and returns a deep copy of this board. */
+		/*!
+		 * Creates and returns a deep copy of this board.
+		 *
+		 * The position and move history are copied, but the piece
+		 * definitions and zobrist keys are implicitly shared with
+		 * this board, so copying a board is cheap.
+		 */
 		virtual Board* copy() const = 0;
 
 		/*! Returns the name of the chess variant. */
@@ -150,6 +166,14 @@ class LIB_EXPORT Board
 		virtual QString defaultFenString() const = 0;
 		/*! Returns the zobrist key for the current position. */
 		quint64 key() const;
+		/*!
+		 * Returns a hash of the variant state that isn't included
+		 * in key(), eg. the checks left in N-check chess. Positions
+		 * with equal key() and stateKey() have the same legal moves.
+		 *
+		 * The default implementation returns 0.
+		 */
+		virtual quint64 stateKey() const;
 		/*!
 		 * Initializes the board.
 		 * This function must be called before a game can be started
@@ -202,6 +226,25 @@ class LIB_EXPORT Board
 		Piece pieceAt(const Square& square) const;
 		/*! Returns the number of halfmoves (plies) played. */
 		int plyCount() const;
+		/*!
+		 * Returns the number of pieces of type \a pieceType that
+		 * belong to \a side on the board.
+		 *
+		 * Side::NoSide counts the pieces of both sides, and
+		 * Piece::NoPiece counts the pieces of every type. Pieces in
+		 * reserve are not counted. The counts are kept up to date
+		 * by setSquare(), so this is a constant-time operation.
+		 */
+		int pieceCount(Side side = Side::NoSide,
+			       int pieceType = Piece::NoPiece) const;
+		/*!
+		 * Returns a hash key of the material on the board, ie. the
+		 * number of pieces of each type and side.
+		 *
+		 * Positions with the same material have the same key, also
+		 * on different boards of the same variant.
+		 */
+		quint64 materialKey() const;
 		/*!
 		 * Returns the number of times the current position was
 		 * reached previously in the game.
@@ -220,6 +263,13 @@ class LIB_EXPORT Board
 		 * always returns 0.
 		 */
 		int reserveCount(Piece piece) const;
+		/*!
+		 * Returns the total number of reserve pieces of \a side.
+		 *
+		 * On variants that don't have piece drops this function
+		 * always returns 0.
+		 */
+		int reserveTotal(Side side) const;
 		/*! Converts \a piece into a piece symbol. */
 		QString pieceSymbol(Piece piece) const;
 		/*! Converts \a pieceSymbol into a Piece object. */
@@ -244,6 +294,11 @@ class LIB_EXPORT Board
 		/*!
 		 * Converts a Move into a string.
 		 *
+		 * The last string of each notation is cached for the current
+		 * position. The players of a game and its PGN share the
+		 * game's board, so each ply is formatted only once in each
+		 * notation.
+		 *
 		 * \note The board must be in a position where \a move can be made.
 		 * \sa moveFromString()
 		 */
@@ -272,7 +327,13 @@ class LIB_EXPORT Board
 		 */
 		GenericMove genericMove(const Move& move) const;
 
-		/*! Returns true if \a move is legal in the current position. */
+		/*!
+		 * Returns true if \a move is legal in the current position.
+		 *
+		 * \note The legal moves of the position are generated once
+		 * and reused by this function, legalMoves() and canMove()
+		 * until the position changes.
+		 */
 		bool isLegalMove(const Move& move);
 		/*!
 		 * Returns true if \a move repeats a position that was
@@ -281,11 +342,23 @@ class LIB_EXPORT Board
 		bool isRepetition(const Move& move);
 		/*! Returns a vector of legal moves in the current position. */
 		QVector<Move> legalMoves();
+		/*!
+		 * Fills \a moves with the legal moves in the current position.
+		 *
+		 * Unlike the QVector version this doesn't allocate memory
+		 * if \a moves already has enough capacity.
+		 */
+		void legalMoves(MoveList& moves);
 		/*!
 		 * Returns the result of the game, or Result::NoResult if
 		 * the game is in progress.
+		 *
+		 * The result is cached until the next move is made or
+		 * undone, so it can be asked many times per ply.
+		 *
+		 * \sa vResult()
 		 */
-		virtual Result result() = 0;
+		Result result();
 		/*!
 		 * Returns the expected game result according to endgame tablebases.
 		 *
@@ -351,6 +424,14 @@ class LIB_EXPORT Board
 		 * subclasses to update the zobrist position key.
 		 */
 		virtual void vUndoMove(const Move& move) = 0;
+		/*!
+		 * Returns the result of the game in the current position.
+		 *
+		 * This function is called by result() when the position
+		 * has changed. Because most positions don't end the game,
+		 * the no-result path shouldn't allocate memory.
+		 */
+		virtual Result vResult() = 0;
 
 		/*! Converts a square index into a Square object. */
 		Square chessSquare(int index) const;
@@ -511,7 +592,40 @@ class LIB_EXPORT Board
 		/*! Removes a piece of type \a piece from the reserve. */
 		void removeFromReserve(const Piece& piece);
 
+		/*!
+		 * Enables a 64-bit bitboard representation of the position.
+		 *
+		 * The bitboards are kept in sync with the square array by
+		 * setSquare(). Only boards with 8x8 squares and no wall
+		 * squares can use bitboards. This function should be called
+		 * by vInitialize().
+		 *
+		 * \sa Bitboard
+		 */
+		void enableBitboards();
+		/*! Returns true if bitboards are enabled. */
+		bool hasBitboards() const;
+		/*! Returns a bitboard of the squares occupied by \a side. */
+		quint64 sideBitboard(Side side) const;
+		/*!
+		 * Returns a bitboard of the squares occupied by pieces of
+		 * type \a pieceType of either side.
+		 */
+		quint64 pieceTypeBitboard(int pieceType) const;
+		/*!
+		 * Returns a bitboard of the squares occupied by pieces of
+		 * \a side that can move like \a movement.
+		 */
+		quint64 movementBitboard(Side side, unsigned movement) const;
+
 	private:
+		KeyCount& keyCount(quint64 key);
+		void addKeyCount(quint64 key);
+		void rebuildKeyCounts(int size);
+		void clearKeyCounts();
+		static quint64 materialKey(const Piece& piece);
+		const MoveList& cachedLegalMoves();
+		void generateLegalMoves(MoveList& moves);
 		struct PieceData
 		{
 			QString name;
@@ -524,6 +638,22 @@ class LIB_EXPORT Board
 			Move move;
 			quint64 key;
 		};
+		// An entry of the position key counts
+		struct KeyCount
+		{
+			quint64 key;
+			int count;
+			bool used;
+		};
+		// A move string cached by moveString()
+		struct MoveString
+		{
+			Move move;
+			quint64 key;
+			int ply;
+			Move lastMove;
+			QString str;
+		};
 		friend LIB_EXPORT QDebug operator<<(QDebug dbg, const Board* board);
 
 		bool m_initialized;
@@ -536,10 +666,45 @@ class LIB_EXPORT Board
 		quint64 m_key;
 		Zobrist* m_zobrist;
 		QSharedPointer<Zobrist> m_sharedZobrist;
-		QVarLengthArray<PieceData> m_pieceData;
+		// Piece definitions don't change after initialization, so
+		// they are implicitly shared between copies of the board.
+		QVector<PieceData> m_pieceData;
 		QVarLengthArray<Piece> m_squares;
-		QVector<MoveData> m_moveHistory;
+		// The history of the first 256 plies is stored inline,
+		// so making and undoing moves doesn't allocate memory.
+		QVarLengthArray<MoveData, 256> m_moveHistory;
+		// How many times each key of m_moveHistory occurs, in an
+		// open-addressing table, so that repeatCount() doesn't
+		// have to scan the history. Entries whose count drops to
+		// zero are kept until the table is rebuilt.
+		QVarLengthArray<KeyCount, 64> m_keyCounts;
+		int m_usedKeyCounts;
 		QVector<int> m_reserve[2];
+		int m_reserveTotal[2];
+		bool m_hasBitboards;
+		quint64 m_sideBitboards[2];
+		QVarLengthArray<quint64, 16> m_typeBitboards;
+		// The piece counts of each type and side, indexed by
+		// type * 2 + side. Type 0 (NoPiece) holds the totals.
+		QVarLengthArray<int, 32> m_pieceCounts;
+		quint64 m_materialKey;
+		// The legal moves of the last position whose moves were
+		// generated. The position is identified by its key, ply
+		// and last move, so the list survives a move being made
+		// and undone, eg. by sanMoveString().
+		MoveList m_legalMoves;
+		bool m_legalMovesValid;
+		quint64 m_legalMovesKey;
+		int m_legalMovesPly;
+		Move m_legalMovesLastMove;
+		// Nesting depth of generateLegalMoves()
+		int m_legalMoveDepth;
+		// The last move string of each MoveNotation, for the
+		// position identified like m_legalMoves
+		MoveString m_moveStrings[2];
+		// The result of the current position, see result()
+		Result m_result;
+		bool m_resultValid;
 };
 
 
@@ -584,18 +749,84 @@ inline void Board::setSquare(int square, Piece piece)
 {
 	Piece& old = m_squares[square];
 	if (old.isValid())
+	{
 		xorKey(m_zobrist->piece(old, square));
+		m_pieceCounts[old.type() * 2 + old.side()]--;
+		m_pieceCounts[old.side()]--;
+		m_materialKey -= materialKey(old);
+	}
 	if (piece.isValid())
+	{
 		xorKey(m_zobrist->piece(piece, square));
+		m_pieceCounts[piece.type() * 2 + piece.side()]++;
+		m_pieceCounts[piece.side()]++;
+		m_materialKey += materialKey(piece);
+	}
+
+	if (m_hasBitboards)
+	{
+		const quint64 mask = Bitboard::squareMask(square);
+		if (old.isValid())
+		{
+			m_sideBitboards[old.side()] ^= mask;
+			m_typeBitboards[old.type()] ^= mask;
+		}
+		if (piece.isValid())
+		{
+			m_sideBitboards[piece.side()] ^= mask;
+			m_typeBitboards[piece.type()] ^= mask;
+		}
+	}
 
 	old = piece;
 }
 
+inline bool Board::hasBitboards() const
+{
+	return m_hasBitboards;
+}
+
+inline quint64 Board::sideBitboard(Side side) const
+{
+	return m_sideBitboards[side];
+}
+
+inline quint64 Board::pieceTypeBitboard(int pieceType) const
+{
+	return m_typeBitboards[pieceType];
+}
+
 inline int Board::plyCount() const
 {
 	return m_moveHistory.size();
 }
 
+inline int Board::pieceCount(Side side, int pieceType) const
+{
+	Q_ASSERT(pieceType >= 0 && pieceType * 2 < m_pieceCounts.size());
+
+	if (side.isNull())
+		return m_pieceCounts[pieceType * 2 + Side::White]
+		     + m_pieceCounts[pieceType * 2 + Side::Black];
+	return m_pieceCounts[pieceType * 2 + side];
+}
+
+inline quint64 Board::materialKey() const
+{
+	return m_materialKey;
+}
+
+inline quint64 Board::materialKey(const Piece& piece)
+{
+	// A fixed pseudo-random key for each type and side (SplitMix64),
+	// so that the material key is a sum of the pieces' keys
+	quint64 x = quint64(piece.type() * 2 + piece.side() + 1)
+		    * Q_UINT64_C(0x9e3779b97f4a7c15);
+	x = (x ^ (x >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+	x = (x ^ (x >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+	return x ^ (x >> 31);
+}
+
 inline const Move& Board::lastMove() const
 {
 	return m_moveHistory.last().move;
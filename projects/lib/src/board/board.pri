@@ -61,8 +61,10 @@ SOURCES += $$PWD/board.cpp \
     $$PWD/gustavboard.cpp \
     $$PWD/boardfactory.cpp \
     $$PWD/boardtransition.cpp \
-    $$PWD/syzygytablebase.cpp
+    $$PWD/syzygytablebase.cpp \
+    $$PWD/bitboard.cpp
 HEADERS += $$PWD/board.h \
+    $$PWD/boardgeometry.h \
     $$PWD/move.h \
     $$PWD/piece.h \
     $$PWD/westernboard.h \
@@ -126,4 +128,5 @@ HEADERS += $$PWD/board.h \
     $$PWD/gustavboard.h \
     $$PWD/boardfactory.h \
     $$PWD/boardtransition.h \
-    $$PWD/syzygytablebase.h
+    $$PWD/syzygytablebase.h \
+    $$PWD/bitboard.h
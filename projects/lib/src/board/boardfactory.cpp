@@ -17,6 +17,8 @@
 */
 
 #include "boardfactory.h"
+#include <QHash>
+#include <QVector>
 #include "aiwokboard.h"
 #include "almostboard.h"
 #include "amazonboard.h"
@@ -71,6 +73,52 @@
 
 namespace Chess {
 
+namespace {
+
+struct VariantTable
+{
+	QStringList names;
+	QVector<BoardFactory::VariantInfo> infos;
+	QHash<QString, int> ids;
+};
+
+// Boards are registered during static initialization, so the table
+// can be built the first time it's needed
+const VariantTable& variantTable()
+{
+	static const VariantTable table = []()
+	{
+		VariantTable t;
+		t.names = BoardFactory::registry()->items().keys();
+		t.infos.reserve(t.names.size());
+
+		for (const QString& name : qAsConst(t.names))
+		{
+			Board* board = BoardFactory::create(name);
+			Q_ASSERT(board != nullptr);
+
+			BoardFactory::VariantInfo info;
+			info.id = t.infos.size();
+			info.name = name;
+			info.width = board->width();
+			info.height = board->height();
+			info.isRandom = board->isRandomVariant();
+			info.hasDrops = board->variantHasDrops();
+			info.hasWallSquares = board->variantHasWallSquares();
+			info.reservePieceTypes = board->reservePieceTypes();
+			delete board;
+
+			t.ids.insert(name, info.id);
+			t.infos.append(info);
+		}
+		return t;
+	}();
+
+	return table;
+}
+
+} // anonymous namespace
+
 REGISTER_BOARD(ThreeCheckBoard, "3check")
 REGISTER_BOARD(FiveCheckBoard, "5check")
 REGISTER_BOARD(AiWokBoard, "ai-wok")
@@ -151,7 +199,26 @@ Board* BoardFactory::create(const QString& variant)
 
 QStringList BoardFactory::variants()
 {
-	return registry()->items().keys();
+	return variantTable().names;
+}
+
+bool BoardFactory::isVariant(const QString& variant)
+{
+	return variantTable().ids.contains(variant);
+}
+
+int BoardFactory::variantId(const QString& variant)
+{
+	return variantTable().ids.value(variant, -1);
+}
+
+const BoardFactory::VariantInfo* BoardFactory::variantInfo(const QString& variant)
+{
+	const VariantTable& table = variantTable();
+	int id = table.ids.value(variant, -1);
+	if (id == -1)
+		return nullptr;
+	return &table.infos.at(id);
 }
 
 } // namespace Chess
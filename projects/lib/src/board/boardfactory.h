@@ -20,6 +20,7 @@
 #define BOARDFACTORY_H
 
 #include <QStringList>
+#include <QList>
 #include <classregistry.h>
 #include "board.h"
 
@@ -30,6 +31,32 @@ namespace Chess {
 class LIB_EXPORT BoardFactory
 {
 	public:
+		/*!
+		 * \brief The fixed properties of a chess variant.
+		 *
+		 * The properties are read once from a board of the variant,
+		 * so they can be queried without creating a Board object.
+		 */
+		struct VariantInfo
+		{
+			/*! A unique ID of the variant, valid for this process. */
+			int id;
+			/*! The name of the variant. */
+			QString name;
+			/*! The width of the board. */
+			int width;
+			/*! The height of the board. */
+			int height;
+			/*! Does the variant use random starting positions? */
+			bool isRandom;
+			/*! Does the variant allow piece drops? */
+			bool hasDrops;
+			/*! Does the variant have wall squares? */
+			bool hasWallSquares;
+			/*! The types of pieces that can be in reserve. */
+			QList<Piece> reservePieceTypes;
+		};
+
 		/*! Returns the class registry for concrete Board subclasses. */
 		static ClassRegistry<Board>* registry();
 		/*!
@@ -39,6 +66,20 @@ class LIB_EXPORT BoardFactory
 		static Board* create(const QString& variant);
 		/*! Returns a list of supported chess variants. */
 		static QStringList variants();
+		/*! Returns true if \a variant is a supported chess variant. */
+		static bool isVariant(const QString& variant);
+		/*!
+		 * Returns the ID of \a variant, or -1 if \a variant is not
+		 * supported.
+		 *
+		 * Comparing IDs is cheaper than comparing variant names.
+		 */
+		static int variantId(const QString& variant);
+		/*!
+		 * Returns the properties of \a variant, or 0 if \a variant
+		 * is not supported.
+		 */
+		static const VariantInfo* variantInfo(const QString& variant);
 
 	private:
 		BoardFactory();
@@ -0,0 +1,121 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOARDGEOMETRY_H
+#define BOARDGEOMETRY_H
+
+namespace Chess {
+
+/*!
+ * \brief Compile-time geometry of a padded board array
+ *
+ * Board stores its squares in a (width + 2) x (height + 4) array,
+ * with one column of wall squares on both sides and two rows of
+ * wall squares above and below the board. BoardGeometry describes
+ * that layout for a board of \a W files and \a H ranks, so that
+ * square index conversions compile to constant arithmetic.
+ *
+ * \sa RuntimeBoardGeometry
+ */
+template<int W, int H>
+struct BoardGeometry
+{
+	/*! The number of files. */
+	static constexpr int Width = W;
+	/*! The number of ranks. */
+	static constexpr int Height = H;
+	/*! The width of the padded array. */
+	static constexpr int ArrayWidth = W + 2;
+	/*! The size of the padded array. */
+	static constexpr int ArraySize = (W + 2) * (H + 4);
+
+	/*! Returns the zero-based file of array index \a index. */
+	static constexpr int file(int index)
+	{
+		return index % ArrayWidth - 1;
+	}
+	/*! Returns the zero-based rank of array index \a index. */
+	static constexpr int rank(int index)
+	{
+		return H - 1 - (index / ArrayWidth - 2);
+	}
+	/*! Returns the array index of \a file and \a rank. */
+	static constexpr int squareIndex(int file, int rank)
+	{
+		return (H - 1 - rank + 2) * ArrayWidth + 1 + file;
+	}
+	/*! Returns true if \a index is a square on the board. */
+	static constexpr bool isValidIndex(int index)
+	{
+		return index >= 0 && index < ArraySize
+		    && file(index) >= 0 && file(index) < W
+		    && rank(index) >= 0 && rank(index) < H;
+	}
+};
+
+/*!
+ * \brief Geometry of a padded board array whose size is only known
+ * at runtime
+ *
+ * RuntimeBoardGeometry has the same interface as BoardGeometry, so
+ * code templated on the geometry works for boards of any size.
+ */
+struct RuntimeBoardGeometry
+{
+	/*! Creates the geometry of a \a width x \a height board. */
+	RuntimeBoardGeometry(int width, int height)
+		: Width(width),
+		  Height(height),
+		  ArrayWidth(width + 2),
+		  ArraySize((width + 2) * (height + 4))
+	{
+	}
+
+	int file(int index) const
+	{
+		return index % ArrayWidth - 1;
+	}
+	int rank(int index) const
+	{
+		return Height - 1 - (index / ArrayWidth - 2);
+	}
+	int squareIndex(int file, int rank) const
+	{
+		return (Height - 1 - rank + 2) * ArrayWidth + 1 + file;
+	}
+	bool isValidIndex(int index) const
+	{
+		return index >= 0 && index < ArraySize
+		    && file(index) >= 0 && file(index) < Width
+		    && rank(index) >= 0 && rank(index) < Height;
+	}
+
+	const int Width;
+	const int Height;
+	const int ArrayWidth;
+	const int ArraySize;
+};
+
+/*! Geometry of 8x8 boards, eg. standard chess. */
+typedef BoardGeometry<8, 8> StandardGeometry;
+/*! Geometry of 10x8 boards, eg. Capablanca chess. */
+typedef BoardGeometry<10, 8> CapablancaGeometry;
+/*! Geometry of 10x10 boards, eg. Grand chess. */
+typedef BoardGeometry<10, 10> GrandGeometry;
+
+} // namespace Chess
+#endif // BOARDGEOMETRY_H
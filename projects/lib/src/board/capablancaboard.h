@@ -52,6 +52,7 @@ class LIB_EXPORT CapablancaBoard : public WesternBoard
 		};
 
 		// Inherited from WesternBoard
+		virtual bool variantHasStandardAttacks() const;
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
 					   QVarLengthArray<Move>& moves) const;
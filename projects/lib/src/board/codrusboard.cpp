@@ -50,18 +50,6 @@ void CodrusBoard::addPromotions(int sourceSquare,
 	moves.append(Move(sourceSquare, targetSquare, Queen));
 }
 
-int CodrusBoard::pieceCount(Side side, int ptype) const
-{
-	int count = 0;
-	for (int i = 0; i < arraySize(); i++)
-	{
-		if ((ptype == Piece::NoPiece || ptype == pieceAt(i).type())
-	        &&  (side == Side::NoSide || side == pieceAt(i).side()))
-			++count;
-	}
-	return count;
-}
-
 bool CodrusBoard::vIsLegalMove(const Move& move)
 {
 	Side side(sideToMove());
@@ -81,7 +69,7 @@ Result CodrusBoard::vResultOfStalemate() const
 	return Result(Result::Draw, Side::NoSide, str);
 }
 
-Result CodrusBoard::result()
+Result CodrusBoard::vResult()
 {
 	const Side side = sideToMove();
 	if (pieceCount(side, King) == 0)
@@ -89,7 +77,7 @@ Result CodrusBoard::result()
 		QString str = tr("%1 wins").arg(side.toString());
 		return Result(Result::Win, side, str);
 	}
-	return GiveawayBoard::result();
+	return GiveawayBoard::vResult();
 }
 
 } // namespace Chess
@@ -59,10 +59,10 @@ class LIB_EXPORT CodrusBoard : public GiveawayBoard
 		// Inherited from GiveawayBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
-		virtual Result result();
 
 	protected:
 		// Inherited from GiveawayBoard
+		virtual Result vResult();
 		virtual bool kingsCountAssertion(int whiteKings,
 						 int blackKings) const;
 		virtual void addPromotions(int sourceSquare,
@@ -73,10 +73,6 @@ class LIB_EXPORT CodrusBoard : public GiveawayBoard
 		/*! Rules outcome of stalemate */
 		virtual Result vResultOfStalemate() const;
 
-	private:
-		int pieceCount(Side side,
-			       int ptype = Piece::NoPiece) const;
-
 }; // namespace Chess
 }
 #endif // CODRUSBOARD_H
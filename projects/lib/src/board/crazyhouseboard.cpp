@@ -19,6 +19,7 @@
 #include "crazyhouseboard.h"
 #include "westernzobrist.h"
 #include "boardtransition.h"
+#include "bitboard.h"
 
 namespace Chess {
 
@@ -71,6 +72,11 @@ int CrazyhouseBoard::reserveType(int pieceType) const
 	return pieceType;
 }
 
+bool CrazyhouseBoard::variantHasBitboards() const
+{
+	return true;
+}
+
 int CrazyhouseBoard::normalPieceType(int type)
 {
 	switch (type)
@@ -221,8 +227,27 @@ void CrazyhouseBoard::generateMovesForPiece(QVarLengthArray<Move>& moves,
 					    int pieceType,
 					    int square) const
 {
-	// Generate drops
-	if (square == 0)
+	// Generate drops from the bitboard of legal drop squares.
+	// The ranks are visited from the top so that the moves are in
+	// the same order as with the square array.
+	quint64 targets;
+	if (square == 0 && dropTargets(&targets))
+	{
+		for (int rank = 7; rank >= 0; rank--)
+		{
+			if (pieceType == Pawn && !pawnDropOkOnRank(rank))
+				continue;
+
+			quint64 rankTargets = targets & (Q_UINT64_C(0xFF) << (rank * 8));
+			while (rankTargets)
+			{
+				int bit = Bitboard::popLsb(rankTargets);
+				moves.append(Move(0, Bitboard::squareIndex(bit),
+						  pieceType));
+			}
+		}
+	}
+	else if (square == 0)
 	{
 		const int size = arraySize();
 		for (int i = 0; i < size; i++)
@@ -64,6 +64,11 @@ bool ExtinctionBoard::inCheck(Side, int) const
 	return false;
 }
 
+bool ExtinctionBoard::variantHasStandardLegality() const
+{
+	return false;
+}
+
 Piece ExtinctionBoard::extinctPiece(Side side) const
 {
 	for (const int type: m_pieceSet)
@@ -84,7 +89,7 @@ Piece ExtinctionBoard::extinctPiece(Side side) const
 	return Piece();
 }
 
-Result ExtinctionBoard::result()
+Result ExtinctionBoard::vResult()
 {
 	QString str;
 	Side side = sideToMove();
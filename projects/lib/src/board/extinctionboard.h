@@ -58,12 +58,13 @@ class LIB_EXPORT ExtinctionBoard : public StandardBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
 	protected:
 		// Inherited from StandardBoard
+		virtual Result vResult();
 		virtual bool kingsCountAssertion(int whiteKings,
 						 int blackKings) const;
 		virtual bool inCheck(Side side, int square = 0) const;
+		virtual bool variantHasStandardLegality() const;
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
 					   QVarLengthArray<Move>& moves) const;
@@ -18,74 +18,92 @@
 
 #include "genericmove.h"
 
+namespace {
+
+// Packs a coordinate into 6 bits. The value is stored plus one so
+// that -1 becomes 0; coordinates that don't fit are stored as -1.
+quint32 packCoordinate(int value)
+{
+	if (value < -1 || value > 62)
+		return 0;
+	return quint32(value + 1);
+}
+
+quint32 packSquare(const Chess::Square& square)
+{
+	return packCoordinate(square.file())
+	     | (packCoordinate(square.rank()) << 6);
+}
+
+Chess::Square unpackSquare(quint32 bits)
+{
+	return Chess::Square(int(bits & 0x3F) - 1, int((bits >> 6) & 0x3F) - 1);
+}
+
+} // anonymous namespace
+
 namespace Chess {
 
 GenericMove::GenericMove()
-	: m_promotion(0)
+	: m_data(0)
 {
 }
 
 GenericMove::GenericMove(const Square& sourceSquare,
 			 const Square& targetSquare,
 			 int promotion)
-	: m_sourceSquare(sourceSquare),
-	  m_targetSquare(targetSquare),
-	  m_promotion(promotion)
+	: m_data(packSquare(sourceSquare)
+		 | (packSquare(targetSquare) << 12)
+		 | (quint32(promotion) << 24))
 {
+	Q_ASSERT(promotion >= 0 && promotion <= 0xFF);
 }
 
 bool GenericMove::operator==(const GenericMove& other) const
 {
-	if (m_sourceSquare == other.m_sourceSquare
-	&&  m_targetSquare == other.m_targetSquare
-	&&  m_promotion == other.m_promotion)
-		return true;
-	return false;
+	return m_data == other.m_data;
 }
 
 bool GenericMove::operator!=(const GenericMove& other) const
 {
-	if (m_sourceSquare != other.m_sourceSquare
-	||  m_targetSquare != other.m_targetSquare
-	||  m_promotion != other.m_promotion)
-		return true;
-	return false;
+	return m_data != other.m_data;
 }
 
 bool GenericMove::isNull() const
 {
-	bool validSource = (m_sourceSquare.isValid() || m_promotion);
-	return !(validSource && m_targetSquare.isValid());
+	bool validSource = (sourceSquare().isValid() || promotion());
+	return !(validSource && targetSquare().isValid());
 }
 
 Square GenericMove::sourceSquare() const
 {
-	return m_sourceSquare;
+	return unpackSquare(m_data);
 }
 
 Square GenericMove::targetSquare() const
 {
-	return m_targetSquare;
+	return unpackSquare(m_data >> 12);
 }
 
 int GenericMove::promotion() const
 {
-	return m_promotion;
+	return int(m_data >> 24);
 }
 
 void GenericMove::setSourceSquare(const Square& square)
 {
-	m_sourceSquare = square;
+	m_data = (m_data & ~0xFFFu) | packSquare(square);
 }
 
 void GenericMove::setTargetSquare(const Square& square)
 {
-	m_targetSquare = square;
+	m_data = (m_data & ~(0xFFFu << 12)) | (packSquare(square) << 12);
 }
 
 void GenericMove::setPromotion(int pieceType)
 {
-	m_promotion = pieceType;
+	Q_ASSERT(pieceType >= 0 && pieceType <= 0xFF);
+	m_data = (m_data & 0xFFFFFFu) | (quint32(pieceType) << 24);
 }
 
 } // namespace Chess
@@ -30,6 +30,12 @@ namespace Chess {
  * When a move is made by a human or retrieved from an opening book of any
  * kind, it will be in this format. Later it can be converted to Chess::Move
  * by a Chess::Board object.
+ *
+ * The squares and the promotion are packed into one 32-bit word, which
+ * keeps opening book entries, PGN move data and queued signals small
+ * and makes comparing moves a single integer comparison. Files and
+ * ranks outside the range -1 to 62 are stored as -1, and the promotion
+ * must be between 0 and 255.
  */
 class LIB_EXPORT GenericMove
 {
@@ -64,13 +70,14 @@ class LIB_EXPORT GenericMove
 		void setPromotion(int pieceType);
 
 	private:
-		Square m_sourceSquare;
-		Square m_targetSquare;
-		int m_promotion;
+		// Bits 0-11: source square, 12-23: target square,
+		// 24-31: promotion. The null move is 0.
+		quint32 m_data;
 };
 
 } // namespace Chess
 
+Q_DECLARE_TYPEINFO(Chess::GenericMove, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(Chess::GenericMove)
 
 #endif // GENERICMOVE_H
@@ -207,6 +207,13 @@ void SimplifiedGryphonBoard::generateMovesForPiece(QVarLengthArray< Move >& move
 	}
 }
 
+quint64 SimplifiedGryphonBoard::stateKey() const
+{
+	// A side's king can move backward after its first capture
+	return (m_captures[Side::White] > 0 ? 1 : 0)
+	     | (m_captures[Side::Black] > 0 ? 2 : 0);
+}
+
 void SimplifiedGryphonBoard::vMakeMove(const Move& move,
 				       BoardTransition* transition)
 {
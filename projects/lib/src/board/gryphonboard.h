@@ -109,6 +109,7 @@ class LIB_EXPORT SimplifiedGryphonBoard : public GryphonBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
+		virtual quint64 stateKey() const;
 
 	protected:
 		virtual void generateMovesForPiece(QVarLengthArray< Move >& moves,
@@ -74,7 +74,7 @@ bool HordeBoard::kingsCountAssertion(int whiteKings, int blackKings) const
 	return whiteKings + blackKings == 1;
 }
 
-Result HordeBoard::result()
+Result HordeBoard::vResult()
 {
 	Side side = sideToMove();
 	Side opp = side.opposite();
@@ -82,7 +82,7 @@ Result HordeBoard::result()
 		return Result(Result::Win, opp,
 			      tr("%1 wins").arg(opp.toString()));
 
-	return StandardBoard::result();
+	return StandardBoard::vResult();
 }
 
 /*!
@@ -55,8 +55,8 @@ class LIB_EXPORT HordeBoard : public StandardBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
 	protected:
+		virtual Result vResult();
 		virtual bool kingsCountAssertion(int whiteKings,
 						 int blackKings) const;
 		virtual bool vIsLegalMove(const Move& m);
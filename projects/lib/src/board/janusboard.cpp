@@ -47,6 +47,11 @@ QString JanusBoard::defaultFenString() const
 	return "rjnbkqbnjr/pppppppppp/10/10/10/10/PPPPPPPPPP/RJNBKQBNJR w KQkq - 0 1";
 }
 
+bool JanusBoard::variantHasStandardAttacks() const
+{
+	return true;
+}
+
 void JanusBoard::addPromotions(int sourceSquare,
 				int targetSquare,
 				QVarLengthArray<Move>& moves) const
@@ -61,6 +61,7 @@ class LIB_EXPORT JanusBoard : public WesternBoard
 		};
 
 		// Inherited from WesternBoard
+		virtual bool variantHasStandardAttacks() const;
 		virtual void addPromotions(int sourceSquare,
 					   int targetSquare,
 					   QVarLengthArray<Move>& moves) const;
@@ -64,7 +64,7 @@ bool JesonMorBoard::inCheck(Side side, int square) const
 	return WesternBoard::inCheck(side, square);
 }
 
-Result JesonMorBoard::result()
+Result JesonMorBoard::vResult()
 {
 	QString str;
 	Side side = sideToMove();
@@ -45,9 +45,9 @@ class LIB_EXPORT JesonMorBoard : public WesternBoard
 		virtual int width() const;
 		virtual int height() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
 	protected:
 		// Inherited from WesternBoard
+		virtual Result vResult();
 		virtual bool kingsCountAssertion(int whiteKings,
 						 int blackKings) const;
 		virtual bool inCheck(Side side, int square = 0) const;
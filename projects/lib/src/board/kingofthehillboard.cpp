@@ -36,7 +36,7 @@ QString KingOfTheHillBoard::variant() const
 	return "kingofthehill";
 }
 
-Result KingOfTheHillBoard::result()
+Result KingOfTheHillBoard::vResult()
 {
 	if (kingInCenter(Side::White))
 		return Result(Result::Win, Side::White,
@@ -44,7 +44,7 @@ Result KingOfTheHillBoard::result()
 	if (kingInCenter(Side::Black))
 		return Result(Result::Win, Side::Black,
 			      tr("Black wins with king in the center"));
-	return StandardBoard::result();
+	return StandardBoard::vResult();
 }
 
 /*! Returns true if the king of \a side is occupying a central square */
@@ -46,7 +46,11 @@ class LIB_EXPORT KingOfTheHillBoard : public StandardBoard
 		// Inherited from StandardBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
-		virtual Result result();
+
+	protected:
+		// Inherited from StandardBoard
+		virtual Result vResult();
+
 	private:
 		bool kingInCenter(Side side) const;
 		const QList<int> m_centralSquares;
@@ -78,7 +78,7 @@ bool LosersBoard::vIsLegalMove(const Move& move)
 	return WesternBoard::vIsLegalMove(move);
 }
 
-Result LosersBoard::result()
+Result LosersBoard::vResult()
 {
 	Side winner;
 	QString str;
@@ -42,10 +42,10 @@ class LIB_EXPORT LosersBoard : public WesternBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
 
 	protected:
 		// Inherited from WesternBoard
+		virtual Result vResult();
 		virtual bool vSetFenString(const QStringList& fen);
 		virtual bool vIsLegalMove(const Move& move);
 
@@ -422,7 +422,7 @@ Result MakrukBoard::resultFromCounting() const
 	return Result();
 }
 
-Result MakrukBoard::result()
+Result MakrukBoard::vResult()
 {
 	QString str;
 	Side side = sideToMove();
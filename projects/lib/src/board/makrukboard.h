@@ -85,7 +85,6 @@ class LIB_EXPORT MakrukBoard : public ShatranjBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
 
 	protected:
 		/*! Piece types for Makruk */
@@ -159,6 +158,7 @@ class LIB_EXPORT MakrukBoard : public ShatranjBoard
 
 		// Inherited from ShatranjBoard
 		virtual void vInitialize();
+		virtual Result vResult();
 		virtual QString vFenString(FenNotation notation) const;
 		virtual bool vSetFenString(const QStringList& fen);
 		virtual bool inCheck(Side side, int square = 0) const;
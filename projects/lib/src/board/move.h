@@ -131,6 +131,7 @@ inline int Move::promotion() const
 
 } // namespace Chess
 
+Q_DECLARE_TYPEINFO(Chess::Move, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(Chess::Move)
 
 #endif // MOVE_H
@@ -77,7 +77,7 @@ void NCheckBoard::vUndoMove(const Move& move)
 	StandardBoard::vUndoMove(move);
 }
 
-Result NCheckBoard::result()
+Result NCheckBoard::vResult()
 {
 	// Side wins if counter is zero
 	Side opp = sideToMove().opposite();
@@ -86,7 +86,7 @@ Result NCheckBoard::result()
 			      tr("%1 checks %2 times")
 			      .arg(opp.toString()).arg(checkLimit()));
 
-	return StandardBoard::result();
+	return StandardBoard::vResult();
 }
 
 inline int NCheckBoard::checkLimit() const
@@ -117,6 +117,12 @@ int NCheckBoard::checksToWin(Side side) const
  * In contrast SCIDB and Lichess use two plus signs and *forward counters*
  * (like +0+0) appended to the normal FEN.
  */
+quint64 NCheckBoard::stateKey() const
+{
+	return quint64(m_checksToWin[Side::White])
+	     | quint64(m_checksToWin[Side::Black]) << 32;
+}
+
 QString NCheckBoard::vFenIncludeString(Board::FenNotation notation) const
 {
 	Q_UNUSED(notation);
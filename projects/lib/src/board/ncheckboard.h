@@ -51,14 +51,16 @@ class LIB_EXPORT NCheckBoard : public StandardBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
 
 		/*! Returns number of checks yet needed for \a side to win */
 		int checksToWin(Side side) const;
+		// Inherited from StandardBoard
+		virtual quint64 stateKey() const;
 
 	protected:
 		// Inherited from StandardBoard
 		virtual void vInitialize();
+		virtual Result vResult();
 		virtual QString vFenIncludeString(FenNotation notation) const;
 		virtual bool vSetFenString(const QStringList& fen);
 		virtual void vMakeMove(const Move& move,
@@ -85,6 +85,21 @@ QString OukBoard::vFenString(Board::FenNotation notation) const
 	return s;
 }
 
+quint64 OukBoard::stateKey() const
+{
+	// The initial moves of the King and the Maiden
+	quint64 key = 0;
+	if (m_moveCount[Side::White][King] == 0)
+		key |= 1;
+	if (m_moveCount[Side::White][Maiden] == 0)
+		key |= 2;
+	if (m_moveCount[Side::Black][King] == 0)
+		key |= 4;
+	if (m_moveCount[Side::Black][Maiden] == 0)
+		key |= 8;
+	return key;
+}
+
 bool OukBoard::parseCastlingRights(QChar c)
 {
 	if (c == '-')
@@ -241,11 +256,11 @@ QString KarOukBoard::defaultFenString() const
 	return "rnsmksnr/8/pppppppp/8/8/PPPPPPPP/8/RNSKMSNR w DEde 0 0 1";
 }
 
-Result KarOukBoard::result()
+Result KarOukBoard::vResult()
 {
 	Side side = sideToMove();
 	if (!inCheck(side))
-		return OukBoard::result();
+		return OukBoard::vResult();
 
 	Side opp = side.opposite();
 	QString str = tr("%1 wins by giving check").arg(opp.toString());
@@ -55,6 +55,7 @@ class LIB_EXPORT OukBoard : public MakrukBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
+		virtual quint64 stateKey() const;
 
 	protected:
 		/*! Piece types for ouk variants. */
@@ -113,7 +114,10 @@ class LIB_EXPORT KarOukBoard : public OukBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
+
+	protected:
+		// Inherited from OukBoard
+		virtual Result vResult();
 };
 
 } // namespace Chess
@@ -150,4 +150,7 @@ inline void Piece::setType(int type)
 }
 
 } // namespace Chess
+
+Q_DECLARE_TYPEINFO(Chess::Piece, Q_MOVABLE_TYPE);
+
 #endif // PIECE_H
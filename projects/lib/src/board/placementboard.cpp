@@ -91,44 +91,37 @@ void PlacementBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
 	const int arwidth = width() + 2;
 	const int start = 2 * arwidth + 1;
 	const int end = start + width();
+	const int a = isBlack ? start : size - end;
+
+	// The bishops and the squares that are empty or have a bishop
+	// on the base rank, by square colour
+	bool hasBishop[2] {false, false};
+	int freeSquares[2] {0, 0};
+	for (int s = a; s < a + width(); s++)
+	{
+		Piece tmp = pieceAt(s);
+		if (tmp.type() == Bishop)
+			hasBishop[s % 2] = true;
+		if (tmp.isEmpty() || tmp.type() == Bishop)
+			freeSquares[s % 2]++;
+	}
+	const bool bishopInReserve = reserveCount(Piece(side, Bishop)) > 0;
 
 	// loop index i will have Black side perspective
 	for (int i = start; i < end; i++)
 	{
-		bool ok = true;
 		int index = isBlack ? i : size - 1 - i;
-		Piece tmp = pieceAt(index);
-		if (!tmp.isEmpty())
+		if (!pieceAt(index).isEmpty())
 			continue;
 
-		// Square on a-file
-		int a = 1 + index / arwidth * arwidth;
-
 		// Bishops must not be placed on same coloured squares
-		if(pieceType == Bishop)
-		{
-			for (int s = a; s < a + width(); s++)
-			{
-				if (s % 2 != index % 2)
-					continue;
-				if (pieceAt(s).type() == Bishop)
-					ok = false;
-			}
-		}
-		else if (reserveCount(Piece(side, Bishop)) > 0)
-		{
-			bool colorOk[2] {false, false};
-
-			for (int s = a; s < a + width(); s++)
-			{
-				if (s == index)
-					continue;
-				tmp = pieceAt(s);
-				if (tmp.isEmpty() || tmp.type() == Bishop)
-					colorOk[s % 2] = true;
-			}
-			ok = colorOk[0] && colorOk[1];
-		}
+		const int color = index % 2;
+		bool ok = true;
+		if (pieceType == Bishop)
+			ok = !hasBishop[color];
+		// Leave a square of each colour for the bishops
+		else if (bishopInReserve)
+			ok = freeSquares[color] > 1 && freeSquares[1 - color] > 0;
 
 		if (ok)
 			moves.append(Move(0, index, pieceType));
@@ -138,13 +131,7 @@ void PlacementBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
 bool PlacementBoard::inSetup() const
 {
 	// Set-up phase ends when no pieces are left in reserve
-	const QList<Piece> reserveTypes = reservePieceTypes();
-	for (const Piece piece: reserveTypes)
-	{
-		if (reserveCount(piece) > 0)
-			return true;
-	}
-	return false;
+	return reserveTotal(Side::White) > 0 || reserveTotal(Side::Black) > 0;
 }
 
 bool PlacementBoard::vSetFenString(const QStringList& fen)
@@ -199,7 +186,7 @@ void PlacementBoard::setCastlingRights()
 	}
 }
 
-Result PlacementBoard::result()
+Result PlacementBoard::vResult()
 {
 	if (m_previouslyInSetUp && !m_inSetUp)
 		setCastlingRights();
@@ -210,7 +197,7 @@ Result PlacementBoard::result()
 	      removeCastlingRights(Side::Black);
 	}
 	m_previouslyInSetUp = m_inSetUp;
-	return WesternBoard::result();
+	return WesternBoard::vResult();
 }
 
 } // namespace Chess
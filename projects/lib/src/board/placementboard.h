@@ -58,9 +58,9 @@ class LIB_EXPORT PlacementBoard : public WesternBoard
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
 		virtual bool variantHasDrops() const;
-		virtual Result result();
 
 	protected:
+		virtual Result vResult();
 		virtual void setCastlingRights();
 
 		// Inherited from WesternBoard
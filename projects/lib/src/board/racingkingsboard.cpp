@@ -72,7 +72,7 @@ bool RacingKingsBoard::canFinish(Side side)
 	return false;
 }
 
-Result RacingKingsBoard::result()
+Result RacingKingsBoard::vResult()
 {
 	QString str;
 	bool blackFinished = finished(Side::Black);
@@ -45,10 +45,11 @@ class LIB_EXPORT RacingKingsBoard : public WesternBoard
 		// Inherited from WesternBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
-		virtual Result result();
 		virtual QString defaultFenString() const;
 
 	protected:
+		// Inherited from WesternBoard
+		virtual Result vResult();
 		virtual bool isLegalPosition();
 
 	private:
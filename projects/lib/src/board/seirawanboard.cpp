@@ -23,7 +23,8 @@
 namespace Chess {
 
 SeirawanBoard::SeirawanBoard()
-	: WesternBoard(new WesternZobrist())
+	: WesternBoard(new WesternZobrist()),
+	  m_legalBaseKey(0)
 {
 	setPieceType(Hawk, tr("hawk"), "H", KnightMovement | BishopMovement, "A");
 	setPieceType(Elephant, tr("elephant"), "E", KnightMovement | RookMovement, "C");
@@ -94,6 +95,20 @@ bool SeirawanBoard::vSetFenString(const QStringList& fen)
 	return WesternBoard::vSetFenString(fen);
 }
 
+quint64 SeirawanBoard::stateKey() const
+{
+	// The squares that pieces can still enter on
+	quint64 key = 0;
+	for (auto it = m_squareMap.constBegin(); it != m_squareMap.constEnd(); ++it)
+	{
+		if (it.value() > 0)
+			continue;
+		key ^= quint64(it.key());
+		key *= Q_UINT64_C(1099511628211);
+	}
+	return key;
+}
+
 void SeirawanBoard::insertIntoSquareMap(int square, int count)
 {
 	m_squareMap.insert(square, count);
@@ -289,7 +304,8 @@ Move SeirawanBoard::moveFromSanString(const QString& str)
 		return Move();
 
 	Piece piece = Piece(sideToMove(), promotion);
-	if (!reservePieceTypes().contains(piece) ||  reserveCount(piece) < 1)
+	if ((promotion != Hawk && promotion != Elephant)
+	||  reserveCount(piece) < 1)
 		return Move();
 
 	int target = move.targetSquare();
@@ -373,7 +389,7 @@ void SeirawanBoard::vUndoMove(const Move& move)
 	// channeling move?
 	if ( piece.side() == side
 	&&   chessSquare(index).isValid()
-	&&   reservePieceTypes().contains(piece))
+	&&   (piece.type() == Hawk || piece.type() == Elephant))
 	{
 		// undo channeling move
 		addToReserve(piece);
@@ -389,46 +405,77 @@ void SeirawanBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
 	if (!isValidSquare(chessSquare(square)))
 		return;
 
-	QVarLengthArray< Move > moves1, moves2;
-	WesternBoard::generateMovesForPiece(moves1, pieceType, square);
-
 	// add normal moves
-	for (Move m: moves1)
-		moves.append(m);
+	const int start = moves.size();
+	WesternBoard::generateMovesForPiece(moves, pieceType, square);
+	const int end = moves.size();
 
 	// return if no channeling is allowed on square
-	if (!m_squareMap.contains(square) ||  m_squareMap[square] > 0)
+	auto it = m_squareMap.constFind(square);
+	if (it == m_squareMap.constEnd() || it.value() > 0)
 		return;
 
-	// generate channeling moves as promotions on base rank
+	// the reserve pieces that can enter the board
 	Side side = sideToMove();
-	for (Move m: moves1)
+	int types[2];
+	int typeCount = 0;
+	for (int type: {Hawk, Elephant})
 	{
-		const QList<Piece>& reserveTypes = reservePieceTypes();
-		for (const Piece& pc: reserveTypes)
-		{
-			if (pc.side() == side &&  reserveCount(pc) > 0)
-				moves2.append(Move(m.sourceSquare(),
-						   m.targetSquare(),
-						   pc.type()));
-		}
+		if (reserveCount(Piece(side, type)) > 0)
+			types[typeCount++] = type;
 	}
 
-	// add channeling moves
-	for (Move m: moves2)
+	// add channeling moves as promotions on base rank
+	for (int i = start; i < end; i++)
 	{
-		moves.append(m);
-		// add castling move with channeling onto rook square
+		const Move m = moves.at(i);
 		Piece piece1 = pieceAt(m.sourceSquare());
 		Piece piece2 = pieceAt(m.targetSquare());
+		bool rookSquare = piece1.type() == King
+			       && piece2.type() == Rook
+			       && piece2.side() == side;
 
-		if (piece1.type() == King
-		&&  piece2.type() == Rook
-		&&  piece2.side() == side)
+		for (int j = 0; j < typeCount; j++)
+		{
 			moves.append(Move(m.sourceSquare(),
 					  m.targetSquare(),
-					  rookSquareChanneling(m.promotion())));
+					  types[j]));
+			// add castling move with channeling onto rook square
+			if (rookSquare)
+				moves.append(Move(m.sourceSquare(),
+						  m.targetSquare(),
+						  rookSquareChanneling(types[j])));
+		}
 	}
 }
 
+bool SeirawanBoard::vIsLegalMove(const Move& move)
+{
+	const int source = move.sourceSquare();
+	const int baseMove = (source << 16) | move.targetSquare();
+	const bool channeling = source != 0
+			     && move.promotion() != Piece::NoPiece
+			     && pieceAt(source).type() != Pawn;
+
+	if (m_legalBaseKey != key())
+	{
+		m_legalBaseKey = key();
+		m_legalBaseMoves.clear();
+	}
+
+	// A piece entering the vacated square can only block attacks
+	// on the king, so a channeling move is legal if the same move
+	// without channeling is. The move generator adds the normal
+	// moves first. The reverse isn't true, so channeling variants
+	// of illegal moves are still tested.
+	if (channeling && m_legalBaseMoves.contains(baseMove))
+		return true;
+
+	if (!WesternBoard::vIsLegalMove(move))
+		return false;
+	if (!channeling && move.promotion() == Piece::NoPiece)
+		m_legalBaseMoves.append(baseMove);
+	return true;
+}
+
 } // namespace Chess
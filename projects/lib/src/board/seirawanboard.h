@@ -53,6 +53,7 @@ class LIB_EXPORT SeirawanBoard : public WesternBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
+		virtual quint64 stateKey() const;
 
 	protected:
 		/*! Special piece types for Seirawan variants. */
@@ -82,8 +83,12 @@ class LIB_EXPORT SeirawanBoard : public WesternBoard
 		virtual void generateMovesForPiece(QVarLengthArray<Move>& moves,
 						   int pieceType,
 						   int square) const;
+		virtual bool vIsLegalMove(const Move& move);
 	private:
 		QMap<int, int> m_squareMap;
+		// Legal moves without channeling in the position m_legalBaseKey
+		quint64 m_legalBaseKey;
+		QVarLengthArray<int, 64> m_legalBaseMoves;
 		void insertIntoSquareMap(int square, int count = 0);
 		void updateSquareMap(const Move& move, int increment);
 		enum direction { forward, backward };
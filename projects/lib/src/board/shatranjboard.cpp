@@ -118,7 +118,7 @@ bool ShatranjBoard::inCheck(Side side, int square) const
 	return WesternBoard::inCheck(side, square);
 }
 
-Result ShatranjBoard::result()
+Result ShatranjBoard::vResult()
 {
 	Side side = sideToMove();
 
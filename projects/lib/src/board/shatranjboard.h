@@ -61,7 +61,6 @@ class LIB_EXPORT ShatranjBoard : public WesternBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
 
 	protected:
 		/*! Special piece types for Shatranj variants. */
@@ -79,6 +78,7 @@ class LIB_EXPORT ShatranjBoard : public WesternBoard
 		static const unsigned AlfilMovement = 32;
 
 		// Inherited from WesternBoard
+		virtual Result vResult();
 		virtual bool hasCastling() const;
 		virtual bool pawnHasDoubleStep() const;
 		virtual void vInitialize();
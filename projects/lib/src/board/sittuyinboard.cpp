@@ -177,13 +177,7 @@ void SittuyinBoard::generateMovesForPiece(QVarLengthArray< Move >& moves,
 bool SittuyinBoard::inSetup() const
 {
 	// Set-up phase (sit-tee) ends when no pieces are left in reserve
-	const QList<Piece> reserveTypes = reservePieceTypes();
-	for (const Piece piece: reserveTypes)
-	{
-		if (reserveCount(piece) > 0)
-			return true;
-	}
-	return false;
+	return reserveTotal(Side::White) > 0 || reserveTotal(Side::Black) > 0;
 }
 
 bool SittuyinBoard::vSetFenString(const QStringList& fen)
@@ -305,7 +299,7 @@ bool SittuyinBoard::canMakeNormalMove()
 	return false;
 }
 
-Result SittuyinBoard::result()
+Result SittuyinBoard::vResult()
 {
 	QString str;
 	Side side = sideToMove();
@@ -114,7 +114,7 @@ class LIB_EXPORT SittuyinBoard : public MakrukBoard
 		virtual bool isLegalPosition();
 		virtual int countingLimit() const;
 		virtual CountingRules countingRules() const;
-		virtual Result result();
+		virtual Result vResult();
 
 	private:
 		bool m_inSetUp;
@@ -28,8 +28,8 @@ Square::Square()
 }
 
 Square::Square(int file, int rank)
-	: m_file(file),
-	  m_rank(rank)
+	: m_file(qint8(qBound(-128, file, 127))),
+	  m_rank(qint8(qBound(-128, rank, 127)))
 {
 }
 
@@ -69,12 +69,13 @@ Square::Color Square::color() const
 
 void Square::setFile(int file)
 {
-	m_file = file;
+	// Out of range values stay out of range instead of wrapping
+	m_file = qint8(qBound(-128, file, 127));
 }
 
 void Square::setRank(int rank)
 {
-	m_rank = rank;
+	m_rank = qint8(qBound(-128, rank, 127));
 }
 
 } // namespace Chess
@@ -29,6 +29,9 @@ namespace Chess {
 * Square is mainly used as a middle-layer between the Board
 * class (which uses integers for squares) and more generic, high-level
 * classes like GenericMove.
+*
+* The file and rank are stored in one byte each, so a Square is as
+* cheap to copy and compare as a 16-bit integer.
 */
 class LIB_EXPORT Square
 {
@@ -67,9 +70,12 @@ class LIB_EXPORT Square
 		void setRank(int rank);
 
 	private:
-		int m_file;
-		int m_rank;
+		qint8 m_file;
+		qint8 m_rank;
 };
 
 } // namespace Chess
+
+Q_DECLARE_TYPEINFO(Chess::Square, Q_MOVABLE_TYPE);
+
 #endif // SQUARE_H
@@ -1062,6 +1062,11 @@ Board* StandardBoard::copy() const
 	return new StandardBoard(*this);
 }
 
+bool StandardBoard::variantHasBitboards() const
+{
+	return true;
+}
+
 QString StandardBoard::variant() const
 {
 	return "standard";
@@ -1074,17 +1079,15 @@ QString StandardBoard::defaultFenString() const
 
 Result StandardBoard::tablebaseResult(unsigned int* dtz) const
 {
-	SyzygyTablebase::PieceList pieces;
+	if (pieceCount() > 7)
+		return Result();
 
+	SyzygyTablebase::PieceList pieces;
 	for (int i = 0; i < arraySize(); i++)
 	{
 		Piece piece(pieceAt(i));
 		if (piece.isValid())
-		{
-			if (pieces.size() > 6)
-				return Result();
 			pieces.append(qMakePair(chessSquare(i), piece));
-		}
 	}
 
 	SyzygyTablebase::Castling castling = 0;
@@ -1102,7 +1105,8 @@ Result StandardBoard::tablebaseResult(unsigned int* dtz) const
 					castling,
 					reversibleMoveCount(),
 					pieces,
-					dtz);
+					dtz,
+					key());
 }
 
 } // namespace Chess
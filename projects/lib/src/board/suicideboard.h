@@ -60,10 +60,6 @@ class LIB_EXPORT SuicideBoard : public AntiBoard
 		// Inherited from AntiBoard
 		virtual Result vResultOfStalemate() const;
 
-	private:
-		int pieceCount(Side side,
-			       int ptype = Piece::NoPiece) const;
-
 }; // namespace Chess
 
 }
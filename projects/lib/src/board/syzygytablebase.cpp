@@ -18,17 +18,149 @@
 
 #include "syzygytablebase.h"
 #include <QDir>
+#include <QFile>
 #include <QMutex>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
 #include <QStringList>
 #include <tbprobe.h>
 #include "westernboard.h"
+#include "latencyhistogram.h"
+
+#ifdef Q_OS_UNIX
+  #include <sys/mman.h>
+#endif
+#ifdef Q_OS_LINUX
+  #include <sys/resource.h>
+#endif
 
 namespace {
 
 bool s_initialized = false, s_initOK = false, s_noRule50 = false;
 int s_pieces = INT_MAX;
+QStringList s_paths;
+
+// Files mapped and locked in memory by prefetch()
+QList<QFile*> s_pinnedFiles;
+
+// Probe statistics
+bool s_statsEnabled = false;
+QAtomicInteger<qint64> s_probeCount;
+QAtomicInteger<qint64> s_cacheHitCount;
+QMutex s_statsMutex;
+LatencyHistogram s_probeLatency;
+qint64 s_pageFaults = 0;
+
+// Returns the number of major page faults of the current thread, or -1
+qint64 majorPageFaults()
+{
+#ifdef Q_OS_LINUX
+	struct rusage usage;
+	if (getrusage(RUSAGE_THREAD, &usage) == 0)
+		return usage.ru_majflt;
+#endif
+	return -1;
+}
+
+// Measures the latency and page faults of a Fathom probe
+class ProbeTimer
+{
+	public:
+		ProbeTimer()
+			: m_pageFaults(0)
+		{
+			if (!s_statsEnabled)
+				return;
+			m_pageFaults = majorPageFaults();
+			m_timer.start();
+		}
+
+		~ProbeTimer()
+		{
+			if (!m_timer.isValid())
+				return;
+
+			const qint64 nsecs = m_timer.nsecsElapsed();
+			const qint64 pageFaults = majorPageFaults();
+
+			QMutexLocker locker(&s_statsMutex);
+			s_probeLatency.add(nsecs);
+			if (pageFaults != -1 && m_pageFaults != -1)
+				s_pageFaults += pageFaults - m_pageFaults;
+		}
+
+	private:
+		QElapsedTimer m_timer;
+		qint64 m_pageFaults;
+};
+// Serializes tb_probe_root(), which isn't thread-safe
 QMutex s_mutex;
 
+/*
+ * A lock-free cache of probe results shared by all games.
+ *
+ * The slots are picked by the low bits of the Zobrist key, and each
+ * slot stores its key XORed with its data, so a slot that is being
+ * overwritten by another thread is read as a miss. The cached values
+ * don't depend on the 50-move counter.
+ */
+class ProbeCache
+{
+	public:
+		enum Kind
+		{
+			Empty,
+			Wdl,		// WDL value with a fresh 50-move counter
+			Dtz,		// Signed distance to zero
+			Checkmate,
+			Stalemate,
+			Failed
+		};
+
+		struct Entry
+		{
+			Kind kind;
+			int value;
+		};
+
+		Entry find(quint64 key) const
+		{
+			const Slot& slot = m_slots[key & (Size - 1)];
+			const quint64 data = slot.data.loadAcquire();
+			const quint64 check = slot.check.loadAcquire();
+
+			Entry entry = { Empty, 0 };
+			if ((check ^ data) == key)
+			{
+				entry.kind = Kind(data >> 32);
+				entry.value = int(qint32(quint32(data)));
+			}
+			return entry;
+		}
+
+		void insert(quint64 key, const Entry& entry)
+		{
+			const quint64 data = (quint64(entry.kind) << 32)
+					   | quint32(entry.value);
+			Slot& slot = m_slots[key & (Size - 1)];
+			slot.check.storeRelease(key ^ data);
+			slot.data.storeRelease(data);
+		}
+
+	private:
+		static const int Size = 1 << 16;
+
+		struct Slot
+		{
+			QAtomicInteger<quint64> check;
+			QAtomicInteger<quint64> data;
+		};
+
+		Slot m_slots[Size];
+};
+
+ProbeCache s_cache;
+
 int tbSquare(const Chess::Square& square)
 {
 	if (!square.isValid())
@@ -46,10 +178,108 @@ bool SyzygyTablebase::initialize(const QString& path)
 
 	const auto nativePath = QDir::toNativeSeparators(path);
 	s_initOK = tb_init(nativePath.toStdString().c_str());
+	if (s_initOK)
+		s_paths = path.split(QDir::listSeparator(), QString::SkipEmptyParts);
 
 	return s_initOK;
 }
 
+qint64 SyzygyTablebase::prefetch(const QStringList& materials,
+				 qint64 maxBytes,
+				 bool lock)
+{
+	if (!s_initOK)
+		return 0;
+
+	QStringList filters;
+	for (const QString& material : materials)
+		filters << material + ".rtbw" << material + ".rtbz";
+
+	qint64 total = 0;
+	QByteArray buffer(1 << 20, Qt::Uninitialized);
+	for (const QString& path : qAsConst(s_paths))
+	{
+		const auto files = QDir(path).entryInfoList(filters, QDir::Files);
+		for (const QFileInfo& info : files)
+		{
+			if (maxBytes >= 0 && total + info.size() > maxBytes)
+				continue;
+
+			QFile* file = new QFile(info.filePath());
+			if (!file->open(QIODevice::ReadOnly))
+			{
+				qWarning("Cannot open tablebase file %s",
+					 qUtf8Printable(info.filePath()));
+				delete file;
+				continue;
+			}
+
+			// A locked mapping keeps the pages resident for
+			// Fathom's mapping of the same file
+			bool pinned = false;
+#ifdef Q_OS_UNIX
+			if (lock)
+			{
+				uchar* data = file->map(0, file->size());
+				if (data != nullptr
+				&&  mlock(data, size_t(file->size())) == 0)
+					pinned = true;
+				else
+					qWarning("Cannot lock tablebase file %s in memory",
+						 qUtf8Printable(info.filePath()));
+			}
+#else
+			Q_UNUSED(lock);
+#endif
+			if (pinned)
+			{
+				s_pinnedFiles.append(file);
+				total += info.size();
+				continue;
+			}
+
+			// Reading the file brings it to the OS file cache
+			while (file->read(buffer.data(), buffer.size()) > 0)
+				;
+			total += info.size();
+			delete file;
+		}
+	}
+
+	return total;
+}
+
+void SyzygyTablebase::setStatisticsEnabled(bool enabled)
+{
+	s_statsEnabled = enabled;
+}
+
+qint64 SyzygyTablebase::probeCount()
+{
+	return s_probeCount.loadAcquire();
+}
+
+qint64 SyzygyTablebase::cacheHitCount()
+{
+	return s_cacheHitCount.loadAcquire();
+}
+
+qint64 SyzygyTablebase::pageFaultCount()
+{
+#ifdef Q_OS_LINUX
+	QMutexLocker locker(&s_statsMutex);
+	return s_pageFaults;
+#else
+	return -1;
+#endif
+}
+
+LatencyHistogram SyzygyTablebase::probeLatency()
+{
+	QMutexLocker locker(&s_statsMutex);
+	return s_probeLatency;
+}
+
 bool SyzygyTablebase::tbAvailable(int pieces)
 {
 	return s_initOK && ((unsigned)pieces <= TB_LARGEST);
@@ -71,7 +301,8 @@ Chess::Result SyzygyTablebase::result(const Chess::Side& side,
 					   Castling castling,
 					   int rule50,
 					   const PieceList& pieces,
-					   unsigned int* dtz)
+					   unsigned int* dtz,
+					   quint64 key)
 {
 	if (!s_initOK)
 		return Chess::Result();
@@ -113,21 +344,92 @@ Chess::Result SyzygyTablebase::result(const Chess::Side& side,
 		}
 	}
 
-	s_mutex.lock();
-	unsigned result = tb_probe_root(white, black, kings, queens, rooks,
-		bishops, knights, pawns, rule50, 0, ep, wtm, nullptr);
-	s_mutex.unlock();
+	ProbeCache::Entry entry = { ProbeCache::Empty, 0 };
+	if (key != 0)
+		entry = s_cache.find(key);
+	if (s_statsEnabled)
+	{
+		s_probeCount.fetchAndAddRelaxed(1);
+		if (entry.kind != ProbeCache::Empty)
+			s_cacheHitCount.fetchAndAddRelaxed(1);
+	}
+
+	// The WDL tables are thread-safe. They are enough unless the
+	// distance to zero is needed or the 50-move counter could turn
+	// a win into a draw.
+	if (entry.kind == ProbeCache::Empty && dtz == nullptr)
+	{
+		unsigned wdl;
+		{
+			ProbeTimer timer;
+			wdl = tb_probe_wdl(white, black, kings, queens, rooks,
+				bishops, knights, pawns, 0, 0, ep, wtm);
+		}
+		if (wdl != TB_RESULT_FAILED)
+		{
+			entry.kind = ProbeCache::Wdl;
+			entry.value = int(wdl);
+			if (key != 0)
+				s_cache.insert(key, entry);
+		}
+	}
+	if (entry.kind == ProbeCache::Empty
+	||  (entry.kind == ProbeCache::Wdl
+	     && (dtz != nullptr
+		 || (rule50 > 0 && !s_noRule50
+		     && (entry.value == TB_WIN || entry.value == TB_LOSS)))))
+	{
+		unsigned result;
+		{
+			ProbeTimer timer;
+			QMutexLocker locker(&s_mutex);
+			result = tb_probe_root(white, black, kings, queens, rooks,
+				bishops, knights, pawns, 0, 0, ep, wtm, nullptr);
+		}
+
+		if (result == TB_RESULT_FAILED)
+			entry.kind = ProbeCache::Failed;
+		else if (result == TB_RESULT_CHECKMATE)
+			entry.kind = ProbeCache::Checkmate;
+		else if (result == TB_RESULT_STALEMATE)
+			entry.kind = ProbeCache::Stalemate;
+		else
+		{
+			const unsigned wdl = TB_GET_WDL(result);
+			entry.kind = ProbeCache::Dtz;
+			entry.value = int(TB_GET_DTZ(result));
+			if (wdl < TB_DRAW)
+				entry.value = -entry.value;
+			else if (wdl == TB_DRAW)
+				entry.value = 0;
+		}
+		if (key != 0)
+			s_cache.insert(key, entry);
+	}
 
-	Chess::Side winner(Chess::Side::NoSide); 
-	if (result == TB_RESULT_FAILED)
+	Chess::Side winner(Chess::Side::NoSide);
+	if (entry.kind == ProbeCache::Failed)
 		return Chess::Result();
-	if (result == TB_RESULT_CHECKMATE)
+	if (entry.kind == ProbeCache::Checkmate)
 		winner = (wtm? Chess::Side::Black: Chess::Side::White);
-	else if (result == TB_RESULT_STALEMATE)
+	else if (entry.kind == ProbeCache::Stalemate)
 		winner = Chess::Side::NoSide;
 	else
 	{
-		switch (TB_GET_WDL(result))
+		// Apply the 50-move counter to the distance to zero
+		unsigned wdl = unsigned(entry.value);
+		if (entry.kind == ProbeCache::Dtz)
+		{
+			const int value = entry.value;
+			if (value > 0)
+				wdl = (value + rule50 <= 100) ? TB_WIN : TB_CURSED_WIN;
+			else if (value < 0)
+				wdl = (-value + rule50 <= 100) ? TB_LOSS : TB_BLESSED_LOSS;
+			else
+				wdl = TB_DRAW;
+		}
+
+		switch (wdl)
 		{
 		case TB_BLESSED_LOSS:
 			if (!s_noRule50)
@@ -147,7 +449,9 @@ Chess::Result SyzygyTablebase::result(const Chess::Side& side,
 			break;
 		}
 	}
-	if (dtz != nullptr)
-		*dtz = TB_GET_DTZ(result);
+	if (dtz != nullptr && entry.kind == ProbeCache::Dtz)
+		*dtz = unsigned(qAbs(entry.value));
+	else if (dtz != nullptr)
+		*dtz = 0;
 	return Chess::Result(Chess::Result::Adjudication, winner, "SyzygyTB");
 }
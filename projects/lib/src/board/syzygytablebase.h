@@ -22,9 +22,11 @@
 #include <QFlags>
 #include <QList>
 #include <QPair>
+#include <QStringList>
 #include "result.h"
 #include "square.h"
 #include "piece.h"
+class LatencyHistogram;
 
 /*!
  * \brief A wrapper for probing Syzygy endgame tablebases.
@@ -77,6 +79,43 @@ class LIB_EXPORT SyzygyTablebase
 		 * Disable the 50 move rule from consideration.
 		 */
 		static void setNoRule50();
+		/*!
+		 * Reads the tablebase files of \a materials into memory
+		 * before they're probed.
+		 *
+		 * \a materials are material signatures such as "KRPvKR",
+		 * which may contain wildcards, eg. "KQ*". If \a maxBytes is
+		 * not negative, files that would take the total over
+		 * \a maxBytes bytes are skipped. If \a lock is true the
+		 * files are also locked in memory so that the OS can't page
+		 * them out (Unix only; the user's memory lock limit applies).
+		 *
+		 * Returns the number of bytes prefetched. This function
+		 * should be called after initialize() and before any games
+		 * are started.
+		 */
+		static qint64 prefetch(const QStringList& materials,
+				       qint64 maxBytes = -1,
+				       bool lock = false);
+		/*!
+		 * Enables or disables collecting probe statistics.
+		 * Disabled by default.
+		 */
+		static void setStatisticsEnabled(bool enabled);
+		/*! Returns the number of probes, including cache hits. */
+		static qint64 probeCount();
+		/*! Returns the number of probes answered by the cache. */
+		static qint64 cacheHitCount();
+		/*!
+		 * Returns the number of major page faults during tablebase
+		 * probes, or -1 if the platform doesn't report them.
+		 */
+		static qint64 pageFaultCount();
+		/*!
+		 * Returns the latencies of the probes that weren't answered
+		 * by the cache.
+		 */
+		static LatencyHistogram probeLatency();
 		/*!
 		 * Returns the expected game result for the positions specified
 		 * by \a side, \a enpassantSq, \a castling and \a pieces.
@@ -88,6 +127,13 @@ class LIB_EXPORT SyzygyTablebase
 		 * If the position isn't found in the tablebases, a null result
 		 * is returned.
 		 *
+		 * If \a key, the position's Zobrist key, is non-zero the
+		 * probe results are cached and shared by all games.
+		 *
+		 * This function is thread-safe. Only probes that need the
+		 * distance to zero are serialized, and only when the
+		 * result isn't already cached.
+		 *
 		 * \sa Chess::Board::tablebaseResult()
 		 */
 		static Chess::Result result(const Chess::Side& side,
@@ -95,7 +141,8 @@ class LIB_EXPORT SyzygyTablebase
 					    Castling castling,
 					    int rule50,
 					    const PieceList& pieces,
-					    unsigned int* dtz = nullptr);
+					    unsigned int* dtz = nullptr,
+					    quint64 key = 0);
 
 	private:
 		SyzygyTablebase();
@@ -51,7 +51,7 @@ bool ThreeKingsBoard::inCheck(Side, int) const
 	return false;
 }
 
-Result ThreeKingsBoard::result()
+Result ThreeKingsBoard::vResult()
 {
 	if (kingCount(Side::White) > kingCount(Side::Black))
 		return Result(Result::Win, Side::White,
@@ -59,7 +59,7 @@ Result ThreeKingsBoard::result()
 	if (kingCount(Side::Black) > kingCount(Side::White))
 		return Result(Result::Win, Side::Black,
 			      tr("Black wins"));
-	return WesternBoard::result();
+	return WesternBoard::vResult();
 }
 
 /*! Returns number of kings of \a side */
@@ -178,7 +178,7 @@ Move TwoKingsEachBoard::moveFromSanString(const QString& str)
 	return move;
 }
 
-Result TwoKingsEachBoard::result()
+Result TwoKingsEachBoard::vResult()
 {
 	QString str;
 
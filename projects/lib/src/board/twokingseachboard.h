@@ -48,8 +48,8 @@ class LIB_EXPORT TwoKingsEachBoard : public WesternBoard
 		virtual Board* copy() const;
 		virtual QString variant() const;
 		virtual QString defaultFenString() const;
-		virtual Result result();
 	protected:
+		virtual Result vResult();
 		virtual void vInitialize();
 		virtual bool kingsCountAssertion(int whiteKings,
 						 int blackKings) const;
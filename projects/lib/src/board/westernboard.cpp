@@ -37,6 +37,8 @@ WesternBoard::WesternBoard(WesternZobrist* zobrist)
 	  m_hasEnPassantCaptures(true),
 	  m_pawnAmbiguous(false),
 	  m_multiDigitNotation(false),
+	  m_hasPinDetection(false),
+	  m_hasAttackMaps(false),
 	  m_zobrist(zobrist)
 {
 	setPieceType(Pawn, tr("pawn"), "P");
@@ -91,6 +93,21 @@ bool WesternBoard::variantHasChanneling(Side, int) const
 	return false;
 }
 
+bool WesternBoard::variantHasBitboards() const
+{
+	return false;
+}
+
+bool WesternBoard::variantHasStandardLegality() const
+{
+	return variantHasBitboards();
+}
+
+bool WesternBoard::variantHasStandardAttacks() const
+{
+	return false;
+}
+
 void WesternBoard::vInitialize()
 {
 	m_kingCanCapture = kingCanCapture();
@@ -138,6 +155,16 @@ void WesternBoard::vInitialize()
 	m_pawnAmbiguous = (pawnAmbiguity(FreeStep) > 1);
 	m_multiDigitNotation =  (height() > 9 && coordinateSystem() == NormalCoordinates)
 			     || (width() > 9 && coordinateSystem() == InvertedCoordinates);
+
+	if (width() == 8 && height() == 8
+	&&  !variantHasWallSquares() && variantHasBitboards())
+		enableBitboards();
+
+	m_hasPinDetection = hasBitboards() && variantHasStandardLegality();
+	m_hasAttackMaps = !hasBitboards() && variantHasStandardAttacks();
+	m_pinData.key = 0;
+	m_pinData.checkers = 0;
+	m_pinData.pinned = 0;
 }
 
 inline int WesternBoard::pawnPushOffset(const PawnStep& ps, int sign) const
@@ -243,25 +270,51 @@ QString WesternBoard::sanMoveString(const Move& move)
 	if (piece.type() != Pawn)	// not pawn
 	{
 		str += pieceSymbol(piece).toUpper();
-		QVarLengthArray<Move> moves;
-		generateMoves(moves, piece.type());
 
-		for (int i = 0; i < moves.size(); i++)
+		// Only the other pieces of the same type can make the move
+		// ambiguous, so only their moves are generated
+		QVarLengthArray<int, 8> squares;
+		if (pieceCount(side, piece.type()) > 1)
 		{
-			const Move& move2 = moves[i];
-			if (move2.sourceSquare() == 0
-			||  move2.sourceSquare() == source
-			||  move2.targetSquare() != target)
-				continue;
+			if (hasBitboards())
+			{
+				quint64 bb = sideBitboard(side)
+					   & pieceTypeBitboard(piece.type());
+				while (bb)
+					squares.append(Bitboard::squareIndex(Bitboard::popLsb(bb)));
+			}
+			else
+			{
+				for (int i = 0; i < arraySize(); i++)
+				{
+					if (pieceAt(i) == piece)
+						squares.append(i);
+				}
+			}
+		}
 
-			if (!vIsLegalMove(move2))
+		QVarLengthArray<Move> moves;
+		for (int sq : squares)
+		{
+			if (sq == source)
 				continue;
 
-			Square square2(chessSquare(move2.sourceSquare()));
-			if (square2.file() != square.file())
-				needFile = true;
-			else if (square2.rank() != square.rank())
-				needRank = true;
+			moves.clear();
+			generateMovesForPiece(moves, piece.type(), sq);
+			for (int i = 0; i < moves.size(); i++)
+			{
+				const Move& move2 = moves[i];
+				if (move2.targetSquare() != target
+				||  !vIsLegalMove(move2))
+					continue;
+
+				Square square2(chessSquare(sq));
+				if (square2.file() != square.file())
+					needFile = true;
+				else if (square2.rank() != square.rank())
+					needRank = true;
+				break;
+			}
 		}
 	}
 	if (needFile)
@@ -484,8 +537,9 @@ Move WesternBoard::moveFromSanString(const QString& str)
 			return Move();
 	}
 
+	// Only generate moves for the pieces that may reach the target
 	QVarLengthArray<Move> moves;
-	generateMoves(moves, piece.type());
+	generateMovesToSquare(moves, piece.type(), target, sourceSq);
 	const Move* match = nullptr;
 
 	// Loop through all legal moves to find a move that matches
@@ -594,7 +648,10 @@ QString WesternBoard::vFenIncludeString(FenNotation notation) const
 QString WesternBoard::vFenString(FenNotation notation) const
 {
 	// Castling rights
-	QString fen = castlingRightsString(notation) + ' ';
+	QString fen;
+	fen.reserve(32);
+	fen += castlingRightsString(notation);
+	fen += QLatin1Char(' ');
 
 	// En-passant square
 	if (m_enpassantSquare != 0)
@@ -604,9 +661,9 @@ QString WesternBoard::vFenString(FenNotation notation) const
 			fen += squareString(m_enpassantTarget);
 	}
 	else
-		fen += '-';
+		fen += QLatin1Char('-');
 
-	fen +=vFenIncludeString(notation);
+	fen += vFenIncludeString(notation);
 
 	// Reversible halfmove count
 	fen += ' ';
@@ -1088,11 +1145,21 @@ void WesternBoard::generateMovesForPiece(QVarLengthArray<Move>& moves,
 	}
 	if (pieceType == King)
 	{
-		generateHoppingMoves(square, m_bishopOffsets, moves);
-		generateHoppingMoves(square, m_rookOffsets, moves);
+		if (hasBitboards())
+			generateBitboardMoves(moves, pieceType, square);
+		else
+		{
+			generateHoppingMoves(square, m_bishopOffsets, moves);
+			generateHoppingMoves(square, m_rookOffsets, moves);
+		}
 		generateCastlingMoves(moves);
 		return;
 	}
+	if (hasBitboards() && square != 0)
+	{
+		generateBitboardMoves(moves, pieceType, square);
+		return;
+	}
 
 	if (pieceHasMovement(pieceType, KnightMovement))
 		generateHoppingMoves(square, m_knightOffsets, moves);
@@ -1102,18 +1169,112 @@ void WesternBoard::generateMovesForPiece(QVarLengthArray<Move>& moves,
 		generateSlidingMoves(square, m_rookOffsets, moves);
 }
 
-bool WesternBoard::inCheck(Side side, int square) const
+void WesternBoard::generateMovesToSquare(QVarLengthArray<Move>& moves,
+					 int pieceType,
+					 int targetSquare,
+					 const Square& sourceHint) const
 {
-	Side opSide = side.opposite();
-	if (square == 0)
+	const Side side = sideToMove();
+	const Square target = chessSquare(targetSquare);
+	moves.clear();
+
+	if (hasBitboards())
 	{
-		square = m_kingSquare[side];
-		// In the "horde" variant the horde side has no king
-		if (square == 0)
-			return false;
+		quint64 sources = sideBitboard(side) & pieceTypeBitboard(pieceType);
+
+		// Standard pieces attack the target from the same squares
+		// that they could be attacked from, so only those pieces
+		// need to generate moves.
+		if (pieceType != Pawn)
+		{
+			const int bit = Bitboard::squareBit(targetSquare);
+			const quint64 occupied = sideBitboard(Side::White)
+					       | sideBitboard(Side::Black);
+			quint64 reach = 0;
+			if (pieceType == King)
+				reach |= Bitboard::kingAttacks(bit);
+			if (pieceHasMovement(pieceType, KnightMovement))
+				reach |= Bitboard::knightAttacks(bit);
+			if (pieceHasMovement(pieceType, BishopMovement))
+				reach |= Bitboard::bishopAttacks(bit, occupied);
+			if (pieceHasMovement(pieceType, RookMovement))
+				reach |= Bitboard::rookAttacks(bit, occupied);
+			sources &= reach;
+		}
+
+		while (sources)
+		{
+			int sq = Bitboard::squareIndex(Bitboard::popLsb(sources));
+			Square source = chessSquare(sq);
+			if ((sourceHint.file() != -1 && source.file() != sourceHint.file())
+			||  (sourceHint.rank() != -1 && source.rank() != sourceHint.rank()))
+				continue;
+			generateMovesForPiece(moves, pieceType, sq);
+		}
+		return;
+	}
+
+	// A pawn can't reach squares further than two steps away
+	int maxPawnFile = 0;
+	for (const PawnStep& pStep: m_pawnSteps)
+		maxPawnFile = qMax(maxPawnFile, qAbs(pStep.file));
+	maxPawnFile *= 2;
+
+	const Piece piece(side, pieceType);
+	const int begin = 2 * m_arwidth;
+	const int end = arraySize() - begin;
+	for (int sq = begin; sq < end; sq++)
+	{
+		if (pieceAt(sq) != piece)
+			continue;
+
+		Square source = chessSquare(sq);
+		if ((sourceHint.file() != -1 && source.file() != sourceHint.file())
+		||  (sourceHint.rank() != -1 && source.rank() != sourceHint.rank()))
+			continue;
+		if (pieceType == Pawn
+		&&  (qAbs(source.file() - target.file()) > maxPawnFile
+		||   qAbs(source.rank() - target.rank()) > 2))
+			continue;
+
+		generateMovesForPiece(moves, pieceType, sq);
+	}
+}
+
+void WesternBoard::generateBitboardMoves(QVarLengthArray<Move>& moves,
+					 int pieceType,
+					 int square) const
+{
+	Q_ASSERT(hasBitboards());
+
+	const int bit = Bitboard::squareBit(square);
+	const quint64 own = sideBitboard(sideToMove());
+	const quint64 occupied = own | sideBitboard(sideToMove().opposite());
+	quint64 targets = 0;
+
+	if (pieceType == King)
+		targets = Bitboard::kingAttacks(bit);
+	else
+	{
+		if (pieceHasMovement(pieceType, KnightMovement))
+			targets |= Bitboard::knightAttacks(bit);
+		if (pieceHasMovement(pieceType, BishopMovement))
+			targets |= Bitboard::bishopAttacks(bit, occupied);
+		if (pieceHasMovement(pieceType, RookMovement))
+			targets |= Bitboard::rookAttacks(bit, occupied);
+	}
+
+	targets &= ~own;
+	while (targets)
+	{
+		int target = Bitboard::squareIndex(Bitboard::popLsb(targets));
+		moves.append(Move(square, target));
 	}
+}
 
-	// Pawn attacks
+bool WesternBoard::pawnAttacked(Side side, int square) const
+{
+	Piece opPawn(side.opposite(), Pawn);
 	int sign = (side == Side::White) ? 1 : -1;
 
 	for (const PawnStep& pStep: m_pawnSteps)
@@ -1121,11 +1282,128 @@ bool WesternBoard::inCheck(Side side, int square) const
 		if (pStep.type == CaptureStep)
 		{
 			int fromSquare = square - pawnPushOffset(pStep, -sign);
-			if (pieceAt(fromSquare) == Piece(opSide, Pawn))
+			if (pieceAt(fromSquare) == opPawn)
 				return true;
 		}
 	}
 
+	return false;
+}
+
+void WesternBoard::attackMap(Side side, QVarLengthArray<quint8, 256>& map) const
+{
+	// Marks the squares that WesternBoard::inCheck() would consider
+	// attacked by the opponent of \a side, by scanning outwards from
+	// the attacking pieces instead of from each attacked square.
+	const Side opSide = side.opposite();
+	const int sign = (side == Side::White) ? 1 : -1;
+	const int size = arraySize();
+
+	map.resize(size);
+	for (int i = 0; i < size; i++)
+		map[i] = 0;
+
+	for (int square = 0; square < size; square++)
+	{
+		const Piece piece = pieceAt(square);
+		if (piece.side() != opSide)
+			continue;
+		const int type = piece.type();
+
+		if (type == Pawn)
+		{
+			for (const PawnStep& pStep: m_pawnSteps)
+			{
+				if (pStep.type != CaptureStep)
+					continue;
+				int target = square + pawnPushOffset(pStep, -sign);
+				if (target >= 0 && target < size)
+					map[target] = 1;
+			}
+		}
+		else if (type == King && m_kingCanCapture)
+		{
+			for (int i = 0; i < m_bishopOffsets.size(); i++)
+				map[square + m_bishopOffsets[i]] = 1;
+			for (int i = 0; i < m_rookOffsets.size(); i++)
+				map[square + m_rookOffsets[i]] = 1;
+		}
+
+		if (pieceHasMovement(type, KnightMovement))
+		{
+			for (int i = 0; i < m_knightOffsets.size(); i++)
+				map[square + m_knightOffsets[i]] = 1;
+		}
+		for (int dir = 0; dir < 2; dir++)
+		{
+			const unsigned movement = dir ? RookMovement : BishopMovement;
+			if (!pieceHasMovement(type, movement))
+				continue;
+
+			const QVarLengthArray<int>& offsets = dir ? m_rookOffsets
+								  : m_bishopOffsets;
+			for (int i = 0; i < offsets.size(); i++)
+			{
+				int target = square + offsets[i];
+				for (;;)
+				{
+					map[target] = 1;
+					if (!pieceAt(target).isEmpty())
+						break;
+					target += offsets[i];
+				}
+			}
+		}
+	}
+}
+
+bool WesternBoard::bitboardAttacked(Side side,
+				    int square,
+				    quint64 occupied) const
+{
+	Q_ASSERT(hasBitboards());
+
+	const Side opSide = side.opposite();
+	const int bit = Bitboard::squareBit(square);
+	const quint64 opPieces = sideBitboard(opSide);
+
+	if (Bitboard::knightAttacks(bit)
+	&   movementBitboard(opSide, KnightMovement))
+		return true;
+	if (m_kingCanCapture
+	&&  (Bitboard::kingAttacks(bit) & opPieces & pieceTypeBitboard(King)))
+		return true;
+	if (Bitboard::bishopAttacks(bit, occupied)
+	&   movementBitboard(opSide, BishopMovement))
+		return true;
+	if (Bitboard::rookAttacks(bit, occupied)
+	&   movementBitboard(opSide, RookMovement))
+		return true;
+
+	return false;
+}
+
+bool WesternBoard::inCheck(Side side, int square) const
+{
+	Side opSide = side.opposite();
+	if (square == 0)
+	{
+		square = m_kingSquare[side];
+		// In the "horde" variant the horde side has no king
+		if (square == 0)
+			return false;
+	}
+
+	if (pawnAttacked(side, square))
+		return true;
+
+	if (hasBitboards())
+	{
+		const quint64 occupied = sideBitboard(Side::White)
+				       | sideBitboard(Side::Black);
+		return bitboardAttacked(side, square, occupied);
+	}
+
 	Piece opKing(opSide, King);
 	Piece piece;
 	
@@ -1221,6 +1499,18 @@ bool WesternBoard::isLegalPosition()
 			}
 		}
 		
+		if (m_hasAttackMaps)
+		{
+			QVarLengthArray<quint8, 256> attacked;
+			attackMap(side, attacked);
+			for (int i = source; i != target; i += offset)
+			{
+				if (attacked[i])
+					return false;
+			}
+			return true;
+		}
+
 		for (int i = source; i != target; i += offset)
 		{
 			if (inCheck(side, i))
@@ -1240,9 +1530,157 @@ bool WesternBoard::vIsLegalMove(const Move& move)
 	&&  captureType(move) != Piece::NoPiece)
 		return false;
 
+	bool isLegal;
+	if (m_hasPinDetection && isLegalByPins(move, &isLegal))
+		return isLegal;
+
 	return Board::vIsLegalMove(move);
 }
 
+void WesternBoard::updatePinData() const
+{
+	if (m_pinData.key == key())
+		return;
+
+	const Side side = sideToMove();
+	const Side opSide = side.opposite();
+	const int kingSq = m_kingSquare[side];
+	const int kingBit = Bitboard::squareBit(kingSq);
+	const quint64 own = sideBitboard(side);
+	const quint64 occupied = own | sideBitboard(opSide);
+	const quint64 bishops = movementBitboard(opSide, BishopMovement);
+	const quint64 rooks = movementBitboard(opSide, RookMovement);
+
+	quint64 checkers = (Bitboard::knightAttacks(kingBit)
+			    & movementBitboard(opSide, KnightMovement))
+			 | (Bitboard::bishopAttacks(kingBit, occupied) & bishops)
+			 | (Bitboard::rookAttacks(kingBit, occupied) & rooks);
+
+	const Piece opPawn(opSide, Pawn);
+	const int sign = (side == Side::White) ? 1 : -1;
+	for (const PawnStep& pStep: m_pawnSteps)
+	{
+		if (pStep.type != CaptureStep)
+			continue;
+		int fromSquare = kingSq - pawnPushOffset(pStep, -sign);
+		if (pieceAt(fromSquare) == opPawn)
+			checkers |= Bitboard::squareMask(fromSquare);
+	}
+
+	// A piece is pinned if it's the only piece between the king
+	// and an opposing slider that would otherwise attack the king.
+	quint64 pinned = 0;
+	quint64 snipers = (Bitboard::bishopAttacks(kingBit, 0) & bishops)
+			| (Bitboard::rookAttacks(kingBit, 0) & rooks);
+	while (snipers)
+	{
+		int sniper = Bitboard::popLsb(snipers);
+		quint64 blockers = Bitboard::between(kingBit, sniper) & occupied;
+		if (blockers != 0 && (blockers & (blockers - 1)) == 0)
+			pinned |= blockers & own;
+	}
+
+	m_pinData.key = key();
+	m_pinData.checkers = checkers;
+	m_pinData.pinned = pinned;
+}
+
+bool WesternBoard::isLegalByPins(const Move& move, bool* isLegal) const
+{
+	Q_ASSERT(isLegal != nullptr);
+
+	const Side side = sideToMove();
+	const int kingSq = m_kingSquare[side];
+	const int source = move.sourceSquare();
+	const int target = move.targetSquare();
+
+	// Variants without a king (eg. the horde side in Horde chess)
+	if (kingSq == 0 || source == target)
+		return false;
+	// Castling and en-passant moves are verified by making them
+	if (source == kingSq && castlingSide(move) != NoCastlingSide)
+		return false;
+	if (source != 0
+	&&  target == m_enpassantSquare
+	&&  pieceAt(source).type() == Pawn)
+		return false;
+
+	if (source == kingSq)
+	{
+		// The king must not step on an attacked square. It's
+		// removed from the occupancy so that it can't hide behind
+		// itself when moving away from a slider.
+		const quint64 occupied = (sideBitboard(Side::White)
+					 | sideBitboard(Side::Black))
+				       & ~Bitboard::squareMask(kingSq);
+		*isLegal = !pawnAttacked(side, target)
+			&& !bitboardAttacked(side, target, occupied);
+		return true;
+	}
+
+	updatePinData();
+
+	const quint64 checkers = m_pinData.checkers;
+	const quint64 targetMask = Bitboard::squareMask(target);
+	const int kingBit = Bitboard::squareBit(kingSq);
+
+	if (checkers != 0)
+	{
+		// Only the king can escape a double check
+		if (checkers & (checkers - 1))
+		{
+			*isLegal = false;
+			return true;
+		}
+
+		// Single check: capture the checker or block the check
+		int checker = Bitboard::lsb(checkers);
+		if (!(targetMask & (checkers | Bitboard::between(kingBit, checker))))
+		{
+			*isLegal = false;
+			return true;
+		}
+	}
+
+	// A pinned piece may only move along the pin line
+	if (source != 0 && (m_pinData.pinned & Bitboard::squareMask(source)))
+	{
+		int sourceBit = Bitboard::squareBit(source);
+		*isLegal = (Bitboard::line(kingBit, sourceBit) & targetMask) != 0;
+		return true;
+	}
+
+	*isLegal = true;
+	return true;
+}
+
+bool WesternBoard::dropTargets(quint64* targets) const
+{
+	Q_ASSERT(targets != nullptr);
+	if (!m_hasPinDetection)
+		return false;
+
+	const quint64 empty = ~(sideBitboard(Side::White)
+			       | sideBitboard(Side::Black));
+	const int kingSq = m_kingSquare[sideToMove()];
+	if (kingSq == 0)
+	{
+		*targets = empty;
+		return true;
+	}
+
+	updatePinData();
+	const quint64 checkers = m_pinData.checkers;
+	if (checkers == 0)
+		*targets = empty;
+	else if (checkers & (checkers - 1))
+		*targets = 0;
+	else
+		*targets = Bitboard::between(Bitboard::squareBit(kingSq),
+					     Bitboard::lsb(checkers)) & empty;
+	return true;
+}
+
 void WesternBoard::addPromotions(int sourceSquare,
 				 int targetSquare,
 				 QVarLengthArray<Move>& moves) const
@@ -1384,7 +1822,7 @@ int WesternBoard::reversibleMoveCount() const
 	return m_reversibleMoveCount;
 }
 
-Result WesternBoard::result()
+Result WesternBoard::vResult()
 {
 	QString str;
 
@@ -1405,10 +1843,16 @@ Result WesternBoard::result()
 		}
 	}
 
-	// Insufficient mating material
-	int material = 0;
+	// Insufficient mating material. Only kings, bishops and a single
+	// knight can be insufficient, so the squares are scanned only then.
+	const int minorPieces = pieceCount(Side::NoSide, King)
+			      + pieceCount(Side::NoSide, Bishop)
+			      + pieceCount(Side::NoSide, Knight);
+	const bool mayBeInsufficient = pieceCount() == minorPieces
+				    && pieceCount(Side::NoSide, Knight) <= 1;
+	int material = mayBeInsufficient ? 0 : 2;
 	bool bishops[] = { false, false };
-	for (int i = 0; i < arraySize(); i++)
+	for (int i = 0; mayBeInsufficient && i < arraySize(); i++)
 	{
 		const Piece& piece = pieceAt(i);
 		if (!piece.isValid())
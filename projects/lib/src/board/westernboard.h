@@ -57,7 +57,6 @@ class LIB_EXPORT WesternBoard : public Board
 		// Inherited from Board
 		virtual int width() const;
 		virtual int height() const;
-		virtual Result result();
 		virtual int reversibleMoveCount() const;
 
 	protected:
@@ -142,6 +141,43 @@ class LIB_EXPORT WesternBoard : public Board
 		 * \sa SeirawanBoard
 		 */
 		virtual bool variantHasChanneling(Side side, int square) const;
+		/*!
+		 * Returns true if the variant can use the bitboard move
+		 * generator for pieces with knight, bishop and rook movement
+		 * and for check detection.
+		 *
+		 * Bitboards are only used on 8x8 boards without wall squares,
+		 * and only if the variant doesn't change how these pieces
+		 * move or attack. The default value is false.
+		 * \sa StandardBoard
+		 */
+		virtual bool variantHasBitboards() const;
+		/*!
+		 * Returns true if a move is legal exactly when it doesn't
+		 * leave the own king under attack.
+		 *
+		 * If both this function and variantHasBitboards() return
+		 * true, vIsLegalMove() filters moves with the checkers and
+		 * pinned pieces of the position instead of making and undoing
+		 * each move. Castling and en-passant moves always use the
+		 * make/undo path. The default value is the value of
+		 * variantHasBitboards().
+		 * \sa AtomicBoard
+		 */
+		virtual bool variantHasStandardLegality() const;
+		/*!
+		 * Returns true if every piece of the variant attacks
+		 * squares the way WesternBoard::inCheck() expects, ie. the
+		 * variant doesn't reimplement inCheck().
+		 *
+		 * When this function returns true and the variant doesn't
+		 * use bitboards, the squares a castling king passes are
+		 * tested against one attack map of the opponent's pieces
+		 * instead of calling inCheck() for each square. The default
+		 * value is false.
+		 * \sa CapablancaBoard
+		 */
+		virtual bool variantHasStandardAttacks() const;
 		/*!
 		 * Adds pawn promotions to a move list.
 		 *
@@ -192,6 +228,18 @@ class LIB_EXPORT WesternBoard : public Board
 		 * If \a square is 0, then the king square is used.
 		 */
 		virtual bool inCheck(Side side, int square = 0) const;
+		/*!
+		 * Stores the squares where the side to move can legally drop
+		 * a piece in \a targets, as a bitboard.
+		 *
+		 * The squares are the empty squares if the side to move is
+		 * not in check, the empty squares between the king and the
+		 * checking piece if it's in a single check, and none if it's
+		 * in a double check. Returns false, without changing
+		 * \a targets, if the board doesn't use pin detection.
+		 * \sa variantHasStandardLegality()
+		 */
+		bool dropTargets(quint64* targets) const;
 
 		/*!
 		 * Returns FEN extensions. The default is an empty string.
@@ -204,6 +252,7 @@ class LIB_EXPORT WesternBoard : public Board
 
 		// Inherited from Board
 		virtual void vInitialize();
+		virtual Result vResult();
 		virtual QString vFenString(FenNotation notation) const;
 		virtual bool vSetFenString(const QStringList& fen);
 		virtual QString lanMoveString(const Move& move);
@@ -228,6 +277,14 @@ class LIB_EXPORT WesternBoard : public Board
 			int rookSquare[2][2];
 		};
 
+		// Checkers and pinned pieces of the side to move
+		struct PinData
+		{
+			quint64 key;
+			quint64 checkers;
+			quint64 pinned;
+		};
+
 		// Data for reversing/unmaking a move
 		struct MoveData
 		{
@@ -242,6 +299,18 @@ class LIB_EXPORT WesternBoard : public Board
 		void generateCastlingMoves(QVarLengthArray<Move>& moves) const;
 		void generatePawnMoves(int sourceSquare,
 				       QVarLengthArray<Move>& moves) const;
+		void generateMovesToSquare(QVarLengthArray<Move>& moves,
+					   int pieceType,
+					   int targetSquare,
+					   const Square& sourceHint) const;
+		void generateBitboardMoves(QVarLengthArray<Move>& moves,
+					   int pieceType,
+					   int square) const;
+		bool bitboardAttacked(Side side, int square, quint64 occupied) const;
+		bool pawnAttacked(Side side, int square) const;
+		void attackMap(Side side, QVarLengthArray<quint8, 256>& map) const;
+		void updatePinData() const;
+		bool isLegalByPins(const Move& move, bool* isLegal) const;
 
 		bool canCastle(CastlingSide castlingSide) const;
 		QString castlingRightsString(FenNotation notation) const;
@@ -269,7 +338,10 @@ class LIB_EXPORT WesternBoard : public Board
 		bool m_hasEnPassantCaptures;
 		bool m_pawnAmbiguous;
 		bool m_multiDigitNotation;
-		QVector<MoveData> m_history;
+		bool m_hasPinDetection;
+		bool m_hasAttackMaps;
+		mutable PinData m_pinData;
+		QVarLengthArray<MoveData, 256> m_history;
 		CastlingRights m_castlingRights;
 		int m_castleTarget[2][2];
 		const WesternZobrist* m_zobrist;
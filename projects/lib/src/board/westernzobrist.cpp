@@ -17,7 +17,6 @@
 */
 
 #include "westernzobrist.h"
-#include <QMutexLocker>
 #include "piece.h"
 
 
@@ -33,8 +32,6 @@ WesternZobrist::WesternZobrist(const quint64* keys)
 void WesternZobrist::initialize(int squareCount,
 				int pieceTypeCount)
 {
-	QMutexLocker locker(&m_mutex);
-
 	if (isInitialized())
 		return;
 
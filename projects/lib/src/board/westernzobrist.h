@@ -20,7 +20,6 @@
 #define WESTERNZOBRIST_H
 
 #include "zobrist.h"
-#include <QMutex>
 
 namespace Chess {
 
@@ -57,7 +56,6 @@ class LIB_EXPORT WesternZobrist : public Zobrist
 	private:
 		int m_castlingIndex;
 		int m_pieceIndex;
-		QMutex m_mutex;
 };
 
 } //namespace Chess
@@ -17,18 +17,9 @@
 */
 
 #include "zobrist.h"
-#include <QVarLengthArray>
-#include <QMutex>
-#include <QMutexLocker>
+#include <QVector>
 #include "piece.h"
 
-namespace {
-
-QVarLengthArray<quint64, 0x2000> s_keys;
-QMutex s_mutex;
-
-} // anonymous namespace
-
 namespace Chess {
 
 int Zobrist::s_randomSeed = 1;
@@ -77,8 +68,6 @@ void Zobrist::initialize(int squareCount,
 	Q_ASSERT(squareCount > 0);
 	Q_ASSERT(pieceTypeCount > 1);
 
-	QMutexLocker locker(&s_mutex);
-
 	if (m_initialized)
 		return;
 
@@ -87,12 +76,18 @@ void Zobrist::initialize(int squareCount,
 
 	if (m_keys == nullptr)
 	{
-		// Initialize the global zobrist array
-		if (s_keys.isEmpty())
+		// The global zobrist array is generated once, by the first
+		// board that is initialized. The initialization of a local
+		// static is thread-safe, and after it only a lock-free guard
+		// check is needed, so boards that are created in parallel
+		// don't wait for each other.
+		static const QVector<quint64> s_keys = []()
 		{
-			for (int i = 0; i < s_keys.capacity(); i++)
-				s_keys.append(random64());
-		}
+			QVector<quint64> keys(0x2000);
+			for (int i = 0; i < keys.size(); i++)
+				keys[i] = random64();
+			return keys;
+		}();
 		m_keys = s_keys.constData();
 	}
 	m_initialized = true;
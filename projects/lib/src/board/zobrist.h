@@ -59,6 +59,10 @@ class LIB_EXPORT Zobrist
 		 *
 		 * \note Subclasses that reimplement this function must call
 		 * the base implementation.
+		 * \note The default keys are shared by all Zobrist objects,
+		 * and different objects can be initialized in parallel
+		 * without locking. A single object must not be initialized
+		 * from several threads at once.
 		 */
 		virtual void initialize(int squareCount,
 					int pieceTypeCount);
@@ -0,0 +1,110 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bookprobecache.h"
+#include <QMutexLocker>
+
+BookProbeCache::BookProbeCache(int capacity)
+	: m_capacity(qMax(1, capacity)),
+	  m_shardCapacity((m_capacity + ShardCount - 1) / ShardCount),
+	  m_size(0)
+{
+	for (Shard& shard : m_shards)
+		shard.hand = 0;
+}
+
+int BookProbeCache::capacity() const
+{
+	return m_capacity;
+}
+
+bool BookProbeCache::isEmpty() const
+{
+	return m_size.loadAcquire() == 0;
+}
+
+BookProbeCache::Shard& BookProbeCache::shard(quint64 key)
+{
+	// Every bit of a Zobrist key is random, so the top bits pick
+	// the shard and the shard's hash table uses the whole key
+	return m_shards[(key >> 60) % ShardCount];
+}
+
+bool BookProbeCache::find(quint64 key, QList<OpeningBook::Entry>* entries)
+{
+	Shard& shard = this->shard(key);
+	QMutexLocker locker(&shard.mutex);
+
+	auto it = shard.index.constFind(key);
+	if (it == shard.index.constEnd())
+		return false;
+
+	Slot& slot = shard.slots[it.value()];
+	slot.referenced = true;
+	*entries = slot.entries;
+	return true;
+}
+
+void BookProbeCache::insert(quint64 key, const QList<OpeningBook::Entry>& entries)
+{
+	Shard& shard = this->shard(key);
+	QMutexLocker locker(&shard.mutex);
+
+	auto it = shard.index.constFind(key);
+	if (it != shard.index.constEnd())
+	{
+		shard.slots[it.value()].entries = entries;
+		return;
+	}
+
+	if (shard.slots.size() < m_shardCapacity)
+	{
+		Slot slot = { key, entries, false };
+		shard.index.insert(key, shard.slots.size());
+		shard.slots.append(slot);
+		m_size.ref();
+		return;
+	}
+
+	// Give the entries that were found since the last pass
+	// a second chance
+	while (shard.slots.at(shard.hand).referenced)
+	{
+		shard.slots[shard.hand].referenced = false;
+		shard.hand = (shard.hand + 1) % shard.slots.size();
+	}
+
+	Slot& slot = shard.slots[shard.hand];
+	shard.index.remove(slot.key);
+	shard.index.insert(key, shard.hand);
+	slot.key = key;
+	slot.entries = entries;
+	shard.hand = (shard.hand + 1) % shard.slots.size();
+}
+
+void BookProbeCache::clear()
+{
+	for (Shard& shard : m_shards)
+	{
+		QMutexLocker locker(&shard.mutex);
+		shard.slots.clear();
+		shard.index.clear();
+		shard.hand = 0;
+	}
+	m_size.storeRelease(0);
+}
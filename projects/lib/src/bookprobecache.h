@@ -0,0 +1,94 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOOKPROBECACHE_H
+#define BOOKPROBECACHE_H
+
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInt>
+#include "openingbook.h"
+
+/*!
+ * \brief A bounded cache of opening book probes
+ *
+ * BookProbeCache maps the Zobrist keys of recently probed positions to
+ * their book entries, including positions that aren't in the book. It
+ * can be used by concurrent games: the keys are spread over shards
+ * that are locked separately.
+ *
+ * When a shard is full, an entry is evicted with the CLOCK policy: the
+ * clock hand skips, and clears the flag of, entries that were found
+ * since the hand last passed them, so frequently probed positions,
+ * like the first moves of the openings, stay in the cache.
+ *
+ * \sa OpeningBook::setProbeCacheSize()
+ */
+class LIB_EXPORT BookProbeCache
+{
+	public:
+		/*! Creates a new cache for at most \a capacity positions. */
+		explicit BookProbeCache(int capacity);
+
+		/*! Returns the maximum number of cached positions. */
+		int capacity() const;
+		/*! Returns true if no positions are cached. */
+		bool isEmpty() const;
+
+		/*!
+		 * Finds the position with Zobrist key \a key and copies its
+		 * entries to \a entries.
+		 *
+		 * Returns true if the position is cached; otherwise returns
+		 * false.
+		 */
+		bool find(quint64 key, QList<OpeningBook::Entry>* entries);
+		/*! Caches \a entries for the position with key \a key. */
+		void insert(quint64 key, const QList<OpeningBook::Entry>& entries);
+		/*! Removes all positions from the cache. */
+		void clear();
+
+	private:
+		Q_DISABLE_COPY(BookProbeCache)
+
+		enum { ShardCount = 16 };
+
+		struct Slot
+		{
+			quint64 key;
+			QList<OpeningBook::Entry> entries;
+			bool referenced;
+		};
+		struct Shard
+		{
+			QMutex mutex;
+			QVector<Slot> slots;
+			QHash<quint64, int> index;
+			int hand;
+		};
+
+		Shard& shard(quint64 key);
+
+		int m_capacity;
+		int m_shardCapacity;
+		QAtomicInt m_size;
+		Shard m_shards[ShardCount];
+};
+
+#endif // BOOKPROBECACHE_H
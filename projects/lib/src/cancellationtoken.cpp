@@ -0,0 +1,33 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cancellationtoken.h"
+
+CancellationToken::CancellationToken()
+	: m_cancelled(new QAtomicInt(0))
+{
+}
+
+void CancellationToken::cancel()
+{
+	m_cancelled->storeRelease(1);
+}
+
+bool CancellationToken::isCancelled() const
+{
+	return m_cancelled->loadAcquire() != 0;
+}
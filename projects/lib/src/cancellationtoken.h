@@ -0,0 +1,52 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CANCELLATIONTOKEN_H
+#define CANCELLATIONTOKEN_H
+
+#include <QSharedPointer>
+#include <QAtomicInt>
+
+/*!
+ * \brief A shared flag for cooperative cancellation of background work
+ *
+ * Copies of a CancellationToken share the same flag, so a task can
+ * hand copies to the helper jobs it starts, and cancelling any copy
+ * cancels all of them. The work is expected to poll isCancelled() and
+ * return early when it becomes true.
+ *
+ * All functions are thread-safe.
+ */
+class LIB_EXPORT CancellationToken
+{
+	public:
+		/*! Creates a new token that isn't cancelled. */
+		CancellationToken();
+
+		/*! Requests cancellation of the work that shares the token. */
+		void cancel();
+		/*!
+		 * Returns true if cancel() was called on this token or
+		 * any of its copies.
+		 */
+		bool isCancelled() const;
+
+	private:
+		QSharedPointer<QAtomicInt> m_cancelled;
+};
+
+#endif // CANCELLATIONTOKEN_H
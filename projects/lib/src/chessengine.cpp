@@ -18,14 +18,40 @@
 
 #include "chessengine.h"
 #include <QIODevice>
-#include <QTimer>
+#include <QMetaMethod>
 #include <QStringRef>
 #include <QtAlgorithms>
+#include <cstring>
 #include "engineoption.h"
+#include "engineprocess.h"
+#include "enginelibrary.h"
+#include "enginesocket.h"
+#include "timerwheel.h"
+#include "tracelog.h"
 
 
 int ChessEngine::s_count = 0;
 
+namespace {
+
+// One optional line in this many is kept by OutputSample
+const int s_sampleInterval = 16;
+
+// Appends \a str and a newline to \a out as Latin-1 without
+// a temporary byte array
+void appendLine(QByteArray& out, const QString& str)
+{
+	const int size = out.size();
+	out.resize(size + str.size() + 1);
+
+	char* dst = out.data() + size;
+	for (const QChar c : str)
+		*dst++ = c.unicode() < 0x100 ? char(c.unicode()) : '?';
+	*dst = '\n';
+}
+
+} // anonymous namespace
+
 QStringRef ChessEngine::nextToken(const QStringRef& previous, bool untilEnd)
 {
 	const QString* str = previous.string();
@@ -76,26 +102,32 @@ ChessEngine::ChessEngine(QObject* parent)
 	  m_pinging(false),
 	  m_whiteEvalPov(false),
 	  m_pondering(false),
-	  m_pingTimer(new QTimer(this)),
-	  m_quitTimer(new QTimer(this)),
-	  m_idleTimer(new QTimer(this)),
-	  m_protocolStartTimer(new QTimer(this)),
+	  m_pingTimer(new WheelTimer(this)),
+	  m_quitTimer(new WheelTimer(this)),
+	  m_idleTimer(new WheelTimer(this)),
+	  m_protocolStartTimer(new WheelTimer(this)),
+	  m_handshakeStart(-1),
+	  m_flushPending(false),
 	  m_ioDevice(nullptr),
-	  m_restartMode(EngineConfiguration::RestartAuto)
+	  m_restartMode(EngineConfiguration::RestartAuto),
+	  m_outputBudget(0),
+	  m_outputPolicy(EngineConfiguration::OutputDrop),
+	  m_windowLines(0),
+	  m_sampleCount(0),
+	  m_droppedLines(0)
 {
-	m_pingTimer->setSingleShot(true);
+	// Reserved capacity survives resize(0) between batches
+	m_outBuffer.reserve(4096);
+
 	m_pingTimer->setInterval(15000);
 	connect(m_pingTimer, SIGNAL(timeout()), this, SLOT(onPingTimeout()));
 
-	m_quitTimer->setSingleShot(true);
 	m_quitTimer->setInterval(5000);
 	connect(m_quitTimer, SIGNAL(timeout()), this, SLOT(onQuitTimeout()));
 
-	m_idleTimer->setSingleShot(true);
 	m_idleTimer->setInterval(15000);
 	connect(m_idleTimer, SIGNAL(timeout()), this, SLOT(onIdleTimeout()));
 
-	m_protocolStartTimer->setSingleShot(true);
 	m_protocolStartTimer->setInterval(35000);
 	connect(m_protocolStartTimer, SIGNAL(timeout()),
 		this, SLOT(onProtocolStartTimeout()));
@@ -142,6 +174,13 @@ void ChessEngine::applyConfiguration(const EngineConfiguration& configuration)
 	m_pondering = configuration.pondering();
 	m_restartMode = configuration.restartMode();
 	setClaimsValidated(configuration.areClaimsValidated());
+	m_outputBudget = configuration.outputBudget();
+	m_outputPolicy = configuration.outputPolicy();
+}
+
+void ChessEngine::addOptionalPrefix(const QByteArray& prefix)
+{
+	m_optionalPrefixes.append(prefix);
 }
 
 void ChessEngine::addOption(EngineOption* option)
@@ -190,6 +229,19 @@ void ChessEngine::setOption(const QString& name, const QVariant& value)
 	sendOption(option->name(), option->value());
 }
 
+void ChessEngine::sendOption(const QString& name, const QVariant& value)
+{
+	if (!value.isNull())
+	{
+		auto it = m_sentOptions.find(name);
+		if (it != m_sentOptions.end() && it.value() == value)
+			return;
+		m_sentOptions[name] = value;
+	}
+
+	writeOption(name, value);
+}
+
 QList<EngineOption*> ChessEngine::options() const
 {
 	return m_options;
@@ -217,7 +269,10 @@ void ChessEngine::start()
 		return;
 	
 	m_pinging = false;
+	m_sentOptions.clear();
 	setState(Starting);
+	if (TraceLog::isEnabled())
+		m_handshakeStart = TraceLog::timestamp();
 
 	flushWriteBuffer();
 	
@@ -233,6 +288,13 @@ void ChessEngine::onProtocolStart()
 	setState(Idle);
 	Q_ASSERT(isReady());
 
+	if (m_handshakeStart >= 0)
+	{
+		TraceLog::addEventSince("engine", "Handshake: " + name(),
+					m_handshakeStart);
+		m_handshakeStart = -1;
+	}
+
 	flushWriteBuffer();
 
 	QMap<QString, QVariant>::const_iterator i = m_optionBuffer.constBegin();
@@ -281,7 +343,10 @@ void ChessEngine::endGame(const Chess::Result& result)
 	ChessPlayer::endGame(result);
 
 	if (restartsBetweenGames())
+	{
+		emit restarting();
 		quit();
+	}
 	else
 		ping();
 }
@@ -303,6 +368,20 @@ bool ChessEngine::supportsVariant(const QString& variant) const
 	return m_variants.contains(variant);
 }
 
+ResourceUsage ChessEngine::resourceUsage() const
+{
+	EngineProcess* process = qobject_cast<EngineProcess*>(m_ioDevice);
+	if (process == nullptr || state() == Disconnected)
+		return ResourceUsage();
+
+	return ResourceUsage::ofProcess(process->processId());
+}
+
+qint64 ChessEngine::droppedLineCount() const
+{
+	return m_droppedLines;
+}
+
 int ChessEngine::id() const
 {
 	return m_id;
@@ -351,6 +430,7 @@ void ChessEngine::kill()
 	m_pingTimer->stop();
 	m_protocolStartTimer->stop();
 	m_writeBuffer.clear();
+	m_outBuffer.resize(0);
 
 	disconnect(m_ioDevice, SIGNAL(readChannelFinished()),
 		   this, SLOT(onCrashed()));
@@ -427,37 +507,124 @@ void ChessEngine::write(const QString& data, WriteMode mode)
 	if (state() == NotStarted
 	||  (m_pinging && mode == Buffered))
 	{
-		m_writeBuffer.append(data);
+		appendLine(m_writeBuffer, data);
 		return;
 	}
 
 	Q_ASSERT(m_ioDevice->isWritable());
-	emit debugMessage(QString(">%1(%2): %3")
-			  .arg(name())
-			  .arg(m_id)
-			  .arg(data));
+	if (isDebugMessageConnected())
+		emit debugMessage(QString(">%1(%2): %3")
+				  .arg(name())
+				  .arg(m_id)
+				  .arg(data));
+
+	appendLine(m_outBuffer, data);
+	scheduleFlush();
+}
+
+void ChessEngine::scheduleFlush()
+{
+	// Commands written while handling the same event, eg. the
+	// position and go commands, reach the device in one write
+	if (m_flushPending)
+		return;
+
+	m_flushPending = true;
+	QMetaObject::invokeMethod(this, "flushOutput", Qt::QueuedConnection);
+}
 
-	if (m_ioDevice->write(data.toLatin1() + "\n") == -1)
+void ChessEngine::flush()
+{
+	flushOutput();
+}
+
+void ChessEngine::flushOutput()
+{
+	m_flushPending = false;
+	if (m_outBuffer.isEmpty())
+		return;
+
+	if (m_ioDevice->isOpen()
+	&&  m_ioDevice->write(m_outBuffer) == -1)
 		qWarning("Writing to engine %s(%d) failed",
 			 qUtf8Printable(name()), m_id);
+	m_outBuffer.resize(0);
+}
+
+bool ChessEngine::isDebugMessageConnected() const
+{
+	static const QMetaMethod signal(
+		QMetaMethod::fromSignal(&ChessPlayer::debugMessage));
+	return isSignalConnected(signal);
 }
 
 void ChessEngine::onReadyRead()
 {
-	while (m_ioDevice->isReadable() && m_ioDevice->canReadLine())
+	if (!m_ioDevice->isReadable())
+		return;
+
+	// Everything the engine has written is read at once, and the
+	// lines are split off in place
+	m_readBuffer += m_ioDevice->readAll();
+
+	// A move in this input is timed from when it was read from the
+	// pipe, so a busy event loop isn't charged to the engine's clock
+	// or left out of the relay latency. EngineProcess is a QProcess
+	// on some platforms.
+	QElapsedTimer inputTimer;
+#ifndef EngineProcess
+	EngineProcess* process = qobject_cast<EngineProcess*>(m_ioDevice);
+	if (process != nullptr)
+		inputTimer = process->lineTimer();
+#endif
+	EngineLibrary* library = qobject_cast<EngineLibrary*>(m_ioDevice);
+	if (library != nullptr)
+		inputTimer = library->lineTimer();
+	// A remote engine isn't charged for the network round trip
+	qint64 latency = 0;
+	EngineSocket* socket = qobject_cast<EngineSocket*>(m_ioDevice);
+	if (socket != nullptr)
+	{
+		inputTimer = socket->lineTimer();
+		latency = socket->latency();
+	}
+	if (!inputTimer.isValid())
+		inputTimer.start();
+	setMoveInputTimer(inputTimer, latency);
+
+	// The output budget is counted in one second windows
+	if (m_outputBudget > 0
+	&&  (!m_outputWindow.isValid() || m_outputWindow.hasExpired(1000)))
+	{
+		m_outputWindow.start();
+		m_windowLines = 0;
+	}
+
+	int pos = 0;
+	while (m_ioDevice->isReadable())
 	{
-		QString line = QString(m_ioDevice->readLine());
-		if (line.endsWith('\n'))
-			line.chop(1);
-		if (line.endsWith('\r'))
-			line.chop(1);
-		if (line.isEmpty())
+		const int end = m_readBuffer.indexOf('\n', pos);
+		if (end == -1)
+			break;
+
+		const int start = pos;
+		int size = end - start;
+		pos = end + 1;
+		if (size > 0 && m_readBuffer.at(end - 1) == '\r')
+			size--;
+		if (size == 0)
+			continue;
+		if (m_outputBudget > 0
+		&&  dropLine(m_readBuffer.constData() + start, size))
 			continue;
 
-		emit debugMessage(QString("<%1(%2): %3")
-				  .arg(name())
-				  .arg(m_id)
-				  .arg(line));
+		const QString line(QString::fromUtf8(
+			m_readBuffer.constData() + start, size));
+		if (isDebugMessageConnected())
+			emit debugMessage(QString("<%1(%2): %3")
+					  .arg(name())
+					  .arg(m_id)
+					  .arg(line));
 		parseLine(line);
 
 		if (m_idleTimer->isActive())
@@ -468,16 +635,67 @@ void ChessEngine::onReadyRead()
 				m_idleTimer->stop();
 		}
 	}
+
+	m_readBuffer.remove(0, pos);
+}
+
+bool ChessEngine::dropLine(const char* data, int size)
+{
+	if (++m_windowLines <= m_outputBudget)
+		return false;
+
+	// Only the prefix is compared, so an optional line is dropped
+	// without decoding or parsing it
+	bool optional = false;
+	for (const QByteArray& prefix : qAsConst(m_optionalPrefixes))
+	{
+		if (size >= prefix.size()
+		&&  memcmp(data, prefix.constData(), size_t(prefix.size())) == 0)
+		{
+			optional = true;
+			break;
+		}
+	}
+	if (!optional)
+		return false;
+
+	if (m_outputPolicy == EngineConfiguration::OutputSample
+	&&  m_sampleCount++ % s_sampleInterval == 0)
+		return false;
+
+	m_droppedLines++;
+	return true;
 }
 
 void ChessEngine::flushWriteBuffer()
 {
-	if (m_pinging || state() == NotStarted)
+	if (m_pinging || state() == NotStarted || m_writeBuffer.isEmpty())
 		return;
 
-	for (const QString& line : qAsConst(m_writeBuffer))
-		write(line);
+	if (state() == Disconnected)
+	{
+		m_writeBuffer.clear();
+		return;
+	}
+
+	if (isDebugMessageConnected())
+	{
+		int start = 0;
+		int end;
+		while ((end = m_writeBuffer.indexOf('\n', start)) != -1)
+		{
+			emit debugMessage(QString(">%1(%2): %3")
+					  .arg(name())
+					  .arg(m_id)
+					  .arg(QLatin1String(m_writeBuffer.constData() + start,
+							     end - start)));
+			start = end + 1;
+		}
+	}
+
+	m_outBuffer.append(m_writeBuffer);
 	m_writeBuffer.clear();
+	scheduleFlush();
 }
 
 void ChessEngine::clearWriteBuffer()
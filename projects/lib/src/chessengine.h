@@ -22,10 +22,12 @@
 #include "chessplayer.h"
 #include <QVariant>
 #include <QStringList>
+#include <QElapsedTimer>
 #include "engineconfiguration.h"
 
 class QIODevice;
 class EngineOption;
+class WheelTimer;
 
 
 /*!
@@ -68,6 +70,8 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		virtual bool isHuman() const;
 		virtual bool isReady() const;
 		virtual bool supportsVariant(const QString& variant) const;
+		virtual ResourceUsage resourceUsage() const;
+		virtual qint64 droppedLineCount() const;
 
 		/*!
 		 * Starts communicating with the engine.
@@ -100,7 +104,11 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		 * Writes text data to the chess engine.
 		 *
 		 * If \a mode is \a Unbuffered, the data will be written to
-		 * the device immediately even if the engine is being pinged.
+		 * the device even if the engine is being pinged.
+		 *
+		 * \note Commands are collected into a byte buffer which is
+		 * written to the device in one call when control returns
+		 * to the event loop.
 		 */
 		void write(const QString& data, WriteMode mode = Buffered);
 
@@ -185,6 +193,16 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		 */
 		bool stopThinking();
 
+		/*!
+		 * Marks the input lines that start with \a prefix as
+		 * optional, eg. debug output. Optional lines are dropped
+		 * or sampled before they're parsed when the engine writes
+		 * more lines than its output budget allows.
+		 *
+		 * \sa EngineConfiguration::outputBudget()
+		 */
+		void addOptionalPrefix(const QByteArray& prefix);
+
 		/*! Adds \a option to the engine options list. */
 		void addOption(EngineOption* option);
 		/*!
@@ -192,8 +210,17 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		 * Returns 0 if an option with that name doesn't exist.
 		 */
 		EngineOption* getOption(const QString& name) const;
-		/*! Tells the engine to set option \a name's value to \a value. */
-		virtual void sendOption(const QString& name, const QVariant& value) = 0;
+		/*!
+		 * Tells the engine to set option \a name's value to \a value.
+		 *
+		 * The option isn't sent again if the engine process already
+		 * has the same value, so a reused engine doesn't eg.
+		 * reallocate its hash table for every game. Options with a
+		 * null value (buttons) are always sent.
+		 */
+		void sendOption(const QString& name, const QVariant& value);
+		/*! Writes the command that sets option \a name to \a value. */
+		virtual void writeOption(const QString& name, const QVariant& value) = 0;
 
 		/*! Adds \a variant to the list of supported variants. */
 		void addVariant(const QString& variant);
@@ -231,6 +258,14 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		 */
 		int id() const;
 
+	signals:
+		/*!
+		 * Emitted at the end of a game when the engine quits
+		 * because it restarts between games. A new instance of the
+		 * engine can be started right away.
+		 */
+		void restarting();
+
 	protected slots:
 		// Inherited from ChessPlayer
 		virtual void onTimeout();
@@ -270,11 +305,22 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		/*! Clear the write buffer without flushing it. */
 		void clearWriteBuffer();
 
+		/*!
+		 * Sends the commands written so far to the engine right
+		 * away instead of at the end of the current event.
+		 */
+		void flush();
+
 	private slots:
 		void onQuitTimeout();
 		void onProtocolStartTimeout();
+		void flushOutput();
 
 	private:
+		bool isDebugMessageConnected() const;
+		void scheduleFlush();
+		bool dropLine(const char* data, int size);
+
 		static int s_count;
 
 		int m_id;
@@ -282,16 +328,30 @@ class LIB_EXPORT ChessEngine : public ChessPlayer
 		bool m_pinging;
 		bool m_whiteEvalPov;
 		bool m_pondering;
-		QTimer* m_pingTimer;
-		QTimer* m_quitTimer;
-		QTimer* m_idleTimer;
-		QTimer* m_protocolStartTimer;
+		WheelTimer* m_pingTimer;
+		WheelTimer* m_quitTimer;
+		WheelTimer* m_idleTimer;
+		WheelTimer* m_protocolStartTimer;
+		// Start of the protocol handshake for TraceLog, or -1
+		qint64 m_handshakeStart;
+		bool m_flushPending;
 		QIODevice *m_ioDevice;
-		QStringList m_writeBuffer;
+		QByteArray m_readBuffer;
+		QByteArray m_writeBuffer;
+		QByteArray m_outBuffer;
 		QStringList m_variants;
 		QList<EngineOption*> m_options;
 		QMap<QString, QVariant> m_optionBuffer;
+		// Option values sent to the engine process
+		QMap<QString, QVariant> m_sentOptions;
 		EngineConfiguration::RestartMode m_restartMode;
+		QList<QByteArray> m_optionalPrefixes;
+		int m_outputBudget;
+		EngineConfiguration::OutputPolicy m_outputPolicy;
+		QElapsedTimer m_outputWindow;
+		int m_windowLines;
+		int m_sampleCount;
+		qint64 m_droppedLines;
 };
 
 #endif // CHESSENGINE_H
@@ -18,38 +18,18 @@
 #include "chessgame.h"
 #include <QThread>
 #include <QTimer>
+#include <QMetaMethod>
 #include "board/board.h"
 #include "chessplayer.h"
+#include "loadmonitor.h"
 #include "openingbook.h"
+#include "memoryaccount.h"
+#include "tracelog.h"
+#include "mersenne.h"
 
 namespace {
 
-QString evalString(const MoveEvaluation& eval)
-{
-	if (eval.isBookEval())
-		return "book";
-	if (eval.isEmpty())
-		return QString();
-
-	QString str = eval.scoreText();
-	if (eval.depth() > 0)
-		str += "/" + QString::number(eval.depth()) + " ";
-
-	int t = eval.time();
-	if (t == 0)
-		return str + "0s";
-
-	int precision = 0;
-	if (t < 100)
-		precision = 3;
-	else if (t < 1000)
-		precision = 2;
-	else if (t < 10000)
-		precision = 1;
-	str += QString::number(double(t / 1000.0), 'f', precision) + 's';
-
-	return str;
-}
+QAtomicInt s_snapshotsEnabled(0);
 
 } // anonymous namespace
 
@@ -63,7 +43,13 @@ ChessGame::ChessGame(Chess::Board* board, PgnGame* pgn, QObject* parent)
 	  m_pgnInitialized(false),
 	  m_bookOwnership(false),
 	  m_boardShouldBeFlipped(false),
-	  m_pgn(pgn)
+	  m_pgn(pgn),
+	  m_snapshotVersion(0),
+	  m_moveMemory(0),
+	  m_loadMonitor(nullptr),
+	  m_overloadedMoves(0),
+	  m_traceStart(-1),
+	  m_engineLogLimit(0)
 {
 	Q_ASSERT(pgn != nullptr);
 
@@ -72,11 +58,14 @@ ChessGame::ChessGame(Chess::Board* board, PgnGame* pgn, QObject* parent)
 		m_player[i] = nullptr;
 		m_book[i] = nullptr;
 		m_bookDepth[i] = 0;
+		m_starvedMoves[i] = 0;
+		m_startDroppedLines[i] = 0;
 	}
 }
 
 ChessGame::~ChessGame()
 {
+	MemoryAccount::add(MemoryAccount::GameMoves, -m_moveMemory);
 	delete m_board;
 	if (m_bookOwnership)
 	{
@@ -133,9 +122,32 @@ const QVector<Chess::Move>& ChessGame::moves() const
 	return m_moves;
 }
 
-const QMap<int,int>& ChessGame::scores() const
+QMap<int,int> ChessGame::scores() const
+{
+	QMap<int,int> scores;
+	for (int i = 0; i < m_scores.size(); i++)
+	{
+		if (m_scores.at(i) != MoveEvaluation::NULL_SCORE)
+			scores[i] = m_scores.at(i);
+	}
+	return scores;
+}
+
+qint64 ChessGame::memoryUsage() const
+{
+	qint64 bytes = sizeof(*this) + m_moveMemory;
+	bytes += m_moves.capacity() * sizeof(Chess::Move);
+	bytes += m_scores.capacity() * sizeof(int);
+	bytes += m_evaluations.capacity() * sizeof(MoveEvaluation);
+	bytes += m_engineLog.capacity();
+	if (m_pgn != nullptr)
+		bytes += sizeof(PgnGame);
+	return bytes;
+}
+
+const QVector<MoveEvaluation>& ChessGame::evaluations() const
 {
-	return m_scores;
+	return m_evaluations;
 }
 
 Chess::Result ChessGame::result() const
@@ -143,6 +155,30 @@ Chess::Result ChessGame::result() const
 	return m_result;
 }
 
+LatencyHistogram ChessGame::relayLatency(Chess::Side side) const
+{
+	Q_ASSERT(!side.isNull());
+	return m_relayLatency[side];
+}
+
+LatencyHistogram ChessGame::clockOverhead(Chess::Side side) const
+{
+	Q_ASSERT(!side.isNull());
+	return m_clockOverhead[side];
+}
+
+ChessPlayer::PonderStats ChessGame::ponderStats(Chess::Side side) const
+{
+	Q_ASSERT(!side.isNull());
+	return m_ponderStats[side];
+}
+
+ResourceUsage ChessGame::resourceUsage(Chess::Side side) const
+{
+	Q_ASSERT(!side.isNull());
+	return m_resourceUsage[side];
+}
+
 ChessPlayer* ChessGame::playerToMove() const
 {
 	if (m_board->sideToMove().isNull())
@@ -167,6 +203,7 @@ void ChessGame::stop(bool emitMoveChanged)
 	if (!m_gameInProgress)
 	{
 		m_result = Chess::Result();
+		publishSnapshot();
 		finish();
 		return;
 	}
@@ -178,17 +215,40 @@ void ChessGame::stop(bool emitMoveChanged)
 	const QVector<PgnGame::MoveData>& moves(m_pgn->moves());
 	int plies = moves.size();
 
-	m_pgn->setTag("PlyCount", QString::number(plies));
+	m_pgn->setTag(PgnGame::PlyCountTag, QString::number(plies));
 
 	m_pgn->setGameEndTime(gameEndTime);
 
+	// Sample the players before they can quit or restart
+	for (int i = 0; i < 2; i++)
+	{
+		Chess::Side side = Chess::Side::Type(i);
+		m_resourceUsage[i] = m_player[i]->resourceUsage().since(m_startUsage[i]);
+		if (m_resourceUsage[i].isValid())
+			m_pgn->setTag(side == Chess::Side::White ? "WhiteResourceUsage"
+								 : "BlackResourceUsage",
+				      m_resourceUsage[i].toString());
+		if (m_starvedMoves[i] > 0)
+			m_pgn->setTag(side == Chess::Side::White ? "WhiteStarvedMoves"
+								 : "BlackStarvedMoves",
+				      QString::number(m_starvedMoves[i]));
+		const qint64 dropped = m_player[i]->droppedLineCount()
+				     - m_startDroppedLines[i];
+		if (dropped > 0)
+			m_pgn->setTag(side == Chess::Side::White ? "WhiteDroppedLines"
+								 : "BlackDroppedLines",
+				      QString::number(dropped));
+	}
+	if (m_overloadedMoves > 0)
+		m_pgn->setTag("HostOverloadMoves", QString::number(m_overloadedMoves));
+
 	m_pgn->setResult(m_result);
 	m_pgn->setResultDescription(m_result.description());
+	publishSnapshot();
 
 	if (emitMoveChanged && plies > 1)
 	{
-		const PgnGame::MoveData& md(moves.at(plies - 1));
-		emit moveChanged(plies - 1, md.move, md.moveString, md.comment);
+		emit moveChanged(MoveEvent(plies - 1, moves.at(plies - 1)));
 	}
 
 	m_player[Chess::Side::White]->endGame(m_result);
@@ -204,7 +264,27 @@ void ChessGame::finish()
 	for (int i = 0; i < 2; i++)
 	{
 		if (m_player[i] != nullptr)
+		{
+			// The player may start a new game after this one
+			m_relayLatency[i] = m_player[i]->relayLatency();
+			m_clockOverhead[i] = m_player[i]->clockOverhead();
+			m_ponderStats[i] = m_player[i]->ponderStats();
 			m_player[i]->disconnect(this);
+		}
+	}
+
+	if (m_traceStart >= 0)
+	{
+		QJsonObject args;
+		args["round"] = m_pgn->round();
+		args["result"] = m_result.toShortString();
+		args["reason"] = m_result.description();
+		args["plies"] = m_moves.size();
+		TraceLog::addEventSince("game",
+					m_pgn->playerName(Chess::Side::White) + " vs "
+					+ m_pgn->playerName(Chess::Side::Black),
+					m_traceStart, args);
+		m_traceStart = -1;
 	}
 
 	emit finished(this, m_result);
@@ -221,29 +301,47 @@ void ChessGame::kill()
 	stop();
 }
 
-void ChessGame::addPgnMove(const Chess::Move& move, const QString& comment)
+void ChessGame::addPgnMove(const Chess::Move& move,
+			   const MoveEvaluation& evaluation)
 {
+	// The comment is formatted from the evaluation when the
+	// PGN is written or displayed
 	PgnGame::MoveData md;
 	md.key = m_board->key();
 	md.move = m_board->genericMove(move);
 	md.moveString = m_board->moveString(move, Chess::Board::StandardAlgebraic);
-	md.comment = comment;
+	md.evaluation = evaluation;
 
+	addPgnMove(md);
+}
+
+void ChessGame::addPgnMove(const PgnGame::MoveData& md)
+{
 	m_pgn->addMove(md);
+
+	const qint64 bytes = sizeof(md)
+			   + (md.moveString.size() + md.comment.size()) * 2;
+	m_moveMemory += bytes;
+	MemoryAccount::add(MemoryAccount::GameMoves, bytes);
 }
 
 void ChessGame::emitLastMove()
 {
 	int ply = m_moves.size() - 1;
-	if (m_scores.contains(ply))
-	{
-		int score = m_scores[ply];
-		if (score != MoveEvaluation::NULL_SCORE)
-			emit scoreChanged(ply, score);
-	}
-
-	const auto& md = m_pgn->moves().last();
-	emit moveMade(md.move, md.moveString, md.comment);
+	int score = m_scores.value(ply, MoveEvaluation::NULL_SCORE);
+	if (score != MoveEvaluation::NULL_SCORE)
+		m_snapshotScores[ply] = score;
+
+	// The snapshot must be published before the signals, see snapshot()
+	publishSnapshot();
+	if (score != MoveEvaluation::NULL_SCORE)
+		emit scoreChanged(ply, score);
+
+	// The comment is formatted by the receivers that need it
+	static const QMetaMethod moveMadeSignal =
+		QMetaMethod::fromSignal(&ChessGame::moveMade);
+	if (isSignalConnected(moveMadeSignal))
+		emit moveMade(MoveEvent(ply, m_pgn->moves().last()));
 }
 
 void ChessGame::onMoveMade(const Chess::Move& move)
@@ -260,9 +358,25 @@ void ChessGame::onMoveMade(const Chess::Move& move)
 		return;
 	}
 
-	m_scores[m_moves.size()] = sender->evaluation().score();
+	// Book and opening moves have no scores
+	while (m_scores.size() < m_moves.size())
+		m_scores.append(MoveEvaluation::NULL_SCORE);
+	m_scores.append(sender->evaluation().score());
 	m_moves.append(move);
-	addPgnMove(move, evalString(sender->evaluation()));
+
+	// The principal variation isn't needed after the game
+	MoveEvaluation eval(sender->evaluation());
+	eval.setPv(QString());
+	m_evaluations.append(eval);
+	addPgnMove(move, eval);
+
+	if (m_loadMonitor != nullptr)
+	{
+		if (m_loadMonitor->addMove(sender->name(), eval))
+			m_starvedMoves[m_board->sideToMove()]++;
+		if (m_loadMonitor->isOverloaded())
+			m_overloadedMoves++;
+	}
 
 	// Get the result before sending the move to the opponent
 	m_board->makeMove(move);
@@ -382,6 +496,7 @@ Chess::Move ChessGame::bookMove(Chess::Side side)
 	||  m_moves.size() >= m_bookDepth[side] * 2)
 		return Chess::Move();
 
+	RandomStream::Scope random(&m_random);
 	Chess::GenericMove bookMove = m_book[side]->move(m_board->key());
 	Chess::Move move = m_board->moveFromGenericMove(bookMove);
 	if (move.isNull())
@@ -417,6 +532,7 @@ void ChessGame::setStartingFen(const QString& fen)
 {
 	Q_ASSERT(!m_gameInProgress);
 	m_startingFen = fen;
+	m_opening.clear();
 }
 
 void ChessGame::setTimeControl(const TimeControl& timeControl, Chess::Side side)
@@ -427,11 +543,19 @@ void ChessGame::setTimeControl(const TimeControl& timeControl, Chess::Side side)
 		m_timeControl[Chess::Side::White] = timeControl;
 }
 
+TimeControl ChessGame::timeControl(Chess::Side side) const
+{
+	TimeControl timeControl(m_timeControl[side]);
+	timeControl.initialize();
+	return timeControl;
+}
+
 void ChessGame::setMoves(const QVector<Chess::Move>& moves)
 {
 	Q_ASSERT(!m_gameInProgress);
 	m_scores.clear();
 	m_moves = moves;
+	m_opening.clear();
 }
 
 bool ChessGame::setMoves(const PgnGame& pgn)
@@ -441,6 +565,7 @@ bool ChessGame::setMoves(const PgnGame& pgn)
 		return false;
 	m_scores.clear();
 	m_moves.clear();
+	m_opening.clear();
 
 	for (const PgnGame::MoveData& md : pgn.moves())
 	{
@@ -458,6 +583,44 @@ bool ChessGame::setMoves(const PgnGame& pgn)
 	return true;
 }
 
+void ChessGame::setOpening(const SharedOpening& opening)
+{
+	Q_ASSERT(!m_gameInProgress);
+	Q_ASSERT(!opening.isNull());
+
+	m_startingFen = opening->startingFen;
+	m_scores.clear();
+	m_moves = opening->moves;
+	m_opening = opening;
+}
+
+ChessGame::SharedOpening ChessGame::sharedOpening()
+{
+	if (!m_opening.isNull() && m_opening->pgnMoves.size() == m_moves.size())
+		return m_opening;
+
+	// Random variants get a fixed starting position here
+	const bool ok = resetBoard();
+	Opening* opening = new Opening;
+	opening->startingFen = m_startingFen;
+	opening->moves = m_moves;
+	opening->pgnMoves.reserve(m_moves.size());
+
+	for (int i = 0; ok && i < m_moves.size(); i++)
+	{
+		const Chess::Move& move(m_moves.at(i));
+		PgnGame::MoveData md;
+		md.key = m_board->key();
+		md.move = m_board->genericMove(move);
+		md.moveString = m_board->moveString(move, Chess::Board::StandardAlgebraic);
+		opening->pgnMoves.append(md);
+		m_board->makeMove(move);
+	}
+
+	m_opening = SharedOpening(opening);
+	return m_opening;
+}
+
 void ChessGame::setOpeningBook(const OpeningBook* book,
 			       Chess::Side side,
 			       int depth)
@@ -476,6 +639,44 @@ void ChessGame::setOpeningBook(const OpeningBook* book,
 	}
 }
 
+const GameAdjudicator& ChessGame::adjudicator() const
+{
+	return m_adjudicator;
+}
+
+void ChessGame::setLoadMonitor(LoadMonitor* monitor)
+{
+	m_loadMonitor = monitor;
+}
+
+void ChessGame::setEngineLogLimit(int bytes)
+{
+	Q_ASSERT(bytes >= 0);
+	m_engineLogLimit = bytes;
+}
+
+QByteArray ChessGame::engineLog() const
+{
+	return m_engineLog;
+}
+
+void ChessGame::onDebugMessage(const QString& data)
+{
+	m_engineLog += QByteArray::number(m_engineLogTimer.elapsed());
+	m_engineLog += ' ';
+	m_engineLog += data.toUtf8();
+	m_engineLog += '\n';
+
+	// Drop the oldest lines in big chunks, because the end of the
+	// log is the most interesting part of a failed game
+	if (m_engineLog.size() > m_engineLogLimit)
+	{
+		int start = m_engineLog.size() - m_engineLogLimit * 3 / 4;
+		start = m_engineLog.indexOf('\n', start) + 1;
+		m_engineLog.remove(0, start > 0 ? start : m_engineLog.size());
+	}
+}
+
 void ChessGame::setAdjudicator(const GameAdjudicator& adjudicator)
 {
 	m_adjudicator = adjudicator;
@@ -513,11 +714,47 @@ void ChessGame::generateOpening()
 	}
 }
 
+void ChessGame::generateRandomMoves(int plies)
+{
+	if (plies <= 0 || !resetBoard())
+		return;
+
+	for (const Chess::Move& move : qAsConst(m_moves))
+	{
+		m_board->makeMove(move);
+		if (!m_board->result().isNone())
+			return;
+	}
+
+	// Append random legal moves that don't end the game
+	RandomStream::Scope random(&m_random);
+	Chess::MoveList moves;
+	for (int i = 0; i < plies; i++)
+	{
+		m_board->legalMoves(moves);
+		if (moves.isEmpty())
+			break;
+
+		const int index = int(Mersenne::random() % quint32(moves.size()));
+		const Chess::Move move(moves.at(index));
+		m_board->makeMove(move);
+		if (!m_board->result().isNone())
+			break;
+
+		m_moves.append(move);
+	}
+}
+
 void ChessGame::emitStartFailed()
 {
 	emit startFailed(this);
 }
 
+void ChessGame::setRandomStream(const RandomStream& stream)
+{
+	m_random = stream;
+}
+
 void ChessGame::setStartDelay(int time)
 {
 	Q_ASSERT(time >= 0);
@@ -529,6 +766,65 @@ void ChessGame::setBookOwnership(bool enabled)
 	m_bookOwnership = enabled;
 }
 
+void ChessGame::setSnapshotsEnabled(bool enabled)
+{
+	s_snapshotsEnabled.storeRelease(enabled ? 1 : 0);
+}
+
+ChessGame::SharedSnapshot ChessGame::snapshot() const
+{
+	QMutexLocker locker(&m_snapshotMutex);
+	return m_snapshot;
+}
+
+void ChessGame::updateSnapshot()
+{
+	publishSnapshot();
+}
+
+int ChessGame::Snapshot::currentTimeLeft(Chess::Side side) const
+{
+	int time = timeLeft[side];
+	if (side == thinkingSide && !infiniteTime[side])
+		time -= int(QDateTime::currentMSecsSinceEpoch() - timestamp);
+	return time;
+}
+
+void ChessGame::publishSnapshot()
+{
+	if (s_snapshotsEnabled.loadAcquire() == 0)
+		return;
+
+	// The snapshot shares the data of the PGN, which is only copied
+	// when the next move is added to the PGN
+	Snapshot* snapshot = new Snapshot;
+	snapshot->version = ++m_snapshotVersion;
+	snapshot->pgn = *m_pgn;
+	snapshot->pgn.setTagReceiver(nullptr);
+	snapshot->fen = m_board->fenString();
+	snapshot->sideToMove = m_board->sideToMove();
+	snapshot->scores = m_snapshotScores;
+	snapshot->thinkingSide = Chess::Side::NoSide;
+	if (m_gameInProgress && !m_finished)
+		snapshot->thinkingSide = m_board->sideToMove();
+	snapshot->timestamp = QDateTime::currentMSecsSinceEpoch();
+	snapshot->finished = m_finished;
+
+	for (int i = 0; i < 2; i++)
+	{
+		// The players get the game's time controls when it starts
+		TimeControl tc(timeControl(Chess::Side::Type(i)));
+		if ((m_gameInProgress || m_finished) && m_player[i] != nullptr)
+			tc = *m_player[i]->timeControl();
+		snapshot->timeLeft[i] = tc.timeLeft();
+		snapshot->infiniteTime[i] = tc.isInfinite();
+	}
+
+	SharedSnapshot shared(snapshot);
+	QMutexLocker locker(&m_snapshotMutex);
+	m_snapshot.swap(shared);
+}
+
 void ChessGame::pauseThread()
 {
 	m_pauseSem.release();
@@ -557,6 +853,7 @@ bool ChessGame::resetBoard()
 	QString fen(m_startingFen);
 	if (fen.isEmpty())
 	{
+		RandomStream::Scope random(&m_random);
 		fen = m_board->defaultFenString();
 		if (m_board->isRandomVariant())
 			m_startingFen = fen;
@@ -629,11 +926,17 @@ void ChessGame::start()
 		m_startDelay = 0;
 		return;
 	}
+	if (TraceLog::isEnabled())
+		m_traceStart = TraceLog::timestamp();
 
+	m_engineLogTimer.start();
 	for (int i = 0; i < 2; i++)
 	{
 		connect(m_player[i], SIGNAL(resultClaim(Chess::Result)),
 			this, SLOT(onResultClaim(Chess::Result)));
+		if (m_engineLogLimit > 0)
+			connect(m_player[i], SIGNAL(debugMessage(QString)),
+				this, SLOT(onDebugMessage(QString)));
 	}
 
 	// Start the game in the correct thread
@@ -645,8 +948,14 @@ void ChessGame::start()
 	emit humanEnabled(false);
 	resetBoard();
 	initializePgn();
+	publishSnapshot();
 	emit initialized(this);
-	emit fenChanged(m_board->startingFenString());
+
+	// Games played without a GUI have no use for the FEN string
+	static const QMetaMethod fenChangedSignal =
+		QMetaMethod::fromSignal(&ChessGame::fenChanged);
+	if (isSignalConnected(fenChangedSignal))
+		emit fenChanged(m_board->startingFenString());
 }
 
 void ChessGame::pause()
@@ -677,11 +986,11 @@ void ChessGame::initializePgn()
 	m_pgn->setResult(m_result);
 
 	if (m_timeControl[Chess::Side::White] == m_timeControl[Chess::Side::Black])
-		m_pgn->setTag("TimeControl", m_timeControl[0].toString());
+		m_pgn->setTag(PgnGame::TimeControlTag, m_timeControl[0].toString());
 	else
 	{
-		m_pgn->setTag("WhiteTimeControl", m_timeControl[Chess::Side::White].toString());
-		m_pgn->setTag("BlackTimeControl", m_timeControl[Chess::Side::Black].toString());
+		m_pgn->setTag(PgnGame::WhiteTimeControlTag, m_timeControl[Chess::Side::White].toString());
+		m_pgn->setTag(PgnGame::BlackTimeControlTag, m_timeControl[Chess::Side::Black].toString());
 	}
 }
 
@@ -724,6 +1033,11 @@ void ChessGame::startGame()
 	emit started(this);
 	QDateTime gameStartTime = QDateTime::currentDateTime();
 	m_pgn->setGameStartTime(gameStartTime);
+	for (int i = 0; i < 2; i++)
+	{
+		m_startUsage[i] = m_player[i]->resourceUsage();
+		m_startDroppedLines[i] = m_player[i]->droppedLineCount();
+	}
 
 	for (int i = 0; i < 2; i++)
 	{
@@ -734,13 +1048,25 @@ void ChessGame::startGame()
 		m_player[side]->newGame(side, m_player[side.opposite()], m_board);
 	}
 
+	MoveEvaluation bookEval;
+	bookEval.setBookEval(true);
+	m_evaluations.fill(bookEval, m_moves.size());
+
 	// Play the forced opening moves first
 	for (int i = 0; i < m_moves.size(); i++)
 	{
 		Chess::Move move(m_moves.at(i));
 		Q_ASSERT(m_board->isLegalMove(move));
-		
-		addPgnMove(move, "book");
+
+		// A shared opening was formatted in advance
+		if (!m_opening.isNull() && i < m_opening->pgnMoves.size())
+		{
+			PgnGame::MoveData md(m_opening->pgnMoves.at(i));
+			md.evaluation = bookEval;
+			addPgnMove(md);
+		}
+		else
+			addPgnMove(move, bookEval);
 
 		playerToMove()->makeBookMove(move);
 		playerToWait()->makeMove(move);
@@ -766,5 +1092,6 @@ void ChessGame::startGame()
 				this, SLOT(resume()));
 	}
 	
+	publishSnapshot();
 	startTurn();
 }
@@ -23,16 +23,25 @@
 #include <QStringList>
 #include <QMap>
 #include <QSemaphore>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QElapsedTimer>
 #include "pgngame.h"
 #include "board/result.h"
 #include "board/move.h"
 #include "timecontrol.h"
 #include "gameadjudicator.h"
+#include "moveevaluation.h"
+#include "moveevent.h"
+#include "latencyhistogram.h"
+#include "resourceusage.h"
+#include "chessplayer.h"
+#include "randomstream.h"
 
 namespace Chess { class Board; }
 class ChessPlayer;
 class OpeningBook;
-class MoveEvaluation;
+class LoadMonitor;
 
 
 class LIB_EXPORT ChessGame : public QObject
@@ -40,6 +49,48 @@ class LIB_EXPORT ChessGame : public QObject
 	Q_OBJECT
 
 	public:
+		// An opening that was validated and formatted once, and is
+		// shared read-only by the games that repeat it
+		struct Opening
+		{
+			QString startingFen;
+			QVector<Chess::Move> moves;
+			// The PGN data of the moves, without the evaluation
+			QVector<PgnGame::MoveData> pgnMoves;
+		};
+		typedef QSharedPointer<const Opening> SharedOpening;
+
+		// The state of the game after a ply, published for readers
+		// in other threads; see snapshot()
+		struct Snapshot
+		{
+			// Increases with every snapshot of the game
+			int version;
+			// The PGN of the game so far, without a tag receiver
+			PgnGame pgn;
+			QString fen;
+			Chess::Side sideToMove;
+			// Engine scores by ply, like scores()
+			QMap<int,int> scores;
+			// The clocks when the snapshot was published
+			int timeLeft[2];
+			bool infiniteTime[2];
+			// The side whose clock is running, or NoSide
+			Chess::Side thinkingSide;
+			qint64 timestamp;
+			bool finished;
+
+			// The time left of \a side now, counting the time since
+			// the snapshot on the running clock
+			int currentTimeLeft(Chess::Side side) const;
+		};
+		typedef QSharedPointer<const Snapshot> SharedSnapshot;
+
+		// Makes the games started after this call publish a
+		// snapshot of their state after every ply. Disabled by
+		// default, because only a GUI needs them.
+		static void setSnapshotsEnabled(bool enabled);
+
 		ChessGame(Chess::Board* board, PgnGame* pgn, QObject* parent = nullptr);
 		virtual ~ChessGame();
 		
@@ -55,24 +106,64 @@ class LIB_EXPORT ChessGame : public QObject
 		Chess::Board* board() const;
 		QString startingFen() const;
 		const QVector<Chess::Move>& moves() const;
-		const QMap<int,int>& scores() const;
+		QMap<int,int> scores() const;
+		const QVector<MoveEvaluation>& evaluations() const;
 		Chess::Result result() const;
+		const GameAdjudicator& adjudicator() const;
+		LatencyHistogram relayLatency(Chess::Side side) const;
+		LatencyHistogram clockOverhead(Chess::Side side) const;
+		ChessPlayer::PonderStats ponderStats(Chess::Side side) const;
+		ResourceUsage resourceUsage(Chess::Side side) const;
+		// Approximate bytes used by the game's move history,
+		// not counting the board and the players
+		qint64 memoryUsage() const;
 
 		void setError(const QString& message);
 		void setPlayer(Chess::Side side, ChessPlayer* player);
 		void setStartingFen(const QString& fen);
 		void setTimeControl(const TimeControl& timeControl,
 				    Chess::Side side = Chess::Side());
+		// The time control that \a side starts the game with
+		TimeControl timeControl(Chess::Side side) const;
 		void setMoves(const QVector<Chess::Move>& moves);
 		bool setMoves(const PgnGame& pgn);
+		// Uses an opening made by another game's sharedOpening(), so
+		// the moves don't have to be validated and formatted again
+		void setOpening(const SharedOpening& opening);
+		// Returns the current opening moves in a form that can be
+		// shared with other games
+		SharedOpening sharedOpening();
 		void setOpeningBook(const OpeningBook* book,
 				    Chess::Side side = Chess::Side(),
 				    int depth = 1000);
 		void setAdjudicator(const GameAdjudicator& adjudicator);
 		void setStartDelay(int time);
 		void setBookOwnership(bool enabled);
+		// The source of the game's opening book moves, random start
+		// position and random opening moves
+		void setRandomStream(const RandomStream& stream);
+		// The monitor that judges whether the moves were played on
+		// an overloaded host; see LoadMonitor
+		void setLoadMonitor(LoadMonitor* monitor);
+		// Keeps the last \a bytes of the players' debug messages in
+		// the engine log of the game; 0 (the default) keeps none
+		void setEngineLogLimit(int bytes);
+		// The timestamped debug messages of the players
+		QByteArray engineLog() const;
 
 		void generateOpening();
+		void generateRandomMoves(int plies);
+
+		// Returns the last published snapshot, or a null pointer if
+		// there's none yet. Can be called from any thread, and only
+		// holds a lock while copying the pointer. Receivers that
+		// connect to moveMade() before the call can skip the events
+		// whose ply is in the snapshot without missing any move.
+		SharedSnapshot snapshot() const;
+		// Publishes a new snapshot after the game's PGN was changed
+		// in another thread, eg. when a move comment is edited. The
+		// game's thread must be locked with lockThread().
+		void updateSnapshot();
 
 		void lockThread();
 		void unlockThread();
@@ -91,13 +182,8 @@ class LIB_EXPORT ChessGame : public QObject
 	signals:
 		void humanEnabled(bool);
 		void fenChanged(const QString& fenString);
-		void moveMade(const Chess::GenericMove& move,
-			      const QString& sanString,
-			      const QString& comment);
-		void moveChanged(int ply,
-				 const Chess::GenericMove& move,
-				 const QString& sanString,
-				 const QString& comment);
+		void moveMade(const MoveEvent& event);
+		void moveChanged(const MoveEvent& event);
 		void scoreChanged(int ply, int score);
 		void initialized(ChessGame* game = nullptr);
 		void started(ChessGame* game = nullptr);
@@ -114,13 +200,17 @@ class LIB_EXPORT ChessGame : public QObject
 		void onPlayerReady();
 		void syncPlayers();
 		void pauseThread();
+		void onDebugMessage(const QString& data);
 
 	private:
 		Chess::Move bookMove(Chess::Side side);
 		bool resetBoard();
 		void initializePgn();
-		void addPgnMove(const Chess::Move& move, const QString& comment);
+		void addPgnMove(const Chess::Move& move,
+				const MoveEvaluation& evaluation);
+		void addPgnMove(const PgnGame::MoveData& md);
 		void emitLastMove();
+		void publishSnapshot();
 		
 		Chess::Board* m_board;
 		ChessPlayer* m_player[2];
@@ -128,6 +218,7 @@ class LIB_EXPORT ChessGame : public QObject
 		const OpeningBook* m_book[2];
 		int m_bookDepth[2];
 		int m_startDelay;
+		RandomStream m_random;
 		bool m_finished;
 		bool m_gameInProgress;
 		bool m_paused;
@@ -138,11 +229,37 @@ class LIB_EXPORT ChessGame : public QObject
 		QString m_startingFen;
 		Chess::Result m_result;
 		QVector<Chess::Move> m_moves;
-		QMap<int,int> m_scores;
+		SharedOpening m_opening;
+		// Engine scores by ply, NULL_SCORE for moves without one
+		QVector<int> m_scores;
+		QVector<MoveEvaluation> m_evaluations;
 		PgnGame* m_pgn;
 		QSemaphore m_pauseSem;
 		QSemaphore m_resumeSem;
+		// The scores of the snapshots, kept up to date by
+		// publishSnapshot() so they aren't rebuilt every ply
+		QMap<int,int> m_snapshotScores;
+		int m_snapshotVersion;
+		mutable QMutex m_snapshotMutex;
+		SharedSnapshot m_snapshot;
 		GameAdjudicator m_adjudicator;
+		LatencyHistogram m_relayLatency[2];
+		LatencyHistogram m_clockOverhead[2];
+		ChessPlayer::PonderStats m_ponderStats[2];
+		ResourceUsage m_startUsage[2];
+		ResourceUsage m_resourceUsage[2];
+		// Engine output lines dropped before the game
+		qint64 m_startDroppedLines[2];
+		qint64 m_moveMemory;
+		LoadMonitor* m_loadMonitor;
+		// Moves with starved nps, and moves on an overloaded host
+		int m_starvedMoves[2];
+		int m_overloadedMoves;
+		// Start of the game for TraceLog, or -1
+		qint64 m_traceStart;
+		int m_engineLogLimit;
+		QByteArray m_engineLog;
+		QElapsedTimer m_engineLogTimer;
 };
 
 #endif // CHESSGAME_H
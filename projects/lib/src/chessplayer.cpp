@@ -19,6 +19,8 @@
 #include "chessplayer.h"
 #include <QTimer>
 #include "board/board.h"
+#include "adaptivemargin.h"
+#include "tracelog.h"
 
 
 ChessPlayer::ChessPlayer(QObject* parent)
@@ -29,9 +31,14 @@ ChessPlayer::ChessPlayer(QObject* parent)
 	  m_validateClaims(true),
 	  m_canPlayAfterTimeout(false),
 	  m_board(nullptr),
-	  m_opponent(nullptr)
+	  m_opponent(nullptr),
+	  m_inputLatency(0),
+	  m_ponderLatency(nullptr),
+	  m_thinkStart(-1)
 {
 	m_timer->setSingleShot(true);
+	// A coarse timer could be late by 5% of the time left
+	m_timer->setTimerType(Qt::PreciseTimer);
 	connect(m_timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
 }
 
@@ -66,6 +73,11 @@ void ChessPlayer::newGame(Chess::Side side, ChessPlayer* opponent, Chess::Board*
 	m_board = board;
 	m_side = side;
 	m_timeControl.initialize();
+	m_moveTimer.invalidate();
+	m_relayLatency.clear();
+	m_clockOverhead.clear();
+	m_ponderStats = PonderStats();
+	m_ponderLatency = nullptr;
 
 	setState(Observing);
 	startGame();
@@ -81,6 +93,7 @@ void ChessPlayer::endGame(const Chess::Result& result)
 	setState(FinishingGame);
 	m_board = nullptr;
 	m_timer->stop();
+	m_thinkStart = -1;
 	disconnect(this, SIGNAL(ready()), this, SLOT(go()));
 }
 
@@ -102,6 +115,23 @@ void ChessPlayer::go()
 	
 	startClock();
 	startThinking();
+	if (TraceLog::isEnabled())
+		m_thinkStart = TraceLog::timestamp();
+
+	// The opponent's move has now been relayed to this player
+	if (m_opponent != nullptr && m_opponent->m_moveTimer.isValid())
+	{
+		const qint64 latency = m_opponent->m_moveTimer.nsecsElapsed();
+		m_relayLatency.add(latency);
+		if (m_thinkStart >= 0)
+			TraceLog::addEvent("relay", "Relay: " + m_name,
+					   m_thinkStart - latency / 1000,
+					   latency / 1000);
+		if (m_ponderLatency != nullptr)
+			m_ponderLatency->add(latency);
+		m_opponent->m_moveTimer.invalidate();
+	}
+	m_ponderLatency = nullptr;
 }
 
 void ChessPlayer::quit()
@@ -127,10 +157,12 @@ void ChessPlayer::startClock()
 
 	m_timeControl.startTimer();
 
-	if (!m_timeControl.isInfinite())
+	// A clock that runs on nodes can't be timed out by wall time
+	if (!m_timeControl.isInfinite() && m_timeControl.nodesPerMs() == 0)
 	{
-		int t = m_timeControl.timeLeft() + m_timeControl.expiryMargin();
-		m_timer->start(qMax(t, 0) + 200);
+		qint64 t = m_timeControl.timeLeftUsec()
+			   + m_timeControl.expiryMarginUsec();
+		m_timer->start(int((qMax(t, Q_INT64_C(0)) + 999) / 1000) + 200);
 	}
 }
 
@@ -141,6 +173,7 @@ void ChessPlayer::makeBookMove(const Chess::Move& move)
 	m_timeControl.update(false);
 	m_eval.setBookEval(true);
 
+	m_moveTimer.start();
 	emit moveMade(move);
 }
 
@@ -268,10 +301,31 @@ void ChessPlayer::emitMove(const Chess::Move& move)
 	if (m_state == Thinking)
 		setState(Observing);
 
+	// The search time reported by the engine, if any
+	const qint64 searchTime = qint64(m_eval.time()) * 1000;
+
+	if (m_inputTimer.isValid())
+		m_timeControl.stopTimer(m_inputTimer, m_inputLatency);
+	if (m_timeControl.nodesPerMs() > 0)
+		m_timeControl.setMoveNodes(m_eval.nodeCount());
 	m_timeControl.update();
 	m_eval.setTime(m_timeControl.lastMoveTime());
 	m_eval.setIsTrusted(!areClaimsValidated());
 
+	if (m_thinkStart >= 0)
+	{
+		TraceLog::addEventSince("think", m_name, m_thinkStart);
+		m_thinkStart = -1;
+	}
+
+	if (searchTime > 0 && m_timeControl.nodesPerMs() == 0)
+	{
+		qint64 overhead = m_timeControl.lastMoveTimeUsec() - searchTime;
+		m_clockOverhead.add(qMax(overhead, Q_INT64_C(0)) * 1000);
+		if (m_timeControl.adaptiveMargin() != nullptr)
+			m_timeControl.adaptiveMargin()->addLag(overhead);
+	}
+
 	m_timer->stop();
 	if (m_timeControl.expired() && !canPlayAfterTimeout())
 	{
@@ -279,9 +333,62 @@ void ChessPlayer::emitMove(const Chess::Move& move)
 		return;
 	}
 
+	if (m_inputTimer.isValid())
+	{
+		m_moveTimer = m_inputTimer;
+		m_inputTimer.invalidate();
+	}
+	else
+		m_moveTimer.start();
 	emit moveMade(move);
 }
 
+void ChessPlayer::setMoveInputTimer(const QElapsedTimer& timer,
+				    qint64 latency)
+{
+	m_inputTimer = timer;
+	m_inputLatency = latency;
+}
+
+const LatencyHistogram& ChessPlayer::relayLatency() const
+{
+	return m_relayLatency;
+}
+
+const LatencyHistogram& ChessPlayer::clockOverhead() const
+{
+	return m_clockOverhead;
+}
+
+const ChessPlayer::PonderStats& ChessPlayer::ponderStats() const
+{
+	return m_ponderStats;
+}
+
+void ChessPlayer::addPonderResult(bool hit, qint64 ponderTime)
+{
+	if (hit)
+	{
+		m_ponderStats.hitTime.add(ponderTime);
+		m_ponderLatency = &m_ponderStats.hitLatency;
+	}
+	else
+	{
+		m_ponderStats.missTime.add(ponderTime);
+		m_ponderLatency = &m_ponderStats.missLatency;
+	}
+}
+
+ResourceUsage ChessPlayer::resourceUsage() const
+{
+	return ResourceUsage();
+}
+
+qint64 ChessPlayer::droppedLineCount() const
+{
+	return 0;
+}
+
 void ChessPlayer::kill()
 {
 	setState(Disconnected);
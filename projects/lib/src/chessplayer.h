@@ -22,10 +22,13 @@
 #include <QObject>
 #include <QString>
 #include <QVector>
+#include <QElapsedTimer>
 #include "board/result.h"
 #include "board/move.h"
 #include "timecontrol.h"
 #include "moveevaluation.h"
+#include "latencyhistogram.h"
+#include "resourceusage.h"
 class QTimer;
 namespace Chess { class Board; }
 
@@ -52,6 +55,31 @@ class LIB_EXPORT ChessPlayer : public QObject
 			Disconnected	//!< Disconnected or terminated
 		};
 
+		/*! Pondering statistics of a game, in nanoseconds. */
+		struct PonderStats
+		{
+			/*! Time pondered before each ponder hit. */
+			LatencyHistogram hitTime;
+			/*! Time pondered before each ponder miss. */
+			LatencyHistogram missTime;
+			/*! Move relay latencies after the ponder hits. */
+			LatencyHistogram hitLatency;
+			/*!
+			 * Move relay latencies after the ponder misses,
+			 * including the time to stop the ponder search.
+			 */
+			LatencyHistogram missLatency;
+
+			/*! Adds the statistics of \a other to these. */
+			void merge(const PonderStats& other)
+			{
+				hitTime.merge(other.hitTime);
+				missTime.merge(other.missTime);
+				hitLatency.merge(other.hitLatency);
+				missLatency.merge(other.missLatency);
+			}
+		};
+
 		/*! Creates and initializes a new ChessPlayer object. */
 		ChessPlayer(QObject* parent = nullptr);
 		virtual ~ChessPlayer();
@@ -156,6 +184,41 @@ class LIB_EXPORT ChessPlayer : public QObject
 		 */
 		void setCanPlayAfterTimeout(bool enable);
 
+		/*!
+		 * Returns the move relay latencies of the current game.
+		 *
+		 * A relay latency is the time from receiving the opponent's
+		 * move until go() has sent the new position to this player.
+		 * Time spent waiting for the player to become ready is
+		 * included.
+		 */
+		const LatencyHistogram& relayLatency() const;
+		/*!
+		 * Returns the clock overheads of the current game.
+		 *
+		 * A clock overhead is the time measured on the player's
+		 * clock for a move minus the search time the player
+		 * reported for it. Moves without a reported search time
+		 * are not included.
+		 */
+		const LatencyHistogram& clockOverhead() const;
+		/*! Returns the pondering statistics of the current game. */
+		const PonderStats& ponderStats() const;
+		/*!
+		 * Returns the operating system resource usage of the
+		 * player's process since it was started.
+		 *
+		 * The default implementation returns an invalid object.
+		 */
+		virtual ResourceUsage resourceUsage() const;
+		/*!
+		 * Returns the number of output lines the player has
+		 * dropped to stay within its output budget.
+		 *
+		 * The default implementation returns 0.
+		 */
+		virtual qint64 droppedLineCount() const;
+
 
 	public slots:
 		/*!
@@ -261,6 +324,14 @@ class LIB_EXPORT ChessPlayer : public QObject
 		 */
 		virtual bool canPlayAfterTimeout() const;
 
+		/*!
+		 * Records a ponder hit if \a hit is true, or a ponder miss
+		 * otherwise, after pondering for \a ponderTime nanoseconds.
+		 * The relay latency of the opponent's move is added to the
+		 * ponder statistics when go() is called.
+		 */
+		void addPonderResult(bool hit, qint64 ponderTime);
+
 		/*! Emits the resultClaim() signal with result \a result. */
 		void claimResult(const Chess::Result& result);
 		/*!
@@ -276,6 +347,19 @@ class LIB_EXPORT ChessPlayer : public QObject
 		 * move came too late.
 		 */
 		void emitMove(const Chess::Move& move);
+
+		/*!
+		 * Tells the player that the input containing its next move
+		 * was received when \a timer was started.
+		 *
+		 * The player's clock is stopped and the next move's relay
+		 * latency is measured from this point instead of from the
+		 * call to emitMove(). \a latency is the network latency in
+		 * microseconds of a remote engine's input, which isn't
+		 * charged to its clock either.
+		 */
+		void setMoveInputTimer(const QElapsedTimer& timer,
+				       qint64 latency = 0);
 		
 		/*! Returns the opposing player. */
 		const ChessPlayer* opponent() const;
@@ -309,6 +393,15 @@ class LIB_EXPORT ChessPlayer : public QObject
 		Chess::Side m_side;
 		Chess::Board* m_board;
 		ChessPlayer* m_opponent;
+		QElapsedTimer m_inputTimer;
+		qint64 m_inputLatency;
+		QElapsedTimer m_moveTimer;
+		LatencyHistogram m_relayLatency;
+		LatencyHistogram m_clockOverhead;
+		PonderStats m_ponderStats;
+		LatencyHistogram* m_ponderLatency;
+		// Start of the current move for TraceLog, or -1
+		qint64 m_thinkStart;
 };
 
 #endif // CHESSPLAYER_H
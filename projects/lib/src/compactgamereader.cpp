@@ -0,0 +1,273 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "compactgamereader.h"
+#include <climits>
+#include <QIODevice>
+#include "compactgamewriter.h"
+#include "pgngame.h"
+#include "board/board.h"
+#include "board/boardfactory.h"
+
+CompactGameReader::CompactGameReader(QIODevice* device)
+	: m_device(device),
+	  m_valid(false),
+	  m_pos(0),
+	  m_board(nullptr)
+{
+	Q_ASSERT(device != nullptr);
+
+	const QByteArray header(CompactGameWriter::fileHeader());
+	m_valid = m_device->read(header.size()) == header;
+}
+
+CompactGameReader::~CompactGameReader()
+{
+	delete m_board;
+}
+
+bool CompactGameReader::isValid() const
+{
+	return m_valid;
+}
+
+bool CompactGameReader::atEnd() const
+{
+	return !m_valid || m_device->atEnd();
+}
+
+bool CompactGameReader::readVarint(quint64* value)
+{
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (m_pos >= m_record.size())
+			return false;
+
+		uchar c = uchar(m_record.at(m_pos++));
+		*value |= quint64(c & 0x7F) << shift;
+		if (!(c & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+bool CompactGameReader::readSigned(int* value)
+{
+	quint64 tmp;
+	if (!readVarint(&tmp))
+		return false;
+
+	*value = int(qint64(tmp >> 1) ^ -qint64(tmp & 1));
+	return true;
+}
+
+bool CompactGameReader::readString(QString* str)
+{
+	quint64 size;
+	if (!readVarint(&size) || size > quint64(m_record.size() - m_pos))
+		return false;
+
+	*str = QString::fromUtf8(m_record.constData() + m_pos, int(size));
+	m_pos += int(size);
+	return true;
+}
+
+bool CompactGameReader::readEvaluation(MoveEvaluation* eval, QString* comment)
+{
+	quint64 flags;
+	if (!readVarint(&flags))
+		return false;
+
+	eval->setBookEval(flags & CompactGameWriter::BookMove);
+	eval->setIsTrusted(flags & CompactGameWriter::TrustedEvaluation);
+
+	if (flags & CompactGameWriter::HasEvaluation)
+	{
+		quint64 fields;
+		if (!readVarint(&fields))
+			return false;
+
+		int value;
+		quint64 count;
+		if (fields & CompactGameWriter::ScoreField)
+		{
+			if (!readSigned(&value))
+				return false;
+			eval->setScore(value);
+		}
+		if (fields & CompactGameWriter::DepthField)
+		{
+			if (!readSigned(&value))
+				return false;
+			eval->setDepth(value);
+		}
+		if (fields & CompactGameWriter::SelectiveDepthField)
+		{
+			if (!readSigned(&value))
+				return false;
+			eval->setSelectiveDepth(value);
+		}
+		if (fields & CompactGameWriter::TimeField)
+		{
+			if (!readSigned(&value))
+				return false;
+			eval->setTime(value);
+		}
+		if (fields & CompactGameWriter::NodeCountField)
+		{
+			if (!readVarint(&count))
+				return false;
+			eval->setNodeCount(count);
+		}
+		if (fields & CompactGameWriter::NpsField)
+		{
+			if (!readVarint(&count))
+				return false;
+			eval->setNps(count);
+		}
+		if (fields & CompactGameWriter::TbHitsField)
+		{
+			if (!readVarint(&count))
+				return false;
+			eval->setTbHits(count);
+		}
+		if (fields & CompactGameWriter::HashUsageField)
+		{
+			if (!readSigned(&value))
+				return false;
+			eval->setHashUsage(value);
+		}
+		if (fields & CompactGameWriter::PonderhitRateField)
+		{
+			if (!readSigned(&value))
+				return false;
+			eval->setPonderhitRate(value);
+		}
+		if (fields & CompactGameWriter::PvNumberField)
+		{
+			if (!readSigned(&value))
+				return false;
+			eval->setPvNumber(value);
+		}
+	}
+
+	if (flags & CompactGameWriter::HasComment)
+		return readString(comment);
+
+	*comment = eval->pgnComment();
+	return true;
+}
+
+bool CompactGameReader::resetBoard(const PgnGame& game)
+{
+	// The board is reused to save an allocation per game
+	const QString variant(game.variant());
+	if (m_board == nullptr || m_board->variant() != variant)
+	{
+		delete m_board;
+		m_board = Chess::BoardFactory::create(variant);
+		if (m_board == nullptr)
+			return false;
+	}
+
+	const QString fen(game.startingFenString());
+	if (!fen.isEmpty())
+		return m_board->setFenString(fen);
+	if (m_board->isRandomVariant())
+		return false;
+
+	m_board->reset();
+	return true;
+}
+
+bool CompactGameReader::read(PgnGame* game, QVector<MoveEvaluation>* evaluations)
+{
+	Q_ASSERT(game != nullptr);
+
+	if (!m_valid)
+		return false;
+
+	// The size of the record
+	quint64 size = 0;
+	char c;
+	for (int shift = 0; ; shift += 7)
+	{
+		if (shift >= 64 || !m_device->getChar(&c))
+			return false;
+		size |= quint64(uchar(c) & 0x7F) << shift;
+		if (!(uchar(c) & 0x80))
+			break;
+	}
+	if (size > INT_MAX)
+		return false;
+
+	m_record = m_device->read(qint64(size));
+	m_pos = 0;
+	if (m_record.size() != int(size))
+		return false;
+
+	game->clear();
+	if (evaluations != nullptr)
+		evaluations->clear();
+
+	quint64 count;
+	if (!readVarint(&count))
+		return false;
+	for (quint64 i = 0; i < count; i++)
+	{
+		QString tag;
+		QString value;
+		if (!readString(&tag) || !readString(&value))
+			return false;
+		game->setTag(tag, value);
+	}
+
+	if (!resetBoard(*game) || !readVarint(&count))
+		return false;
+
+	Chess::MoveList legalMoves;
+	for (quint64 i = 0; i < count; i++)
+	{
+		if (m_pos + 2 > m_record.size())
+			return false;
+		int index = uchar(m_record.at(m_pos))
+			  | (uchar(m_record.at(m_pos + 1)) << 8);
+		m_pos += 2;
+
+		m_board->legalMoves(legalMoves);
+		if (index >= legalMoves.size())
+			return false;
+		const Chess::Move move(legalMoves.at(index));
+
+		PgnGame::MoveData md;
+		MoveEvaluation eval;
+		if (!readEvaluation(&eval, &md.comment))
+			return false;
+		md.key = m_board->key();
+		md.move = m_board->genericMove(move);
+		md.moveString = m_board->moveString(move, Chess::Board::StandardAlgebraic);
+
+		game->addMove(md, false);
+		if (evaluations != nullptr)
+			evaluations->append(eval);
+		m_board->makeMove(move);
+	}
+
+	return true;
+}
@@ -0,0 +1,83 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPACTGAMEREADER_H
+#define COMPACTGAMEREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "moveevaluation.h"
+class QIODevice;
+class PgnGame;
+namespace Chess { class Board; }
+
+/*!
+ * \brief Reads games written by CompactGameWriter.
+ *
+ * The games are converted back to PgnGame objects with the same tags,
+ * moves and move comments. The move evaluations are also available
+ * as MoveEvaluation objects.
+ *
+ * \sa CompactGameWriter
+ */
+class LIB_EXPORT CompactGameReader
+{
+	public:
+		/*!
+		 * Creates a new reader for \a device and reads the
+		 * file header.
+		 */
+		explicit CompactGameReader(QIODevice* device);
+		/*! Destroys the reader. */
+		~CompactGameReader();
+
+		/*!
+		 * Returns true if the device starts with a valid header
+		 * of a supported format version.
+		 */
+		bool isValid() const;
+		/*! Returns true if there are no more games to read. */
+		bool atEnd() const;
+
+		/*!
+		 * Reads the next game into \a game.
+		 *
+		 * If \a evaluations is not null, the move evaluations are
+		 * stored in it.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool read(PgnGame* game,
+			  QVector<MoveEvaluation>* evaluations = nullptr);
+
+	private:
+		Q_DISABLE_COPY(CompactGameReader)
+
+		bool readVarint(quint64* value);
+		bool readSigned(int* value);
+		bool readString(QString* str);
+		bool readEvaluation(MoveEvaluation* eval, QString* comment);
+		bool resetBoard(const PgnGame& game);
+
+		QIODevice* m_device;
+		bool m_valid;
+		QByteArray m_record;
+		int m_pos;
+		Chess::Board* m_board;
+};
+
+#endif // COMPACTGAMEREADER_H
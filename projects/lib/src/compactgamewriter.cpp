@@ -0,0 +1,218 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "compactgamewriter.h"
+#include <QIODevice>
+#include <QScopedPointer>
+#include "pgngame.h"
+#include "board/board.h"
+
+namespace {
+
+void writeVarint(QByteArray* out, quint64 value)
+{
+	while (value >= 0x80)
+	{
+		out->append(char((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out->append(char(value));
+}
+
+void writeSigned(QByteArray* out, qint64 value)
+{
+	// Zigzag encoding keeps small negative values short
+	writeVarint(out, (quint64(value) << 1) ^ quint64(value >> 63));
+}
+
+void writeString(QByteArray* out, const QString& str)
+{
+	const QByteArray utf8(str.toUtf8());
+	writeVarint(out, quint64(utf8.size()));
+	out->append(utf8);
+}
+
+} // anonymous namespace
+
+QByteArray CompactGameWriter::fileHeader()
+{
+	QByteArray header("CCGF");
+	header.append(char(FormatVersion));
+	return header;
+}
+
+CompactGameWriter::CompactGameWriter(QIODevice* device)
+	: m_device(nullptr),
+	  m_headerWritten(false)
+{
+	setDevice(device);
+}
+
+QIODevice* CompactGameWriter::device() const
+{
+	return m_device;
+}
+
+void CompactGameWriter::setDevice(QIODevice* device)
+{
+	m_device = device;
+	m_headerWritten = false;
+}
+
+void CompactGameWriter::writeEvaluation(const MoveEvaluation& eval,
+					const QString& comment)
+{
+	int flags = 0;
+	if (eval.isBookEval())
+		flags |= BookMove;
+	if (eval.isTrusted())
+		flags |= TrustedEvaluation;
+
+	int fields = 0;
+	if (eval.score() != MoveEvaluation::NULL_SCORE)
+		fields |= ScoreField;
+	if (eval.depth() != 0)
+		fields |= DepthField;
+	if (eval.selectiveDepth() != 0)
+		fields |= SelectiveDepthField;
+	if (eval.time() != 0)
+		fields |= TimeField;
+	if (eval.nodeCount() != 0)
+		fields |= NodeCountField;
+	if (eval.nps() != 0)
+		fields |= NpsField;
+	if (eval.tbHits() != 0)
+		fields |= TbHitsField;
+	if (eval.hashUsage() != 0)
+		fields |= HashUsageField;
+	if (eval.ponderhitRate() != 0)
+		fields |= PonderhitRateField;
+	if (eval.pvNumber() != 0)
+		fields |= PvNumberField;
+	if (fields != 0)
+		flags |= HasEvaluation;
+
+	// Most comments can be generated from the stored fields
+	MoveEvaluation stored(eval);
+	stored.setPonderMove(QString());
+	stored.setPv(QString());
+	if (comment != stored.pgnComment())
+		flags |= HasComment;
+
+	writeVarint(&m_record, quint64(flags));
+	if (fields != 0)
+	{
+		writeVarint(&m_record, quint64(fields));
+		if (fields & ScoreField)
+			writeSigned(&m_record, eval.score());
+		if (fields & DepthField)
+			writeSigned(&m_record, eval.depth());
+		if (fields & SelectiveDepthField)
+			writeSigned(&m_record, eval.selectiveDepth());
+		if (fields & TimeField)
+			writeSigned(&m_record, eval.time());
+		if (fields & NodeCountField)
+			writeVarint(&m_record, eval.nodeCount());
+		if (fields & NpsField)
+			writeVarint(&m_record, eval.nps());
+		if (fields & TbHitsField)
+			writeVarint(&m_record, eval.tbHits());
+		if (fields & HashUsageField)
+			writeSigned(&m_record, eval.hashUsage());
+		if (fields & PonderhitRateField)
+			writeSigned(&m_record, eval.ponderhitRate());
+		if (fields & PvNumberField)
+			writeSigned(&m_record, eval.pvNumber());
+	}
+	if (flags & HasComment)
+		writeString(&m_record, comment);
+}
+
+bool CompactGameWriter::write(const PgnGame& game,
+			      const QVector<MoveEvaluation>& evaluations)
+{
+	if (m_device == nullptr)
+		return false;
+
+	QScopedPointer<Chess::Board> board(game.createBoard());
+	if (board.isNull())
+		return false;
+
+	m_record.resize(0);
+
+	// PgnGame::tags() fills the missing roster tags with "?"
+	auto tags = game.tags();
+	for (auto it = tags.begin(); it != tags.end(); )
+	{
+		if (it->second == "?")
+			it = tags.erase(it);
+		else
+			++it;
+	}
+	writeVarint(&m_record, quint64(tags.size()));
+	for (const auto& tag : qAsConst(tags))
+	{
+		writeString(&m_record, tag.first);
+		writeString(&m_record, tag.second);
+	}
+
+	const QVector<PgnGame::MoveData>& moves = game.moves();
+	writeVarint(&m_record, quint64(moves.size()));
+
+	Chess::MoveList legalMoves;
+	for (int i = 0; i < moves.size(); i++)
+	{
+		const PgnGame::MoveData& md = moves.at(i);
+		Chess::Move move(board->moveFromGenericMove(md.move));
+
+		board->legalMoves(legalMoves);
+		int index = -1;
+		for (int j = 0; j < legalMoves.size(); j++)
+		{
+			if (legalMoves.at(j) == move)
+			{
+				index = j;
+				break;
+			}
+		}
+		if (index == -1 || index > 0xFFFF)
+		{
+			qWarning("Can't write illegal move %s in compact format",
+				 qUtf8Printable(md.moveString));
+			return false;
+		}
+		m_record.append(char(index & 0xFF));
+		m_record.append(char(index >> 8));
+
+		writeEvaluation(i < evaluations.size() ?
+				evaluations.at(i) : MoveEvaluation(),
+				md.commentText());
+		board->makeMove(move);
+	}
+
+	QByteArray data;
+	if (!m_headerWritten && m_device->size() == 0)
+		data = fileHeader();
+	writeVarint(&data, quint64(m_record.size()));
+	data.append(m_record);
+
+	if (m_device->write(data) != data.size())
+		return false;
+	m_headerWritten = true;
+
+	return true;
+}
@@ -0,0 +1,110 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPACTGAMEWRITER_H
+#define COMPACTGAMEWRITER_H
+
+#include <QByteArray>
+#include <QVector>
+#include "moveevaluation.h"
+class QIODevice;
+class PgnGame;
+
+/*!
+ * \brief Writes games in a compact binary format.
+ *
+ * A compact game file starts with the bytes "CCGF" and a format
+ * version, followed by one record per game. Each record starts with
+ * its size as a varint (little-endian base 128) and contains:
+ * - the PGN tags as length-prefixed UTF-8 strings, so the starting
+ *   position, variant and result are kept
+ * - each move as a 16-bit little-endian index into the list of legal
+ *   moves generated by Chess::Board::legalMoves()
+ * - each move's MoveEvaluation fields as varints, with a bit mask of
+ *   the fields that are set, and the PGN comment only if it can't be
+ *   generated from the evaluation
+ *
+ * Because the move indices depend on the move generator, the format
+ * version changes whenever move generation order changes.
+ *
+ * \sa CompactGameReader
+ */
+class LIB_EXPORT CompactGameWriter
+{
+	public:
+		/*! The current version of the format. */
+		static const int FormatVersion = 1;
+
+		/*! Per-move flags. */
+		enum MoveFlag
+		{
+			HasEvaluation = 0x1,	//!< Evaluation fields follow
+			BookMove = 0x2,		//!< The move is a book move
+			TrustedEvaluation = 0x4,	//!< The evaluation is trusted
+			HasComment = 0x8	//!< A PGN comment follows
+		};
+		/*! The evaluation fields, in the order they are written. */
+		enum EvaluationField
+		{
+			ScoreField = 0x1,
+			DepthField = 0x2,
+			SelectiveDepthField = 0x4,
+			TimeField = 0x8,
+			NodeCountField = 0x10,
+			NpsField = 0x20,
+			TbHitsField = 0x40,
+			HashUsageField = 0x80,
+			PonderhitRateField = 0x100,
+			PvNumberField = 0x200
+		};
+
+		/*! Returns the header of a compact game file. */
+		static QByteArray fileHeader();
+
+		/*! Creates a new writer that writes to \a device. */
+		explicit CompactGameWriter(QIODevice* device = nullptr);
+
+		/*! Returns the output device. */
+		QIODevice* device() const;
+		/*!
+		 * Sets the output device to \a device.
+		 *
+		 * The file header is written first if the device is empty.
+		 */
+		void setDevice(QIODevice* device);
+
+		/*!
+		 * Writes \a game with the move evaluations \a evaluations.
+		 *
+		 * The evaluation of move N is evaluations[N]; moves without
+		 * an evaluation keep only their PGN comment.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool write(const PgnGame& game,
+			   const QVector<MoveEvaluation>& evaluations =
+				QVector<MoveEvaluation>());
+
+	private:
+		void writeEvaluation(const MoveEvaluation& eval,
+				     const QString& comment);
+
+		QIODevice* m_device;
+		bool m_headerWritten;
+		QByteArray m_record;
+};
+
+#endif // COMPACTGAMEWRITER_H
@@ -0,0 +1,209 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "compactpgngame.h"
+#include "board/board.h"
+#include "moveevaluation.h"
+
+namespace {
+
+// Packed moves have 6 bits for each coordinate of the source and
+// target squares and 8 bits for the promotion piece. The coordinates
+// are offset by one so that null squares (eg. the source square of
+// a piece drop) are stored as zero.
+const int s_coordBits = 6;
+const quint32 s_coordMask = (1 << s_coordBits) - 1;
+const int s_promotionBits = 8;
+
+} // anonymous namespace
+
+CompactPgnGame::CompactPgnGame()
+	: m_packed(false)
+{
+}
+
+CompactPgnGame::CompactPgnGame(const PgnGame& game)
+	: m_header(game),
+	  m_packed(false)
+{
+	m_header.setTagReceiver(nullptr);
+
+	// Games that can't be replayed on a board stay as they are
+	Chess::Board* board = game.createBoard();
+	if (board == nullptr)
+		return;
+	delete board;
+
+	const QVector<PgnGame::MoveData>& moves = game.m_moves;
+	QVector<Move> packedMoves;
+	packedMoves.reserve(moves.size());
+	for (int i = 0; i < moves.size(); i++)
+	{
+		const PgnGame::MoveData& md = moves.at(i);
+		Move move = { 0, MoveEvaluation::NULL_SCORE, 0, 0, 0 };
+		if (!packMove(md.move, &move.move))
+			return;
+
+		// The evaluation is stored as numbers only if it
+		// regenerates the exact same comment
+		const QString comment(md.commentText());
+		const MoveEvaluation eval(MoveEvaluation::fromPgnComment(comment));
+		if (eval.pgnComment() == comment
+		&&  eval.depth() >= 0 && eval.depth() <= 0xFFFF
+		&&  eval.time() >= 0)
+		{
+			move.score = eval.score();
+			move.time = eval.time();
+			move.depth = quint16(eval.depth());
+			if (eval.isBookEval())
+				move.flags |= BookEval;
+		}
+		else
+		{
+			move.flags |= TextComment;
+			m_comments.append(qMakePair(i, comment));
+		}
+		packedMoves.append(move);
+	}
+
+	m_moves = packedMoves;
+	m_header.m_moves.clear();
+	m_header.m_moves.squeeze();
+	m_packed = true;
+}
+
+bool CompactPgnGame::isNull() const
+{
+	return m_header.isNull() && m_moves.isEmpty();
+}
+
+int CompactPgnGame::moveCount() const
+{
+	if (!m_packed)
+		return m_header.m_moves.size();
+	return m_moves.size();
+}
+
+int CompactPgnGame::memoryUsage() const
+{
+	int size = int(sizeof(*this)) + m_moves.capacity() * int(sizeof(Move));
+	for (const auto& comment : m_comments)
+		size += int(sizeof(comment)) + comment.second.size() * 2;
+
+	for (const QString& value : m_header.m_standardTags)
+		size += value.size() * 2;
+	const auto& tags = m_header.m_tags;
+	for (auto it = tags.constBegin(); it != tags.constEnd(); ++it)
+		size += (it.key().size() + it.value().size()) * 2 + 64;
+
+	// Unpacked moves
+	for (const auto& md : m_header.m_moves)
+		size += int(sizeof(md))
+			+ (md.moveString.size() + md.comment.size()) * 2;
+
+	return size;
+}
+
+PgnGame CompactPgnGame::toPgnGame() const
+{
+	if (!m_packed)
+		return m_header;
+
+	PgnGame game(m_header);
+	Chess::Board* board = game.createBoard();
+	Q_ASSERT(board != nullptr);
+	game.m_moves.reserve(m_moves.size());
+
+	int commentIndex = 0;
+	for (const Move& move : m_moves)
+	{
+		const Chess::GenericMove genericMove(unpackMove(move.move));
+		const Chess::Move boardMove(board->moveFromGenericMove(genericMove));
+		if (boardMove.isNull())
+		{
+			qWarning("CompactPgnGame: illegal move");
+			break;
+		}
+
+		PgnGame::MoveData md;
+		md.key = board->key();
+		md.move = genericMove;
+		md.moveString = board->moveString(boardMove,
+			Chess::Board::StandardAlgebraic);
+
+		if (move.flags & TextComment)
+		{
+			md.comment = m_comments.at(commentIndex).second;
+			commentIndex++;
+		}
+		else
+		{
+			MoveEvaluation eval;
+			eval.setBookEval(move.flags & BookEval);
+			eval.setScore(move.score);
+			eval.setDepth(move.depth);
+			eval.setTime(move.time);
+			md.comment = eval.pgnComment();
+		}
+
+		game.m_moves.append(md);
+		board->makeMove(boardMove);
+	}
+
+	delete board;
+	return game;
+}
+
+bool CompactPgnGame::packMove(const Chess::GenericMove& move, quint32* packed)
+{
+	const int coords[] = {
+		move.sourceSquare().file(), move.sourceSquare().rank(),
+		move.targetSquare().file(), move.targetSquare().rank()
+	};
+
+	quint32 value = 0;
+	for (int coord : coords)
+	{
+		if (coord < -1 || coord >= int(s_coordMask) - 1)
+			return false;
+		value = (value << s_coordBits) | quint32(coord + 1);
+	}
+
+	const int promotion = move.promotion();
+	if (promotion < 0 || promotion >= (1 << s_promotionBits))
+		return false;
+	*packed = (value << s_promotionBits) | quint32(promotion);
+	return true;
+}
+
+Chess::GenericMove CompactPgnGame::unpackMove(quint32 packed)
+{
+	const int promotion = int(packed & ((1 << s_promotionBits) - 1));
+	packed >>= s_promotionBits;
+
+	int coords[4];
+	for (int i = 3; i >= 0; i--)
+	{
+		coords[i] = int(packed & s_coordMask) - 1;
+		packed >>= s_coordBits;
+	}
+
+	return Chess::GenericMove(Chess::Square(coords[0], coords[1]),
+				  Chess::Square(coords[2], coords[3]),
+				  promotion);
+}
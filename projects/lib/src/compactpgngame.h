@@ -0,0 +1,89 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COMPACTPGNGAME_H
+#define COMPACTPGNGAME_H
+
+#include <QVector>
+#include <QPair>
+#include <QString>
+#include "pgngame.h"
+
+
+/*!
+ * \brief A PGN game packed for keeping many games in memory
+ *
+ * A PgnGame stores every move with its position key, SAN string and
+ * comment, which adds up to a few hundred bytes per move. CompactPgnGame
+ * keeps only the things that can't be recomputed: each move is packed
+ * into 32 bits, and the score, depth and time of its evaluation are
+ * stored as numbers. The position keys and SAN strings are regenerated
+ * by replaying the moves on a board when the game is expanded with
+ * toPgnGame(). Comments that don't follow the MoveEvaluation format
+ * are kept as text.
+ *
+ * The SAN strings of the expanded game are in the board's canonical
+ * form, which can differ from the move strings of a PGN file.
+ *
+ * \sa PgnGame
+ */
+class LIB_EXPORT CompactPgnGame
+{
+	public:
+		/*! Creates a null game. */
+		CompactPgnGame();
+		/*! Creates a compact copy of \a game. */
+		explicit CompactPgnGame(const PgnGame& game);
+
+		/*! Returns true if the game has no tags and no moves. */
+		bool isNull() const;
+		/*! Returns the number of halfmoves in the game. */
+		int moveCount() const;
+		/*! Returns the approximate memory usage of the game in bytes. */
+		int memoryUsage() const;
+
+		/*! Expands the game back to a PgnGame. */
+		PgnGame toPgnGame() const;
+
+	private:
+		enum MoveFlag
+		{
+			BookEval = 0x1,		//!< The move is from an opening book
+			TextComment = 0x2	//!< The comment is in m_comments
+		};
+
+		struct Move
+		{
+			quint32 move;	// Packed GenericMove
+			qint32 score;	// MoveEvaluation::NULL_SCORE if none
+			qint32 time;	// Move time in milliseconds
+			quint16 depth;
+			quint16 flags;
+		};
+
+		static bool packMove(const Chess::GenericMove& move,
+				     quint32* packed);
+		static Chess::GenericMove unpackMove(quint32 packed);
+
+		PgnGame m_header;
+		QVector<Move> m_moves;
+		QVector<QPair<int, QString>> m_comments;
+		bool m_packed;
+};
+
+#endif // COMPACTPGNGAME_H
@@ -0,0 +1,682 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "compressedfile.h"
+#include <cstring>
+#ifdef CUTECHESS_GZIP
+// Fathom's Z_PREFIX would rename the zlib functions, but the system
+// library is built without the prefix
+#undef Z_PREFIX
+#include <zlib.h>
+#endif
+#ifdef CUTECHESS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+const int s_chunkSize = 64 * 1024;
+
+enum FlushMode
+{
+	NoFlush,
+	SyncFlush,
+	FinishFlush
+};
+
+CompressedFile::Compression compressionForHeader(const QByteArray& header)
+{
+	if (header.startsWith("\x1f\x8b"))
+		return CompressedFile::Gzip;
+	if (header.startsWith("\x28\xb5\x2f\xfd"))
+		return CompressedFile::Zstd;
+	return CompressedFile::NoCompression;
+}
+
+} // anonymous namespace
+
+struct CompressedFile::Codec
+{
+	Codec()
+		: writing(false),
+		  inMember(false)
+	{
+		#ifdef CUTECHESS_GZIP
+		std::memset(&zlib, 0, sizeof(zlib));
+		zlibActive = false;
+		#endif
+		#ifdef CUTECHESS_ZSTD
+		zstdOut = nullptr;
+		zstdIn = nullptr;
+		zstdInput.src = nullptr;
+		zstdInput.size = 0;
+		zstdInput.pos = 0;
+		#endif
+	}
+
+	bool writing;
+	// True if a gzip member or a Zstandard frame is incomplete
+	bool inMember;
+	#ifdef CUTECHESS_GZIP
+	z_stream zlib;
+	bool zlibActive;
+	#endif
+	#ifdef CUTECHESS_ZSTD
+	ZSTD_CCtx* zstdOut;
+	ZSTD_DCtx* zstdIn;
+	ZSTD_inBuffer zstdInput;
+	#endif
+};
+
+CompressedFile::CompressedFile(QObject* parent)
+	: QIODevice(parent),
+	  m_compression(NoCompression),
+	  m_level(-1),
+	  m_eof(false),
+	  m_failed(false),
+	  m_codec(nullptr),
+	  m_outputPos(0),
+	  m_outputStart(0)
+{
+}
+
+CompressedFile::CompressedFile(const QString& fileName, QObject* parent)
+	: QIODevice(parent),
+	  m_file(fileName),
+	  m_compression(NoCompression),
+	  m_level(-1),
+	  m_eof(false),
+	  m_failed(false),
+	  m_codec(nullptr),
+	  m_outputPos(0),
+	  m_outputStart(0)
+{
+}
+
+CompressedFile::~CompressedFile()
+{
+	close();
+}
+
+bool CompressedFile::isSupported(Compression compression)
+{
+	switch (compression)
+	{
+	case NoCompression:
+		return true;
+	case Gzip:
+		#ifdef CUTECHESS_GZIP
+		return true;
+		#else
+		return false;
+		#endif
+	case Zstd:
+		#ifdef CUTECHESS_ZSTD
+		return true;
+		#else
+		return false;
+		#endif
+	default:
+		return false;
+	}
+}
+
+CompressedFile::Compression CompressedFile::compressionForFileName(const QString& fileName)
+{
+	if (fileName.endsWith(".gz", Qt::CaseInsensitive))
+		return Gzip;
+	if (fileName.endsWith(".zst", Qt::CaseInsensitive))
+		return Zstd;
+	return NoCompression;
+}
+
+CompressedFile::Compression CompressedFile::detectCompression(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return NoCompression;
+	return compressionForHeader(file.read(4));
+}
+
+QString CompressedFile::fileName() const
+{
+	return m_file.fileName();
+}
+
+void CompressedFile::setFileName(const QString& fileName)
+{
+	m_file.setFileName(fileName);
+}
+
+bool CompressedFile::exists() const
+{
+	return m_file.exists();
+}
+
+CompressedFile::Compression CompressedFile::compression() const
+{
+	return m_compression;
+}
+
+int CompressedFile::compressionLevel() const
+{
+	return m_level;
+}
+
+void CompressedFile::setCompressionLevel(int level)
+{
+	m_level = level;
+}
+
+QFileDevice::FileError CompressedFile::error() const
+{
+	QFileDevice::FileError error = m_file.error();
+	if (error == QFileDevice::NoError && m_failed)
+	{
+		if (openMode() & WriteOnly)
+			return QFileDevice::WriteError;
+		return QFileDevice::ReadError;
+	}
+	return error;
+}
+
+int CompressedFile::handle() const
+{
+	return m_file.handle();
+}
+
+bool CompressedFile::flush()
+{
+	if (!isOpen() || !(openMode() & WriteOnly))
+		return false;
+
+	bool ok = m_compression == NoCompression
+		  || encode(nullptr, 0, SyncFlush);
+	return m_file.flush() && ok;
+}
+
+bool CompressedFile::open(OpenMode mode)
+{
+	if (isOpen())
+	{
+		qWarning("CompressedFile::open: File %s is already open",
+			 qUtf8Printable(fileName()));
+		return false;
+	}
+	if ((mode & ReadWrite) == ReadWrite)
+	{
+		setErrorString(tr("A compressed file can't be opened for "
+				  "reading and writing at the same time"));
+		return false;
+	}
+
+	m_eof = false;
+	m_failed = false;
+	m_outputPos = 0;
+	m_outputStart = 0;
+	m_output.clear();
+	m_input.clear();
+
+	// QIODevice does the text mode conversion
+	if (!m_file.open(mode & ~(Text | Unbuffered)))
+	{
+		setErrorString(m_file.errorString());
+		return false;
+	}
+
+	if (mode & WriteOnly)
+		m_compression = compressionForFileName(fileName());
+	else
+		m_compression = compressionForHeader(m_file.peek(4));
+
+	if (!isSupported(m_compression))
+	{
+		setErrorString(tr("This build does not support the "
+				  "compression of %1").arg(fileName()));
+		m_file.close();
+		return false;
+	}
+	if (m_compression != NoCompression && !initCodec())
+	{
+		m_file.close();
+		return false;
+	}
+
+	// The decompressed data is buffered here, so QIODevice's own
+	// buffer would only get in the way of seeking
+	return QIODevice::open(mode | Unbuffered);
+}
+
+void CompressedFile::close()
+{
+	if (!isOpen())
+		return;
+
+	if (m_codec != nullptr && m_codec->writing)
+		encode(nullptr, 0, FinishFlush);
+	endCodec();
+	m_file.close();
+	m_input.clear();
+	m_output.clear();
+	m_outputPos = 0;
+	m_outputStart = 0;
+
+	QIODevice::close();
+}
+
+bool CompressedFile::isSequential() const
+{
+	return false;
+}
+
+qint64 CompressedFile::size() const
+{
+	if (m_compression == NoCompression)
+		return m_file.size();
+	if (m_codec != nullptr && m_codec->writing)
+		return pos();
+
+	// The size of the data decompressed so far, which is the real
+	// size once the whole file is read
+	return m_outputStart + m_output.size();
+}
+
+bool CompressedFile::seek(qint64 pos)
+{
+	if (pos == QIODevice::pos())
+		return true;
+
+	if (m_compression == NoCompression)
+		return m_file.seek(pos) && QIODevice::seek(pos);
+	if (m_codec == nullptr || m_codec->writing || pos < 0)
+		return false;
+
+	if (pos < m_outputStart && !rewind())
+		return false;
+	while (pos > m_outputStart + m_output.size())
+	{
+		if (m_eof)
+			return false;
+		m_outputPos = m_output.size();
+		if (!decodeChunk())
+			return false;
+	}
+	m_outputPos = int(pos - m_outputStart);
+
+	return QIODevice::seek(pos);
+}
+
+bool CompressedFile::atEnd() const
+{
+	// Find out if there is more data before answering
+	if (m_compression != NoCompression && !m_eof
+	&&  m_codec != nullptr && !m_codec->writing
+	&&  m_outputPos >= m_output.size())
+		const_cast<CompressedFile*>(this)->decodeChunk();
+
+	return QIODevice::atEnd();
+}
+
+qint64 CompressedFile::readData(char* data, qint64 maxSize)
+{
+	if (m_compression == NoCompression)
+		return m_file.read(data, maxSize);
+
+	while (m_outputPos >= m_output.size())
+	{
+		if (m_eof)
+			return 0;
+		if (!decodeChunk())
+			return -1;
+	}
+
+	int n = int(qMin(maxSize, qint64(m_output.size() - m_outputPos)));
+	std::memcpy(data, m_output.constData() + m_outputPos, size_t(n));
+	m_outputPos += n;
+
+	return n;
+}
+
+qint64 CompressedFile::readLineData(char* data, qint64 maxSize)
+{
+	// QIODevice::readLine() leaves room for the terminating null
+	if (m_compression == NoCompression)
+		return m_file.readLine(data, maxSize + 1);
+
+	qint64 n = 0;
+	while (n < maxSize)
+	{
+		if (m_outputPos >= m_output.size())
+		{
+			if (m_eof)
+				break;
+			if (!decodeChunk())
+				return n > 0 ? n : -1;
+			continue;
+		}
+
+		const char* start = m_output.constData() + m_outputPos;
+		int count = int(qMin(maxSize - n,
+				     qint64(m_output.size() - m_outputPos)));
+		const char* end = static_cast<const char*>(
+			std::memchr(start, '\n', size_t(count)));
+		if (end != nullptr)
+			count = int(end - start) + 1;
+
+		std::memcpy(data + n, start, size_t(count));
+		n += count;
+		m_outputPos += count;
+
+		if (end != nullptr)
+			break;
+	}
+
+	return n;
+}
+
+qint64 CompressedFile::writeData(const char* data, qint64 maxSize)
+{
+	if (m_compression == NoCompression)
+		return m_file.write(data, maxSize);
+
+	if (!encode(data, maxSize, NoFlush))
+		return -1;
+	return maxSize;
+}
+
+bool CompressedFile::fail(const QString& error)
+{
+	m_failed = true;
+	m_eof = true;
+	setErrorString(error);
+	qWarning("%s: %s", qUtf8Printable(fileName()), qUtf8Printable(error));
+
+	return false;
+}
+
+bool CompressedFile::initCodec()
+{
+	endCodec();
+	m_codec = new Codec;
+	m_codec->writing = (m_file.openMode() & WriteOnly) != 0;
+
+	bool ok = false;
+	#ifdef CUTECHESS_GZIP
+	if (m_compression == Gzip)
+	{
+		z_stream& z = m_codec->zlib;
+		int level = m_level < 0 ? Z_DEFAULT_COMPRESSION
+					: qBound(1, m_level, 9);
+
+		// Gzip headers
+		const int windowBits = 16 + MAX_WBITS;
+		int ret = m_codec->writing ?
+			  deflateInit2(&z, level, Z_DEFLATED, windowBits,
+				       8, Z_DEFAULT_STRATEGY) :
+			  inflateInit2(&z, windowBits);
+		m_codec->zlibActive = ret == Z_OK;
+		ok = m_codec->zlibActive;
+	}
+	#endif
+	#ifdef CUTECHESS_ZSTD
+	if (m_compression == Zstd)
+	{
+		if (m_codec->writing)
+		{
+			m_codec->zstdOut = ZSTD_createCCtx();
+			int level = m_level < 0 ? ZSTD_CLEVEL_DEFAULT : m_level;
+			ok = m_codec->zstdOut != nullptr
+			  && !ZSTD_isError(ZSTD_CCtx_setParameter(m_codec->zstdOut,
+					ZSTD_c_compressionLevel, level));
+		}
+		else
+		{
+			m_codec->zstdIn = ZSTD_createDCtx();
+			ok = m_codec->zstdIn != nullptr;
+		}
+	}
+	#endif
+
+	if (!ok)
+	{
+		endCodec();
+		return fail(tr("Could not initialize the compression library"));
+	}
+	return true;
+}
+
+void CompressedFile::endCodec()
+{
+	if (m_codec == nullptr)
+		return;
+
+	#ifdef CUTECHESS_GZIP
+	if (m_codec->zlibActive)
+	{
+		if (m_codec->writing)
+			deflateEnd(&m_codec->zlib);
+		else
+			inflateEnd(&m_codec->zlib);
+	}
+	#endif
+	#ifdef CUTECHESS_ZSTD
+	ZSTD_freeCCtx(m_codec->zstdOut);
+	ZSTD_freeDCtx(m_codec->zstdIn);
+	#endif
+
+	delete m_codec;
+	m_codec = nullptr;
+}
+
+bool CompressedFile::rewind()
+{
+	if (!m_file.seek(0))
+		return fail(m_file.errorString());
+
+	m_eof = false;
+	m_input.clear();
+	m_output.clear();
+	m_outputPos = 0;
+	m_outputStart = 0;
+
+	return initCodec();
+}
+
+bool CompressedFile::decodeChunk()
+{
+	Q_ASSERT(m_codec != nullptr);
+
+	m_outputStart += m_output.size();
+	m_output.resize(s_chunkSize);
+	m_outputPos = 0;
+
+	int produced = 0;
+	while (produced == 0)
+	{
+		bool hasInput = false;
+		#ifdef CUTECHESS_GZIP
+		if (m_compression == Gzip)
+			hasInput = m_codec->zlib.avail_in > 0;
+		#endif
+		#ifdef CUTECHESS_ZSTD
+		if (m_compression == Zstd)
+			hasInput = m_codec->zstdInput.pos < m_codec->zstdInput.size;
+		#endif
+
+		if (!hasInput)
+		{
+			m_input.resize(s_chunkSize);
+			qint64 n = m_file.read(m_input.data(), s_chunkSize);
+			if (n < 0)
+			{
+				m_output.resize(0);
+				return fail(m_file.errorString());
+			}
+			m_input.resize(int(n));
+			if (n == 0)
+			{
+				if (m_codec->inMember)
+					qWarning("Compressed file %s is truncated",
+						 qUtf8Printable(fileName()));
+				m_eof = true;
+				break;
+			}
+
+			#ifdef CUTECHESS_GZIP
+			m_codec->zlib.next_in = reinterpret_cast<Bytef*>(m_input.data());
+			m_codec->zlib.avail_in = uInt(n);
+			#endif
+			#ifdef CUTECHESS_ZSTD
+			m_codec->zstdInput.src = m_input.constData();
+			m_codec->zstdInput.size = size_t(n);
+			m_codec->zstdInput.pos = 0;
+			#endif
+		}
+
+		QString error = tr("Unsupported compression");
+		bool ok = false;
+		#ifdef CUTECHESS_GZIP
+		if (m_compression == Gzip)
+		{
+			z_stream& z = m_codec->zlib;
+			z.next_out = reinterpret_cast<Bytef*>(m_output.data());
+			z.avail_out = uInt(s_chunkSize);
+
+			int ret = inflate(&z, Z_NO_FLUSH);
+			produced = s_chunkSize - int(z.avail_out);
+			if (ret == Z_STREAM_END)
+			{
+				// The next member may follow
+				m_codec->inMember = false;
+				ok = inflateReset(&z) == Z_OK;
+			}
+			else if (ret == Z_OK || ret == Z_BUF_ERROR)
+			{
+				m_codec->inMember = true;
+				ok = true;
+			}
+			else if (z.msg != nullptr)
+				error = QString::fromLatin1(z.msg);
+		}
+		#endif
+		#ifdef CUTECHESS_ZSTD
+		if (m_compression == Zstd)
+		{
+			ZSTD_outBuffer out = { m_output.data(), size_t(s_chunkSize), 0 };
+			size_t ret = ZSTD_decompressStream(m_codec->zstdIn, &out,
+							   &m_codec->zstdInput);
+			produced = int(out.pos);
+			if (ZSTD_isError(ret))
+				error = QString::fromLatin1(ZSTD_getErrorName(ret));
+			else
+			{
+				m_codec->inMember = ret != 0;
+				ok = true;
+			}
+		}
+		#endif
+
+		if (!ok)
+		{
+			m_output.resize(0);
+			return fail(error);
+		}
+	}
+
+	m_output.resize(produced);
+	return true;
+}
+
+bool CompressedFile::encode(const char* data, qint64 size, int flush)
+{
+	Q_ASSERT(m_codec != nullptr);
+
+	if (m_failed)
+		return false;
+	m_output.resize(s_chunkSize);
+
+	#ifdef CUTECHESS_GZIP
+	if (m_compression == Gzip)
+	{
+		z_stream& z = m_codec->zlib;
+		int mode = Z_NO_FLUSH;
+		if (flush == SyncFlush)
+			mode = Z_SYNC_FLUSH;
+		else if (flush == FinishFlush)
+			mode = Z_FINISH;
+
+		qint64 left = size;
+		do
+		{
+			uInt n = uInt(qMin(left, qint64(1 << 30)));
+			z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+			z.avail_in = n;
+			data += n;
+			left -= n;
+
+			do
+			{
+				z.next_out = reinterpret_cast<Bytef*>(m_output.data());
+				z.avail_out = uInt(s_chunkSize);
+				if (deflate(&z, left > 0 ? Z_NO_FLUSH : mode) == Z_STREAM_ERROR)
+					return fail(tr("Compression failed"));
+
+				qint64 count = s_chunkSize - qint64(z.avail_out);
+				if (count > 0 && m_file.write(m_output.constData(), count) != count)
+					return fail(m_file.errorString());
+			}
+			while (z.avail_out == 0);
+		}
+		while (left > 0);
+
+		return true;
+	}
+	#endif
+	#ifdef CUTECHESS_ZSTD
+	if (m_compression == Zstd)
+	{
+		ZSTD_EndDirective mode = ZSTD_e_continue;
+		if (flush == SyncFlush)
+			mode = ZSTD_e_flush;
+		else if (flush == FinishFlush)
+			mode = ZSTD_e_end;
+
+		ZSTD_inBuffer in = { data, size_t(size), 0 };
+		for (;;)
+		{
+			ZSTD_outBuffer out = { m_output.data(), size_t(s_chunkSize), 0 };
+			size_t left = ZSTD_compressStream2(m_codec->zstdOut, &out, &in, mode);
+			if (ZSTD_isError(left))
+				return fail(QString::fromLatin1(ZSTD_getErrorName(left)));
+
+			qint64 count = qint64(out.pos);
+			if (count > 0 && m_file.write(m_output.constData(), count) != count)
+				return fail(m_file.errorString());
+
+			if (mode == ZSTD_e_continue ? in.pos == in.size : left == 0)
+				break;
+		}
+
+		return true;
+	}
+	#endif
+
+	Q_UNUSED(data);
+	Q_UNUSED(size);
+	Q_UNUSED(flush);
+	return fail(tr("Unsupported compression"));
+}
@@ -0,0 +1,154 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPRESSEDFILE_H
+#define COMPRESSEDFILE_H
+
+#include <QIODevice>
+#include <QFile>
+#include <QByteArray>
+
+/*!
+ * \brief A file that is transparently compressed with gzip or Zstandard
+ *
+ * When a CompressedFile is opened for reading, the compression of the
+ * file is detected from its first bytes, and the file is decompressed
+ * in small chunks while it's being read. Files that are not compressed
+ * are read as they are. When the file is opened for writing, the
+ * compression is selected by the file name suffix (".gz" or ".zst").
+ * Appending to a compressed file adds a new gzip member or Zstandard
+ * frame, and both formats allow concatenated members.
+ *
+ * A compressed file can be read from any position, but seeking
+ * backwards starts the decompression again from the beginning of
+ * the file, so random access into a large file is slow.
+ *
+ * Gzip support requires a library built with "CONFIG+=gzip" and
+ * Zstandard support one built with "CONFIG+=zstd".
+ */
+class LIB_EXPORT CompressedFile : public QIODevice
+{
+	Q_OBJECT
+
+	public:
+		/*! The compression format of a file. */
+		enum Compression
+		{
+			NoCompression,	//!< Plain, uncompressed file
+			Gzip,		//!< Gzip (deflate) compression
+			Zstd		//!< Zstandard compression
+		};
+
+		/*! Creates a new CompressedFile with \a parent. */
+		explicit CompressedFile(QObject* parent = nullptr);
+		/*! Creates a new CompressedFile for file \a fileName. */
+		explicit CompressedFile(const QString& fileName,
+					QObject* parent = nullptr);
+		/*! Closes the file and destroys the CompressedFile. */
+		virtual ~CompressedFile();
+
+		/*!
+		 * Returns true if this build of the library supports
+		 * \a compression; otherwise returns false.
+		 */
+		static bool isSupported(Compression compression);
+		/*!
+		 * Returns the compression that is used for writing to
+		 * \a fileName, based on its suffix.
+		 */
+		static Compression compressionForFileName(const QString& fileName);
+		/*!
+		 * Returns the compression of the existing file \a fileName,
+		 * based on its contents.
+		 */
+		static Compression detectCompression(const QString& fileName);
+
+		/*! Returns the name of the file. */
+		QString fileName() const;
+		/*!
+		 * Sets the name of the file to \a fileName.
+		 *
+		 * The file must be closed.
+		 */
+		void setFileName(const QString& fileName);
+		/*! Returns true if the file exists. */
+		bool exists() const;
+		/*! Returns the file's current compression. */
+		Compression compression() const;
+
+		/*!
+		 * Returns the compression level used for writing, or -1 for
+		 * the library's default level (the default).
+		 */
+		int compressionLevel() const;
+		/*!
+		 * Sets the compression level to \a level.
+		 *
+		 * Gzip uses levels from 1 to 9 and Zstandard from 1 to 19.
+		 * The level takes effect when the file is opened.
+		 */
+		void setCompressionLevel(int level);
+
+		/*! Returns the file error status. */
+		QFileDevice::FileError error() const;
+		/*! Returns the file handle of the underlying file. */
+		int handle() const;
+		/*!
+		 * Writes all pending compressed data to the file in a way
+		 * that lets a reader decompress everything written so far.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool flush();
+
+		// Inherited from QIODevice
+		virtual bool open(OpenMode mode);
+		virtual void close();
+		virtual bool isSequential() const;
+		virtual qint64 size() const;
+		virtual bool seek(qint64 pos);
+		virtual bool atEnd() const;
+
+	protected:
+		// Inherited from QIODevice
+		virtual qint64 readData(char* data, qint64 maxSize);
+		virtual qint64 readLineData(char* data, qint64 maxSize);
+		virtual qint64 writeData(const char* data, qint64 maxSize);
+
+	private:
+		struct Codec;
+
+		bool initCodec();
+		void endCodec();
+		bool rewind();
+		bool decodeChunk();
+		bool encode(const char* data, qint64 size, int flush);
+		bool fail(const QString& error);
+
+		QFile m_file;
+		Compression m_compression;
+		int m_level;
+		bool m_eof;
+		bool m_failed;
+		Codec* m_codec;
+		QByteArray m_input;
+		QByteArray m_output;
+		int m_outputPos;
+		qint64 m_outputStart;
+};
+
+#endif // COMPRESSEDFILE_H
@@ -0,0 +1,370 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "cpuallocator.h"
+#include <QThread>
+#include <QDir>
+#include <QFile>
+#include <QSet>
+
+#if defined(Q_OS_WIN32)
+  #include <windows.h>
+#elif defined(Q_OS_LINUX)
+  #include <sched.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// Parses a Linux CPU list such as "0-7,16-23"
+QList<int> parseCpuList(const QByteArray& str)
+{
+	QList<int> cpus;
+	const auto ranges = str.trimmed().split(',');
+	for (const QByteArray& range : ranges)
+	{
+		const int sep = range.indexOf('-');
+		bool ok1 = false;
+		bool ok2 = false;
+		int first = range.left(sep).toInt(&ok1);
+		int last = sep == -1 ? first : range.mid(sep + 1).toInt(&ok2);
+		if (!ok1 || (sep != -1 && !ok2))
+			continue;
+
+		for (int cpu = first; cpu <= last; cpu++)
+			cpus << cpu;
+	}
+
+	return cpus;
+}
+#endif // Q_OS_LINUX
+
+QList<int> availableCpus()
+{
+	QList<int> cpus;
+
+#if defined(Q_OS_LINUX)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0)
+	{
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		{
+			if (CPU_ISSET(cpu, &set))
+				cpus << cpu;
+		}
+	}
+#elif defined(Q_OS_WIN32)
+	DWORD_PTR processMask = 0;
+	DWORD_PTR systemMask = 0;
+	if (GetProcessAffinityMask(GetCurrentProcess(),
+				   &processMask, &systemMask))
+	{
+		for (int cpu = 0; cpu < int(sizeof(DWORD_PTR) * 8); cpu++)
+		{
+			if (processMask & (DWORD_PTR(1) << cpu))
+				cpus << cpu;
+		}
+	}
+#endif
+
+	if (cpus.isEmpty())
+	{
+		for (int cpu = 0; cpu < QThread::idealThreadCount(); cpu++)
+			cpus << cpu;
+	}
+
+	return cpus;
+}
+
+// Returns an identifier of the physical core that runs \a cpu
+int physicalCore(int cpu)
+{
+#if defined(Q_OS_LINUX)
+	QFile file(QString("/sys/devices/system/cpu/cpu%1/topology/thread_siblings_list")
+		   .arg(cpu));
+	if (file.open(QIODevice::ReadOnly))
+	{
+		const auto siblings = parseCpuList(file.readAll());
+		if (!siblings.isEmpty())
+			return siblings.first();
+	}
+#elif defined(Q_OS_WIN32)
+	DWORD size = 0;
+	GetLogicalProcessorInformation(nullptr, &size);
+	QVector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(
+		int(size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION)));
+	if (cpu < int(sizeof(ULONG_PTR) * 8)
+	&&  !info.isEmpty()
+	&&  GetLogicalProcessorInformation(info.data(), &size))
+	{
+		for (const auto& item : qAsConst(info))
+		{
+			const ULONG_PTR mask = item.ProcessorMask;
+			if (item.Relationship != RelationProcessorCore
+			||  !(mask & (ULONG_PTR(1) << cpu)))
+				continue;
+
+			// The lowest CPU of the core identifies it
+			for (int i = 0; i < int(sizeof(ULONG_PTR) * 8); i++)
+			{
+				if (mask & (ULONG_PTR(1) << i))
+					return i;
+			}
+		}
+	}
+#endif
+
+	return cpu;
+}
+
+} // anonymous namespace
+
+CpuAllocator::CpuAllocator(int coresPerEngine,
+			   const QList< QList<int> >& cpuGroups)
+	: m_coresPerEngine(coresPerEngine),
+	  m_next(0)
+{
+	Q_ASSERT(coresPerEngine > 0);
+
+	// A group smaller than a game still gets one slot whose
+	// cores are shared by the players
+	const int gameSize = 2 * coresPerEngine;
+	int maxSlots = 0;
+	for (const auto& group : cpuGroups)
+		maxSlots = qMax(maxSlots, qMax(1, group.size() / gameSize));
+
+	for (int i = 0; i < maxSlots; i++)
+	{
+		for (const auto& group : cpuGroups)
+		{
+			if (group.isEmpty()
+			||  i >= qMax(1, group.size() / gameSize))
+				continue;
+
+			Slot slot;
+			slot.users = 0;
+			for (int j = 0; j < 2; j++)
+			{
+				const int first = i * gameSize + j * coresPerEngine;
+				for (int k = 0; k < coresPerEngine; k++)
+					slot.cpus[j] << group.at((first + k) % group.size());
+			}
+			m_slots << slot;
+		}
+	}
+}
+
+int CpuAllocator::coresPerEngine() const
+{
+	return m_coresPerEngine;
+}
+
+int CpuAllocator::slotCount() const
+{
+	return m_slots.size();
+}
+
+int CpuAllocator::acquire()
+{
+	if (m_slots.isEmpty())
+		return -1;
+
+	int best = -1;
+	for (int i = 0; i < m_slots.size(); i++)
+	{
+		const int slot = (m_next + i) % m_slots.size();
+		if (best == -1 || m_slots[slot].users < m_slots[best].users)
+			best = slot;
+		if (m_slots[best].users == 0)
+			break;
+	}
+
+	if (m_slots[best].users > 0)
+	{
+		static bool warned = false;
+		if (!warned)
+		{
+			warned = true;
+			qWarning("Not enough CPUs for %d cores per engine, "
+				 "some games will share their cores",
+				 m_coresPerEngine);
+		}
+	}
+
+	m_slots[best].users++;
+	m_next = (best + 1) % m_slots.size();
+	return best;
+}
+
+void CpuAllocator::release(int slot)
+{
+	Q_ASSERT(slot >= 0 && slot < m_slots.size());
+	Q_ASSERT(m_slots[slot].users > 0);
+
+	m_slots[slot].users--;
+}
+
+QList<int> CpuAllocator::cpus(int slot, int index) const
+{
+	Q_ASSERT(slot >= 0 && slot < m_slots.size());
+	Q_ASSERT(index == 0 || index == 1);
+
+	return m_slots.at(slot).cpus[index];
+}
+
+QList< QList<int> > CpuAllocator::cpuGroups(bool byNumaNode)
+{
+	const QList<int> cpus = availableCpus();
+	QList< QList<int> > groups;
+
+#ifdef Q_OS_LINUX
+	if (byNumaNode)
+	{
+		QDir dir("/sys/devices/system/node");
+		const auto nodes = dir.entryList(QStringList() << "node*",
+						 QDir::Dirs);
+		for (const QString& node : nodes)
+		{
+			QFile file(dir.filePath(node + "/cpulist"));
+			if (!file.open(QIODevice::ReadOnly))
+				continue;
+
+			// Only the CPUs that we're allowed to use
+			QList<int> group;
+			const auto nodeCpus = parseCpuList(file.readAll());
+			for (int cpu : nodeCpus)
+			{
+				if (cpus.contains(cpu))
+					group << cpu;
+			}
+			if (!group.isEmpty())
+				groups << group;
+		}
+	}
+#else
+	Q_UNUSED(byNumaNode);
+#endif
+
+	if (groups.isEmpty())
+		groups << cpus;
+	return groups;
+}
+
+QList< QList<int> > CpuAllocator::physicalCores(const QList< QList<int> >& cpuGroups)
+{
+	QList< QList<int> > groups;
+	QSet<int> cores;
+
+	for (const auto& group : cpuGroups)
+	{
+		QList<int> cpus;
+		for (int cpu : group)
+		{
+			const int core = physicalCore(cpu);
+			if (cores.contains(core))
+				continue;
+			cores.insert(core);
+			cpus << cpu;
+		}
+		groups << cpus;
+	}
+
+	return groups;
+}
+
+QList< QList<int> > CpuAllocator::withoutCpus(const QList< QList<int> >& cpuGroups,
+					      int count)
+{
+	QList< QList<int> > groups;
+	for (auto group : cpuGroups)
+	{
+		const int n = qMin(count, group.size());
+		group.erase(group.begin(), group.begin() + n);
+		count -= n;
+		if (!group.isEmpty())
+			groups << group;
+	}
+
+	return groups;
+}
+
+int CpuAllocator::gameCapacity(int coresPerEngine,
+			       const QList< QList<int> >& cpuGroups)
+{
+	Q_ASSERT(coresPerEngine > 0);
+
+	int games = 0;
+	for (const auto& group : cpuGroups)
+		games += group.size() / (2 * coresPerEngine);
+	return games;
+}
+
+bool CpuAllocator::hasProcessAffinity()
+{
+#if defined(Q_OS_LINUX) || defined(Q_OS_WIN32)
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool CpuAllocator::setProcessAffinity(qint64 pid, const QList<int>& cpus)
+{
+	if (pid <= 0 || cpus.isEmpty())
+		return false;
+
+#if defined(Q_OS_LINUX)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int cpu : cpus)
+	{
+		if (cpu >= 0 && cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+	}
+
+	return sched_setaffinity(pid_t(pid), sizeof(set), &set) == 0;
+#elif defined(Q_OS_WIN32)
+	// Processor groups aren't supported, so only the first 64
+	// (or 32) CPUs can be used
+	DWORD_PTR mask = 0;
+	for (int cpu : cpus)
+	{
+		if (cpu >= 0 && cpu < int(sizeof(DWORD_PTR) * 8))
+			mask |= DWORD_PTR(1) << cpu;
+	}
+	if (mask == 0)
+		return false;
+
+	HANDLE process = OpenProcess(PROCESS_SET_INFORMATION
+				     | PROCESS_QUERY_INFORMATION,
+				     FALSE, DWORD(pid));
+	if (process == NULL)
+		return false;
+
+	bool ok = SetProcessAffinityMask(process, mask);
+	CloseHandle(process);
+	return ok;
+#else
+	// macOS only has affinity hints for threads
+	Q_UNUSED(pid);
+	Q_UNUSED(cpus);
+	return false;
+#endif
+}
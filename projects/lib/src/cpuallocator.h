@@ -0,0 +1,122 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef CPUALLOCATOR_H
+#define CPUALLOCATOR_H
+
+#include <QList>
+#include <QVector>
+
+/*!
+ * \brief Assigns dedicated sets of CPU cores to concurrent games
+ *
+ * The available CPUs are divided into game slots. Each slot has two
+ * disjoint sets of \a coresPerEngine cores, one for each player, taken
+ * from a single group of CPUs. A group is typically a NUMA node, so
+ * both engines of a game share the node's memory and caches. The
+ * slots of different groups are interleaved, so consecutive games are
+ * spread evenly over the groups.
+ *
+ * When there are more games than slots, the least used slot is shared.
+ */
+class LIB_EXPORT CpuAllocator
+{
+	public:
+		/*!
+		 * Creates a new allocator that gives \a coresPerEngine
+		 * cores to each engine from \a cpuGroups.
+		 *
+		 * Each item of \a cpuGroups is a list of CPU numbers.
+		 */
+		CpuAllocator(int coresPerEngine,
+			     const QList< QList<int> >& cpuGroups);
+
+		/*! Returns the number of cores per engine. */
+		int coresPerEngine() const;
+		/*! Returns the number of game slots. */
+		int slotCount() const;
+		/*!
+		 * Reserves a game slot and returns its index.
+		 *
+		 * Unused slots are given round-robin. If all slots are
+		 * in use, the least used slot is returned.
+		 * Returns -1 if there are no slots.
+		 */
+		int acquire();
+		/*! Releases \a slot that was reserved with acquire(). */
+		void release(int slot);
+		/*!
+		 * Returns the CPUs of player \a index (0 for white, 1 for
+		 * black) in \a slot.
+		 */
+		QList<int> cpus(int slot, int index) const;
+
+		/*!
+		 * Returns the CPUs this process may run on, grouped by
+		 * NUMA node if \a byNumaNode is true.
+		 */
+		static QList< QList<int> > cpuGroups(bool byNumaNode);
+		/*!
+		 * Returns \a cpuGroups with one CPU for each physical core,
+		 * so that simultaneous multithreading siblings don't count
+		 * as separate cores.
+		 */
+		static QList< QList<int> > physicalCores(const QList< QList<int> >& cpuGroups);
+		/*!
+		 * Returns \a cpuGroups without their first \a count CPUs,
+		 * eg. to leave them to this process.
+		 */
+		static QList< QList<int> > withoutCpus(const QList< QList<int> >& cpuGroups,
+						       int count);
+		/*!
+		 * Returns the number of games whose engines all get
+		 * \a coresPerEngine dedicated cores from \a cpuGroups.
+		 *
+		 * Unlike slotCount(), a group smaller than a game doesn't
+		 * count, so the result may be 0.
+		 */
+		static int gameCapacity(int coresPerEngine,
+					const QList< QList<int> >& cpuGroups);
+		/*!
+		 * Returns true if setProcessAffinity() is supported on
+		 * this platform.
+		 */
+		static bool hasProcessAffinity();
+		/*!
+		 * Restricts process \a pid to \a cpus.
+		 *
+		 * Threads that the process creates later inherit the
+		 * restriction. Returns false if the affinity can't be set
+		 * or isn't supported on this platform.
+		 */
+		static bool setProcessAffinity(qint64 pid, const QList<int>& cpus);
+
+	private:
+		struct Slot
+		{
+			QList<int> cpus[2];
+			int users;
+		};
+
+		int m_coresPerEngine;
+		int m_next;
+		QVector<Slot> m_slots;
+};
+
+#endif // CPUALLOCATOR_H
@@ -17,27 +17,31 @@
 */
 
 #include "econode.h"
+#include <algorithm>
 #include <QStringList>
 #include <QFile>
 #include <QDataStream>
+#include <QHash>
+#include <QMap>
 #include <QMutex>
 #include "pgngame.h"
 #include "pgnstream.h"
 
 namespace {
 
-QStringList s_openings;
-EcoNode* s_root = nullptr;
+// Identifies the flat trie format of the ECO file
+const quint32 s_ecoMagic = 0x45434f54;
 
-class EcoDeleter
+struct EcoEdge
 {
-	public:
-		~EcoDeleter()
-		{
-			delete s_root;
-		}
+	quint64 move;
+	quint32 node;
 };
-EcoDeleter s_ecoDeleter;
+
+QStringList s_strings;
+QVector<EcoNode> s_nodes;
+QVector<EcoEdge> s_edges;
+const EcoNode* s_root = nullptr;
 
 int ecoFromString(const QString& ecoString)
 {
@@ -55,52 +59,79 @@ int ecoFromString(const QString& ecoString)
 
 } // anonymous namespace
 
-QDataStream& operator<<(QDataStream& out, const EcoNode* node)
-{
-	if (!node)
-		return out;
-	out << node->m_ecoCode
-	    << node->m_opening
-	    << node->m_variation
-	    << node->m_children;
-
-	return out;
-}
-
-QDataStream& operator>>(QDataStream& in, EcoNode*& node)
-{
-	node = new EcoNode;
-
-	in >> node->m_ecoCode
-	   >> node->m_opening
-	   >> node->m_variation
-	   >> node->m_children;
-
-	return in;
-}
-
 void EcoNode::initialize()
 {
 	static QMutex mutex;
 	if (s_root)
 		return;
 
-	mutex.lock();
-	if (!s_root)
+	QMutexLocker locker(&mutex);
+	if (s_root)
+		return;
+
+	Q_INIT_RESOURCE(eco);
+
+	QFile file(":/eco.bin");
+	if (!file.open(QIODevice::ReadOnly))
 	{
-		Q_INIT_RESOURCE(eco);
+		qWarning("Could not open ECO file");
+		return;
+	}
 
-		QFile file(":/eco.bin");
-		if (!file.open(QIODevice::ReadOnly))
-			qWarning("Could not open ECO file");
-		else
-		{
-			QDataStream in(&file);
-			in.setVersion(QDataStream::Qt_4_6);
-			in >> s_openings >> s_root;
-		}
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_4_6);
+
+	quint32 magic = 0;
+	quint32 count = 0;
+	QStringList strings;
+	QVector<EcoNode> nodes;
+	QVector<EcoEdge> edges;
+
+	in >> magic >> strings >> count;
+	nodes.reserve(int(count));
+	for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+	{
+		EcoNode node;
+		in >> node.m_firstChild
+		   >> node.m_childCount
+		   >> node.m_ecoCode
+		   >> node.m_opening
+		   >> node.m_variation;
+		nodes.append(node);
+	}
+
+	in >> count;
+	edges.reserve(int(count));
+	for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+	{
+		EcoEdge edge;
+		in >> edge.move >> edge.node;
+		if (edge.node >= quint32(nodes.size()))
+			break;
+		edges.append(edge);
+	}
+
+	bool ok = (magic == s_ecoMagic
+		   && in.status() == QDataStream::Ok
+		   && !nodes.isEmpty()
+		   && edges.size() == int(count));
+	for (int i = 0; ok && i < nodes.size(); i++)
+	{
+		const EcoNode& node = nodes.at(i);
+		ok = (node.m_firstChild + node.m_childCount <= count
+		      && node.m_opening < strings.size()
+		      && node.m_variation < strings.size());
+	}
+	if (!ok)
+	{
+		qWarning("Invalid ECO file");
+		return;
 	}
-	mutex.unlock();
+
+	s_strings = strings;
+	s_nodes = nodes;
+	s_edges = edges;
+	s_root = s_nodes.constData();
 }
 
 void EcoNode::initialize(PgnStream& in)
@@ -114,45 +145,98 @@ void EcoNode::initialize(PgnStream& in)
 		return;
 	}
 
-	s_root = new EcoNode;
-	EcoNode* current = s_root;
-	QMap<QString, int> tmpOpenings;
+	struct TreeNode
+	{
+		TreeNode()
+			: ecoCode(-1),
+			  opening(-1),
+			  variation(-1)
+		{
+		}
+
+		qint16 ecoCode;
+		qint32 opening;
+		qint32 variation;
+		QMap<quint64, int> children;
+	};
+
+	QVector<TreeNode> tree(1);
+	QHash<QString, int> stringIndex;
+	QStringList strings;
+	auto addString = [&](const QString& str)
+	{
+		if (str.isEmpty())
+			return -1;
+
+		int index = stringIndex.value(str, -1);
+		if (index == -1)
+		{
+			index = strings.size();
+			stringIndex[str] = index;
+			strings.append(str);
+		}
+		return index;
+	};
 
 	PgnGame game;
 	while (game.read(in, INT_MAX - 1, false))
 	{
-		current = s_root;
-		for (const PgnGame::MoveData& move : game.moves())
+		int current = 0;
+		for (const PgnGame::MoveData& md : game.moves())
 		{
-			QString san = move.moveString;
-			EcoNode* node = current->child(san);
-			if (node == nullptr)
+			const quint64 move = encodeMove(md.moveString);
+			if (move == 0)
+			{
+				qWarning("Invalid ECO move: %s",
+					 qUtf8Printable(md.moveString));
+				current = 0;
+				break;
+			}
+
+			int node = tree.at(current).children.value(move, -1);
+			if (node == -1)
 			{
-				node = new EcoNode;
-				current->addChild(san, node);
+				node = tree.size();
+				tree[current].children[move] = node;
+				tree.append(TreeNode());
 			}
 			current = node;
 		}
-		if (current == s_root)
+		if (current == 0)
 			continue;
 
-		current->m_ecoCode = ecoFromString(game.tagValue("ECO"));
+		TreeNode& node = tree[current];
+		node.ecoCode = ecoFromString(game.tagValue(PgnGame::EcoTag));
+		node.opening = addString(game.tagValue(PgnGame::OpeningTag));
+		node.variation = addString(game.tagValue(PgnGame::VariationTag));
+	}
 
-		QString val = game.tagValue("Opening");
-		if (!val.isEmpty())
+	// Number the nodes in breadth-first order so that the children
+	// of each node have consecutive edges
+	QVector<int> order(1, 0);
+	for (int i = 0; i < order.size(); i++)
+	{
+		const TreeNode& treeNode = tree.at(order.at(i));
+
+		EcoNode node;
+		node.m_firstChild = quint32(s_edges.size());
+		node.m_childCount = quint16(treeNode.children.size());
+		node.m_ecoCode = treeNode.ecoCode;
+		node.m_opening = treeNode.opening;
+		node.m_variation = treeNode.variation;
+		s_nodes.append(node);
+
+		for (auto it = treeNode.children.constBegin();
+		     it != treeNode.children.constEnd(); ++it)
 		{
-			int index = tmpOpenings.value(val, -1);
-			if (index == -1)
-			{
-				index = tmpOpenings.count();
-				tmpOpenings[val] = index;
-				s_openings.append(val);
-			}
-			current->m_opening = index;
+			EcoEdge edge = { it.key(), quint32(order.size()) };
+			s_edges.append(edge);
+			order.append(it.value());
 		}
-
-		current->m_variation = game.tagValue("Variation");
 	}
+
+	s_strings = strings;
+	s_root = s_nodes.constData();
 }
 
 const EcoNode* EcoNode::root()
@@ -167,12 +251,12 @@ const EcoNode* EcoNode::find(const QVector<PgnGame::MoveData>& moves)
 	if (!s_root)
 		return nullptr;
 
-	EcoNode* current = s_root;
-	EcoNode* valid = nullptr;
+	const EcoNode* current = s_root;
+	const EcoNode* valid = nullptr;
 
 	for (const PgnGame::MoveData& move : moves)
 	{
-		EcoNode* node = current->child(move.moveString);
+		const EcoNode* node = current->child(move.moveString);
 		if (node == nullptr)
 			return valid;
 		if (!node->opening().isEmpty())
@@ -197,18 +281,45 @@ void EcoNode::write(const QString& fileName)
 
 	QDataStream out(&file);
 	out.setVersion(QDataStream::Qt_4_6);
-	out << s_openings << s_root;
+	out << s_ecoMagic << s_strings << quint32(s_nodes.size());
+	for (const EcoNode& node : qAsConst(s_nodes))
+	{
+		out << node.m_firstChild
+		    << node.m_childCount
+		    << node.m_ecoCode
+		    << node.m_opening
+		    << node.m_variation;
+	}
+
+	out << quint32(s_edges.size());
+	for (const EcoEdge& edge : qAsConst(s_edges))
+		out << edge.move << edge.node;
 }
 
-EcoNode::EcoNode()
-	: m_ecoCode(-1),
-	  m_opening(-1)
+quint64 EcoNode::encodeMove(const QString& sanMove)
 {
+	if (sanMove.isEmpty() || sanMove.length() > 8)
+		return 0;
+
+	quint64 move = 0;
+	for (int i = 0; i < sanMove.length(); i++)
+	{
+		const ushort c = sanMove.at(i).unicode();
+		if (c > 0xff)
+			return 0;
+		move |= quint64(c) << (i * 8);
+	}
+
+	return move;
 }
 
-EcoNode::~EcoNode()
+EcoNode::EcoNode()
+	: m_firstChild(0),
+	  m_childCount(0),
+	  m_ecoCode(-1),
+	  m_opening(-1),
+	  m_variation(-1)
 {
-	qDeleteAll(m_children);
 }
 
 bool EcoNode::isLeaf() const
@@ -227,20 +338,27 @@ QString EcoNode::ecoCode() const
 
 QString EcoNode::opening() const
 {
-	return m_opening >= 0 ? s_openings[m_opening] : QString();
+	return m_opening >= 0 ? s_strings.at(m_opening) : QString();
 }
 
 QString EcoNode::variation() const
 {
-	return m_variation;
+	return m_variation >= 0 ? s_strings.at(m_variation) : QString();
 }
 
-EcoNode* EcoNode::child(const QString& sanMove) const
+const EcoNode* EcoNode::child(const QString& sanMove) const
 {
-	return m_children.value(sanMove);
-}
+	const quint64 move = encodeMove(sanMove);
+	const EcoEdge* first = s_edges.constData() + m_firstChild;
+	const EcoEdge* last = first + m_childCount;
 
-void EcoNode::addChild(const QString& sanMove, EcoNode* child)
-{
-	m_children[sanMove] = child;
+	first = std::lower_bound(first, last, move,
+		[](const EcoEdge& edge, quint64 value)
+	{
+		return edge.move < value;
+	});
+	if (first == last || first->move != move)
+		return nullptr;
+
+	return s_nodes.constData() + first->node;
 }
@@ -20,9 +20,7 @@
 #define ECONODE_H
 
 #include <QString>
-#include <QMap>
 #include "pgngame.h"
-class QDataStream;
 class PgnStream;
 
 /*!
@@ -37,15 +35,17 @@ class PgnStream;
  * to a PgnGame can be found by traversing the ECO tree as new moves are added
  * to the game, or by passing all the moves at once to the find() function.
  *
+ * The tree is stored as a flat trie: the nodes are kept in one array, and
+ * the children of a node are a contiguous range of edges sorted by the
+ * encoded SAN move (see encodeMove()). The binary file holds the arrays
+ * as they are in memory, so loading it doesn't build any nodes.
+ *
  * \note The Encyclopaedia of Chess Openings only applies to games of standard
  * chess that start from the default starting position.
  */
 class LIB_EXPORT EcoNode
 {
 	public:
-		/*! Destroys the node and its subtree. */
-		~EcoNode();
-
 		/*!
 		 * Returns true if the node is a leaf node; otherwise returns false.
 		 * A leaf node is a node that counts as an opening and has an ECO
@@ -56,7 +56,7 @@ class LIB_EXPORT EcoNode
 		 * Returns the node's child node corresponding to \a sanMove, or 0
 		 * if no match is found.
 		 */
-		EcoNode* child(const QString& sanMove) const;
+		const EcoNode* child(const QString& sanMove) const;
 		/*!
 		 * Returns the node's ECO code, or an empty string if the node is
 		 * an inner node.
@@ -73,6 +73,13 @@ class LIB_EXPORT EcoNode
 		 */
 		QString variation() const;
 
+		/*!
+		 * Returns \a sanMove packed into an integer, one Latin-1
+		 * character per byte, or 0 if the move string is longer
+		 * than 8 characters.
+		 */
+		static quint64 encodeMove(const QString& sanMove);
+
 		/*! Initializes the ECO tree from the internal opening database. */
 		static void initialize();
 		/*! Initializes the ECO tree by parsing the PGN games in \a in. */
@@ -91,25 +98,13 @@ class LIB_EXPORT EcoNode
 		static void write(const QString& fileName);
 
 	private:
-		friend LIB_EXPORT QDataStream& operator<<(QDataStream& out, const EcoNode* node);
-		friend LIB_EXPORT QDataStream& operator>>(QDataStream& in, EcoNode*& node);
-
 		EcoNode();
-		void addChild(const QString& sanMove, EcoNode* child);
 
+		quint32 m_firstChild;
+		quint16 m_childCount;
 		qint16 m_ecoCode;
 		qint32 m_opening;
-		QString m_variation;
-
-		QMap<QString, EcoNode*> m_children;
+		qint32 m_variation;
 };
 
-/*! Writes the node \a node to stream \a out. */
-extern LIB_EXPORT QDataStream& operator<<(QDataStream& out, const EcoNode* node);
-/*!
- * Reads a node from stream \a in into \a node.
- * \a node should be a null or uninitialized pointer.
- */
-extern LIB_EXPORT QDataStream& operator>>(QDataStream& in, EcoNode*& node);
-
 #endif // ECONODE_H
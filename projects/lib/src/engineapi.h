@@ -0,0 +1,77 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINEAPI_H
+#define ENGINEAPI_H
+
+/*
+ * The C interface of chess engines that are loaded from a shared
+ * library instead of being run as a separate process.
+ *
+ * The library exports a function named CUTECHESS_ENGINE_MAIN with the
+ * CuteChessEngineMain signature. Cute Chess calls it in a thread of
+ * its own, and it works like the engine's main() function with the
+ * standard input and output replaced by the functions in
+ * CuteChessEngineIo. The engine speaks its usual protocol (eg. UCI)
+ * over them and returns after the "quit" command or at the end of
+ * the input.
+ *
+ * Many instances of the engine may run at the same time in the same
+ * process, so the engine must not keep its state in global variables.
+ *
+ * This header doesn't depend on Qt or Cute Chess, so engine authors
+ * can copy it to their own source tree.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The name of the entry point exported by an engine library */
+#define CUTECHESS_ENGINE_MAIN "cutechess_engine_main"
+
+typedef struct CuteChessEngineIo
+{
+	/* Passed as the first argument to the functions below */
+	void* context;
+	/*
+	 * Blocks until the next line of input is available and returns
+	 * it without the newline character. The string is valid until
+	 * the next call. Returns a null pointer at the end of the input.
+	 */
+	const char* (*readLine)(void* context);
+	/*
+	 * Sends the line \a line, without a newline character, to
+	 * Cute Chess. Can be called from any of the engine's threads.
+	 */
+	void (*writeLine)(void* context, const char* line);
+} CuteChessEngineIo;
+
+/*
+ * The engine's entry point. The arguments are the ones in the engine
+ * configuration, with the library's path as argv[0].
+ */
+typedef int (*CuteChessEngineMain)(const CuteChessEngineIo* io,
+				   int argc,
+				   const char* const* argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ENGINEAPI_H */
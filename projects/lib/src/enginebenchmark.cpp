@@ -0,0 +1,414 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "enginebenchmark.h"
+#include <QIODevice>
+#include <QTimer>
+#include "enginebuilder.h"
+#include "engineoption.h"
+
+namespace {
+
+// Time given to an engine to exit after the "quit" command
+const int s_quitTimeout = 2000;
+
+} // anonymous namespace
+
+EngineBenchmark::EngineBenchmark(QObject* parent)
+	: QObject(parent),
+	  m_pingCount(100),
+	  m_searchCount(10),
+	  m_timeout(10000),
+	  m_current(0),
+	  m_device(nullptr),
+	  m_timer(new QTimer(this)),
+	  m_step(Idle),
+	  m_stepCount(0),
+	  m_pingId(0),
+	  m_stopped(false)
+{
+	m_timer->setSingleShot(true);
+	connect(m_timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+}
+
+void EngineBenchmark::addEngine(const EngineConfiguration& config)
+{
+	Engine engine;
+	engine.config = config;
+	engine.histograms.resize(MeasurementCount);
+	m_engines.append(engine);
+}
+
+int EngineBenchmark::engineCount() const
+{
+	return m_engines.size();
+}
+
+QString EngineBenchmark::engineName(int engine) const
+{
+	return m_engines.at(engine).config.name();
+}
+
+void EngineBenchmark::setPingCount(int count)
+{
+	m_pingCount = count;
+}
+
+void EngineBenchmark::setSearchCount(int count)
+{
+	m_searchCount = count;
+}
+
+void EngineBenchmark::setTimeout(int msecs)
+{
+	m_timeout = msecs;
+}
+
+int EngineBenchmark::timeout() const
+{
+	return m_timeout;
+}
+
+const LatencyHistogram& EngineBenchmark::histogram(int engine,
+						   Measurement measurement) const
+{
+	return m_engines.at(engine).histograms.at(measurement);
+}
+
+QStringList EngineBenchmark::errors(int engine) const
+{
+	return m_engines.at(engine).errors;
+}
+
+QString EngineBenchmark::measurementName(Measurement measurement)
+{
+	switch (measurement)
+	{
+	case StartupTime:
+		return tr("Startup");
+	case PingTime:
+		return tr("Ping");
+	case OptionTime:
+		return tr("Option");
+	case FirstInfoTime:
+		return tr("First info");
+	case StopTime:
+		return tr("Stop");
+	default:
+		return QString();
+	}
+}
+
+void EngineBenchmark::start()
+{
+	m_current = 0;
+	m_stopped = false;
+	startEngine();
+}
+
+void EngineBenchmark::stop()
+{
+	if (m_stopped)
+		return;
+
+	m_stopped = true;
+	if (m_device != nullptr && m_step != Quitting)
+		quitEngine(tr("Benchmark stopped"));
+}
+
+bool EngineBenchmark::isUci() const
+{
+	return m_engines.at(m_current).config.protocol() == "uci";
+}
+
+void EngineBenchmark::startEngine()
+{
+	while (m_current < m_engines.size())
+	{
+		if (m_stopped)
+		{
+			m_current = m_engines.size();
+			break;
+		}
+
+		QString error;
+		EngineBuilder builder(m_engines.at(m_current).config);
+		m_device = builder.startDevice(&error);
+		if (m_device != nullptr)
+			break;
+
+		m_engines[m_current].errors.append(error);
+		emit engineFinished(m_current);
+		m_current++;
+	}
+	if (m_current >= m_engines.size())
+	{
+		m_step = Idle;
+		emit finished();
+		return;
+	}
+
+	connect(m_device, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+	connect(m_device, SIGNAL(readChannelFinished()),
+		this, SLOT(onEngineQuit()));
+
+	m_step = Starting;
+	m_stepCount = 0;
+	m_pingId = 0;
+	m_elapsed.start();
+	if (isUci())
+		write("uci");
+	else
+	{
+		write("xboard");
+		write("protover 2");
+	}
+	m_timer->start(m_timeout);
+}
+
+void EngineBenchmark::write(const QString& line)
+{
+	m_device->write(line.toLatin1() + '\n');
+}
+
+void EngineBenchmark::onReadyRead()
+{
+	while (m_device != nullptr && m_device->canReadLine())
+	{
+		QString line(QString::fromLatin1(m_device->readLine()));
+		processLine(line.trimmed());
+	}
+}
+
+void EngineBenchmark::processLine(const QString& line)
+{
+	const bool uci = isUci();
+
+	switch (m_step)
+	{
+	case Starting:
+		// Xboard engines may ask for more time with "done=0"
+		if ((uci && line == "uciok")
+		||  (!uci && line.startsWith("feature ")
+		     && line.contains("done=1")))
+		{
+			addSample(StartupTime);
+			m_step = SettingOption;
+			nextStep();
+		}
+		break;
+	case SettingOption:
+		if (isPong(line))
+		{
+			addSample(OptionTime);
+			m_stepCount++;
+			nextStep();
+		}
+		break;
+	case Pinging:
+		if (isPong(line))
+		{
+			addSample(PingTime);
+			m_stepCount++;
+			nextStep();
+		}
+		break;
+	case Searching:
+		// Thinking output starts with the depth in Xboard
+		if ((uci && line.startsWith("info "))
+		||  (!uci && !line.isEmpty() && line.at(0).isDigit()))
+		{
+			addSample(FirstInfoTime);
+			m_step = Stopping;
+			m_elapsed.start();
+			write(uci ? "stop" : "?");
+			m_timer->start(m_timeout);
+		}
+		// An engine that moves before thinking out loud
+		// doesn't get a sample
+		else if (line.startsWith(uci ? "bestmove " : "move "))
+		{
+			m_stepCount++;
+			nextStep();
+		}
+		break;
+	case Stopping:
+		if (line.startsWith(uci ? "bestmove " : "move "))
+		{
+			addSample(StopTime);
+			m_step = Searching;
+			m_stepCount++;
+			nextStep();
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void EngineBenchmark::addSample(Measurement measurement)
+{
+	m_engines[m_current].histograms[measurement].add(m_elapsed.nsecsElapsed());
+}
+
+void EngineBenchmark::nextStep()
+{
+	if (m_step == SettingOption)
+	{
+		const auto options = m_engines.at(m_current).config.options();
+		if (m_stepCount < options.size())
+		{
+			const EngineOption* option = options.at(m_stepCount);
+			const QString name = option->name();
+			const QVariant value = option->value();
+
+			// The commands match those of UciEngine and XboardEngine
+			m_elapsed.start();
+			if (isUci() && value.isNull())
+				write("setoption name " + name);
+			else if (isUci())
+				write("setoption name " + name + " value " + value.toString());
+			else if (name == "memory" || name == "cores"
+			     ||  name.startsWith("egtpath "))
+				write(name + " " + value.toString());
+			else if (value.isNull())
+				write("option " + name);
+			else if (value.type() == QVariant::Bool)
+				write("option " + name + "=" + (value.toBool() ? "1" : "0"));
+			else
+				write("option " + name + "=" + value.toString());
+			sendPing();
+			return;
+		}
+		m_step = Pinging;
+		m_stepCount = 0;
+	}
+	if (m_step == Pinging)
+	{
+		if (m_stepCount < m_pingCount)
+		{
+			m_elapsed.start();
+			sendPing();
+			return;
+		}
+		m_step = Searching;
+		m_stepCount = 0;
+	}
+	if (m_step == Searching && m_stepCount < m_searchCount)
+	{
+		startSearch();
+		return;
+	}
+
+	m_timer->stop();
+	quitEngine();
+}
+
+void EngineBenchmark::sendPing()
+{
+	if (isUci())
+		write("isready");
+	else
+		write(QString("ping %1").arg(++m_pingId));
+	m_timer->start(m_timeout);
+}
+
+bool EngineBenchmark::isPong(const QString& line) const
+{
+	if (isUci())
+		return line == "readyok";
+	return line == QString("pong %1").arg(m_pingId);
+}
+
+void EngineBenchmark::startSearch()
+{
+	if (isUci())
+	{
+		write("position startpos");
+		m_elapsed.start();
+		write("go infinite");
+	}
+	else
+	{
+		write("new");
+		write("post");
+		m_elapsed.start();
+		write("go");
+	}
+	m_timer->start(m_timeout);
+}
+
+void EngineBenchmark::quitEngine(const QString& error)
+{
+	if (!error.isEmpty())
+		m_engines[m_current].errors.append(error);
+
+	m_step = Quitting;
+	write("quit");
+	m_timer->start(s_quitTimeout);
+}
+
+void EngineBenchmark::onTimeout()
+{
+	if (m_step == Quitting)
+	{
+		onEngineQuit();
+		return;
+	}
+
+	QString command;
+	switch (m_step)
+	{
+	case Starting:
+		command = isUci() ? "uci" : "protover 2";
+		break;
+	case SettingOption:
+	case Pinging:
+		command = isUci() ? "isready" : "ping";
+		break;
+	case Searching:
+		command = "go";
+		break;
+	case Stopping:
+		command = isUci() ? "stop" : "?";
+		break;
+	default:
+		break;
+	}
+	quitEngine(tr("No response to \"%1\" in %2 ms")
+		   .arg(command).arg(m_timeout));
+}
+
+void EngineBenchmark::onEngineQuit()
+{
+	if (m_device == nullptr)
+		return;
+	if (m_step != Quitting)
+		m_engines[m_current].errors.append(tr("Engine terminated unexpectedly"));
+
+	m_timer->stop();
+	m_device->disconnect(this);
+	m_device->close();
+	m_device->deleteLater();
+	m_device = nullptr;
+	m_step = Idle;
+
+	emit engineFinished(m_current);
+	m_current++;
+	startEngine();
+}
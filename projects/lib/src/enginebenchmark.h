@@ -0,0 +1,168 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINEBENCHMARK_H
+#define ENGINEBENCHMARK_H
+
+#include <QObject>
+#include <QVector>
+#include <QStringList>
+#include <QElapsedTimer>
+#include "engineconfiguration.h"
+#include "latencyhistogram.h"
+class QIODevice;
+class QTimer;
+
+/*!
+ * \brief Measures how quickly chess engines respond to commands
+ *
+ * EngineBenchmark starts each engine in turn and times its responses
+ * to the commands that matter for fast games:
+ * - the time from starting the protocol to the end of the engine's
+ *   initialization ("uciok", or "feature done=1" for Xboard engines)
+ * - the round trip of "isready" or "ping"
+ * - the time to apply each of the engine's configured options
+ * - the time from "go" to the first line of thinking output
+ * - the time from "stop" (or "?") to the engine's move
+ *
+ * The benchmark speaks the protocol directly over the engine's process
+ * or library interface, without a game or ChessEngine object, so it
+ * can send commands at any time and the times don't include the
+ * parsing of the engine's output. An engine that doesn't answer within
+ * timeout() is stopped, and its measurements so far are kept.
+ */
+class LIB_EXPORT EngineBenchmark : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! The measured response times. */
+		enum Measurement
+		{
+			StartupTime,	//!< Protocol initialization
+			PingTime,	//!< "isready" or "ping" round trip
+			OptionTime,	//!< Applying one option
+			FirstInfoTime,	//!< "go" to first thinking output
+			StopTime,	//!< "stop" to the engine's move
+			MeasurementCount
+		};
+
+		/*! Creates a new benchmark. */
+		explicit EngineBenchmark(QObject* parent = nullptr);
+
+		/*! Adds an engine defined by \a config to the benchmark. */
+		void addEngine(const EngineConfiguration& config);
+		/*! Returns the number of engines. */
+		int engineCount() const;
+		/*! Returns the name of \a engine. */
+		QString engineName(int engine) const;
+
+		/*!
+		 * Sets the number of "isready" or "ping" round trips per
+		 * engine to \a count. The default is 100.
+		 */
+		void setPingCount(int count);
+		/*!
+		 * Sets the number of searches per engine to \a count.
+		 * The default is 10.
+		 */
+		void setSearchCount(int count);
+		/*!
+		 * Sets the time in milliseconds an engine has to respond
+		 * to each command to \a msecs. The default is 10 seconds.
+		 */
+		void setTimeout(int msecs);
+		/*! Returns the response timeout in milliseconds. */
+		int timeout() const;
+
+		/*!
+		 * Returns the samples of \a measurement for \a engine,
+		 * in nanoseconds.
+		 */
+		const LatencyHistogram& histogram(int engine,
+						  Measurement measurement) const;
+		/*! Returns the errors of \a engine, or an empty list. */
+		QStringList errors(int engine) const;
+		/*! Returns a short English name of \a measurement. */
+		static QString measurementName(Measurement measurement);
+
+	public slots:
+		/*! Starts the benchmark. */
+		void start();
+		/*!
+		 * Stops the benchmark after telling the current engine
+		 * to quit. The finished() signal is emitted as usual.
+		 */
+		void stop();
+
+	signals:
+		/*! Emitted when \a engine has been measured and has quit. */
+		void engineFinished(int engine);
+		/*! Emitted when all of the engines have been measured. */
+		void finished();
+
+	private slots:
+		void onReadyRead();
+		void onTimeout();
+		void onEngineQuit();
+
+	private:
+		enum Step
+		{
+			Idle,
+			Starting,
+			SettingOption,
+			Pinging,
+			Searching,
+			Stopping,
+			Quitting
+		};
+		struct Engine
+		{
+			EngineConfiguration config;
+			QVector<LatencyHistogram> histograms;
+			QStringList errors;
+		};
+
+		bool isUci() const;
+		void startEngine();
+		void write(const QString& line);
+		void processLine(const QString& line);
+		void addSample(Measurement measurement);
+		void nextStep();
+		void sendPing();
+		bool isPong(const QString& line) const;
+		void startSearch();
+		void quitEngine(const QString& error = QString());
+
+		QVector<Engine> m_engines;
+		int m_pingCount;
+		int m_searchCount;
+		int m_timeout;
+
+		int m_current;
+		QIODevice* m_device;
+		QTimer* m_timer;
+		QElapsedTimer m_elapsed;
+		Step m_step;
+		int m_stepCount;
+		int m_pingId;
+		bool m_stopped;
+};
+
+#endif // ENGINEBENCHMARK_H
@@ -19,7 +19,10 @@
 #include "enginebuilder.h"
 #include <QDir>
 #include "engineprocess.h"
+#include "enginelibrary.h"
+#include "enginesocket.h"
 #include "enginefactory.h"
+#include "tracelog.h"
 
 
 EngineBuilder::EngineBuilder(const EngineConfiguration& config)
@@ -37,6 +40,45 @@ ChessPlayer* EngineBuilder::create(QObject* receiver,
 				   const char* method,
 				   QObject* parent,
 				   QString* error) const
+{
+	if (!EngineFactory::protocols().contains(m_config.protocol()))
+	{
+		setError(error, tr("Unknown chess protocol: %1")
+			 .arg(m_config.protocol()));
+		return nullptr;
+	}
+
+	const qint64 traceStart = TraceLog::isEnabled() ? TraceLog::timestamp() : -1;
+	QIODevice* device = startDevice(error);
+	if (device == nullptr)
+		return nullptr;
+	if (traceStart >= 0)
+		TraceLog::addEventSince("engine", "Start-up: " + name(), traceStart);
+
+	ChessEngine* engine = EngineFactory::create(m_config.protocol());
+	Q_ASSERT(engine != nullptr);
+
+	engine->setParent(parent);
+	if (receiver != nullptr && method != nullptr)
+		QObject::connect(engine, SIGNAL(debugMessage(QString)),
+				 receiver, method);
+	engine->setDevice(device);
+	engine->applyConfiguration(m_config);
+
+	engine->start();
+	return engine;
+}
+
+QIODevice* EngineBuilder::startDevice(QString* error) const
+{
+	if (!m_config.remote().isEmpty())
+		return startRemote(error);
+	if (!m_config.library().isEmpty())
+		return startLibrary(error);
+	return startProcess(error);
+}
+
+QIODevice* EngineBuilder::startProcess(QString* error) const
 {
 	QString workDir = m_config.workingDirectory();
 	QString cmd = m_config.command().trimmed();
@@ -48,13 +90,6 @@ ChessPlayer* EngineBuilder::create(QObject* receiver,
 		return nullptr;
 	}
 
-	if (!EngineFactory::protocols().contains(m_config.protocol()))
-	{
-		setError(error, tr("Unknown chess protocol: %1")
-			 .arg(m_config.protocol()));
-		return nullptr;
-	}
-
 	EngineProcess* process = new EngineProcess();
 
 	if (workDir.isEmpty())
@@ -85,18 +120,37 @@ ChessPlayer* EngineBuilder::create(QObject* receiver,
 		return nullptr;
 	}
 
-	ChessEngine* engine = EngineFactory::create(m_config.protocol());
-	Q_ASSERT(engine != nullptr);
+	return process;
+}
 
-	engine->setParent(parent);
-	if (receiver != nullptr && method != nullptr)
-		QObject::connect(engine, SIGNAL(debugMessage(QString)),
-				 receiver, method);
-	engine->setDevice(process);
-	engine->applyConfiguration(m_config);
+QIODevice* EngineBuilder::startLibrary(QString* error) const
+{
+	// The working directory and standard error are per process,
+	// so they're left alone
+	EngineLibrary* library = new EngineLibrary();
+	if (!library->start(m_config.library(), m_config.arguments()))
+	{
+		setError(error, tr("Cannot load engine library: %1")
+			 .arg(library->errorString()));
+		delete library;
+		return nullptr;
+	}
 
-	engine->start();
-	return engine;
+	return library;
+}
+
+QIODevice* EngineBuilder::startRemote(QString* error) const
+{
+	EngineSocket* socket = new EngineSocket();
+	if (!socket->connectToRelay(m_config.remote()))
+	{
+		setError(error, tr("Cannot connect to engine relay %1: %2")
+			 .arg(m_config.remote(), socket->errorString()));
+		delete socket;
+		return nullptr;
+	}
+
+	return socket;
 }
 
 void EngineBuilder::setError(QString* error, const QString& message) const
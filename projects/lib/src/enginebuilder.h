@@ -22,9 +22,18 @@
 #include "playerbuilder.h"
 #include <QCoreApplication>
 #include "engineconfiguration.h"
+class QIODevice;
 
 
-/*! \brief A class for constructing local chess engines. */
+/*!
+ * \brief A class for constructing local chess engines.
+ *
+ * The engine is started as a separate process, or in a thread of this
+ * process if its configuration has a library. If the configuration has
+ * a remote address, the engine is reached through an EngineRelay.
+ *
+ * \sa EngineConfiguration::setLibrary(), EngineConfiguration::setRemote()
+ */
 class LIB_EXPORT EngineBuilder : public PlayerBuilder
 {
 	Q_DECLARE_TR_FUNCTIONS(EngineBuilder)
@@ -40,7 +49,21 @@ class LIB_EXPORT EngineBuilder : public PlayerBuilder
 					    QObject* parent,
 					    QString* error) const;
 
+		/*!
+		 * Starts the engine's process or library without a
+		 * ChessEngine object and returns its IO device, or nullptr
+		 * if the engine can't be started. The caller owns the
+		 * device.
+		 *
+		 * If \a error isn't nullptr, the error message is stored
+		 * in it; otherwise it's printed with qWarning().
+		 */
+		QIODevice* startDevice(QString* error) const;
+
 	private:
+		QIODevice* startProcess(QString* error) const;
+		QIODevice* startLibrary(QString* error) const;
+		QIODevice* startRemote(QString* error) const;
 		void setError(QString* error, const QString& message) const;
 
 		EngineConfiguration m_config;
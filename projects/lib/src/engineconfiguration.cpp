@@ -27,7 +27,9 @@ EngineConfiguration::EngineConfiguration()
 	  m_whiteEvalPov(false),
 	  m_pondering(false),
 	  m_validateClaims(true),
-	  m_restartMode(RestartAuto)
+	  m_restartMode(RestartAuto),
+	  m_outputBudget(0),
+	  m_outputPolicy(OutputDrop)
 {
 }
 
@@ -41,7 +43,9 @@ EngineConfiguration::EngineConfiguration(const QString& name,
 	  m_whiteEvalPov(false),
 	  m_pondering(false),
 	  m_validateClaims(true),
-	  m_restartMode(RestartAuto)
+	  m_restartMode(RestartAuto),
+	  m_outputBudget(0),
+	  m_outputPolicy(OutputDrop)
 {
 }
 
@@ -50,12 +54,16 @@ EngineConfiguration::EngineConfiguration(const QVariant& variant)
 	  m_whiteEvalPov(false),
 	  m_pondering(false),
 	  m_validateClaims(true),
-	  m_restartMode(RestartAuto)
+	  m_restartMode(RestartAuto),
+	  m_outputBudget(0),
+	  m_outputPolicy(OutputDrop)
 {
 	const QVariantMap map = variant.toMap();
 
 	setName(map["name"].toString());
 	setCommand(map["command"].toString());
+	setLibrary(map["library"].toString());
+	setRemote(map["remote"].toString());
 	setWorkingDirectory(map["workingDirectory"].toString());
 	setStderrFile(map["stderrFile"].toString());
 	setProtocol(map["protocol"].toString());
@@ -81,8 +89,15 @@ EngineConfiguration::EngineConfiguration(const QVariant& variant)
 	if (map.contains("validateClaims"))
 		setClaimsValidated(map["validateClaims"].toBool());
 
+	if (map.contains("outputBudget"))
+		setOutputBudget(map["outputBudget"].toInt());
+	if (map["outputPolicy"].toString() == "sample")
+		setOutputPolicy(OutputSample);
+
 	if (map.contains("variants"))
 		setSupportedVariants(map["variants"].toStringList());
+	if (map.contains("detected"))
+		setDetectionStamp(EngineStamp::fromVariant(map["detected"]));
 
 	if (map.contains("options"))
 	{
@@ -100,16 +115,21 @@ EngineConfiguration::EngineConfiguration(const QVariant& variant)
 EngineConfiguration::EngineConfiguration(const EngineConfiguration& other)
 	: m_name(other.m_name),
 	  m_command(other.m_command),
+	  m_library(other.m_library),
+	  m_remote(other.m_remote),
 	  m_workingDirectory(other.m_workingDirectory),
 	  m_stderrFile(other.m_stderrFile),
 	  m_protocol(other.m_protocol),
 	  m_arguments(other.m_arguments),
 	  m_initStrings(other.m_initStrings),
 	  m_variants(other.m_variants),
+	  m_detectionStamp(other.m_detectionStamp),
 	  m_whiteEvalPov(other.m_whiteEvalPov),
 	  m_pondering(other.m_pondering),
 	  m_validateClaims(other.m_validateClaims),
-	  m_restartMode(other.m_restartMode)
+	  m_restartMode(other.m_restartMode),
+	  m_outputBudget(other.m_outputBudget),
+	  m_outputPolicy(other.m_outputPolicy)
 {
 	const auto options = other.options();
 	for (const EngineOption* option : options)
@@ -124,16 +144,21 @@ EngineConfiguration& EngineConfiguration::operator=(EngineConfiguration&& other)
 	qDeleteAll(m_options);
 	m_name = other.m_name;
 	m_command = other.m_command;
+	m_library = other.m_library;
+	m_remote = other.m_remote;
 	m_workingDirectory = other.m_workingDirectory;
 	m_stderrFile = other.m_stderrFile;
 	m_protocol = other.m_protocol;
 	m_arguments = other.m_arguments;
 	m_initStrings = other.m_initStrings;
 	m_variants = other.m_variants;
+	m_detectionStamp = other.m_detectionStamp;
 	m_whiteEvalPov = other.m_whiteEvalPov;
 	m_pondering = other.m_pondering;
 	m_validateClaims = other.m_validateClaims;
 	m_restartMode = other.m_restartMode;
+	m_outputBudget = other.m_outputBudget;
+	m_outputPolicy = other.m_outputPolicy;
 	m_options = other.m_options;
 
 	// other's destructor will cause a mess if its m_options isn't cleared
@@ -152,6 +177,10 @@ QVariant EngineConfiguration::toVariant() const
 
 	map.insert("name", m_name);
 	map.insert("command", m_command);
+	if (!m_library.isEmpty())
+		map.insert("library", m_library);
+	if (!m_remote.isEmpty())
+		map.insert("remote", m_remote);
 	map.insert("workingDirectory", m_workingDirectory);
 	map.insert("stderrFile", m_stderrFile);
 	map.insert("protocol", m_protocol);
@@ -171,6 +200,11 @@ QVariant EngineConfiguration::toVariant() const
 	if (!m_validateClaims)
 		map.insert("validateClaims", false);
 
+	if (m_outputBudget > 0)
+		map.insert("outputBudget", m_outputBudget);
+	if (m_outputPolicy == OutputSample)
+		map.insert("outputPolicy", "sample");
+
 	if (m_variants.count("standard") != m_variants.count())
 		map.insert("variants", m_variants);
 
@@ -183,6 +217,9 @@ QVariant EngineConfiguration::toVariant() const
 		map.insert("options", optionsList);
 	}
 
+	if (!m_detectionStamp.isNull())
+		map.insert("detected", m_detectionStamp.toVariant());
+
 	return map;
 }
 
@@ -196,6 +233,16 @@ void EngineConfiguration::setCommand(const QString& command)
 	m_command = command;
 }
 
+void EngineConfiguration::setLibrary(const QString& fileName)
+{
+	m_library = fileName;
+}
+
+void EngineConfiguration::setRemote(const QString& address)
+{
+	m_remote = address;
+}
+
 void EngineConfiguration::setProtocol(const QString& protocol)
 {
 	m_protocol = protocol;
@@ -221,6 +268,16 @@ QString EngineConfiguration::command() const
 	return m_command;
 }
 
+QString EngineConfiguration::library() const
+{
+	return m_library;
+}
+
+QString EngineConfiguration::remote() const
+{
+	return m_remote;
+}
+
 QString EngineConfiguration::workingDirectory() const
 {
 	return m_workingDirectory;
@@ -281,6 +338,16 @@ void EngineConfiguration::setSupportedVariants(const QStringList& variants)
 	m_variants = variants;
 }
 
+EngineStamp EngineConfiguration::detectionStamp() const
+{
+	return m_detectionStamp;
+}
+
+void EngineConfiguration::setDetectionStamp(const EngineStamp& stamp)
+{
+	m_detectionStamp = stamp;
+}
+
 QList<EngineOption*> EngineConfiguration::options() const
 {
 	return m_options;
@@ -321,6 +388,23 @@ void EngineConfiguration::setOption(const QString& name, const QVariant& value)
 	m_options << new EngineTextOption(name, value, value);
 }
 
+int EngineConfiguration::threadCount() const
+{
+	for (const EngineOption* option : qAsConst(m_options))
+	{
+		if (option->name().compare("Threads", Qt::CaseInsensitive) != 0
+		&&  option->name() != "cores")
+			continue;
+
+		bool ok = false;
+		const int count = option->value().toInt(&ok);
+		if (ok && count > 0)
+			return count;
+	}
+
+	return 1;
+}
+
 bool EngineConfiguration::whiteEvalPov() const
 {
 	return m_whiteEvalPov;
@@ -361,22 +445,47 @@ void EngineConfiguration::setClaimsValidated(bool validate)
 	m_validateClaims = validate;
 }
 
+int EngineConfiguration::outputBudget() const
+{
+	return m_outputBudget;
+}
+
+void EngineConfiguration::setOutputBudget(int linesPerSecond)
+{
+	m_outputBudget = qMax(0, linesPerSecond);
+}
+
+EngineConfiguration::OutputPolicy EngineConfiguration::outputPolicy() const
+{
+	return m_outputPolicy;
+}
+
+void EngineConfiguration::setOutputPolicy(OutputPolicy policy)
+{
+	m_outputPolicy = policy;
+}
+
 EngineConfiguration& EngineConfiguration::operator=(const EngineConfiguration& other)
 {
 	if (this != &other)
 	{
 		m_name = other.m_name;
 		m_command = other.m_command;
+		m_library = other.m_library;
+		m_remote = other.m_remote;
 		m_workingDirectory = other.m_workingDirectory;
 		m_stderrFile = other.m_stderrFile;
 		m_protocol = other.m_protocol;
 		m_arguments = other.m_arguments;
 		m_initStrings = other.m_initStrings;
 		m_variants = other.m_variants;
+		m_detectionStamp = other.m_detectionStamp;
 		m_whiteEvalPov = other.m_whiteEvalPov;
 		m_pondering = other.m_pondering;
 		m_validateClaims = other.m_validateClaims;
 		m_restartMode = other.m_restartMode;
+		m_outputBudget = other.m_outputBudget;
+		m_outputPolicy = other.m_outputPolicy;
 
 		qDeleteAll(m_options);
 		m_options.clear();
@@ -22,6 +22,7 @@
 #include <QString>
 #include <QStringList>
 #include <QVariant>
+#include "enginestamp.h"
 
 class EngineOption;
 
@@ -43,6 +44,15 @@ class LIB_EXPORT EngineConfiguration
 			RestartOn,	//!< The engine is always restarted between games
 			RestartOff	//!< The engine is never restarted between games
 		};
+		/*!
+		 * What happens to the engine's optional output lines, eg.
+		 * "info string" in UCI, when it exceeds its output budget.
+		 */
+		enum OutputPolicy
+		{
+			OutputDrop,	//!< The lines are dropped
+			OutputSample	//!< One line in 16 is kept
+		};
 
 		/*! Creates an empty chess engine configuration. */
 		EngineConfiguration();
@@ -83,6 +93,29 @@ class LIB_EXPORT EngineConfiguration
 		 * \sa command()
 		 */
 		void setCommand(const QString& command);
+		/*!
+		 * Sets the shared library that implements the engine.
+		 *
+		 * If \a fileName isn't empty, the engine is loaded from the
+		 * library and run in a thread instead of being started
+		 * with command(). The library must export the interface in
+		 * engineapi.h.
+		 *
+		 * \sa library()
+		 */
+		void setLibrary(const QString& fileName);
+		/*!
+		 * Sets the address of a relay that runs the engine.
+		 *
+		 * If \a address isn't empty, the engine is run by an
+		 * EngineRelay on another host, and it's reached over TCP at
+		 * \a address, given as "host:port". The command, library,
+		 * working directory and standard error file are then the
+		 * relay's business.
+		 *
+		 * \sa remote()
+		 */
+		void setRemote(const QString& address);
 		/*!
 		 * Sets the working directory the engine uses.
 		 *
@@ -115,6 +148,18 @@ class LIB_EXPORT EngineConfiguration
 		 * \sa setCommand()
 		 */
 		QString command() const;
+		/*!
+		 * Returns the shared library that implements the engine.
+		 *
+		 * \sa setLibrary()
+		 */
+		QString library() const;
+		/*!
+		 * Returns the address of a relay that runs the engine.
+		 *
+		 * \sa setRemote()
+		 */
+		QString remote() const;
 		/*!
 		 * Returns the working directory the engine uses.
 		 *
@@ -163,6 +208,17 @@ class LIB_EXPORT EngineConfiguration
 		/*! Sets the list of supported variants to \a variants. */
 		void setSupportedVariants(const QStringList& variants);
 
+		/*!
+		 * Returns the stamp of the engine binary that the options
+		 * and supported variants were detected from.
+		 *
+		 * The stamp is null if the options weren't detected or
+		 * the binary couldn't be identified.
+		 */
+		EngineStamp detectionStamp() const;
+		/*! Sets the detection stamp to \a stamp. */
+		void setDetectionStamp(const EngineStamp& stamp);
+
 		/*! Returns the options sent to the engine. */
 		QList<EngineOption*> options() const;
 		/*! Sets the options sent to the engine. */
@@ -176,6 +232,14 @@ class LIB_EXPORT EngineConfiguration
 		 * EngineTextOption object is added to the configuration.
 		 */
 		void setOption(const QString& name, const QVariant& value);
+		/*!
+		 * Returns the number of search threads the engine is
+		 * configured to use.
+		 *
+		 * The number is read from the "Threads" (UCI) or "cores"
+		 * (Xboard) option. Returns 1 if neither is set.
+		 */
+		int threadCount() const;
 
 		/*! Returns true if evaluation is from white's point of view. */
 		bool whiteEvalPov() const;
@@ -206,6 +270,22 @@ class LIB_EXPORT EngineConfiguration
 		/*! Sets result claim validation mode to \a validate. */
 		void setClaimsValidated(bool validate);
 
+		/*!
+		 * Returns the number of lines per second the engine can
+		 * write before its optional lines are dropped or sampled.
+		 * The default value is 0, which means no limit.
+		 */
+		int outputBudget() const;
+		/*! Sets the output budget to \a linesPerSecond. */
+		void setOutputBudget(int linesPerSecond);
+		/*!
+		 * Returns the policy for optional lines over the output
+		 * budget. The default value is \a OutputDrop.
+		 */
+		OutputPolicy outputPolicy() const;
+		/*! Sets the output policy to \a policy. */
+		void setOutputPolicy(OutputPolicy policy);
+
 		/*!
 		 * Assigns \a other to this engine configuration and returns
 		 * a reference to this object.
@@ -215,6 +295,8 @@ class LIB_EXPORT EngineConfiguration
 	private:
 		QString m_name;
 		QString m_command;
+		QString m_library;
+		QString m_remote;
 		QString m_workingDirectory;
 		QString m_stderrFile;
 		QString m_protocol;
@@ -222,10 +304,13 @@ class LIB_EXPORT EngineConfiguration
 		QStringList m_initStrings;
 		QStringList m_variants;
 		QList<EngineOption*> m_options;
+		EngineStamp m_detectionStamp;
 		bool m_whiteEvalPov;
 		bool m_pondering;
 		bool m_validateClaims;
 		RestartMode m_restartMode;
+		int m_outputBudget;
+		OutputPolicy m_outputPolicy;
 };
 
 #endif // ENGINE_CONFIGURATION_H
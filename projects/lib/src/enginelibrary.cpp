@@ -0,0 +1,235 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "enginelibrary.h"
+#include <QThread>
+#include <QLibrary>
+#include <QFile>
+#include <QVector>
+#include <QMutexLocker>
+#include <functional>
+#include <cstring>
+
+namespace {
+
+class EngineThread : public QThread
+{
+	public:
+		EngineThread(const std::function<void()>& function)
+			: m_function(function)
+		{
+		}
+
+	protected:
+		virtual void run()
+		{
+			m_function();
+		}
+
+	private:
+		std::function<void()> m_function;
+};
+
+} // anonymous namespace
+
+EngineLibrary::EngineLibrary(QObject* parent)
+	: QIODevice(parent),
+	  m_main(nullptr),
+	  m_thread(nullptr),
+	  m_finished(false),
+	  m_inputClosed(false)
+{
+}
+
+EngineLibrary::~EngineLibrary()
+{
+	if (m_thread == nullptr)
+		return;
+
+	closeInput();
+	if (!m_thread->wait(10000))
+	{
+		qWarning("EngineLibrary: waiting for the engine to return");
+		m_thread->wait();
+	}
+	delete m_thread;
+}
+
+bool EngineLibrary::start(const QString& fileName, const QStringList& arguments)
+{
+	Q_ASSERT(m_thread == nullptr);
+
+	// The library stays loaded for the other instances of the engine
+	QLibrary library(fileName);
+	if (!library.load())
+	{
+		setErrorString(library.errorString());
+		return false;
+	}
+
+	m_main = reinterpret_cast<CuteChessEngineMain>(
+		library.resolve(CUTECHESS_ENGINE_MAIN));
+	if (m_main == nullptr)
+	{
+		setErrorString(tr("%1 doesn't export %2")
+			       .arg(fileName, CUTECHESS_ENGINE_MAIN));
+		return false;
+	}
+
+	m_arguments = QStringList() << fileName << arguments;
+	m_thread = new EngineThread([this]() { run(); });
+	connect(m_thread, SIGNAL(finished()), this, SLOT(onFinished()));
+
+	QIODevice::open(ReadWrite | Unbuffered);
+	m_thread->start();
+
+	return true;
+}
+
+void EngineLibrary::run()
+{
+	QVector<QByteArray> args;
+	QVector<const char*> argv;
+	for (const QString& arg : qAsConst(m_arguments))
+		args.append(QFile::encodeName(arg));
+	for (const QByteArray& arg : qAsConst(args))
+		argv.append(arg.constData());
+	argv.append(nullptr);
+
+	CuteChessEngineIo io;
+	io.context = this;
+	io.readLine = &EngineLibrary::readLine;
+	io.writeLine = &EngineLibrary::writeLine;
+
+	m_main(&io, args.size(), argv.constData());
+}
+
+const char* EngineLibrary::readLine(void* context)
+{
+	auto self = static_cast<EngineLibrary*>(context);
+	QMutexLocker locker(&self->m_mutex);
+
+	while (self->m_input.isEmpty() && !self->m_inputClosed)
+		self->m_inputAvailable.wait(&self->m_mutex);
+	if (self->m_input.isEmpty())
+		return nullptr;
+
+	self->m_currentInput = self->m_input.dequeue();
+	return self->m_currentInput.constData();
+}
+
+void EngineLibrary::writeLine(void* context, const char* line)
+{
+	auto self = static_cast<EngineLibrary*>(context);
+	QMutexLocker locker(&self->m_mutex);
+
+	// The reader takes all of the output at once, so a signal is
+	// needed only if there was nothing left to read
+	const bool notify = self->m_output.isEmpty();
+	self->m_output.append(line, int(strlen(line)));
+	self->m_output.append('\n');
+	self->m_lineTimer.start();
+	locker.unlock();
+
+	if (notify)
+		emit self->readyRead();
+}
+
+void EngineLibrary::closeInput()
+{
+	QMutexLocker locker(&m_mutex);
+	m_inputClosed = true;
+	m_inputAvailable.wakeAll();
+}
+
+void EngineLibrary::onFinished()
+{
+	m_finished = true;
+	emit readChannelFinished();
+}
+
+qint64 EngineLibrary::bytesAvailable() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_output.size() + QIODevice::bytesAvailable();
+}
+
+bool EngineLibrary::canReadLine() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_output.contains('\n') || QIODevice::canReadLine();
+}
+
+void EngineLibrary::close()
+{
+	closeInput();
+	QIODevice::close();
+}
+
+bool EngineLibrary::isSequential() const
+{
+	return true;
+}
+
+QElapsedTimer EngineLibrary::lineTimer() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_lineTimer;
+}
+
+qint64 EngineLibrary::readData(char* data, qint64 maxSize)
+{
+	QMutexLocker locker(&m_mutex);
+
+	int n = int(qMin(maxSize, qint64(m_output.size())));
+	if (n <= 0)
+		return m_finished ? -1 : 0;
+
+	memcpy(data, m_output.constData(), size_t(n));
+	m_output.remove(0, n);
+
+	return n;
+}
+
+qint64 EngineLibrary::writeData(const char* data, qint64 maxSize)
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_inputClosed || m_finished)
+		return -1;
+
+	// Only complete lines are passed to the engine
+	m_partialInput.append(data, int(maxSize));
+	int start = 0;
+	for (;;)
+	{
+		int end = m_partialInput.indexOf('\n', start);
+		if (end == -1)
+			break;
+
+		int size = end - start;
+		if (size > 0 && m_partialInput.at(end - 1) == '\r')
+			size--;
+		m_input.enqueue(m_partialInput.mid(start, size));
+		start = end + 1;
+	}
+	m_partialInput.remove(0, start);
+
+	if (start > 0)
+		m_inputAvailable.wakeAll();
+	return maxSize;
+}
@@ -0,0 +1,118 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINELIBRARY_H
+#define ENGINELIBRARY_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QQueue>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include "engineapi.h"
+class QThread;
+
+
+/*!
+ * \brief Runs a chess engine from a shared library in a thread
+ *
+ * EngineLibrary is an alternative to EngineProcess for engines that are
+ * built as shared libraries with the C interface in engineapi.h. The
+ * engine's entry point runs in a dedicated thread, and its input and
+ * output lines go through in-memory queues instead of pipes, so there
+ * are no process start-up costs or system calls per line. The chess
+ * protocol is parsed by the usual ChessEngine subclass.
+ *
+ * Writing to the device sends lines to the engine, and reading from it
+ * returns the engine's output. The readChannelFinished() signal is
+ * emitted when the engine's entry point returns.
+ *
+ * \sa EngineProcess
+ */
+class LIB_EXPORT EngineLibrary : public QIODevice
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new EngineLibrary. */
+		explicit EngineLibrary(QObject* parent = nullptr);
+		/*!
+		 * Destroys the EngineLibrary.
+		 *
+		 * If the engine is still running, its input is closed and
+		 * the destructor waits for the entry point to return.
+		 */
+		virtual ~EngineLibrary();
+
+		// Inherited from QIODevice
+		virtual qint64 bytesAvailable() const;
+		virtual bool canReadLine() const;
+		virtual void close();
+		virtual bool isSequential() const;
+
+		/*!
+		 * Loads the engine library \a fileName and starts its
+		 * entry point with \a arguments in a new thread.
+		 *
+		 * Returns true if successful; otherwise returns false and
+		 * sets errorString().
+		 */
+		bool start(const QString& fileName,
+			   const QStringList& arguments = QStringList());
+
+		/*!
+		 * Returns a timer that was started when the engine wrote its
+		 * last line of output.
+		 *
+		 * The timer is invalid if no line has been written yet.
+		 */
+		QElapsedTimer lineTimer() const;
+
+	protected:
+		// Inherited from QIODevice
+		virtual qint64 readData(char* data, qint64 maxSize);
+		virtual qint64 writeData(const char* data, qint64 maxSize);
+
+	private slots:
+		void onFinished();
+
+	private:
+		static const char* readLine(void* context);
+		static void writeLine(void* context, const char* line);
+
+		void run();
+		void closeInput();
+
+		CuteChessEngineMain m_main;
+		QStringList m_arguments;
+		QThread* m_thread;
+		bool m_finished;
+
+		mutable QMutex m_mutex;
+		QWaitCondition m_inputAvailable;
+		QQueue<QByteArray> m_input;
+		QByteArray m_partialInput;
+		QByteArray m_currentInput;
+		bool m_inputClosed;
+		QByteArray m_output;
+		QElapsedTimer m_lineTimer;
+};
+
+#endif // ENGINELIBRARY_H
@@ -18,18 +18,81 @@
 
 #include "enginemanager.h"
 #include <QFile>
+#include <QSaveFile>
 #include <QTextStream>
-#include <jsonparser.h>
+#include <QTimer>
+#include <QThreadPool>
+#include <QRunnable>
+#include <jsonreader.h>
 #include <jsonserializer.h>
 
+namespace {
+
+void writeEngines(const QList<EngineConfiguration>& engines,
+		  const QString& fileName)
+{
+	QVariantList list;
+	list.reserve(engines.size());
+	for (const EngineConfiguration& config : engines)
+		list << config.toVariant();
+
+	// The old file stays intact until the new one is complete
+	QSaveFile output(fileName);
+	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qWarning("cannot open engine configuration file: %s",
+			 qUtf8Printable(fileName));
+		return;
+	}
+
+	QTextStream out(&output);
+	JsonSerializer serializer(list);
+	serializer.serialize(out);
+	out.flush();
+
+	if (!output.commit())
+		qWarning("cannot write engine configuration file: %s",
+			 qUtf8Printable(fileName));
+}
+
+/*! Saves a snapshot of the engines. */
+class SaveTask : public QRunnable
+{
+	public:
+		SaveTask(const QList<EngineConfiguration>& engines,
+			 const QString& fileName)
+			: m_engines(engines),
+			  m_fileName(fileName)
+		{
+		}
+
+		// Inherited from QRunnable
+		virtual void run()
+		{
+			writeEngines(m_engines, m_fileName);
+		}
+
+	private:
+		const QList<EngineConfiguration> m_engines;
+		const QString m_fileName;
+};
+
+} // anonymous namespace
+
 
 EngineManager::EngineManager(QObject* parent)
-	: QObject(parent)
+	: QObject(parent),
+	  m_saveTimer(new QTimer(this)),
+	  m_savePool(new QThreadPool(this))
 {
+	m_saveTimer->setSingleShot(true);
+	connect(m_saveTimer, SIGNAL(timeout()), this, SLOT(startSave()));
+	m_savePool->setMaxThreadCount(1);
 }
 
 EngineManager::~EngineManager()
 {
+	waitForSave();
 }
 
 int EngineManager::engineCount() const
@@ -42,9 +105,29 @@ EngineConfiguration EngineManager::engineAt(int index) const
 	return m_engines.at(index);
 }
 
+void EngineManager::indexEngine(int index)
+{
+	const EngineConfiguration& engine = m_engines.at(index);
+	m_nameIndex[engine.name()].append(index);
+
+	QStringList variants(engine.supportedVariants());
+	variants.removeDuplicates();
+	for (const QString& variant : qAsConst(variants))
+		m_variantCounts[variant]++;
+}
+
+void EngineManager::rebuildIndex()
+{
+	m_nameIndex.clear();
+	m_variantCounts.clear();
+	for (int i = 0; i < m_engines.size(); i++)
+		indexEngine(i);
+}
+
 void EngineManager::addEngine(const EngineConfiguration& engine)
 {
 	m_engines << engine;
+	indexEngine(m_engines.size() - 1);
 
 	emit engineAdded(m_engines.size() - 1);
 }
@@ -52,6 +135,7 @@ void EngineManager::addEngine(const EngineConfiguration& engine)
 void EngineManager::updateEngineAt(int index, const EngineConfiguration& engine)
 {
 	m_engines[index] = engine;
+	rebuildIndex();
 
 	emit engineUpdated(index);
 }
@@ -61,6 +145,7 @@ void EngineManager::removeEngineAt(int index)
 	emit engineAboutToBeRemoved(index);
 
 	m_engines.removeAt(index);
+	rebuildIndex();
 }
 
 QList<EngineConfiguration> EngineManager::engines() const
@@ -71,6 +156,7 @@ QList<EngineConfiguration> EngineManager::engines() const
 void EngineManager::setEngines(const QList<EngineConfiguration>& engines)
 {
 	m_engines = engines;
+	rebuildIndex();
 
 	emit enginesReset();
 }
@@ -80,13 +166,7 @@ bool EngineManager::supportsVariant(const QString& variant) const
 	if (m_engines.isEmpty())
 		return false;
 
-	for (const auto& config : qAsConst(m_engines))
-	{
-		if (!config.supportsVariant(variant))
-			return false;
-	}
-
-	return true;
+	return m_variantCounts.value(variant) == m_engines.size();
 }
 
 void EngineManager::loadEngines(const QString& fileName)
@@ -95,16 +175,26 @@ void EngineManager::loadEngines(const QString& fileName)
 		return;
 
 	QFile input(fileName);
-	if (!input.open(QIODevice::ReadOnly | QIODevice::Text))
+	if (!input.open(QIODevice::ReadOnly))
 	{
 		qWarning("cannot open engine configuration file: %s",
 			 qUtf8Printable(fileName));
 		return;
 	}
 
-	QTextStream stream(&input);
-	JsonParser parser(stream);
-	const QVariantList engines(parser.parse().toList());
+	// Parse the file in place when it can be mapped to memory
+	QByteArray data;
+	qint64 size = input.size();
+	auto bytes = reinterpret_cast<const char*>(input.map(0, size));
+	if (bytes == nullptr)
+	{
+		data = input.readAll();
+		bytes = data.constData();
+		size = data.size();
+	}
+
+	JsonReader parser(bytes, size);
+	const QVariantList engines(parser.readVariant().toList());
 
 	if (parser.hasError())
 	{
@@ -119,28 +209,72 @@ void EngineManager::loadEngines(const QString& fileName)
 
 void EngineManager::saveEngines(const QString& fileName)
 {
-	QVariantList engines;
-	for (const EngineConfiguration& config : qAsConst(m_engines))
-		engines << config.toVariant();
+	// A queued save must not overwrite this one later
+	waitForSave();
+	writeEngines(m_engines, fileName);
+}
 
-	QFile output(fileName);
-	if (!output.open(QIODevice::WriteOnly | QIODevice::Text))
+void EngineManager::saveEnginesLater(const QString& fileName, int delay)
+{
+	if (m_saveTimer->isActive() && fileName != m_saveFileName)
+		startSave();
+
+	m_saveFileName = fileName;
+	m_saveTimer->start(delay);
+}
+
+void EngineManager::startSave()
+{
+	m_saveTimer->stop();
+
+	// The list is copied on write, so the snapshot is cheap and the
+	// engines can be edited while the save is running
+	m_savePool->start(new SaveTask(m_engines, m_saveFileName));
+}
+
+void EngineManager::waitForSave()
+{
+	if (m_saveTimer->isActive())
+		startSave();
+	m_savePool->waitForDone();
+}
+
+int EngineManager::detectedEngineIndex(const EngineStamp& stamp,
+					const QString& protocol) const
+{
+	if (stamp.isNull())
+		return -1;
+
+	for (int i = 0; i < m_engines.size(); i++)
 	{
-		qWarning("cannot open engine configuration file: %s",
-			 qUtf8Printable(fileName));
-		return;
+		const EngineConfiguration& engine = m_engines.at(i);
+		if (engine.protocol() == protocol
+		&&  engine.detectionStamp() == stamp)
+			return i;
 	}
 
-	QTextStream out(&output);
-	JsonSerializer serializer(engines);
-	serializer.serialize(out);
+	return -1;
 }
 
 QSet<QString> EngineManager::engineNames() const
 {
 	QSet<QString> names;
-	for (const EngineConfiguration& engine : qAsConst(m_engines))
-		names.insert(engine.name());
+	names.reserve(m_nameIndex.size());
+	for (auto it = m_nameIndex.constBegin(); it != m_nameIndex.constEnd(); ++it)
+		names.insert(it.key());
 
 	return names;
 }
+
+int EngineManager::engineIndex(const QString& name) const
+{
+	const auto it = m_nameIndex.constFind(name);
+	if (it == m_nameIndex.constEnd())
+		return -1;
+	return it->first();
+}
+
+int EngineManager::engineNameCount(const QString& name) const
+{
+	return m_nameIndex.value(name).size();
+}
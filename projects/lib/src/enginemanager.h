@@ -20,11 +20,19 @@
 #define ENGINE_MANAGER_H
 
 #include <QSet>
+#include <QHash>
+#include <QVector>
 #include "engineconfiguration.h"
+class QTimer;
+class QThreadPool;
 
 /*!
  * \brief Manages chess engines and their configurations.
  *
+ * The engines are indexed by name and by supported variant, so
+ * looking up an engine by its name and checking variant support
+ * take constant time regardless of the number of engines.
+ *
  * \sa EngineConfiguration
  */
 class LIB_EXPORT EngineManager : public QObject
@@ -61,9 +69,46 @@ class LIB_EXPORT EngineManager : public QObject
 
 		void loadEngines(const QString& fileName);
 		void saveEngines(const QString& fileName);
+		/*!
+		 * Saves the engines to \a fileName in the background after
+		 * \a delay milliseconds.
+		 *
+		 * Another call within the delay postpones the save, so a
+		 * burst of changes is written only once. The engines are
+		 * serialized from a snapshot in a worker thread, and the
+		 * file is replaced atomically.
+		 *
+		 * \sa waitForSave()
+		 */
+		void saveEnginesLater(const QString& fileName, int delay = 500);
+		/*!
+		 * Starts a pending save immediately and waits until all
+		 * saves are finished.
+		 *
+		 * This is called by the destructor.
+		 */
+		void waitForSave();
+
+		/*!
+		 * Returns the index of an engine whose options were
+		 * detected from the binary identified by \a stamp with
+		 * protocol \a protocol, or -1 if there's no such engine.
+		 *
+		 * The options and variants of that engine can be used
+		 * instead of starting the engine to detect them again.
+		 */
+		int detectedEngineIndex(const EngineStamp& stamp,
+					const QString& protocol) const;
 
 		/*! Returns the names of all configured engines. */
 		QSet<QString> engineNames() const;
+		/*!
+		 * Returns the index of the first engine named \a name,
+		 * or -1 if there is no such engine.
+		 */
+		int engineIndex(const QString& name) const;
+		/*! Returns the number of engines named \a name. */
+		int engineNameCount(const QString& name) const;
 
 	signals:
 		/*!
@@ -82,9 +127,22 @@ class LIB_EXPORT EngineManager : public QObject
 		/*! Emitted when an engine is updated at \a index. */
 		void engineUpdated(int index);
 
+	private slots:
+		void startSave();
+
 	private:
-		QList<EngineConfiguration> m_engines;
+		void indexEngine(int index);
+		void rebuildIndex();
 
+		QList<EngineConfiguration> m_engines;
+		// Engine indexes by name, in ascending order
+		QHash<QString, QVector<int>> m_nameIndex;
+		// Number of engines supporting each variant
+		QHash<QString, int> m_variantCounts;
+		QString m_saveFileName;
+		QTimer* m_saveTimer;
+		// Runs the saves one at a time, in order
+		QThreadPool* m_savePool;
 };
 
 #endif // ENGINE_MANAGER_H
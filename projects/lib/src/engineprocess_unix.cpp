@@ -0,0 +1,490 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engineprocess_unix.h"
+#include <QDir>
+#include <QFile>
+#include <QRegExp>
+#include <QTimer>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QVector>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#ifdef Q_OS_MACOS
+  #include <crt_externs.h>
+  #define environ (*_NSGetEnviron())
+#else
+  extern char** environ;
+#endif
+#include "pipereader_unix.h"
+
+// posix_spawn can change the child's working directory only with
+// glibc 2.29 or later and macOS 10.15 or later. Older systems fall
+// back to fork and exec.
+#if defined(Q_OS_MACOS)
+  #define ENGINEPROCESS_SPAWN_CHDIR
+#elif defined(__GLIBC__)
+  #if __GLIBC_PREREQ(2, 29)
+    #define ENGINEPROCESS_SPAWN_CHDIR
+  #endif
+#endif
+
+
+EngineProcess::EngineProcess(QObject* parent)
+	: QIODevice(parent),
+	  m_started(false),
+	  m_finished(false),
+	  m_exitCode(0),
+	  m_exitStatus(EngineProcess::NormalExit),
+	  m_stdErrFileMode(Truncate),
+	  m_pid(-1),
+	  m_inWrite(-1),
+	  m_outRead(-1),
+	  m_reader(nullptr)
+{
+}
+
+EngineProcess::~EngineProcess()
+{
+	if (m_started)
+	{
+		qWarning("EngineProcess: Destroyed while process is still running.");
+		kill();
+		waitForFinished();
+	}
+	cleanup();
+}
+
+int EngineProcess::exitCode() const
+{
+	return m_exitCode;
+}
+
+EngineProcess::ExitStatus EngineProcess::exitStatus() const
+{
+	return m_exitStatus;
+}
+
+qint64 EngineProcess::processId() const
+{
+	return m_started ? qint64(m_pid) : 0;
+}
+
+QElapsedTimer EngineProcess::lineTimer() const
+{
+	if (m_reader == nullptr)
+		return QElapsedTimer();
+	return m_reader->lineTimer();
+}
+
+qint64 EngineProcess::bytesAvailable() const
+{
+	qint64 n = QIODevice::bytesAvailable();
+
+	if (!m_started)
+		return n;
+	return m_reader->bytesAvailable() + n;
+}
+
+bool EngineProcess::canReadLine() const
+{
+	if (!m_started)
+		return QIODevice::canReadLine();
+	return m_reader->canReadLine() || QIODevice::canReadLine();
+}
+
+void EngineProcess::closeFd(int* fd)
+{
+	if (*fd == -1)
+		return;
+	::close(*fd);
+	*fd = -1;
+}
+
+void EngineProcess::cleanup()
+{
+	// Deleting the reader unregisters it from the reactor thread,
+	// so the pipe can be closed safely afterwards.
+	delete m_reader;
+	m_reader = nullptr;
+
+	closeFd(&m_inWrite);
+	closeFd(&m_outRead);
+
+	m_pid = -1;
+	m_started = false;
+}
+
+void EngineProcess::close()
+{
+	if (!m_started)
+		return;
+
+	emit aboutToClose();
+	kill();
+	waitForFinished(-1);
+	cleanup();
+	QIODevice::close();
+}
+
+bool EngineProcess::isSequential() const
+{
+	return true;
+}
+
+void EngineProcess::setWorkingDirectory(const QString& dir)
+{
+	m_workDir = dir;
+}
+
+void EngineProcess::setStandardErrorFile(const QString& fileName, OpenMode mode)
+{
+	m_stdErrFile = fileName;
+	m_stdErrFileMode = mode;
+}
+
+QStringList EngineProcess::splitCommand(const QString& command)
+{
+	QStringList args;
+
+	QRegExp rx("((?:[^\\s\"]+)|(?:\"(?:\\\\\"|[^\"])*\"))");
+	int pos = 0;
+	while ((pos = rx.indexIn(command, pos)) != -1)
+	{
+		QString arg = rx.cap();
+		if (arg.size() >= 2 && arg.startsWith('\"') && arg.endsWith('\"'))
+			arg = arg.mid(1, arg.size() - 2).replace("\\\"", "\"");
+		args << arg;
+		pos += rx.matchedLength();
+	}
+
+	return args;
+}
+
+QString EngineProcess::programPath(const QString& wdir, const QString& prog)
+{
+	// Programs without a path are searched from PATH and relative
+	// paths are relative to the working directory, like in QProcess.
+	if (!prog.contains('/') || wdir.isEmpty() || QDir::isAbsolutePath(prog))
+		return prog;
+	return QDir(wdir).absoluteFilePath(prog);
+}
+
+bool EngineProcess::createPipe(int fds[2])
+{
+	// Neither end of the pipe may leak into engines that other
+	// threads start at the same time.
+#ifdef Q_OS_LINUX
+	return pipe2(fds, O_CLOEXEC) == 0;
+#else
+	if (pipe(fds) != 0)
+		return false;
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	return true;
+#endif
+}
+
+int EngineProcess::openFile(const QString& fileName, OpenMode mode)
+{
+	if (fileName.isEmpty())
+		return ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+	int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+	if (mode == Append)
+		flags |= O_APPEND;
+	else
+		flags |= O_TRUNC;
+
+	return ::open(QFile::encodeName(fileName).constData(), flags, 0666);
+}
+
+pid_t EngineProcess::spawn(const QString& program,
+			   const QStringList& arguments,
+			   int inRead,
+			   int outWrite,
+			   int errWrite)
+{
+	QByteArray path = QFile::encodeName(programPath(m_workDir, program));
+	QByteArray wdir = QFile::encodeName(m_workDir);
+
+	QList<QByteArray> args;
+	args << QFile::encodeName(program);
+	for (const QString& arg : arguments)
+		args << arg.toLocal8Bit();
+
+	QVector<char*> argv;
+	argv.reserve(args.size() + 1);
+	for (QByteArray& arg : args)
+		argv << arg.data();
+	argv << nullptr;
+
+	pid_t pid = -1;
+	int err = 0;
+
+#ifdef ENGINEPROCESS_SPAWN_CHDIR
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, inRead, STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, outWrite, STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, errWrite, STDERR_FILENO);
+	if (!wdir.isEmpty())
+		posix_spawn_file_actions_addchdir_np(&actions, wdir.constData());
+
+	// SIGPIPE is ignored in this process but not in the engine
+	sigset_t sigDefault;
+	sigemptyset(&sigDefault);
+	sigaddset(&sigDefault, SIGPIPE);
+	sigset_t sigMask;
+	sigemptyset(&sigMask);
+
+	short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+  #ifdef Q_OS_MACOS
+	flags |= POSIX_SPAWN_CLOEXEC_DEFAULT;
+  #endif
+
+	posix_spawnattr_t attr;
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setflags(&attr, flags);
+	posix_spawnattr_setsigdefault(&attr, &sigDefault);
+	posix_spawnattr_setsigmask(&attr, &sigMask);
+
+	err = posix_spawnp(&pid, path.constData(), &actions, &attr,
+			   argv.data(), environ);
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&actions);
+#else // not ENGINEPROCESS_SPAWN_CHDIR
+	pid = fork();
+	if (pid == 0)
+	{
+		if (!wdir.isEmpty() && chdir(wdir.constData()) != 0)
+			_exit(127);
+		dup2(inRead, STDIN_FILENO);
+		dup2(outWrite, STDOUT_FILENO);
+		dup2(errWrite, STDERR_FILENO);
+		signal(SIGPIPE, SIG_DFL);
+		execvp(path.constData(), argv.data());
+		_exit(127);
+	}
+	if (pid == -1)
+		err = errno;
+#endif // not ENGINEPROCESS_SPAWN_CHDIR
+
+	if (err != 0)
+	{
+		qWarning("EngineProcess: cannot start %s: %s",
+			 path.constData(), strerror(err));
+		return -1;
+	}
+	return pid;
+}
+
+void EngineProcess::start(const QString& program,
+			  const QStringList& arguments,
+			  OpenMode mode)
+{
+	if (m_started)
+		close();
+
+	m_started = false;
+	m_finished = false;
+	m_exitCode = 0;
+	m_exitStatus = NormalExit;
+
+	// Temporary descriptors for the child process' end of the pipes
+	int inPipe[2] = { -1, -1 };
+	int outPipe[2] = { -1, -1 };
+	int errWrite = openFile(m_stdErrFile, m_stdErrFileMode);
+
+	if (errWrite != -1 && createPipe(inPipe) && createPipe(outPipe))
+	{
+		m_inWrite = inPipe[1];
+		m_outRead = outPipe[0];
+		fcntl(m_outRead, F_SETFL, fcntl(m_outRead, F_GETFL) | O_NONBLOCK);
+
+		m_pid = spawn(program, arguments, inPipe[0], outPipe[1], errWrite);
+	}
+	else
+	{
+		closeFd(&inPipe[1]);
+		closeFd(&outPipe[0]);
+	}
+
+	// Close the child process' ends of the pipes to make sure that
+	// the reader sees the end of the pipe when the child terminates
+	closeFd(&inPipe[0]);
+	closeFd(&outPipe[1]);
+	closeFd(&errWrite);
+
+	m_started = (m_pid != -1);
+	if (m_started)
+	{
+		// Start reading input from the child
+		m_reader = new PipeReader(m_outRead, this);
+		connect(m_reader, SIGNAL(finished()), this, SLOT(onFinished()));
+		connect(m_reader, SIGNAL(finished()), this, SIGNAL(readChannelFinished()));
+		connect(m_reader, SIGNAL(readyRead()), this, SIGNAL(readyRead()));
+
+		// Make QIODevice aware that the device is now open
+		QIODevice::open(mode);
+	}
+	else
+		cleanup();
+}
+
+void EngineProcess::start(const QString& program,
+			  OpenMode mode)
+{
+	QStringList args = splitCommand(program);
+	if (args.isEmpty())
+		return;
+
+	QString prog = args.first();
+	args.removeFirst();
+	start(prog, args, mode);
+}
+
+void EngineProcess::kill()
+{
+	if (m_started)
+		::kill(m_pid, SIGKILL);
+}
+
+bool EngineProcess::reap(bool block)
+{
+	int status = 0;
+	pid_t ret;
+	do
+		ret = waitpid(m_pid, &status, block ? 0 : WNOHANG);
+	while (ret == -1 && errno == EINTR);
+
+	if (ret == 0)
+		return false;
+
+	if (ret == -1)
+	{
+		qWarning("EngineProcess: waitpid failed: %s", strerror(errno));
+		m_exitCode = -1;
+		m_exitStatus = CrashExit;
+	}
+	else if (WIFEXITED(status))
+	{
+		m_exitCode = WEXITSTATUS(status);
+		m_exitStatus = NormalExit;
+	}
+	else
+	{
+		m_exitCode = WIFSIGNALED(status) ? WTERMSIG(status) : -1;
+		m_exitStatus = CrashExit;
+	}
+	return true;
+}
+
+void EngineProcess::setFinished()
+{
+	m_finished = true;
+	cleanup();
+	emit finished(m_exitCode, m_exitStatus);
+}
+
+void EngineProcess::onFinished()
+{
+	if (!m_started || m_finished || !m_reader->isFinished())
+		return;
+
+	// The child may close its output a moment before it exits
+	if (!reap(false))
+	{
+		QTimer::singleShot(10, this, SLOT(onFinished()));
+		return;
+	}
+	setFinished();
+}
+
+bool EngineProcess::waitForFinished(int msecs)
+{
+	if (!m_started)
+		return true;
+
+	if (msecs == -1)
+		reap(true);
+	else
+	{
+		QElapsedTimer timer;
+		timer.start();
+		while (!reap(false))
+		{
+			if (timer.hasExpired(msecs))
+				return false;
+			QThread::usleep(500);
+		}
+	}
+
+	setFinished();
+	return true;
+}
+
+bool EngineProcess::waitForStarted(int msecs)
+{
+	// Don't wait here because posix_spawn already did the waiting
+	Q_UNUSED(msecs);
+	return m_started;
+}
+
+QString EngineProcess::workingDirectory() const
+{
+	return m_workDir;
+}
+
+qint64 EngineProcess::readData(char* data, qint64 maxSize)
+{
+	if (!m_started)
+		return -1;
+
+	return m_reader->readData(data, maxSize);
+}
+
+qint64 EngineProcess::writeData(const char* data, qint64 maxSize)
+{
+	if (!m_started)
+		return -1;
+
+	// The engine's input pipe is blocking, so everything is written
+	// unless the pipe breaks.
+	qint64 written = 0;
+	while (written < maxSize)
+	{
+		ssize_t n = ::write(m_inWrite, data + written,
+				    size_t(maxSize - written));
+		if (n == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return written > 0 ? written : -1;
+		}
+		written += n;
+	}
+	return written;
+}
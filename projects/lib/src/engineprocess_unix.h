@@ -0,0 +1,194 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINEPROCESS_UNIX_H
+#define ENGINEPROCESS_UNIX_H
+
+#include <sys/types.h>
+#include <QIODevice>
+#include <QString>
+#include <QElapsedTimer>
+#include <QStringList>
+class PipeReader;
+
+
+/*!
+ * \brief A replacement for QProcess on Linux and macOS
+ *
+ * QProcess needs a socket notifier per pipe and event loop dispatch in
+ * the owning thread before a chess engine's output is even read.
+ * EngineProcess starts the engine with posix_spawn and lets a
+ * PipeReader read its output as soon as it arrives. All engines share
+ * the same epoll/kqueue reactor thread. The interface is the same as
+ * QProcess' with some unneeded features left out.
+ *
+ * \sa QProcess
+ * \sa PipeReader
+ */
+class LIB_EXPORT EngineProcess : public QIODevice
+{
+	Q_OBJECT
+
+	public:
+		/*! The process' exit status. */
+		enum ExitStatus
+		{
+			NormalExit,	//!< The process exited normally
+			CrashExit	//!< The process crashed
+		};
+
+		/*! Creates a new EngineProcess. */
+		explicit EngineProcess(QObject* parent = nullptr);
+		/*!
+		 * Destructs the EngineProcess and frees all resources.
+		 * If the process is still running, it is killed.
+		 */
+		virtual ~EngineProcess();
+
+		// Inherited from QIODevice
+		virtual qint64 bytesAvailable() const;
+		virtual bool canReadLine() const;
+		virtual void close();
+		virtual bool isSequential() const;
+
+		/*! Returns the exit code of the last process that finished. */
+		int exitCode() const;
+		/*! Returns the exit status of the last process that finished. */
+		ExitStatus exitStatus() const;
+		/*!
+		 * Returns the native process identifier of the running
+		 * process, or 0 if no process is running.
+		 */
+		qint64 processId() const;
+		/*!
+		 * Returns a timer that was started when the last complete
+		 * line of output was read from the process.
+		 *
+		 * Unlike the readyRead() signal this isn't delayed by the
+		 * owning thread's event loop. The timer is invalid if no
+		 * line has been read yet.
+		 */
+		QElapsedTimer lineTimer() const;
+
+		/*!
+		 * Returns the process' working directory.
+		 * Returns an empty string if the working directory wasn't
+		 * set with setWorkingDirectory().
+		 */
+		QString workingDirectory() const;
+		/*!
+		 * Sets the working directory to dir.
+		 * EngineProcess will start the process in this directory.
+		 */
+		void setWorkingDirectory(const QString& dir);
+		/*!
+		 * Redirects the process' standard error to the file fileName.
+		 * The file will be appended to if mode is Append; otherwise
+		 * it will be truncated. If no file is set the standard
+		 * error is discarded.
+		 */
+		void setStandardErrorFile(const QString& fileName,
+					  OpenMode mode = Truncate);
+
+		/*!
+		 * Starts the program \a program in a new process, passing the
+		 * command line arguments in \a arguments. The OpenMode is set
+		 * to \a mode.
+		 *
+		 * \note Unlike the same function in QProcess, this one will
+		 * block until the process has started.
+		 *
+		 * \note To check if the process started successfully, call
+		 * the waitForStarted() method.
+		 */
+		void start(const QString& program,
+			   const QStringList& arguments,
+			   OpenMode mode = ReadWrite);
+		/*! Starts the program \a program with OpenMode \a mode. */
+		void start(const QString& program,
+			   OpenMode mode = ReadWrite);
+
+		/*!
+		 * Blocks until the process has finished and the finished()
+		 * signal has been emitted.
+		 *
+		 * Times out after \a msecs milliseconds. If \a msecs is -1
+		 * the function will not time out.
+		 *
+		 * \return true if the process finished.
+		 */
+		bool waitForFinished(int msecs = 30000);
+
+		/*!
+		 * Returns true if the process started successfully.
+		 * Doesn't really wait for anything since the start() method
+		 * already did the waiting.
+		 */
+		bool waitForStarted(int msecs = 30000);
+
+	public slots:
+		/*! Kills the process, causing it to exit immediately. */
+		void kill();
+
+	signals:
+		/*!
+		 * Emitted when the process finishes.
+		 * \param exitCode exit code of the process
+		 * \param exitStatus exit status of the process
+		 */
+		void finished(int exitCode, ExitStatus exitStatus);
+
+	protected:
+		// Inherited from QIODevice
+		virtual qint64 readData(char* data, qint64 maxSize);
+		virtual qint64 writeData(const char* data, qint64 maxSize);
+
+	private slots:
+		void onFinished();
+
+	private:
+		static QStringList splitCommand(const QString& command);
+		static QString programPath(const QString& wdir,
+					   const QString& prog);
+		static bool createPipe(int fds[2]);
+		static int openFile(const QString& fileName, OpenMode mode);
+		static void closeFd(int* fd);
+
+		void cleanup();
+		bool reap(bool block);
+		void setFinished();
+		pid_t spawn(const QString& program,
+			    const QStringList& arguments,
+			    int inRead,
+			    int outWrite,
+			    int errWrite);
+
+		bool m_started;
+		bool m_finished;
+		int m_exitCode;
+		ExitStatus m_exitStatus;
+		QString m_workDir;
+		QString m_stdErrFile;
+		OpenMode m_stdErrFileMode;
+		pid_t m_pid;
+		int m_inWrite;
+		int m_outRead;
+		PipeReader* m_reader;
+};
+
+#endif // ENGINEPROCESS_UNIX_H
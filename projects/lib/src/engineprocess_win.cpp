@@ -62,6 +62,18 @@ EngineProcess::ExitStatus EngineProcess::exitStatus() const
 	return m_exitStatus;
 }
 
+qint64 EngineProcess::processId() const
+{
+	return m_started ? qint64(m_processInfo.dwProcessId) : 0;
+}
+
+QElapsedTimer EngineProcess::lineTimer() const
+{
+	if (m_reader == 0)
+		return QElapsedTimer();
+	return m_reader->lineTimer();
+}
+
 qint64 EngineProcess::bytesAvailable() const
 {
 	qint64 n = QIODevice::bytesAvailable();
@@ -89,16 +101,8 @@ void EngineProcess::killHandle(HANDLE* handle)
 
 void EngineProcess::cleanup()
 {
-	if (m_reader != 0)
-	{
-		if (m_reader->isRunning())
-		{
-			qWarning("EngineProcess: pipe reader was terminated");
-			m_reader->terminate();
-		}
-		delete m_reader;
-		m_reader = 0;
-	}
+	delete m_reader;
+	m_reader = 0;
 
 	killHandle(&m_inWrite);
 	killHandle(&m_outRead);
@@ -259,13 +263,19 @@ void EngineProcess::start(const QString& program,
 	HANDLE outWrite;
 	HANDLE inRead;
 
-	// Security attributes. Use the same one for both pipes.
+	// Security attributes for the input pipe
 	SECURITY_ATTRIBUTES saAttr;
 	saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
 	saAttr.bInheritHandle = TRUE;
 	saAttr.lpSecurityDescriptor = NULL;
 
-	CreatePipe(&m_outRead, &outWrite, &saAttr, 0);
+	// The output pipe is read with overlapped I/O on the pipe
+	// readers' shared completion port
+	if (!PipeReader::createPipe(&m_outRead, &outWrite, true))
+	{
+		cleanup();
+		return;
+	}
 	CreatePipe(&inRead, &m_inWrite, &saAttr, 0);
 
 	STARTUPINFO startupInfo;
@@ -276,15 +286,8 @@ void EngineProcess::start(const QString& program,
 	startupInfo.hStdInput = inRead;
 	startupInfo.dwFlags |= STARTF_USESTDHANDLES;
 
-	// Call DuplicateHandle with a NULL target to get non-inheritable
-	// handles for the parent process' ends of the pipes
-	DuplicateHandle(GetCurrentProcess(),
-			m_outRead,		// child's stdout read end
-			GetCurrentProcess(),
-			NULL,			// no target
-			0,			// flags
-			FALSE,			// not inheritable
-			DUPLICATE_SAME_ACCESS);	// same handle access
+	// Call DuplicateHandle with a NULL target to get a non-inheritable
+	// handle for the parent process' end of the input pipe
 	DuplicateHandle(GetCurrentProcess(),
 			m_inWrite,		// child's stdin write end
 			GetCurrentProcess(),
@@ -341,7 +344,6 @@ void EngineProcess::start(const QString& program,
 		connect(m_reader, SIGNAL(finished()), this, SLOT(onFinished()));
 		connect(m_reader, SIGNAL(finished()), this, SIGNAL(readChannelFinished()));
 		connect(m_reader, SIGNAL(readyRead()), this, SIGNAL(readyRead()));
-		m_reader->start();
 
 		// Make QIODevice aware that the device is now open
 		QIODevice::open(mode);
@@ -389,7 +391,6 @@ void EngineProcess::onFinished()
 		if (m_exitCode != 0)
 			m_exitStatus = CrashExit;
 
-		Q_ASSERT(m_reader == 0 || m_reader->isFinished());
 		cleanup();
 		emit finished((int)m_exitCode, m_exitStatus);
 	}
@@ -409,11 +410,14 @@ bool EngineProcess::waitForFinished(int msecs)
 	DWORD ret = WaitForSingleObject(m_processInfo.hProcess, dwWait);
 	if (ret == WAIT_OBJECT_0)
 	{
-		// The blocking ReadFile call in the pipe reader should
-		// return now that the pipes are closed. But if it doesn't
-		// happen, the pipe reader will be terminated violently
-		// after the timeout.
-		m_reader->wait(10000);
+		// The pipe reader should see the end of the pipe now that
+		// the child's end is closed
+		QElapsedTimer timer;
+		timer.start();
+		while (!m_reader->isFinished() && !timer.hasExpired(10000))
+			Sleep(1);
+		if (!m_reader->isFinished())
+			qWarning("EngineProcess: pipe reader didn't finish");
 		onFinished();
 
 		return true;
@@ -22,6 +22,7 @@
 #include <windows.h>
 #include <QIODevice>
 #include <QString>
+#include <QElapsedTimer>
 #include <QMutex>
 class PipeReader;
 
@@ -34,7 +35,13 @@ class PipeReader;
  * new data immediately (no polling) when it's available. The interface is
  * the same as QProcess' with some unneeded features left out.
  *
- * On non-Windows platforms EngineProcess is just a typedef to QProcess.
+ * The engine's output is read with overlapped I/O by a PipeReader. All
+ * engines share the same I/O completion port thread, so the number of
+ * threads doesn't grow with the number of engines.
+ *
+ * On Linux and macOS EngineProcess is implemented with posix_spawn and
+ * an epoll/kqueue reactor. On other platforms it's just a typedef to
+ * QProcess.
  *
  * \sa QProcess
  * \sa PipeReader
@@ -69,6 +76,20 @@ class LIB_EXPORT EngineProcess : public QIODevice
 		int exitCode() const;
 		/*! Returns the exit status of the last process that finished. */
 		ExitStatus exitStatus() const;
+		/*!
+		 * Returns the native process identifier of the running
+		 * process, or 0 if no process is running.
+		 */
+		qint64 processId() const;
+		/*!
+		 * Returns a timer that was started when the last complete
+		 * line of output was read from the process.
+		 *
+		 * Unlike the readyRead() signal this isn't delayed by the
+		 * owning thread's event loop. The timer is invalid if no
+		 * line has been read yet.
+		 */
+		QElapsedTimer lineTimer() const;
 
 		/*!
 		 * Returns the process' working directory.
@@ -0,0 +1,174 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "enginerelay.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include "enginebuilder.h"
+#include "enginesocket.h"
+
+namespace {
+
+struct RelaySession
+{
+	// Input lines received from the client, and when the last
+	// of them was received
+	qint64 lines;
+	QElapsedTimer inputTimer;
+	// Incomplete line of the engine's output
+	QByteArray output;
+};
+
+} // anonymous namespace
+
+EngineRelay::EngineRelay(const EngineConfiguration& config, QObject* parent)
+	: QObject(parent),
+	  m_config(config),
+	  m_server(new QTcpServer(this))
+{
+	connect(m_server, SIGNAL(newConnection()),
+		this, SLOT(onNewConnection()));
+}
+
+bool EngineRelay::listen(const QHostAddress& address, quint16 port)
+{
+	if (!m_server->listen(address, port))
+	{
+		m_error = m_server->errorString();
+		return false;
+	}
+	return true;
+}
+
+quint16 EngineRelay::serverPort() const
+{
+	return m_server->serverPort();
+}
+
+QString EngineRelay::errorString() const
+{
+	return m_error;
+}
+
+void EngineRelay::stop()
+{
+	m_server->close();
+
+	const auto sockets = m_server->findChildren<QTcpSocket*>();
+	for (QTcpSocket* socket : sockets)
+		socket->abort();
+
+	emit finished();
+}
+
+void EngineRelay::onNewConnection()
+{
+	while (m_server->hasPendingConnections())
+	{
+		QTcpSocket* socket = m_server->nextPendingConnection();
+		socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		connect(socket, SIGNAL(disconnected()),
+			socket, SLOT(deleteLater()));
+		startSession(socket);
+	}
+}
+
+void EngineRelay::startSession(QTcpSocket* socket)
+{
+	const QString peer(QString("%1:%2")
+			   .arg(socket->peerAddress().toString())
+			   .arg(socket->peerPort()));
+
+	QString error;
+	QIODevice* engine = EngineBuilder(m_config).startDevice(&error);
+	if (engine == nullptr)
+	{
+		qWarning("Relay: %s", qUtf8Printable(error.simplified()));
+		socket->write("error " + error.simplified().toUtf8() + "\n");
+		socket->disconnectFromHost();
+		return;
+	}
+	qInfo("Relay: started %s for %s",
+	      qUtf8Printable(m_config.name()), qUtf8Printable(peer));
+
+	// The engine is stopped with its connection
+	engine->setParent(socket);
+	socket->write(EngineSocket::greeting() + "\n");
+	socket->flush();
+
+	auto session = QSharedPointer<RelaySession>::create();
+	session->lines = 0;
+	session->inputTimer.start();
+
+	connect(socket, &QTcpSocket::readyRead, engine, [=]()
+	{
+		const QByteArray data(socket->readAll());
+		const int lines = data.count('\n');
+		if (lines > 0)
+		{
+			session->lines += lines;
+			session->inputTimer.start();
+		}
+		engine->write(data);
+	});
+
+	auto relayOutput = [=]()
+	{
+		session->output += engine->readAll();
+		const int last = session->output.lastIndexOf('\n');
+		if (last == -1)
+			return;
+
+		const QByteArray prefix(QByteArray::number(session->lines) + ' '
+			+ QByteArray::number(session->inputTimer.nsecsElapsed() / 1000)
+			+ ' ');
+		QByteArray data;
+		int pos = 0;
+		while (pos <= last)
+		{
+			const int end = session->output.indexOf('\n', pos);
+			int size = end - pos;
+			if (size > 0 && session->output.at(end - 1) == '\r')
+				size--;
+			data += prefix;
+			data.append(session->output.constData() + pos, size);
+			data += '\n';
+			pos = end + 1;
+		}
+		session->output.remove(0, pos);
+
+		socket->write(data);
+		socket->flush();
+	};
+	connect(engine, &QIODevice::readyRead, socket, relayOutput);
+	relayOutput();
+
+	connect(engine, &QIODevice::readChannelFinished, socket, [=]()
+	{
+		relayOutput();
+		qInfo("Relay: %s quit", qUtf8Printable(m_config.name()));
+		socket->disconnectFromHost();
+	});
+	connect(socket, &QTcpSocket::disconnected, engine, [=]()
+	{
+		qInfo("Relay: %s disconnected", qUtf8Printable(peer));
+		engine->close();
+	});
+}
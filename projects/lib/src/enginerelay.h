@@ -0,0 +1,96 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINERELAY_H
+#define ENGINERELAY_H
+
+#include <QObject>
+#include <QHostAddress>
+#include "engineconfiguration.h"
+class QTcpServer;
+class QTcpSocket;
+
+/*!
+ * \brief Serves a chess engine to remote EngineSocket connections
+ *
+ * EngineRelay runs on the engine's host. It listens for TCP
+ * connections, and starts a new instance of the engine for each of
+ * them with EngineBuilder::startDevice(), so the engine can be a
+ * process or a library. The engine's input and output are relayed
+ * line by line with Nagle's algorithm disabled, and the engine is
+ * stopped when its connection is closed.
+ *
+ * The protocol is line-based:
+ * - Once the engine is running the relay sends EngineSocket::greeting().
+ *   If the engine can't be started it sends "error <message>" and
+ *   closes the connection.
+ * - The client's lines are passed to the engine as they are.
+ * - Each line of the engine's output is sent as
+ *   "<input lines> <usecs> <line>", where \a input \a lines is the
+ *   number of lines the relay has received and \a usecs is the time in
+ *   microseconds from receiving the last of them to reading the
+ *   engine's line. The client subtracts \a usecs from its own round
+ *   trip time to get the network latency.
+ *
+ * \sa EngineSocket
+ */
+class LIB_EXPORT EngineRelay : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a relay for the engine defined by \a config. */
+		explicit EngineRelay(const EngineConfiguration& config,
+				     QObject* parent = nullptr);
+
+		/*!
+		 * Starts listening on \a address and \a port.
+		 *
+		 * If \a port is 0 a port is chosen automatically; see
+		 * serverPort(). Returns true if successful; otherwise
+		 * returns false and sets errorString().
+		 */
+		bool listen(const QHostAddress& address, quint16 port);
+		/*! Returns the port the relay listens on. */
+		quint16 serverPort() const;
+		/*! Returns the last error. */
+		QString errorString() const;
+
+	public slots:
+		/*!
+		 * Stops listening, closes the connections and stops their
+		 * engines. The finished() signal is emitted afterwards.
+		 */
+		void stop();
+
+	signals:
+		/*! This signal is emitted when the relay is stopped. */
+		void finished();
+
+	private slots:
+		void onNewConnection();
+
+	private:
+		void startSession(QTcpSocket* socket);
+
+		EngineConfiguration m_config;
+		QTcpServer* m_server;
+		QString m_error;
+};
+
+#endif // ENGINERELAY_H
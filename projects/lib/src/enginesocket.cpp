@@ -0,0 +1,237 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "enginesocket.h"
+#include <QTcpSocket>
+#include <algorithm>
+#include <cstring>
+
+
+EngineSocket::EngineSocket(QObject* parent)
+	: QIODevice(parent),
+	  m_socket(new QTcpSocket(this)),
+	  m_finished(false),
+	  m_linesWritten(0),
+	  m_latency(0)
+{
+}
+
+EngineSocket::~EngineSocket()
+{
+	m_socket->abort();
+}
+
+QByteArray EngineSocket::greeting()
+{
+	return "cutechess-relay 1";
+}
+
+bool EngineSocket::connectToRelay(const QString& address, int msecs)
+{
+	const int sep = address.lastIndexOf(':');
+	bool ok = false;
+	const int port = address.mid(sep + 1).toInt(&ok);
+	QString host(address.left(sep));
+	if (host.startsWith('[') && host.endsWith(']'))
+		host = host.mid(1, host.size() - 2);
+	if (sep <= 0 || !ok || port <= 0 || port > 65535)
+	{
+		setErrorString(tr("Invalid relay address: %1").arg(address));
+		return false;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	m_socket->connectToHost(host, quint16(port));
+	if (!m_socket->waitForConnected(msecs))
+	{
+		setErrorString(m_socket->errorString());
+		m_socket->abort();
+		return false;
+	}
+	m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+	// The relay sends its greeting once the engine is running
+	while (!m_socket->canReadLine())
+	{
+		const int left = msecs - int(timer.elapsed());
+		if (left <= 0 || !m_socket->waitForReadyRead(left))
+		{
+			if (m_socket->state() == QAbstractSocket::ConnectedState)
+				setErrorString(tr("The relay didn't start the engine in time"));
+			else
+				setErrorString(m_socket->errorString());
+			m_socket->abort();
+			return false;
+		}
+	}
+
+	const QByteArray line(m_socket->readLine().trimmed());
+	if (line != greeting())
+	{
+		if (line.startsWith("error "))
+			setErrorString(QString::fromUtf8(line.mid(6)));
+		else
+			setErrorString(tr("Unknown relay protocol"));
+		m_socket->abort();
+		return false;
+	}
+
+	connect(m_socket, SIGNAL(readyRead()), this, SLOT(onSocketReadyRead()));
+	connect(m_socket, SIGNAL(disconnected()),
+		this, SLOT(onSocketDisconnected()));
+	QIODevice::open(ReadWrite | Unbuffered);
+
+	// Output that arrived with the greeting is announced once the
+	// caller has connected to readyRead()
+	if (m_socket->bytesAvailable() > 0)
+		QMetaObject::invokeMethod(this, "onSocketReadyRead",
+					  Qt::QueuedConnection);
+	return true;
+}
+
+QElapsedTimer EngineSocket::lineTimer() const
+{
+	return m_lineTimer;
+}
+
+qint64 EngineSocket::latency() const
+{
+	return m_latency;
+}
+
+void EngineSocket::onSocketReadyRead()
+{
+	m_input += m_socket->readAll();
+	if (parseLines())
+	{
+		m_lineTimer.start();
+		emit readyRead();
+	}
+}
+
+void EngineSocket::onSocketDisconnected()
+{
+	if (m_finished)
+		return;
+
+	onSocketReadyRead();
+	m_finished = true;
+	emit readChannelFinished();
+}
+
+bool EngineSocket::parseLines()
+{
+	// Each line is "<input lines> <usecs> <engine's line>"
+	bool found = false;
+	int pos = 0;
+	for (;;)
+	{
+		const int end = m_input.indexOf('\n', pos);
+		if (end == -1)
+			break;
+
+		const int sep1 = m_input.indexOf(' ', pos);
+		const int sep2 = (sep1 == -1) ? -1 : m_input.indexOf(' ', sep1 + 1);
+		if (sep1 != -1 && sep1 < end && sep2 != -1 && sep2 < end)
+		{
+			const qint64 lines = m_input.mid(pos, sep1 - pos).toLongLong();
+			const qint64 usecs = m_input.mid(sep1 + 1, sep2 - sep1 - 1).toLongLong();
+			m_latency = lineLatency(lines, usecs);
+			m_output.append(m_input.constData() + sep2 + 1, end - sep2);
+			found = true;
+		}
+		else
+			qWarning("EngineSocket: Invalid line from relay");
+
+		pos = end + 1;
+	}
+	m_input.remove(0, pos);
+
+	return found;
+}
+
+qint64 EngineSocket::lineLatency(qint64 lines, qint64 usecs)
+{
+	// The writes before the one that had the engine's last input
+	// line won't be needed again
+	while (!m_writes.isEmpty() && m_writes.head().first < lines)
+		m_writes.dequeue();
+	if (lines == 0 || m_writes.isEmpty())
+		return 0;
+
+	const qint64 roundTrip = m_writes.head().second.nsecsElapsed() / 1000;
+	return qMax(roundTrip - usecs, Q_INT64_C(0));
+}
+
+qint64 EngineSocket::bytesAvailable() const
+{
+	return m_output.size() + QIODevice::bytesAvailable();
+}
+
+bool EngineSocket::canReadLine() const
+{
+	return m_output.contains('\n') || QIODevice::canReadLine();
+}
+
+void EngineSocket::close()
+{
+	// Lines that are still buffered, eg. "quit", are sent first
+	m_socket->disconnectFromHost();
+	QIODevice::close();
+}
+
+bool EngineSocket::isSequential() const
+{
+	return true;
+}
+
+qint64 EngineSocket::readData(char* data, qint64 maxSize)
+{
+	int n = int(qMin(maxSize, qint64(m_output.size())));
+	if (n <= 0)
+		return m_finished ? -1 : 0;
+
+	memcpy(data, m_output.constData(), size_t(n));
+	m_output.remove(0, n);
+
+	return n;
+}
+
+qint64 EngineSocket::writeData(const char* data, qint64 maxSize)
+{
+	if (m_finished)
+		return -1;
+
+	const qint64 lines = std::count(data, data + maxSize, '\n');
+	if (lines > 0)
+	{
+		m_linesWritten += lines;
+		QElapsedTimer timer;
+		timer.start();
+		m_writes.enqueue(qMakePair(m_linesWritten, timer));
+
+		// An engine that never answers doesn't grow the queue
+		if (m_writes.size() > 1024)
+			m_writes.dequeue();
+	}
+
+	const qint64 n = m_socket->write(data, maxSize);
+	m_socket->flush();
+	return n;
+}
@@ -0,0 +1,116 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINESOCKET_H
+#define ENGINESOCKET_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QQueue>
+#include <QPair>
+#include <QElapsedTimer>
+class QTcpSocket;
+
+
+/*!
+ * \brief A connection to a chess engine that runs behind an EngineRelay
+ *
+ * EngineSocket is an alternative to EngineProcess for engines on other
+ * hosts. It connects to an EngineRelay over TCP with Nagle's algorithm
+ * disabled, and the relay starts the engine for the duration of the
+ * connection.
+ *
+ * Writing to the device sends lines to the engine as they are, and
+ * reading from it returns the engine's output. The relay prefixes each
+ * output line with the number of input lines it had received and the
+ * engine-side time in microseconds since the last of them, which the
+ * device strips. The difference between that time and the time since
+ * the input line was written here is the network latency of the line,
+ * so a remote engine's clock isn't charged for the round trip.
+ * The readChannelFinished() signal is emitted when the relay closes
+ * the connection, eg. because the engine quit.
+ *
+ * \sa EngineRelay
+ */
+class LIB_EXPORT EngineSocket : public QIODevice
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new EngineSocket. */
+		explicit EngineSocket(QObject* parent = nullptr);
+		/*! Destroys the EngineSocket and closes its connection. */
+		virtual ~EngineSocket();
+
+		// Inherited from QIODevice
+		virtual qint64 bytesAvailable() const;
+		virtual bool canReadLine() const;
+		virtual void close();
+		virtual bool isSequential() const;
+
+		/*!
+		 * Connects to the relay at \a address, given as "host:port",
+		 * and waits up to \a msecs milliseconds for it to start the
+		 * engine.
+		 *
+		 * Returns true if successful; otherwise returns false and
+		 * sets errorString().
+		 */
+		bool connectToRelay(const QString& address, int msecs = 30000);
+
+		/*!
+		 * Returns a timer that was started when the last line of
+		 * the engine's output was received.
+		 *
+		 * The timer is invalid if no line has been received yet.
+		 */
+		QElapsedTimer lineTimer() const;
+		/*!
+		 * Returns the network latency in microseconds of the last
+		 * line of the engine's output.
+		 */
+		qint64 latency() const;
+
+		/*! Returns the line a relay sends after starting its engine. */
+		static QByteArray greeting();
+
+	protected:
+		// Inherited from QIODevice
+		virtual qint64 readData(char* data, qint64 maxSize);
+		virtual qint64 writeData(const char* data, qint64 maxSize);
+
+	private slots:
+		void onSocketReadyRead();
+		void onSocketDisconnected();
+
+	private:
+		bool parseLines();
+		qint64 lineLatency(qint64 lines, qint64 usecs);
+
+		QTcpSocket* m_socket;
+		bool m_finished;
+		QByteArray m_input;
+		QByteArray m_output;
+		qint64 m_linesWritten;
+		// Line count after each write, and when the write was made
+		QQueue<QPair<qint64, QElapsedTimer>> m_writes;
+		QElapsedTimer m_lineTimer;
+		qint64 m_latency;
+};
+
+#endif // ENGINESOCKET_H
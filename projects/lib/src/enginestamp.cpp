@@ -0,0 +1,139 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "enginestamp.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include "engineconfiguration.h"
+
+namespace {
+
+// Returns the program of \a command, which may be quoted
+QString program(const QString& command)
+{
+	const QString cmd(command.trimmed());
+	if (cmd.startsWith('"'))
+	{
+		const int end = cmd.indexOf('"', 1);
+		return end == -1 ? cmd.mid(1) : cmd.mid(1, end - 1);
+	}
+	return cmd.section(' ', 0, 0);
+}
+
+} // anonymous namespace
+
+EngineStamp::EngineStamp()
+	: m_size(0),
+	  m_modified(0)
+{
+}
+
+EngineStamp EngineStamp::fromConfiguration(const EngineConfiguration& config)
+{
+	EngineStamp stamp;
+	// A remote engine's files aren't on this host
+	if (!config.remote().isEmpty())
+		return stamp;
+
+	const QString fileName(config.library().isEmpty() ?
+			       program(config.command()) : config.library());
+	if (fileName.isEmpty())
+		return stamp;
+
+	QFileInfo info(fileName);
+	if (info.isRelative() && !config.workingDirectory().isEmpty())
+		info.setFile(QDir(config.workingDirectory()), fileName);
+	if (!info.isFile())
+	{
+		const QString path(QStandardPaths::findExecutable(fileName));
+		if (path.isEmpty())
+			return stamp;
+		info.setFile(path);
+	}
+
+	QFile file(info.absoluteFilePath());
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file))
+		return stamp;
+
+	// The command is part of the stamp because the executable
+	// may be an interpreter (eg. "wine engine.exe")
+	stamp.m_command = config.library().isEmpty() ? config.command()
+						     : QString();
+	stamp.m_filePath = info.absoluteFilePath();
+	stamp.m_size = info.size();
+	stamp.m_modified = info.lastModified().toMSecsSinceEpoch();
+	stamp.m_hash = hash.result();
+	return stamp;
+}
+
+EngineStamp EngineStamp::fromVariant(const QVariant& variant)
+{
+	const QVariantMap map(variant.toMap());
+
+	EngineStamp stamp;
+	stamp.m_command = map["command"].toString();
+	stamp.m_filePath = map["path"].toString();
+	stamp.m_size = map["size"].toLongLong();
+	stamp.m_modified = map["modified"].toLongLong();
+	stamp.m_hash = QByteArray::fromHex(map["sha1"].toByteArray());
+
+	if (stamp.m_filePath.isEmpty() || stamp.m_hash.isEmpty())
+		return EngineStamp();
+	return stamp;
+}
+
+bool EngineStamp::isNull() const
+{
+	return m_filePath.isEmpty();
+}
+
+QString EngineStamp::filePath() const
+{
+	return m_filePath;
+}
+
+QVariant EngineStamp::toVariant() const
+{
+	QVariantMap map;
+	if (!m_command.isEmpty())
+		map.insert("command", m_command);
+	map.insert("path", m_filePath);
+	map.insert("size", m_size);
+	map.insert("modified", m_modified);
+	map.insert("sha1", QString::fromLatin1(m_hash.toHex()));
+
+	return map;
+}
+
+bool EngineStamp::operator==(const EngineStamp& other) const
+{
+	return m_filePath == other.m_filePath
+	    && m_size == other.m_size
+	    && m_modified == other.m_modified
+	    && m_hash == other.m_hash
+	    && m_command == other.m_command;
+}
+
+bool EngineStamp::operator!=(const EngineStamp& other) const
+{
+	return !(*this == other);
+}
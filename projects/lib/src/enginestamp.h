@@ -0,0 +1,72 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINESTAMP_H
+#define ENGINESTAMP_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVariant>
+class EngineConfiguration;
+
+/*!
+ * \brief Identifies the engine binary that options were detected from
+ *
+ * Detecting an engine's options and variants means starting the
+ * engine. An EngineStamp records the command and the executable
+ * (path, size, modification time and SHA-1 hash) of the engine when
+ * the options were detected. The options can be reused for as long
+ * as a new stamp of the same engine compares equal.
+ *
+ * \sa EngineConfiguration::detectionStamp()
+ */
+class LIB_EXPORT EngineStamp
+{
+	public:
+		/*! Creates a null stamp. */
+		EngineStamp();
+		/*!
+		 * Creates a stamp of the executable or library of the
+		 * engine in \a config.
+		 *
+		 * Returns a null stamp if the file can't be found.
+		 */
+		static EngineStamp fromConfiguration(const EngineConfiguration& config);
+		/*! Creates a stamp from \a variant, written by toVariant(). */
+		static EngineStamp fromVariant(const QVariant& variant);
+
+		/*! Returns true if the stamp doesn't identify a file. */
+		bool isNull() const;
+		/*! Returns the path of the executable or library. */
+		QString filePath() const;
+		/*! Converts the stamp into a QVariant map. */
+		QVariant toVariant() const;
+
+		/*! Returns true if \a other identifies the same binary. */
+		bool operator==(const EngineStamp& other) const;
+		/*! Returns true if \a other identifies a different binary. */
+		bool operator!=(const EngineStamp& other) const;
+
+	private:
+		QString m_command;
+		QString m_filePath;
+		qint64 m_size;
+		qint64 m_modified;
+		QByteArray m_hash;
+};
+
+#endif // ENGINESTAMP_H
@@ -0,0 +1,255 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "epdextractor.h"
+#include <QThread>
+#include <QVector>
+#include <QScopedPointer>
+#include "pgngame.h"
+#include "pgnstream.h"
+#include "pgnchunkreader.h"
+#include "moveevaluation.h"
+#include "board/board.h"
+
+namespace {
+
+struct Position
+{
+	quint64 key;
+	QByteArray fen;
+};
+
+/*! The positions of one chunk of PGN games. */
+struct Chunk
+{
+	QVector<Position> positions;
+	int games;
+};
+
+/*! Parses chunks of PGN games and picks their positions. */
+class PositionPicker
+{
+	public:
+		PositionPicker(int minPly,
+			       int maxPly,
+			       const QStringList& results,
+			       int maxScore)
+			: m_minPly(minPly),
+			  m_maxPly(maxPly),
+			  m_results(results),
+			  m_maxScore(maxScore)
+		{
+		}
+
+		Chunk pick(const QByteArray& data) const
+		{
+			Chunk chunk;
+			chunk.games = 0;
+
+			// The comment of the move played from the last
+			// position is needed for its score
+			PgnStream in(&data);
+			PgnGame game;
+			while (game.read(in, m_maxPly + 2, false))
+			{
+				chunk.games++;
+				addGame(game, &chunk.positions);
+			}
+
+			return chunk;
+		}
+
+	private:
+		void addGame(const PgnGame& game, QVector<Position>* positions) const
+		{
+			if (!m_results.isEmpty()
+			&&  !m_results.contains(game.tagValue(PgnGame::ResultTag)))
+				return;
+
+			QScopedPointer<Chess::Board> board(game.createBoard());
+			if (board.isNull())
+				return;
+
+			const QVector<PgnGame::MoveData>& moves = game.moves();
+			for (int ply = 0; ply <= m_maxPly; ply++)
+			{
+				if (!board->result().isNone())
+					break;
+				if (ply >= m_minPly && acceptScore(moves, ply))
+				{
+					Position pos = {
+						board->key(),
+						board->fenString().toUtf8()
+					};
+					positions->append(pos);
+				}
+
+				if (ply >= moves.size())
+					break;
+				const Chess::Move move(board->moveFromGenericMove(moves.at(ply).move));
+				if (move.isNull())
+					break;
+				board->makeMove(move);
+			}
+		}
+
+		bool acceptScore(const QVector<PgnGame::MoveData>& moves, int ply) const
+		{
+			if (m_maxScore < 0 || ply >= moves.size())
+				return true;
+
+			const MoveEvaluation eval(
+				MoveEvaluation::fromPgnComment(moves.at(ply).commentText()));
+			if (eval.isEmpty() || eval.isBookEval()
+			||  eval.score() == MoveEvaluation::NULL_SCORE)
+				return true;
+			return qAbs(eval.score()) <= m_maxScore;
+		}
+
+		int m_minPly;
+		int m_maxPly;
+		QStringList m_results;
+		int m_maxScore;
+};
+
+} // anonymous namespace
+
+EpdExtractor::EpdExtractor()
+	: m_minPly(8),
+	  m_maxPly(8),
+	  m_maxScore(-1),
+	  m_unique(false),
+	  m_threadCount(QThread::idealThreadCount()),
+	  m_gameCount(0),
+	  m_positionCount(0),
+	  m_duplicateCount(0),
+	  m_failed(false)
+{
+}
+
+void EpdExtractor::setPlies(int minPly, int maxPly)
+{
+	Q_ASSERT(minPly >= 0 && minPly <= maxPly);
+	m_minPly = minPly;
+	m_maxPly = maxPly;
+}
+
+void EpdExtractor::setResults(const QStringList& results)
+{
+	m_results = results;
+}
+
+void EpdExtractor::setMaxScore(int centipawns)
+{
+	m_maxScore = centipawns;
+}
+
+void EpdExtractor::setUnique(bool unique)
+{
+	m_unique = unique;
+}
+
+void EpdExtractor::setThreadCount(int count)
+{
+	m_threadCount = qMax(1, count);
+}
+
+qint64 EpdExtractor::gameCount() const
+{
+	return m_gameCount;
+}
+
+qint64 EpdExtractor::positionCount() const
+{
+	return m_positionCount;
+}
+
+qint64 EpdExtractor::duplicateCount() const
+{
+	return m_duplicateCount;
+}
+
+bool EpdExtractor::open(const QString& fileName)
+{
+	m_out.setFileName(fileName);
+	if (!m_out.open(QIODevice::WriteOnly))
+	{
+		qWarning("Can't open EPD file %s", qUtf8Printable(fileName));
+		return false;
+	}
+	return true;
+}
+
+bool EpdExtractor::addPgnFile(const QString& fileName)
+{
+	Q_ASSERT(m_out.isOpen());
+
+	PgnChunkReader reader;
+	if (!reader.open(fileName, QIODevice::ReadOnly | QIODevice::Text))
+		return false;
+
+	QByteArray buffer;
+	auto collect = [this, &buffer](const Chunk& result)
+	{
+		m_gameCount += result.games;
+		for (const Position& pos : qAsConst(result.positions))
+		{
+			if (m_unique && m_keys.contains(pos.key))
+			{
+				m_duplicateCount++;
+				continue;
+			}
+			if (m_unique)
+				m_keys.insert(pos.key);
+
+			buffer += pos.fen;
+			buffer += '\n';
+			m_positionCount++;
+		}
+		if (!m_failed && m_out.write(buffer) != buffer.size())
+		{
+			qWarning("Can't write to EPD file %s",
+				 qUtf8Printable(m_out.fileName()));
+			m_failed = true;
+		}
+		buffer.resize(0);
+	};
+
+	const PositionPicker picker(m_minPly, m_maxPly, m_results, m_maxScore);
+	reader.process([&picker, &collect](const PgnChunkReader::Chunk& chunk)
+	{
+		const Chunk result(picker.pick(chunk.data));
+		return PgnChunkReader::Collector([&collect, result]()
+		{
+			collect(result);
+		});
+	}, m_threadCount);
+
+	return !m_failed;
+}
+
+bool EpdExtractor::close()
+{
+	if (m_failed || !m_out.commit())
+	{
+		qWarning("Can't write EPD file %s",
+			 qUtf8Printable(m_out.fileName()));
+		return false;
+	}
+	return true;
+}
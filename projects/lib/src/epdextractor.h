@@ -0,0 +1,123 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EPDEXTRACTOR_H
+#define EPDEXTRACTOR_H
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QSaveFile>
+
+/*!
+ * \brief Extracts opening positions from large PGN collections
+ *
+ * The games are parsed and replayed by a pool of worker threads, which
+ * pick the positions between the minimum and maximum ply of each game.
+ * The positions are written to an EPD file as FEN strings, one per
+ * line, in the order of the games in the input, regardless of the
+ * number of threads.
+ *
+ * Games can be filtered by their result, and positions by the score of
+ * the move played from them. The score is read from the move comment,
+ * eg. "+0.31/13 4.5s", from the point of view of the side to move.
+ * Positions whose move has no score are kept. Duplicate positions can
+ * be dropped, in which case the first occurrence is kept.
+ *
+ * \note The PGN input is split between threads at lines that start
+ * with an Event tag, so a file without Event tags is parsed by a
+ * single thread.
+ *
+ * \sa PolyglotBookBuilder
+ */
+class LIB_EXPORT EpdExtractor
+{
+	public:
+		/*! Creates a new extractor. */
+		EpdExtractor();
+
+		/*!
+		 * Sets the range of plies whose positions are extracted to
+		 * \a minPly - \a maxPly. The default is 8 - 8.
+		 */
+		void setPlies(int minPly, int maxPly);
+		/*!
+		 * Only extracts positions from games whose result is in
+		 * \a results, eg. "1-0" or "1/2-1/2". By default all games
+		 * are used.
+		 */
+		void setResults(const QStringList& results);
+		/*!
+		 * Skips positions whose absolute score is greater than
+		 * \a centipawns. A negative value, the default, disables
+		 * the filter.
+		 */
+		void setMaxScore(int centipawns);
+		/*! Drops duplicate positions if \a unique is true. */
+		void setUnique(bool unique);
+		/*!
+		 * Sets the number of worker threads to \a count.
+		 * The default is the number of CPU cores.
+		 */
+		void setThreadCount(int count);
+
+		/*!
+		 * Opens the EPD file \a fileName for writing. The file is
+		 * replaced when close() is called.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool open(const QString& fileName);
+		/*!
+		 * Extracts the positions of PGN file \a fileName.
+		 * The file may be compressed with gzip or Zstandard.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool addPgnFile(const QString& fileName);
+		/*!
+		 * Finishes writing the EPD file.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool close();
+
+		/*! Returns the number of games read so far. */
+		qint64 gameCount() const;
+		/*! Returns the number of positions written so far. */
+		qint64 positionCount() const;
+		/*! Returns the number of duplicate positions dropped. */
+		qint64 duplicateCount() const;
+
+	private:
+		Q_DISABLE_COPY(EpdExtractor)
+
+		int m_minPly;
+		int m_maxPly;
+		QStringList m_results;
+		int m_maxScore;
+		bool m_unique;
+		int m_threadCount;
+		qint64 m_gameCount;
+		qint64 m_positionCount;
+		qint64 m_duplicateCount;
+		QSet<quint64> m_keys;
+		QSaveFile m_out;
+		bool m_failed;
+};
+
+#endif // EPDEXTRACTOR_H
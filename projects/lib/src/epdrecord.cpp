@@ -19,11 +19,20 @@
 #include "epdrecord.h"
 #include <QTextStream>
 
-EpdRecord::EpdRecord()
+namespace {
+
+bool isSpace(char c)
 {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
 }
 
-bool EpdRecord::parse(QTextStream& stream)
+/*!
+ * Parses the operations in \a text, up to the end of the line, into
+ * \a operations.
+ * Returns true if successful; otherwise returns false.
+ */
+bool parseOperationText(const QString& text,
+			QMap<QString, QStringList>* operations)
 {
 	enum TokenType
 	{
@@ -32,33 +41,13 @@ bool EpdRecord::parse(QTextStream& stream)
 		OperandToken
 	};
 
-	m_fen.clear();
-	m_operations.clear();
-
-	// Parse FEN
-	for (int i = 0; i < 4; i++)
-	{
-		QString tmp;
-		stream >> tmp;
-		if (stream.status() != QTextStream::Ok)
-			return false;
-
-		m_fen.append(tmp);
-		if (i < 3)
-			m_fen.append(" ");
-	}
-
-	// Parse the operations
 	QString opcode;
 	QString operand;
 	TokenType type = SeparatorToken;
 	bool inQuotes = false;
-	bool ok = true;
-	while (stream.status() == QTextStream::Ok)
-	{
-		QChar c;
-		stream >> c;
 
+	for (const QChar& c : text)
+	{
 		switch (c.toLatin1())
 		{
 		case '\n':
@@ -73,44 +62,32 @@ bool EpdRecord::parse(QTextStream& stream)
 					type = OperandToken;
 				else
 				{
-					m_operations[opcode].append(operand);
+					(*operations)[opcode].append(operand);
 					operand.clear();
 				}
 			}
 			break;
 		case '\"':
 			if (type == OpcodeToken)
-			{
-				ok = false;
-				break;
-			}
+				return false;
 			else if (type == SeparatorToken)
 			{
 				if (opcode.isEmpty())
-				{
-					ok = false;
-					break;
-				}
+					return false;
 				type = OperandToken;
 			}
 			else if (type == OperandToken
 			     &&  !inQuotes
 			     &&  !operand.isEmpty())
-			{
-				ok = false;
-				break;
-			}
+				return false;
 			inQuotes = !inQuotes;
 			break;
 		case ';':
 			if (!inQuotes)
 			{
 				if (opcode.isEmpty())
-				{
-					ok = false;
-					break;
-				}
-				m_operations[opcode].append(operand);
+					return false;
+				(*operations)[opcode].append(operand);
 				opcode.clear();
 				operand.clear();
 				type = SeparatorToken;
@@ -125,20 +102,92 @@ bool EpdRecord::parse(QTextStream& stream)
 				operand.append(c);
 			break;
 		}
+	}
 
-		if (!ok)
+	return true;
+}
+
+} // anonymous namespace
+
+EpdRecord::EpdRecord()
+	: m_operationOffset(0)
+{
+}
+
+bool EpdRecord::parse(QTextStream& stream)
+{
+	m_fen.clear();
+	m_operations.clear();
+	m_operationData.clear();
+
+	// Parse FEN
+	for (int i = 0; i < 4; i++)
+	{
+		QString tmp;
+		stream >> tmp;
+		if (stream.status() != QTextStream::Ok)
+			return false;
+
+		m_fen.append(tmp);
+		if (i < 3)
+			m_fen.append(" ");
+	}
+
+	// Parse the operations
+	return parseOperationText(stream.readLine(), &m_operations);
+}
+
+bool EpdRecord::parse(const QByteArray& line)
+{
+	m_fen.clear();
+	m_operations.clear();
+	m_operationData.clear();
+
+	const char* data = line.constData();
+	const int size = line.size();
+	int pos = 0;
+
+	// Split off the four FEN fields
+	for (int i = 0; i < 4; i++)
+	{
+		while (pos < size && isSpace(data[pos]))
+			pos++;
+		const int start = pos;
+		while (pos < size && !isSpace(data[pos]))
+			pos++;
+		if (pos == start)
 		{
-			while (!stream.atEnd() && c != '\n')
-				stream >> c;
+			m_fen.clear();
 			return false;
 		}
+
+		if (i > 0)
+			m_fen.append(QLatin1Char(' '));
+		m_fen.append(QLatin1String(data + start, pos - start));
 	}
 
+	// The operations are parsed when they are needed
+	m_operationData = line;
+	m_operationOffset = pos;
 	return true;
 }
 
+void EpdRecord::parseOperations() const
+{
+	if (m_operationData.isEmpty())
+		return;
+
+	const QString text(QString::fromUtf8(
+		m_operationData.constData() + m_operationOffset,
+		m_operationData.size() - m_operationOffset));
+	m_operationData.clear();
+
+	parseOperationText(text, &m_operations);
+}
+
 bool EpdRecord::hasOpcode(const QString& opcode) const
 {
+	parseOperations();
 	return m_operations.contains(opcode);
 }
 
@@ -149,5 +198,6 @@ QString EpdRecord::fen() const
 
 QStringList EpdRecord::operands(const QString& opcode) const
 {
+	parseOperations();
 	return m_operations.value(opcode);
 }
@@ -21,6 +21,7 @@
 
 #include <QStringList>
 #include <QMap>
+#include <QByteArray>
 class QTextStream;
 
 /*!
@@ -39,6 +40,9 @@ class QTextStream;
  * records from EPD files, but in the future it may also be used to
  * build new EPD test suites etc.
  *
+ * A record parsed from bytes only splits off the FEN string. The
+ * operations are parsed the first time they are asked for.
+ *
  * \sa OpeningSuite
  */
 class LIB_EXPORT EpdRecord
@@ -52,6 +56,18 @@ class LIB_EXPORT EpdRecord
 		 * Returns true if successful; otherwise returns false.
 		 */
 		bool parse(QTextStream& stream);
+		/*!
+		 * Parses the record in \a line, which holds one line of
+		 * an EPD file in Latin-1 or UTF-8.
+		 *
+		 * The bytes of \a line are not copied, so if \a line
+		 * was created with QByteArray::fromRawData() the data
+		 * must stay valid until the operations have been read.
+		 *
+		 * Returns true if the line has a FEN string; otherwise
+		 * returns false.
+		 */
+		bool parse(const QByteArray& line);
 		/*!
 		 * Returns true if the record contains an opcode that
 		 * matches \a opcode; otherwise returns false.
@@ -67,8 +83,13 @@ class LIB_EXPORT EpdRecord
 		QStringList operands(const QString& opcode) const;
 
 	private:
+		void parseOperations() const;
+
 		QString m_fen;
-		QMap<QString, QStringList> m_operations;
+		// The record's line, and the start of its operations
+		mutable QByteArray m_operationData;
+		int m_operationOffset;
+		mutable QMap<QString, QStringList> m_operations;
 };
 
 #endif // EPDRECORD_H
@@ -0,0 +1,186 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "epdtest.h"
+#include <QFile>
+#include "board/board.h"
+#include "epdrecord.h"
+
+EpdTest::EpdTest(GameManager* manager, QObject* parent)
+	: PositionSearcher(manager, parent),
+	  m_nextSearch(0)
+{
+}
+
+bool EpdTest::addPositions(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		setError(tr("Can't open EPD file %1").arg(fileName));
+		return false;
+	}
+
+	Chess::Board* board = this->board();
+	int lineNumber = 0;
+	while (!file.atEnd())
+	{
+		const QByteArray line(file.readLine());
+		lineNumber++;
+
+		EpdRecord record;
+		if (!record.parse(line))
+			continue;
+
+		Position position;
+		QStringList* lists[2] = { &position.bestMoves,
+					  &position.avoidMoves };
+		const QStringList operands[2] = { record.operands("bm"),
+						  record.operands("am") };
+		if (operands[0].isEmpty() && operands[1].isEmpty())
+			continue;
+
+		position.fen = record.fen();
+		if (!board->setFenString(position.fen))
+		{
+			qWarning("%s:%d: invalid position",
+				 qUtf8Printable(fileName), lineNumber);
+			continue;
+		}
+
+		// The moves are stored in the notation that ChessGame uses,
+		// so that they can be compared as strings
+		bool ok = true;
+		for (int i = 0; i < 2 && ok; i++)
+		{
+			for (const QString& str : operands[i])
+			{
+				const Chess::Move move(board->moveFromString(str));
+				if (move.isNull())
+				{
+					qWarning("%s:%d: illegal move: %s",
+						 qUtf8Printable(fileName),
+						 lineNumber,
+						 qUtf8Printable(str));
+					ok = false;
+					break;
+				}
+				lists[i]->append(board->moveString(
+					move, Chess::Board::StandardAlgebraic));
+			}
+		}
+		if (!ok)
+			continue;
+
+		position.id = record.operands("id").join(' ');
+		m_positions.append(position);
+	}
+
+	return true;
+}
+
+int EpdTest::positionCount() const
+{
+	return m_positions.size();
+}
+
+QString EpdTest::positionId(int position) const
+{
+	const QString& id = m_positions.at(position).id;
+	return id.isEmpty() ? QString::number(position + 1) : id;
+}
+
+int EpdTest::searchedCount(int engine) const
+{
+	return engine < m_scores.size() ? m_scores.at(engine).searched : 0;
+}
+
+int EpdTest::solvedCount(int engine) const
+{
+	return engine < m_scores.size() ? m_scores.at(engine).solved : 0;
+}
+
+qint64 EpdTest::totalSolveTime(int engine) const
+{
+	return engine < m_scores.size() ? m_scores.at(engine).solveTime : 0;
+}
+
+EpdTest::Score& EpdTest::score(int engine)
+{
+	while (m_scores.size() <= engine)
+		m_scores.append(Score{ 0, 0, 0 });
+	return m_scores[engine];
+}
+
+bool EpdTest::nextSearch(Search* search)
+{
+	if (m_nextSearch >= m_positions.size() * engineCount())
+		return false;
+
+	// The engines take turns so that they progress at the same pace
+	search->index = m_nextSearch++;
+	search->engine = search->index % engineCount();
+	search->fen = m_positions.at(search->index / engineCount()).fen;
+	m_solveTimes.insert(search->index, -1);
+
+	return true;
+}
+
+bool EpdTest::isCorrect(const Position& position, const QString& move) const
+{
+	if (move.isEmpty() || position.avoidMoves.contains(move))
+		return false;
+	return position.bestMoves.isEmpty() || position.bestMoves.contains(move);
+}
+
+void EpdTest::searchUpdated(const Search& search, const MoveEvaluation& eval)
+{
+	const Position& position = m_positions.at(search.index / engineCount());
+	int& solveTime = m_solveTimes[search.index];
+
+	if (!isCorrect(position, eval.pv().section(' ', 0, 0)))
+		solveTime = -1;
+	else if (solveTime == -1)
+		solveTime = eval.time();
+}
+
+void EpdTest::searchFinished(const Search& search,
+			     const QString& move,
+			     const MoveEvaluation& eval)
+{
+	PositionResult result;
+	result.engine = search.engine;
+	result.position = search.index / engineCount();
+	result.move = move;
+	result.solved = isCorrect(m_positions.at(result.position), move);
+	result.solveTime = -1;
+
+	const int solveTime = m_solveTimes.take(search.index);
+	if (result.solved)
+		result.solveTime = solveTime != -1 ? solveTime
+						   : qMax(0, eval.time());
+
+	Score& engineScore = score(search.engine);
+	engineScore.searched++;
+	if (result.solved)
+	{
+		engineScore.solved++;
+		engineScore.solveTime += result.solveTime;
+	}
+	emit positionFinished(result);
+}
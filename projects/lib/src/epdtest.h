@@ -0,0 +1,124 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EPDTEST_H
+#define EPDTEST_H
+
+#include <QStringList>
+#include "positionsearcher.h"
+
+/*!
+ * \brief Runs an EPD test suite against chess engines
+ *
+ * EpdTest reads positions with best move ("bm") or avoid move ("am")
+ * operations from EPD files and lets each engine search every
+ * position once. A position is solved if the engine plays one of the
+ * best moves and none of the avoid moves.
+ *
+ * The solve time of a position is the search time at which the
+ * engine's principal variation started with a correct move for the
+ * last time. If the engine doesn't report its principal variations,
+ * it's the time of the whole search.
+ */
+class LIB_EXPORT EpdTest : public PositionSearcher
+{
+	Q_OBJECT
+
+	public:
+		/*! The result of one engine in one position. */
+		struct PositionResult
+		{
+			/*! The index of the engine. */
+			int engine;
+			/*! The index of the position. */
+			int position;
+			/*! The move played by the engine in SAN, or empty. */
+			QString move;
+			/*! Was the position solved? */
+			bool solved;
+			/*! The solve time in milliseconds, or -1 if unsolved. */
+			int solveTime;
+		};
+
+		/*! Creates a new EpdTest that plays through \a manager. */
+		explicit EpdTest(GameManager* manager, QObject* parent = nullptr);
+
+		/*!
+		 * Reads the test positions from EPD file \a fileName.
+		 * Records without "bm" or "am" operations are skipped, as
+		 * are records with invalid positions or moves.
+		 *
+		 * The variant must be set before adding positions.
+		 * Returns false if the file can't be read.
+		 */
+		bool addPositions(const QString& fileName);
+		/*! Returns the number of test positions. */
+		int positionCount() const;
+		/*!
+		 * Returns the ID of \a position: the operand of its "id"
+		 * operation, or its number if there's no ID.
+		 */
+		QString positionId(int position) const;
+
+		/*! Returns the number of positions searched by \a engine. */
+		int searchedCount(int engine) const;
+		/*! Returns the number of positions solved by \a engine. */
+		int solvedCount(int engine) const;
+		/*! Returns the sum of \a engine's solve times in milliseconds. */
+		qint64 totalSolveTime(int engine) const;
+
+	signals:
+		/*! Emitted when an engine has searched a position. */
+		void positionFinished(const EpdTest::PositionResult& result);
+
+	protected:
+		// Inherited from PositionSearcher
+		virtual bool nextSearch(Search* search);
+		virtual void searchUpdated(const Search& search,
+					   const MoveEvaluation& eval);
+		virtual void searchFinished(const Search& search,
+					    const QString& move,
+					    const MoveEvaluation& eval);
+
+	private:
+		struct Position
+		{
+			QString fen;
+			QString id;
+			QStringList bestMoves;
+			QStringList avoidMoves;
+		};
+		struct Score
+		{
+			int searched;
+			int solved;
+			qint64 solveTime;
+		};
+
+		bool isCorrect(const Position& position,
+			       const QString& move) const;
+		Score& score(int engine);
+
+		QVector<Position> m_positions;
+		QVector<Score> m_scores;
+		// Solve times of the ongoing searches
+		QHash<int, int> m_solveTimes;
+		int m_nextSearch;
+};
+
+#endif // EPDTEST_H
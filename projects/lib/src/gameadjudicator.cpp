@@ -29,12 +29,21 @@ GameAdjudicator::GameAdjudicator()
 	  m_resignScore(0),
 	  m_twoSided(false),
 	  m_maxGameLength(0),
-	  m_tbEnabled(false)
+	  m_tbEnabled(false),
+	  m_tbDtz(false),
+	  m_agreementMoveCount(0),
+	  m_agreementScore(0),
+	  m_agreementMargin(0),
+	  m_agreementCount(0),
+	  m_mateConfirmation(false),
+	  m_pliesSaved(0)
 {
 	m_resignScoreCount[0] = 0;
 	m_resignScoreCount[1] = 0;
 	m_winScoreCount[0] = 0;
 	m_winScoreCount[1] = 0;
+	m_whiteScore[0] = m_whiteScore[1] = 0;
+	m_hasScore[0] = m_hasScore[1] = false;
 }
 
 void GameAdjudicator::setDrawThreshold(int moveNumber, int moveCount, int score)
@@ -67,11 +76,32 @@ void GameAdjudicator::setMaximumGameLength(int moveCount)
 	m_maxGameLength = moveCount;
 }
 
+void GameAdjudicator::setAgreementThreshold(int moveCount, int score, int margin)
+{
+	Q_ASSERT(moveCount >= 0);
+	Q_ASSERT(margin >= 0);
+
+	m_agreementMoveCount = moveCount;
+	m_agreementScore = score;
+	m_agreementMargin = margin;
+	m_agreementCount = 0;
+}
+
+void GameAdjudicator::setMateConfirmation(bool enable)
+{
+	m_mateConfirmation = enable;
+}
+
 void GameAdjudicator::setTablebaseAdjudication(bool enable)
 {
 	m_tbEnabled = enable;
 }
 
+void GameAdjudicator::setTablebaseDtz(bool enable)
+{
+	m_tbDtz = enable;
+}
+
 void GameAdjudicator::addEval(const Chess::Board* board, const MoveEvaluation& eval)
 {
 	Chess::Side side = board->sideToMove().opposite();
@@ -79,7 +109,12 @@ void GameAdjudicator::addEval(const Chess::Board* board, const MoveEvaluation& e
 	// Tablebase adjudication
 	if (m_tbEnabled)
 	{
-		m_result = board->tablebaseResult();
+		unsigned int dtz = 0;
+		m_result = board->tablebaseResult(m_tbDtz ? &dtz : nullptr);
+		if (m_tbDtz && !m_result.winner().isNull())
+			m_result = Chess::Result(m_result.type(),
+						 m_result.winner(),
+						 QString("SyzygyTB, DTZ %1").arg(dtz));
 		if (!m_result.isNone())
 			return;
 	}
@@ -90,10 +125,60 @@ void GameAdjudicator::addEval(const Chess::Board* board, const MoveEvaluation& e
 		m_drawScoreCount = 0;
 		m_resignScoreCount[side] = 0;
 		m_winScoreCount[side] = 0;
+		m_agreementCount = 0;
+		m_hasScore[side] = false;
+		m_mateClaimer = Chess::Side::NoSide;
 
 		return;
 	}
 
+	const int mateScore = MoveEvaluation::MATE_SCORE - 200;
+
+	// Mate score confirmed by the opponent
+	if (m_mateConfirmation)
+	{
+		if (m_mateClaimer == side.opposite() && eval.score() <= -mateScore)
+		{
+			// Plies to mate, as in MoveEvaluation::scoreText()
+			m_pliesSaved = 2 * (1000 - (-eval.score() % 1000));
+			m_result = Chess::Result(Chess::Result::Adjudication,
+						 side.opposite(),
+						 "confirmed mate score");
+			return;
+		}
+		m_mateClaimer = (eval.score() >= mateScore) ? side
+							     : Chess::Side::NoSide;
+	}
+
+	// Both players agree on the winner
+	if (m_agreementMoveCount > 0)
+	{
+		const int whiteScore = (side == Chess::Side::White) ? eval.score()
+								   : -eval.score();
+		m_whiteScore[side] = whiteScore;
+		m_hasScore[side] = true;
+
+		const int otherScore = m_whiteScore[side.opposite()];
+		if (m_hasScore[side.opposite()]
+		&&  qAbs(whiteScore) >= m_agreementScore
+		&&  (whiteScore > 0) == (otherScore > 0)
+		&&  qAbs(otherScore) >= m_agreementScore
+		&&  qAbs(whiteScore - otherScore) <= m_agreementMargin)
+			m_agreementCount++;
+		else
+			m_agreementCount = 0;
+
+		if (m_agreementCount >= m_agreementMoveCount * 2)
+		{
+			Chess::Side winner = (whiteScore > 0) ? Chess::Side::White
+							      : Chess::Side::Black;
+			m_result = Chess::Result(Chess::Result::Adjudication,
+						 winner,
+						 "score agreement");
+			return;
+		}
+	}
+
 	// Draw adjudication
 	if (m_drawMoveNum > 0)
 	{
@@ -160,3 +245,8 @@ Chess::Result GameAdjudicator::result() const
 {
 	return m_result;
 }
+
+int GameAdjudicator::pliesSaved() const
+{
+	return m_pliesSaved;
+}
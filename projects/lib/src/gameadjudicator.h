@@ -69,6 +69,26 @@ class LIB_EXPORT GameAdjudicator
 		 * The limit is not in action if set to zero.
 		 */
 		void setMaximumGameLength(int moveCount);
+		/*!
+		 * Sets the score agreement adjudication threshold.
+		 *
+		 * A game will be adjudicated as a win if both players
+		 * report a score of at least \a score centipawns in favor
+		 * of the same side for at least \a moveCount consecutive
+		 * moves, and their scores differ by at most \a margin
+		 * centipawns. The threshold is not in action if
+		 * \a moveCount is zero.
+		 */
+		void setAgreementThreshold(int moveCount, int score, int margin);
+		/*!
+		 * Sets mate confirmation adjudication to \a enable.
+		 *
+		 * If \a enable is true a game will be adjudicated as a
+		 * win when a player reports a mate score and the opponent
+		 * confirms it on the next move by reporting that it's
+		 * getting mated.
+		 */
+		void setMateConfirmation(bool enable);
 		/*!
 		 * Sets tablebase adjudication to \a enable.
 		 *
@@ -76,6 +96,16 @@ class LIB_EXPORT GameAdjudicator
 		 * latest position is found in the tablebases.
 		 */
 		void setTablebaseAdjudication(bool enable);
+		/*!
+		 * Sets recording the distance to zero of tablebase
+		 * adjudications to \a enable.
+		 *
+		 * If \a enable is true the DTZ of the position is added to
+		 * the description of decisive tablebase results, eg.
+		 * "SyzygyTB, DTZ 23". Finding the DTZ costs a DTZ table
+		 * probe, so the DTZ tablebase files are needed.
+		 */
+		void setTablebaseDtz(bool enable);
 
 		/*!
 		 * Adds a new move evaluation to the adjudicator.
@@ -96,6 +126,13 @@ class LIB_EXPORT GameAdjudicator
 		 * game can't be adjudicated yet, a null result is returned.
 		 */
 		Chess::Result result() const;
+		/*!
+		 * Returns an estimate of the number of plies that the
+		 * adjudication saved, or 0 if it's not known.
+		 *
+		 * The estimate is known only for confirmed mates.
+		 */
+		int pliesSaved() const;
 
 	private:
 		int m_drawMoveNum;
@@ -109,6 +146,18 @@ class LIB_EXPORT GameAdjudicator
 		bool m_twoSided;
 		int m_maxGameLength;
 		bool m_tbEnabled;
+		bool m_tbDtz;
+		int m_agreementMoveCount;
+		int m_agreementScore;
+		int m_agreementMargin;
+		int m_agreementCount;
+		// Latest scores of both sides from White's point of view
+		int m_whiteScore[2];
+		bool m_hasScore[2];
+		bool m_mateConfirmation;
+		// The side that reported a mate score on the previous move
+		Chess::Side m_mateClaimer;
+		int m_pliesSaved;
 		Chess::Result m_result;
 };
 
@@ -18,10 +18,18 @@
 
 #include "gamemanager.h"
 #include <QThread>
+#include <QMetaMethod>
 #include <algorithm>
 #include "playerbuilder.h"
 #include "chessgame.h"
 #include "chessplayer.h"
+#include "chessengine.h"
+#include "engineprocess.h"
+#include "cpuallocator.h"
+#include "loadmonitor.h"
+#include "livegamefeed.h"
+
+Q_DECLARE_METATYPE(const PlayerBuilder*)
 
 class GameInitializer : public QObject
 {
@@ -29,12 +37,20 @@ class GameInitializer : public QObject
 
 	public:
 		GameInitializer(const PlayerBuilder* white,
-				const PlayerBuilder* black);
+				const PlayerBuilder* black,
+				GameManager* manager);
 		virtual ~GameInitializer();
 
 		const PlayerBuilder* whiteBuilder() const;
 		const PlayerBuilder* blackBuilder() const;
+		const PlayerBuilder* builder(int index) const;
+		bool hasPlayer(int index) const;
 		void swapPlayers();
+		void setPlayer(int index,
+			       const PlayerBuilder* builder,
+			       ChessPlayer* player,
+			       int generation);
+		void setCpus(int index, const QList<int>& cpus);
 		void setGame(ChessGame* game);
 
 	public slots:
@@ -47,21 +63,39 @@ class GameInitializer : public QObject
 
 	private slots:
 		void onPlayerQuit();
+		void onPlayerRestarting();
 
 	private:
+		struct ReleasedPlayer
+		{
+			const PlayerBuilder* builder;
+			ChessPlayer* player;
+			int generation;
+		};
+
+		ChessPlayer* createPlayer(int index, QString* error);
 		void deletePlayer(int index);
+		void releasePlayers();
+		void pinPlayer(int index);
 
 		int m_playerCount;
 		bool m_finishing;
+		GameManager* m_manager;
 		const PlayerBuilder* m_builder[2];
 		ChessPlayer* m_player[2];
+		// Replacements started for engines that restart between games
+		ChessPlayer* m_spare[2];
+		QList<int> m_cpus[2];
 		ChessGame* m_game;
+		QList<ReleasedPlayer> m_released;
 };
 
 GameInitializer::GameInitializer(const PlayerBuilder* white,
-				 const PlayerBuilder* black)
+				 const PlayerBuilder* black,
+				 GameManager* manager)
 	: m_playerCount(0),
 	  m_finishing(false),
+	  m_manager(manager),
 	  m_game(nullptr)
 {
 	Q_ASSERT(white != nullptr);
@@ -71,6 +105,8 @@ GameInitializer::GameInitializer(const PlayerBuilder* white,
 	m_builder[Chess::Side::Black] = black;
 	m_player[0] = nullptr;
 	m_player[1] = nullptr;
+	m_spare[0] = nullptr;
+	m_spare[1] = nullptr;
 }
 
 GameInitializer::~GameInitializer()
@@ -83,6 +119,19 @@ GameInitializer::~GameInitializer()
 		m_player[i]->disconnect();
 		m_player[i]->kill();
 	}
+	for (int i = 0; i < 2; i++)
+	{
+		if (m_spare[i] == nullptr)
+			continue;
+
+		m_spare[i]->disconnect();
+		m_spare[i]->kill();
+	}
+	for (const ReleasedPlayer& released : qAsConst(m_released))
+	{
+		released.player->disconnect();
+		released.player->kill();
+	}
 }
 
 const PlayerBuilder* GameInitializer::whiteBuilder() const
@@ -95,10 +144,53 @@ const PlayerBuilder* GameInitializer::blackBuilder() const
 	return m_builder[Chess::Side::Black];
 }
 
+const PlayerBuilder* GameInitializer::builder(int index) const
+{
+	return m_builder[index];
+}
+
+bool GameInitializer::hasPlayer(int index) const
+{
+	return m_player[index] != nullptr;
+}
+
 void GameInitializer::swapPlayers()
 {
 	std::swap(m_builder[0], m_builder[1]);
 	std::swap(m_player[0], m_player[1]);
+	std::swap(m_spare[0], m_spare[1]);
+	std::swap(m_cpus[0], m_cpus[1]);
+}
+
+void GameInitializer::setPlayer(int index,
+				const PlayerBuilder* builder,
+				ChessPlayer* player,
+				int generation)
+{
+	Q_ASSERT(builder != nullptr);
+
+	// The old player is released in this object's thread when the
+	// next game is initialized
+	if (m_player[index] != nullptr && player != m_player[index])
+	{
+		ReleasedPlayer released = { m_builder[index], m_player[index], generation };
+		m_released << released;
+	}
+	// A replacement that won't be used can go to the idle player pool
+	if (m_spare[index] != nullptr
+	&&  (builder != m_builder[index] || player != nullptr))
+	{
+		ReleasedPlayer released = { m_builder[index], m_spare[index], generation };
+		m_released << released;
+		m_spare[index] = nullptr;
+	}
+	m_builder[index] = builder;
+	m_player[index] = player;
+}
+
+void GameInitializer::setCpus(int index, const QList<int>& cpus)
+{
+	m_cpus[index] = cpus;
 }
 
 void GameInitializer::setGame(ChessGame* game)
@@ -106,6 +198,27 @@ void GameInitializer::setGame(ChessGame* game)
 	m_game = game;
 }
 
+ChessPlayer* GameInitializer::createPlayer(int index, QString* error)
+{
+	// Debug output is only formatted if someone listens
+	static const QMetaMethod signal(
+		QMetaMethod::fromSignal(&GameManager::debugMessage));
+	const bool debug = m_manager != nullptr
+			&& m_manager->isSignalConnected(signal);
+
+	ChessPlayer* player = m_builder[index]->create(m_manager,
+						       debug ? SIGNAL(debugMessage(QString))
+							     : nullptr,
+						       this, error);
+
+	ChessEngine* engine = qobject_cast<ChessEngine*>(player);
+	if (engine != nullptr)
+		connect(engine, SIGNAL(restarting()),
+			this, SLOT(onPlayerRestarting()),
+			Qt::QueuedConnection);
+	return player;
+}
+
 void GameInitializer::deletePlayer(int index)
 {
 	ChessPlayer* player = m_player[index];
@@ -123,8 +236,61 @@ void GameInitializer::deletePlayer(int index)
 	}
 }
 
+void GameInitializer::releasePlayers()
+{
+	for (const ReleasedPlayer& released : qAsConst(m_released))
+	{
+		ChessPlayer* player = released.player;
+		if (player->state() == ChessPlayer::Disconnected)
+		{
+			player->deleteLater();
+			continue;
+		}
+		if (m_manager == nullptr || released.generation == -1)
+		{
+			connect(player, SIGNAL(disconnected()),
+				player, SLOT(deleteLater()));
+			player->quit();
+			continue;
+		}
+
+		// Only the player's own thread can push it to the
+		// manager's thread for the idle player pool
+		player->setParent(nullptr);
+		player->moveToThread(m_manager->thread());
+		QMetaObject::invokeMethod(m_manager, "addIdlePlayer",
+					  Qt::QueuedConnection,
+					  Q_ARG(const PlayerBuilder*, released.builder),
+					  Q_ARG(ChessPlayer*, player),
+					  Q_ARG(int, released.generation));
+	}
+	m_released.clear();
+}
+
+void GameInitializer::pinPlayer(int index)
+{
+	if (m_cpus[index].isEmpty())
+		return;
+
+	// Players from the idle player pool may come from another
+	// game slot, so the affinity is set for every game
+	ChessEngine* engine = qobject_cast<ChessEngine*>(m_player[index]);
+	if (engine == nullptr)
+		return;
+	EngineProcess* process = qobject_cast<EngineProcess*>(engine->device());
+	if (process == nullptr)
+		return;
+
+	if (!CpuAllocator::setProcessAffinity(process->processId(),
+					      m_cpus[index]))
+		qWarning("Cannot set the CPU affinity of engine %s",
+			 qUtf8Printable(engine->name()));
+}
+
 void GameInitializer::initializeGame()
 {
+	releasePlayers();
+
 	for (int i = 0; i < 2; i++)
 	{
 		// Delete a disconnected player (crashed engine) so that
@@ -135,12 +301,21 @@ void GameInitializer::initializeGame()
 			deletePlayer(i);
 		}
 
+		// The replacement of a restarted engine has been starting
+		// since the end of the previous game
+		if (m_player[i] == nullptr && m_spare[i] != nullptr)
+		{
+			if (m_spare[i]->state() != ChessPlayer::Disconnected)
+				m_player[i] = m_spare[i];
+			else
+				m_spare[i]->deleteLater();
+			m_spare[i] = nullptr;
+		}
+
 		if (m_player[i] == nullptr)
 		{
 			QString error;
-			m_player[i] = m_builder[i]->create(thread()->parent(),
-							   SIGNAL(debugMessage(QString)),
-							   this, &error);
+			m_player[i] = createPlayer(i, &error);
 			m_game->setError(error);
 
 			if (m_player[i] == nullptr)
@@ -152,6 +327,10 @@ void GameInitializer::initializeGame()
 				return;
 			}
 		}
+		// A player from the idle player pool has no parent yet
+		else if (m_player[i]->parent() != this)
+			m_player[i]->setParent(this);
+		pinPlayer(i);
 		m_game->setPlayer(Chess::Side::Type(i), m_player[i]);
 	}
 	m_playerCount = 2;
@@ -165,6 +344,26 @@ void GameInitializer::finish()
 		return;
 	m_finishing = true;
 
+	// Players released after the last game quit with the others
+	for (int i = 0; i < 2; i++)
+	{
+		if (m_spare[i] == nullptr)
+			continue;
+
+		ReleasedPlayer released = { m_builder[i], m_spare[i], -1 };
+		m_released << released;
+		m_spare[i] = nullptr;
+	}
+	for (const ReleasedPlayer& released : qAsConst(m_released))
+	{
+		m_playerCount++;
+		connect(released.player, SIGNAL(disconnected()),
+			this, SLOT(onPlayerQuit()),
+			Qt::QueuedConnection);
+		released.player->quit();
+	}
+	m_released.clear();
+
 	if (m_playerCount <= 0)
 	{
 		emit finished();
@@ -189,17 +388,44 @@ void GameInitializer::onPlayerQuit()
 		emit finished();
 }
 
+void GameInitializer::onPlayerRestarting()
+{
+	if (m_finishing)
+		return;
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (m_player[i] != QObject::sender() || m_spare[i] != nullptr)
+			continue;
+
+		// The new instance starts its protocol while the old one
+		// quits and the game is saved. Errors are reported when
+		// the next game creates the player again.
+		QString error;
+		m_spare[i] = createPlayer(i, &error);
+		break;
+	}
+}
+
 
-class GameThread : public QThread
+/*
+ * A game slot. The slot's initializer, games and players run either in
+ * the slot's own thread or in a worker thread shared with other slots.
+ */
+class GameThread : public QObject
 {
 	Q_OBJECT
 
 	public:
 		GameThread(const PlayerBuilder* white,
 			   const PlayerBuilder* black,
-			   QObject* parent);
+			   GameManager* manager,
+			   QThread* worker = nullptr);
 		virtual ~GameThread();
 
+		QThread* workerThread() const;
+		bool isRunning() const;
+		void start();
 		bool isReady() const;
 		void newGame(ChessGame* game);
 		void finish();
@@ -209,34 +435,47 @@ class GameThread : public QThread
 		ChessGame* game() const;
 		GameManager::StartMode startMode() const;
 		GameManager::CleanupMode cleanupMode() const;
+		int cpuSlot() const;
 
 		void setStartMode(GameManager::StartMode mode);
 		void setCleanupMode(GameManager::CleanupMode mode);
+		void setCpuSlot(int slot);
 
 	signals:
 		void gameInitialized(bool success);
 		void ready();
+		void finished();
 
 	private slots:
 		void onGameDestroyed();
+		void onInitializerDestroyed();
 
 	private:
 		bool m_ready;
+		bool m_running;
+		bool m_ownsThread;
+		QThread* m_thread;
 		GameManager::StartMode m_startMode;
 		GameManager::CleanupMode m_cleanupMode;
+		int m_cpuSlot;
 		ChessGame* m_game;
 		GameInitializer* m_initializer;
 };
 
 GameThread::GameThread(const PlayerBuilder* white,
 		       const PlayerBuilder* black,
-		       QObject* parent)
-	: QThread(parent),
+		       GameManager* manager,
+		       QThread* worker)
+	: QObject(manager),
 	  m_ready(true),
+	  m_running(false),
+	  m_ownsThread(worker == nullptr),
+	  m_thread(worker != nullptr ? worker : new QThread(this)),
 	  m_startMode(GameManager::StartImmediately),
 	  m_cleanupMode(GameManager::DeletePlayers),
+	  m_cpuSlot(-1),
 	  m_game(nullptr),
-	  m_initializer(new GameInitializer(white, black))
+	  m_initializer(new GameInitializer(white, black, manager))
 {
 	connect(m_initializer, SIGNAL(gameInitialized(bool)),
 		this, SIGNAL(gameInitialized(bool)));
@@ -244,13 +483,43 @@ GameThread::GameThread(const PlayerBuilder* white,
 		m_initializer, SLOT(deleteLater()),
 		Qt::QueuedConnection);
 	connect(m_initializer, SIGNAL(destroyed()),
-		this, SLOT(quit()),
+		this, SLOT(onInitializerDestroyed()),
 		Qt::QueuedConnection);
-	m_initializer->moveToThread(this);
+	if (m_ownsThread)
+	{
+		static int threadCount = 0;
+		m_thread->setObjectName(QString("GameThread %1").arg(++threadCount));
+		connect(m_thread, SIGNAL(finished()), this, SIGNAL(finished()));
+	}
+	m_initializer->moveToThread(m_thread);
 }
 
 GameThread::~GameThread()
 {
+	if (m_ownsThread)
+	{
+		m_thread->quit();
+		m_thread->wait();
+	}
+}
+
+QThread* GameThread::workerThread() const
+{
+	return m_thread;
+}
+
+bool GameThread::isRunning() const
+{
+	if (m_ownsThread)
+		return m_thread->isRunning();
+	return m_running;
+}
+
+void GameThread::start()
+{
+	m_running = true;
+	if (m_ownsThread)
+		m_thread->start();
 }
 
 bool GameThread::isReady() const
@@ -313,6 +582,11 @@ GameManager::CleanupMode GameThread::cleanupMode() const
 	return m_cleanupMode;
 }
 
+int GameThread::cpuSlot() const
+{
+	return m_cpuSlot;
+}
+
 void GameThread::setStartMode(GameManager::StartMode mode)
 {
 	m_startMode = mode;
@@ -323,19 +597,55 @@ void GameThread::setCleanupMode(GameManager::CleanupMode mode)
 	m_cleanupMode = mode;
 }
 
+void GameThread::setCpuSlot(int slot)
+{
+	m_cpuSlot = slot;
+}
+
 void GameThread::onGameDestroyed()
 {
 	m_ready = true;
 	emit ready();
 }
 
+void GameThread::onInitializerDestroyed()
+{
+	m_running = false;
+	if (m_ownsThread)
+		m_thread->quit();
+	else
+		emit finished();
+}
+
 
 GameManager::GameManager(QObject* parent)
 	: QObject(parent),
 	  m_finishing(false),
+	  m_cleaningUp(false),
+	  m_startingQueuedGames(false),
+	  m_startPending(false),
 	  m_concurrency(1),
-	  m_activeQueuedGameCount(0)
+	  m_activeQueuedGameCount(0),
+	  m_idlePlayerLimit(0),
+	  m_poolGeneration(0),
+	  m_quittingPlayerCount(0),
+	  m_workerThreadCount(0),
+	  m_cpuAllocator(nullptr),
+	  m_loadMonitor(nullptr),
+	  m_liveFeed(nullptr)
+{
+	qRegisterMetaType<const PlayerBuilder*>();
+	qRegisterMetaType<ChessPlayer*>();
+}
+
+GameManager::~GameManager()
 {
+	for (QThread* worker : qAsConst(m_workers))
+	{
+		worker->quit();
+		worker->wait();
+	}
+	delete m_cpuAllocator;
 }
 
 QList<ChessGame*> GameManager::activeGames() const
@@ -353,7 +663,141 @@ void GameManager::setConcurrency(int concurrency)
 	m_concurrency = concurrency;
 }
 
+int GameManager::idlePlayerLimit() const
+{
+	return m_idlePlayerLimit;
+}
+
+void GameManager::setIdlePlayerLimit(int limit)
+{
+	Q_ASSERT(limit >= 0);
+	m_idlePlayerLimit = limit;
+
+	while (m_idlePlayers.size() > m_idlePlayerLimit)
+	{
+		auto it = m_idlePlayers.begin();
+		ChessPlayer* player = it.value();
+		m_idlePlayers.erase(it);
+		quitPlayer(player);
+	}
+}
+
+int GameManager::workerThreadCount() const
+{
+	return m_workerThreadCount;
+}
+
+void GameManager::setWorkerThreadCount(int count)
+{
+	Q_ASSERT(count >= 0);
+	m_workerThreadCount = count;
+}
+
+QThread* GameManager::workerThread()
+{
+	Q_ASSERT(m_workerThreadCount > 0);
+
+	while (m_workers.size() < m_workerThreadCount)
+	{
+		QThread* worker = new QThread(this);
+		worker->setObjectName(QString("Game worker %1").arg(m_workers.size() + 1));
+		worker->start();
+		m_workers << worker;
+	}
+
+	// Use the worker with the fewest game slots
+	QThread* best = nullptr;
+	int bestLoad = 0;
+	for (int i = 0; i < m_workerThreadCount; i++)
+	{
+		QThread* worker = m_workers.at(i);
+		int load = 0;
+		for (GameThread* thread : qAsConst(m_threads))
+		{
+			if (thread != nullptr && thread->workerThread() == worker)
+				load++;
+		}
+		if (best == nullptr || load < bestLoad)
+		{
+			best = worker;
+			bestLoad = load;
+		}
+	}
+
+	return best;
+}
+
+LoadMonitor* GameManager::loadMonitor() const
+{
+	return m_loadMonitor;
+}
+
+void GameManager::setLoadMonitor(LoadMonitor* monitor)
+{
+	delete m_loadMonitor;
+	m_loadMonitor = monitor;
+	if (monitor == nullptr)
+		return;
+
+	monitor->setParent(this);
+	connect(monitor, SIGNAL(overloadEnded()),
+		this, SLOT(startPendingGames()));
+}
+
+LiveGameFeed* GameManager::liveFeed() const
+{
+	return m_liveFeed;
+}
+
+void GameManager::setLiveFeed(LiveGameFeed* feed)
+{
+	delete m_liveFeed;
+	m_liveFeed = feed;
+	if (feed != nullptr)
+		feed->setParent(this);
+}
+
+void GameManager::setCpuAffinity(int coresPerEngine, bool numaPerGame)
+{
+	setCpuAffinity(coresPerEngine, coresPerEngine > 0
+		       ? CpuAllocator::cpuGroups(numaPerGame)
+		       : QList< QList<int> >());
+}
+
+void GameManager::setCpuAffinity(int coresPerEngine,
+				 const QList< QList<int> >& cpuGroups)
+{
+	Q_ASSERT(coresPerEngine >= 0);
+
+	// Slots that are in use are dropped with the old allocator
+	for (GameThread* thread : qAsConst(m_threads))
+	{
+		if (thread != nullptr)
+			thread->setCpuSlot(-1);
+	}
+	delete m_cpuAllocator;
+	m_cpuAllocator = nullptr;
+
+	if (coresPerEngine > 0)
+		m_cpuAllocator = new CpuAllocator(coresPerEngine, cpuGroups);
+}
+
+void GameManager::releaseCpuSlot(GameThread* thread)
+{
+	if (m_cpuAllocator == nullptr || thread->cpuSlot() == -1)
+		return;
+
+	m_cpuAllocator->release(thread->cpuSlot());
+	thread->setCpuSlot(-1);
+}
+
 void GameManager::cleanupIdleThreads()
+{
+	finishIdleThreads();
+	quitIdlePlayers();
+}
+
+void GameManager::finishIdleThreads()
 {
 	QList<GameThread*>::iterator it = m_activeThreads.begin();
 	while (it != m_activeThreads.end())
@@ -364,6 +808,7 @@ void GameManager::cleanupIdleThreads()
 		if (thread->isReady())
 		{
 			it = m_activeThreads.erase(it);
+			releaseCpuSlot(thread);
 			thread->finishAndDelete();
 		}
 		else
@@ -371,9 +816,105 @@ void GameManager::cleanupIdleThreads()
 	}
 }
 
+void GameManager::addIdlePlayer(const PlayerBuilder* builder,
+				ChessPlayer* player,
+				int generation)
+{
+	Q_ASSERT(builder != nullptr);
+	Q_ASSERT(player != nullptr);
+
+	// The builder may have been deleted if the pool was cleaned up
+	// after the player was released
+	if (generation != m_poolGeneration
+	||  m_idlePlayers.size() >= m_idlePlayerLimit)
+	{
+		quitPlayer(player);
+		return;
+	}
+
+	player->setParent(this);
+	m_idlePlayers.insert(builder, player);
+}
+
+ChessPlayer* GameManager::takeIdlePlayer(const PlayerBuilder* builder,
+					 QThread* thread)
+{
+	auto it = m_idlePlayers.find(builder);
+	while (it != m_idlePlayers.end() && it.key() == builder)
+	{
+		ChessPlayer* player = it.value();
+		it = m_idlePlayers.erase(it);
+
+		// Engines can crash while they're idle
+		if (player->state() == ChessPlayer::Disconnected)
+		{
+			player->deleteLater();
+			continue;
+		}
+
+		player->setParent(nullptr);
+		player->moveToThread(thread);
+		return player;
+	}
+
+	return nullptr;
+}
+
+void GameManager::quitPlayer(ChessPlayer* player)
+{
+	if (player->state() == ChessPlayer::Disconnected)
+	{
+		player->deleteLater();
+		return;
+	}
+
+	m_quittingPlayerCount++;
+	connect(player, SIGNAL(disconnected()),
+		this, SLOT(onIdlePlayerQuit()));
+	player->quit();
+}
+
+void GameManager::quitIdlePlayers()
+{
+	// Players released before this are not added to the pool
+	m_poolGeneration++;
+
+	const auto players = m_idlePlayers.values();
+	m_idlePlayers.clear();
+	for (ChessPlayer* player : players)
+		quitPlayer(player);
+}
+
+void GameManager::onIdlePlayerQuit()
+{
+	QObject* player = QObject::sender();
+	Q_ASSERT(player != nullptr);
+
+	disconnect(player, SIGNAL(disconnected()),
+		   this, SLOT(onIdlePlayerQuit()));
+	player->deleteLater();
+
+	m_quittingPlayerCount--;
+	checkFinished();
+}
+
+void GameManager::checkFinished()
+{
+	if (!m_cleaningUp
+	||  !m_threads.isEmpty()
+	||  m_quittingPlayerCount > 0)
+		return;
+
+	m_cleaningUp = false;
+	m_finishing = false;
+	emit finished();
+}
+
 void GameManager::cleanup()
 {
 	m_finishing = false;
+	m_cleaningUp = true;
+	quitIdlePlayers();
 
 	// Remove terminated threads from the list
 	QList< QPointer<GameThread> >::iterator it = m_threads.begin();
@@ -387,13 +928,14 @@ void GameManager::cleanup()
 
 	if (m_threads.isEmpty())
 	{
-		emit finished();
+		checkFinished();
 		return;
 	}
 
 	// Terminate running threads
 	for (GameThread* thread : qAsConst(m_threads))
 	{
+		releaseCpuSlot(thread);
 		connect(thread, SIGNAL(finished()), this, SLOT(onThreadQuit()),
 			Qt::QueuedConnection);
 		thread->finish();
@@ -442,11 +984,7 @@ void GameManager::onThreadQuit()
 	if (thread != nullptr)
 		thread->deleteLater();
 
-	if (m_threads.isEmpty())
-	{
-		m_finishing = false;
-		emit finished();
-	}
+	checkFinished();
 }
 
 void GameManager::onThreadReady()
@@ -461,13 +999,21 @@ void GameManager::onThreadReady()
 	if (thread->cleanupMode() == DeletePlayers)
 	{
 		m_activeThreads.removeOne(thread);
+		releaseCpuSlot(thread);
 		thread->finishAndDelete();
 	}
 
+	// The slots of games that end at the same time are filled
+	// in one batch
 	if (thread->startMode() == Enqueue)
 	{
 		m_activeQueuedGameCount--;
-		startQueuedGame();
+		if (!m_startPending)
+		{
+			m_startPending = true;
+			QMetaObject::invokeMethod(this, "startPendingGames",
+						  Qt::QueuedConnection);
+		}
 	}
 
 	emit gameDestroyed(game);
@@ -488,6 +1034,7 @@ void GameManager::onGameInitialized(bool success)
 
 		m_threads.removeOne(gameThread);
 		m_activeThreads.removeOne(gameThread);
+		releaseCpuSlot(gameThread);
 
 		connect(gameThread, SIGNAL(destroyed()),
 			game, SLOT(emitStartFailed()));
@@ -498,9 +1045,12 @@ void GameManager::onGameInitialized(bool success)
 
 	m_activeGames << game;
 	if (gameThread->startMode() == Enqueue)
-		cleanupIdleThreads();
+		finishIdleThreads();
+	game->setLoadMonitor(m_loadMonitor);
+	if (m_liveFeed != nullptr)
+		m_liveFeed->addGame(game);
 
-	game->moveToThread(gameThread);
+	game->moveToThread(gameThread->workerThread());
 	connect(game, SIGNAL(started(ChessGame*)),
 		this, SIGNAL(gameStarted(ChessGame*)),
 		Qt::QueuedConnection);
@@ -510,7 +1060,8 @@ void GameManager::onGameInitialized(bool success)
 }
 
 GameThread* GameManager::getThread(const PlayerBuilder* white,
-				   const PlayerBuilder* black)
+				   const PlayerBuilder* black,
+				   CleanupMode cleanupMode)
 {
 	Q_ASSERT(white != nullptr);
 	Q_ASSERT(black != nullptr);
@@ -528,22 +1079,89 @@ GameThread* GameManager::getThread(const PlayerBuilder* white,
 			return thread;
 	}
 
-	GameThread* gameThread = new GameThread(white, black, this);
-	m_threads << gameThread;
-	m_activeThreads << gameThread;
-	connect(gameThread, SIGNAL(ready()),
-		this, SLOT(onThreadReady()));
-	connect(gameThread, SIGNAL(gameInitialized(bool)),
-		this, SLOT(onGameInitialized(bool)),
-		Qt::QueuedConnection);
+	// Pair an idle thread again if its players can be reused. The
+	// thread that shares the most players with the new game is used.
+	GameThread* gameThread = nullptr;
+	int sharedCount = -1;
+	if (cleanupMode == ReusePlayers)
+	{
+		for (GameThread* thread : qAsConst(m_activeThreads))
+		{
+			if (!thread->isReady()
+			||  thread->cleanupMode() != ReusePlayers)
+				continue;
+
+			GameInitializer* tmp = thread->initializer();
+			int count = 0;
+			if (tmp->whiteBuilder() == white || tmp->blackBuilder() == white)
+				count++;
+			if (tmp->whiteBuilder() == black || tmp->blackBuilder() == black)
+				count++;
+			if (count > sharedCount)
+			{
+				sharedCount = count;
+				gameThread = thread;
+			}
+		}
+	}
+
+	if (gameThread != nullptr)
+	{
+		// Keep a shared player on the same side in the initializer
+		GameInitializer* tmp = gameThread->initializer();
+		if (tmp->whiteBuilder() == black || tmp->blackBuilder() == white)
+			tmp->swapPlayers();
+	}
+	else
+	{
+		QThread* worker = m_workerThreadCount > 0 ? workerThread() : nullptr;
+		gameThread = new GameThread(white, black, this, worker);
+		m_threads << gameThread;
+		m_activeThreads << gameThread;
+
+		if (m_cpuAllocator != nullptr)
+		{
+			const int slot = m_cpuAllocator->acquire();
+			gameThread->setCpuSlot(slot);
+			for (int i = 0; i < 2; i++)
+				gameThread->initializer()->setCpus(i,
+					m_cpuAllocator->cpus(slot, i));
+		}
+		connect(gameThread, SIGNAL(ready()),
+			this, SLOT(onThreadReady()));
+		connect(gameThread, SIGNAL(gameInitialized(bool)),
+			this, SLOT(onGameInitialized(bool)),
+			Qt::QueuedConnection);
+	}
 
-	gameThread->start();
+	// Replace the players that aren't shared, preferably with
+	// players from the idle player pool
+	GameInitializer* initializer = gameThread->initializer();
+	const PlayerBuilder* builders[2] = { white, black };
+	const int generation = cleanupMode == ReusePlayers && m_idlePlayerLimit > 0
+			       ? m_poolGeneration : -1;
+	for (int i = 0; i < 2; i++)
+	{
+		if (initializer->builder(i) == builders[i]
+		&&  initializer->hasPlayer(i))
+			continue;
+
+		ChessPlayer* player = nullptr;
+		if (cleanupMode == ReusePlayers)
+			player = takeIdlePlayer(builders[i],
+						gameThread->workerThread());
+		initializer->setPlayer(i, builders[i], player, generation);
+	}
+
+	if (!gameThread->isRunning())
+		gameThread->start();
 	return gameThread;
 }
 
 void GameManager::startGame(const GameEntry& entry)
 {
-	GameThread* gameThread = getThread(entry.white, entry.black);
+	GameThread* gameThread = getThread(entry.white, entry.black,
+					   entry.cleanupMode);
 	Q_ASSERT(gameThread != nullptr);
 
 	gameThread->setStartMode(entry.startMode);
@@ -551,18 +1169,46 @@ void GameManager::startGame(const GameEntry& entry)
 	gameThread->newGame(entry.game);
 }
 
+void GameManager::startPendingGames()
+{
+	m_startPending = false;
+	if (!m_cleaningUp)
+		startQueuedGame();
+}
+
 void GameManager::startQueuedGame()
 {
-	if (m_activeQueuedGameCount >= m_concurrency)
+	// Games added by receivers of the ready() signal are
+	// started by the loop below instead of recursively
+	if (m_startingQueuedGames)
 		return;
-	if (m_gameEntries.isEmpty())
+	m_startingQueuedGames = true;
+
+	while (m_activeQueuedGameCount < m_concurrency)
 	{
-		emit ready();
-		return;
+		// An overloaded host still runs one game so that the
+		// match makes progress
+		if (m_activeQueuedGameCount > 0
+		&&  m_loadMonitor != nullptr
+		&&  m_loadMonitor->isOverloaded())
+			break;
+
+		if (m_gameEntries.isEmpty())
+		{
+			emit readyForGames(m_concurrency - m_activeQueuedGameCount);
+			if (m_gameEntries.isEmpty())
+				emit ready();
+			if (m_gameEntries.isEmpty())
+				break;
+		}
+
+		// Don't wait for the game to be initialized; its players
+		// start in the game thread while the next game is queued
+		m_activeQueuedGameCount++;
+		startGame(m_gameEntries.takeFirst());
 	}
 
-	m_activeQueuedGameCount++;
-	startGame(m_gameEntries.takeFirst());
+	m_startingQueuedGames = false;
 }
 
 #include "gamemanager.moc"
@@ -21,10 +21,15 @@
 
 #include <QObject>
 #include <QList>
+#include <QMultiMap>
 #include <QPointer>
 class ChessGame;
 class ChessPlayer;
 class PlayerBuilder;
+class CpuAllocator;
+class LoadMonitor;
+class LiveGameFeed;
+class QThread;
 class GameThread;
 
 
@@ -35,6 +40,12 @@ class GameThread;
  * multiple games concurrently, and queue games to be
  * run when a game slot/thread is free.
  *
+ * Players of games started in ReusePlayers mode stay alive between
+ * games. When the pairing changes, an idle game thread is paired again
+ * and keeps the players it shares with the new game. The other players
+ * can be kept in a pool of idle players, up to idlePlayerLimit(), and
+ * handed to the next game that needs them instead of starting new ones.
+ *
  * \sa ChessGame, PlayerBuilder
  */
 class LIB_EXPORT GameManager : public QObject
@@ -71,6 +82,8 @@ class LIB_EXPORT GameManager : public QObject
 
 		/*! Creates a new game manager. */
 		GameManager(QObject* parent = nullptr);
+		/*! Destroys the game manager. */
+		virtual ~GameManager();
 
 		/*!
 		 * Returns the list of active games.
@@ -98,13 +111,113 @@ class LIB_EXPORT GameManager : public QObject
 		 */
 		void setConcurrency(int concurrency);
 
+		/*!
+		 * Returns the maximum number of idle players that are kept
+		 * alive for future games.
+		 *
+		 * \sa setIdlePlayerLimit()
+		 */
+		int idlePlayerLimit() const;
+		/*!
+		 * Sets the maximum number of idle players to \a limit.
+		 *
+		 * Only players of games started in ReusePlayers mode are
+		 * kept. Every idle engine keeps its memory (eg. hash tables)
+		 * allocated, so the default limit is 0.
+		 *
+		 * \sa idlePlayerLimit()
+		 */
+		void setIdlePlayerLimit(int limit);
+
+		/*!
+		 * Returns the number of shared worker threads.
+		 *
+		 * \sa setWorkerThreadCount()
+		 */
+		int workerThreadCount() const;
+		/*!
+		 * Runs the games in a fixed pool of \a count worker threads.
+		 *
+		 * Each game slot is assigned to the worker with the fewest
+		 * slots, and many games share the event loop of a worker.
+		 * This saves OS threads and scheduling overhead when a lot
+		 * of short games run concurrently. If \a count is 0
+		 * (the default), every game slot has its own thread.
+		 *
+		 * Only game slots created after this call are affected.
+		 *
+		 * \sa workerThreadCount()
+		 */
+		void setWorkerThreadCount(int count);
+
+		/*!
+		 * Pins every engine process to a dedicated set of
+		 * \a coresPerEngine CPU cores.
+		 *
+		 * Each game thread reserves a slot with a core set for both
+		 * players when it's created, and the slots are given
+		 * round-robin. If \a numaPerGame is true, both players of a
+		 * game run on the same NUMA node. The engines' own thread
+		 * options should match \a coresPerEngine.
+		 *
+		 * If \a coresPerEngine is 0, the engines are not pinned.
+		 * Only threads created after this call are affected.
+		 *
+		 * \note Not supported on macOS.
+		 */
+		void setCpuAffinity(int coresPerEngine, bool numaPerGame);
+		/*!
+		 * Pins every engine process to a dedicated set of
+		 * \a coresPerEngine CPU cores from \a cpuGroups.
+		 *
+		 * This is the same as the function above, but the CPUs and
+		 * their grouping are given by the caller, eg. to leave out
+		 * simultaneous multithreading siblings.
+		 *
+		 * \sa CpuAllocator::cpuGroups()
+		 */
+		void setCpuAffinity(int coresPerEngine,
+				    const QList< QList<int> >& cpuGroups);
+
+		/*!
+		 * Returns the load monitor, or nullptr if there's none.
+		 *
+		 * \sa setLoadMonitor()
+		 */
+		LoadMonitor* loadMonitor() const;
+		/*!
+		 * Sets the load monitor that controls the admission of
+		 * queued games to \a monitor, and takes its ownership.
+		 *
+		 * While the host is overloaded, queued games are held
+		 * back, except when no queued game is running. The games
+		 * report their moves to the monitor and tag the moves
+		 * that were affected by the overload in their PGN.
+		 */
+		void setLoadMonitor(LoadMonitor* monitor);
+
+		/*!
+		 * Returns the live game feed, or nullptr if there's none.
+		 *
+		 * \sa setLiveFeed()
+		 */
+		LiveGameFeed* liveFeed() const;
+		/*!
+		 * Publishes the moves of the games to \a feed, and takes
+		 * its ownership.
+		 *
+		 * Only the games started after this call are published.
+		 */
+		void setLiveFeed(LiveGameFeed* feed);
+
 		/*!
 		 * Cleans up and deletes all idle game threads
 		 *
 		 * This function cleans up and removes all resources used by
 		 * game threads that are waiting for new games. The resources
-		 * include the players and the thread they're living in. The
-		 * PlayerBuilder objects will not be deleted.
+		 * include the players and the thread they're living in, and
+		 * the players in the idle player pool. The PlayerBuilder
+		 * objects will not be deleted.
 		 *
 		 * Generally this function should be called after a tournament
 		 * has ended.
@@ -165,15 +278,30 @@ class LIB_EXPORT GameManager : public QObject
 		 */
 		void gameDestroyed(ChessGame* game);
 		/*!
-		 * This signal is emitted after a game has started
-		 * or after a game has ended, if there are free
-		 * game slots.
+		 * This signal is emitted after a game has been handed to
+		 * its game thread or after a game has ended, if there are
+		 * free game slots.
+		 *
+		 * Queued games don't wait for earlier games to finish
+		 * initializing, so the engines of a whole wave of games
+		 * start in parallel.
 		 *
 		 * \note The signal is NOT emitted if a newly freed
 		 * game slot can be used by a game that was waiting in
 		 * the queue.
 		 */
 		void ready();
+		/*!
+		 * This signal is emitted before ready() when there are
+		 * \a count free game slots and no queued games.
+		 *
+		 * A receiver can fill all of the slots at once by adding
+		 * up to \a count games in Enqueue mode. Games that end at
+		 * the same time are replaced in one batch.
+		 *
+		 * \sa ready()
+		 */
+		void readyForGames(int count);
 		/*!
 		 * This signal is emitted when all games have ended and all
 		 * idle players have been deleted. Then the manager can be
@@ -186,9 +314,16 @@ class LIB_EXPORT GameManager : public QObject
 	private slots:
 		void onThreadReady();
 		void onThreadQuit();
+		void startPendingGames();
 		void onGameInitialized(bool success);
+		void addIdlePlayer(const PlayerBuilder* builder,
+				   ChessPlayer* player,
+				   int generation);
+		void onIdlePlayerQuit();
 
 	private:
+		friend class GameInitializer;
+
 		struct GameEntry
 		{
 			ChessGame* game;
@@ -199,14 +334,35 @@ class LIB_EXPORT GameManager : public QObject
 		};
 
 		GameThread* getThread(const PlayerBuilder* white,
-				      const PlayerBuilder* black);
+				      const PlayerBuilder* black,
+				      CleanupMode cleanupMode);
 		void startGame(const GameEntry& entry);
 		void startQueuedGame();
+		void finishIdleThreads();
+		ChessPlayer* takeIdlePlayer(const PlayerBuilder* builder,
+					    QThread* thread);
+		void quitPlayer(ChessPlayer* player);
+		void quitIdlePlayers();
+		void releaseCpuSlot(GameThread* thread);
+		QThread* workerThread();
 		void cleanup();
+		void checkFinished();
 
 		bool m_finishing;
+		bool m_cleaningUp;
+		bool m_startingQueuedGames;
+		bool m_startPending;
 		int m_concurrency;
 		int m_activeQueuedGameCount;
+		int m_idlePlayerLimit;
+		int m_poolGeneration;
+		int m_quittingPlayerCount;
+		int m_workerThreadCount;
+		CpuAllocator* m_cpuAllocator;
+		LoadMonitor* m_loadMonitor;
+		LiveGameFeed* m_liveFeed;
+		QList<QThread*> m_workers;
+		QMultiMap<const PlayerBuilder*, ChessPlayer*> m_idlePlayers;
 		QList< QPointer<GameThread> > m_threads;
 		QList<GameThread*> m_activeThreads;
 		QList<GameEntry> m_gameEntries;
@@ -0,0 +1,103 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gamesink.h"
+
+GameSink::GameSink(const QString& name)
+	: m_name(name)
+{
+}
+
+GameSink::~GameSink()
+{
+}
+
+QString GameSink::name() const
+{
+	return m_name;
+}
+
+QString GameSink::errorString() const
+{
+	return m_error;
+}
+
+void GameSink::setError(const QString& error)
+{
+	m_error = error;
+}
+
+
+FileGameSink::FileGameSink(const QString& name, const QString& fileName)
+	: GameSink(name),
+	  m_file(fileName)
+{
+}
+
+FileGameSink::~FileGameSink()
+{
+	if (m_file.isOpen())
+		m_file.close();
+}
+
+QString FileGameSink::fileName() const
+{
+	return m_file.fileName();
+}
+
+QFile* FileGameSink::file()
+{
+	return &m_file;
+}
+
+bool FileGameSink::openFile()
+{
+	bool isOpen = m_file.isOpen();
+	if (isOpen && m_file.exists())
+		return true;
+
+	if (isOpen)
+	{
+		qWarning("The %s file %s does not exist. Reopening...",
+			 qUtf8Printable(name()),
+			 qUtf8Printable(m_file.fileName()));
+		m_file.close();
+	}
+
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		setError(QString("Could not open %1 file %2")
+			 .arg(name(), m_file.fileName()));
+		return false;
+	}
+
+	deviceOpened(&m_file);
+	return true;
+}
+
+bool FileGameSink::writeError()
+{
+	setError(QString("Could not write to %1 file %2")
+		 .arg(name(), m_file.fileName()));
+	return false;
+}
+
+void FileGameSink::deviceOpened(QIODevice* device)
+{
+	Q_UNUSED(device);
+}
@@ -0,0 +1,145 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMESINK_H
+#define GAMESINK_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QSharedPointer>
+#include <QFile>
+#include "pgngame.h"
+#include "moveevaluation.h"
+#include "board/result.h"
+
+/*!
+ * \brief A finished game that is published to the game sinks
+ *
+ * A record is created once per game and shared read-only by all
+ * sinks, so it must not be modified after it's published.
+ *
+ * \sa GameSink
+ */
+struct LIB_EXPORT GameRecord
+{
+	/*! The game number, starting from 1. */
+	int number;
+	/*! The game with its tags and moves. */
+	PgnGame pgn;
+	/*! The evaluations of the moves. */
+	QVector<MoveEvaluation> evaluations;
+	/*! The FEN string of the end position. */
+	QString endFen;
+	/*! The result, with the way the game ended. */
+	Chess::Result result;
+	/*! The engine log of the game, if one was kept. */
+	QByteArray engineLog;
+};
+
+/*! A shared, immutable game record. */
+typedef QSharedPointer<const GameRecord> SharedGameRecord;
+
+/*!
+ * \brief An output for finished games
+ *
+ * A tournament gives each of its sinks a background thread and a queue
+ * of its own, so a slow sink delays neither the tournament nor the
+ * other sinks. write() is called by that thread only, in the order
+ * the games finished.
+ *
+ * \sa Tournament::addGameSink()
+ */
+class LIB_EXPORT GameSink
+{
+	public:
+		/*!
+		 * Creates a new sink named \a name.
+		 *
+		 * The name identifies the sink in error messages, and a
+		 * tournament has only one sink of each name.
+		 */
+		explicit GameSink(const QString& name);
+		/*! Destroys the sink. */
+		virtual ~GameSink();
+
+		/*! Returns the name of the sink. */
+		QString name() const;
+		/*! Returns the description of the last error. */
+		QString errorString() const;
+
+		/*!
+		 * Writes \a record to the output.
+		 *
+		 * Returns true if successful; otherwise sets the error
+		 * string and returns false.
+		 */
+		virtual bool write(const GameRecord& record) = 0;
+
+	protected:
+		/*! Sets the error string to \a error. */
+		void setError(const QString& error);
+
+	private:
+		QString m_name;
+		QString m_error;
+};
+
+/*!
+ * \brief A game sink that appends to a file
+ *
+ * The file is opened when the first game is written, and opened again
+ * if it's moved or deleted while the games are being written.
+ */
+class LIB_EXPORT FileGameSink : public GameSink
+{
+	public:
+		/*! Creates a new sink named \a name for file \a fileName. */
+		FileGameSink(const QString& name, const QString& fileName);
+		/*! Closes the file and destroys the sink. */
+		virtual ~FileGameSink();
+
+		/*! Returns the name of the file. */
+		QString fileName() const;
+
+	protected:
+		/*!
+		 * Makes sure that the file is open for appending.
+		 *
+		 * Returns true if successful; otherwise sets the error
+		 * string and returns false.
+		 */
+		bool openFile();
+		/*! Returns the file. */
+		QFile* file();
+		/*!
+		 * Sets the error string to a description of a failed
+		 * write, and returns false.
+		 */
+		bool writeError();
+		/*!
+		 * This function is called when the file has been opened
+		 * as \a device. The default implementation does nothing.
+		 */
+		virtual void deviceOpened(QIODevice* device);
+
+	private:
+		QFile m_file;
+};
+
+#endif // GAMESINK_H
@@ -0,0 +1,124 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gamesinks.h"
+#include <QDir>
+#include "compressedfile.h"
+
+EpdSink::EpdSink(const QString& fileName)
+	: FileGameSink("EPD", fileName)
+{
+}
+
+void EpdSink::deviceOpened(QIODevice* device)
+{
+	m_out.setDevice(device);
+}
+
+bool EpdSink::write(const GameRecord& record)
+{
+	if (!openFile())
+		return false;
+
+	m_out << record.endFen << "\n";
+	m_out.flush();
+	if (file()->error() != QFile::NoError)
+		return writeError();
+	return true;
+}
+
+
+CompactGameSink::CompactGameSink(const QString& fileName)
+	: FileGameSink("compact game", fileName)
+{
+}
+
+void CompactGameSink::deviceOpened(QIODevice* device)
+{
+	m_writer.setDevice(device);
+}
+
+bool CompactGameSink::write(const GameRecord& record)
+{
+	if (!openFile())
+		return false;
+
+	if (!m_writer.write(record.pgn, record.evaluations) || !file()->flush())
+		return writeError();
+	return true;
+}
+
+
+TrainingDataSink::TrainingDataSink(const QString& fileName,
+				   const TrainingDataWriter::Filter& filter)
+	: FileGameSink("training data", fileName)
+{
+	m_writer.setFilter(filter);
+}
+
+void TrainingDataSink::deviceOpened(QIODevice* device)
+{
+	m_writer.setDevice(device);
+}
+
+bool TrainingDataSink::write(const GameRecord& record)
+{
+	if (!openFile())
+		return false;
+
+	// Unlike the game outputs the file isn't flushed after each game:
+	// QFile's buffer collects the small records
+	if (m_writer.write(record.pgn, record.evaluations) == -1)
+		return writeError();
+	return true;
+}
+
+
+EngineLogSink::EngineLogSink(const QString& directory, const QString& suffix)
+	: GameSink("engine log"),
+	  m_directory(directory),
+	  m_suffix(suffix)
+{
+}
+
+bool EngineLogSink::write(const GameRecord& record)
+{
+	// The logs are needed only for the games that failed
+	switch (record.result.type())
+	{
+	case Chess::Result::Timeout:
+	case Chess::Result::IllegalMove:
+	case Chess::Result::Disconnection:
+	case Chess::Result::StalledConnection:
+		break;
+	default:
+		return true;
+	}
+
+	const QString fileName(QDir(m_directory).filePath(
+		QString("game-%1.log%2").arg(record.number).arg(m_suffix)));
+	CompressedFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly)
+	||  file.write(record.engineLog) != record.engineLog.size())
+	{
+		setError(QString("Could not write engine log file %1")
+			 .arg(fileName));
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,122 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMESINKS_H
+#define GAMESINKS_H
+
+#include <QTextStream>
+#include "gamesink.h"
+#include "compactgamewriter.h"
+#include "trainingdatawriter.h"
+
+/*!
+ * \brief A game sink that appends the end positions to an EPD file
+ */
+class LIB_EXPORT EpdSink : public FileGameSink
+{
+	public:
+		/*! Creates a new sink for EPD file \a fileName. */
+		explicit EpdSink(const QString& fileName);
+
+		// Inherited from GameSink
+		virtual bool write(const GameRecord& record);
+
+	protected:
+		// Inherited from FileGameSink
+		virtual void deviceOpened(QIODevice* device);
+
+	private:
+		QTextStream m_out;
+};
+
+/*!
+ * \brief A game sink that appends the games to a compact game file
+ *
+ * \sa CompactGameWriter
+ */
+class LIB_EXPORT CompactGameSink : public FileGameSink
+{
+	public:
+		/*! Creates a new sink for compact game file \a fileName. */
+		explicit CompactGameSink(const QString& fileName);
+
+		// Inherited from GameSink
+		virtual bool write(const GameRecord& record);
+
+	protected:
+		// Inherited from FileGameSink
+		virtual void deviceOpened(QIODevice* device);
+
+	private:
+		CompactGameWriter m_writer;
+};
+
+/*!
+ * \brief A game sink that extracts training data from the games
+ *
+ * \sa TrainingDataWriter
+ */
+class LIB_EXPORT TrainingDataSink : public FileGameSink
+{
+	public:
+		/*!
+		 * Creates a new sink that appends the positions that pass
+		 * \a filter to training data file \a fileName.
+		 */
+		TrainingDataSink(const QString& fileName,
+				 const TrainingDataWriter::Filter& filter);
+
+		// Inherited from GameSink
+		virtual bool write(const GameRecord& record);
+
+	protected:
+		// Inherited from FileGameSink
+		virtual void deviceOpened(QIODevice* device);
+
+	private:
+		TrainingDataWriter m_writer;
+};
+
+/*!
+ * \brief A game sink that saves the engine logs of failed games
+ *
+ * The log of a game that ended in a time forfeit, an illegal move,
+ * a crash or a stalled engine is written to "game-<number>.log" plus
+ * a suffix in a directory. The suffix ".gz" or ".zst" compresses the
+ * file. The logs of the other games are dropped.
+ *
+ * \sa CompressedFile
+ */
+class LIB_EXPORT EngineLogSink : public GameSink
+{
+	public:
+		/*!
+		 * Creates a new sink that writes to \a directory with file
+		 * name suffix \a suffix.
+		 */
+		EngineLogSink(const QString& directory, const QString& suffix);
+
+		// Inherited from GameSink
+		virtual bool write(const GameRecord& record);
+
+	private:
+		QString m_directory;
+		QString m_suffix;
+};
+
+#endif // GAMESINKS_H
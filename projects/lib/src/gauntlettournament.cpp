@@ -33,6 +33,11 @@ QString GauntletTournament::type() const
 	return "gauntlet";
 }
 
+bool GauntletTournament::canReorderGames() const
+{
+	return true;
+}
+
 void GauntletTournament::onGameAboutToStart(ChessGame* game,
 					    const PlayerBuilder* white,
 					    const PlayerBuilder* black)
@@ -46,6 +51,17 @@ void GauntletTournament::onGameAboutToStart(ChessGame* game,
 void GauntletTournament::initializePairing()
 {
 	m_opponent = 1;
+	m_sprts.clear();
+	m_pairs.clear();
+
+	// The tournament's own test is replaced by one per opponent
+	if (!sprt()->isNull() && playerCount() > 2)
+	{
+		m_sprts.fill(*sprt(), playerCount());
+		*sprt() = Sprt();
+		for (int i = 0; i < playerCount(); i++)
+			m_pairs.append(i > 0 ? pair(0, i) : nullptr);
+	}
 }
 
 int GauntletTournament::gamesPerCycle() const
@@ -60,6 +76,23 @@ TournamentPair* GauntletTournament::nextPair(int gameNumber)
 	if (gameNumber % gamesPerEncounter() != 0)
 		return currentPair();
 
+	if (!m_sprts.isEmpty())
+	{
+		for (int i = 1; i < playerCount(); i++)
+		{
+			if (m_opponent >= playerCount())
+			{
+				m_opponent = 1;
+				setCurrentRound(currentRound() + 1);
+			}
+
+			const int opponent = m_opponent++;
+			if (!isOpponentFinished(opponent))
+				return m_pairs.at(opponent);
+		}
+		return nullptr;
+	}
+
 	if (m_opponent >= playerCount())
 	{
 		m_opponent = 1;
@@ -76,3 +109,55 @@ bool GauntletTournament::hasGauntletRatingsOrder() const
 {
 	return true;
 }
+
+bool GauntletTournament::isOpponentFinished(int opponent) const
+{
+	const int maxGames = gamesPerEncounter() * roundMultiplier();
+	return m_pairs.at(opponent)->gamesStarted() >= maxGames
+	    || m_sprts.at(opponent).status().result != Sprt::Continue;
+}
+
+bool GauntletTournament::areAllGamesFinished() const
+{
+	if (m_sprts.isEmpty())
+		return Tournament::areAllGamesFinished();
+	if (gamesInProgress() > 0)
+		return false;
+
+	for (int i = 1; i < playerCount(); i++)
+	{
+		if (!isOpponentFinished(i))
+			return false;
+	}
+	return true;
+}
+
+Sprt* GauntletTournament::pairSprt(const TournamentPair* pair)
+{
+	if (m_sprts.isEmpty())
+		return Tournament::pairSprt(pair);
+
+	const int opponent = qMax(pair->firstPlayer(), pair->secondPlayer());
+	return &m_sprts[opponent];
+}
+
+void GauntletTournament::onSprtFinished(const TournamentPair* pair)
+{
+	// The opponent's remaining games are skipped by nextPair()
+	if (m_sprts.isEmpty())
+		Tournament::onSprtFinished(pair);
+}
+
+QString GauntletTournament::results() const
+{
+	QString ret(Tournament::results());
+	for (int i = 1; i < m_sprts.size(); i++)
+	{
+		const QString sprtStr(sprtStatusString(m_sprts.at(i)));
+		if (!sprtStr.isEmpty())
+			ret += QString("\nSPRT vs %1: %2")
+			       .arg(playerAt(i).name(), sprtStr);
+	}
+
+	return ret;
+}
@@ -20,12 +20,20 @@
 #define GAUNTLETTOURNAMENT_H
 
 #include "tournament.h"
+#include "sprt.h"
 
 /*!
  * \brief Gauntlet type chess tournament.
  *
  * In a Gauntlet tournament the first participant plays
  * against all the others.
+ *
+ * If the tournament has an SPRT and more than two players, each
+ * opponent gets a test of its own with the same parameters. An
+ * opponent stops playing as soon as its test accepts H0 or H1, and
+ * the free game slots go to the opponents whose tests continue. The
+ * tournament ends when every test is decided or every opponent has
+ * played all of its games.
  */
 class LIB_EXPORT GauntletTournament : public Tournament
 {
@@ -37,6 +45,8 @@ class LIB_EXPORT GauntletTournament : public Tournament
 					    QObject *parent = nullptr);
 		// Inherited from Tournament
 		virtual QString type() const;
+		virtual bool canReorderGames() const;
+		virtual QString results() const;
 
 	protected:
 		// Inherited from Tournament
@@ -47,9 +57,17 @@ class LIB_EXPORT GauntletTournament : public Tournament
 		virtual int gamesPerCycle() const;
 		virtual TournamentPair* nextPair(int gameNumber);
 		virtual bool hasGauntletRatingsOrder() const;
+		virtual bool areAllGamesFinished() const;
+		virtual Sprt* pairSprt(const TournamentPair* pair);
+		virtual void onSprtFinished(const TournamentPair* pair);
 
 	private:
+		bool isOpponentFinished(int opponent) const;
+
 		int m_opponent;
+		// The tests and pairs of the opponents with their own SPRT
+		QVector<Sprt> m_sprts;
+		QVector<TournamentPair*> m_pairs;
 };
 
 #endif // GAUNTLETTOURNAMENT_H
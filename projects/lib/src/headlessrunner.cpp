@@ -0,0 +1,711 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "headlessrunner.h"
+#include <QIODevice>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QDate>
+#include "board/board.h"
+#include "board/boardfactory.h"
+#include "enginebuilder.h"
+#include "engineoption.h"
+#include "moveevaluation.h"
+#include "pgngame.h"
+
+namespace {
+
+// Idle passes over the games before the runner starts to sleep
+const int s_spinCount = 64;
+// The sleep between idle passes in microseconds
+const int s_idleSleep = 100;
+
+} // anonymous namespace
+
+/*!
+ * One game in progress and the pair of engines that plays it.
+ *
+ * The slot is a state machine that is advanced by poll(). Each engine
+ * waits for at most one reply at a time: "uciok" when it starts,
+ * "readyok" before a game and "bestmove" while it's thinking.
+ */
+class HeadlessRunner::Slot
+{
+	public:
+		explicit Slot(HeadlessRunner* runner);
+		~Slot();
+
+		// Handles the engines' output and timeouts, and returns
+		// true if any output was read
+		bool poll();
+		// Returns true if the slot has no more games to play
+		bool isFinished() const;
+
+	private:
+		enum State
+		{
+			Starting,	// Waiting for "uciok"
+			Preparing,	// Waiting for "readyok"
+			Playing,	// Waiting for moves
+			Stopping,	// Waiting for the moves of a finished game
+			Finished	// No more games or the engines failed
+		};
+
+		struct Engine
+		{
+			QIODevice* device;
+			QString name;
+			// The reply the engine is waiting for, or empty
+			QByteArray expected;
+			QElapsedTimer waitTimer;
+			TimeControl timeControl;
+			MoveEvaluation eval;
+		};
+
+		int engineIndex(Chess::Side side) const;
+		void write(Engine& engine, const QByteArray& line);
+		void expect(Engine& engine, const QByteArray& reply);
+		bool isWaiting() const;
+		bool readOutput(int index);
+		void processLine(int index, const QByteArray& line);
+		void parseInfo(Engine& engine, const QByteArray& line);
+		void configure(Engine& engine, const EngineConfiguration& config);
+		void checkTimeouts();
+		void startGame();
+		void startTurn();
+		void makeMove(int index, const QByteArray& moveString);
+		void finishGame(const Chess::Result& result);
+		void fail(int index, const QString& error);
+		void quitEngines();
+
+		HeadlessRunner* m_runner;
+		State m_state;
+		Engine m_engines[2];
+		// The index of the engine that plays White
+		int m_white;
+		Chess::Board* m_board;
+		PgnGame m_pgn;
+		GameAdjudicator m_adjudicator;
+		// The "position" command of the current position
+		QByteArray m_position;
+		int m_plies;
+};
+
+HeadlessRunner::Slot::Slot(HeadlessRunner* runner)
+	: m_runner(runner),
+	  m_state(Starting),
+	  m_white(0),
+	  m_board(Chess::BoardFactory::create(runner->m_variant)),
+	  m_plies(0)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		m_engines[i].device = nullptr;
+		m_engines[i].name = runner->m_config[i].name();
+	}
+	if (m_board == nullptr)
+	{
+		m_runner->m_errors.append(QString("Unknown variant: %1")
+					  .arg(runner->m_variant));
+		m_state = Finished;
+		return;
+	}
+	m_board->initialize();
+
+	for (int i = 0; i < 2; i++)
+	{
+		QString error;
+		EngineBuilder builder(runner->m_config[i]);
+		Engine& engine = m_engines[i];
+		engine.device = builder.startDevice(&error);
+		if (engine.device == nullptr)
+		{
+			fail(i, error);
+			return;
+		}
+
+		write(engine, "uci");
+		expect(engine, "uciok");
+	}
+}
+
+HeadlessRunner::Slot::~Slot()
+{
+	quitEngines();
+	delete m_board;
+}
+
+bool HeadlessRunner::Slot::isFinished() const
+{
+	return m_state == Finished;
+}
+
+int HeadlessRunner::Slot::engineIndex(Chess::Side side) const
+{
+	return side == Chess::Side::White ? m_white : 1 - m_white;
+}
+
+void HeadlessRunner::Slot::write(Engine& engine, const QByteArray& line)
+{
+	engine.device->write(line + '\n');
+	// Needed by devices that write in the event loop, eg. QProcess
+	engine.device->waitForBytesWritten(0);
+}
+
+void HeadlessRunner::Slot::expect(Engine& engine, const QByteArray& reply)
+{
+	engine.expected = reply;
+	engine.waitTimer.start();
+}
+
+bool HeadlessRunner::Slot::isWaiting() const
+{
+	return !m_engines[0].expected.isEmpty()
+	    || !m_engines[1].expected.isEmpty();
+}
+
+bool HeadlessRunner::Slot::poll()
+{
+	bool progress = false;
+	for (int i = 0; i < 2 && m_state != Finished; i++)
+		progress |= readOutput(i);
+
+	if (m_state != Finished)
+		checkTimeouts();
+	return progress;
+}
+
+bool HeadlessRunner::Slot::readOutput(int index)
+{
+	Engine& engine = m_engines[index];
+
+	// EngineProcess and EngineLibrary fill their buffers in other
+	// threads, but sockets and QProcess need to be waited for
+	if (!engine.device->canReadLine()
+	&&  !engine.device->waitForReadyRead(0))
+		return false;
+
+	bool progress = false;
+	while (engine.device != nullptr && engine.device->canReadLine())
+	{
+		QByteArray line(engine.device->readLine());
+		processLine(index, line.trimmed());
+		progress = true;
+	}
+
+	return progress;
+}
+
+void HeadlessRunner::Slot::processLine(int index, const QByteArray& line)
+{
+	Engine& engine = m_engines[index];
+	const int space = line.indexOf(' ');
+	const QByteArray command(space == -1 ? line : line.left(space));
+
+	if (command == "info")
+	{
+		if (engine.expected == "bestmove")
+			parseInfo(engine, line);
+		return;
+	}
+	if (command == "id" && m_state == Starting)
+	{
+		if (engine.name.isEmpty() && line.startsWith("id name "))
+			engine.name = QString::fromUtf8(line.mid(8));
+		return;
+	}
+	if (command != engine.expected)
+		return;
+
+	engine.expected.clear();
+	if (command == "uciok")
+	{
+		configure(engine, m_runner->m_config[index]);
+		if (!isWaiting())
+			startGame();
+	}
+	else if (command == "readyok")
+	{
+		if (!isWaiting())
+		{
+			m_state = Playing;
+			startTurn();
+		}
+	}
+	else if (m_state == Stopping)
+	{
+		if (!isWaiting())
+			startGame();
+	}
+	else
+		makeMove(index, line.mid(space + 1).split(' ').first());
+}
+
+void HeadlessRunner::Slot::parseInfo(Engine& engine, const QByteArray& line)
+{
+	const QList<QByteArray> tokens(line.split(' '));
+	for (int i = 1; i + 1 < tokens.size(); i++)
+	{
+		const QByteArray& token = tokens.at(i);
+		if (token == "string" || token == "pv")
+			break;
+		if (token == "depth")
+			engine.eval.setDepth(tokens.at(++i).toInt());
+		else if (token == "seldepth")
+			engine.eval.setSelectiveDepth(tokens.at(++i).toInt());
+		else if (token == "nodes")
+			engine.eval.setNodeCount(tokens.at(++i).toULongLong());
+		else if (token == "score" && i + 2 < tokens.size())
+		{
+			const QByteArray& type = tokens.at(++i);
+			int score = tokens.at(++i).toInt();
+			if (i + 1 < tokens.size()
+			&&  (tokens.at(i + 1) == "lowerbound"
+			 ||  tokens.at(i + 1) == "upperbound"))
+				continue;
+
+			if (type == "mate")
+			{
+				if (score > 0)
+					score = MoveEvaluation::MATE_SCORE + 1 - score * 2;
+				else if (score < 0)
+					score = -MoveEvaluation::MATE_SCORE - score * 2;
+			}
+			else if (type != "cp")
+				continue;
+			engine.eval.setScore(score);
+		}
+	}
+}
+
+void HeadlessRunner::Slot::configure(Engine& engine,
+				     const EngineConfiguration& config)
+{
+	const QString& variant = m_runner->m_variant;
+	if (variant == "fischerandom")
+		write(engine, "setoption name UCI_Chess960 value true");
+	else if (variant != "standard")
+		write(engine, "setoption name UCI_Variant value " + variant.toLatin1());
+
+	const auto options = config.options();
+	for (const EngineOption* option : options)
+	{
+		const QVariant value(option->value());
+		if (value.isNull())
+			write(engine, "setoption name " + option->name().toUtf8());
+		else
+			write(engine, "setoption name " + option->name().toUtf8()
+				      + " value " + value.toString().toUtf8());
+	}
+
+	const auto initStrings = config.initStrings();
+	for (const QString& str : initStrings)
+		write(engine, str.toUtf8());
+}
+
+void HeadlessRunner::Slot::checkTimeouts()
+{
+	for (int i = 0; i < 2; i++)
+	{
+		Engine& engine = m_engines[i];
+		if (engine.expected.isEmpty())
+			continue;
+
+		if (m_state == Playing)
+		{
+			const TimeControl& tc = engine.timeControl;
+			if (!tc.isInfinite()
+			&&  tc.activeTimeLeft() + tc.expiryMargin() < 0)
+			{
+				const Chess::Side side(m_board->sideToMove());
+				finishGame(Chess::Result(Chess::Result::Timeout,
+							 side.opposite()));
+				return;
+			}
+		}
+		if (engine.waitTimer.hasExpired(m_runner->m_timeout))
+		{
+			fail(i, QString("%1 didn't send \"%2\" in %3 ms")
+				.arg(engine.name,
+				     QString::fromLatin1(engine.expected))
+				.arg(m_runner->m_timeout));
+			return;
+		}
+	}
+}
+
+void HeadlessRunner::Slot::startGame()
+{
+	int number = 0;
+	QString fen;
+	if (!m_runner->takeGame(&number, &fen))
+	{
+		quitEngines();
+		m_state = Finished;
+		return;
+	}
+
+	if (fen.isEmpty() || !m_board->setFenString(fen))
+	{
+		if (!fen.isEmpty())
+			m_runner->m_errors.append(QString("Invalid FEN string: %1")
+						  .arg(fen));
+		fen = m_board->defaultFenString();
+		m_board->setFenString(fen);
+	}
+	if (!m_board->isRandomVariant() && fen == m_board->defaultFenString())
+	{
+		fen.clear();
+		m_position = "position startpos";
+	}
+	else
+		m_position = "position fen " + fen.toLatin1();
+
+	// The engines swap colors after every game
+	m_white = number % 2;
+	m_plies = 0;
+	m_adjudicator = m_runner->m_adjudicator;
+
+	m_pgn.clear();
+	m_pgn.setVariant(m_board->variant());
+	m_pgn.setStartingFenString(m_board->startingSide(), fen);
+	m_pgn.setDate(QDate::currentDate());
+	m_pgn.setRound(number + 1);
+	m_pgn.setTag(PgnGame::TimeControlTag, m_runner->m_timeControl.toString());
+	for (int i = 0; i < 2; i++)
+	{
+		const Chess::Side side = Chess::Side::Type(i);
+		m_pgn.setPlayerName(side, m_engines[engineIndex(side)].name);
+
+		Engine& engine = m_engines[i];
+		engine.timeControl = m_runner->m_timeControl;
+		engine.timeControl.initialize();
+		write(engine, "ucinewgame");
+		write(engine, "isready");
+		expect(engine, "readyok");
+	}
+	m_pgn.setResult(Chess::Result());
+
+	m_state = Preparing;
+}
+
+void HeadlessRunner::Slot::startTurn()
+{
+	const Chess::Side side(m_board->sideToMove());
+	Engine& engine = m_engines[engineIndex(side)];
+	const TimeControl& myTc = engine.timeControl;
+	const TimeControl& whiteTc = m_engines[m_white].timeControl;
+	const TimeControl& blackTc = m_engines[1 - m_white].timeControl;
+
+	QByteArray command("go");
+	if (myTc.isInfinite())
+	{
+		if (myTc.plyLimit() == 0 && myTc.nodeLimit() == 0)
+			command += " infinite";
+	}
+	else if (myTc.timePerMove() > 0)
+		command += " movetime " + QByteArray::number(myTc.timeLeft());
+	else
+	{
+		command += " wtime " + QByteArray::number(whiteTc.timeLeft());
+		command += " btime " + QByteArray::number(blackTc.timeLeft());
+		if (whiteTc.timeIncrement() > 0)
+			command += " winc " + QByteArray::number(whiteTc.timeIncrement());
+		if (blackTc.timeIncrement() > 0)
+			command += " binc " + QByteArray::number(blackTc.timeIncrement());
+		if (myTc.movesLeft() > 0)
+			command += " movestogo " + QByteArray::number(myTc.movesLeft());
+	}
+	if (myTc.plyLimit() > 0)
+		command += " depth " + QByteArray::number(myTc.plyLimit());
+	if (myTc.nodeLimit() > 0)
+		command += " nodes " + QByteArray::number(myTc.nodeLimit());
+
+	engine.eval.clear();
+	write(engine, m_position);
+	write(engine, command);
+	expect(engine, "bestmove");
+	engine.timeControl.startTimer();
+}
+
+void HeadlessRunner::Slot::makeMove(int index, const QByteArray& moveString)
+{
+	Engine& engine = m_engines[index];
+	const Chess::Side side(m_board->sideToMove());
+	engine.timeControl.update();
+
+	const Chess::Move move(m_board->moveFromString(QString::fromLatin1(moveString)));
+	if (move.isNull())
+	{
+		finishGame(Chess::Result(Chess::Result::IllegalMove,
+					 side.opposite(),
+					 QString::fromLatin1(moveString)));
+		return;
+	}
+	if (engine.timeControl.expired())
+	{
+		finishGame(Chess::Result(Chess::Result::Timeout,
+					 side.opposite()));
+		return;
+	}
+
+	// ECO codes aren't looked up for the games
+	engine.eval.setTime(engine.timeControl.lastMoveTime());
+	PgnGame::MoveData md;
+	md.key = m_board->key();
+	md.move = m_board->genericMove(move);
+	md.moveString = m_board->moveString(move, Chess::Board::StandardAlgebraic);
+	md.evaluation = engine.eval;
+	m_pgn.addMove(md, false);
+
+	if (m_plies++ == 0)
+		m_position += " moves";
+	m_position += ' ';
+	m_position += m_board->moveString(move, Chess::Board::LongAlgebraic).toLatin1();
+	m_board->makeMove(move);
+
+	Chess::Result result(m_board->result());
+	if (result.isNone())
+	{
+		if (m_board->reversibleMoveCount() == 0)
+			m_adjudicator.resetDrawMoveCount();
+
+		m_adjudicator.addEval(m_board, engine.eval);
+		result = m_adjudicator.result();
+	}
+
+	if (result.isNone())
+		startTurn();
+	else
+		finishGame(result);
+}
+
+void HeadlessRunner::Slot::finishGame(const Chess::Result& result)
+{
+	m_pgn.setResult(result);
+	m_pgn.setResultDescription(result.description());
+	m_runner->finishGame(m_pgn, m_plies);
+
+	// An engine that lost on time is still thinking
+	for (Engine& engine : m_engines)
+	{
+		if (engine.expected == "bestmove")
+		{
+			write(engine, "stop");
+			expect(engine, "bestmove");
+		}
+	}
+	if (isWaiting())
+		m_state = Stopping;
+	else
+		startGame();
+}
+
+void HeadlessRunner::Slot::fail(int index, const QString& error)
+{
+	m_runner->m_errors.append(error);
+	if (m_state == Playing)
+	{
+		const int white = engineIndex(Chess::Side::White);
+		const Chess::Side winner(index == white ? Chess::Side::Black
+							: Chess::Side::White);
+		Chess::Result result(Chess::Result::StalledConnection, winner);
+		m_pgn.setResult(result);
+		m_pgn.setResultDescription(result.description());
+		m_runner->finishGame(m_pgn, m_plies);
+	}
+
+	quitEngines();
+	m_state = Finished;
+}
+
+void HeadlessRunner::Slot::quitEngines()
+{
+	for (Engine& engine : m_engines)
+	{
+		if (engine.device == nullptr)
+			continue;
+
+		write(engine, "quit");
+		engine.device->close();
+		delete engine.device;
+		engine.device = nullptr;
+		engine.expected.clear();
+	}
+}
+
+
+HeadlessRunner::HeadlessRunner(const EngineConfiguration& first,
+			       const EngineConfiguration& second)
+	: m_variant("standard"),
+	  m_timeControl("inf"),
+	  m_gameCount(2),
+	  m_concurrency(1),
+	  m_timeout(60000),
+	  m_nextGame(0),
+	  m_finishedGames(0),
+	  m_plies(0)
+{
+	m_config[0] = first;
+	m_config[1] = second;
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+	qDeleteAll(m_slots);
+}
+
+void HeadlessRunner::setVariant(const QString& variant)
+{
+	m_variant = variant;
+}
+
+void HeadlessRunner::setTimeControl(const TimeControl& timeControl)
+{
+	m_timeControl = timeControl;
+}
+
+void HeadlessRunner::setAdjudicator(const GameAdjudicator& adjudicator)
+{
+	m_adjudicator = adjudicator;
+}
+
+void HeadlessRunner::setOpenings(const QStringList& fens)
+{
+	m_openings = fens;
+}
+
+void HeadlessRunner::setGameCount(int count)
+{
+	m_gameCount = qMax(0, count);
+}
+
+void HeadlessRunner::setConcurrency(int count)
+{
+	m_concurrency = qMax(1, count);
+}
+
+int HeadlessRunner::concurrency() const
+{
+	return m_concurrency;
+}
+
+void HeadlessRunner::setTimeout(int msecs)
+{
+	m_timeout = qMax(1, msecs);
+}
+
+int HeadlessRunner::timeout() const
+{
+	return m_timeout;
+}
+
+void HeadlessRunner::setGameFinishedCallback(
+	const std::function<void(const PgnGame&)>& callback)
+{
+	m_callback = callback;
+}
+
+void HeadlessRunner::setCancellationToken(const CancellationToken& token)
+{
+	m_cancel = token;
+}
+
+bool HeadlessRunner::takeGame(int* number, QString* fen)
+{
+	if (m_nextGame >= m_gameCount || m_cancel.isCancelled())
+		return false;
+
+	*number = m_nextGame++;
+	if (!m_openings.isEmpty())
+		*fen = m_openings.at((*number / 2) % m_openings.size());
+	return true;
+}
+
+void HeadlessRunner::finishGame(const PgnGame& pgn, int plies)
+{
+	m_finishedGames++;
+	m_plies += plies;
+	if (m_callback)
+		m_callback(pgn);
+}
+
+int HeadlessRunner::run()
+{
+	for (int i = 0; i < 2; i++)
+	{
+		if (m_config[i].protocol() != "uci")
+		{
+			m_errors.append(QString("%1 doesn't use the UCI protocol")
+					.arg(m_config[i].name()));
+			return 0;
+		}
+	}
+
+	const int startCount = m_finishedGames;
+	qDeleteAll(m_slots);
+	m_slots.clear();
+	const int slotCount = qMin(m_concurrency, m_gameCount - m_nextGame);
+	for (int i = 0; i < slotCount; i++)
+		m_slots.append(new Slot(this));
+
+	int idlePasses = 0;
+	for (;;)
+	{
+		bool progress = false;
+		bool finished = true;
+		for (Slot* slot : qAsConst(m_slots))
+		{
+			if (slot->isFinished())
+				continue;
+			progress |= slot->poll();
+			finished &= slot->isFinished();
+		}
+		if (finished || m_cancel.isCancelled())
+			break;
+
+		// Spin briefly after a move to catch fast replies, then
+		// sleep to leave the CPU to the engines
+		if (progress)
+			idlePasses = 0;
+		else if (++idlePasses < s_spinCount)
+			QThread::yieldCurrentThread();
+		else
+			QThread::usleep(s_idleSleep);
+	}
+
+	qDeleteAll(m_slots);
+	m_slots.clear();
+
+	return m_finishedGames - startCount;
+}
+
+int HeadlessRunner::finishedGameCount() const
+{
+	return m_finishedGames;
+}
+
+qint64 HeadlessRunner::plyCount() const
+{
+	return m_plies;
+}
+
+QStringList HeadlessRunner::errors() const
+{
+	return m_errors;
+}
@@ -0,0 +1,154 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADLESSRUNNER_H
+#define HEADLESSRUNNER_H
+
+#include <functional>
+#include <QVector>
+#include <QStringList>
+#include "engineconfiguration.h"
+#include "timecontrol.h"
+#include "gameadjudicator.h"
+#include "cancellationtoken.h"
+class PgnGame;
+
+/*!
+ * \brief Plays games between two UCI engines without an event loop
+ *
+ * HeadlessRunner is a minimal alternative to ChessGame and GameManager
+ * for self-play and other bulk games where nobody watches the games.
+ * There are no ChessPlayer objects, signals or game threads: the
+ * runner speaks the UCI protocol to the engines' IO devices directly
+ * and polls them for output in a tight loop in the calling thread.
+ *
+ * The runner keeps concurrency() games in progress at a time, each
+ * with its own pair of engines, and starts the next game on the same
+ * engines with "ucinewgame". The engines swap colors after every game,
+ * so each opening is played once with each color.
+ *
+ * The games use the same Board, TimeControl, GameAdjudicator and
+ * PgnGame classes as ChessGame, but leave out opening books, pondering,
+ * engine restarts and the Xboard protocol. An engine that crashes or
+ * doesn't reply within timeout() loses the game on a stalled
+ * connection, and its engines aren't used for more games.
+ *
+ * run() blocks until the games are finished. The runner doesn't need
+ * a QCoreApplication event loop, so several runners can be run in
+ * parallel in threads of their own, eg. one per CPU core.
+ */
+class LIB_EXPORT HeadlessRunner
+{
+	public:
+		/*!
+		 * Creates a new runner for games between the engines
+		 * \a first and \a second, which must use the UCI protocol.
+		 */
+		HeadlessRunner(const EngineConfiguration& first,
+			       const EngineConfiguration& second);
+		/*! Destroys the runner and quits its engines. */
+		~HeadlessRunner();
+
+		/*! Sets the chess variant. The default is "standard". */
+		void setVariant(const QString& variant);
+		/*! Sets the time control of both engines. */
+		void setTimeControl(const TimeControl& timeControl);
+		/*! Sets the adjudicator of each game. */
+		void setAdjudicator(const GameAdjudicator& adjudicator);
+		/*!
+		 * Sets the starting positions of the games to \a fens.
+		 * Each position is played twice, the second time with
+		 * colors reversed. The positions are used again from the
+		 * start when they run out. By default the games start from
+		 * the variant's starting position.
+		 */
+		void setOpenings(const QStringList& fens);
+		/*!
+		 * Sets the number of games to play to \a count.
+		 * The default is 2.
+		 */
+		void setGameCount(int count);
+		/*!
+		 * Sets the number of games in progress at a time to
+		 * \a count. The default is 1.
+		 */
+		void setConcurrency(int count);
+		/*! Returns the number of games in progress at a time. */
+		int concurrency() const;
+		/*!
+		 * Sets the time in milliseconds an engine has to reply to
+		 * a command to \a msecs. The time control is also enforced
+		 * when it's stricter. The default is 60 seconds.
+		 */
+		void setTimeout(int msecs);
+		/*! Returns the engines' reply timeout in milliseconds. */
+		int timeout() const;
+		/*!
+		 * Sets the function that is called with each finished game
+		 * to \a callback. It's called in the thread that runs the
+		 * games, which waits for it to return.
+		 */
+		void setGameFinishedCallback(
+			const std::function<void(const PgnGame&)>& callback);
+		/*!
+		 * Sets the token that stops the games early to \a token.
+		 * The games in progress are abandoned without a result.
+		 */
+		void setCancellationToken(const CancellationToken& token);
+
+		/*!
+		 * Starts the engines and plays the games, and returns the
+		 * number of games that were finished.
+		 */
+		int run();
+
+		/*! Returns the number of games finished by run(). */
+		int finishedGameCount() const;
+		/*! Returns the number of moves played by run(). */
+		qint64 plyCount() const;
+		/*! Returns the errors of the engines, or an empty list. */
+		QStringList errors() const;
+
+	private:
+		Q_DISABLE_COPY(HeadlessRunner)
+
+		class Slot;
+		friend class Slot;
+
+		bool takeGame(int* number, QString* fen);
+		void finishGame(const PgnGame& pgn, int plies);
+
+		EngineConfiguration m_config[2];
+		QString m_variant;
+		TimeControl m_timeControl;
+		GameAdjudicator m_adjudicator;
+		QStringList m_openings;
+		int m_gameCount;
+		int m_concurrency;
+		int m_timeout;
+		std::function<void(const PgnGame&)> m_callback;
+		CancellationToken m_cancel;
+
+		int m_nextGame;
+		int m_finishedGames;
+		qint64 m_plies;
+		QStringList m_errors;
+		QVector<Slot*> m_slots;
+};
+
+#endif // HEADLESSRUNNER_H
@@ -114,6 +114,13 @@ void KnockoutTournament::initializePairing()
 
 	m_rounds.clear();
 	m_rounds << pairs;
+	for (int size = pairs.size() / 2; size >= 1; size /= 2)
+	{
+		QList<TournamentPair*> round;
+		for (int i = 0; i < size; i++)
+			round << nullptr;
+		m_rounds << round;
+	}
 }
 
 int KnockoutTournament::gamesPerCycle() const
@@ -132,41 +139,61 @@ int KnockoutTournament::gamesPerCycle() const
 
 void KnockoutTournament::addScore(int player, int score)
 {
-	for (TournamentPair* pair : m_rounds.last())
+	// A player only advances after all games of the previous
+	// encounter are over, so the game belongs to the player's
+	// latest pair
+	bool found = false;
+	for (int round = m_rounds.size() - 1; round >= 0 && !found; round--)
 	{
-		if (pair->firstPlayer() == player)
-		{
-			pair->addFirstScore(score);
-			break;
-		}
-		if (pair->secondPlayer() == player)
+		for (TournamentPair* pair : qAsConst(m_rounds.at(round)))
 		{
-			pair->addSecondScore(score);
-			break;
+			if (pair == nullptr)
+				continue;
+			if (pair->firstPlayer() == player)
+			{
+				pair->addFirstScore(score);
+				found = true;
+				break;
+			}
+			if (pair->secondPlayer() == player)
+			{
+				pair->addSecondScore(score);
+				found = true;
+				break;
+			}
 		}
 	}
 
 	Tournament::addScore(player, score);
 }
 
-QList<int> KnockoutTournament::lastRoundWinners() const
+bool KnockoutTournament::isDecided(const TournamentPair* pair) const
 {
-	QList<int> winners;
-	const auto last = m_rounds.last();
-	for (const TournamentPair* pair : last)
-		winners << pair->leader();
+	return pair != nullptr
+	    && !pair->gamesInProgress()
+	    && !needMoreGames(pair);
+}
 
-	return winners;
+void KnockoutTournament::advanceWinners()
+{
+	for (int round = 1; round < m_rounds.size(); round++)
+	{
+		const QList<TournamentPair*>& feeders(m_rounds.at(round - 1));
+		QList<TournamentPair*>& pairs(m_rounds[round]);
+		for (int i = 0; i < pairs.size(); i++)
+		{
+			const TournamentPair* first(feeders.at(2 * i));
+			const TournamentPair* second(feeders.at(2 * i + 1));
+			if (pairs.at(i) == nullptr
+			&&  isDecided(first) && isDecided(second))
+				pairs[i] = pair(first->leader(), second->leader());
+		}
+	}
 }
 
 bool KnockoutTournament::areAllGamesFinished() const
 {
-	const QList<TournamentPair*>& lastRound(m_rounds.last());
-	if (lastRound.size() > 1)
-		return false;
-
-	const TournamentPair* pair(lastRound.first());
-	return !pair->gamesInProgress() && !needMoreGames(pair);
+	return isDecided(m_rounds.last().first());
 }
 
 bool KnockoutTournament::needMoreGames(const TournamentPair* pair) const
@@ -205,32 +232,21 @@ TournamentPair* KnockoutTournament::nextPair(int gameNumber)
 {
 	Q_UNUSED(gameNumber);
 
-	const auto last = m_rounds.last();
-	for (TournamentPair* pair : last)
-	{
-		if (needMoreGames(pair))
-			return pair;
-	}
-
-	QList<int> winners(lastRoundWinners());
-	if (winners.size() <= 1 || gamesInProgress())
-		return nullptr;
-
-	QList<TournamentPair*> nextRound;
-	for (int i = 0; i < winners.size(); i += 2)
-	{
-		nextRound << pair(winners.at(i), winners.at(i + 1));
-	}
-	m_rounds << nextRound;
-	setCurrentRound(currentRound() + 1);
-
-	for (TournamentPair* pair : qAsConst(nextRound))
+	advanceWinners();
+	for (int round = 0; round < m_rounds.size(); round++)
 	{
-		if (pair->isValid())
-			return pair;
+		const auto pairs = m_rounds.at(round);
+		for (TournamentPair* pair : pairs)
+		{
+			if (pair != nullptr && needMoreGames(pair))
+			{
+				// The round of the game for its PGN tags
+				setCurrentRound(round + 1);
+				return pair;
+			}
+		}
 	}
 
-	Q_UNREACHABLE();
 	return nullptr;
 }
 
@@ -255,12 +271,18 @@ QString KnockoutTournament::results() const
 	}
 	lines.removeLast();
 
-	for (int round = 0; round < currentRound(); round++)
+	for (int round = 0; round < m_rounds.size(); round++)
 	{
 		int x = 0;
 		const auto nthRound = m_rounds.at(round);
 		for (const TournamentPair* pair : nthRound)
 		{
+			if (pair == nullptr)
+			{
+				x++;
+				continue;
+			}
+
 			QString winner;
 			if (needMoreGames(pair) || pair->gamesInProgress())
 				winner = "...";
@@ -27,6 +27,12 @@
  *
  * A single-elimination tournament where the number of rounds is
  * determined by the number of players.
+ *
+ * The rounds don't wait for each other: a pair of the next round is
+ * formed as soon as both of the encounters leading to it are decided,
+ * so a long encounter only holds up its own branch of the bracket.
+ * The games of earlier rounds are started first, and the pairs of
+ * each round in bracket order.
  */
 class LIB_EXPORT KnockoutTournament : public Tournament
 {
@@ -54,9 +60,14 @@ class LIB_EXPORT KnockoutTournament : public Tournament
 		static int playerSeed(int rank, int bracketSize);
 
 		QList<int> firstRoundPlayers() const;
-		QList<int> lastRoundWinners() const;
 		bool needMoreGames(const TournamentPair* pair) const;
+		// Returns true if \a pair exists and has a winner
+		bool isDecided(const TournamentPair* pair) const;
+		// Forms the pairs whose both feeder encounters are decided
+		void advanceWinners();
 
+		// The pairs of each round in bracket order. Pairs that
+		// are not formed yet are null.
 		QList< QList<TournamentPair*> > m_rounds;
 };
 
@@ -0,0 +1,139 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "latencyhistogram.h"
+#include <cmath>
+
+namespace {
+
+// Number of buckets per power of two is 2^SubBucketBits
+const int SubBucketBits = 4;
+const int SubBuckets = 1 << SubBucketBits;
+
+int msb(quint64 value)
+{
+	int n = 0;
+	while (value >>= 1)
+		n++;
+	return n;
+}
+
+} // anonymous namespace
+
+LatencyHistogram::LatencyHistogram()
+	: m_count(0),
+	  m_max(0),
+	  m_sum(0)
+{
+}
+
+bool LatencyHistogram::isEmpty() const
+{
+	return m_count == 0;
+}
+
+qint64 LatencyHistogram::count() const
+{
+	return m_count;
+}
+
+qint64 LatencyHistogram::max() const
+{
+	return m_max;
+}
+
+qint64 LatencyHistogram::sum() const
+{
+	return m_sum;
+}
+
+int LatencyHistogram::bucket(qint64 value)
+{
+	if (value < SubBuckets)
+		return int(value);
+
+	// Values below 2^SubBucketBits have a bucket of their own, the
+	// rest are split by the position of the most significant bit and
+	// the next SubBucketBits bits.
+	int shift = msb(quint64(value)) - SubBucketBits;
+	int sub = int(value >> shift) & (SubBuckets - 1);
+	return (shift + 1) * SubBuckets + sub;
+}
+
+qint64 LatencyHistogram::bucketLimit(int bucket)
+{
+	if (bucket < SubBuckets)
+		return bucket;
+
+	int shift = bucket / SubBuckets - 1;
+	qint64 sub = bucket % SubBuckets;
+	return ((SubBuckets + sub + 1) << shift) - 1;
+}
+
+qint64 LatencyHistogram::percentile(double percent) const
+{
+	if (m_count == 0)
+		return 0;
+
+	qint64 rank = qint64(std::ceil(percent / 100.0 * m_count));
+	rank = qBound(qint64(1), rank, m_count);
+
+	qint64 seen = 0;
+	for (int i = 0; i < m_buckets.size(); i++)
+	{
+		seen += m_buckets.at(i);
+		if (seen >= rank)
+			return qMin(bucketLimit(i), m_max);
+	}
+
+	return m_max;
+}
+
+void LatencyHistogram::add(qint64 nsecs)
+{
+	nsecs = qMax(nsecs, qint64(0));
+
+	int i = bucket(nsecs);
+	if (i >= m_buckets.size())
+		m_buckets.resize(i + 1);
+	m_buckets[i]++;
+
+	m_count++;
+	m_max = qMax(m_max, nsecs);
+	m_sum += nsecs;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+	if (other.m_buckets.size() > m_buckets.size())
+		m_buckets.resize(other.m_buckets.size());
+	for (int i = 0; i < other.m_buckets.size(); i++)
+		m_buckets[i] += other.m_buckets.at(i);
+
+	m_count += other.m_count;
+	m_max = qMax(m_max, other.m_max);
+	m_sum += other.m_sum;
+}
+
+void LatencyHistogram::clear()
+{
+	m_buckets.clear();
+	m_count = 0;
+	m_max = 0;
+	m_sum = 0;
+}
@@ -0,0 +1,74 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QVector>
+
+/*!
+ * \brief A histogram of time intervals in nanoseconds
+ *
+ * LatencyHistogram stores the number of samples in log-linear buckets:
+ * every power of two is divided into 16 equally wide buckets, so the
+ * percentiles are accurate to about 6% regardless of the magnitude of
+ * the samples. The memory usage doesn't depend on the number of samples,
+ * which makes it possible to collect statistics for a whole tournament.
+ */
+class LIB_EXPORT LatencyHistogram
+{
+	public:
+		/*! Creates a new empty histogram. */
+		LatencyHistogram();
+
+		/*! Returns true if the histogram has no samples. */
+		bool isEmpty() const;
+		/*! Returns the number of samples. */
+		qint64 count() const;
+		/*! Returns the largest sample. */
+		qint64 max() const;
+		/*! Returns the sum of the samples. */
+		qint64 sum() const;
+		/*!
+		 * Returns the smallest value that is larger than or equal
+		 * to \a percent percent of the samples.
+		 *
+		 * The value is the upper limit of the bucket that contains
+		 * the percentile, or the largest sample if it's smaller.
+		 * Returns 0 if the histogram is empty.
+		 */
+		qint64 percentile(double percent) const;
+
+		/*! Adds a sample of \a nsecs nanoseconds. */
+		void add(qint64 nsecs);
+		/*! Adds all the samples of \a other to this histogram. */
+		void merge(const LatencyHistogram& other);
+		/*! Removes all samples. */
+		void clear();
+
+	private:
+		static int bucket(qint64 value);
+		static qint64 bucketLimit(int bucket);
+
+		QVector<qint64> m_buckets;
+		qint64 m_count;
+		qint64 m_max;
+		qint64 m_sum;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,130 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "livegameclient.h"
+#include <QTcpSocket>
+#include "livegamefeed.h"
+#include "moveevaluation.h"
+
+LiveGameClient::LiveGameClient(QObject* parent)
+	: QObject(parent),
+	  m_socket(new QTcpSocket(this)),
+	  m_greeted(false)
+{
+	connect(m_socket, SIGNAL(readyRead()),
+		this, SLOT(onReadyRead()));
+	connect(m_socket, SIGNAL(error(QAbstractSocket::SocketError)),
+		this, SLOT(onError()));
+	connect(m_socket, SIGNAL(disconnected()),
+		this, SIGNAL(disconnected()));
+}
+
+void LiveGameClient::connectToFeed(const QString& host, quint16 port)
+{
+	m_greeted = false;
+	m_socket->abort();
+	m_socket->connectToHost(host, port);
+}
+
+void LiveGameClient::disconnectFromFeed()
+{
+	m_socket->disconnectFromHost();
+}
+
+void LiveGameClient::onError()
+{
+	emit error(m_socket->errorString());
+}
+
+void LiveGameClient::onReadyRead()
+{
+	while (m_socket->canReadLine())
+	{
+		QByteArray line(m_socket->readLine());
+		line.chop(1);
+
+		if (!m_greeted)
+		{
+			if (line != LiveGameFeed::greeting())
+			{
+				emit error(tr("Not a live game feed"));
+				m_socket->abort();
+				return;
+			}
+			m_greeted = true;
+		}
+		else if (!parseLine(line))
+			qWarning("Invalid line from live game feed: %s",
+				 line.constData());
+	}
+}
+
+bool LiveGameClient::parseLine(const QByteArray& line)
+{
+	const QList<QByteArray> fields(line.split('\t'));
+	const QByteArray& type(fields.first());
+	bool ok = fields.size() > 1;
+	const int id = ok ? fields.at(1).toInt(&ok) : 0;
+	if (!ok)
+		return false;
+
+	if (type == "game" && fields.size() == 8)
+	{
+		bool whiteOk = false;
+		bool blackOk = false;
+		const int whiteTime = fields.at(6).toInt(&whiteOk);
+		const int blackTime = fields.at(7).toInt(&blackOk);
+		if (!whiteOk || !blackOk)
+			return false;
+
+		emit gameStarted(id,
+				 QString::fromUtf8(fields.at(2)),
+				 QString::fromUtf8(fields.at(3)),
+				 QString::fromUtf8(fields.at(4)),
+				 QString::fromUtf8(fields.at(5)),
+				 whiteTime, blackTime);
+		return true;
+	}
+	if (type == "move" && fields.size() == 7)
+	{
+		bool plyOk = false;
+		bool depthOk = false;
+		bool timeOk = false;
+		const int ply = fields.at(2).toInt(&plyOk);
+		const int depth = fields.at(5).toInt(&depthOk);
+		const int timeLeft = fields.at(6).toInt(&timeOk);
+		int score = MoveEvaluation::NULL_SCORE;
+		if (fields.at(4) != "-")
+			score = fields.at(4).toInt(&ok);
+		if (!ok || !plyOk || !depthOk || !timeOk)
+			return false;
+
+		emit moveMade(id, ply, QString::fromUtf8(fields.at(3)),
+			      score, depth, timeLeft);
+		return true;
+	}
+	if (type == "end" && fields.size() == 4)
+	{
+		emit gameFinished(id,
+				  QString::fromUtf8(fields.at(2)),
+				  QString::fromUtf8(fields.at(3)));
+		return true;
+	}
+
+	return false;
+}
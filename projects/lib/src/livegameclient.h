@@ -0,0 +1,98 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIVEGAMECLIENT_H
+#define LIVEGAMECLIENT_H
+
+#include <QObject>
+#include <QByteArray>
+class QTcpSocket;
+
+/*!
+ * \brief Receives live games from a LiveGameFeed
+ *
+ * The client connects to the feed of a remote tournament and emits a
+ * signal for each event of the protocol, so the games can be shown
+ * without running them.
+ *
+ * \sa LiveGameFeed
+ */
+class LIB_EXPORT LiveGameClient : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new client. */
+		explicit LiveGameClient(QObject* parent = nullptr);
+
+		/*!
+		 * Connects to the feed at \a host and \a port.
+		 *
+		 * The connection is made in the background; error() is
+		 * emitted if it fails.
+		 */
+		void connectToFeed(const QString& host, quint16 port);
+		/*! Closes the connection. */
+		void disconnectFromFeed();
+
+	signals:
+		/*!
+		 * This signal is emitted when game \a id starts with
+		 * \a variant and the starting position \a fen.
+		 *
+		 * \a whiteTime and \a blackTime are the players' time left
+		 * in milliseconds, or -1 for infinite time.
+		 */
+		void gameStarted(int id,
+				 const QString& variant,
+				 const QString& fen,
+				 const QString& white,
+				 const QString& black,
+				 int whiteTime,
+				 int blackTime);
+		/*!
+		 * This signal is emitted when move \a san is made at
+		 * \a ply in game \a id.
+		 *
+		 * \a score is the engine's score in centipawns, or
+		 * MoveEvaluation::NULL_SCORE. \a timeLeft is the mover's
+		 * time left after the move, or -1 for infinite time.
+		 */
+		void moveMade(int id, int ply, const QString& san,
+			      int score, int depth, int timeLeft);
+		/*! This signal is emitted when game \a id ends. */
+		void gameFinished(int id,
+				  const QString& result,
+				  const QString& description);
+		/*! This signal is emitted when the connection fails. */
+		void error(const QString& message);
+		/*! This signal is emitted when the feed closes the connection. */
+		void disconnected();
+
+	private slots:
+		void onReadyRead();
+		void onError();
+
+	private:
+		bool parseLine(const QByteArray& line);
+
+		QTcpSocket* m_socket;
+		bool m_greeted;
+};
+
+#endif // LIVEGAMECLIENT_H
@@ -0,0 +1,180 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "livegamefeed.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "chessgame.h"
+#include "chessplayer.h"
+#include "timecontrol.h"
+#include "board/board.h"
+
+namespace {
+
+QByteArray field(const QString& str)
+{
+	QString tmp(str);
+	tmp.replace('\t', ' ');
+	tmp.replace('\n', ' ');
+	return tmp.toUtf8();
+}
+
+int timeLeft(const ChessPlayer* player)
+{
+	const TimeControl* tc = player->timeControl();
+	return tc->isInfinite() ? -1 : tc->timeLeft();
+}
+
+} // anonymous namespace
+
+QByteArray LiveGameFeed::greeting()
+{
+	return "cutechess-live 1";
+}
+
+LiveGameFeed::LiveGameFeed(QObject* parent)
+	: QObject(parent),
+	  m_server(new QTcpServer(this)),
+	  m_nextId(0)
+{
+	connect(m_server, SIGNAL(newConnection()),
+		this, SLOT(onNewConnection()));
+}
+
+bool LiveGameFeed::listen(const QHostAddress& address, quint16 port)
+{
+	if (!m_server->listen(address, port))
+	{
+		m_error = m_server->errorString();
+		return false;
+	}
+	return true;
+}
+
+quint16 LiveGameFeed::serverPort() const
+{
+	return m_server->serverPort();
+}
+
+QString LiveGameFeed::errorString() const
+{
+	return m_error;
+}
+
+void LiveGameFeed::addGame(ChessGame* game)
+{
+	Q_ASSERT(game != nullptr);
+	Q_ASSERT(game->thread() == thread());
+
+	const int id = ++m_nextId;
+	const QByteArray prefix(QByteArray::number(id) + '\t');
+
+	// The lines are formatted in the game's thread, where the
+	// players and the board can be accessed
+	auto post = [=](const QByteArray& line, bool finished)
+	{
+		QMetaObject::invokeMethod(this, "publish", Qt::QueuedConnection,
+					  Q_ARG(int, id),
+					  Q_ARG(QByteArray, line),
+					  Q_ARG(bool, finished));
+	};
+
+	connect(game, &ChessGame::started, game, [=]()
+	{
+		const ChessPlayer* white = game->player(Chess::Side::White);
+		const ChessPlayer* black = game->player(Chess::Side::Black);
+		QByteArray line("game\t" + prefix);
+		line += field(game->board()->variant()) + '\t';
+		line += field(game->board()->startingFenString()) + '\t';
+		line += field(white->name()) + '\t';
+		line += field(black->name()) + '\t';
+		line += QByteArray::number(timeLeft(white)) + '\t';
+		line += QByteArray::number(timeLeft(black)) + '\n';
+		post(line, false);
+	}, Qt::DirectConnection);
+
+	connect(game, &ChessGame::moveMade, game, [=](const MoveEvent& event)
+	{
+		const MoveEvaluation eval(event.evaluation());
+		const int score = eval.score();
+		QByteArray line("move\t" + prefix);
+		line += QByteArray::number(event.ply()) + '\t';
+		line += field(event.san()) + '\t';
+		line += (score == MoveEvaluation::NULL_SCORE
+			 ? QByteArray("-") : QByteArray::number(score)) + '\t';
+		line += QByteArray::number(eval.depth()) + '\t';
+		line += QByteArray::number(timeLeft(game->playerToWait())) + '\n';
+		post(line, false);
+	}, Qt::DirectConnection);
+
+	connect(game, &ChessGame::finished, game, [=]()
+	{
+		const Chess::Result result(game->result());
+		QByteArray line("end\t" + prefix);
+		line += field(result.toShortString()) + '\t';
+		line += field(result.description()) + '\n';
+		post(line, true);
+	}, Qt::DirectConnection);
+}
+
+void LiveGameFeed::publish(int id, const QByteArray& line, bool finished)
+{
+	if (finished)
+		m_games.remove(id);
+	else
+		m_games[id] += line;
+
+	// Aborting a client removes it from the list
+	const auto clients = m_clients;
+	for (QTcpSocket* client : clients)
+	{
+		if (client->bytesToWrite() > MaxBacklog)
+		{
+			qWarning("Disconnecting live game client %s: too slow",
+				 qUtf8Printable(client->peerAddress().toString()));
+			client->abort();
+			continue;
+		}
+		client->write(line);
+	}
+}
+
+void LiveGameFeed::onNewConnection()
+{
+	while (m_server->hasPendingConnections())
+	{
+		QTcpSocket* client = m_server->nextPendingConnection();
+		client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		connect(client, SIGNAL(disconnected()),
+			this, SLOT(onClientDisconnected()));
+		m_clients.append(client);
+
+		client->write(greeting() + '\n');
+		for (const QByteArray& lines : qAsConst(m_games))
+			client->write(lines);
+	}
+}
+
+void LiveGameFeed::onClientDisconnected()
+{
+	QTcpSocket* client = qobject_cast<QTcpSocket*>(sender());
+	Q_ASSERT(client != nullptr);
+
+	m_clients.removeOne(client);
+	client->deleteLater();
+}
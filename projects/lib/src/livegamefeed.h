@@ -0,0 +1,99 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIVEGAMEFEED_H
+#define LIVEGAMEFEED_H
+
+#include <QObject>
+#include <QMap>
+#include <QByteArray>
+#include <QHostAddress>
+class QTcpServer;
+class QTcpSocket;
+class ChessGame;
+
+/*!
+ * \brief Publishes the moves of live games to TCP clients
+ *
+ * LiveGameFeed lets a GUI on another machine watch the games without
+ * running them. The protocol is line-based, with tab-separated fields:
+ * - The feed sends greeting() when a client connects.
+ * - "game <id> <variant> <fen> <white> <black> <white time> <black time>"
+ *   starts game \a id. The times are the players' time left in
+ *   milliseconds, or -1 for infinite time.
+ * - "move <id> <ply> <san> <score> <depth> <time left>" is a move of
+ *   game \a id in Standard Algebraic Notation, with the engine's score
+ *   in centipawns or "-" and the mover's time left after the move.
+ * - "end <id> <result> <description>" ends game \a id.
+ *
+ * A client that connects during a game gets the lines of the game so
+ * far. The events are formatted in the threads of the games, and a
+ * client that falls more than MaxBacklog bytes behind is disconnected.
+ *
+ * \sa LiveGameClient
+ */
+class LIB_EXPORT LiveGameFeed : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Maximum number of unsent bytes per client. */
+		static const int MaxBacklog = 4 * 1024 * 1024;
+
+		/*! Returns the first line sent to the clients. */
+		static QByteArray greeting();
+
+		/*! Creates a new feed. */
+		explicit LiveGameFeed(QObject* parent = nullptr);
+
+		/*!
+		 * Starts listening on \a address and \a port.
+		 *
+		 * If \a port is 0 a port is chosen automatically; see
+		 * serverPort(). Returns true if successful; otherwise
+		 * returns false and sets errorString().
+		 */
+		bool listen(const QHostAddress& address, quint16 port);
+		/*! Returns the port the feed listens on. */
+		quint16 serverPort() const;
+		/*! Returns the last error. */
+		QString errorString() const;
+
+		/*!
+		 * Publishes the moves of \a game.
+		 *
+		 * This function must be called before the game is started,
+		 * in the thread of the feed and the game.
+		 */
+		void addGame(ChessGame* game);
+
+	private slots:
+		void onNewConnection();
+		void onClientDisconnected();
+		void publish(int id, const QByteArray& line, bool finished);
+
+	private:
+		QTcpServer* m_server;
+		QList<QTcpSocket*> m_clients;
+		QString m_error;
+		int m_nextId;
+		// The lines of the games in progress
+		QMap<int, QByteArray> m_games;
+};
+
+#endif // LIVEGAMEFEED_H
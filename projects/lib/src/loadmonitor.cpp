@@ -0,0 +1,170 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "loadmonitor.h"
+#include <QTimer>
+#include <QThread>
+#include <QFile>
+#include "moveevaluation.h"
+
+LoadMonitor::LoadMonitor(QObject* parent)
+	: QObject(parent),
+	  m_timer(new QTimer(this)),
+	  m_maxLoad(1.0),
+	  m_npsDrop(0.5),
+	  m_load(-1.0),
+	  m_starvedRate(0.0),
+	  m_overloaded(false)
+{
+	m_timer->setInterval(1000);
+	connect(m_timer, SIGNAL(timeout()), this, SLOT(sample()));
+	m_timer->start();
+}
+
+double LoadMonitor::maxLoad() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_maxLoad;
+}
+
+void LoadMonitor::setMaxLoad(double load)
+{
+	Q_ASSERT(load > 0.0);
+
+	QMutexLocker locker(&m_mutex);
+	m_maxLoad = load;
+}
+
+double LoadMonitor::npsDrop() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_npsDrop;
+}
+
+void LoadMonitor::setNpsDrop(double fraction)
+{
+	Q_ASSERT(fraction > 0.0 && fraction < 1.0);
+
+	QMutexLocker locker(&m_mutex);
+	m_npsDrop = fraction;
+}
+
+double LoadMonitor::load() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_load;
+}
+
+bool LoadMonitor::isOverloaded() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_overloaded;
+}
+
+bool LoadMonitor::addMove(const QString& player, const MoveEvaluation& eval)
+{
+	if (eval.isBookEval() || eval.nps() == 0 || eval.time() < MinMoveTime)
+		return false;
+
+	const double nps = double(eval.nps());
+	QMutexLocker locker(&m_mutex);
+	Baseline& baseline = m_baselines[player];
+
+	const bool starved = baseline.samples >= MinSamples
+			  && nps < baseline.nps * (1.0 - m_npsDrop);
+	m_starvedRate = 0.9 * m_starvedRate + (starved ? 0.1 : 0.0);
+	if (starved)
+		return true;
+
+	// The first moves are averaged, and then the baseline follows
+	// the engine's nps slowly. Starved moves are left out so that
+	// they don't drag the baseline down.
+	baseline.samples++;
+	baseline.nps += (nps - baseline.nps) / qMin(baseline.samples, 20);
+	return false;
+}
+
+quint64 LoadMonitor::baselineNps(const QString& player) const
+{
+	QMutexLocker locker(&m_mutex);
+	const Baseline baseline = m_baselines.value(player, Baseline{0.0, 0});
+	if (baseline.samples < MinSamples)
+		return 0;
+	return quint64(baseline.nps);
+}
+
+void LoadMonitor::sample()
+{
+	const double load = sampleHostLoad();
+	bool ended = false;
+	{
+		QMutexLocker locker(&m_mutex);
+		if (load >= 0.0)
+			m_load = (m_load < 0.0) ? load : 0.7 * m_load + 0.3 * load;
+		// Starved moves that aren't repeated are forgotten
+		m_starvedRate *= 0.95;
+
+		// The overload ends a bit below the limits so that games
+		// aren't started and held back on alternate samples
+		if (!m_overloaded
+		&&  (m_load > m_maxLoad || m_starvedRate > 0.25))
+		{
+			m_overloaded = true;
+			qWarning("Host overloaded (load %.2f, %.0f%% of moves "
+				 "starved), holding back new games",
+				 m_load, m_starvedRate * 100.0);
+		}
+		else if (m_overloaded
+		     &&  m_load <= 0.9 * m_maxLoad && m_starvedRate < 0.1)
+		{
+			m_overloaded = false;
+			ended = true;
+			qInfo("Host load back to normal, starting new games");
+		}
+	}
+
+	if (ended)
+		emit overloadEnded();
+}
+
+double LoadMonitor::sampleHostLoad()
+{
+#ifdef Q_OS_LINUX
+	// The "procs_running" line of /proc/stat counts the runnable
+	// threads, including the one reading the file
+	QFile file("/proc/stat");
+	if (!file.open(QIODevice::ReadOnly))
+		return -1.0;
+
+	while (!file.atEnd())
+	{
+		const QByteArray line(file.readLine());
+		if (!line.startsWith("procs_running "))
+			continue;
+
+		bool ok = false;
+		const int running = line.mid(14).trimmed().toInt(&ok);
+		if (!ok)
+			break;
+		return double(qMax(running - 1, 0))
+			/ qMax(QThread::idealThreadCount(), 1);
+	}
+#endif
+
+	return -1.0;
+}
@@ -0,0 +1,123 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOADMONITOR_H
+#define LOADMONITOR_H
+
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+class QTimer;
+class MoveEvaluation;
+
+/*!
+ * \brief Detects when a host is too loaded to play fair games
+ *
+ * Noisy neighbours and thermal throttling starve the engines of CPU
+ * time, and the games still finish with results that are biased.
+ * LoadMonitor detects this in two ways:
+ * - The host load, sampled every second, is the number of runnable
+ *   threads per CPU. It's only available on Linux.
+ * - Each engine's nodes per second are compared with its running
+ *   baseline. A move whose nps is more than npsDrop() below the
+ *   baseline is starved. Short moves are ignored because their nps
+ *   isn't reliable.
+ *
+ * The host is overloaded when its load exceeds maxLoad(), or when a
+ * large share of the recent moves are starved. GameManager holds back
+ * new games while the host is overloaded, and ChessGame counts the
+ * affected moves in its PGN tags.
+ *
+ * The monitor is shared by all games. All functions are thread-safe.
+ */
+class LIB_EXPORT LoadMonitor : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! The number of moves that make an engine's baseline. */
+		static const int MinSamples = 8;
+		/*! The shortest move in milliseconds that is measured. */
+		static const int MinMoveTime = 200;
+
+		/*! Creates a new LoadMonitor and starts sampling. */
+		explicit LoadMonitor(QObject* parent = nullptr);
+
+		/*!
+		 * Returns the largest allowed number of runnable threads
+		 * per CPU. The default is 1.0.
+		 */
+		double maxLoad() const;
+		/*! Sets the largest allowed load to \a load. */
+		void setMaxLoad(double load);
+		/*!
+		 * Returns the fraction by which a move's nps must fall
+		 * below the engine's baseline to be starved. The default
+		 * is 0.5.
+		 */
+		double npsDrop() const;
+		/*! Sets the starving nps drop to \a fraction. */
+		void setNpsDrop(double fraction);
+
+		/*!
+		 * Returns the smoothed host load, or -1 if it can't be
+		 * sampled on this platform.
+		 */
+		double load() const;
+		/*! Returns true if the host is overloaded. */
+		bool isOverloaded() const;
+
+		/*!
+		 * Adds a move by \a player with evaluation \a eval.
+		 *
+		 * Returns true if the move was starved.
+		 */
+		bool addMove(const QString& player, const MoveEvaluation& eval);
+		/*!
+		 * Returns the nps baseline of \a player, or 0 until
+		 * MinSamples moves have been measured.
+		 */
+		quint64 baselineNps(const QString& player) const;
+
+	signals:
+		/*! This signal is emitted when the host is no longer overloaded. */
+		void overloadEnded();
+
+	private slots:
+		void sample();
+
+	private:
+		struct Baseline
+		{
+			double nps;
+			int samples;
+		};
+
+		static double sampleHostLoad();
+
+		mutable QMutex m_mutex;
+		QTimer* m_timer;
+		double m_maxLoad;
+		double m_npsDrop;
+		double m_load;
+		double m_starvedRate;
+		bool m_overloaded;
+		QHash<QString, Baseline> m_baselines;
+};
+
+#endif // LOADMONITOR_H
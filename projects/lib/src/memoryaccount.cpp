@@ -0,0 +1,81 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "memoryaccount.h"
+#include <QAtomicInteger>
+#include <QString>
+
+namespace {
+
+QAtomicInteger<qint64> s_usage[MemoryAccount::ComponentCount];
+QAtomicInteger<qint64> s_budget(0);
+
+} // anonymous namespace
+
+void MemoryAccount::add(Component component, qint64 bytes)
+{
+	Q_ASSERT(component >= 0 && component < ComponentCount);
+	s_usage[component].fetchAndAddRelaxed(bytes);
+}
+
+qint64 MemoryAccount::usage(Component component)
+{
+	Q_ASSERT(component >= 0 && component < ComponentCount);
+	return s_usage[component].loadAcquire();
+}
+
+qint64 MemoryAccount::totalUsage()
+{
+	qint64 total = 0;
+	for (int i = 0; i < ComponentCount; i++)
+		total += s_usage[i].loadAcquire();
+	return total;
+}
+
+QString MemoryAccount::componentName(Component component)
+{
+	switch (component)
+	{
+	case OpeningBooks:
+		return "opening_books";
+	case OpeningIndexes:
+		return "opening_indexes";
+	case PgnBuffer:
+		return "pgn_buffer";
+	case GameMoves:
+		return "game_moves";
+	default:
+		return QString();
+	}
+}
+
+void MemoryAccount::setBudget(qint64 bytes)
+{
+	s_budget.storeRelease(qMax(qint64(0), bytes));
+}
+
+qint64 MemoryAccount::budget()
+{
+	return s_budget.loadAcquire();
+}
+
+bool MemoryAccount::exceedsBudget(qint64 bytes)
+{
+	const qint64 limit = budget();
+	return limit > 0 && totalUsage() + bytes > limit;
+}
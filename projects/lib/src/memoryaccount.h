@@ -0,0 +1,87 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MEMORYACCOUNT_H
+#define MEMORYACCOUNT_H
+
+#include <QtGlobal>
+class QString;
+
+/*!
+ * \brief Counts the memory used by the largest data structures
+ *
+ * MemoryAccount keeps a process-wide byte counter for each component
+ * that can grow large during a long match: opening books, opening
+ * suite indexes, games waiting to be saved in order, and the moves of
+ * the games in progress. The counters are estimates of the heap memory
+ * the components use; memory-mapped files aren't counted.
+ *
+ * A memory budget can be set for the whole process. When the counted
+ * memory exceeds it, the components that have a lower-memory mode
+ * switch to it: opening books are read from disk instead of RAM, and
+ * finished games are saved right away even if an earlier game is
+ * still running.
+ *
+ * All functions are thread-safe.
+ */
+class LIB_EXPORT MemoryAccount
+{
+	public:
+		/*! A component whose memory is counted. */
+		enum Component
+		{
+			OpeningBooks,	//!< Opening books read into RAM
+			OpeningIndexes,	//!< File positions of opening suites
+			PgnBuffer,	//!< Games waiting to be saved in order
+			GameMoves,	//!< Moves of the games in progress
+			ComponentCount	//!< Number of components
+		};
+
+		/*!
+		 * Adds \a bytes to the usage of \a component. Memory is
+		 * released by adding a negative number of bytes.
+		 */
+		static void add(Component component, qint64 bytes);
+		/*! Returns the memory used by \a component in bytes. */
+		static qint64 usage(Component component);
+		/*! Returns the memory used by all components in bytes. */
+		static qint64 totalUsage();
+		/*!
+		 * Returns the name of \a component, in lower case and with
+		 * underscores between words (eg. "opening_books").
+		 */
+		static QString componentName(Component component);
+
+		/*!
+		 * Sets the memory budget of all components to \a bytes.
+		 * A budget of 0 (the default) means no limit.
+		 */
+		static void setBudget(qint64 bytes);
+		/*! Returns the memory budget, or 0 if there's no limit. */
+		static qint64 budget();
+		/*!
+		 * Returns true if adding \a bytes to the current usage
+		 * would exceed the budget; otherwise returns false.
+		 */
+		static bool exceedsBudget(qint64 bytes = 0);
+
+	private:
+		MemoryAccount();
+};
+
+#endif // MEMORYACCOUNT_H
@@ -28,16 +28,22 @@
  * 0 and 0xFFFFFFFF - 1 at uniform distribution. Unlike Qt's
  * own random numbers, the sequences generated by this class
  * are not deterministic per thread.
+ *
+ * If the calling thread has a current RandomStream, the numbers
+ * come from it instead.
  */
 class LIB_EXPORT Mersenne
 {
 	public:
 		/*! Initializes the PRNG with \a seed. */
 		static void initialize(quint32 seed);
+		/*! Returns the seed the PRNG was initialized with. */
+		static quint32 seed();
 		/*!
 		 * Returns a pseudorandom number between 0 and 0xFFFFFFFF -1.
 		 *
-		 * This function is thread-safe.
+		 * This function is thread-safe. It's lock-free if the
+		 * calling thread has a current RandomStream.
 		 */
 		static quint32 random();
 
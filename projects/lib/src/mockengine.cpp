@@ -0,0 +1,166 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mockengine.h"
+#include <cstdio>
+#include <QTextStream>
+#include "board/board.h"
+#include "board/boardfactory.h"
+
+MockEngine::MockEngine()
+	: m_board(Chess::BoardFactory::create("standard"))
+{
+	Q_ASSERT(m_board != nullptr);
+	m_board->reset();
+}
+
+MockEngine::~MockEngine()
+{
+	delete m_board;
+}
+
+int MockEngine::run(const QString& protocol)
+{
+	QTextStream in(stdin);
+	if (protocol == "uci")
+		runUci(in);
+	else if (protocol == "xboard")
+		runXboard(in);
+	else
+		return 1;
+
+	return 0;
+}
+
+void MockEngine::send(const QString& line)
+{
+	fputs(qPrintable(line), stdout);
+	fputc('\n', stdout);
+	fflush(stdout);
+}
+
+void MockEngine::setPosition(const QString& fen, const QStringList& moves)
+{
+	m_board->setFenString(fen.isEmpty() ? m_board->defaultFenString() : fen);
+	for (const QString& str : moves)
+	{
+		const Chess::Move move(m_board->moveFromString(str));
+		if (move.isNull())
+			break;
+		m_board->makeMove(move);
+	}
+}
+
+// Picks a legal move from the position's hash key
+QString MockEngine::bestMove()
+{
+	const QVector<Chess::Move> moves(m_board->legalMoves());
+	if (moves.isEmpty())
+		return QString();
+
+	const Chess::Move& move = moves.at(int(m_board->key() % moves.size()));
+	QString str(m_board->moveString(move, Chess::Board::LongAlgebraic));
+	m_board->makeMove(move);
+
+	return str;
+}
+
+void MockEngine::runUci(QTextStream& in)
+{
+	while (!in.atEnd())
+	{
+		const QString line(in.readLine().trimmed());
+		const QString command(line.section(' ', 0, 0));
+
+		if (command == "uci")
+		{
+			send("id name Mock");
+			send("uciok");
+		}
+		else if (command == "isready")
+			send("readyok");
+		else if (command == "position")
+		{
+			const int movesPos = line.indexOf(" moves ");
+			QStringList moves;
+			if (movesPos != -1)
+				moves = line.mid(movesPos + 7).split(' ', QString::SkipEmptyParts);
+
+			QString fen;
+			if (line.startsWith("position fen "))
+				fen = line.mid(13, movesPos == -1 ? -1 : movesPos - 13);
+			setPosition(fen, moves);
+		}
+		else if (command == "go")
+		{
+			const QString move(bestMove());
+			send("bestmove " + (move.isEmpty() ? QString("0000") : move));
+		}
+		else if (command == "quit")
+			return;
+	}
+}
+
+void MockEngine::runXboard(QTextStream& in)
+{
+	bool force = false;
+	Chess::Side side(Chess::Side::Black);
+
+	while (!in.atEnd())
+	{
+		const QString line(in.readLine().trimmed());
+		const QString command(line.section(' ', 0, 0));
+		const QString args(line.section(' ', 1));
+
+		if (command == "protover")
+			send("feature ping=1 setboard=1 usermove=1 time=1 "
+			     "myname=\"Mock\" done=1");
+		else if (command == "ping")
+			send("pong " + args);
+		else if (command == "new")
+		{
+			setPosition(QString(), QStringList());
+			force = false;
+			side = Chess::Side::Black;
+		}
+		else if (command == "setboard")
+			setPosition(args, QStringList());
+		else if (command == "force")
+			force = true;
+		else if (command == "usermove")
+			setPosition(m_board->fenString(), QStringList() << args);
+		else if (command == "go")
+		{
+			force = false;
+			side = m_board->sideToMove();
+		}
+		else if (command == "quit")
+			return;
+		else
+			continue;
+
+		if (!force
+		&&  (command == "go" || command == "usermove")
+		&&  m_board->sideToMove() == side)
+		{
+			const QString move(bestMove());
+			if (!move.isEmpty())
+				send("move " + move);
+		}
+	}
+}
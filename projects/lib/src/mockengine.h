@@ -0,0 +1,73 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOCKENGINE_H
+#define MOCKENGINE_H
+
+#include <QString>
+#include <QStringList>
+class QTextStream;
+namespace Chess { class Board; }
+
+/*!
+ * \brief A chess engine that replies to every search request instantly
+ *
+ * Benchmarks run copies of their own executable as mock UCI or Xboard
+ * engines, so that their games measure cutechess' own overhead: the
+ * engine I/O, the move parsing and the signals between the game
+ * threads. The moves are picked from the position's hash key, so the
+ * same position always gets the same move and the games are
+ * repeatable.
+ */
+class LIB_EXPORT MockEngine
+{
+	public:
+		/*!
+		 * The maximum length of games between mock engines, which
+		 * can shuffle pieces for hundreds of moves.
+		 *
+		 * \sa GameAdjudicator::setMaximumGameLength()
+		 */
+		static const int MaxGameLength = 100;
+
+		/*! Creates a new mock engine for standard chess. */
+		MockEngine();
+		/*! Destroys the engine. */
+		~MockEngine();
+
+		/*!
+		 * Talks to the GUI in \a protocol ("uci" or "xboard") over
+		 * the standard input and output until told to quit.
+		 *
+		 * Returns 0 when done, or 1 if \a protocol is unknown.
+		 */
+		int run(const QString& protocol);
+
+	private:
+		Q_DISABLE_COPY(MockEngine)
+
+		void send(const QString& line);
+		void setPosition(const QString& fen, const QStringList& moves);
+		QString bestMove();
+		void runUci(QTextStream& in);
+		void runXboard(QTextStream& in);
+
+		Chess::Board* m_board;
+};
+
+#endif // MOCKENGINE_H
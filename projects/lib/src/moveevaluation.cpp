@@ -143,6 +143,87 @@ QString MoveEvaluation::scoreText() const
 	return str;
 }
 
+QString MoveEvaluation::pgnComment() const
+{
+	if (isBookEval())
+		return "book";
+	if (isEmpty())
+		return QString();
+
+	QString str = scoreText();
+	if (depth() > 0)
+		str += "/" + QString::number(depth()) + " ";
+
+	int t = time();
+	if (t == 0)
+		return str + "0s";
+
+	int precision = 0;
+	if (t < 100)
+		precision = 3;
+	else if (t < 1000)
+		precision = 2;
+	else if (t < 10000)
+		precision = 1;
+	str += QString::number(double(t / 1000.0), 'f', precision) + 's';
+
+	return str;
+}
+
+MoveEvaluation MoveEvaluation::fromPgnComment(const QString& comment)
+{
+	MoveEvaluation eval;
+	const QString str(comment.section(',', 0, 0).trimmed());
+	if (str == "book")
+	{
+		eval.setBookEval(true);
+		return eval;
+	}
+
+	QString timeStr(str);
+	const int slash = str.indexOf('/');
+	if (slash > 0)
+	{
+		const int space = str.indexOf(' ', slash);
+		bool ok = false;
+		const int depth = str.mid(slash + 1, space < 0 ? -1 : space - slash - 1)
+				  .toInt(&ok);
+		if (!ok || depth <= 0)
+			return eval;
+
+		QString scoreStr(str.left(slash));
+		const bool negative = scoreStr.startsWith('-');
+		int score;
+		const int m = scoreStr.indexOf('M');
+		if (m >= 0)
+		{
+			// Mate distances, as in scoreText()
+			const int distance = scoreStr.mid(m + 1).toInt(&ok);
+			score = MATE_SCORE - distance;
+			if (negative)
+				score = -score;
+		}
+		else
+			score = qRound(scoreStr.toDouble(&ok) * 100.0);
+		if (!ok)
+			return eval;
+
+		eval.setDepth(depth);
+		eval.setScore(score);
+		timeStr = space < 0 ? QString() : str.mid(space + 1);
+	}
+
+	if (timeStr.endsWith('s'))
+	{
+		bool ok = false;
+		const double t = timeStr.left(timeStr.size() - 1).toDouble(&ok);
+		if (ok)
+			eval.setTime(qRound(t * 1000.0));
+	}
+
+	return eval;
+}
+
 int MoveEvaluation::time() const
 {
 	return m_time;
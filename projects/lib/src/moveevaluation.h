@@ -83,6 +83,23 @@ class LIB_EXPORT MoveEvaluation
 		 * \note For human players an empty string is returned.
 		 */
 		QString scoreText() const;
+		/*!
+		 * The evaluation as a PGN move comment, eg. "+0.31/13 4.5s".
+		 *
+		 * Returns "book" for book moves and an empty string if there
+		 * is no evaluation.
+		 */
+		QString pgnComment() const;
+		/*!
+		 * Parses a PGN move comment written by pgnComment(), eg.
+		 * "+0.31/13 4.5s" or "-M6/20 0.8s", into an evaluation.
+		 *
+		 * Only the score, the depth and the move time are restored.
+		 * Text after a comma, like the description of the game's
+		 * result, is ignored. Comments in other formats return an
+		 * evaluation with no score and no depth.
+		 */
+		static MoveEvaluation fromPgnComment(const QString& comment);
 
 		/*! Move time in milliseconds. */
 		int time() const;
@@ -0,0 +1,60 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "moveevent.h"
+
+MoveEvent::MoveEvent()
+	: m_ply(-1)
+{
+}
+
+MoveEvent::MoveEvent(int ply, const PgnGame::MoveData& data)
+	: m_ply(ply),
+	  m_data(new PgnGame::MoveData(data))
+{
+}
+
+bool MoveEvent::isNull() const
+{
+	return m_data.isNull();
+}
+
+int MoveEvent::ply() const
+{
+	return m_ply;
+}
+
+Chess::GenericMove MoveEvent::move() const
+{
+	return m_data.isNull() ? Chess::GenericMove() : m_data->move;
+}
+
+QString MoveEvent::san() const
+{
+	return m_data.isNull() ? QString() : m_data->moveString;
+}
+
+MoveEvaluation MoveEvent::evaluation() const
+{
+	return m_data.isNull() ? MoveEvaluation() : m_data->evaluation;
+}
+
+QString MoveEvent::comment() const
+{
+	return m_data.isNull() ? QString() : m_data->commentText();
+}
@@ -0,0 +1,70 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOVEEVENT_H
+#define MOVEEVENT_H
+
+#include <QSharedPointer>
+#include <QMetaType>
+#include "pgngame.h"
+
+/*!
+ * \brief A move made or changed in a ChessGame
+ *
+ * ChessGame emits one MoveEvent per ply. The event shares the ply's
+ * move data through a reference-counted pointer, so queued deliveries
+ * to other threads only copy a pointer. The move comment is formatted
+ * from the move evaluation only when comment() is called, in the
+ * receiver's thread.
+ *
+ * The event carries no position; ChessGame::fenChanged() is only
+ * emitted when a game starts, and receivers that need the position
+ * after each move apply move() to their own board.
+ */
+class LIB_EXPORT MoveEvent
+{
+	public:
+		/*! Creates a null event. */
+		MoveEvent();
+		/*! Creates a new event of the move \a data at \a ply. */
+		MoveEvent(int ply, const PgnGame::MoveData& data);
+
+		/*! Returns true if the event has no move. */
+		bool isNull() const;
+		/*! Returns the zero-based ply of the move. */
+		int ply() const;
+		/*! Returns the move. */
+		Chess::GenericMove move() const;
+		/*! Returns the move in Standard Algebraic Notation. */
+		QString san() const;
+		/*! Returns the engine's evaluation of the move. */
+		MoveEvaluation evaluation() const;
+		/*!
+		 * Returns the move comment, formatted from the evaluation
+		 * like in the PGN output.
+		 */
+		QString comment() const;
+
+	private:
+		int m_ply;
+		QSharedPointer<const PgnGame::MoveData> m_data;
+};
+
+Q_DECLARE_METATYPE(MoveEvent)
+
+#endif // MOVEEVENT_H
@@ -20,11 +20,47 @@
 #include <QString>
 #include <QFile>
 #include <QDataStream>
+#include <QScopedPointer>
+#include <QVector>
+#include <QElapsedTimer>
+#include <climits>
 #include <QtDebug>
 #include "pgngame.h"
 #include "pgnstream.h"
 #include "mersenne.h"
+#include "memoryaccount.h"
+#include "bookprobecache.h"
+
+/*!
+ * Book entries in the book file's format, sorted by key. The entries
+ * are either read into \a bytes or mapped from \a file.
+ */
+struct OpeningBook::SortedEntries
+{
+	SortedEntries()
+		: file(nullptr),
+		  data(nullptr),
+		  count(0),
+		  prefixBits(0)
+	{
+	}
+	~SortedEntries()
+	{
+		delete file;
+	}
+
+	QByteArray bytes;
+	QFile* file;
+	const uchar* data;
+	qint64 count;
+	// The index of the first entry for each of the 2^prefixBits
+	// key prefixes, and the entry count at the end
+	int prefixBits;
+	QVector<quint32> jumpTable;
 
+	private:
+		Q_DISABLE_COPY(SortedEntries)
+};
 
 QDataStream& operator>>(QDataStream& in, OpeningBook* book)
 {
@@ -40,6 +76,21 @@ QDataStream& operator>>(QDataStream& in, OpeningBook* book)
 
 QDataStream& operator<<(QDataStream& out, const OpeningBook* book)
 {
+	// Sorted entries are already in the book's file format
+	if (book->m_sorted)
+	{
+		const char* data = reinterpret_cast<const char*>(book->m_sorted->data);
+		qint64 size = book->m_sorted->count * book->entrySize();
+		while (size > 0 && out.status() == QDataStream::Ok)
+		{
+			const int chunk = int(qMin(size, qint64(INT_MAX)));
+			out.writeRawData(data, chunk);
+			data += chunk;
+			size -= chunk;
+		}
+		return out;
+	}
+
 	OpeningBook::Map::const_iterator it;
 	for (it = book->m_map.constBegin(); it != book->m_map.constEnd(); ++it)
 		book->writeEntry(it, out);
@@ -48,17 +99,27 @@ QDataStream& operator<<(QDataStream& out, const OpeningBook* book)
 }
 
 OpeningBook::OpeningBook(AccessMode mode)
-	: m_mode(mode)
+	: m_mode(mode),
+	  m_probes(0),
+	  m_hits(0),
+	  m_entryHits(0),
+	  m_probeTime(0),
+	  m_cacheHits(0),
+	  m_memoryUsage(0)
 {
 }
 
 OpeningBook::~OpeningBook()
 {
+	MemoryAccount::add(MemoryAccount::OpeningBooks, -m_memoryUsage);
 }
 
 bool OpeningBook::read(const QString& filename)
 {
 	m_filename = filename;
+	m_sorted.clear();
+	setProbeCacheSize(probeCacheSize());
+
 	QFile file(filename);
 	if (!file.open(QIODevice::ReadOnly))
 		return false;
@@ -70,14 +131,41 @@ bool OpeningBook::read(const QString& filename)
 		return false;
 	}
 
+	// A book that doesn't fit in the memory budget is searched on disk
+	if (m_mode == Ram && MemoryAccount::exceedsBudget(file.size()))
+	{
+		qWarning("Memory budget exceeded, reading opening book %s from disk",
+			 qUtf8Printable(filename));
+		m_mode = Disk;
+	}
+
 	if (m_mode == Disk)
+	{
+		// Probes search the mapped file without any system calls.
+		// If the file can't be mapped it's read on every probe.
+		SortedEntries* sorted = new SortedEntries;
+		sorted->file = new QFile(filename);
+		if (file.size() > 0 && sorted->file->open(QIODevice::ReadOnly))
+			sorted->data = sorted->file->map(0, file.size());
+		sorted->count = file.size() / entrySize();
+		if (sorted->data != nullptr)
+			m_sorted.reset(sorted);
+		else
+			delete sorted;
+		updateMemoryUsage();
 		return true;
+	}
 
 	m_map.clear();
-	QDataStream in(&file);
-	in >> this;
+	if (!loadSortedEntries(&file))
+	{
+		file.seek(0);
+		QDataStream in(&file);
+		in >> this;
+	}
+	updateMemoryUsage();
 
-	return !m_map.isEmpty();
+	return !m_sorted.isNull() || !m_map.isEmpty();
 }
 
 bool OpeningBook::write(const QString& filename) const
@@ -92,8 +180,83 @@ bool OpeningBook::write(const QString& filename) const
 	return true;
 }
 
+bool OpeningBook::loadSortedEntries(QFile* file)
+{
+	if (file->size() / entrySize() > UINT_MAX)
+		return false;
+
+	QScopedPointer<SortedEntries> sorted(new SortedEntries);
+	sorted->bytes = file->readAll();
+	sorted->data = reinterpret_cast<const uchar*>(sorted->bytes.constData());
+	sorted->count = sorted->bytes.size() / entrySize();
+	if (sorted->count == 0 || sorted->bytes.size() != file->size())
+		return false;
+
+	// About four entries per key prefix
+	while (sorted->prefixBits < 16
+	&&     (qint64(4) << sorted->prefixBits) < sorted->count)
+		sorted->prefixBits++;
+	const int shift = 64 - sorted->prefixBits;
+	const quint32 prefixCount = quint32(1) << sorted->prefixBits;
+	sorted->jumpTable.resize(int(prefixCount + 1));
+
+	quint64 key = 0;
+	quint64 prevKey = 0;
+	quint32 prefix = 0;
+	for (qint64 i = 0; i < sorted->count; i++)
+	{
+		readEntry(sorted->data + i * entrySize(), &key);
+		if (key < prevKey)
+			return false;
+		prevKey = key;
+
+		const quint32 keyPrefix = shift < 64 ? quint32(key >> shift) : 0;
+		while (prefix <= keyPrefix)
+			sorted->jumpTable[int(prefix++)] = quint32(i);
+	}
+	while (prefix <= prefixCount)
+		sorted->jumpTable[int(prefix++)] = quint32(sorted->count);
+
+	m_sorted.reset(sorted.take());
+	return true;
+}
+
+void OpeningBook::unpackSortedEntries()
+{
+	const auto sorted = m_sorted;
+	m_sorted.clear();
+
+	quint64 key;
+	for (qint64 i = 0; i < sorted->count; i++)
+	{
+		const Entry entry = readEntry(sorted->data + i * entrySize(), &key);
+		addEntry(entry, key);
+	}
+}
+
+void OpeningBook::updateMemoryUsage()
+{
+	// A map node holds the key, the entry and three pointers
+	qint64 bytes = qint64(m_map.size())
+		     * qint64(sizeof(quint64) + sizeof(Entry) + 3 * sizeof(void*));
+	if (m_sorted)
+		bytes += m_sorted->bytes.size()
+		       + m_sorted->jumpTable.size() * qint64(sizeof(quint32));
+
+	MemoryAccount::add(MemoryAccount::OpeningBooks, bytes - m_memoryUsage);
+	m_memoryUsage = bytes;
+}
+
 void OpeningBook::addEntry(const Entry& entry, quint64 key)
 {
+	// Copies of the book keep their cache
+	if (m_cache && !m_cache->isEmpty())
+		setProbeCacheSize(probeCacheSize());
+
+	// New entries go to the binary tree
+	if (m_sorted)
+		unpackSortedEntries();
+
 	Map::iterator it = m_map.find(key);
 	while (it != m_map.end() && it.key() == key)
 	{
@@ -136,6 +299,7 @@ int OpeningBook::import(const PgnGame& pgn, int maxMoves)
 			addEntry(entry, moves.at(i).key);
 		}
 	}
+	updateMemoryUsage();
 
 	return ret;
 }
@@ -218,22 +382,136 @@ QList<OpeningBook::Entry> OpeningBook::entriesFromDisk(quint64 key) const
 	return entries;
 }
 
+OpeningBook::Entry OpeningBook::readEntry(const uchar* data, quint64* key) const
+{
+	const QByteArray bytes(QByteArray::fromRawData(
+		reinterpret_cast<const char*>(data), entrySize()));
+	QDataStream in(bytes);
+	return readEntry(in, key);
+}
+
+QList<OpeningBook::Entry> OpeningBook::sortedEntries(quint64 key) const
+{
+	QList<Entry> entries;
+	const uchar* data = m_sorted->data;
+	const qint64 step = entrySize();
+	const qint64 n = m_sorted->count;
+
+	// The jump table narrows the search to the key's prefix
+	qint64 first = 0;
+	qint64 last = n;
+	if (!m_sorted->jumpTable.isEmpty())
+	{
+		const int shift = 64 - m_sorted->prefixBits;
+		const int prefix = shift < 64 ? int(key >> shift) : 0;
+		first = m_sorted->jumpTable.at(prefix);
+		last = m_sorted->jumpTable.at(prefix + 1);
+	}
+
+	// Binary search for the first entry with the key
+	quint64 entryKey = 0;
+	while (first < last)
+	{
+		const qint64 middle = first + (last - first) / 2;
+		readEntry(data + middle * step, &entryKey);
+		if (entryKey < key)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	for (qint64 i = first; i < n; i++)
+	{
+		Entry entry = readEntry(data + i * step, &entryKey);
+		if (entryKey != key)
+			break;
+		entries << entry;
+	}
+
+	return entries;
+}
+
 QList<OpeningBook::Entry> OpeningBook::entries(quint64 key) const
 {
+	if (!m_cache)
+		return findEntries(key);
+
+	QList<Entry> entries;
+	if (m_cache->find(key, &entries))
+	{
+		m_cacheHits.fetchAndAddRelaxed(1);
+		return entries;
+	}
+
+	entries = findEntries(key);
+	m_cache->insert(key, entries);
+	return entries;
+}
+
+int OpeningBook::probeCacheSize() const
+{
+	return m_cache ? m_cache->capacity() : 0;
+}
+
+void OpeningBook::setProbeCacheSize(int positions)
+{
+	if (positions > 0)
+		m_cache.reset(new BookProbeCache(positions));
+	else
+		m_cache.clear();
+}
+
+QList<OpeningBook::Entry> OpeningBook::findEntries(quint64 key) const
+{
+	if (m_sorted)
+		return sortedEntries(key);
 	if (m_mode == Ram)
 		return m_map.values(key);
 	return entriesFromDisk(key);
 }
 
+OpeningBook::Statistics OpeningBook::statistics() const
+{
+	Statistics stats = {
+		m_probes.loadAcquire(),
+		m_hits.loadAcquire(),
+		m_entryHits.loadAcquire(),
+		m_probeTime.loadAcquire(),
+		m_cacheHits.loadAcquire()
+	};
+	return stats;
+}
+
+void OpeningBook::resetStatistics()
+{
+	m_probes.storeRelease(0);
+	m_hits.storeRelease(0);
+	m_entryHits.storeRelease(0);
+	m_probeTime.storeRelease(0);
+	m_cacheHits.storeRelease(0);
+}
+
+QString OpeningBook::fileName() const
+{
+	return m_filename;
+}
+
 Chess::GenericMove OpeningBook::move(quint64 key) const
 {
 	Chess::GenericMove move;
 	
 	// There can be multiple entries/moves with the same key.
 	// We need to find them all to choose the best one
+	QElapsedTimer timer;
+	timer.start();
 	const auto entries = this->entries(key);
+	m_probeTime.fetchAndAddRelaxed(timer.nsecsElapsed());
+	m_probes.fetchAndAddRelaxed(1);
 	if (entries.isEmpty())
 		return move;
+
+	m_hits.fetchAndAddRelaxed(1);
+	m_entryHits.fetchAndAddRelaxed(entries.size());
 	
 	// Calculate the total weight of all available moves
 	int totalWeight = 0;
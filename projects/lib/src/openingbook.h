@@ -21,12 +21,16 @@
 
 #include <QtGlobal>
 #include <QMultiMap>
+#include <QSharedPointer>
+#include <QAtomicInteger>
 #include "board/genericmove.h"
 
 class QString;
 class QDataStream;
+class QFile;
 class PgnGame;
 class PgnStream;
+class BookProbeCache;
 
 
 /*!
@@ -39,6 +43,12 @@ class PgnStream;
  * The opening book can be stored externally in a binary file. When it's needed,
  * it is loaded in memory, and positions can be found quickly by searching
  * the book for Zobrist keys that match the current board position.
+ *
+ * A book file whose entries are sorted by key is kept in memory as is,
+ * in the file's own format, and searched with a key-prefix jump table.
+ * The loaded entries are shared read-only by copies of the book. Books
+ * that are imported from PGN games, or files that aren't sorted, are
+ * stored in a binary tree instead.
  */
 class LIB_EXPORT OpeningBook
 {
@@ -47,7 +57,12 @@ class LIB_EXPORT OpeningBook
 		enum AccessMode
 		{
 			Ram,	//!< Load the entire book to RAM
-			Disk	//!< Read moves directly from disk
+			/*!
+			 * Read moves directly from disk. The book file
+			 * is mapped into memory if possible, and the
+			 * mapping is shared by copies of the book.
+			 */
+			Disk
 		};
 
 		/*!
@@ -69,7 +84,32 @@ class LIB_EXPORT OpeningBook
 			quint16 weight;
 		};
 
-		/*! Creates a new OpeningBook with access mode \a mode. */
+		/*!
+		 * \brief Counters for the probes made by move().
+		 *
+		 * The counters are updated atomically, so a book shared by
+		 * concurrent games collects the probes of all of them.
+		 */
+		struct Statistics
+		{
+			/*! The number of probes. */
+			qint64 probes;
+			/*! The number of probes that found at least one entry. */
+			qint64 hits;
+			/*! The total number of entries found by the hits. */
+			qint64 entries;
+			/*! The cumulative probe time in nanoseconds. */
+			qint64 probeTime;
+			/*! The number of probes found in the probe cache. */
+			qint64 cacheHits;
+		};
+
+		/*!
+		 * Creates a new OpeningBook with access mode \a mode.
+		 *
+		 * A book with the \a Ram access mode is read from disk
+		 * instead if it doesn't fit in the MemoryAccount budget.
+		 */
 		OpeningBook(AccessMode mode = Ram);
 		/*! Destroys the opening book. */
 		virtual ~OpeningBook();
@@ -111,6 +151,27 @@ class LIB_EXPORT OpeningBook
 		/*! Returns all entries matching \a key. */
 		QList<Entry> entries(quint64 key) const;
 
+		/*! Returns the size of the probe cache in positions. */
+		int probeCacheSize() const;
+		/*!
+		 * Caches the entries of the last \a positions probed
+		 * positions, so that positions that are probed again, eg.
+		 * by every game of a tournament, aren't searched again.
+		 * The cache is shared by copies of the book and can be
+		 * used by concurrent games. If \a positions is 0 (the
+		 * default), there's no cache.
+		 *
+		 * \sa BookProbeCache
+		 */
+		void setProbeCacheSize(int positions);
+
+		/*! Returns the probe statistics of move(). */
+		Statistics statistics() const;
+		/*! Resets the probe statistics. */
+		void resetStatistics();
+		/*! Returns the name of the book file, if any. */
+		QString fileName() const;
+
 		/*!
 		 * Reads a book from \a filename.
 		 * Returns true if successful; otherwise returns false.
@@ -144,17 +205,40 @@ class LIB_EXPORT OpeningBook
 		 * belongs to the entry.
 		 */
 		virtual Entry readEntry(QDataStream& in, quint64* key) const = 0;
+		/*!
+		 * Reads a book entry from \a data, which holds the
+		 * entrySize() bytes of an entry in the book file.
+		 *
+		 * The default implementation calls readEntry() with a
+		 * data stream that reads \a data.
+		 */
+		virtual Entry readEntry(const uchar* data, quint64* key) const;
 		
 		/*! Writes the key and entry pointed to by \a it, to \a out. */
 		virtual void writeEntry(const Map::const_iterator& it,
 					QDataStream& out) const = 0;
 
 	private:
+		struct SortedEntries;
+
+		QList<Entry> findEntries(quint64 key) const;
 		QList<Entry> entriesFromDisk(quint64 key) const;
+		QList<Entry> sortedEntries(quint64 key) const;
+		bool loadSortedEntries(QFile* file);
+		void unpackSortedEntries();
+		void updateMemoryUsage();
 
 		AccessMode m_mode;
 		QString m_filename;
 		Map m_map;
+		QSharedPointer<const SortedEntries> m_sorted;
+		QSharedPointer<BookProbeCache> m_cache;
+		mutable QAtomicInteger<qint64> m_probes;
+		mutable QAtomicInteger<qint64> m_hits;
+		mutable QAtomicInteger<qint64> m_entryHits;
+		mutable QAtomicInteger<qint64> m_probeTime;
+		mutable QAtomicInteger<qint64> m_cacheHits;
+		qint64 m_memoryUsage;
 };
 
 /*!
@@ -0,0 +1,292 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "openingindex.h"
+#include <climits>
+#include <cstring>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QtEndian>
+#include "memoryaccount.h"
+
+namespace {
+
+const quint32 s_version = 2;
+// Magic, version, format, suite size, modification time and hash
+const int s_headerSize = 56;
+// The header and the number of openings
+const int s_dataOffset = 64;
+// The number of openings that share a base position
+const int s_blockSize = 64;
+// Marks an offset that doesn't fit in 32 bits
+const quint32 s_wideOffset = 0xFFFFFFFF;
+// The size of the blocks at the beginning and end of the suite
+// that are hashed
+const int s_hashBlockSize = 64 * 1024;
+const int s_writeChunkSize = 64 * 1024;
+
+} // anonymous namespace
+
+OpeningIndex::OpeningIndex()
+	: m_mapFile(nullptr),
+	  m_mappedBases(nullptr),
+	  m_mappedOffsets(nullptr),
+	  m_mappedCount(0),
+	  m_memoryUsage(0)
+{
+}
+
+OpeningIndex::~OpeningIndex()
+{
+	unmap();
+	MemoryAccount::add(MemoryAccount::OpeningIndexes, -m_memoryUsage);
+}
+
+int OpeningIndex::count() const
+{
+	if (m_mapFile != nullptr)
+		return m_mappedCount;
+	return m_offsets.size();
+}
+
+bool OpeningIndex::isEmpty() const
+{
+	return count() == 0;
+}
+
+qint64 OpeningIndex::at(int index) const
+{
+	Q_ASSERT(index >= 0 && index < count());
+
+	const int block = index / s_blockSize;
+	if (m_mapFile != nullptr)
+	{
+		return qFromLittleEndian<qint64>(m_mappedBases + qint64(block) * 8)
+		     + qFromLittleEndian<quint32>(m_mappedOffsets + qint64(index) * 4);
+	}
+
+	const quint32 offset = m_offsets.at(index);
+	if (offset == s_wideOffset)
+		return m_wideOffsets.value(index);
+	return m_bases.at(block) + offset;
+}
+
+void OpeningIndex::append(qint64 pos)
+{
+	Q_ASSERT(m_mapFile == nullptr);
+
+	const int index = m_offsets.size();
+	const int capacity = m_offsets.capacity();
+	if (index % s_blockSize == 0)
+		m_bases.append(pos);
+
+	const qint64 offset = pos - m_bases.last();
+	if (offset >= 0 && offset < s_wideOffset)
+		m_offsets.append(quint32(offset));
+	else
+	{
+		m_offsets.append(s_wideOffset);
+		m_wideOffsets.insert(index, pos);
+	}
+
+	// Usage is counted when the arrays grow
+	if (m_offsets.capacity() != capacity)
+		updateMemoryUsage();
+}
+
+void OpeningIndex::clear()
+{
+	unmap();
+	m_bases.clear();
+	m_offsets.clear();
+	m_wideOffsets.clear();
+	updateMemoryUsage();
+}
+
+void OpeningIndex::updateMemoryUsage()
+{
+	// Mapped index files are not counted
+	const qint64 bytes = m_bases.capacity() * qint64(sizeof(qint64))
+			   + m_offsets.capacity() * qint64(sizeof(quint32))
+			   + m_wideOffsets.size() * qint64(4 * sizeof(qint64));
+
+	MemoryAccount::add(MemoryAccount::OpeningIndexes, bytes - m_memoryUsage);
+	m_memoryUsage = bytes;
+}
+
+void OpeningIndex::unmap()
+{
+	// Destroying the file unmaps it
+	delete m_mapFile;
+	m_mapFile = nullptr;
+	m_mappedBases = nullptr;
+	m_mappedOffsets = nullptr;
+	m_mappedCount = 0;
+}
+
+QStringList OpeningIndex::cacheFileNames(const QString& fileName)
+{
+	QStringList names;
+	names << fileName + ".cci";
+
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+	if (!dir.isEmpty())
+	{
+		QByteArray path(QFileInfo(fileName).absoluteFilePath().toUtf8());
+		QByteArray key(QCryptographicHash::hash(path, QCryptographicHash::Sha1));
+		names << dir + "/openings/" + QString::fromLatin1(key.toHex()) + ".cci";
+	}
+
+	return names;
+}
+
+QByteArray OpeningIndex::header(const QString& fileName, int format)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+
+	// Hashing the whole suite would take as long as indexing it
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(file.read(s_hashBlockSize));
+	if (file.size() > s_hashBlockSize)
+	{
+		file.seek(qMax(qint64(s_hashBlockSize), file.size() - s_hashBlockSize));
+		hash.addData(file.read(s_hashBlockSize));
+	}
+	const qint64 modified = QFileInfo(file).lastModified().toMSecsSinceEpoch();
+
+	QByteArray data(s_headerSize, 0);
+	uchar* p = reinterpret_cast<uchar*>(data.data());
+	std::memcpy(p, "CCOI", 4);
+	qToLittleEndian<quint32>(s_version, p + 4);
+	qToLittleEndian<quint32>(quint32(format), p + 8);
+	qToLittleEndian<qint64>(file.size(), p + 16);
+	qToLittleEndian<qint64>(modified, p + 24);
+	std::memcpy(p + 32, hash.result().constData(), 20);
+
+	return data;
+}
+
+bool OpeningIndex::load(const QString& fileName, int format)
+{
+	clear();
+
+	const QByteArray expected(header(fileName, format));
+	if (expected.isEmpty())
+		return false;
+
+	const auto names = cacheFileNames(fileName);
+	for (const QString& name : names)
+	{
+		QFile* file = new QFile(name);
+		const qint64 size = file->size();
+		uchar* data = nullptr;
+		if (size >= s_dataOffset && file->open(QIODevice::ReadOnly))
+			data = file->map(0, size);
+		if (data == nullptr)
+		{
+			delete file;
+			continue;
+		}
+
+		const qint64 count = qFromLittleEndian<qint64>(data + s_headerSize);
+		const qint64 blocks = (count + s_blockSize - 1) / s_blockSize;
+		if (std::memcmp(data, expected.constData(), s_headerSize) != 0
+		||  count < 0 || count > INT_MAX
+		||  size != s_dataOffset + blocks * 8 + count * 4)
+		{
+			delete file;
+			continue;
+		}
+
+		m_mapFile = file;
+		m_mappedBases = data + s_dataOffset;
+		m_mappedOffsets = m_mappedBases + blocks * 8;
+		m_mappedCount = int(count);
+		return true;
+	}
+
+	return false;
+}
+
+bool OpeningIndex::save(const QString& fileName, int format) const
+{
+	// The cache format has no room for wide offsets
+	if (!m_wideOffsets.isEmpty())
+		return false;
+
+	const QByteArray head(header(fileName, format));
+	if (head.isEmpty())
+		return false;
+
+	const int n = count();
+	const int blocks = (n + s_blockSize - 1) / s_blockSize;
+	QByteArray start(s_dataOffset, 0);
+	std::memcpy(start.data(), head.constData(), s_headerSize);
+	qToLittleEndian<qint64>(n, start.data() + s_headerSize);
+
+	const auto names = cacheFileNames(fileName);
+	for (const QString& name : names)
+	{
+		QDir().mkpath(QFileInfo(name).absolutePath());
+		QSaveFile file(name);
+		if (!file.open(QIODevice::WriteOnly))
+			continue;
+
+		bool ok = file.write(start) == start.size();
+		QByteArray chunk;
+		chunk.reserve(s_writeChunkSize + 8);
+
+		// The first opening of each block is at the block's base
+		for (int i = 0; i < blocks && ok; i++)
+		{
+			uchar entry[8];
+			qToLittleEndian<qint64>(at(i * s_blockSize), entry);
+			chunk.append(reinterpret_cast<const char*>(entry), 8);
+
+			if (chunk.size() >= s_writeChunkSize || i == blocks - 1)
+			{
+				ok = file.write(chunk) == chunk.size();
+				chunk.resize(0);
+			}
+		}
+		for (int i = 0; i < n && ok; i++)
+		{
+			const qint64 base = at(i - i % s_blockSize);
+			uchar entry[4];
+			qToLittleEndian<quint32>(quint32(at(i) - base), entry);
+			chunk.append(reinterpret_cast<const char*>(entry), 4);
+
+			if (chunk.size() >= s_writeChunkSize || i == n - 1)
+			{
+				ok = file.write(chunk) == chunk.size();
+				chunk.resize(0);
+			}
+		}
+
+		if (ok && file.commit())
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,104 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENINGINDEX_H
+#define OPENINGINDEX_H
+
+#include <QVector>
+#include <QHash>
+#include <QStringList>
+class QFile;
+
+/*!
+ * \brief The file positions of the openings in an opening suite
+ *
+ * OpeningIndex stores the file position of each opening in an opening
+ * suite file. The positions are kept in blocks of 64 consecutive
+ * openings: each block has a 64-bit base position, and each opening
+ * a 32-bit offset from the base of its block, so a position takes a
+ * little over 4 bytes.
+ *
+ * An index can be saved to a cache file next to the suite (or in the
+ * user's cache directory if the suite's directory isn't writable),
+ * and a saved index is loaded by mapping the cache file into memory,
+ * so loading takes the same time for every suite size.
+ *
+ * A cache file is only used if the size, modification time and a
+ * hash of the beginning and end of the suite file still match.
+ *
+ * \sa OpeningSuite
+ */
+class LIB_EXPORT OpeningIndex
+{
+	public:
+		/*! Creates a new empty index. */
+		OpeningIndex();
+		/*! Destroys the index. */
+		~OpeningIndex();
+
+		/*! Returns the number of openings. */
+		int count() const;
+		/*! Returns true if the index contains no openings. */
+		bool isEmpty() const;
+		/*! Returns the file position of opening \a index. */
+		qint64 at(int index) const;
+
+		/*!
+		 * Appends file position \a pos to the index.
+		 *
+		 * The index is smallest when the positions are appended
+		 * in ascending order.
+		 */
+		void append(qint64 pos);
+		/*! Removes all openings from the index. */
+		void clear();
+
+		/*!
+		 * Loads a cached index of suite file \a fileName whose
+		 * openings are in format \a format.
+		 *
+		 * Returns true if a valid cache file was found; otherwise
+		 * returns false.
+		 */
+		bool load(const QString& fileName, int format);
+		/*!
+		 * Saves the index to the cache of suite file \a fileName
+		 * whose openings are in format \a format.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool save(const QString& fileName, int format) const;
+
+	private:
+		Q_DISABLE_COPY(OpeningIndex)
+
+		static QStringList cacheFileNames(const QString& fileName);
+		static QByteArray header(const QString& fileName, int format);
+		void unmap();
+		void updateMemoryUsage();
+
+		QVector<qint64> m_bases;
+		QVector<quint32> m_offsets;
+		QHash<int, qint64> m_wideOffsets;
+		QFile* m_mapFile;
+		const uchar* m_mappedBases;
+		const uchar* m_mappedOffsets;
+		int m_mappedCount;
+		qint64 m_memoryUsage;
+};
+
+#endif // OPENINGINDEX_H
@@ -0,0 +1,135 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "openingpool.h"
+#include <QMutexLocker>
+#include "openingsuite.h"
+#include "board/board.h"
+#include "board/boardfactory.h"
+
+OpeningPool::OpeningPool(OpeningSuite* suite,
+			 const QString& variant,
+			 int maxPlies,
+			 int capacity,
+			 QObject* parent)
+	: QThread(parent),
+	  m_suite(suite),
+	  m_variant(variant),
+	  m_maxPlies(maxPlies),
+	  m_capacity(qMax(1, capacity)),
+	  m_board(nullptr),
+	  m_stopping(false)
+{
+	Q_ASSERT(suite != nullptr);
+}
+
+OpeningPool::~OpeningPool()
+{
+	m_mutex.lock();
+	m_stopping = true;
+	m_notFull.wakeAll();
+	m_mutex.unlock();
+
+	wait();
+}
+
+OpeningPool::Opening OpeningPool::take()
+{
+	QMutexLocker locker(&m_mutex);
+	while (m_queue.isEmpty())
+		m_notEmpty.wait(&m_mutex);
+
+	Opening opening(m_queue.dequeue());
+	m_notFull.wakeOne();
+
+	return opening;
+}
+
+void OpeningPool::run()
+{
+	m_board = Chess::BoardFactory::create(m_variant);
+	Q_ASSERT(m_board != nullptr);
+
+	for (;;)
+	{
+		m_mutex.lock();
+		while (m_queue.size() >= m_capacity && !m_stopping)
+			m_notFull.wait(&m_mutex);
+		const bool stopping = m_stopping;
+		m_mutex.unlock();
+
+		if (stopping)
+			break;
+
+		Opening opening(prepare(m_suite->nextGame(m_maxPlies)));
+		if (m_suite->isStream())
+			opening.number = m_suite->openingNumber();
+
+		m_mutex.lock();
+		m_queue.enqueue(opening);
+		m_notEmpty.wakeOne();
+		m_mutex.unlock();
+	}
+
+	delete m_board;
+	m_board = nullptr;
+}
+
+OpeningPool::Opening OpeningPool::prepare(const PgnGame& game) const
+{
+	Opening opening;
+	opening.isValidated = true;
+	opening.isValid = false;
+	opening.number = 0;
+	opening.fen = game.startingFenString();
+
+	// The random starting position of a game is picked by ChessGame
+	if (opening.fen.isEmpty() && m_board->isRandomVariant())
+	{
+		opening.isValidated = false;
+		opening.game = game;
+		return opening;
+	}
+
+	// Validate the opening like ChessGame::setMoves() does
+	const QString fen(opening.fen.isEmpty() ?
+			  m_board->defaultFenString() : opening.fen);
+	if (!m_board->setFenString(fen))
+	{
+		qWarning("Invalid FEN string: %s", qUtf8Printable(fen));
+		opening.fen.clear();
+		return opening;
+	}
+	if (!opening.fen.isEmpty())
+		opening.fen = m_board->fenString();
+
+	for (const PgnGame::MoveData& md : game.moves())
+	{
+		Chess::Move move(m_board->moveFromGenericMove(md.move));
+		if (!m_board->isLegalMove(move))
+			return opening;
+
+		m_board->makeMove(move);
+		if (!m_board->result().isNone())
+			break;
+
+		opening.moves.append(move);
+	}
+
+	opening.isValid = true;
+	return opening;
+}
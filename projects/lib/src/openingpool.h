@@ -0,0 +1,124 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPENINGPOOL_H
+#define OPENINGPOOL_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QVector>
+#include "pgngame.h"
+#include "board/move.h"
+class OpeningSuite;
+namespace Chess { class Board; }
+
+/*!
+ * \brief A queue of openings prepared on a background thread
+ *
+ * OpeningPool reads openings from an OpeningSuite in its own thread
+ * and validates them for a chess variant, keeping a bounded queue of
+ * ready openings. Tournament games take their openings from the queue
+ * so that reading and replaying the openings doesn't delay the start
+ * of a game.
+ *
+ * The opening suite is used only by the pool's thread while the pool
+ * is running, and must outlive the pool.
+ *
+ * \sa OpeningSuite
+ */
+class LIB_EXPORT OpeningPool : public QThread
+{
+	public:
+		/*! An opening taken from the pool. */
+		struct Opening
+		{
+			/*!
+			 * True if the opening was validated by the pool.
+			 * Otherwise \a game must be validated by
+			 * ChessGame::setMoves().
+			 */
+			bool isValidated;
+			/*!
+			 * True if the opening is legal in the variant.
+			 * An invalid opening may still have some
+			 * legal moves.
+			 */
+			bool isValid;
+			/*!
+			 * The starting FEN string, or an empty string for
+			 * the variant's default starting position.
+			 */
+			QString fen;
+			/*! The opening moves. */
+			QVector<Chess::Move> moves;
+			/*! The opening game, if it wasn't validated. */
+			PgnGame game;
+			/*!
+			 * The number of the opening in a streamed suite,
+			 * or 0 if the suite isn't a stream.
+			 *
+			 * \sa OpeningSuite::openingNumber()
+			 */
+			int number;
+		};
+
+		/*!
+		 * Creates a new pool of openings from \a suite for
+		 * \a variant games.
+		 *
+		 * A maximum of \a maxPlies plies are read from an opening,
+		 * and at most \a capacity openings are kept in the queue.
+		 */
+		OpeningPool(OpeningSuite* suite,
+			    const QString& variant,
+			    int maxPlies,
+			    int capacity,
+			    QObject* parent = nullptr);
+		/*! Stops the pool and waits for its thread to finish. */
+		virtual ~OpeningPool();
+
+		/*!
+		 * Removes the next opening from the queue and returns it.
+		 * Waits until the pool's thread has prepared an opening
+		 * if the queue is empty.
+		 *
+		 * \note The pool must have been started.
+		 */
+		Opening take();
+
+	protected:
+		// Inherited from QThread
+		virtual void run();
+
+	private:
+		Opening prepare(const PgnGame& game) const;
+
+		OpeningSuite* m_suite;
+		QString m_variant;
+		int m_maxPlies;
+		int m_capacity;
+		Chess::Board* m_board;
+		bool m_stopping;
+		QQueue<Opening> m_queue;
+		QMutex m_mutex;
+		QWaitCondition m_notEmpty;
+		QWaitCondition m_notFull;
+};
+
+#endif // OPENINGPOOL_H
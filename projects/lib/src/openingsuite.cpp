@@ -17,11 +17,161 @@
 */
 
 #include "openingsuite.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <QFile>
-#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <cstring>
 #include "pgnstream.h"
+#include "pgnchunkreader.h"
 #include "epdrecord.h"
 #include "mersenne.h"
+#include "compressedfile.h"
+#include "streamdevice.h"
+#include "board/board.h"
+#include "board/boardfactory.h"
+
+namespace {
+
+// Smaller suites are scanned in one piece
+const qint64 s_minParallelSize = 4 * 1024 * 1024;
+
+typedef PgnChunkReader::Range Chunk;
+
+class IndexTask : public QRunnable
+{
+	public:
+		explicit IndexTask(const std::function<void()>& function)
+			: m_function(function)
+		{
+		}
+
+		// Inherited from QRunnable
+		virtual void run()
+		{
+			m_function();
+		}
+
+	private:
+		std::function<void()> m_function;
+};
+
+// Opens opening suite \a fileName. Plain files are opened as QFiles so
+// that PgnStream can map them into memory.
+QIODevice* openFile(const QString& fileName)
+{
+	QIODevice* file;
+	if (CompressedFile::detectCompression(fileName) == CompressedFile::NoCompression)
+		file = new QFile(fileName);
+	else
+		file = new CompressedFile(fileName);
+
+	if (!file->open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		delete file;
+		return nullptr;
+	}
+	return file;
+}
+
+qint64 nextPgnPos(PgnStream* stream)
+{
+	if (!stream->nextGame())
+		return -1;
+
+	const qint64 pos = stream->pos();
+
+	char c;
+	bool inTag = false;
+	bool inQuotes = false;
+
+	while ((c = stream->readChar()) != 0)
+	{
+		if (!inTag)
+		{
+			if (c == '[')
+				inTag = true;
+			else if (!isspace(c))
+			{
+				stream->rewindChar();
+				break;
+			}
+
+			continue;
+		}
+
+		if ((c == ']' && !inQuotes) || c == '\n' || c == '\r')
+		{
+			inTag = false;
+			inQuotes = false;
+		}
+		else if (c == '\"')
+			inQuotes = !inQuotes;
+	}
+
+	return pos;
+}
+
+// Returns the file positions of the openings that start in \a chunk.
+// EPD data is read from the memory mapping \a data if it's not null.
+QVector<qint64> scanChunk(const QString& fileName,
+			  OpeningSuite::Format format,
+			  const char* data,
+			  const Chunk& chunk,
+			  const QAtomicInt& canceled)
+{
+	QVector<qint64> positions;
+
+	if (format == OpeningSuite::EpdFormat && data != nullptr)
+	{
+		// Every line is an opening, like in OpeningSuite::getEpdPos()
+		qint64 pos = chunk.start;
+		while (pos < chunk.end && !canceled.loadAcquire())
+		{
+			positions.append(pos);
+			const char* nl = static_cast<const char*>(
+				memchr(data + pos, '\n', size_t(chunk.end - pos)));
+			if (nl == nullptr)
+				break;
+			pos = nl - data + 1;
+		}
+		return positions;
+	}
+
+	QScopedPointer<QIODevice> file(openFile(fileName));
+	if (file.isNull())
+		return positions;
+
+	if (format == OpeningSuite::PgnFormat)
+	{
+		PgnStream stream(file.data());
+		if (!stream.seek(chunk.start, -1))
+			return positions;
+
+		qint64 pos;
+		while (!canceled.loadAcquire()
+		&&  (pos = nextPgnPos(&stream)) != -1 && pos < chunk.end)
+			positions.append(pos);
+	}
+	else if (chunk.start == 0 || file->seek(chunk.start))
+	{
+		qint64 pos = file->pos();
+		while (pos < chunk.end && !canceled.loadAcquire()
+		&&  !file->readLine().isEmpty())
+		{
+			positions.append(pos);
+			pos = file->pos();
+		}
+	}
+
+	return positions;
+}
+
+} // anonymous namespace
 
 OpeningSuite::OpeningSuite(const QString& fen)
 	: m_format(EpdFormat),
@@ -29,10 +179,22 @@ OpeningSuite::OpeningSuite(const QString& fen)
 	  m_gamesRead(0),
 	  m_gameIndex(0),
 	  m_startIndex(0),
+	  m_sampleSize(0),
+	  m_uniquePositions(false),
+	  m_uniquePlies(0),
+	  m_duplicateCount(-1),
+	  m_isStream(false),
+	  m_openingNumber(0),
 	  m_fen(fen),
 	  m_file(nullptr),
-	  m_epdStream(nullptr),
-	  m_pgnStream(nullptr)
+	  m_epdData(nullptr),
+	  m_epdSize(0),
+	  m_epdPos(0),
+	  m_pgnStream(nullptr),
+	  m_board(nullptr),
+	  m_permutationBits(0),
+	  m_backgroundIndexing(false),
+	  m_indexPool(nullptr)
 {
 }
 
@@ -45,25 +207,30 @@ OpeningSuite::OpeningSuite(const QString& fileName,
 	  m_gamesRead(0),
 	  m_gameIndex(0),
 	  m_startIndex(startIndex),
+	  m_sampleSize(0),
+	  m_uniquePositions(false),
+	  m_uniquePlies(0),
+	  m_duplicateCount(-1),
+	  m_isStream(StreamDevice::isStream(fileName)),
+	  m_openingNumber(0),
 	  m_fileName(fileName),
 	  m_file(nullptr),
-	  m_epdStream(nullptr),
-	  m_pgnStream(nullptr)
+	  m_epdData(nullptr),
+	  m_epdSize(0),
+	  m_epdPos(0),
+	  m_pgnStream(nullptr),
+	  m_board(nullptr),
+	  m_permutationBits(0),
+	  m_backgroundIndexing(false),
+	  m_indexPool(nullptr)
 {
 }
 
 OpeningSuite::~OpeningSuite()
 {
-	if (m_epdStream != nullptr)
-	{
-		delete m_epdStream->device();
-		delete m_epdStream;
-	}
-	if (m_pgnStream != nullptr)
-	{
-		delete m_pgnStream->device();
-		delete m_pgnStream;
-	}
+	stopIndexing();
+	delete m_pgnStream;
+	delete m_file;
 }
 
 OpeningSuite::Format OpeningSuite::format() const
@@ -78,7 +245,61 @@ OpeningSuite::Order OpeningSuite::order() const
 
 bool OpeningSuite::isNull() const
 {
-	return m_epdStream == nullptr && m_pgnStream == nullptr;
+	return m_file == nullptr;
+}
+
+bool OpeningSuite::isStream() const
+{
+	return m_isStream;
+}
+
+int OpeningSuite::openingNumber() const
+{
+	return m_openingNumber;
+}
+
+void OpeningSuite::setSampleSize(int count)
+{
+	m_sampleSize = count;
+}
+
+void OpeningSuite::setUniquePositions(const QString& variant, int maxPlies)
+{
+	Q_ASSERT(maxPlies > 0);
+
+	m_uniquePositions = true;
+	m_uniquePlies = maxPlies;
+	m_variant = variant;
+}
+
+void OpeningSuite::setBackgroundIndexing(bool enabled)
+{
+	m_backgroundIndexing = enabled;
+}
+
+bool OpeningSuite::isIndexing() const
+{
+	return m_indexPool != nullptr && !m_indexReady.loadAcquire();
+}
+
+int OpeningSuite::openingCount() const
+{
+	if (isIndexing() || m_filePositions.isEmpty())
+		return -1;
+	return m_filePositions.count();
+}
+
+int OpeningSuite::duplicateCount() const
+{
+	return m_duplicateCount;
+}
+
+int OpeningSuite::indexFormat() const
+{
+	// A deduplicated index depends on the opening depth
+	if (m_uniquePositions)
+		return m_format | (m_uniquePlies << 8);
+	return m_format;
 }
 
 bool OpeningSuite::initialize()
@@ -86,78 +307,128 @@ bool OpeningSuite::initialize()
 	if (!m_fen.isEmpty())
 		return true;
 
+	stopIndexing();
 	m_gamesRead = 0;
 	m_gameIndex = 0;
+	m_duplicateCount = -1;
 	m_filePositions.clear();
 
-	if (m_epdStream != nullptr)
-	{
-		delete m_epdStream->device();
-		delete m_epdStream;
-		m_epdStream = nullptr;
-	}
-	if (m_pgnStream != nullptr)
+	delete m_pgnStream;
+	m_pgnStream = nullptr;
+	delete m_file;
+	m_file = nullptr;
+	m_epdData = nullptr;
+	m_epdSize = 0;
+	m_epdPos = 0;
+
+	if (m_isStream)
 	{
-		delete m_pgnStream->device();
-		delete m_pgnStream;
-		m_pgnStream = nullptr;
-	}
+		if (m_order == RandomOrder || m_uniquePositions)
+		{
+			qWarning("Openings streamed from %s can only be read "
+				 "in sequential order", qUtf8Printable(m_fileName));
+			return false;
+		}
 
-	m_file = new QFile(m_fileName);
-	if (!m_file->open(QIODevice::ReadOnly | QIODevice::Text))
+		StreamDevice* stream = new StreamDevice();
+		stream->open(m_fileName);
+		m_file = stream;
+	}
+	else
+		m_file = openFile(m_fileName);
+	if (m_file == nullptr)
 	{
 		qWarning("Can't open opening suite %s",
 			 qUtf8Printable(m_fileName));
-		delete m_file;
 		return false;
 	}
 
 	if (m_format == PgnFormat)
 		m_pgnStream = new PgnStream(m_file);
 
-	if (m_order == RandomOrder)
+	if (m_order == RandomOrder || m_uniquePositions)
 	{
-		// Create a shuffled vector of file positions
-		for (;;)
+		const bool indexed = m_filePositions.load(m_fileName, indexFormat());
+		if (!indexed && m_backgroundIndexing && m_order == RandomOrder
+		&&  !m_uniquePositions && m_sampleSize <= 0)
 		{
-			FilePosition pos;
-			if (m_format == EpdFormat)
-				pos = getEpdPos();
-			else if (m_format == PgnFormat)
-				pos = getPgnPos();
+			// Games are started with sequential openings while
+			// the index is built
+			for (quint32& key : m_permutationKeys)
+				key = Mersenne::random();
 
-			if (pos.pos == -1)
-				break;
+			m_indexPool = new QThreadPool;
+			m_indexPool->start(new IndexTask([this]()
+			{
+				indexFilePositions();
+				if (m_filePositions.isEmpty())
+					qWarning("No openings found in %s",
+						 qUtf8Printable(m_fileName));
+				initPermutation();
+				m_indexReady.storeRelease(1);
+			}));
+		}
+		else if (!indexed)
+		{
+			if (m_uniquePositions)
+			{
+				m_duplicateCount = 0;
+				if (m_format == EpdFormat)
+					m_board = Chess::BoardFactory::create(m_variant);
+			}
 
-			int i = Mersenne::random() % (m_filePositions.size() + 1);
-			if (i == m_filePositions.size())
-				m_filePositions.append(pos);
+			if (m_sampleSize > 0 && m_order == RandomOrder)
+				sampleFilePositions();
+			else if (m_uniquePositions)
+			{
+				qint64 pos;
+				while ((pos = nextIndexPos()) != -1)
+					m_filePositions.append(pos);
+				m_filePositions.save(m_fileName, indexFormat());
+			}
 			else
+				indexFilePositions();
+
+			delete m_board;
+			m_board = nullptr;
+			m_positionKeys = QSet<quint64>();
+		}
+
+		if (m_indexPool == nullptr)
+		{
+			if (m_filePositions.isEmpty())
 			{
-				m_filePositions.append(m_filePositions.at(i));
-				m_filePositions[i] = pos;
+				qWarning("No openings found in %s",
+					 qUtf8Printable(m_fileName));
+				return false;
 			}
+
+			initPermutation();
+			for (quint32& key : m_permutationKeys)
+				key = Mersenne::random();
+
+			if (m_order == SequentialOrder)
+				m_gameIndex = m_startIndex % m_filePositions.count();
 		}
 	}
 	else if (m_order == SequentialOrder)
 	{
 		for (int i = 0; i < m_startIndex; i++)
 		{
-			FilePosition pos;
-			if (m_format == EpdFormat)
-				pos = getEpdPos();
-			else if (m_format == PgnFormat)
-				pos = getPgnPos();
-
-			if (pos.pos == -1)
+			if (nextPos() == -1)
 				break;
 		}
 	}
 
-	if (m_format == EpdFormat)
+	if (m_format == EpdFormat && !m_isStream)
 	{
-		m_file->reset();
-		m_epdStream = new QTextStream(m_file);
+		// Plain EPD files are parsed straight from a memory mapping
+		QFile* file = qobject_cast<QFile*>(m_file);
+		if (file != nullptr && file->size() > 0)
+			m_epdData = file->map(0, file->size());
+		if (m_epdData != nullptr)
+			m_epdSize = file->size();
+		seekEpd(0);
 	}
 
 	return true;
@@ -175,33 +446,35 @@ PgnGame OpeningSuite::nextGame(int maxPlies)
 	if (isNull())
 		return game;
 
-	FilePosition pos = { -1, -1 };
-	if (m_order == RandomOrder)
+	// Until the index is ready the openings are read in sequence
+	const bool indexing = isIndexing();
+	qint64 pos = -1;
+	if (!indexing && !m_filePositions.isEmpty())
 	{
-		pos = m_filePositions.at(m_gameIndex++);
-		if (m_gameIndex >= m_filePositions.size())
+		if (m_order == RandomOrder)
+			pos = m_filePositions.at(randomIndex(m_gameIndex++));
+		else
+			pos = m_filePositions.at(m_gameIndex++);
+		if (m_gameIndex >= m_filePositions.count())
 			m_gameIndex = 0;
 	}
 
 	bool ok = false;
 	if (m_format == EpdFormat)
 	{
-		if (pos.pos != -1)
-		{
-			m_epdStream->seek(pos.pos);
-			m_epdStream->resetStatus();
-		}
+		if (pos != -1)
+			seekEpd(pos);
 
 		EpdRecord epd;
-		ok = epd.parse(*m_epdStream);
+		ok = readEpdRecord(&epd);
 
 		// Rewind the EPD input file
-		if (m_order == SequentialOrder
-		&&  !ok && m_gamesRead > 0 && m_epdStream->atEnd())
+		if (!m_isStream
+		&&  (m_order == SequentialOrder || indexing)
+		&&  !ok && m_gamesRead > 0 && atEpdEnd())
 		{
-			m_epdStream->seek(0);
-			m_epdStream->resetStatus();
-			ok = epd.parse(*m_epdStream);
+			seekEpd(0);
+			ok = readEpdRecord(&epd);
 		}
 
 		Chess::Side side(epd.fen().section(' ', 1, 1));
@@ -209,13 +482,16 @@ PgnGame OpeningSuite::nextGame(int maxPlies)
 	}
 	else if (m_format == PgnFormat)
 	{
-		if (pos.pos != -1)
-			m_pgnStream->seek(pos.pos, pos.lineNumber);
+		// The line number is only needed for warnings, so it's
+		// counted when it's asked for
+		if (pos != -1)
+			m_pgnStream->seek(pos, -1);
 
 		ok = game.read(*m_pgnStream, maxPlies);
 
 		// Rewind the PGN input file
-		if (m_order == SequentialOrder
+		if (!m_isStream
+		&&  (m_order == SequentialOrder || indexing)
 		&&  !ok && m_gamesRead > 0)
 		{
 			m_pgnStream->rewind();
@@ -225,63 +501,304 @@ PgnGame OpeningSuite::nextGame(int maxPlies)
 
 	if (ok)
 		m_gamesRead++;
+	if (m_isStream)
+	{
+		// A stream can't be rewound, so the remaining games start
+		// from the default position
+		if (!ok && m_openingNumber > 0)
+			qWarning("The opening stream %s has ended",
+				 qUtf8Printable(m_fileName));
+		m_openingNumber = ok ? m_startIndex + m_gamesRead : 0;
+	}
 	return game;
 }
 
-OpeningSuite::FilePosition OpeningSuite::getPgnPos()
+int OpeningSuite::randomIndex(int index) const
 {
-	FilePosition pos = { -1, -1 };
-	if (!m_pgnStream->nextGame())
-		return pos;
+	// A four-round Feistel network is a bijection on 2 * bits bits.
+	// Values outside the suite are walked through the permutation
+	// again until they land inside it.
+	const int bits = m_permutationBits;
+	const quint32 mask = (quint32(1) << bits) - 1;
+	quint32 value = quint32(index);
+	do
+	{
+		quint32 left = value >> bits;
+		quint32 right = value & mask;
+		for (quint32 key : m_permutationKeys)
+		{
+			quint32 f = (right ^ key) * 0x9E3779B1u;
+			f ^= f >> 15;
+			f *= 0x85EBCA77u;
+			f ^= f >> 13;
+
+			quint32 tmp = right;
+			right = (left ^ f) & mask;
+			left = tmp;
+		}
+		value = (left << bits) | right;
+	}
+	while (value >= quint32(m_filePositions.count()));
 
-	pos.pos = m_pgnStream->pos();
-	pos.lineNumber = m_pgnStream->lineNumber();
+	return int(value);
+}
 
-	char c;
-	bool inTag = false;
-	bool inQuotes = false;
+void OpeningSuite::initPermutation()
+{
+	// The openings are shuffled by a random permutation of
+	// the smallest power of 4 that covers them
+	m_permutationBits = 1;
+	while ((qint64(1) << (2 * m_permutationBits)) < m_filePositions.count())
+		m_permutationBits++;
+}
 
-	while ((c = m_pgnStream->readChar()) != 0)
+void OpeningSuite::indexFilePositions()
+{
+	// Plain files are mapped into memory and split into chunks
+	// that are indexed by parallel threads
+	QFile file(m_fileName);
+	const char* data = nullptr;
+	qint64 size = 0;
+	if (CompressedFile::detectCompression(m_fileName) == CompressedFile::NoCompression
+	&&  file.open(QIODevice::ReadOnly))
 	{
-		if (!inTag)
+		size = file.size();
+		if (size > 0)
+			data = reinterpret_cast<const char*>(file.map(0, size));
+	}
+
+	QVector<Chunk> chunks;
+	if (data != nullptr)
+	{
+		int count = 1;
+		if (size >= s_minParallelSize)
+			count = qMax(1, QThread::idealThreadCount());
+		chunks = PgnChunkReader::split(data, size, count,
+					       m_format == PgnFormat);
+	}
+	else
+	{
+		Chunk chunk = { 0, std::numeric_limits<qint64>::max() };
+		chunks.append(chunk);
+	}
+
+	QVector< QVector<qint64> > positions(chunks.size());
+	QVector<qint64>* results = positions.data();
+	QThreadPool pool;
+	pool.setMaxThreadCount(chunks.size());
+	for (int i = 1; i < chunks.size(); i++)
+	{
+		const Chunk chunk = chunks.at(i);
+		pool.start(new IndexTask([=]()
 		{
-			if (c == '[')
-				inTag = true;
-			else if (!isspace(c))
+			results[i] = scanChunk(m_fileName, m_format, data,
+					       chunk, m_indexCanceled);
+		}));
+	}
+	results[0] = scanChunk(m_fileName, m_format, data,
+			       chunks.first(), m_indexCanceled);
+	pool.waitForDone();
+
+	if (data != nullptr)
+		file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+
+	// A partial index isn't saved
+	if (m_indexCanceled.loadAcquire())
+		return;
+
+	for (const QVector<qint64>& chunkPositions : qAsConst(positions))
+	{
+		for (qint64 pos : chunkPositions)
+			m_filePositions.append(pos);
+	}
+	m_filePositions.save(m_fileName, indexFormat());
+}
+
+void OpeningSuite::stopIndexing()
+{
+	if (m_indexPool == nullptr)
+		return;
+
+	m_indexCanceled.storeRelease(1);
+	m_indexPool->waitForDone();
+	delete m_indexPool;
+	m_indexPool = nullptr;
+	m_indexCanceled.storeRelease(0);
+	m_indexReady.storeRelease(0);
+}
+
+qint64 OpeningSuite::nextPos()
+{
+	if (m_format == EpdFormat)
+		return getEpdPos();
+	if (m_format == PgnFormat)
+		return getPgnPos();
+	return -1;
+}
+
+qint64 OpeningSuite::nextIndexPos()
+{
+	if (m_uniquePositions)
+		return nextUniquePos();
+	return nextPos();
+}
+
+qint64 OpeningSuite::nextUniquePos()
+{
+	for (;;)
+	{
+		qint64 pos = -1;
+		quint64 key = 0;
+
+		if (m_format == EpdFormat)
+		{
+			QByteArray line;
+			pos = getEpdPos(&line);
+			if (pos == -1)
+				return -1;
+
+			EpdRecord epd;
+			if (m_board == nullptr
+			||  !epd.parse(line)
+			||  !m_board->setFenString(epd.fen()))
+				continue;
+			key = m_board->key();
+		}
+		else if (m_format == PgnFormat)
+		{
+			if (!m_pgnStream->nextGame())
+				return -1;
+			pos = m_pgnStream->pos();
+
+			PgnGame game;
+			if (!game.read(*m_pgnStream, m_uniquePlies, false))
+				continue;
+
+			if (!game.moves().isEmpty())
+				key = m_pgnStream->board()->key();
+			else
 			{
-				m_pgnStream->rewindChar();
-				break;
+				Chess::Board* board = game.createBoard();
+				if (board == nullptr)
+					continue;
+				key = board->key();
+				delete board;
 			}
+		}
+		else
+			return -1;
 
+		if (m_positionKeys.contains(key))
+		{
+			m_duplicateCount++;
 			continue;
 		}
+		m_positionKeys.insert(key);
+		return pos;
+	}
+}
 
-		if ((c == ']' && !inQuotes) || c == '\n' || c == '\r')
+void OpeningSuite::sampleFilePositions()
+{
+	// Reservoir sampling picks every opening with equal probability
+	// in a single pass
+	QVector<qint64> sample;
+	sample.reserve(m_sampleSize);
+
+	qint64 pos;
+	quint32 seen = 0;
+	while ((pos = nextIndexPos()) != -1)
+	{
+		if (sample.size() < m_sampleSize)
+			sample.append(pos);
+		else
 		{
-			inTag = false;
-			inQuotes = false;
+			const quint32 i = Mersenne::random() % (seen + 1);
+			if (i < quint32(m_sampleSize))
+				sample[int(i)] = pos;
 		}
-		else if (c == '\"')
-			inQuotes = !inQuotes;
+		seen++;
 	}
 
-	return pos;
+	// Sorted positions are stored in the least space
+	std::sort(sample.begin(), sample.end());
+	for (qint64 samplePos : qAsConst(sample))
+		m_filePositions.append(samplePos);
+}
+
+qint64 OpeningSuite::getPgnPos()
+{
+	return nextPgnPos(m_pgnStream);
+}
+
+void OpeningSuite::seekEpd(qint64 pos)
+{
+	if (m_epdData != nullptr)
+		m_epdPos = pos;
+	else
+		m_file->seek(pos);
+}
+
+bool OpeningSuite::atEpdEnd() const
+{
+	if (m_epdData != nullptr)
+		return m_epdPos >= m_epdSize;
+	return m_file->atEnd();
+}
+
+bool OpeningSuite::readEpdRecord(EpdRecord* record)
+{
+	while (!atEpdEnd())
+	{
+		QByteArray line;
+		if (m_epdData != nullptr)
+		{
+			const char* data = reinterpret_cast<const char*>(m_epdData);
+			const char* start = data + m_epdPos;
+			const char* end = static_cast<const char*>(
+				memchr(start, '\n', size_t(m_epdSize - m_epdPos)));
+			if (end == nullptr)
+				end = data + m_epdSize;
+			m_epdPos = end - data + 1;
+
+			if (end > start && end[-1] == '\r')
+				end--;
+			line = QByteArray::fromRawData(start, int(end - start));
+		}
+		else
+			line = m_file->readLine();
+
+		if (record->parse(line))
+			return true;
+
+		// Skip empty lines
+		for (char c : qAsConst(line))
+		{
+			if (!isspace(uchar(c)))
+				return false;
+		}
+	}
+
+	return false;
 }
 
-OpeningSuite::FilePosition OpeningSuite::getEpdPos()
+qint64 OpeningSuite::getEpdPos(QByteArray* line)
 {
-	FilePosition pos = { m_file->pos(), -1 };
+	qint64 pos = m_file->pos();
 
-	while (m_file->readLine().isEmpty())
+	QByteArray tmp;
+	while ((tmp = m_file->readLine()).isEmpty())
 	{
 		if (m_file->atEnd())
 		{
-			pos.pos = -1;
+			pos = -1;
 			break;
 		}
 		else
-			pos.pos = m_file->pos();
+			pos = m_file->pos();
 	}
 
+	if (line != nullptr)
+		*line = tmp;
 	return pos;
 }
@@ -19,12 +19,16 @@
 #ifndef OPENINGSUITE_H
 #define OPENINGSUITE_H
 
-#include <QVector>
 #include "pgngame.h"
+#include "openingindex.h"
+#include <QSet>
+#include <QAtomicInt>
 class QString;
-class QFile;
-class QTextStream;
+class QIODevice;
+class QThreadPool;
 class PgnStream;
+class EpdRecord;
+namespace Chess { class Board; }
 
 /*!
  * \brief A suite of chess openings
@@ -60,8 +64,16 @@ class LIB_EXPORT OpeningSuite
 		OpeningSuite(const QString& fen);
 		/*!
 		 * Creates a new opening suite that reads the openings
-		 * from \a fileName in \a format format.
+		 * from \a fileName in \a format format. The file may be
+		 * compressed with gzip or Zstandard.
 		 *
+		 * \a fileName can also be a stream that is read as it
+		 * arrives, eg. from a generator process: "-" for the
+		 * standard input, a named pipe, or "tcp://HOST:PORT".
+		 * A stream can only be read once in sequential order,
+		 * without compression.
+		 *
+		 * \sa StreamDevice
 		 * Openings will be picked according to \a order.
 		 *
 		 * If \a order is \a SequentialOrder, \a startIndex will
@@ -87,6 +99,73 @@ class LIB_EXPORT OpeningSuite
 		 * returns false.
 		 */
 		bool isNull() const;
+		/*!
+		 * Returns true if the openings are read from a stream
+		 * instead of a file; otherwise returns false.
+		 */
+		bool isStream() const;
+		/*!
+		 * Returns the number of the opening returned by the last
+		 * call to nextGame() in a stream, counted from 1 including
+		 * the openings skipped by the start index. Returns 0 if
+		 * the suite isn't a stream or the stream has ended.
+		 */
+		int openingNumber() const;
+		/*!
+		 * Keeps a random sample of at most \a count openings in
+		 * memory when the order is RandomOrder and the suite has
+		 * no valid index cache. With \a count of 0 (the default)
+		 * every opening is indexed.
+		 *
+		 * A sampled index isn't saved to the cache. This function
+		 * must be called before initialize().
+		 */
+		void setSampleSize(int count);
+		/*!
+		 * Skips openings that lead to a position already reached
+		 * by an earlier opening in the suite. Positions are
+		 * compared by the Zobrist key of the opening's final
+		 * position after at most \a maxPlies plies. EPD positions
+		 * are set up on a board of \a variant.
+		 *
+		 * The suite is indexed in one pass that keeps only the
+		 * file positions and the keys of the unique openings, and
+		 * the index is cached like the index of a RandomOrder
+		 * suite. This function must be called before initialize().
+		 */
+		void setUniquePositions(const QString& variant, int maxPlies);
+		/*!
+		 * If \a enabled is true, initialize() doesn't wait for the
+		 * index of a RandomOrder suite to be built. The index is
+		 * built by a background thread, and until it's ready the
+		 * openings are read in sequential order from the start of
+		 * the suite. The default is false.
+		 *
+		 * Which openings are played before the index is ready
+		 * depends on timing, so the openings can't be reproduced
+		 * with the same random seed. Suites with unique positions
+		 * or a sample size are always indexed by initialize().
+		 * This function must be called before initialize().
+		 */
+		void setBackgroundIndexing(bool enabled);
+		/*!
+		 * Returns true if the index of the suite is still being
+		 * built in the background; otherwise returns false.
+		 */
+		bool isIndexing() const;
+		/*!
+		 * Returns the number of indexed openings, or -1 if the
+		 * suite isn't indexed or the index isn't ready yet. With
+		 * unique positions this is the number of unique positions
+		 * in the suite.
+		 */
+		int openingCount() const;
+		/*!
+		 * Returns the number of duplicate openings skipped when
+		 * the suite was indexed, or -1 if the index was loaded
+		 * from the cache or positions aren't deduplicated.
+		 */
+		int duplicateCount() const;
 
 		/*!
 		 * Initializes the opening suite.
@@ -95,7 +174,12 @@ class LIB_EXPORT OpeningSuite
 		 * the opening suite file and gets ready to read data. If
 		 * \a order is RandomOrder, the file positions of all the
 		 * openings are parsed from the file, which could take some
-		 * time if the file is large.
+		 * time if the file is large. Uncompressed files are split
+		 * into chunks that are parsed by parallel threads. The
+		 * positions are cached in an OpeningIndex file, so later
+		 * runs only parse the file again if it has changed.
+		 *
+		 * \sa setBackgroundIndexing()
 		 *
 		 * Returns true if successful; otherwise returns false.
 		 */
@@ -107,26 +191,49 @@ class LIB_EXPORT OpeningSuite
 		PgnGame nextGame(int maxPlies);
 
 	private:
-		struct FilePosition
-		{
-			qint64 pos;
-			qint64 lineNumber;
-		};
-
-		FilePosition getPgnPos();
-		FilePosition getEpdPos();
+		qint64 getPgnPos();
+		qint64 getEpdPos(QByteArray* line = nullptr);
+		void seekEpd(qint64 pos);
+		bool atEpdEnd() const;
+		bool readEpdRecord(EpdRecord* record);
+		qint64 nextPos();
+		qint64 nextUniquePos();
+		qint64 nextIndexPos();
+		int indexFormat() const;
+		void indexFilePositions();
+		void initPermutation();
+		void stopIndexing();
+		void sampleFilePositions();
+		int randomIndex(int index) const;
 
 		Format m_format;
 		Order m_order;
 		int m_gamesRead;
 		int m_gameIndex;
 		int m_startIndex;
+		int m_sampleSize;
+		bool m_uniquePositions;
+		int m_uniquePlies;
+		int m_duplicateCount;
+		bool m_isStream;
+		int m_openingNumber;
+		QString m_variant;
+		Chess::Board* m_board;
+		QSet<quint64> m_positionKeys;
 		QString m_fileName;
 		QString m_fen;
-		QFile* m_file;
-		QTextStream* m_epdStream;
+		QIODevice* m_file;
+		const uchar* m_epdData;
+		qint64 m_epdSize;
+		qint64 m_epdPos;
 		PgnStream* m_pgnStream;
-		QVector<FilePosition> m_filePositions;
+		OpeningIndex m_filePositions;
+		int m_permutationBits;
+		quint32 m_permutationKeys[4];
+		bool m_backgroundIndexing;
+		QThreadPool* m_indexPool;
+		QAtomicInt m_indexReady;
+		QAtomicInt m_indexCanceled;
 };
 
 #endif // OPENINGSUITE_H
@@ -0,0 +1,109 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "outputqueue.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+
+OutputQueue::OutputQueue(int capacity, QObject* parent)
+	: QThread(parent),
+	  m_capacity(qMax(1, capacity)),
+	  m_stopping(false),
+	  m_busy(false),
+	  m_jobs(0),
+	  m_maxDepth(0),
+	  m_waitTime(0)
+{
+	setObjectName("Output queue");
+}
+
+OutputQueue::~OutputQueue()
+{
+	m_mutex.lock();
+	m_stopping = true;
+	m_notEmpty.wakeAll();
+	m_mutex.unlock();
+
+	wait();
+}
+
+void OutputQueue::post(const std::function<void()>& job)
+{
+	QMutexLocker locker(&m_mutex);
+	if (!isRunning())
+		start();
+
+	if (m_queue.size() >= m_capacity)
+	{
+		QElapsedTimer timer;
+		timer.start();
+		while (m_queue.size() >= m_capacity)
+			m_notFull.wait(&m_mutex);
+		m_waitTime += timer.nsecsElapsed();
+	}
+
+	m_queue.enqueue(job);
+	m_maxDepth = qMax(m_maxDepth, m_queue.size());
+	m_notEmpty.wakeOne();
+}
+
+void OutputQueue::waitForDone()
+{
+	QMutexLocker locker(&m_mutex);
+	while (!m_queue.isEmpty() || m_busy)
+		m_done.wait(&m_mutex);
+}
+
+OutputQueue::Statistics OutputQueue::statistics() const
+{
+	QMutexLocker locker(&m_mutex);
+
+	Statistics stats;
+	stats.jobs = m_jobs;
+	stats.depth = m_queue.size();
+	stats.maxDepth = m_maxDepth;
+	stats.capacity = m_capacity;
+	stats.waitTime = m_waitTime;
+	return stats;
+}
+
+void OutputQueue::run()
+{
+	QMutexLocker locker(&m_mutex);
+	for (;;)
+	{
+		while (m_queue.isEmpty() && !m_stopping)
+			m_notEmpty.wait(&m_mutex);
+
+		// The remaining jobs are run before stopping
+		if (m_queue.isEmpty())
+			break;
+
+		const std::function<void()> job(m_queue.dequeue());
+		m_busy = true;
+		m_notFull.wakeOne();
+		locker.unlock();
+
+		job();
+
+		locker.relock();
+		m_busy = false;
+		m_jobs++;
+		if (m_queue.isEmpty())
+			m_done.wakeAll();
+	}
+}
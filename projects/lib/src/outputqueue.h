@@ -0,0 +1,92 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OUTPUTQUEUE_H
+#define OUTPUTQUEUE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <functional>
+
+/*!
+ * \brief A bounded queue of output jobs run on a background thread
+ *
+ * OutputQueue runs jobs, typically writes to output files, one at a
+ * time in the order they were posted. The thread that posts the jobs
+ * doesn't wait for slow file systems, unless the queue is full: then
+ * post() blocks until the oldest job has started, so that a file
+ * system that can't keep up doesn't make the queue grow without
+ * limits.
+ *
+ * The thread is started when the first job is posted.
+ */
+class LIB_EXPORT OutputQueue : public QThread
+{
+	public:
+		/*! Statistics of the queue. */
+		struct Statistics
+		{
+			qint64 jobs;		//!< Number of finished jobs
+			int depth;		//!< Number of waiting jobs
+			int maxDepth;		//!< Maximum number of waiting jobs
+			int capacity;		//!< Capacity of the queue
+			qint64 waitTime;	//!< Time spent in a full post(), in ns
+		};
+
+		/*!
+		 * Creates a new queue that holds at most \a capacity
+		 * waiting jobs.
+		 */
+		explicit OutputQueue(int capacity, QObject* parent = nullptr);
+		/*!
+		 * Runs the remaining jobs and waits for the thread to
+		 * finish.
+		 */
+		virtual ~OutputQueue();
+
+		/*!
+		 * Adds \a job to the queue. Waits for free space if the
+		 * queue is full.
+		 */
+		void post(const std::function<void()>& job);
+		/*! Waits until all posted jobs have been run. */
+		void waitForDone();
+
+		/*! Returns the current statistics of the queue. */
+		Statistics statistics() const;
+
+	protected:
+		// Inherited from QThread
+		virtual void run();
+
+	private:
+		int m_capacity;
+		bool m_stopping;
+		bool m_busy;
+		qint64 m_jobs;
+		int m_maxDepth;
+		qint64 m_waitTime;
+		QQueue< std::function<void()> > m_queue;
+		mutable QMutex m_mutex;
+		QWaitCondition m_notEmpty;
+		QWaitCondition m_notFull;
+		QWaitCondition m_done;
+};
+
+#endif // OUTPUTQUEUE_H
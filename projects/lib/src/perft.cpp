@@ -0,0 +1,289 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "perft.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QScopedPointer>
+#include "board/board.h"
+#include "board/boardfactory.h"
+
+
+class Perft::HashTable
+{
+	public:
+		explicit HashTable(int megabytes)
+			: m_mask(0)
+		{
+			// The largest power of two that fits in the given size
+			quint64 size = 1;
+			const quint64 bytes = quint64(megabytes) << 20;
+			while (2 * size * sizeof(Slot) <= bytes)
+				size *= 2;
+			m_slots = new Slot[size];
+			m_mask = size - 1;
+		}
+
+		~HashTable()
+		{
+			delete[] m_slots;
+		}
+
+		// Stores the check word xored with the data so that an entry
+		// torn by a concurrent write is rejected instead of misread
+		bool probe(quint64 key, int depth, quint64* nodes) const
+		{
+			const Slot& slot = m_slots[key & m_mask];
+			const quint64 data = slot.data.loadAcquire();
+			const quint64 check = slot.check.loadAcquire();
+
+			if ((check ^ data) != key || int(data & 0xff) != depth)
+				return false;
+			*nodes = data >> 8;
+			return true;
+		}
+
+		void insert(quint64 key, int depth, quint64 nodes)
+		{
+			const quint64 data = (nodes << 8) | quint64(depth);
+			Slot& slot = m_slots[key & m_mask];
+			slot.check.storeRelease(key ^ data);
+			slot.data.storeRelease(data);
+		}
+
+	private:
+		struct Slot
+		{
+			QAtomicInteger<quint64> check;
+			QAtomicInteger<quint64> data;
+		};
+
+		Slot* m_slots;
+		quint64 m_mask;
+};
+
+namespace {
+
+// The Zobrist key mixed with the variant state outside the key. The
+// state is scrambled first because its bits are usually few and low.
+quint64 positionKey(Chess::Board* board)
+{
+	quint64 state = board->stateKey();
+	if (state == 0)
+		return board->key();
+
+	state ^= state >> 33;
+	state *= Q_UINT64_C(0xff51afd7ed558ccd);
+	state ^= state >> 33;
+	state *= Q_UINT64_C(0xc4ceb9fe1a85ec53);
+	state ^= state >> 33;
+	return board->key() ^ state;
+}
+
+} // anonymous namespace
+
+/*!
+ * Takes root moves from a shared counter until all of them have been
+ * counted, so that the threads stay busy even if the subtrees have
+ * very different sizes.
+ */
+class Perft::Task : public QRunnable
+{
+	public:
+		Task(Chess::Board* board,
+		     int depth,
+		     const Chess::MoveList& rootMoves,
+		     QAtomicInt* nextMove,
+		     quint64* counts,
+		     HashTable* table)
+			: m_board(board),
+			  m_depth(depth),
+			  m_rootMoves(rootMoves),
+			  m_nextMove(nextMove),
+			  m_counts(counts),
+			  m_table(table)
+		{
+		}
+
+		static quint64 perft(Chess::Board* board, int depth, HashTable* table)
+		{
+			Chess::MoveList moves;
+			board->legalMoves(moves);
+			if (depth <= 1 || moves.isEmpty())
+				return depth <= 0 ? 1 : quint64(moves.size());
+
+			quint64 key = 0;
+			quint64 nodes = 0;
+			if (table != nullptr)
+			{
+				key = positionKey(board);
+				if (table->probe(key, depth, &nodes))
+					return nodes;
+			}
+
+			for (const Chess::Move& move : qAsConst(moves))
+			{
+				board->makeMove(move);
+				nodes += perft(board, depth - 1, table);
+				board->undoMove();
+			}
+
+			if (table != nullptr)
+				table->insert(key, depth, nodes);
+			return nodes;
+		}
+
+		// Inherited from QRunnable
+		virtual void run()
+		{
+			for (;;)
+			{
+				const int i = m_nextMove->fetchAndAddRelaxed(1);
+				if (i >= m_rootMoves.size())
+					break;
+
+				m_board->makeMove(m_rootMoves.at(i));
+				m_counts[i] = perft(m_board.data(), m_depth - 1,
+						    m_table);
+				m_board->undoMove();
+			}
+		}
+
+	private:
+		QScopedPointer<Chess::Board> m_board;
+		int m_depth;
+		const Chess::MoveList& m_rootMoves;
+		QAtomicInt* m_nextMove;
+		quint64* m_counts;
+		HashTable* m_table;
+};
+
+Perft::Perft()
+	: m_board(nullptr),
+	  m_threadCount(QThread::idealThreadCount()),
+	  m_hashSize(64),
+	  m_table(nullptr)
+{
+}
+
+Perft::~Perft()
+{
+	delete m_board;
+	delete m_table;
+}
+
+bool Perft::setPosition(const QString& variant, const QString& fen)
+{
+	QScopedPointer<Chess::Board> board(BoardFactory::create(variant));
+	if (board.isNull())
+	{
+		m_error = QString("Unknown variant: %1").arg(variant);
+		return false;
+	}
+
+	board->initialize();
+	const QString startFen(fen.isEmpty() ? board->defaultFenString() : fen);
+	if (!board->setFenString(startFen))
+	{
+		m_error = QString("Invalid FEN string: %1").arg(startFen);
+		return false;
+	}
+
+	// Counts stored for another variant would be found by the
+	// same keys
+	if (m_board != nullptr && m_board->variant() != board->variant())
+	{
+		delete m_table;
+		m_table = nullptr;
+	}
+
+	delete m_board;
+	m_board = board.take();
+	m_error.clear();
+	return true;
+}
+
+void Perft::setThreadCount(int count)
+{
+	m_threadCount = qMax(1, count);
+}
+
+void Perft::setHashSize(int megabytes)
+{
+	m_hashSize = qMax(0, megabytes);
+	delete m_table;
+	m_table = nullptr;
+}
+
+QString Perft::errorString() const
+{
+	return m_error;
+}
+
+quint64 Perft::count(int depth)
+{
+	Q_ASSERT(m_board != nullptr);
+
+	if (depth <= 1)
+		return Task::perft(m_board, depth, nullptr);
+
+	quint64 nodes = 0;
+	const auto rootMoves = divide(depth);
+	for (const RootMove& rootMove : rootMoves)
+		nodes += rootMove.nodes;
+	return nodes;
+}
+
+QVector<Perft::RootMove> Perft::divide(int depth)
+{
+	Q_ASSERT(m_board != nullptr);
+
+	Chess::MoveList rootMoves;
+	m_board->legalMoves(rootMoves);
+
+	// Only positions with at least two plies left are stored
+	if (m_table == nullptr && m_hashSize > 0 && depth > 2)
+		m_table = new HashTable(m_hashSize);
+
+	QVector<quint64> counts(rootMoves.size(), 1);
+	if (depth > 1)
+	{
+		QThreadPool pool;
+		pool.setMaxThreadCount(m_threadCount);
+		QAtomicInt nextMove(0);
+
+		const int taskCount = qMin(m_threadCount, rootMoves.size());
+		for (int i = 0; i < taskCount; i++)
+			pool.start(new Task(m_board->copy(), depth, rootMoves,
+					    &nextMove, counts.data(), m_table));
+		pool.waitForDone();
+	}
+
+	QVector<RootMove> result;
+	result.reserve(rootMoves.size());
+	for (int i = 0; i < rootMoves.size(); i++)
+	{
+		const QString move(m_board->moveString(rootMoves.at(i),
+						       Chess::Board::LongAlgebraic));
+		result.append({ move, depth <= 0 ? 0 : counts.at(i) });
+	}
+	return result;
+}
@@ -0,0 +1,104 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <QString>
+#include <QVector>
+namespace Chess { class Board; }
+
+/*!
+ * \brief Counts the leaf nodes of a move generation tree
+ *
+ * Perft walks every legal move sequence from a position up to a
+ * fixed depth and counts the positions at the last ply. The counts
+ * are used to verify move generators against each other, so Perft
+ * works with every variant supported by BoardFactory.
+ *
+ * The root moves are split between a pool of worker threads, each
+ * walking its own copy of the board. The workers share a lock-free
+ * transposition table of subtree counts. The table is keyed by the
+ * Zobrist key mixed with Chess::Board::stateKey(), which covers the
+ * variant state outside the Zobrist key, eg. the remaining checks of
+ * N-check chess. All variants use the same Zobrist keys, so the table
+ * is cleared when the variant changes.
+ */
+class LIB_EXPORT Perft
+{
+	public:
+		/*! The node count of a root move. */
+		struct RootMove
+		{
+			/*! The move in long algebraic notation. */
+			QString move;
+			/*! The number of leaf nodes below the move. */
+			quint64 nodes;
+		};
+
+		/*! Creates a new Perft object. */
+		Perft();
+		/*! Destroys the Perft object and its hash table. */
+		~Perft();
+
+		/*!
+		 * Sets the position to \a fen in chess variant \a variant.
+		 * An empty \a fen selects the variant's starting position.
+		 *
+		 * Returns false and sets errorString() if the variant or
+		 * the position is invalid.
+		 */
+		bool setPosition(const QString& variant, const QString& fen);
+		/*!
+		 * Sets the number of worker threads to \a count.
+		 * The default is the number of CPU cores.
+		 */
+		void setThreadCount(int count);
+		/*!
+		 * Sets the size of the transposition table to \a megabytes.
+		 * A size of 0 disables the table. The default is 64 MB.
+		 */
+		void setHashSize(int megabytes);
+		/*! Returns the last error, or an empty string. */
+		QString errorString() const;
+
+		/*!
+		 * Returns the number of leaf nodes \a depth plies below
+		 * the position.
+		 */
+		quint64 count(int depth);
+		/*!
+		 * Returns the number of leaf nodes below each legal move
+		 * of the position, \a depth plies deep counting the move.
+		 */
+		QVector<RootMove> divide(int depth);
+
+	private:
+		Q_DISABLE_COPY(Perft)
+
+		class HashTable;
+		class Task;
+
+		Chess::Board* m_board;
+		int m_threadCount;
+		int m_hashSize;
+		HashTable* m_table;
+		QString m_error;
+};
+
+#endif // PERFT_H
@@ -0,0 +1,333 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgnchunkreader.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <QFile>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QMap>
+#include "compressedfile.h"
+
+namespace {
+
+typedef PgnChunkReader::Chunk Chunk;
+typedef PgnChunkReader::Collector Collector;
+typedef PgnChunkReader::Parser Parser;
+
+/*!
+ * The collectors of the chunks parsed by worker threads, waiting to be
+ * called in the same order as the chunks were read.
+ */
+class CollectorQueue
+{
+	public:
+		CollectorQueue()
+			: m_nextTask(0),
+			  m_nextResult(0),
+			  m_pending(0)
+		{
+		}
+
+		int addTask()
+		{
+			QMutexLocker locker(&m_mutex);
+			m_pending++;
+			return m_nextTask++;
+		}
+		void finishTask(int index, const Collector& collector)
+		{
+			QMutexLocker locker(&m_mutex);
+			m_results.insert(index, collector);
+			m_pending--;
+			m_ready.wakeOne();
+		}
+		int pendingCount()
+		{
+			QMutexLocker locker(&m_mutex);
+			return m_pending + m_results.size();
+		}
+		// Waits until the next chunk is ready if \a wait is true
+		bool take(Collector* collector, bool wait)
+		{
+			QMutexLocker locker(&m_mutex);
+			while (wait && !m_results.contains(m_nextResult) && m_pending > 0)
+				m_ready.wait(&m_mutex);
+			if (!m_results.contains(m_nextResult))
+				return false;
+
+			*collector = m_results.take(m_nextResult++);
+			return true;
+		}
+
+	private:
+		QMutex m_mutex;
+		QWaitCondition m_ready;
+		QMap<int, Collector> m_results;
+		int m_nextTask;
+		int m_nextResult;
+		int m_pending;
+};
+
+class ParseTask : public QRunnable
+{
+	public:
+		ParseTask(const Chunk& chunk,
+			  int index,
+			  const Parser& parser,
+			  CollectorQueue* queue)
+			: m_chunk(chunk),
+			  m_index(index),
+			  m_parser(parser),
+			  m_queue(queue)
+		{
+		}
+
+		// Inherited from QRunnable
+		virtual void run()
+		{
+			m_queue->finishTask(m_index, m_parser(m_chunk));
+		}
+
+	private:
+		Chunk m_chunk;
+		int m_index;
+		Parser m_parser;
+		CollectorQueue* m_queue;
+};
+
+// Returns true if the line ending just before index \a pos is empty
+// or contains only white space. PGN games are separated by such lines.
+bool followsEmptyLine(const char* data, qint64 pos)
+{
+	for (qint64 i = pos - 2; i >= 0 && data[i] != '\n'; i--)
+	{
+		if (data[i] != ' ' && data[i] != '\t' && data[i] != '\r')
+			return false;
+	}
+	return true;
+}
+
+} // anonymous namespace
+
+PgnChunkReader::PgnChunkReader()
+	: m_chunkSize(4 * 1024 * 1024),
+	  m_map(nullptr),
+	  m_mapSize(0),
+	  m_mapPos(0),
+	  m_lineNumber(1)
+{
+}
+
+PgnChunkReader::~PgnChunkReader()
+{
+	close();
+}
+
+int PgnChunkReader::chunkSize() const
+{
+	return m_chunkSize;
+}
+
+void PgnChunkReader::setChunkSize(int bytes)
+{
+	Q_ASSERT(bytes > 0);
+	m_chunkSize = bytes;
+}
+
+bool PgnChunkReader::open(const QString& fileName, QIODevice::OpenMode mode)
+{
+	close();
+	m_fileName = fileName;
+
+	const bool compressed =
+		CompressedFile::detectCompression(fileName) != CompressedFile::NoCompression;
+	if (compressed)
+		m_file.reset(new CompressedFile(fileName));
+	else
+		m_file.reset(new QFile(fileName));
+	if (!m_file->open(mode))
+	{
+		qWarning("Can't open PGN file %s", qUtf8Printable(fileName));
+		m_file.reset();
+		return false;
+	}
+
+	// Mapped data isn't translated like text mode reads
+	if (!compressed && !(mode & QIODevice::Text))
+	{
+		QFile* file = static_cast<QFile*>(m_file.data());
+		if (file->size() > 0)
+			m_map = reinterpret_cast<const char*>(file->map(0, file->size()));
+		if (m_map != nullptr)
+			m_mapSize = file->size();
+	}
+
+	return true;
+}
+
+void PgnChunkReader::close()
+{
+	// Closing the file unmaps it
+	m_file.reset();
+	m_map = nullptr;
+	m_mapSize = 0;
+	m_mapPos = 0;
+	m_rest.clear();
+	m_lineNumber = 1;
+}
+
+QString PgnChunkReader::fileName() const
+{
+	return m_fileName;
+}
+
+bool PgnChunkReader::readChunk(Chunk* chunk)
+{
+	if (m_file.isNull())
+		return false;
+
+	if (m_map != nullptr)
+	{
+		if (m_mapPos >= m_mapSize)
+			return false;
+
+		// Split the mapping at the start of a game
+		qint64 end = m_mapSize;
+		if (m_mapSize - m_mapPos > m_chunkSize)
+		{
+			const qint64 from = m_mapPos + m_chunkSize;
+			const QByteArray rest(QByteArray::fromRawData(
+				m_map + from, int(qMin(m_mapSize - from, qint64(INT_MAX)))));
+			const int index = rest.indexOf("\n[Event ");
+			if (index >= 0)
+				end = from + index + 1;
+		}
+		end = qMin(end, m_mapPos + INT_MAX);
+
+		chunk->data = QByteArray::fromRawData(m_map + m_mapPos,
+						      int(end - m_mapPos));
+		m_mapPos = end;
+	}
+	else
+	{
+		QByteArray data(m_rest);
+		m_rest.clear();
+		for (;;)
+		{
+			const QByteArray read(m_file->read(m_chunkSize));
+			if (read.isEmpty())
+				break;
+			data += read;
+
+			// Split the input at the start of the last game,
+			// unless the whole file has been read
+			const int index = data.lastIndexOf("\n[Event ");
+			if (index < 0)
+				continue;
+			m_rest = data.mid(index + 1);
+			data.truncate(index + 1);
+			break;
+		}
+		if (data.isEmpty())
+			return false;
+
+		chunk->data = data;
+	}
+
+	chunk->lineNumber = m_lineNumber;
+	m_lineNumber += std::count(chunk->data.constBegin(),
+				   chunk->data.constEnd(), '\n');
+	return true;
+}
+
+void PgnChunkReader::process(const Parser& parser, int threadCount)
+{
+	threadCount = qMax(1, threadCount);
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(threadCount);
+	CollectorQueue queue;
+
+	Collector collector;
+	auto collect = [&](bool wait)
+	{
+		while (queue.take(&collector, wait))
+		{
+			collector();
+			wait = false;
+		}
+	};
+
+	Chunk chunk;
+	while (readChunk(&chunk))
+	{
+		// Keep a bounded number of chunks in memory
+		while (queue.pendingCount() >= 2 * threadCount)
+			collect(true);
+
+		const int index = queue.addTask();
+		pool.start(new ParseTask(chunk, index, parser, &queue));
+		collect(false);
+	}
+
+	// The tasks may read the mapping, which is unmapped with the file
+	pool.waitForDone();
+	collect(false);
+}
+
+QVector<PgnChunkReader::Range> PgnChunkReader::split(const char* data,
+						     qint64 size,
+						     int count,
+						     bool pgn)
+{
+	QVector<Range> ranges;
+	Range range = { 0, size };
+	ranges.append(range);
+
+	for (int i = 1; i < count; i++)
+	{
+		qint64 pos = qMax(size * i / count, ranges.last().start + 1);
+		while (pos < size)
+		{
+			const char* nl = static_cast<const char*>(
+				memchr(data + pos, '\n', size_t(size - pos)));
+			if (nl == nullptr)
+			{
+				pos = size;
+				break;
+			}
+			pos = nl - data + 1;
+			if (!pgn || (pos < size && data[pos] == '['
+			&&  followsEmptyLine(data, pos)))
+				break;
+		}
+		if (pos >= size)
+			break;
+
+		ranges.last().end = pos;
+		range.start = pos;
+		ranges.append(range);
+	}
+
+	return ranges;
+}
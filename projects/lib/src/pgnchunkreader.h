@@ -0,0 +1,137 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNCHUNKREADER_H
+#define PGNCHUNKREADER_H
+
+#include <functional>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QIODevice>
+#include <QScopedPointer>
+
+/*!
+ * \brief Reads a PGN file in chunks of whole games
+ *
+ * PgnChunkReader splits a PGN file into chunks of about chunkSize()
+ * bytes that end where a game begins, so that each chunk can be parsed
+ * by its own PgnStream. Files compressed with gzip or Zstandard are
+ * decompressed on the fly. Other files are mapped into memory and split
+ * without copying, unless they are opened in text mode.
+ *
+ * process() parses the chunks with a pool of worker threads and
+ * collects the results in the order of the input, regardless of the
+ * number of threads.
+ *
+ * \note The input is split at lines that start with an Event tag, so a
+ * file without Event tags is read as one chunk.
+ */
+class LIB_EXPORT PgnChunkReader
+{
+	public:
+		/*! A chunk of whole PGN games. */
+		struct Chunk
+		{
+			/*!
+			 * The games. The data of a mapped file is only
+			 * valid until the reader is closed.
+			 */
+			QByteArray data;
+			/*! The line number of the chunk's first line. */
+			qint64 lineNumber;
+		};
+		/*! A range of bytes in a file. */
+		struct Range
+		{
+			/*! The position of the first byte. */
+			qint64 start;
+			/*! The position after the last byte. */
+			qint64 end;
+		};
+		/*! Collects a chunk's result on the reading thread. */
+		typedef std::function<void()> Collector;
+		/*! Parses a chunk on a worker thread. */
+		typedef std::function<Collector(const Chunk&)> Parser;
+
+		/*! Creates a new reader. */
+		PgnChunkReader();
+		/*! Destroys the reader and closes its file. */
+		~PgnChunkReader();
+
+		/*!
+		 * Returns the approximate size of a chunk in bytes.
+		 * The default is 4 MiB.
+		 */
+		int chunkSize() const;
+		/*! Sets the approximate size of a chunk to \a bytes. */
+		void setChunkSize(int bytes);
+
+		/*!
+		 * Opens the PGN file \a fileName in \a mode, which is
+		 * ReadOnly or ReadOnly | Text.
+		 *
+		 * Returns true if successful; otherwise prints a warning
+		 * and returns false.
+		 */
+		bool open(const QString& fileName,
+			  QIODevice::OpenMode mode = QIODevice::ReadOnly);
+		/*! Closes the file. */
+		void close();
+		/*! Returns the name of the file. */
+		QString fileName() const;
+
+		/*!
+		 * Reads the next chunk to \a chunk.
+		 * Returns false at the end of the file.
+		 */
+		bool readChunk(Chunk* chunk);
+		/*!
+		 * Reads the rest of the file and calls \a parser for each
+		 * chunk on up to \a threadCount worker threads. The
+		 * collectors returned by \a parser are called on the
+		 * calling thread in the order of the chunks. At most
+		 * 2 * \a threadCount chunks are in memory at once.
+		 */
+		void process(const Parser& parser, int threadCount);
+
+		/*!
+		 * Splits the \a size bytes of \a data, eg. a mapped file,
+		 * into at most \a count ranges of about equal size that
+		 * start at the beginning of a line. If \a pgn is true, a
+		 * range only starts at the first tag of a game that
+		 * follows an empty line.
+		 */
+		static QVector<Range> split(const char* data,
+					    qint64 size,
+					    int count,
+					    bool pgn = true);
+
+	private:
+		Q_DISABLE_COPY(PgnChunkReader)
+
+		QString m_fileName;
+		QScopedPointer<QIODevice> m_file;
+		int m_chunkSize;
+		const char* m_map;
+		qint64 m_mapSize;
+		qint64 m_mapPos;
+		QByteArray m_rest;
+		qint64 m_lineNumber;
+};
+
+#endif // PGNCHUNKREADER_H
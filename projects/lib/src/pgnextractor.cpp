@@ -0,0 +1,146 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "pgnextractor.h"
+#include "pgnstream.h"
+#include "pgnchunkreader.h"
+#include "pgngameentry.h"
+
+PgnExtractor::PgnExtractor(const PgnGameFilter& filter)
+	: m_filter(filter),
+	  m_minPlies(0),
+	  m_gameCount(0),
+	  m_matchCount(0),
+	  m_failed(false)
+{
+}
+
+void PgnExtractor::setMinPlies(int plies)
+{
+	m_minPlies = plies;
+}
+
+qint64 PgnExtractor::gameCount() const
+{
+	return m_gameCount;
+}
+
+qint64 PgnExtractor::matchCount() const
+{
+	return m_matchCount;
+}
+
+bool PgnExtractor::open(const QString& fileName)
+{
+	m_out.setFileName(fileName);
+	if (!m_out.open(QIODevice::WriteOnly))
+	{
+		qWarning("Can't open PGN file %s", qUtf8Printable(fileName));
+		return false;
+	}
+	return true;
+}
+
+bool PgnExtractor::hasMinPlies(const QByteArray& game) const
+{
+	// Count the move tokens without parsing the moves
+	PgnStream in(&game);
+	if (!in.nextGame())
+		return false;
+
+	int plies = 0;
+	for (;;)
+	{
+		switch (in.readNext())
+		{
+		case PgnStream::PgnMove:
+			if (++plies >= m_minPlies)
+				return true;
+			break;
+		case PgnStream::PgnResult:
+		case PgnStream::NoToken:
+			return false;
+		default:
+			break;
+		}
+	}
+}
+
+void PgnExtractor::addGames(const QByteArray& data)
+{
+	PgnStream in(&data);
+	PgnGameEntry entry;
+	QByteArray buffer;
+
+	// A game ends where the next one begins, so the games are
+	// copied with their comments and formatting intact
+	bool more = entry.read(in);
+	while (more)
+	{
+		m_gameCount++;
+		const qint64 start = entry.pos();
+		const bool match = entry.match(m_filter);
+		more = entry.read(in);
+		if (!match)
+			continue;
+
+		const qint64 end = more ? entry.pos() : qint64(data.size());
+		const QByteArray game(QByteArray::fromRawData(
+			data.constData() + start, int(end - start)));
+		if (m_minPlies > 0 && !hasMinPlies(game))
+			continue;
+
+		m_matchCount++;
+		buffer += game;
+		if (!game.endsWith('\n'))
+			buffer += "\n\n";
+	}
+
+	if (!m_failed && m_out.write(buffer) != buffer.size())
+	{
+		qWarning("Can't write to PGN file %s",
+			 qUtf8Printable(m_out.fileName()));
+		m_failed = true;
+	}
+}
+
+bool PgnExtractor::addPgnFile(const QString& fileName)
+{
+	Q_ASSERT(m_out.isOpen());
+
+	PgnChunkReader reader;
+	if (!reader.open(fileName))
+		return false;
+
+	PgnChunkReader::Chunk chunk;
+	while (!m_failed && reader.readChunk(&chunk))
+		addGames(chunk.data);
+
+	return !m_failed;
+}
+
+bool PgnExtractor::close()
+{
+	if (m_failed || !m_out.commit())
+	{
+		qWarning("Can't write PGN file %s",
+			 qUtf8Printable(m_out.fileName()));
+		return false;
+	}
+	return true;
+}
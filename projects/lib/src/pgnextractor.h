@@ -0,0 +1,89 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNEXTRACTOR_H
+#define PGNEXTRACTOR_H
+
+#include <QString>
+#include <QSaveFile>
+#include "pgngamefilter.h"
+
+/*!
+ * \brief Copies the games that match a filter from PGN collections
+ *
+ * PgnExtractor streams PGN files and writes the games that match a
+ * PgnGameFilter to an output file byte for byte, without parsing or
+ * re-serializing their moves. Only the tags of each game are read with
+ * PgnGameEntry; the move text of the games that fail the filter is
+ * skipped. The moves of a matching game are only tokenized when a
+ * minimum ply count is set, and even then they aren't replayed.
+ *
+ * \sa PgnGameFilter, PgnGameEntry
+ */
+class LIB_EXPORT PgnExtractor
+{
+	public:
+		/*! Creates a new extractor that uses \a filter. */
+		explicit PgnExtractor(const PgnGameFilter& filter);
+
+		/*!
+		 * Only copies games with at least \a plies plies.
+		 * The default is 0.
+		 */
+		void setMinPlies(int plies);
+
+		/*!
+		 * Opens the PGN file \a fileName for writing. The file is
+		 * replaced when close() is called.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool open(const QString& fileName);
+		/*!
+		 * Copies the matching games of PGN file \a fileName.
+		 * The file may be compressed with gzip or Zstandard.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool addPgnFile(const QString& fileName);
+		/*!
+		 * Finishes writing the output file.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool close();
+
+		/*! Returns the number of games read so far. */
+		qint64 gameCount() const;
+		/*! Returns the number of games copied so far. */
+		qint64 matchCount() const;
+
+	private:
+		Q_DISABLE_COPY(PgnExtractor)
+
+		bool hasMinPlies(const QByteArray& game) const;
+		void addGames(const QByteArray& data);
+
+		PgnGameFilter m_filter;
+		int m_minPlies;
+		qint64 m_gameCount;
+		qint64 m_matchCount;
+		QSaveFile m_out;
+		bool m_failed;
+};
+
+#endif // PGNEXTRACTOR_H
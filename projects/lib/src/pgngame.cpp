@@ -21,6 +21,8 @@
 #include <QFile>
 #include <QMetaObject>
 #include <QDateTime>
+#include <QHash>
+#include <algorithm>
 #include "board/boardfactory.h"
 #include "econode.h"
 #include "pgnstream.h"
@@ -28,12 +30,70 @@
 
 namespace {
 
-void writeTag(QTextStream& out, const QString& tag, const QString& value)
+// Appends \a str to \a out in UTF-8 without a temporary copy when
+// it's plain ASCII, which is true for most of a PGN game
+void appendString(QByteArray* out, const QString& str)
 {
+	const QChar* data = str.constData();
+	const int size = str.size();
+
+	for (int i = 0; i < size; i++)
+	{
+		if (data[i].unicode() >= 0x80)
+		{
+			out->append(str.midRef(i).toUtf8());
+			return;
+		}
+		out->append(char(data[i].unicode()));
+	}
+}
+
+void writeTag(QByteArray* out, const QString& tag, const QString& value)
+{
+	out->append('[');
+	appendString(out, tag);
+	out->append(" \"");
 	if (!value.isEmpty())
-		out << "[" << tag << " \"" << value << "\"]\n";
+		appendString(out, value);
 	else
-		out << "[" << tag << " \"?\"]\n";
+		out->append('?');
+	out->append("\"]\n");
+}
+
+struct StandardTagTable
+{
+	QString names[PgnGame::StandardTagCount];
+	QHash<QString, int> ids;
+};
+
+const StandardTagTable& standardTagTable()
+{
+	static const StandardTagTable table = []()
+	{
+		// In the order of PgnGame::StandardTag
+		static const char* const names[] =
+		{
+			"Event", "Site", "Date", "Round", "White", "Black",
+			"Result", "FEN", "SetUp", "Variant", "PlyCount",
+			"Termination", "TimeControl", "WhiteTimeControl",
+			"BlackTimeControl", "ECO", "Opening", "Variation",
+			"GameNumber", "GameStartTime", "GameEndTime",
+			"GameDuration"
+		};
+		static_assert(sizeof(names) / sizeof(names[0])
+			      == PgnGame::StandardTagCount,
+			      "Standard tag names don't match the IDs");
+
+		StandardTagTable t;
+		for (int i = 0; i < PgnGame::StandardTagCount; i++)
+		{
+			t.names[i] = QString::fromLatin1(names[i]);
+			t.ids.insert(t.names[i], i);
+		}
+		return t;
+	}();
+
+	return table;
 }
 
 } // anonymous namespace
@@ -51,22 +111,46 @@ QTextStream& operator<<(QTextStream& out, const PgnGame& game)
 }
 
 
+QString PgnGame::MoveData::commentText() const
+{
+	const QString text(evaluation.pgnComment());
+	if (text.isEmpty())
+		return comment;
+	if (comment.isEmpty())
+		return text;
+	return text + ", " + comment;
+}
+
 PgnGame::PgnGame()
 	: m_startingSide(Chess::Side::White),
-	  m_eco(EcoNode::root()),
+	  m_eco(nullptr),
 	  m_tagReceiver(nullptr)
 {
 }
 
 bool PgnGame::isNull() const
 {
-	return (m_tags.isEmpty() && m_moves.isEmpty());
+	return (!hasTags() && m_moves.isEmpty());
+}
+
+bool PgnGame::hasTags() const
+{
+	if (!m_tags.isEmpty())
+		return true;
+	for (const QString& value : m_standardTags)
+	{
+		if (!value.isEmpty())
+			return true;
+	}
+	return false;
 }
 
 void PgnGame::clear()
 {
 	m_startingSide = Chess::Side();
-	m_eco = EcoNode::root();
+	m_eco = nullptr;
+	for (QString& value : m_standardTags)
+		value.clear();
 	m_tags.clear();
 	m_moves.clear();
 }
@@ -74,24 +158,30 @@ void PgnGame::clear()
 QList< QPair<QString, QString> > PgnGame::tags() const
 {
 	QList< QPair<QString, QString> > list;
+	const StandardTagTable& table = standardTagTable();
 
 	// The seven tag roster
-	const QStringList roster = (QStringList() << "Event" << "Site" << "Date"
-		<< "Round" << "White" << "Black" << "Result");
-	for (const QString& tag : roster)
+	for (int i = 0; i < RosterSize; i++)
 	{
-		QString value = m_tags.value(tag);
+		QString value = m_standardTags[i];
 		if (value.isEmpty())
 			value = "?";
-		list.append(qMakePair(tag, value));
+		list.append(qMakePair(table.names[i], value));
 	}
 
+	// The other tags in alphabetical order
+	for (int i = RosterSize; i < StandardTagCount; i++)
+	{
+		if (!m_standardTags[i].isEmpty())
+			list.append(qMakePair(table.names[i], m_standardTags[i]));
+	}
 	QMap<QString, QString>::const_iterator it;
 	for (it = m_tags.constBegin(); it != m_tags.constEnd(); ++it)
 	{
-		if (!roster.contains(it.key()) && !it.value().isEmpty())
+		if (!it.value().isEmpty())
 			list.append(qMakePair(it.key(), it.value()));
 	}
+	std::sort(list.begin() + RosterSize, list.end());
 
 	return list;
 }
@@ -106,13 +196,16 @@ void PgnGame::addMove(const MoveData& data, bool addEco)
 	m_moves.append(data);
 
 	if (addEco) {
+		// The ECO tree is loaded when the first game is classified
+		if (m_moves.size() == 1 && isStandard())
+			m_eco = EcoNode::root();
 		m_eco = (m_eco && isStandard()) ? m_eco->child(data.moveString)
 						: nullptr;
 		if (m_eco && m_eco->isLeaf())
 		{
-			setTag("ECO", m_eco->ecoCode());
-			setTag("Opening", m_eco->opening());
-			setTag("Variation", m_eco->variation());
+			setTag(EcoTag, m_eco->ecoCode());
+			setTag(OpeningTag, m_eco->opening());
+			setTag(VariationTag, m_eco->variation());
 		}
 	}
 }
@@ -149,7 +242,7 @@ Chess::Board* PgnGame::createBoard() const
 
 bool PgnGame::parseMove(PgnStream& in, bool addEco)
 {
-	if (m_tags.isEmpty())
+	if (!hasTags())
 	{
 		qWarning("No tags found");
 		return false;
@@ -161,7 +254,7 @@ bool PgnGame::parseMove(PgnStream& in, bool addEco)
 	// set the board when we get the first move
 	if (m_moves.isEmpty())
 	{
-		QString tmp(m_tags.value("Variant").toLower());
+		QString tmp(m_standardTags[VariantTag].toLower());
 		if (tmp == "chess" || tmp == "normal")
 			tmp = QString("standard");
 
@@ -172,9 +265,9 @@ bool PgnGame::parseMove(PgnStream& in, bool addEco)
 		}
 		board = in.board();
 		if (tmp.isEmpty() && board->variant() != "standard")
-			setTag("Variant", board->variant());
+			setTag(VariantTag, board->variant());
 
-		tmp = m_tags.value("FEN");
+		tmp = m_standardTags[FenTag];
 		if (tmp.isEmpty())
 		{
 			if (board->isRandomVariant())
@@ -234,12 +327,17 @@ bool PgnGame::read(PgnStream& in, int maxMoves, bool addEco)
 		case PgnStream::PgnResult:
 			{
 				const QString str(in.tokenString());
-				QString result = m_tags.value("Result");
+				const QString& result = m_standardTags[ResultTag];
 
 				if (!result.isEmpty() && str != result)
-					qWarning("%s", qUtf8Printable(QString("Line %1: The termination "
-						 "marker is different from the result tag").arg(in.lineNumber())));
-				setTag("Result", str);
+				{
+					QString msg("The termination marker is different "
+						    "from the result tag");
+					if (in.lineNumber() != -1)
+						msg.prepend(QString("Line %1: ").arg(in.lineNumber()));
+					qWarning("%s", qUtf8Printable(msg));
+				}
+				setTag(ResultTag, str);
 			}
 			stop = true;
 			break;
@@ -261,17 +359,68 @@ bool PgnGame::read(PgnStream& in, int maxMoves, bool addEco)
 		if (stop)
 			break;
 	}
-	if (m_tags.isEmpty())
+	if (!hasTags())
 		return false;
 
-	setTag("PlyCount", QString::number(m_moves.size()));
+	setTag(PlyCountTag, QString::number(m_moves.size()));
+
+	return true;
+}
+
+bool PgnGame::readTags(PgnStream& in, bool countPlies)
+{
+	clear();
+	if (!in.nextGame())
+		return false;
+
+	int plies = 0;
+	while (in.status() == PgnStream::Ok)
+	{
+		const PgnStream::TokenType type = in.readNext();
+		if (type == PgnStream::PgnTag)
+		{
+			setTag(in.tagName(), in.tagValue());
+			continue;
+		}
+
+		// The next call to nextGame() skips the rest of the game
+		if (type == PgnStream::NoToken || !countPlies)
+			break;
+		if (type == PgnStream::PgnMove)
+			plies++;
+		else if (type == PgnStream::PgnResult)
+		{
+			if (m_standardTags[ResultTag].isEmpty())
+				setTag(ResultTag, in.tokenString());
+			break;
+		}
+	}
+	if (!hasTags())
+		return false;
+
+	if (countPlies)
+		setTag(PlyCountTag, QString::number(plies));
 
 	return true;
 }
 
 bool PgnGame::write(QTextStream& out, PgnMode mode) const
 {
-	if (m_tags.isEmpty())
+	QByteArray data;
+	if (!write(&data, mode))
+		return false;
+
+	out << QString::fromUtf8(data);
+	out.flush();
+
+	return (out.status() == QTextStream::Ok);
+}
+
+bool PgnGame::write(QByteArray* out, PgnMode mode) const
+{
+	Q_ASSERT(out != nullptr);
+
+	if (!hasTags())
 		return false;
 	
 	const QList< QPair<QString, QString> > tags = this->tags();
@@ -279,65 +428,83 @@ bool PgnGame::write(QTextStream& out, PgnMode mode) const
 	for (int i = 0; i < maxTags; i++)
 		writeTag(out, tags.at(i).first, tags.at(i).second);
 	
-	if (mode == Minimal && m_tags.contains("FEN"))
+	if (mode == Minimal && !m_standardTags[FenTag].isEmpty())
 	{
-		writeTag(out, "FEN", m_tags["FEN"]);
-		writeTag(out, "SetUp", m_tags["SetUp"]);
+		writeTag(out, "FEN", m_standardTags[FenTag]);
+		writeTag(out, "SetUp", m_standardTags[SetUpTag]);
 	}
 
-	if (mode == Minimal && m_tags.contains("Variant")
+	if (mode == Minimal && !m_standardTags[GameNumberTag].isEmpty())
+		writeTag(out, "GameNumber", m_standardTags[GameNumberTag]);
+
+	if (mode == Minimal && !m_standardTags[VariantTag].isEmpty()
 	&&  variant() != "standard")
 	{
-		writeTag(out, "Variant", m_tags["Variant"]);
+		writeTag(out, "Variant", m_standardTags[VariantTag]);
 	}
 
-	QString str;
 	int lineLength = 0;
 	int movenum = 0;
 	int side = m_startingSide;
 
 	if (m_moves.isEmpty() && !m_initialComment.isEmpty())
-		out << "\n" << "{" << m_initialComment << "}";
+	{
+		out->append("\n{");
+		appendString(out, m_initialComment);
+		out->append('}');
+	}
 
 	for (int i = 0; i < m_moves.size(); i++)
 	{
 		const MoveData& data = m_moves.at(i);
+		const QString comment(mode == Verbose ? data.commentText() : QString());
+		const bool hasComment = !comment.isEmpty();
 
-		str.clear();
+		char number[16];
+		int numberLength = 0;
 		if (i == 0 && side == Chess::Side::Black)
-			str = QString::number(++movenum) + "... ";
+			numberLength = qsnprintf(number, sizeof(number), "%d... ", ++movenum);
 		else if (side == Chess::Side::White)
-			str = QString::number(++movenum) + ". ";
+			numberLength = qsnprintf(number, sizeof(number), "%d. ", ++movenum);
 
-		str += data.moveString;
-		if (mode == Verbose && !data.comment.isEmpty())
-			str += QString(" {%1}").arg(data.comment);
+		int length = numberLength + data.moveString.size();
+		if (hasComment)
+			length += comment.size() + 3;
 
 		// Limit the lines to 80 characters
-		if (lineLength == 0 || lineLength + str.size() >= 80)
+		if (lineLength == 0 || lineLength + length >= 80)
 		{
-			out << "\n" << str;
-			lineLength = str.size();
+			out->append('\n');
+			lineLength = length;
 		}
 		else
 		{
-			out << " " << str;
-			lineLength += str.size() + 1;
+			out->append(' ');
+			lineLength += length + 1;
+		}
+
+		out->append(number, numberLength);
+		appendString(out, data.moveString);
+		if (hasComment)
+		{
+			out->append(" {");
+			appendString(out, comment);
+			out->append('}');
 		}
 
 		side = !side;
 	}
 
-	str = m_tags.value("Result");
+	const QString result = m_standardTags[ResultTag];
 
-	if (lineLength + str.size() >= 80)
-		out << "\n" << str << "\n\n";
+	if (lineLength + result.size() >= 80)
+		out->append('\n');
 	else
-		out << " " << str << "\n\n";
-
-	out.flush();
+		out->append(' ');
+	appendString(out, result);
+	out->append("\n\n");
 
-	return (out.status() == QTextStream::Ok);
+	return true;
 }
 
 bool PgnGame::write(const QString& filename, PgnMode mode) const
@@ -352,54 +519,75 @@ bool PgnGame::write(const QString& filename, PgnMode mode) const
 
 bool PgnGame::isStandard() const
 {
-	return variant() == "standard" && !m_tags.contains("FEN");
+	return variant() == "standard" && m_standardTags[FenTag].isEmpty();
 }
 
 QString PgnGame::tagValue(const QString& tag) const
 {
+	int id = standardTag(tag);
+	if (id != -1)
+		return m_standardTags[id];
 	return m_tags.value(tag);
 }
 
+QString PgnGame::tagValue(StandardTag tag) const
+{
+	Q_ASSERT(tag >= 0 && tag < StandardTagCount);
+	return m_standardTags[tag];
+}
+
+int PgnGame::standardTag(const QString& tag)
+{
+	return standardTagTable().ids.value(tag, -1);
+}
+
+QString PgnGame::standardTagName(StandardTag tag)
+{
+	Q_ASSERT(tag >= 0 && tag < StandardTagCount);
+	return standardTagTable().names[tag];
+}
+
 QString PgnGame::event() const
 {
-	return m_tags.value("Event");
+	return m_standardTags[EventTag];
 }
 
 QString PgnGame::site() const
 {
-	return m_tags.value("Site");
+	return m_standardTags[SiteTag];
 }
 
 QDate PgnGame::date() const
 {
-	return QDate::fromString(m_tags.value("Date"), "yyyy.MM.dd");
+	return QDate::fromString(m_standardTags[DateTag], "yyyy.MM.dd");
 }
 
 int PgnGame::round() const
 {
-	return m_tags.value("Round").toInt();
+	return m_standardTags[RoundTag].toInt();
 }
 
 QString PgnGame::playerName(Chess::Side side) const
 {
 	if (side == Chess::Side::White)
-		return m_tags.value("White");
+		return m_standardTags[WhiteTag];
 	else if (side == Chess::Side::Black)
-		return m_tags.value("Black");
+		return m_standardTags[BlackTag];
 
 	return QString();
 }
 
 Chess::Result PgnGame::result() const
 {
-	return Chess::Result(m_tags.value("Result"));
+	return Chess::Result(m_standardTags[ResultTag]);
 }
 
 QString PgnGame::variant() const
 {
-	if (m_tags.contains("Variant"))
+	const QString& value = m_standardTags[VariantTag];
+	if (!value.isEmpty())
 	{
-		QString variant(m_tags.value("Variant").toLower());
+		QString variant(value.toLower());
 		if ("chess" != variant && "normal" != variant)
 			return variant;
 	}
@@ -413,77 +601,98 @@ Chess::Side PgnGame::startingSide() const
 
 QString PgnGame::startingFenString() const
 {
-	return m_tags.value("FEN");
+	return m_standardTags[FenTag];
 }
 
 void PgnGame::setTag(const QString& tag, const QString& value)
 {
+	int id = standardTag(tag);
+	if (id != -1)
+	{
+		setTag(StandardTag(id), value);
+		return;
+	}
+
 	if (value.isEmpty())
 		m_tags.remove(tag);
 	else
 		m_tags[tag] = value;
 
-	if (m_tagReceiver)
-		QMetaObject::invokeMethod(m_tagReceiver, "setTag",
+	QObject* receiver = m_tagReceiver.loadAcquire();
+	if (receiver)
+		QMetaObject::invokeMethod(receiver, "setTag",
 					  Qt::QueuedConnection,
 					  Q_ARG(QString, tag),
 					  Q_ARG(QString, value));
 }
 
+void PgnGame::setTag(StandardTag tag, const QString& value)
+{
+	Q_ASSERT(tag >= 0 && tag < StandardTagCount);
+	m_standardTags[tag] = value;
+
+	QObject* receiver = m_tagReceiver.loadAcquire();
+	if (receiver)
+		QMetaObject::invokeMethod(receiver, "setTag",
+					  Qt::QueuedConnection,
+					  Q_ARG(QString, standardTagName(tag)),
+					  Q_ARG(QString, value));
+}
+
 void PgnGame::setEvent(const QString& event)
 {
-	setTag("Event", event);
+	setTag(EventTag, event);
 }
 
 void PgnGame::setSite(const QString& site)
 {
-	setTag("Site", site);
+	setTag(SiteTag, site);
 }
 
 void PgnGame::setDate(const QDate& date)
 {
-	setTag("Date", date.toString("yyyy.MM.dd"));
+	setTag(DateTag, date.toString("yyyy.MM.dd"));
 }
 
 void PgnGame::setRound(int round)
 {
-	setTag("Round", QString::number(round));
+	setTag(RoundTag, QString::number(round));
 }
 
 void PgnGame::setPlayerName(Chess::Side side, const QString& name)
 {
 	if (side == Chess::Side::White)
-		setTag("White", name);
+		setTag(WhiteTag, name);
 	else if (side == Chess::Side::Black)
-		setTag("Black", name);
+		setTag(BlackTag, name);
 }
 
 void PgnGame::setResult(const Chess::Result& result)
 {
-	setTag("Result", result.toShortString());
+	setTag(ResultTag, result.toShortString());
 
 	switch (result.type())
 	{
 	case Chess::Result::Adjudication:
-		setTag("Termination", "adjudication");
+		setTag(TerminationTag, "adjudication");
 		break;
 	case Chess::Result::Timeout:
-		setTag("Termination", "time forfeit");
+		setTag(TerminationTag, "time forfeit");
 		break;
 	case Chess::Result::Disconnection:
-		setTag("Termination", "abandoned");
+		setTag(TerminationTag, "abandoned");
 		break;
 	case Chess::Result::StalledConnection:
-		setTag("Termination", "stalled connection");
+		setTag(TerminationTag, "stalled connection");
 		break;
 	case Chess::Result::IllegalMove:
-		setTag("Termination", "illegal move");
+		setTag(TerminationTag, "illegal move");
 		break;
 	case Chess::Result::NoResult:
-		setTag("Termination", "unterminated");
+		setTag(TerminationTag, "unterminated");
 		break;
 	default:
-		setTag("Termination", QString());
+		setTag(TerminationTag, QString());
 		break;
 	}
 }
@@ -491,9 +700,9 @@ void PgnGame::setResult(const Chess::Result& result)
 void PgnGame::setVariant(const QString& variant)
 {
 	if (variant == "standard")
-		setTag("Variant", QString());
+		setTag(VariantTag, QString());
 	else
-		setTag("Variant", variant);
+		setTag(VariantTag, variant);
 }
 
 void PgnGame::setStartingSide(Chess::Side side)
@@ -506,13 +715,13 @@ void PgnGame::setStartingFenString(Chess::Side side, const QString& fen)
 	m_startingSide = side;
 	if (fen.isEmpty())
 	{
-		setTag("FEN", QString());
-		setTag("SetUp", QString());
+		setTag(FenTag, QString());
+		setTag(SetUpTag, QString());
 	}
 	else
 	{
-		setTag("FEN", fen);
-		setTag("SetUp", "1");
+		setTag(FenTag, fen);
+		setTag(SetUpTag, "1");
 	}
 }
 
@@ -535,7 +744,7 @@ void PgnGame::setResultDescription(const QString& description)
 
 void PgnGame::setTagReceiver(QObject* receiver)
 {
-	m_tagReceiver = receiver;
+	m_tagReceiver.storeRelease(receiver);
 }
 
 QString PgnGame::timeStamp(const QDateTime& dateTime)
@@ -546,16 +755,16 @@ QString PgnGame::timeStamp(const QDateTime& dateTime)
 void PgnGame::setGameStartTime(const QDateTime& dateTime)
 {
 	m_gameStartTime = dateTime;
-	setTag("GameStartTime", timeStamp(dateTime));
+	setTag(GameStartTimeTag, timeStamp(dateTime));
 }
 
 void PgnGame::setGameEndTime(const QDateTime& dateTime)
 {
-	setTag("GameEndTime", timeStamp(dateTime));
+	setTag(GameEndTimeTag, timeStamp(dateTime));
 
 	int d = m_gameStartTime.secsTo(dateTime);
 	QTime time = QTime(d / 3600, d % 3600 / 60, d % 60);
-	setTag("GameDuration", time.toString("hh:mm:ss"));
+	setTag(GameDurationTag, time.toString("hh:mm:ss"));
 }
 
 // HACK
@@ -568,9 +777,9 @@ QMap< int, int > PgnGame::extractScores() const
 	for (const auto md: moves())
 	{
 		// Default format: Xboard/concise like {0.35/16 5.1s})
-		// Ref.: ChessGame::evalString and MoveEvaluation::scoreText
+		// Ref.: MoveEvaluation::pgnComment and MoveEvaluation::scoreText
 		int count = scores.count();
-		QString s = md.comment.split('/').at(0);
+		QString s = md.commentText().split('/').at(0);
 		bool isMateScore = s.contains('M');
 		if (isMateScore)
 			s.remove('M');
@@ -24,10 +24,13 @@
 #include <QList>
 #include <QPair>
 #include <QDate>
+#include <QAtomicPointer>
 #include <climits>
 #include "board/genericmove.h"
 #include "board/result.h"
+#include "moveevaluation.h"
 class QTextStream;
+class QByteArray;
 class PgnStream;
 class EcoNode;
 class QObject;
@@ -60,6 +63,41 @@ class LIB_EXPORT PgnGame
 			Verbose
 		};
 
+		/*!
+		 * \brief Tags with a fixed ID.
+		 *
+		 * These are the Seven Tag Roster and the other tags that
+		 * Cute Chess sets itself. Their values are stored by ID, so
+		 * reading and writing them needs no lookups by name. Other
+		 * tags are stored by name.
+		 */
+		enum StandardTag
+		{
+			EventTag,		//!< Event
+			SiteTag,		//!< Site
+			DateTag,		//!< Date
+			RoundTag,		//!< Round
+			WhiteTag,		//!< White
+			BlackTag,		//!< Black
+			ResultTag,		//!< Result
+			FenTag,			//!< FEN
+			SetUpTag,		//!< SetUp
+			VariantTag,		//!< Variant
+			PlyCountTag,		//!< PlyCount
+			TerminationTag,		//!< Termination
+			TimeControlTag,		//!< TimeControl
+			WhiteTimeControlTag,	//!< WhiteTimeControl
+			BlackTimeControlTag,	//!< BlackTimeControl
+			EcoTag,			//!< ECO
+			OpeningTag,		//!< Opening
+			VariationTag,		//!< Variation
+			GameNumberTag,		//!< GameNumber
+			GameStartTimeTag,	//!< GameStartTime
+			GameEndTimeTag,		//!< GameEndTime
+			GameDurationTag,	//!< GameDuration
+			StandardTagCount	//!< The number of standard tags
+		};
+
 		/*! \brief A struct for storing the game's move history. */
 		struct MoveData
 		{
@@ -69,8 +107,26 @@ class LIB_EXPORT PgnGame
 			Chess::GenericMove move;
 			/*! The move in Standard Algebraic Notation. */
 			QString moveString;
+			/*!
+			 * The engine's evaluation of the move.
+			 *
+			 * Live games store the evaluation instead of a
+			 * formatted comment, so that the comment text is
+			 * only generated when it's needed.
+			 *
+			 * \sa commentText()
+			 */
+			MoveEvaluation evaluation;
 			/*! A comment/annotation describing the move. */
 			QString comment;
+
+			/*!
+			 * Returns the full comment of the move: the
+			 * evaluation in the format of
+			 * MoveEvaluation::pgnComment(), followed by
+			 * \a comment.
+			 */
+			QString commentText() const;
 		};
 
 		/*! Creates a new PgnGame object. */
@@ -113,12 +169,38 @@ class LIB_EXPORT PgnGame
 		 */
 		bool read(PgnStream& in, int maxMoves = INT_MAX - 1,
 				  bool addEco = true);
+		/*!
+		 * Reads only the tags of a game from a PGN stream, and skips
+		 * the move text without parsing the moves.
+		 *
+		 * If \a countPlies is true, the move tokens are counted,
+		 * without validating them, and stored in the \a PlyCount
+		 * tag, and a missing \a Result tag is taken from the
+		 * termination marker. Otherwise the move text isn't
+		 * tokenized at all.
+		 *
+		 * The game has no moves afterwards. Returns true if any tags
+		 * were read.
+		 *
+		 * \sa read()
+		 */
+		bool readTags(PgnStream& in, bool countPlies = false);
 		/*!
 		 * Writes the game to a text stream.
 		 *
 		 * Returns true if successful; otherwise returns false.
 		 */
 		bool write(QTextStream& out, PgnMode mode = Verbose) const;
+		/*!
+		 * Appends the game to \a out in UTF-8 encoding.
+		 *
+		 * This is faster than writing to a text stream, and \a out
+		 * can be reused for many games.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 * \sa PgnWriter
+		 */
+		bool write(QByteArray* out, PgnMode mode = Verbose) const;
 		/*!
 		 * Writes the game to a file.
 		 * If the file already exists, the game will be appended
@@ -139,6 +221,15 @@ class LIB_EXPORT PgnGame
 		 * If \a tag doesn't exist, an empty string is returned.
 		 */
 		QString tagValue(const QString& tag) const;
+		/*! Returns the value of standard tag \a tag. */
+		QString tagValue(StandardTag tag) const;
+		/*!
+		 * Returns the ID of tag \a tag, or -1 if \a tag is not a
+		 * standard tag.
+		 */
+		static int standardTag(const QString& tag);
+		/*! Returns the name of standard tag \a tag. */
+		static QString standardTagName(StandardTag tag);
 		/*! Returns the name of the tournament or match event. */
 		QString event() const;
 		/*! Returns the location of the event. */
@@ -163,6 +254,11 @@ class LIB_EXPORT PgnGame
 		 * If \a tag doesn't exist, a new tag is created.
 		 */
 		void setTag(const QString& tag, const QString& value);
+		/*!
+		 * Sets the value of standard tag \a tag to \a value.
+		 * An empty \a value removes the tag.
+		 */
+		void setTag(StandardTag tag, const QString& value);
 		/*! Sets the name of the tournament or match event. */
 		void setEvent(const QString& event);
 		/*! Sets the location of the event. */
@@ -194,7 +290,8 @@ class LIB_EXPORT PgnGame
 		 * Sets a receiver for PGN tags
 		 *
 		 * \a receiver is an object whose "setTag(QString tag, QString value)"
-		 * slot is called when a PGN tag changes.
+		 * slot is called when a PGN tag changes. The receiver can be
+		 * set from another thread than the one that changes the tags.
 		 */
 		void setTagReceiver(QObject* receiver);
 		/*! Sets the starting time of the game */
@@ -206,13 +303,20 @@ class LIB_EXPORT PgnGame
 		QMap<int, int> extractScores() const;
 
 	private:
+		friend class CompactPgnGame;
+
+		// The number of tags in the Seven Tag Roster
+		static const int RosterSize = ResultTag + 1;
+
 		bool parseMove(PgnStream& in, bool addEco);
+		bool hasTags() const;
 		
 		Chess::Side m_startingSide;
 		const EcoNode* m_eco;
+		QString m_standardTags[StandardTagCount];
 		QMap<QString, QString> m_tags;
 		QVector<MoveData> m_moves;
-		QObject* m_tagReceiver;
+		QAtomicPointer<QObject> m_tagReceiver;
 		QString m_initialComment;
 		static QString timeStamp(const QDateTime& dateTime);
 		QDateTime m_gameStartTime;
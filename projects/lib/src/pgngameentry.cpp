@@ -22,47 +22,10 @@
 #include <QMap>
 #include "pgnstream.h"
 #include "pgngamefilter.h"
+#include "pgntagtable.h"
 
 namespace {
 
-int s_stringContains(const char* s1, const char* s2, int size)
-{
-	Q_ASSERT(s1 != nullptr);
-	Q_ASSERT(s2 != nullptr);
-	Q_ASSERT(size >= 0);
-
-	if (!*s2)
-		return 0;
-	if (size == 0)
-		return -1;
-
-	const char* s1_end = s1 + size;
-
-	while (s1 < s1_end)
-	{
-		if (toupper(*s1) == toupper(*s2))
-		{
-			const char* a = s1 + 1;
-			const char* b = s2 + 1;
-
-			while (*b && a < s1_end)
-			{
-				if (toupper(*a) != toupper(*b))
-					break;
-				a++;
-				b++;
-			}
-			if (!*b)
-				return b - s2;
-			if (a == s1_end)
-				return -1;
-		}
-		s1++;
-	}
-
-	return -1;
-}
-
 int s_stringToInt(const char *s, int size)
 {
 	int num = 0;
@@ -76,6 +39,25 @@ int s_stringToInt(const char *s, int size)
 	return num;
 }
 
+bool s_parseDate(const char* str, int size, QDate* date)
+{
+	if (size < 10)
+		return false;
+
+	int year = s_stringToInt(str, 4);
+	if (year == 0)
+		return false;
+	int month = s_stringToInt(str + 5, 2);
+	if (month == 0)
+		month = 1;
+	int day = s_stringToInt(str + 8, 2);
+	if (day == 0)
+		day = 1;
+
+	*date = QDate(year, month, day);
+	return true;
+}
+
 } // anonymous namespace
 
 PgnStream& operator>>(PgnStream& in, PgnGameEntry& entry)
@@ -100,51 +82,50 @@ PgnGameEntry::PgnGameEntry()
 	: m_pos(0),
 	  m_lineNumber(1)
 {
+	for (int i = 0; i < TagCount; i++)
+		m_tags[i] = 0;
 }
 
 bool PgnGameEntry::match(const PgnGameFilter& filter) const
 {
-	const char* data = m_data.constData();
-
 	if (filter.type() == PgnGameFilter::FixedString)
-		return s_stringContains(data, filter.pattern(), m_data.size()) != -1;
+	{
+		for (int type = 0; type < TagCount; type++)
+		{
+			if (filter.matchLength(PgnGameFilter::PatternTerm,
+					       m_tags[type]) != -1)
+				return true;
+		}
+		return false;
+	}
 
+	const PgnTagTable* table = PgnTagTable::instance();
 	int whitePlayer = 0;
 
-	int i = 0;
-	for (int type = 0; type < 8; type++)
+	for (int type = 0; type < TagCount; type++)
 	{
-		int size = data[i++];
-		const char* str = data + i;
+		const int id = m_tags[type];
+		const QByteArray& value = table->value(id);
+		const char* str = value.constData();
+		const int size = value.size();
 
 		switch (type)
 		{
 		case EventTag:
-			if (s_stringContains(str, filter.event(), size) == -1)
+			if (filter.matchLength(PgnGameFilter::EventTerm, id) == -1)
 				return false;
 			break;
 		case SiteTag:
-			if (s_stringContains(str, filter.site(), size) == -1)
+			if (filter.matchLength(PgnGameFilter::SiteTerm, id) == -1)
 				return false;
 			break;
 		case DateTag:
 			if (!filter.minDate().isNull() || !filter.maxDate().isNull())
 			{
-				if (size < 10)
+				QDate date;
+				if (!s_parseDate(str, size, &date))
 					return false;
 
-				int year = s_stringToInt(str, 4);
-				if (year == 0)
-					return false;
-				int month = s_stringToInt(str + 5, 2);
-				if (month == 0)
-					month = 1;
-				int day = s_stringToInt(str + 8, 2);
-				if (day == 0)
-					day = 1;
-
-				QDate date(year, month, day);
-
 				if ((!filter.minDate().isNull() && date < filter.minDate())
 				||  (!filter.maxDate().isNull() && date > filter.maxDate()))
 					return false;
@@ -167,9 +148,9 @@ bool PgnGameEntry::match(const PgnGameFilter& filter) const
 				int len2 = -1;
 
 				if (filter.playerSide() != Chess::Side::Black)
-					len1 = s_stringContains(str, filter.player(), size);
+					len1 = filter.matchLength(PgnGameFilter::PlayerTerm, id);
 				if (filter.playerSide() != Chess::Side::White)
-					len2 = s_stringContains(str, filter.opponent(), size);
+					len2 = filter.matchLength(PgnGameFilter::OpponentTerm, id);
 
 				if (len1 == -1 && len2 == -1)
 					return false;
@@ -182,9 +163,9 @@ bool PgnGameEntry::match(const PgnGameFilter& filter) const
 				int len2 = -1;
 
 				if (filter.playerSide() != Chess::Side::White && whitePlayer != 1)
-					len1 = s_stringContains(str, filter.player(), size);
+					len1 = filter.matchLength(PgnGameFilter::PlayerTerm, id);
 				if (filter.playerSide() != Chess::Side::Black && whitePlayer != 2)
-					len2 = s_stringContains(str, filter.opponent(), size);
+					len2 = filter.matchLength(PgnGameFilter::OpponentTerm, id);
 
 				if (len1 == -1 && len2 == -1)
 					return false;
@@ -244,28 +225,35 @@ bool PgnGameEntry::match(const PgnGameFilter& filter) const
 				return false;
 		}
 			break;
+		case VariantTag:
+			if (*filter.variant())
+			{
+				const char* variant = size > 0 ? str : "standard";
+				if (qstricmp(variant, filter.variant()) != 0)
+					return false;
+			}
+			break;
 		default:
 			break;
 		}
-		i += size;
 	}
 
 	return true;
 }
 
-void PgnGameEntry::addTag(const QByteArray& tagValue)
+void PgnGameEntry::setTag(TagType type, const QByteArray& tagValue)
 {
-	int size = qMin(127, tagValue.size());
-
-	m_data.append(char(size));
-	m_data.append(tagValue.constData(), size);
+	// Tag values are limited to 127 characters so that they
+	// can be stored in the packed format of write()
+	m_tags[type] = PgnTagTable::instance()->intern(tagValue.left(127));
 }
 
 void PgnGameEntry::clear()
 {
 	m_pos = 0;
 	m_lineNumber = 1;
-	m_data.clear();
+	for (int i = 0; i < TagCount; i++)
+		m_tags[i] = 0;
 }
 
 bool PgnGameEntry::read(PgnStream& in)
@@ -275,7 +263,6 @@ bool PgnGameEntry::read(PgnStream& in)
 
 	m_pos = in.pos();
 	m_lineNumber = in.lineNumber();
-	m_data.clear();
 
 	char c;
 	QByteArray tagName;
@@ -324,14 +311,14 @@ bool PgnGameEntry::read(PgnStream& in)
 			tagValue += c;
 	}
 
-	addTag(tags["Event"]);
-	addTag(tags["Site"]);
-	addTag(tags["Date"]);
-	addTag(tags["Round"]);
-	addTag(tags["White"]);
-	addTag(tags["Black"]);
-	addTag(tags["Result"]);
-	addTag(tags["Variant"]);
+	setTag(EventTag, tags["Event"]);
+	setTag(SiteTag, tags["Site"]);
+	setTag(DateTag, tags["Date"]);
+	setTag(RoundTag, tags["Round"]);
+	setTag(WhiteTag, tags["White"]);
+	setTag(BlackTag, tags["Black"]);
+	setTag(ResultTag, tags["Result"]);
+	setTag(VariantTag, tags["Variant"]);
 
 	return true;
 }
@@ -343,7 +330,22 @@ bool PgnGameEntry::read(QDataStream& in)
 
 	in >> m_pos;
 	in >> m_lineNumber;
-	in >> m_data;
+
+	// The tags are stored as a length byte followed by the
+	// characters of the value, in TagType order
+	QByteArray data;
+	in >> data;
+
+	int i = 0;
+	for (int type = 0; type < TagCount; type++)
+	{
+		int size = (i < data.size()) ? data.at(i++) : 0;
+		if (size < 0 || i + size > data.size())
+			return false;
+
+		setTag(TagType(type), data.mid(i, size));
+		i += size;
+	}
 
 	return in.status() == QDataStream::Ok;
 }
@@ -355,7 +357,16 @@ void PgnGameEntry::write(QDataStream& out) const
 
 	out << m_pos;
 	out << m_lineNumber;
-	out << m_data;
+
+	const PgnTagTable* table = PgnTagTable::instance();
+	QByteArray data;
+	for (int type = 0; type < TagCount; type++)
+	{
+		const QByteArray& value = table->value(m_tags[type]);
+		data.append(char(value.size()));
+		data.append(value);
+	}
+	out << data;
 }
 
 qint64 PgnGameEntry::pos() const
@@ -370,12 +381,22 @@ qint64 PgnGameEntry::lineNumber() const
 
 QString PgnGameEntry::tagValue(TagType type) const
 {
-	int i = 0;
-	for (int j = 0; j < type; j++)
-		i += m_data[i] + 1;
-
-	int size = m_data[i];
-	if (size == 0)
+	const QByteArray& value = PgnTagTable::instance()->value(m_tags[type]);
+	if (value.isEmpty())
 		return QString();
-	return m_data.mid(i + 1, size);
+	return value;
+}
+
+QDate PgnGameEntry::date() const
+{
+	const QByteArray& value = PgnTagTable::instance()->value(m_tags[DateTag]);
+	QDate date;
+	s_parseDate(value.constData(), value.size(), &date);
+
+	return date;
+}
+
+int PgnGameEntry::tagId(TagType type) const
+{
+	return m_tags[type];
 }
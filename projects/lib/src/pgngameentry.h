@@ -33,7 +33,9 @@ class QDataStream;
  * the position and line number in a PGN stream.
  * This class was designed for high-performance and low memory
  * consumption, which is useful for quickly loading large game
- * collections.
+ * collections. The tag values are interned in PgnTagTable, so an
+ * entry only stores one integer per tag and recurring player and
+ * event names are stored only once.
  *
  * \sa PgnGame, PgnStream
  */
@@ -50,7 +52,8 @@ class LIB_EXPORT PgnGameEntry
 			WhiteTag,	//!< The player of the white pieces
 			BlackTag,	//!< The player of the black pieces
 			ResultTag,	//!< The result of the game
-			VariantTag	//!< The chess variant of the game
+			VariantTag,	//!< The chess variant of the game
+			TagCount	//!< The number of tag types
 		};
 
 		/*! Creates a new empty PgnGameEntry object. */
@@ -88,11 +91,22 @@ class LIB_EXPORT PgnGameEntry
 
 		/*! Returns the tag value corresponding to \a type. */
 		QString tagValue(TagType type) const;
+		/*!
+		 * Returns the starting date of the game, or a null date if
+		 * the \a DateTag is missing or invalid. An unknown month or
+		 * day defaults to 1.
+		 */
+		QDate date() const;
+		/*!
+		 * Returns the PgnTagTable id of the tag value corresponding
+		 * to \a type. Equal values have equal ids.
+		 */
+		int tagId(TagType type) const;
 
 	private:
-		void addTag(const QByteArray& tagValue);
+		void setTag(TagType type, const QByteArray& tagValue);
 
-		QByteArray m_data;
+		int m_tags[TagCount];
 
 		qint64 m_pos;
 		qint64 m_lineNumber;
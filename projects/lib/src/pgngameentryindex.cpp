@@ -0,0 +1,321 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgngameentryindex.h"
+#include <algorithm>
+#include <limits>
+#include <QtAlgorithms>
+#include "pgngameentry.h"
+#include "pgntagtable.h"
+#include "board/result.h"
+
+namespace {
+
+const PgnGameEntry::TagType s_columnTags[] =
+{
+	PgnGameEntry::EventTag,
+	PgnGameEntry::SiteTag,
+	PgnGameEntry::WhiteTag,
+	PgnGameEntry::BlackTag
+};
+
+QVector<int> s_intersection(const QVector<int>& a, const QVector<int>& b)
+{
+	QVector<int> result;
+	result.reserve(qMin(a.size(), b.size()));
+	std::set_intersection(a.constBegin(), a.constEnd(),
+			      b.constBegin(), b.constEnd(),
+			      std::back_inserter(result));
+	return result;
+}
+
+} // anonymous namespace
+
+PgnGameEntryIndex::PgnGameEntryIndex()
+	: m_entryCount(0)
+{
+}
+
+int PgnGameEntryIndex::entryCount() const
+{
+	return m_entryCount;
+}
+
+void PgnGameEntryIndex::clear()
+{
+	m_entryCount = 0;
+	for (int i = 0; i < ColumnCount; i++)
+		m_postings[i].clear();
+	m_dates.clear();
+	m_undated.clear();
+	for (int i = 0; i < ResultClassCount; i++)
+		m_results[i].clear();
+}
+
+int PgnGameEntryIndex::resultClass(int tagId)
+{
+	auto it = m_resultClasses.constFind(tagId);
+	if (it != m_resultClasses.constEnd())
+		return it.value();
+
+	const QByteArray& value = PgnTagTable::instance()->value(tagId);
+	Chess::Result result(QString::fromLatin1(value));
+	int resultClass = -1;
+
+	if (result.winner() == Chess::Side::White)
+		resultClass = WhiteWinsClass;
+	else if (result.winner() == Chess::Side::Black)
+		resultClass = BlackWinsClass;
+	else if (result.isDraw())
+		resultClass = DrawClass;
+	else if (result.isNone())
+		resultClass = UnfinishedClass;
+
+	m_resultClasses.insert(tagId, resultClass);
+	return resultClass;
+}
+
+void PgnGameEntryIndex::append(const QList<const PgnGameEntry*>& entries)
+{
+	const int first = m_entryCount;
+	const int firstDate = m_dates.size();
+	m_entryCount += entries.size();
+
+	for (int i = 0; i < ResultClassCount; i++)
+		m_results[i].resize((m_entryCount + 63) / 64);
+
+	int number = first;
+	for (const PgnGameEntry* entry : entries)
+	{
+		for (int i = 0; i < ColumnCount; i++)
+			m_postings[i][entry->tagId(s_columnTags[i])].append(number);
+
+		const QDate date(entry->date());
+		if (date.isValid())
+			m_dates.append({ date.toJulianDay(), number });
+		else
+			m_undated.append(number);
+
+		int rc = resultClass(entry->tagId(PgnGameEntry::ResultTag));
+		if (rc != -1)
+			m_results[rc][number / 64] |= Q_UINT64_C(1) << (number % 64);
+
+		number++;
+	}
+
+	// Keep the dates sorted by day and then by entry number
+	auto byDay = [](const DateEntry& a, const DateEntry& b)
+	{
+		return a.day < b.day;
+	};
+	std::stable_sort(m_dates.begin() + firstDate, m_dates.end(), byDay);
+	std::inplace_merge(m_dates.begin(), m_dates.begin() + firstDate,
+			   m_dates.end(), byDay);
+}
+
+QVector<int> PgnGameEntryIndex::matching(Column column,
+					 PgnGameFilter::Term term,
+					 const PgnGameFilter& filter) const
+{
+	QVector<int> entries;
+	const QHash<int, QVector<int>>& postings = m_postings[column];
+
+	for (auto it = postings.constBegin(); it != postings.constEnd(); ++it)
+	{
+		if (filter.matchLength(term, it.key()) != -1)
+			entries += it.value();
+	}
+	std::sort(entries.begin(), entries.end());
+
+	return entries;
+}
+
+QVector<int> PgnGameEntryIndex::playerMatching(PgnGameFilter::Term term,
+					       const PgnGameFilter& filter) const
+{
+	// A player of either color; the same game can be found
+	// through both columns
+	QVector<int> entries = matching(WhiteColumn, term, filter);
+	entries += matching(BlackColumn, term, filter);
+
+	std::sort(entries.begin(), entries.end());
+	entries.erase(std::unique(entries.begin(), entries.end()),
+		      entries.end());
+
+	return entries;
+}
+
+QVector<int> PgnGameEntryIndex::dateMatching(const PgnGameFilter& filter) const
+{
+	DateEntry min = { std::numeric_limits<qint64>::min(), 0 };
+	DateEntry max = { std::numeric_limits<qint64>::max(), 0 };
+	if (!filter.minDate().isNull())
+		min.day = filter.minDate().toJulianDay();
+	if (!filter.maxDate().isNull())
+		max.day = filter.maxDate().toJulianDay();
+
+	auto byDay = [](const DateEntry& a, const DateEntry& b)
+	{
+		return a.day < b.day;
+	};
+	auto begin = std::lower_bound(m_dates.constBegin(), m_dates.constEnd(),
+				      min, byDay);
+	auto end = std::upper_bound(begin, m_dates.constEnd(), max, byDay);
+
+	QVector<int> dated;
+	dated.reserve(int(end - begin));
+	for (auto it = begin; it != end; ++it)
+		dated.append(it->entry);
+	std::sort(dated.begin(), dated.end());
+
+	// Entries without a valid date are left for PgnGameEntry::match()
+	QVector<int> entries;
+	entries.reserve(dated.size() + m_undated.size());
+	std::merge(dated.constBegin(), dated.constEnd(),
+		   m_undated.constBegin(), m_undated.constEnd(),
+		   std::back_inserter(entries));
+
+	return entries;
+}
+
+bool PgnGameEntryIndex::resultBitmap(const PgnGameFilter& filter,
+				     QVector<quint64>* bitmap) const
+{
+	switch (filter.result())
+	{
+	case PgnGameFilter::EitherPlayerWins:
+		*bitmap = m_results[WhiteWinsClass];
+		for (int i = 0; i < bitmap->size(); i++)
+			(*bitmap)[i] |= m_results[BlackWinsClass].at(i);
+		break;
+	case PgnGameFilter::WhiteWins:
+		*bitmap = m_results[WhiteWinsClass];
+		break;
+	case PgnGameFilter::BlackWins:
+		*bitmap = m_results[BlackWinsClass];
+		break;
+	case PgnGameFilter::Draw:
+		*bitmap = m_results[DrawClass];
+		break;
+	case PgnGameFilter::Unfinished:
+		*bitmap = m_results[UnfinishedClass];
+		break;
+	default:
+		// The first player's result depends on the names
+		return false;
+	}
+
+	if (filter.isResultInverted())
+	{
+		for (int i = 0; i < bitmap->size(); i++)
+			(*bitmap)[i] = ~bitmap->at(i);
+		if (m_entryCount % 64 != 0)
+			bitmap->last() &= (Q_UINT64_C(1) << (m_entryCount % 64)) - 1;
+	}
+
+	return true;
+}
+
+bool PgnGameEntryIndex::candidates(const PgnGameFilter& filter,
+				   QVector<int>* entries) const
+{
+	Q_ASSERT(entries != nullptr);
+
+	if (filter.type() != PgnGameFilter::Advanced)
+		return false;
+
+	QVector<QVector<int>> lists;
+	const bool hasPlayer = *filter.player() != 0;
+	const bool hasOpponent = *filter.opponent() != 0;
+
+	if (*filter.event() != 0)
+		lists.append(matching(EventColumn, PgnGameFilter::EventTerm, filter));
+	if (*filter.site() != 0)
+		lists.append(matching(SiteColumn, PgnGameFilter::SiteTerm, filter));
+
+	if (filter.playerSide() == Chess::Side::White)
+	{
+		if (hasPlayer)
+			lists.append(matching(WhiteColumn, PgnGameFilter::PlayerTerm, filter));
+		if (hasOpponent)
+			lists.append(matching(BlackColumn, PgnGameFilter::OpponentTerm, filter));
+	}
+	else if (filter.playerSide() == Chess::Side::Black)
+	{
+		if (hasPlayer)
+			lists.append(matching(BlackColumn, PgnGameFilter::PlayerTerm, filter));
+		if (hasOpponent)
+			lists.append(matching(WhiteColumn, PgnGameFilter::OpponentTerm, filter));
+	}
+	else
+	{
+		if (hasPlayer)
+			lists.append(playerMatching(PgnGameFilter::PlayerTerm, filter));
+		if (hasOpponent)
+			lists.append(playerMatching(PgnGameFilter::OpponentTerm, filter));
+	}
+
+	if (!filter.minDate().isNull() || !filter.maxDate().isNull())
+		lists.append(dateMatching(filter));
+
+	QVector<quint64> bitmap;
+	const bool hasBitmap = resultBitmap(filter, &bitmap);
+
+	if (lists.isEmpty() && !hasBitmap)
+		return false;
+
+	QVector<int> result;
+	if (lists.isEmpty())
+	{
+		for (int i = 0; i < bitmap.size(); i++)
+		{
+			quint64 bits = bitmap.at(i);
+			while (bits != 0)
+			{
+				result.append(i * 64 + int(qCountTrailingZeroBits(bits)));
+				bits &= bits - 1;
+			}
+		}
+	}
+	else
+	{
+		// Intersect the shortest lists first
+		std::sort(lists.begin(), lists.end(),
+			  [](const QVector<int>& a, const QVector<int>& b)
+		{
+			return a.size() < b.size();
+		});
+
+		result = lists.first();
+		for (int i = 1; i < lists.size() && !result.isEmpty(); i++)
+			result = s_intersection(result, lists.at(i));
+
+		if (hasBitmap)
+		{
+			auto notInBitmap = [&bitmap](int entry)
+			{
+				return !(bitmap.at(entry / 64) & (Q_UINT64_C(1) << (entry % 64)));
+			};
+			result.erase(std::remove_if(result.begin(), result.end(),
+						    notInBitmap),
+				     result.end());
+		}
+	}
+
+	*entries = result;
+	return true;
+}
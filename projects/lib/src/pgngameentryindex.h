@@ -0,0 +1,117 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNGAMEENTRYINDEX_H
+#define PGNGAMEENTRYINDEX_H
+
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include "pgngamefilter.h"
+class PgnGameEntry;
+
+/*!
+ * \brief A search index of PGN game entries.
+ *
+ * PgnGameEntryIndex stores the entries of a game collection by
+ * column: a list of entry numbers for each distinct event, site and
+ * player name, the entries sorted by date, and a bitmap of the
+ * entries for each kind of game result. An advanced PgnGameFilter
+ * can then be answered by intersecting the lists of the matching
+ * values instead of matching every entry.
+ *
+ * The index only narrows down the search; the candidates() may
+ * still contain entries that don't match the filter, so they
+ * should be checked with PgnGameEntry::match().
+ *
+ * \sa PgnGameEntry, PgnGameFilter
+ */
+class LIB_EXPORT PgnGameEntryIndex
+{
+	public:
+		/*! Creates a new empty index. */
+		PgnGameEntryIndex();
+
+		/*! Returns the number of indexed entries. */
+		int entryCount() const;
+		/*! Removes all entries from the index. */
+		void clear();
+		/*!
+		 * Adds \a entries to the index. The first entry of
+		 * \a entries gets entry number entryCount().
+		 *
+		 * The index doesn't take ownership of the entries or
+		 * keep pointers to them.
+		 */
+		void append(const QList<const PgnGameEntry*>& entries);
+
+		/*!
+		 * Stores the numbers of the entries that can match
+		 * \a filter in \a entries, in ascending order.
+		 *
+		 * Returns false if the index can't narrow down the search
+		 * for \a filter, eg. for \a FixedString filters. Then every
+		 * entry has to be matched and \a entries is left untouched.
+		 *
+		 * \note \a filter should be prepared with
+		 * PgnGameFilter::prepare() first.
+		 */
+		bool candidates(const PgnGameFilter& filter,
+				QVector<int>* entries) const;
+
+	private:
+		enum Column
+		{
+			EventColumn,
+			SiteColumn,
+			WhiteColumn,
+			BlackColumn,
+			ColumnCount
+		};
+		enum ResultClass
+		{
+			WhiteWinsClass,
+			BlackWinsClass,
+			DrawClass,
+			UnfinishedClass,
+			ResultClassCount
+		};
+		struct DateEntry
+		{
+			qint64 day;
+			int entry;
+		};
+
+		QVector<int> matching(Column column,
+				      PgnGameFilter::Term term,
+				      const PgnGameFilter& filter) const;
+		QVector<int> playerMatching(PgnGameFilter::Term term,
+					    const PgnGameFilter& filter) const;
+		QVector<int> dateMatching(const PgnGameFilter& filter) const;
+		bool resultBitmap(const PgnGameFilter& filter,
+				  QVector<quint64>* bitmap) const;
+		int resultClass(int tagId);
+
+		int m_entryCount;
+		QHash<int, QVector<int>> m_postings[ColumnCount];
+		QVector<DateEntry> m_dates;
+		QVector<int> m_undated;
+		QVector<quint64> m_results[ResultClassCount];
+		QHash<int, int> m_resultClasses;
+};
+
+#endif // PGNGAMEENTRYINDEX_H
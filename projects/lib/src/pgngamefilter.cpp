@@ -17,8 +17,51 @@
 */
 
 #include "pgngamefilter.h"
+#include <cctype>
 #include "pgngameentry.h"
+#include "pgntagtable.h"
 
+namespace {
+
+int s_stringContains(const char* s1, const char* s2, int size)
+{
+	Q_ASSERT(s1 != nullptr);
+	Q_ASSERT(s2 != nullptr);
+	Q_ASSERT(size >= 0);
+
+	if (!*s2)
+		return 0;
+	if (size == 0)
+		return -1;
+
+	const char* s1_end = s1 + size;
+
+	while (s1 < s1_end)
+	{
+		if (toupper(*s1) == toupper(*s2))
+		{
+			const char* a = s1 + 1;
+			const char* b = s2 + 1;
+
+			while (*b && a < s1_end)
+			{
+				if (toupper(*a) != toupper(*b))
+					break;
+				a++;
+				b++;
+			}
+			if (!*b)
+				return b - s2;
+			if (a == s1_end)
+				return -1;
+		}
+		s1++;
+	}
+
+	return -1;
+}
+
+} // anonymous namespace
 
 PgnGameFilter::PgnGameFilter()
 	: m_type(Advanced),
@@ -43,27 +86,32 @@ void PgnGameFilter::setPattern(const QString& pattern)
 {
 	m_type = FixedString;
 	m_pattern = pattern.toLatin1();
+	m_matches.clear();
 }
 
 void PgnGameFilter::setEvent(const QString& event)
 {
 	m_event = event.toLatin1();
+	m_matches.clear();
 }
 
 void PgnGameFilter::setSite(const QString& site)
 {
 	m_site = site.toLatin1();
+	m_matches.clear();
 }
 
 void PgnGameFilter::setPlayer(const QString& name, Chess::Side side)
 {
 	m_player = name.toLatin1();
 	m_playerSide = side;
+	m_matches.clear();
 }
 
 void PgnGameFilter::setOpponent(const QString& name)
 {
 	m_opponent = name.toLatin1();
+	m_matches.clear();
 }
 
 void PgnGameFilter::setMinDate(const QDate& date)
@@ -95,3 +143,67 @@ void PgnGameFilter::setResultInverted(bool invert)
 {
 	m_resultInverted = invert;
 }
+
+void PgnGameFilter::setVariant(const QString& variant)
+{
+	m_variant = variant.toLatin1();
+}
+
+const QByteArray& PgnGameFilter::termString(Term term) const
+{
+	switch (term)
+	{
+	case PatternTerm:
+		return m_pattern;
+	case EventTerm:
+		return m_event;
+	case SiteTerm:
+		return m_site;
+	case PlayerTerm:
+		return m_player;
+	default:
+		return m_opponent;
+	}
+}
+
+void PgnGameFilter::prepare()
+{
+	const PgnTagTable* table = PgnTagTable::instance();
+	TagMatches* matches = new TagMatches;
+	matches->count = table->count();
+
+	for (int term = 0; term <= OpponentTerm; term++)
+	{
+		QVector<qint8>& lengths = matches->lengths[term];
+		const QByteArray& str = termString(Term(term));
+
+		// Only the terms that are used are matched in advance
+		if ((m_type == FixedString) != (term == PatternTerm)
+		||  str.isEmpty())
+			continue;
+
+		lengths.resize(matches->count);
+		for (int id = 0; id < matches->count; id++)
+		{
+			const QByteArray& value = table->value(id);
+			lengths[id] = qint8(s_stringContains(value.constData(),
+							     str.constData(),
+							     value.size()));
+		}
+	}
+
+	m_matches.reset(matches);
+}
+
+int PgnGameFilter::matchLength(Term term, int tagId) const
+{
+	const QByteArray& str = termString(term);
+	if (str.isEmpty())
+		return 0;
+	if (m_matches && tagId < m_matches->lengths[term].size())
+		return m_matches->lengths[term].at(tagId);
+
+	const QByteArray& value = PgnTagTable::instance()->value(tagId);
+	return s_stringContains(value.constData(), str.constData(),
+				value.size());
+}
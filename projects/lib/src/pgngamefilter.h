@@ -21,6 +21,8 @@
 
 #include <QByteArray>
 #include <QDate>
+#include <QVector>
+#include <QSharedPointer>
 #include "board/side.h"
 class QString;
 class PgnGameEntry;
@@ -58,6 +60,15 @@ class LIB_EXPORT PgnGameFilter
 			Draw,			//!< The game is a draw
 			Unfinished		//!< The game wasn't completed
 		};
+		/*! A filtering term that is matched against tag values. */
+		enum Term
+		{
+			PatternTerm,	//!< The \a FixedString pattern
+			EventTerm,	//!< The \a Event tag filter
+			SiteTerm,	//!< The \a Site tag filter
+			PlayerTerm,	//!< The first player's filter
+			OpponentTerm	//!< The opponent's filter
+		};
 
 		/*!
 		 * Creates a new empty filter.
@@ -118,6 +129,12 @@ class LIB_EXPORT PgnGameFilter
 		 * of \a result(); otherwise returns false.
 		 */
 		bool isResultInverted() const;
+		/*!
+		 * Returns the filter for the \a Variant tag.
+		 *
+		 * \note An empty string won't filter out any games.
+		 */
+		const char* variant() const;
 
 		/*!
 		 * Sets the \a FixedString pattern to \a pattern.
@@ -146,8 +163,43 @@ class LIB_EXPORT PgnGameFilter
 		void setResult(Result result);
 		/*! Sets the \a resultInverted value to \a invert. */
 		void setResultInverted(bool invert);
+		/*!
+		 * Sets the \a Variant tag filter to \a variant.
+		 *
+		 * Unlike the other terms, the variant has to match exactly
+		 * (ignoring case), and games without a \a Variant tag are
+		 * standard chess games.
+		 */
+		void setVariant(const QString& variant);
+
+		/*!
+		 * Matches the filtering terms against every tag value in
+		 * PgnTagTable, so that matching game entries afterwards only
+		 * needs to look up the results by tag ID.
+		 *
+		 * This should be called before filtering a whole database.
+		 * Changing the filter discards the prepared results.
+		 */
+		void prepare();
+		/*!
+		 * Returns the length of the filtering term \a term if the
+		 * tag value identified by \a tagId contains it, or -1 if it
+		 * doesn't. The matching is case insensitive, and an empty
+		 * term matches every value.
+		 *
+		 * \sa PgnTagTable
+		 */
+		int matchLength(Term term, int tagId) const;
 
 	private:
+		struct TagMatches
+		{
+			int count;
+			QVector<qint8> lengths[OpponentTerm + 1];
+		};
+
+		const QByteArray& termString(Term term) const;
+
 		Type m_type;
 		QByteArray m_pattern;
 		QByteArray m_event;
@@ -161,6 +213,8 @@ class LIB_EXPORT PgnGameFilter
 		int m_maxRound;
 		Result m_result;
 		bool m_resultInverted;
+		QByteArray m_variant;
+		QSharedPointer<const TagMatches> m_matches;
 };
 
 inline PgnGameFilter::Type PgnGameFilter::type() const
@@ -213,6 +267,11 @@ inline bool PgnGameFilter::isResultInverted() const
 	return m_resultInverted;
 }
 
+inline const char* PgnGameFilter::variant() const
+{
+	return m_variant.constData();
+}
+
 inline const char* PgnGameFilter::player() const
 {
 	return m_player.constData();
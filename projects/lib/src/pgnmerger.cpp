@@ -0,0 +1,308 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgnmerger.h"
+#include <algorithm>
+#include <vector>
+#include <QVector>
+#include "pgnstream.h"
+#include "pgnchunkreader.h"
+
+namespace {
+
+// The size of the PGN chunks read from each input at once
+const int s_chunkSize = 1024 * 1024;
+// The size of the output buffer
+const int s_bufferSize = 4 * 1024 * 1024;
+
+struct MergeGame
+{
+	qint64 number;
+	// The position of the game in its file, which orders the
+	// games with the same number
+	qint64 sequence;
+	bool numbered;
+	QByteArray data;
+};
+
+// Orders a heap so that the game with the smallest number is on top
+bool laterGame(const MergeGame& a, const MergeGame& b)
+{
+	if (a.number != b.number)
+		return a.number > b.number;
+	return a.sequence > b.sequence;
+}
+
+/*! The games of one input file, put in order within a window. */
+class MergeSource
+{
+	public:
+		MergeSource(const QString& fileName, int window)
+			: m_fileName(fileName),
+			  m_window(window),
+			  m_start(-1),
+			  m_sequence(0),
+			  m_number(0),
+			  m_lastNumber(0),
+			  m_sorted(true)
+		{
+		}
+
+		bool open()
+		{
+			m_reader.setChunkSize(s_chunkSize);
+			return m_reader.open(m_fileName);
+		}
+
+		// Takes the game with the smallest number in the window
+		bool next(MergeGame* game)
+		{
+			while (int(m_games.size()) <= m_window)
+			{
+				MergeGame newGame;
+				if (!readGame(&newGame))
+					break;
+				m_games.push_back(newGame);
+				std::push_heap(m_games.begin(), m_games.end(), laterGame);
+			}
+			if (m_games.empty())
+				return false;
+
+			std::pop_heap(m_games.begin(), m_games.end(), laterGame);
+			*game = m_games.back();
+			m_games.pop_back();
+
+			if (game->number < m_lastNumber && m_sorted)
+			{
+				qWarning("%s is out of order by more than %d games, "
+					 "the output isn't sorted",
+					 qUtf8Printable(m_fileName), m_window);
+				m_sorted = false;
+			}
+			m_lastNumber = qMax(m_lastNumber, game->number);
+			return true;
+		}
+
+	private:
+		bool readChunk()
+		{
+			PgnChunkReader::Chunk chunk;
+			if (!m_reader.readChunk(&chunk))
+				return false;
+
+			m_chunk = chunk.data;
+			m_in.setString(&m_chunk);
+			m_start = m_in.nextGame() ? m_in.pos() : -1;
+			return true;
+		}
+
+		// Reads the next game in file order
+		bool readGame(MergeGame* game)
+		{
+			while (m_start < 0)
+			{
+				if (!readChunk())
+					return false;
+			}
+
+			game->numbered = false;
+			while (m_in.readNext() == PgnStream::PgnTag)
+			{
+				if (m_in.tagName() != "GameNumber")
+					continue;
+				bool ok = false;
+				const qint64 number = m_in.tagValue().toLongLong(&ok);
+				if (ok)
+				{
+					m_number = number;
+					game->numbered = true;
+				}
+			}
+			game->number = m_number;
+			game->sequence = m_sequence++;
+
+			// A game ends where the next one begins, so the games
+			// are copied with their comments and formatting intact
+			const qint64 start = m_start;
+			m_start = m_in.nextGame() ? m_in.pos() : -1;
+			const qint64 end = (m_start >= 0) ? m_start : m_chunk.size();
+			game->data = m_chunk.mid(int(start), int(end - start));
+			if (!game->data.endsWith('\n'))
+				game->data += "\n\n";
+
+			return true;
+		}
+
+		QString m_fileName;
+		int m_window;
+		PgnChunkReader m_reader;
+		QByteArray m_chunk;
+		PgnStream m_in;
+		qint64 m_start;
+		qint64 m_sequence;
+		qint64 m_number;
+		qint64 m_lastNumber;
+		bool m_sorted;
+		std::vector<MergeGame> m_games;
+};
+
+} // anonymous namespace
+
+PgnMerger::PgnMerger()
+	: m_window(1024),
+	  m_ordered(true),
+	  m_gameCount(0),
+	  m_duplicateCount(0),
+	  m_failed(false)
+{
+}
+
+int PgnMerger::window() const
+{
+	return m_window;
+}
+
+void PgnMerger::setWindow(int games)
+{
+	m_window = qMax(0, games);
+}
+
+void PgnMerger::setOrdered(bool enabled)
+{
+	m_ordered = enabled;
+}
+
+qint64 PgnMerger::gameCount() const
+{
+	return m_gameCount;
+}
+
+qint64 PgnMerger::duplicateCount() const
+{
+	return m_duplicateCount;
+}
+
+bool PgnMerger::open(const QString& fileName)
+{
+	m_out.setFileName(fileName);
+	if (!m_out.open(QIODevice::WriteOnly))
+	{
+		qWarning("Can't open PGN file %s", qUtf8Printable(fileName));
+		return false;
+	}
+	return true;
+}
+
+void PgnMerger::write(const QByteArray& game)
+{
+	m_gameCount++;
+	m_buffer += game;
+	if (m_buffer.size() < s_bufferSize)
+		return;
+
+	if (!m_failed && m_out.write(m_buffer) != m_buffer.size())
+	{
+		qWarning("Can't write to PGN file %s",
+			 qUtf8Printable(m_out.fileName()));
+		m_failed = true;
+	}
+	m_buffer.clear();
+}
+
+bool PgnMerger::merge(const QStringList& fileNames)
+{
+	Q_ASSERT(m_out.isOpen());
+
+	QVector<MergeSource*> sources;
+	for (const QString& fileName : fileNames)
+	{
+		sources.append(new MergeSource(fileName, m_ordered ? m_window : 0));
+		if (!sources.last()->open())
+		{
+			qDeleteAll(sources);
+			return false;
+		}
+	}
+
+	MergeGame game;
+	if (!m_ordered)
+	{
+		for (MergeSource* source : qAsConst(sources))
+		{
+			while (!m_failed && source->next(&game))
+				write(game.data);
+		}
+		qDeleteAll(sources);
+		return !m_failed;
+	}
+
+	// The next game of every input, with the input's index as the
+	// sequence so that ties are taken in the order of the inputs
+	std::vector<MergeGame> heads;
+	auto pull = [&](int index)
+	{
+		if (!sources.at(index)->next(&game))
+			return;
+		game.sequence = index;
+		heads.push_back(game);
+		std::push_heap(heads.begin(), heads.end(), laterGame);
+	};
+	for (int i = 0; i < sources.size(); i++)
+		pull(i);
+
+	bool haveLast = false;
+	qint64 lastNumber = 0;
+	while (!heads.empty() && !m_failed)
+	{
+		std::pop_heap(heads.begin(), heads.end(), laterGame);
+		MergeGame head(heads.back());
+		heads.pop_back();
+		pull(int(head.sequence));
+
+		if (head.numbered && haveLast && head.number == lastNumber)
+		{
+			m_duplicateCount++;
+			continue;
+		}
+		if (head.numbered)
+		{
+			haveLast = true;
+			lastNumber = head.number;
+		}
+		write(head.data);
+	}
+
+	qDeleteAll(sources);
+	return !m_failed;
+}
+
+bool PgnMerger::close()
+{
+	if (!m_failed && !m_buffer.isEmpty()
+	&&  m_out.write(m_buffer) != m_buffer.size())
+		m_failed = true;
+	m_buffer.clear();
+
+	if (m_failed || !m_out.commit())
+	{
+		qWarning("Can't write PGN file %s",
+			 qUtf8Printable(m_out.fileName()));
+		return false;
+	}
+	return true;
+}
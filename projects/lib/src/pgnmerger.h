@@ -0,0 +1,101 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNMERGER_H
+#define PGNMERGER_H
+
+#include <QString>
+#include <QStringList>
+#include <QSaveFile>
+
+/*!
+ * \brief Merges PGN shards into one file in the order of game numbers
+ *
+ * PgnMerger does a k-way merge of PGN files, eg. the shards written by
+ * Tournament::setPgnShardCount() or by distributed workers, ordering
+ * the games by their "GameNumber" tag. The games are copied byte for
+ * byte; only their tags are read.
+ *
+ * Each input may be out of order by at most window() games, which is
+ * enough for games saved as they finish. A game without a GameNumber
+ * tag keeps its place after the previous game of its file. When two
+ * games have the same number, eg. a game that was played again after
+ * resuming a tournament, only the first one is kept.
+ *
+ * \sa PgnExtractor
+ */
+class LIB_EXPORT PgnMerger
+{
+	public:
+		/*! Creates a new merger. */
+		PgnMerger();
+
+		/*!
+		 * Returns the number of games that are read ahead from each
+		 * input to put it in order. The default is 1024.
+		 */
+		int window() const;
+		/*! Sets the reorder window to \a games. */
+		void setWindow(int games);
+		/*!
+		 * Sets ordering by game number to \a enabled. If \a enabled
+		 * is false, the inputs are concatenated in the order they
+		 * are given. The default is true.
+		 */
+		void setOrdered(bool enabled);
+
+		/*!
+		 * Opens the PGN file \a fileName for writing. The file is
+		 * replaced when close() is called.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool open(const QString& fileName);
+		/*!
+		 * Merges the PGN files \a fileNames into the output file.
+		 * The files may be compressed with gzip or Zstandard.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool merge(const QStringList& fileNames);
+		/*!
+		 * Finishes writing the output file.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool close();
+
+		/*! Returns the number of games written so far. */
+		qint64 gameCount() const;
+		/*! Returns the number of duplicate games dropped so far. */
+		qint64 duplicateCount() const;
+
+	private:
+		Q_DISABLE_COPY(PgnMerger)
+
+		void write(const QByteArray& game);
+
+		int m_window;
+		bool m_ordered;
+		qint64 m_gameCount;
+		qint64 m_duplicateCount;
+		QByteArray m_buffer;
+		QSaveFile m_out;
+		bool m_failed;
+};
+
+#endif // PGNMERGER_H
@@ -20,10 +20,52 @@
 #include <cctype>
 #include <cstring>
 #include <QIODevice>
+#include <QFile>
 #include "board/boardfactory.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace {
 
+/*!
+ * Returns a pointer to the first character in range [\a begin, \a end)
+ * that is one of the \a count characters in \a chars, or \a end if
+ * there is no such character.
+ */
+const char* findFirstOf(const char* begin,
+			const char* end,
+			const char* chars,
+			int count)
+{
+#ifdef __SSE2__
+	// Compare 16 characters at a time against each delimiter
+	Q_ASSERT(count <= 8);
+	__m128i delims[8];
+	for (int i = 0; i < count; i++)
+		delims[i] = _mm_set1_epi8(chars[i]);
+
+	while (end - begin >= 16)
+	{
+		__m128i block = _mm_loadu_si128((const __m128i*)begin);
+		__m128i match = _mm_cmpeq_epi8(block, delims[0]);
+		for (int i = 1; i < count; i++)
+			match = _mm_or_si128(match, _mm_cmpeq_epi8(block, delims[i]));
+
+		int mask = _mm_movemask_epi8(match);
+		if (mask != 0)
+			return begin + qCountTrailingZeroBits(quint32(mask));
+		begin += 16;
+	}
+#endif
+	for (; begin != end; ++begin)
+	{
+		if (memchr(chars, *begin, count))
+			break;
+	}
+	return begin;
+}
+
 void skipSection(PgnStream* in, char start)
 {
 	char end;
@@ -61,10 +103,14 @@ PgnStream::PgnStream(const QString& variant)
 	: m_board(nullptr),
 	  m_pos(0),
 	  m_lineNumber(1),
+	  m_lineCountPos(-1),
 	  m_lastChar(0),
 	  m_tokenType(NoToken),
 	  m_device(nullptr),
 	  m_string(nullptr),
+	  m_data(nullptr),
+	  m_size(0),
+	  m_textMode(false),
 	  m_status(Ok),
 	  m_phase(OutOfGame)
 {
@@ -72,14 +118,16 @@ PgnStream::PgnStream(const QString& variant)
 }
 
 PgnStream::PgnStream(QIODevice* device, const QString& variant)
-	: m_board(nullptr)
+	: m_board(nullptr),
+	  m_data(nullptr)
 {
 	setVariant(variant);
 	setDevice(device);
 }
 
 PgnStream::PgnStream(const QByteArray* string, const QString& variant)
-	: m_board(nullptr)
+	: m_board(nullptr),
+	  m_data(nullptr)
 {
 	setVariant(variant);
 	setString(string);
@@ -87,13 +135,28 @@ PgnStream::PgnStream(const QByteArray* string, const QString& variant)
 
 PgnStream::~PgnStream()
 {
+	unmapFile();
 	delete m_board;
 }
 
+void PgnStream::unmapFile()
+{
+	// If the file was already destroyed it unmapped itself
+	if (m_data != nullptr && m_mappedFile != nullptr)
+		m_mappedFile->unmap((uchar*)m_data);
+
+	m_mappedFile = nullptr;
+	m_data = nullptr;
+	m_size = 0;
+	m_textMode = false;
+}
+
 void PgnStream::reset()
 {
+	unmapFile();
 	m_pos = 0;
 	m_lineNumber = 1;
+	m_lineCountPos = -1;
 	m_lastChar = 0;
 	m_tokenString.clear();
 	m_tagName.clear();
@@ -121,6 +184,20 @@ void PgnStream::setDevice(QIODevice* device)
 
 	reset();
 	m_device = device;
+
+	QFile* file = qobject_cast<QFile*>(device);
+	if (file == nullptr || !file->isOpen() || file->size() <= 0)
+		return;
+
+	uchar* data = file->map(0, file->size());
+	if (data == nullptr)
+		return;
+
+	m_mappedFile = file;
+	m_data = (const char*)data;
+	m_size = file->size();
+	m_pos = file->pos();
+	m_textMode = file->isTextModeEnabled();
 }
 
 const QByteArray* PgnStream::string() const
@@ -145,7 +222,7 @@ bool PgnStream::setVariant(const QString& variant)
 {
 	if (m_board != nullptr && m_board->variant() == variant)
 		return true;
-	if (!Chess::BoardFactory::variants().contains(variant))
+	if (!Chess::BoardFactory::isVariant(variant))
 		return false;
 
 	delete m_board;
@@ -162,6 +239,8 @@ bool PgnStream::isOpen() const
 
 qint64 PgnStream::pos() const
 {
+	if (m_data)
+		return m_pos;
 	if (m_device)
 		return m_device->pos();
 	return m_pos;
@@ -169,13 +248,44 @@ qint64 PgnStream::pos() const
 
 qint64 PgnStream::lineNumber() const
 {
+	if (m_lineCountPos == -1)
+		return m_lineNumber;
+
+	// Count the lines before the last seek position
+	const char* data;
+	qint64 size;
+	if (!contiguousData(&data, &size))
+		return -1;
+
+	const char* p = data;
+	const char* end = data + qMin(m_lineCountPos, size);
+	while ((p = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)))) != nullptr)
+	{
+		m_lineNumber++;
+		p++;
+	}
+	m_lineCountPos = -1;
+
 	return m_lineNumber;
 }
 
 char PgnStream::readChar()
 {
 	char c;
-	if (m_device)
+	if (m_data)
+	{
+		// Like QIODevice, drop carriage returns in text mode
+		do
+		{
+			if (m_pos >= m_size)
+			{
+				m_status = ReadPastEnd;
+				return 0;
+			}
+			c = m_data[m_pos++];
+		} while (c == '\r' && m_textMode);
+	}
+	else if (m_device)
 	{
 		if (!m_device->getChar(&m_lastChar))
 		{
@@ -210,7 +320,9 @@ void PgnStream::rewindChar()
 	Q_ASSERT(pos() > 0);
 
 	char c;
-	if (m_device)
+	if (m_data)
+		c = m_data[--m_pos];
+	else if (m_device)
 	{
 		c = m_lastChar;
 		m_device->ungetChar(m_lastChar);
@@ -231,7 +343,12 @@ bool PgnStream::seek(qint64 pos, qint64 lineNumber)
 		return false;
 
 	bool ok = false;
-	if (m_device)
+	if (m_data)
+	{
+		ok = pos <= m_size;
+		m_pos = pos;
+	}
+	else if (m_device)
 	{
 		ok = m_device->seek(pos);
 		m_pos = 0;
@@ -245,7 +362,16 @@ bool PgnStream::seek(qint64 pos, qint64 lineNumber)
 		return false;
 
 	m_status = Ok;
-	m_lineNumber = lineNumber;
+	if (lineNumber < 0)
+	{
+		m_lineNumber = 1;
+		m_lineCountPos = pos;
+	}
+	else
+	{
+		m_lineNumber = lineNumber;
+		m_lineCountPos = -1;
+	}
 	m_lastChar = 0;
 	m_phase = OutOfGame;
 
@@ -257,10 +383,67 @@ PgnStream::Status PgnStream::status() const
 	return m_status;
 }
 
+bool PgnStream::contiguousData(const char** data, qint64* size) const
+{
+	if (m_data)
+	{
+		*data = m_data;
+		*size = m_size;
+		return true;
+	}
+	if (!m_device && m_string)
+	{
+		*data = m_string->constData();
+		*size = m_string->size();
+		return true;
+	}
+	return false;
+}
+
 void PgnStream::parseUntil(const char* chars)
 {
 	Q_ASSERT(chars != nullptr);
 
+	const char* data;
+	qint64 size;
+	if (contiguousData(&data, &size))
+	{
+		// A null character ends the token like the end of the
+		// data does, and carriage returns are skipped in text mode
+		char delims[8];
+		int count = 0;
+		for (; chars[count] != 0; count++)
+		{
+			Q_ASSERT(count < 6);
+			delims[count] = chars[count];
+		}
+		delims[count++] = 0;
+		if (m_textMode)
+			delims[count++] = '\r';
+
+		for (;;)
+		{
+			const char* begin = data + m_pos;
+			const char* end = data + size;
+			const char* found = findFirstOf(begin, end, delims, count);
+
+			m_tokenString.append(begin, int(found - begin));
+			m_pos = found - data;
+			if (found == end)
+			{
+				m_status = ReadPastEnd;
+				return;
+			}
+
+			char c = data[m_pos++];
+			if (c == '\n')
+				m_lineNumber++;
+			else if (c == '\r' && m_textMode)
+				continue;
+			return;
+		}
+	}
+
 	char c;
 	while ((c = readChar()) != 0)
 	{
@@ -337,6 +520,47 @@ void PgnStream::parseComment(char opBracket)
 	int level = 1;
 	char clBracket = (opBracket == '(') ? ')' : '}';
 
+	const char* data;
+	qint64 size;
+	if (contiguousData(&data, &size))
+	{
+		char delims[] = { opBracket, clBracket, '\n', 0, '\r' };
+		const int count = m_textMode ? 5 : 4;
+
+		for (;;)
+		{
+			const char* begin = data + m_pos;
+			const char* end = data + size;
+			const char* found = findFirstOf(begin, end, delims, count);
+
+			m_tokenString.append(begin, int(found - begin));
+			m_pos = found - data;
+			if (found == end)
+			{
+				m_status = ReadPastEnd;
+				return;
+			}
+
+			char c = data[m_pos++];
+			if (c == 0)
+				return;
+			if (c == '\r')
+				continue;
+			if (c == '\n')
+			{
+				m_lineNumber++;
+				if (m_tokenString.isEmpty())
+					continue;
+			}
+			else if (c == opBracket)
+				level++;
+			else if (c == clBracket && --level <= 0)
+				return;
+
+			m_tokenString.append(c);
+		}
+	}
+
 	char c;
 	while ((c = readChar()) != 0)
 	{
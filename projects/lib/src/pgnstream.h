@@ -21,7 +21,9 @@
 
 #include <QtGlobal>
 #include <QString>
+#include <QPointer>
 class QIODevice;
+class QFile;
 namespace Chess { class Board; }
 
 
@@ -104,7 +106,17 @@ class LIB_EXPORT PgnStream
 
 		/*! Returns the assigned device, or 0 if no device is in use. */
 		QIODevice* device() const;
-		/*! Sets the current device to \a device. */
+		/*!
+		 * Sets the current device to \a device.
+		 *
+		 * If \a device is an open QFile, the stream tries to map
+		 * the file into memory and reads it directly from there.
+		 * Otherwise, or if mapping fails, the stream reads the
+		 * device one character at a time.
+		 *
+		 * \note A mapped file must stay open while the stream
+		 * is being read.
+		 */
 		void setDevice(QIODevice* device);
 
 		/*! Returns the assigned string, or 0 if no string is in use. */
@@ -126,7 +138,13 @@ class LIB_EXPORT PgnStream
 		/*! Returns the current position in the stream. */
 		qint64 pos() const;
 
-		/*! Returns the current line number. */
+		/*!
+		 * Returns the current line number, or -1 if it isn't known.
+		 *
+		 * The line number is unknown only if seek() was called
+		 * without one on a stream that doesn't read a string or a
+		 * memory-mapped file.
+		 */
 		qint64 lineNumber() const;
 
 		/*! Resets the stream to its default state. */
@@ -152,6 +170,10 @@ class LIB_EXPORT PgnStream
 		/*!
 		 * Seeks to position \a pos in the device, and sets the current
 		 * line number to \a lineNumber.
+		 *
+		 * If \a lineNumber is -1, the line number is counted from the
+		 * start of the input when lineNumber() is called.
+		 *
 		 * Returns true if successful; otherwise returns false.
 		 */
 		bool seek(qint64 pos, qint64 lineNumber = 1);
@@ -200,13 +222,16 @@ class LIB_EXPORT PgnStream
 			InGame
 		};
 
+		bool contiguousData(const char** data, qint64* size) const;
 		void parseUntil(const char* chars);
 		void parseTag();
 		void parseComment(char opBracket);
+		void unmapFile();
 
 		Chess::Board* m_board;
 		qint64 m_pos;
-		qint64 m_lineNumber;
+		mutable qint64 m_lineNumber;
+		mutable qint64 m_lineCountPos;
 		char m_lastChar;
 		QByteArray m_tokenString;
 		QByteArray m_tagName;
@@ -214,6 +239,10 @@ class LIB_EXPORT PgnStream
 		TokenType m_tokenType;
 		QIODevice* m_device;
 		const QByteArray* m_string;
+		QPointer<QFile> m_mappedFile;
+		const char* m_data;
+		qint64 m_size;
+		bool m_textMode;
 		Status m_status;
 		Phase m_phase;
 };
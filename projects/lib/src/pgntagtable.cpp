@@ -0,0 +1,83 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgntagtable.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+
+PgnTagTable::PgnTagTable()
+	: m_count(0)
+{
+	for (int i = 0; i < MaxSegments; i++)
+		m_segments[i] = nullptr;
+
+	// The empty value gets ID 0
+	m_segments[0] = new QByteArray[SegmentSize];
+	m_ids.insert(QByteArray(), 0);
+	m_count.storeRelease(1);
+}
+
+PgnTagTable::~PgnTagTable()
+{
+	for (int i = 0; i < MaxSegments; i++)
+		delete [] m_segments[i];
+}
+
+PgnTagTable* PgnTagTable::instance()
+{
+	static PgnTagTable s_table;
+	return &s_table;
+}
+
+int PgnTagTable::intern(const QByteArray& value)
+{
+	if (value.isEmpty())
+		return 0;
+
+	{
+		QReadLocker locker(&m_lock);
+		auto it = m_ids.constFind(value);
+		if (it != m_ids.constEnd())
+			return it.value();
+	}
+
+	QWriteLocker locker(&m_lock);
+	auto it = m_ids.constFind(value);
+	if (it != m_ids.constEnd())
+		return it.value();
+
+	int id = m_count.loadAcquire();
+	int segment = id >> SegmentBits;
+	if (segment >= MaxSegments)
+	{
+		qWarning("PgnTagTable: too many distinct tag values");
+		return 0;
+	}
+	if (m_segments[segment] == nullptr)
+		m_segments[segment] = new QByteArray[SegmentSize];
+
+	m_segments[segment][id & (SegmentSize - 1)] = value;
+	m_ids.insert(value, id);
+	m_count.storeRelease(id + 1);
+
+	return id;
+}
+
+int PgnTagTable::count() const
+{
+	return m_count.loadAcquire();
+}
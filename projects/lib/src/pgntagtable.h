@@ -0,0 +1,84 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNTAGTABLE_H
+#define PGNTAGTABLE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QAtomicInt>
+
+/*!
+ * \brief A table of interned PGN tag values.
+ *
+ * The same player names, events, sites and results appear in
+ * thousands of games of a large PGN database. PgnTagTable stores
+ * each distinct tag value once and identifies it by a small integer
+ * ID, so that a PgnGameEntry only needs to store the IDs of its tags,
+ * and filters can compare tags by their IDs.
+ *
+ * There is one table for the whole process, shared by all databases.
+ * Values are never removed from the table. Interning new values is
+ * thread-safe, and the value of a known ID can be read without
+ * locking.
+ *
+ * \sa PgnGameEntry, PgnGameFilter
+ */
+class LIB_EXPORT PgnTagTable
+{
+	public:
+		/*! Returns the table shared by all PGN game entries. */
+		static PgnTagTable* instance();
+
+		/*!
+		 * Returns the ID of \a value, adding \a value to the table
+		 * if it isn't there yet. The ID of an empty value is 0.
+		 */
+		int intern(const QByteArray& value);
+		/*! Returns the value whose ID is \a id. */
+		const QByteArray& value(int id) const;
+		/*! Returns the number of values in the table. */
+		int count() const;
+
+	private:
+		enum
+		{
+			SegmentBits = 12,
+			SegmentSize = 1 << SegmentBits,
+			MaxSegments = 4096
+		};
+
+		PgnTagTable();
+		~PgnTagTable();
+		Q_DISABLE_COPY(PgnTagTable)
+
+		QReadWriteLock m_lock;
+		QHash<QByteArray, int> m_ids;
+		// Values are stored in fixed-size segments that are never
+		// moved, so readers don't need to lock the table
+		QByteArray* m_segments[MaxSegments];
+		QAtomicInt m_count;
+};
+
+inline const QByteArray& PgnTagTable::value(int id) const
+{
+	Q_ASSERT(id >= 0 && id < m_count.loadAcquire());
+	return m_segments[id >> SegmentBits][id & (SegmentSize - 1)];
+}
+
+#endif // PGNTAGTABLE_H
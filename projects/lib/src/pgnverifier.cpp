@@ -0,0 +1,246 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgnverifier.h"
+#include <climits>
+#include <QThread>
+#include <QVector>
+#include <QStringList>
+#include <QScopedPointer>
+#include "pgnstream.h"
+#include "pgnchunkreader.h"
+#include "board/board.h"
+
+namespace {
+
+struct GameError
+{
+	int game;
+	qint64 line;
+	QString message;
+};
+
+/*! The verified games of one chunk of PGN input. */
+struct Chunk
+{
+	QByteArray output;
+	QVector<GameError> errors;
+	int games;
+};
+
+/*! Replays chunks of PGN games and checks their results. */
+class ChunkVerifier
+{
+	public:
+		ChunkVerifier(bool write, PgnGame::PgnMode mode)
+			: m_write(write),
+			  m_mode(mode)
+		{
+		}
+
+		Chunk verifyChunk(const QByteArray& data, qint64 firstLine) const
+		{
+			Chunk chunk;
+			chunk.games = 0;
+
+			PgnStream in(&data);
+			in.seek(0, firstLine);
+			PgnGame game;
+			for (;;)
+			{
+				// The Result tag is read first because
+				// PgnGame::read() replaces it with the
+				// termination marker
+				const qint64 pos = in.pos();
+				const qint64 line = in.lineNumber();
+				if (!game.readTags(in))
+					break;
+				const QString resultTag(game.tagValue(PgnGame::ResultTag));
+				in.seek(pos, line);
+				if (!game.read(in, INT_MAX - 1, m_write))
+					break;
+
+				const QString error(verify(game, resultTag, &in));
+				if (!error.isEmpty())
+				{
+					GameError e = { chunk.games, in.lineNumber(), error };
+					chunk.errors.append(e);
+				}
+				else if (m_write)
+					game.write(&chunk.output, m_mode);
+				chunk.games++;
+			}
+
+			return chunk;
+		}
+
+	private:
+		static QString verify(const PgnGame& game,
+				      const QString& resultTag,
+				      PgnStream* in)
+		{
+			if (in->tokenType() == PgnStream::PgnMove)
+				return QString("Can't play move %1 at ply %2")
+					.arg(QString::fromUtf8(in->tokenString()))
+					.arg(game.moves().size() + 1);
+			if (in->tokenType() != PgnStream::PgnResult)
+				return "No termination marker";
+
+			const QString result(game.tagValue(PgnGame::ResultTag));
+			if (resultTag.isEmpty())
+				return "No Result tag";
+			if (resultTag != result)
+				return QString("The Result tag %1 is different from "
+					       "the termination marker %2")
+					.arg(resultTag, result);
+
+			// The stream's board is only set up by the first move
+			QScopedPointer<Chess::Board> startBoard;
+			Chess::Board* board = in->board();
+			if (game.moves().isEmpty())
+			{
+				startBoard.reset(game.createBoard());
+				board = startBoard.data();
+				if (board == nullptr)
+					return "Invalid starting position";
+			}
+			const Chess::Result boardResult(board->result());
+			if (!boardResult.isNone()
+			&&  boardResult.toShortString() != result)
+				return QString("The result %1 doesn't match the "
+					       "final position: %2")
+					.arg(result, boardResult.description());
+
+			static const QStringList terminations = {
+				"abandoned", "adjudication", "death", "emergency",
+				"normal", "rules infraction", "time forfeit",
+				"unterminated", "stalled connection", "illegal move"
+			};
+			const QString termination(game.tagValue(PgnGame::TerminationTag));
+			if (termination.isEmpty())
+				return QString();
+			if (!terminations.contains(termination))
+				return QString("Unknown termination: %1").arg(termination);
+			if ((result == "*") != (termination == "unterminated"))
+				return QString("The termination %1 doesn't match "
+					       "the result %2")
+					.arg(termination, result);
+
+			return QString();
+		}
+
+		bool m_write;
+		PgnGame::PgnMode m_mode;
+};
+
+} // anonymous namespace
+
+PgnVerifier::PgnVerifier()
+	: m_threadCount(QThread::idealThreadCount()),
+	  m_mode(PgnGame::Verbose),
+	  m_gameCount(0),
+	  m_errorCount(0),
+	  m_failed(false)
+{
+}
+
+void PgnVerifier::setThreadCount(int count)
+{
+	m_threadCount = qMax(1, count);
+}
+
+qint64 PgnVerifier::gameCount() const
+{
+	return m_gameCount;
+}
+
+qint64 PgnVerifier::errorCount() const
+{
+	return m_errorCount;
+}
+
+bool PgnVerifier::open(const QString& fileName, PgnGame::PgnMode mode)
+{
+	m_mode = mode;
+	m_out.setFileName(fileName);
+	if (!m_out.open(QIODevice::WriteOnly))
+	{
+		qWarning("Can't open PGN file %s", qUtf8Printable(fileName));
+		return false;
+	}
+	return true;
+}
+
+bool PgnVerifier::addPgnFile(const QString& fileName)
+{
+	// Uncompressed files are mapped and split without copying
+	PgnChunkReader reader;
+	if (!reader.open(fileName))
+		return false;
+
+	const bool write = m_out.isOpen();
+	qint64 fileGames = 0;
+
+	auto collect = [&](const Chunk& result)
+	{
+		for (const GameError& error : result.errors)
+		{
+			qWarning("%s:%lld: game %lld: %s",
+				 qUtf8Printable(fileName), error.line,
+				 fileGames + error.game + 1,
+				 qUtf8Printable(error.message));
+		}
+		fileGames += result.games;
+		m_gameCount += result.games;
+		m_errorCount += result.errors.size();
+
+		if (write && !m_failed
+		&&  m_out.write(result.output) != result.output.size())
+		{
+			qWarning("Can't write to PGN file %s",
+				 qUtf8Printable(m_out.fileName()));
+			m_failed = true;
+		}
+	};
+
+	const ChunkVerifier verifier(write, m_mode);
+	reader.process([&verifier, &collect](const PgnChunkReader::Chunk& chunk)
+	{
+		const Chunk result(verifier.verifyChunk(chunk.data,
+							chunk.lineNumber));
+		return PgnChunkReader::Collector([&collect, result]()
+		{
+			collect(result);
+		});
+	}, m_threadCount);
+
+	return !m_failed;
+}
+
+bool PgnVerifier::close()
+{
+	if (!m_out.isOpen())
+		return !m_failed;
+	if (m_failed || !m_out.commit())
+	{
+		qWarning("Can't write PGN file %s",
+			 qUtf8Printable(m_out.fileName()));
+		return false;
+	}
+	return true;
+}
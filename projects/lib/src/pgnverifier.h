@@ -0,0 +1,105 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNVERIFIER_H
+#define PGNVERIFIER_H
+
+#include <QString>
+#include <QSaveFile>
+#include "pgngame.h"
+
+/*!
+ * \brief Verifies and normalizes large PGN collections
+ *
+ * The games are read with PgnGame::read() by a pool of worker threads,
+ * which replays every move. A game fails the verification if:
+ * - a move is illegal or can't be parsed
+ * - the game has no termination marker, or the marker is different
+ *   from the Result tag
+ * - the game ends in a position that decides the game by the rules,
+ *   eg. checkmate, with a different result
+ * - the Termination tag has an unknown value, or doesn't agree with
+ *   whether the game is finished
+ *
+ * The errors are printed with qWarning() in the order of the games,
+ * with the line where reading the game stopped. The games that pass
+ * can be written to a PGN file in the format of PgnGame::write(), in
+ * the order of the games in the input, regardless of the number of
+ * threads.
+ *
+ * Uncompressed files are mapped into memory and parsed in place.
+ *
+ * \note The PGN input is split between threads at lines that start
+ * with an Event tag, so a file without Event tags is parsed by a
+ * single thread.
+ *
+ * \sa EpdExtractor
+ */
+class LIB_EXPORT PgnVerifier
+{
+	public:
+		/*! Creates a new verifier. */
+		PgnVerifier();
+
+		/*!
+		 * Sets the number of worker threads to \a count.
+		 * The default is the number of CPU cores.
+		 */
+		void setThreadCount(int count);
+
+		/*!
+		 * Opens the PGN file \a fileName for writing the valid
+		 * games in \a mode. The file is replaced when close() is
+		 * called. Without an output file the games are only
+		 * verified.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool open(const QString& fileName,
+			  PgnGame::PgnMode mode = PgnGame::Verbose);
+		/*!
+		 * Verifies the games of PGN file \a fileName.
+		 * The file may be compressed with gzip or Zstandard.
+		 *
+		 * Returns false if the file can't be read or the output
+		 * can't be written, regardless of the games' errors.
+		 */
+		bool addPgnFile(const QString& fileName);
+		/*!
+		 * Finishes writing the output file.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool close();
+
+		/*! Returns the number of games read so far. */
+		qint64 gameCount() const;
+		/*! Returns the number of games that failed so far. */
+		qint64 errorCount() const;
+
+	private:
+		Q_DISABLE_COPY(PgnVerifier)
+
+		int m_threadCount;
+		PgnGame::PgnMode m_mode;
+		qint64 m_gameCount;
+		qint64 m_errorCount;
+		QSaveFile m_out;
+		bool m_failed;
+};
+
+#endif // PGNVERIFIER_H
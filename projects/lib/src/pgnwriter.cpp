@@ -0,0 +1,151 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pgnwriter.h"
+#include <QFileDevice>
+#include "compressedfile.h"
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+PgnWriter::PgnWriter(QIODevice* device)
+	: m_device(device),
+	  m_mode(PgnGame::Verbose),
+	  m_batchSize(1),
+	  m_syncInterval(0),
+	  m_bufferedGames(0),
+	  m_unsyncedGames(0)
+{
+	// A reserved buffer keeps its memory when it's emptied
+	m_buffer.reserve(64 * 1024);
+}
+
+PgnWriter::~PgnWriter()
+{
+	flush();
+}
+
+QIODevice* PgnWriter::device() const
+{
+	return m_device;
+}
+
+void PgnWriter::setDevice(QIODevice* device)
+{
+	flush();
+	m_device = device;
+	m_unsyncedGames = 0;
+}
+
+PgnGame::PgnMode PgnWriter::mode() const
+{
+	return m_mode;
+}
+
+void PgnWriter::setMode(PgnGame::PgnMode mode)
+{
+	m_mode = mode;
+}
+
+int PgnWriter::batchSize() const
+{
+	return m_batchSize;
+}
+
+void PgnWriter::setBatchSize(int games)
+{
+	m_batchSize = qMax(1, games);
+}
+
+int PgnWriter::syncInterval() const
+{
+	return m_syncInterval;
+}
+
+void PgnWriter::setSyncInterval(int games)
+{
+	m_syncInterval = qMax(0, games);
+}
+
+bool PgnWriter::write(const PgnGame& game)
+{
+	const int size = m_buffer.size();
+	if (!game.write(&m_buffer, m_mode))
+	{
+		m_buffer.resize(size);
+		return false;
+	}
+
+	if (++m_bufferedGames >= m_batchSize)
+		return flush();
+	return true;
+}
+
+bool PgnWriter::writeFormatted(const QByteArray& data)
+{
+	m_buffer.append(data);
+
+	if (++m_bufferedGames >= m_batchSize)
+		return flush();
+	return true;
+}
+
+bool PgnWriter::flush()
+{
+	if (m_bufferedGames == 0)
+		return true;
+	if (m_device == nullptr)
+		return false;
+
+	bool ok = m_device->write(m_buffer) == m_buffer.size();
+	QFileDevice* file = qobject_cast<QFileDevice*>(m_device);
+	CompressedFile* compressedFile = qobject_cast<CompressedFile*>(m_device);
+	if (file != nullptr)
+		ok = file->flush() && ok;
+	else if (compressedFile != nullptr)
+		ok = compressedFile->flush() && ok;
+	m_unsyncedGames += m_bufferedGames;
+	m_bufferedGames = 0;
+	m_buffer.resize(0);
+
+	if (ok && m_syncInterval > 0 && m_unsyncedGames >= m_syncInterval)
+	{
+		ok = sync();
+		m_unsyncedGames = 0;
+	}
+
+	return ok;
+}
+
+bool PgnWriter::sync()
+{
+	int handle = -1;
+	if (QFileDevice* file = qobject_cast<QFileDevice*>(m_device))
+		handle = file->handle();
+	else if (CompressedFile* file = qobject_cast<CompressedFile*>(m_device))
+		handle = file->handle();
+	if (handle == -1)
+		return true;
+
+	#ifdef Q_OS_WIN
+	return _commit(handle) == 0;
+	#else
+	return fsync(handle) == 0;
+	#endif
+}
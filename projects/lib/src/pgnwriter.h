@@ -0,0 +1,109 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PGNWRITER_H
+#define PGNWRITER_H
+
+#include <QByteArray>
+#include "pgngame.h"
+class QIODevice;
+
+/*!
+ * \brief A buffered writer for PGN games.
+ *
+ * PgnWriter formats games directly into a reusable UTF-8 buffer and
+ * writes the buffer to its device in batches of batchSize() games.
+ * If the device is a file or a CompressedFile, the writer can also
+ * make the operating system commit the file to disk every
+ * syncInterval() games, so that a crash loses at most that many games.
+ *
+ * \sa PgnGame::write()
+ */
+class LIB_EXPORT PgnWriter
+{
+	public:
+		/*! Creates a new writer that writes to \a device. */
+		explicit PgnWriter(QIODevice* device = nullptr);
+		/*! Flushes the buffered games and destroys the writer. */
+		~PgnWriter();
+
+		/*! Returns the output device. */
+		QIODevice* device() const;
+		/*!
+		 * Sets the output device to \a device.
+		 *
+		 * The games buffered for the old device are written first.
+		 */
+		void setDevice(QIODevice* device);
+
+		/*! Returns the PGN mode of the written games. */
+		PgnGame::PgnMode mode() const;
+		/*! Sets the PGN mode of the written games to \a mode. */
+		void setMode(PgnGame::PgnMode mode);
+
+		/*!
+		 * Returns the number of games that are buffered before
+		 * they are written to the device. The default is 1.
+		 */
+		int batchSize() const;
+		/*! Sets the batch size to \a games. */
+		void setBatchSize(int games);
+
+		/*!
+		 * Returns the number of written games after which the
+		 * output file is synchronized to disk, or 0 if it's never
+		 * synchronized (the default).
+		 */
+		int syncInterval() const;
+		/*! Sets the sync interval to \a games. */
+		void setSyncInterval(int games);
+
+		/*!
+		 * Writes \a game.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool write(const PgnGame& game);
+		/*!
+		 * Writes a game that was already formatted by
+		 * PgnGame::write() into \a data.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool writeFormatted(const QByteArray& data);
+		/*!
+		 * Writes all buffered games to the device.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool flush();
+
+	private:
+		Q_DISABLE_COPY(PgnWriter)
+
+		bool sync();
+
+		QIODevice* m_device;
+		PgnGame::PgnMode m_mode;
+		int m_batchSize;
+		int m_syncInterval;
+		int m_bufferedGames;
+		int m_unsyncedGames;
+		QByteArray m_buffer;
+};
+
+#endif // PGNWRITER_H
@@ -0,0 +1,330 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pipereader_unix.h"
+#include <QThread>
+#include <QHash>
+#include <QMutexLocker>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef Q_OS_LINUX
+  #include <sys/epoll.h>
+#else
+  #include <sys/types.h>
+  #include <sys/event.h>
+  #include <sys/time.h>
+#endif
+
+namespace {
+
+/*
+ * A thread that waits for input on all registered engine pipes.
+ *
+ * Readers are identified by a serial number instead of a pointer so that
+ * an event fetched just before a reader was removed can never be
+ * delivered to a new reader that happens to reuse the same address.
+ */
+class PipeReactor : public QThread
+{
+	public:
+		PipeReactor();
+		virtual ~PipeReactor();
+
+		quint64 add(int fd, PipeReader* reader);
+		void remove(quint64 id);
+
+	protected:
+		virtual void run();
+
+	private:
+		bool watch(int fd, quint64 id, bool enable);
+
+		int m_poll;
+		int m_wakeup[2];
+		quint64 m_lastId;
+		QHash<quint64, QPair<int, PipeReader*>> m_readers;
+		QMutex m_mutex;
+};
+
+Q_GLOBAL_STATIC(PipeReactor, s_reactor)
+
+PipeReactor::PipeReactor()
+	: m_poll(-1),
+	  m_lastId(0)
+{
+	// Writing to an engine that has just died must not kill the GUI
+	// or the CLI, so handle broken pipes as write errors instead.
+	signal(SIGPIPE, SIG_IGN);
+
+#ifdef Q_OS_LINUX
+	m_poll = epoll_create1(EPOLL_CLOEXEC);
+#else
+	m_poll = kqueue();
+	if (m_poll != -1)
+		fcntl(m_poll, F_SETFD, FD_CLOEXEC);
+#endif
+	if (m_poll == -1)
+		qWarning("PipeReactor: cannot create poll descriptor: %s",
+			 strerror(errno));
+
+	// The wakeup pipe has id 0 and is used to stop the thread
+	m_wakeup[0] = m_wakeup[1] = -1;
+	if (pipe(m_wakeup) == 0)
+	{
+		fcntl(m_wakeup[0], F_SETFD, FD_CLOEXEC);
+		fcntl(m_wakeup[1], F_SETFD, FD_CLOEXEC);
+		watch(m_wakeup[0], 0, true);
+	}
+
+	start();
+}
+
+PipeReactor::~PipeReactor()
+{
+	if (m_wakeup[1] != -1)
+	{
+		char c = 0;
+		while (::write(m_wakeup[1], &c, 1) == -1 && errno == EINTR)
+			;
+		wait();
+		::close(m_wakeup[0]);
+		::close(m_wakeup[1]);
+	}
+	if (m_poll != -1)
+		::close(m_poll);
+}
+
+bool PipeReactor::watch(int fd, quint64 id, bool enable)
+{
+#ifdef Q_OS_LINUX
+	epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.u64 = id;
+
+	return epoll_ctl(m_poll, enable ? EPOLL_CTL_ADD : EPOLL_CTL_DEL,
+			 fd, &event) == 0;
+#else
+	struct kevent event;
+	EV_SET(&event, fd, EVFILT_READ, enable ? EV_ADD : EV_DELETE,
+	       0, 0, reinterpret_cast<void*>(quintptr(id)));
+
+	return kevent(m_poll, &event, 1, nullptr, 0, nullptr) == 0;
+#endif
+}
+
+quint64 PipeReactor::add(int fd, PipeReader* reader)
+{
+	QMutexLocker locker(&m_mutex);
+
+	quint64 id = ++m_lastId;
+	m_readers[id] = qMakePair(fd, reader);
+	if (!watch(fd, id, true))
+		qWarning("PipeReactor: cannot watch pipe: %s",
+			 strerror(errno));
+
+	return id;
+}
+
+void PipeReactor::remove(quint64 id)
+{
+	QMutexLocker locker(&m_mutex);
+
+	auto it = m_readers.find(id);
+	if (it == m_readers.end())
+		return;
+
+	watch(it->first, id, false);
+	m_readers.erase(it);
+}
+
+void PipeReactor::run()
+{
+	const int MaxEvents = 64;
+
+	for (;;)
+	{
+#ifdef Q_OS_LINUX
+		epoll_event events[MaxEvents];
+		int n = epoll_wait(m_poll, events, MaxEvents, -1);
+#else
+		struct kevent events[MaxEvents];
+		int n = kevent(m_poll, nullptr, 0, events, MaxEvents, nullptr);
+#endif
+		if (n == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			qWarning("PipeReactor: wait failed: %s",
+				 strerror(errno));
+			return;
+		}
+
+		QMutexLocker locker(&m_mutex);
+		for (int i = 0; i < n; i++)
+		{
+#ifdef Q_OS_LINUX
+			quint64 id = events[i].data.u64;
+#else
+			quint64 id = quintptr(events[i].udata);
+#endif
+			if (id == 0)
+				return;
+
+			auto it = m_readers.find(id);
+			if (it == m_readers.end())
+				continue;
+
+			// The pipe was closed or broken: stop watching it
+			if (!it->second->readPipe())
+			{
+				watch(it->first, id, false);
+				m_readers.erase(it);
+			}
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+PipeReader::PipeReader(int fd, QObject* parent)
+	: QObject(parent),
+	  m_fd(fd),
+	  m_id(0),
+	  m_pos(0),
+	  m_lastNewLine(-1),
+	  m_finished(false)
+{
+	Q_ASSERT(m_fd != -1);
+	m_id = s_reactor()->add(m_fd, this);
+}
+
+PipeReader::~PipeReader()
+{
+	// After this the reactor thread can't be inside readPipe()
+	if (!s_reactor.isDestroyed())
+		s_reactor()->remove(m_id);
+}
+
+qint64 PipeReader::bytesAvailable() const
+{
+	QMutexLocker locker(&m_mutex);
+	return qint64(m_buffer.size() - m_pos);
+}
+
+bool PipeReader::canReadLine() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_lastNewLine >= m_pos;
+}
+
+QElapsedTimer PipeReader::lineTimer() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_lineTimer;
+}
+
+bool PipeReader::isFinished() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_finished;
+}
+
+qint64 PipeReader::readData(char* data, qint64 maxSize)
+{
+	QMutexLocker locker(&m_mutex);
+
+	int n = int(qMin(maxSize, qint64(m_buffer.size() - m_pos)));
+	if (n <= 0)
+		return -1;
+
+	memcpy(data, m_buffer.constData() + m_pos, size_t(n));
+	m_pos += n;
+
+	if (m_pos == m_buffer.size())
+	{
+		m_buffer.resize(0);
+		m_pos = 0;
+		m_lastNewLine = -1;
+	}
+	else if (m_pos >= m_buffer.size() / 2)
+	{
+		// Compact the buffer once most of it has been consumed
+		m_buffer.remove(0, m_pos);
+		m_lastNewLine -= m_pos;
+		m_pos = 0;
+	}
+
+	return n;
+}
+
+bool PipeReader::readPipe()
+{
+	static const int BufSize = 0x8000;
+	char buf[BufSize];
+	bool newLine = false;
+	bool ok = true;
+
+	for (;;)
+	{
+		ssize_t n = ::read(m_fd, buf, BufSize);
+		if (n > 0)
+		{
+			QMutexLocker locker(&m_mutex);
+			int offset = m_buffer.size();
+			m_buffer.append(buf, int(n));
+
+			for (int i = int(n) - 1; i >= 0; i--)
+			{
+				if (buf[i] == '\n')
+				{
+					m_lastNewLine = offset + i;
+					m_lineTimer.start();
+					newLine = true;
+					break;
+				}
+			}
+			continue;
+		}
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+
+		if (n == -1)
+			qWarning("PipeReader: read failed: %s", strerror(errno));
+
+		QMutexLocker locker(&m_mutex);
+		m_finished = true;
+		ok = false;
+		break;
+	}
+
+	// To avoid signal spam, send the 'readyRead' signal only
+	// if we have a whole line of new data
+	if (newLine)
+		emit readyRead();
+	if (!ok)
+		emit finished();
+
+	return ok;
+}
@@ -0,0 +1,105 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PIPEREADER_UNIX_H
+#define PIPEREADER_UNIX_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QMutex>
+#include <QElapsedTimer>
+
+
+/*!
+ * \brief Reads input from a child process' non-blocking pipe
+ *
+ * PipeReader is intended for reading input from chess engines on Linux
+ * and macOS. Instead of having a thread or a socket notifier of its own,
+ * every PipeReader is registered with a single reactor thread that
+ * waits for all engine pipes with epoll (Linux) or kqueue (macOS).
+ * The reactor reads the data into the PipeReader's buffer and the
+ * readyRead() signal is sent when a new line of text data is available.
+ *
+ * \note This class is for Linux and macOS only
+ * \sa EngineProcess
+ */
+class LIB_EXPORT PipeReader : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*!
+		 * Creates a new PipeReader for the non-blocking file
+		 * descriptor \a fd and starts watching it.
+		 *
+		 * The PipeReader doesn't take ownership of \a fd.
+		 */
+		PipeReader(int fd, QObject* parent = nullptr);
+		/*! Stops watching the pipe and destroys the PipeReader. */
+		virtual ~PipeReader();
+
+		/*!
+		 * Read up to \a maxSize bytes into \a data.
+		 * \return number of bytes read or -1 if an error occurred.
+		 */
+		qint64 readData(char* data, qint64 maxSize);
+
+		/*! Returns the number of bytes available for reading. */
+		qint64 bytesAvailable() const;
+
+		/*! Returns true if a complete line of data can be read. */
+		bool canReadLine() const;
+
+		/*!
+		 * Returns a timer that was started when the last complete
+		 * line of data was read from the pipe.
+		 *
+		 * The timer is invalid if no line has been read yet.
+		 */
+		QElapsedTimer lineTimer() const;
+
+		/*! Returns true if the end of the pipe was reached. */
+		bool isFinished() const;
+
+		/*!
+		 * Reads everything available in the pipe.
+		 *
+		 * Returns false if the pipe was closed by the writer or an
+		 * error occurred, in which case the finished() signal is
+		 * sent. Called by the reactor thread.
+		 */
+		bool readPipe();
+
+	signals:
+		/*! There's a new line of data available. */
+		void readyRead();
+		/*! The write end of the pipe was closed. */
+		void finished();
+
+	private:
+		int m_fd;
+		quint64 m_id;
+		QByteArray m_buffer;
+		int m_pos;
+		int m_lastNewLine;
+		bool m_finished;
+		QElapsedTimer m_lineTimer;
+		mutable QMutex m_mutex;
+};
+
+#endif // PIPEREADER_UNIX_H
@@ -17,109 +17,341 @@
 */
 
 #include "pipereader_win.h"
+#include <QThread>
+#include <QHash>
 #include <QMutexLocker>
+#include <QCoreApplication>
+
+namespace {
+
+/*
+ * A thread that services the I/O completion port of all engine pipes.
+ *
+ * Readers are identified by a serial number, which is the completion
+ * key of their pipe, so that a completion of a read that was cancelled
+ * when its reader was removed is never delivered to another reader.
+ * Completion packets without an OVERLAPPED structure ask the reader to
+ * issue a new read, and the key 0 stops the thread.
+ */
+class PipeReactor : public QThread
+{
+	public:
+		PipeReactor();
+		virtual ~PipeReactor();
+
+		quint64 add(HANDLE pipe, PipeReader* reader);
+		void remove(quint64 id);
+		void resume(quint64 id);
+
+	protected:
+		virtual void run();
+
+	private:
+		HANDLE m_port;
+		quint64 m_lastId;
+		QHash<quint64, PipeReader*> m_readers;
+		QMutex m_mutex;
+};
+
+Q_GLOBAL_STATIC(PipeReactor, s_reactor)
+
+PipeReactor::PipeReactor()
+	: m_port(NULL),
+	  m_lastId(0)
+{
+	m_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+	if (m_port == NULL)
+		qWarning("PipeReactor: cannot create completion port: 0x%x",
+			 int(GetLastError()));
+	else
+		start();
+}
+
+PipeReactor::~PipeReactor()
+{
+	if (m_port == NULL)
+		return;
+
+	PostQueuedCompletionStatus(m_port, 0, 0, NULL);
+	wait();
+	CloseHandle(m_port);
+}
+
+quint64 PipeReactor::add(HANDLE pipe, PipeReader* reader)
+{
+	QMutexLocker locker(&m_mutex);
+
+	quint64 id = ++m_lastId;
+	m_readers[id] = reader;
+	if (CreateIoCompletionPort(pipe, m_port, ULONG_PTR(id), 0) == NULL)
+		qWarning("PipeReactor: cannot watch pipe: 0x%x",
+			 int(GetLastError()));
+	resume(id);
+
+	return id;
+}
+
+void PipeReactor::remove(quint64 id)
+{
+	QMutexLocker locker(&m_mutex);
+	m_readers.remove(id);
+}
+
+void PipeReactor::resume(quint64 id)
+{
+	PostQueuedCompletionStatus(m_port, 0, ULONG_PTR(id), NULL);
+}
+
+void PipeReactor::run()
+{
+	for (;;)
+	{
+		DWORD size = 0;
+		ULONG_PTR key = 0;
+		OVERLAPPED* overlapped = nullptr;
+		BOOL ok = GetQueuedCompletionStatus(m_port, &size, &key,
+						    &overlapped, INFINITE);
+		if (!ok && overlapped == nullptr)
+		{
+			qWarning("PipeReactor: wait failed: 0x%x",
+				 int(GetLastError()));
+			return;
+		}
+		if (key == 0)
+			return;
+		if (!ok)
+		{
+			DWORD err = GetLastError();
+			if (err != ERROR_BROKEN_PIPE
+			&&  err != ERROR_OPERATION_ABORTED)
+				qWarning("ReadFile failed with 0x%x", int(err));
+		}
+
+		QMutexLocker locker(&m_mutex);
+		auto it = m_readers.find(quint64(key));
+		if (it == m_readers.end())
+			continue;
+
+		bool alive = overlapped ? (*it)->readCompleted(ok, size)
+					: (*it)->readPipe();
+		if (!alive)
+			m_readers.erase(it);
+	}
+}
+
+} // anonymous namespace
 
 
 PipeReader::PipeReader(HANDLE pipe, QObject* parent)
-	: QThread(parent),
+	: QObject(parent),
 	  m_pipe(pipe),
-	  m_bufEnd(m_buf + BufSize),
-	  m_start(m_buf),
-	  m_end(m_buf),
-	  m_freeBytes(BufSize),
-	  m_usedBytes(0),
-	  m_lastNewLine(1)
+	  m_id(0),
+	  m_readPos(0),
+	  m_writePos(0),
+	  m_lineEnd(0),
+	  m_waiting(0),
+	  m_pending(0),
+	  m_finished(0)
 {
 	Q_ASSERT(m_pipe != INVALID_HANDLE_VALUE);
+	ZeroMemory(&m_overlapped, sizeof(m_overlapped));
+	m_id = s_reactor()->add(m_pipe, this);
+}
+
+PipeReader::~PipeReader()
+{
+	// After this the port thread can't issue or complete reads
+	if (!s_reactor.isDestroyed())
+		s_reactor()->remove(m_id);
+
+	// The kernel may still write to the buffer and the OVERLAPPED
+	// structure, so wait until the pending read is cancelled
+	if (m_pending.loadAcquire())
+	{
+		DWORD size = 0;
+		CancelIoEx(m_pipe, &m_overlapped);
+		GetOverlappedResult(m_pipe, &m_overlapped, &size, TRUE);
+	}
+}
+
+bool PipeReader::createPipe(HANDLE* readPipe, HANDLE* writePipe, bool inherit)
+{
+	static QAtomicInt s_serial;
+
+	// Anonymous pipes don't support overlapped I/O
+	QString name = QString("\\\\.\\pipe\\cutechess-%1-%2")
+		.arg(QCoreApplication::applicationPid())
+		.arg(s_serial.fetchAndAddRelaxed(1));
+
+	*readPipe = CreateNamedPipeW((LPCWSTR)name.utf16(),
+				     PIPE_ACCESS_INBOUND
+				     | FILE_FLAG_OVERLAPPED
+				     | FILE_FLAG_FIRST_PIPE_INSTANCE,
+				     PIPE_TYPE_BYTE | PIPE_WAIT
+				     | PIPE_REJECT_REMOTE_CLIENTS,
+				     1,		// max. instances
+				     BufSize,	// output buffer size
+				     BufSize,	// input buffer size
+				     0,		// default timeout
+				     NULL);	// not inheritable
+	if (*readPipe == INVALID_HANDLE_VALUE)
+		return false;
+
+	SECURITY_ATTRIBUTES sa;
+	sa.nLength = sizeof(sa);
+	sa.bInheritHandle = inherit ? TRUE : FALSE;
+	sa.lpSecurityDescriptor = NULL;
+
+	*writePipe = CreateFileW((LPCWSTR)name.utf16(),
+				 GENERIC_WRITE,
+				 0,		// no sharing
+				 &sa,
+				 OPEN_EXISTING,
+				 FILE_ATTRIBUTE_NORMAL,
+				 NULL);
+	if (*writePipe == INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(*readPipe);
+		*readPipe = INVALID_HANDLE_VALUE;
+		return false;
+	}
+
+	return true;
+}
+
+quint32 PipeReader::usedBytes() const
+{
+	return m_writePos.loadAcquire() - m_readPos.loadAcquire();
 }
 
 qint64 PipeReader::bytesAvailable() const
 {
-	return qint64(m_usedBytes.available());
+	return qint64(usedBytes());
 }
 
 bool PipeReader::canReadLine() const
 {
-	QMutexLocker locker(&m_mutex);
-	return m_lastNewLine <= m_usedBytes.available();
+	// The newline may already have been read, in which case the
+	// line end is behind the read position
+	quint32 n = m_lineEnd.loadAcquire() - m_readPos.loadAcquire();
+	return qint32(n) > 0;
+}
+
+QElapsedTimer PipeReader::lineTimer() const
+{
+	QMutexLocker locker(&m_timerMutex);
+	return m_lineTimer;
+}
+
+bool PipeReader::isFinished() const
+{
+	return m_finished.loadAcquire() != 0;
 }
 
 qint64 PipeReader::readData(char* data, qint64 maxSize)
 {
-	int n = qMin(int(maxSize), m_usedBytes.available());
+	const quint32 readPos = m_readPos.loadAcquire();
+	const int n = int(qMin(maxSize, qint64(usedBytes())));
 	if (n <= 0)
 		return -1;
-	m_usedBytes.acquire(n);
 
-	// Copy the first (possibly the only) block of data
-	int size1 = qMin(int(m_bufEnd - m_start), n);
-	memcpy(data, m_start, size_t(size1));
-	m_start += size1;
+	// Copy the first (possibly the only) block of data, and the
+	// second block from the beginning of the buffer
+	const quint32 start = readPos & (BufSize - 1);
+	const int size1 = qMin(int(BufSize - start), n);
+	memcpy(data, m_buf + start, size_t(size1));
+	if (n > size1)
+		memcpy(data + size1, m_buf, size_t(n - size1));
 
-	Q_ASSERT(m_start <= m_bufEnd);
-	if (m_start == m_bufEnd)
-		m_start = m_buf;
+	m_readPos.fetchAndAddOrdered(quint32(n));
 
-	// Copy the second block of data from the beginning
-	int size2 = n - size1;
-	if (size2 > 0)
-	{
-		memcpy(data + size1, m_start, size_t(size2));
-		m_start += size2;
-
-		Q_ASSERT(m_start <= m_bufEnd);
-		if (m_start == m_bufEnd)
-			m_start = m_buf;
-	}
-	Q_ASSERT(n == size1 + size2);
+	// Let the port thread read more if the buffer was full
+	if (m_waiting.testAndSetOrdered(1, 0) && !s_reactor.isDestroyed())
+		s_reactor()->resume(m_id);
 
-	m_freeBytes.release(n);
 	return n;
 }
 
-void PipeReader::run()
+bool PipeReader::finish()
 {
-	DWORD dwRead = 0;
+	m_finished.storeRelease(1);
+	emit finished();
+	return false;
+}
 
-	for (;;)
+bool PipeReader::readPipe()
+{
+	if (m_pending.loadAcquire() || isFinished())
+		return true;
+
+	quint32 used = usedBytes();
+	if (used == BufSize)
 	{
-		int maxSize = qMin(BufSize / 10, int(m_bufEnd - m_end));
-		m_freeBytes.acquire(maxSize);
+		// Check again after raising the flag, in case readData()
+		// made room before it could see the flag
+		m_waiting.fetchAndStoreOrdered(1);
+		used = usedBytes();
+		if (used == BufSize || !m_waiting.testAndSetOrdered(1, 0))
+			return true;
+	}
+
+	const quint32 end = m_writePos.loadAcquire() & (BufSize - 1);
+	DWORD maxSize = qMin(qMin(BufSize / 10, BufSize - end),
+			     BufSize - used);
 
-		BOOL ok = ReadFile(m_pipe, m_end, maxSize, &dwRead, 0);
-		if (!ok || dwRead == 0)
+	ZeroMemory(&m_overlapped, sizeof(m_overlapped));
+	m_pending.storeRelease(1);
+
+	// Even a read that completes at once is reported to the port
+	if (!ReadFile(m_pipe, m_buf + end, maxSize, NULL, &m_overlapped))
+	{
+		DWORD err = GetLastError();
+		if (err != ERROR_IO_PENDING)
 		{
-			DWORD err = GetLastError();
-			if (err != ERROR_INVALID_HANDLE
-			&&  err != ERROR_BROKEN_PIPE)
+			m_pending.storeRelease(0);
+			if (err != ERROR_BROKEN_PIPE
+			&&  err != ERROR_INVALID_HANDLE)
 				qWarning("ReadFile failed with 0x%x", int(err));
-			return;
+			return finish();
 		}
+	}
 
-		m_end += dwRead;
-		Q_ASSERT(m_end <= m_bufEnd);
+	return true;
+}
 
-		QMutexLocker locker(&m_mutex);
+bool PipeReader::readCompleted(bool ok, DWORD size)
+{
+	m_pending.storeRelease(0);
+	if (!ok)
+		return finish();
 
-		m_lastNewLine += dwRead;
-		for (int i = 1; i <= int(dwRead); i++)
+	const quint32 writePos = m_writePos.loadAcquire();
+	const char* data = m_buf + (writePos & (BufSize - 1));
+	int newLine = -1;
+	for (int i = int(size) - 1; i >= 0; i--)
+	{
+		if (data[i] == '\n')
 		{
-			if (*(m_end - i) == '\n')
-			{
-				m_lastNewLine = i;
-				break;
-			}
+			newLine = i;
+			break;
 		}
+	}
 
-		if (m_end == m_bufEnd)
-			m_end = m_buf;
-
-		m_freeBytes.release(maxSize - dwRead);
-		m_usedBytes.release(dwRead);
+	// Publish the data before the new line end, so that
+	// canReadLine() never claims a line that isn't there yet
+	m_writePos.storeRelease(writePos + size);
 
-		// To avoid signal spam, send the 'readyRead' signal only
-		// if we have a whole line of new data
-		if (m_lastNewLine <= int(dwRead))
-			emit readyRead();
+	// To avoid signal spam, send the 'readyRead' signal only
+	// if we have a whole line of new data
+	if (newLine != -1)
+	{
+		m_lineEnd.storeRelease(writePos + quint32(newLine) + 1);
+		{
+			QMutexLocker locker(&m_timerMutex);
+			m_lineTimer.start();
+		}
+		emit readyRead();
 	}
+
+	return readPipe();
 }
@@ -20,31 +20,62 @@
 #define PIPEREADER_WIN_H
 
 #include <windows.h>
-#include <QThread>
+#include <QObject>
 #include <QMutex>
-#include <QSemaphore>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
 
 
 /*!
- * \brief A thread class for reading input from a child process
+ * \brief Reads input from a child process' overlapped pipe
  *
  * PipeReader is intended for reading input from chess engines in Windows.
- * It uses blocking read calls to read from a WinAPI pipe, and
- * sends the readyRead() signal when a new line of text data is available.
+ * Instead of having a thread of its own, every PipeReader is registered
+ * with a single I/O completion port that is serviced by one thread for
+ * all engine pipes. The port thread issues overlapped reads into the
+ * PipeReader's buffer, and the readyRead() signal is sent when a new
+ * line of text data is available. Queued connections deliver the
+ * signals to the thread that owns the engine.
  *
- * No event loops are used. The child process has to terminate or be
- * terminated before the pipe reader can exit cleanly.
+ * The data goes through a single-producer, single-consumer ring buffer
+ * whose read and write positions are atomic counters, so neither side
+ * takes a lock to pass data. When the buffer is full, no new read is
+ * issued until the consumer makes room.
+ *
+ * The pipe must be opened for overlapped I/O; createPipe() creates one.
  *
  * \note This class is for Windows only
  * \sa EngineProcess
  */
-class LIB_EXPORT PipeReader : public QThread
+class LIB_EXPORT PipeReader : public QObject
 {
 	Q_OBJECT
 
 	public:
-		/*! Creates a new PipeReader and starts the read loop. */
+		/*!
+		 * Creates a new PipeReader for the overlapped pipe \a pipe
+		 * and starts reading it.
+		 *
+		 * The PipeReader doesn't take ownership of \a pipe.
+		 */
 		PipeReader(HANDLE pipe, QObject* parent = nullptr);
+		/*!
+		 * Stops reading the pipe and destroys the PipeReader.
+		 *
+		 * A pending read is cancelled.
+		 */
+		virtual ~PipeReader();
+
+		/*!
+		 * Creates a pipe whose read end \a readPipe supports
+		 * overlapped I/O. The write end \a writePipe is inheritable
+		 * if \a inherit is true; the read end never is.
+		 *
+		 * Returns true if successful.
+		 */
+		static bool createPipe(HANDLE* readPipe,
+				       HANDLE* writePipe,
+				       bool inherit);
 
 		/*!
 		 * Read up to \a maxSize bytes into \a data.
@@ -58,25 +89,66 @@ class LIB_EXPORT PipeReader : public QThread
 		/*! Returns true if a complete line of data can be read. */
 		bool canReadLine() const;
 
+		/*!
+		 * Returns a timer that was started when the last complete
+		 * line of data was read from the pipe.
+		 *
+		 * The timer is invalid if no line has been read yet.
+		 */
+		QElapsedTimer lineTimer() const;
+
+		/*! Returns true if the end of the pipe was reached. */
+		bool isFinished() const;
+
+		/*!
+		 * Issues an overlapped read into the free part of the
+		 * buffer, unless a read is already pending or the buffer
+		 * is full.
+		 *
+		 * Returns false if the pipe was closed by the writer or an
+		 * error occurred, in which case the finished() signal is
+		 * sent. Called by the port thread.
+		 */
+		bool readPipe();
+		/*!
+		 * Takes \a size bytes of data from a completed read, or ends
+		 * the input if \a ok is false, and issues the next read.
+		 *
+		 * Returns false if the pipe was closed by the writer or an
+		 * error occurred, in which case the finished() signal is
+		 * sent. Called by the port thread.
+		 */
+		bool readCompleted(bool ok, DWORD size);
+
 	signals:
 		/*! There's a new line of data available. */
 		void readyRead();
-		
-	protected:
-		virtual void run();
+		/*! The write end of the pipe was closed. */
+		void finished();
 
 	private:
-		static const int BufSize = 0x8000;
+		// Must be a power of two
+		static const quint32 BufSize = 0x8000;
+
+		quint32 usedBytes() const;
+		bool finish();
 
 		HANDLE m_pipe;
+		quint64 m_id;
+		OVERLAPPED m_overlapped;
 		char m_buf[BufSize];
-		const char* const m_bufEnd;
-		char* m_start;
-		char* m_end;
-		mutable QMutex m_mutex;
-		QSemaphore m_freeBytes;
-		QSemaphore m_usedBytes;
-		int m_lastNewLine;
+		// Total number of bytes read and written; the counters
+		// wrap around, and only their difference matters.
+		QAtomicInteger<quint32> m_readPos;
+		QAtomicInteger<quint32> m_writePos;
+		// Write position just past the last newline character
+		QAtomicInteger<quint32> m_lineEnd;
+		// Set by the port thread when the buffer is full
+		QAtomicInt m_waiting;
+		QAtomicInt m_pending;
+		QAtomicInt m_finished;
+		mutable QMutex m_timerMutex;
+		QElapsedTimer m_lineTimer;
 };
 
 #endif // PIPEREADER_WIN_H
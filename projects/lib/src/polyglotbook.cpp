@@ -18,6 +18,7 @@
 
 #include "polyglotbook.h"
 #include <QDataStream>
+#include <QtEndian>
 
 namespace {
 
@@ -59,6 +60,11 @@ PolyglotBook::PolyglotBook(AccessMode mode)
 {
 }
 
+quint16 PolyglotBook::encodeMove(const Chess::GenericMove& move)
+{
+	return moveToBits(move);
+}
+
 int PolyglotBook::entrySize() const
 {
 	return 16;
@@ -77,6 +83,16 @@ OpeningBook::Entry PolyglotBook::readEntry(QDataStream& in, quint64* key) const
 	return { moveFromBits(pgMove), weight };
 }
 
+OpeningBook::Entry PolyglotBook::readEntry(const uchar* data, quint64* key) const
+{
+	// A mapped entry is decoded without a data stream
+	*key = qFromBigEndian<quint64>(data);
+	const quint16 pgMove = qFromBigEndian<quint16>(data + 8);
+	const quint16 weight = qFromBigEndian<quint16>(data + 10);
+
+	return { moveFromBits(pgMove), weight };
+}
+
 void PolyglotBook::writeEntry(const Map::const_iterator& it,
 			      QDataStream& out) const
 {
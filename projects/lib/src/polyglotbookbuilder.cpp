@@ -0,0 +1,380 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "polyglotbookbuilder.h"
+#include <algorithm>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QDir>
+#include <QThread>
+#include <QtEndian>
+#include "pgngame.h"
+#include "pgnstream.h"
+#include "pgnchunkreader.h"
+#include "polyglotbook.h"
+
+namespace {
+
+typedef PolyglotBookBuilder::Record Record;
+
+// The number of records read at once from a temporary file
+const int s_readBufferSize = 64 * 1024;
+const int s_writeChunkSize = 64 * 1024;
+
+bool recordLessThan(const Record& a, const Record& b)
+{
+	if (a.key != b.key)
+		return a.key < b.key;
+	return a.move < b.move;
+}
+
+/*!
+ * Sorts \a records and merges the weights of records that have the
+ * same key and move.
+ */
+void sortAndMerge(QVector<Record>* records)
+{
+	std::sort(records->begin(), records->end(), recordLessThan);
+
+	int count = 0;
+	for (int i = 0; i < records->size(); i++)
+	{
+		const Record& record = records->at(i);
+		if (count > 0)
+		{
+			Record& last = (*records)[count - 1];
+			if (last.key == record.key && last.move == record.move)
+			{
+				last.weight += record.weight;
+				continue;
+			}
+		}
+		(*records)[count++] = record;
+	}
+	records->resize(count);
+}
+
+void addGame(const PgnGame& game, QVector<Record>* records)
+{
+	// Same weights as in OpeningBook::import()
+	const Chess::Side winner(game.result().winner());
+	int loserMod = -1;
+	quint32 weight = 1;
+	if (!winner.isNull())
+	{
+		loserMod = int(game.startingSide() == winner);
+		weight = 2;
+	}
+
+	const QVector<PgnGame::MoveData>& moves = game.moves();
+	for (int i = 0; i < moves.size(); i++)
+	{
+		if ((i % 2) == loserMod)
+			continue;
+
+		const PgnGame::MoveData& md = moves.at(i);
+		Record record = {
+			md.key,
+			PolyglotBook::encodeMove(md.move),
+			weight
+		};
+		records->append(record);
+	}
+}
+
+/*!
+ * Parses a chunk of PGN games, turns their moves into records, and
+ * returns the number of games.
+ */
+int parseChunk(const QByteArray& data, int maxPlies, QVector<Record>* records)
+{
+	int games = 0;
+	PgnStream in(&data);
+	PgnGame game;
+	while (game.read(in, maxPlies, false))
+	{
+		games++;
+		addGame(game, records);
+	}
+	return games;
+}
+
+/*! Reads the sorted records of a temporary file in blocks. */
+class RunReader
+{
+	public:
+		explicit RunReader(QIODevice* device)
+			: m_device(device),
+			  m_pos(0)
+		{
+			m_device->seek(0);
+			fill();
+		}
+
+		bool atEnd() const
+		{
+			return m_pos >= m_buffer.size();
+		}
+		const Record& current() const
+		{
+			return m_buffer.at(m_pos);
+		}
+		void next()
+		{
+			if (++m_pos >= m_buffer.size())
+				fill();
+		}
+
+	private:
+		void fill()
+		{
+			m_buffer.resize(s_readBufferSize);
+			const qint64 size = m_device->read(
+				reinterpret_cast<char*>(m_buffer.data()),
+				qint64(m_buffer.size()) * sizeof(Record));
+			m_buffer.resize(size > 0 ? int(size / qint64(sizeof(Record))) : 0);
+			m_pos = 0;
+		}
+
+		QIODevice* m_device;
+		QVector<Record> m_buffer;
+		int m_pos;
+};
+
+/*! Writes the Polyglot entries of one position. */
+void writePosition(quint64 key,
+		   QVector<QPair<quint16, quint64>>* moves,
+		   QByteArray* out)
+{
+	// Popular moves first, like the Polyglot tools do
+	std::stable_sort(moves->begin(), moves->end(),
+		[](const QPair<quint16, quint64>& a, const QPair<quint16, quint64>& b)
+	{
+		return a.second > b.second;
+	});
+
+	const quint64 maxWeight = moves->first().second;
+	for (const auto& move : qAsConst(*moves))
+	{
+		quint64 weight = move.second;
+		if (maxWeight > 0xFFFF)
+			weight = qMax(quint64(1), weight * 0xFFFF / maxWeight);
+
+		uchar entry[16];
+		qToBigEndian<quint64>(key, entry);
+		qToBigEndian<quint16>(move.first, entry + 8);
+		qToBigEndian<quint16>(quint16(weight), entry + 10);
+		qToBigEndian<quint32>(0, entry + 12);
+		out->append(reinterpret_cast<const char*>(entry), 16);
+	}
+	moves->clear();
+}
+
+} // anonymous namespace
+
+PolyglotBookBuilder::PolyglotBookBuilder()
+	: m_maxPlies(1024),
+	  m_threadCount(QThread::idealThreadCount()),
+	  m_memoryLimit(qint64(1) << 30),
+	  m_gameCount(0),
+	  m_entryCount(0),
+	  m_failed(false)
+{
+}
+
+PolyglotBookBuilder::~PolyglotBookBuilder()
+{
+	qDeleteAll(m_runs);
+}
+
+void PolyglotBookBuilder::setMaxPlies(int plies)
+{
+	Q_ASSERT(plies > 0);
+	m_maxPlies = plies;
+}
+
+void PolyglotBookBuilder::setThreadCount(int count)
+{
+	m_threadCount = qMax(1, count);
+}
+
+void PolyglotBookBuilder::setMemoryLimit(qint64 bytes)
+{
+	m_memoryLimit = bytes;
+}
+
+qint64 PolyglotBookBuilder::gameCount() const
+{
+	return m_gameCount;
+}
+
+qint64 PolyglotBookBuilder::entryCount() const
+{
+	return m_entryCount;
+}
+
+void PolyglotBookBuilder::addRecords(const QVector<Record>& records)
+{
+	if (m_failed)
+		return;
+
+	m_records += records;
+	if (qint64(m_records.size()) * qint64(sizeof(Record)) < m_memoryLimit)
+		return;
+
+	// Merging often frees enough memory to keep going
+	sortAndMerge(&m_records);
+	if (qint64(m_records.size()) * qint64(sizeof(Record)) >= m_memoryLimit / 2)
+		m_failed = !spill();
+}
+
+bool PolyglotBookBuilder::spill()
+{
+	QTemporaryFile* file = new QTemporaryFile(QDir::tempPath() + "/cutechess-book-XXXXXX");
+	if (!file->open())
+	{
+		qWarning("Can't create a temporary file in %s",
+			 qUtf8Printable(QDir::tempPath()));
+		delete file;
+		return false;
+	}
+	m_runs.append(file);
+
+	const char* data = reinterpret_cast<const char*>(m_records.constData());
+	const qint64 size = qint64(m_records.size()) * sizeof(Record);
+	if (file->write(data, size) != size)
+	{
+		qWarning("Can't write to temporary file %s",
+			 qUtf8Printable(file->fileName()));
+		return false;
+	}
+
+	m_records.resize(0);
+	return true;
+}
+
+bool PolyglotBookBuilder::addPgnFile(const QString& fileName)
+{
+	PgnChunkReader reader;
+	if (!reader.open(fileName, QIODevice::ReadOnly | QIODevice::Text))
+		return false;
+
+	const int maxPlies = m_maxPlies;
+	reader.process([this, maxPlies](const PgnChunkReader::Chunk& chunk)
+	{
+		QVector<Record> records;
+		const int games = parseChunk(chunk.data, maxPlies, &records);
+
+		return PgnChunkReader::Collector([this, records, games]()
+		{
+			m_gameCount += games;
+			addRecords(records);
+		});
+	}, m_threadCount);
+
+	return !m_failed;
+}
+
+bool PolyglotBookBuilder::write(const QString& fileName)
+{
+	if (m_failed)
+		return false;
+
+	sortAndMerge(&m_records);
+	m_entryCount = 0;
+
+	QSaveFile out(fileName);
+	if (!out.open(QIODevice::WriteOnly))
+	{
+		qWarning("Can't open book file %s", qUtf8Printable(fileName));
+		return false;
+	}
+
+	QList<RunReader*> readers;
+	for (QTemporaryFile* run : qAsConst(m_runs))
+		readers.append(new RunReader(run));
+	int memoryPos = 0;
+
+	QByteArray buffer;
+	buffer.reserve(s_writeChunkSize + 16 * 64);
+	QVector<QPair<quint16, quint64>> moves;
+	quint64 key = 0;
+	bool ok = true;
+
+	for (;;)
+	{
+		// Find the smallest record of all the sorted runs
+		const Record* best = nullptr;
+		RunReader* bestReader = nullptr;
+		if (memoryPos < m_records.size())
+			best = &m_records.at(memoryPos);
+		for (RunReader* reader : qAsConst(readers))
+		{
+			if (!reader->atEnd()
+			&&  (best == nullptr || recordLessThan(reader->current(), *best)))
+			{
+				best = &reader->current();
+				bestReader = reader;
+			}
+		}
+		if (best == nullptr)
+			break;
+
+		const Record record = *best;
+		if (bestReader != nullptr)
+			bestReader->next();
+		else
+			memoryPos++;
+
+		if (!moves.isEmpty() && record.key != key)
+		{
+			m_entryCount += moves.size();
+			writePosition(key, &moves, &buffer);
+		}
+		key = record.key;
+
+		// The runs are sorted by key and move
+		if (!moves.isEmpty() && moves.last().first == record.move)
+			moves.last().second += record.weight;
+		else
+			moves.append(qMakePair(record.move, quint64(record.weight)));
+
+		if (buffer.size() >= s_writeChunkSize)
+		{
+			ok = out.write(buffer) == buffer.size();
+			buffer.resize(0);
+			if (!ok)
+				break;
+		}
+	}
+	if (ok && !moves.isEmpty())
+	{
+		m_entryCount += moves.size();
+		writePosition(key, &moves, &buffer);
+	}
+	if (ok)
+		ok = out.write(buffer) == buffer.size();
+	qDeleteAll(readers);
+
+	if (!ok || !out.commit())
+	{
+		qWarning("Can't write book file %s", qUtf8Printable(fileName));
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,116 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POLYGLOTBOOKBUILDER_H
+#define POLYGLOTBOOKBUILDER_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+class QIODevice;
+class QTemporaryFile;
+
+/*!
+ * \brief Builds Polyglot opening books from large PGN collections
+ *
+ * The games are parsed and replayed by a pool of worker threads, which
+ * turn each move into an entry of the Polyglot key, the move and a
+ * weight. Like OpeningBook::import(), the winner's moves of a decisive
+ * game get a weight of 2, the loser's moves are skipped, and both
+ * sides' moves in other games get a weight of 1.
+ *
+ * The entries are sorted and merged in memory, and spilled to sorted
+ * temporary files when the memory limit is reached. write() then
+ * merges the files into the book. Positions whose total weight doesn't
+ * fit in the 16-bit Polyglot weight have their weights scaled down.
+ *
+ * \note The PGN input is split between threads at lines that start
+ * with an Event tag, so a file without Event tags is parsed by a
+ * single thread.
+ *
+ * \sa PolyglotBook
+ */
+class LIB_EXPORT PolyglotBookBuilder
+{
+	public:
+		/*! Creates a new book builder. */
+		PolyglotBookBuilder();
+		/*! Destroys the builder and its temporary files. */
+		~PolyglotBookBuilder();
+
+		/*!
+		 * Sets the maximum number of plies read from a game
+		 * to \a plies. The default is 1024.
+		 */
+		void setMaxPlies(int plies);
+		/*!
+		 * Sets the number of worker threads to \a count.
+		 * The default is the number of CPU cores.
+		 */
+		void setThreadCount(int count);
+		/*!
+		 * Sets the maximum memory used for book entries to
+		 * \a bytes. The default is 1 GiB.
+		 */
+		void setMemoryLimit(qint64 bytes);
+
+		/*!
+		 * Adds the games of PGN file \a fileName to the book.
+		 * The file may be compressed with gzip or Zstandard.
+		 *
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool addPgnFile(const QString& fileName);
+		/*!
+		 * Writes the book to \a fileName.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool write(const QString& fileName);
+
+		/*! Returns the number of games added so far. */
+		qint64 gameCount() const;
+		/*!
+		 * Returns the number of entries in the book written by
+		 * write().
+		 */
+		qint64 entryCount() const;
+
+		/*! A book entry before the weights are merged. */
+		struct Record
+		{
+			quint64 key;
+			quint16 move;
+			quint32 weight;
+		};
+
+	private:
+		Q_DISABLE_COPY(PolyglotBookBuilder)
+
+		void addRecords(const QVector<Record>& records);
+		bool spill();
+
+		int m_maxPlies;
+		int m_threadCount;
+		qint64 m_memoryLimit;
+		qint64 m_gameCount;
+		qint64 m_entryCount;
+		QVector<Record> m_records;
+		QList<QTemporaryFile*> m_runs;
+		bool m_failed;
+};
+
+#endif // POLYGLOTBOOKBUILDER_H
@@ -0,0 +1,246 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "positionanalyzer.h"
+#include <QScopedPointer>
+#include "board/board.h"
+#include "compressedfile.h"
+#include "epdrecord.h"
+#include "pgngame.h"
+#include "pgnstream.h"
+
+namespace {
+
+// The EPD "ce" value of \a score: centipawns, or 32767 minus the
+// number of plies to mate
+int centipawnEval(int score)
+{
+	int absScore = qAbs(score);
+	if (absScore > MoveEvaluation::MATE_SCORE - 200
+	&&  (absScore = 1000 - (absScore % 1000)) < 200)
+		return score > 0 ? 32767 - absScore : absScore - 32767;
+	return score;
+}
+
+} // anonymous namespace
+
+PositionAnalyzer::PositionAnalyzer(GameManager* manager, QObject* parent)
+	: PositionSearcher(manager, parent),
+	  m_input(nullptr),
+	  m_pgnStream(nullptr),
+	  m_nextIndex(0),
+	  m_nextOutput(0),
+	  m_analyzedCount(0)
+{
+	m_output.open(stdout, QIODevice::WriteOnly);
+}
+
+PositionAnalyzer::~PositionAnalyzer()
+{
+	closeInput();
+}
+
+void PositionAnalyzer::addEpdFile(const QString& fileName)
+{
+	m_inputs.enqueue(Input{ fileName, false });
+}
+
+void PositionAnalyzer::addPgnFile(const QString& fileName)
+{
+	m_inputs.enqueue(Input{ fileName, true });
+}
+
+bool PositionAnalyzer::setOutput(const QString& fileName)
+{
+	m_output.close();
+	if (fileName.isEmpty())
+		return m_output.open(stdout, QIODevice::WriteOnly);
+
+	m_output.setFileName(fileName);
+	if (!m_output.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		setError(tr("Can't open output file %1").arg(fileName));
+		return false;
+	}
+	return true;
+}
+
+int PositionAnalyzer::analyzedCount() const
+{
+	return m_analyzedCount;
+}
+
+bool PositionAnalyzer::openNextInput()
+{
+	while (!m_inputs.isEmpty())
+	{
+		const Input input(m_inputs.dequeue());
+		QScopedPointer<QIODevice> device;
+		bool ok;
+
+		if (input.fileName == "-")
+		{
+			QFile* file = new QFile;
+			device.reset(file);
+			ok = file->open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+		}
+		else
+		{
+			if (CompressedFile::detectCompression(input.fileName)
+			    == CompressedFile::NoCompression)
+				device.reset(new QFile(input.fileName));
+			else
+				device.reset(new CompressedFile(input.fileName));
+			ok = device->open(QIODevice::ReadOnly | QIODevice::Text);
+		}
+		if (!ok)
+		{
+			qWarning("Can't open input file %s",
+				 qUtf8Printable(input.fileName));
+			continue;
+		}
+
+		m_input = device.take();
+		if (input.isPgn)
+			m_pgnStream = new PgnStream(m_input, variant());
+		return true;
+	}
+
+	return false;
+}
+
+void PositionAnalyzer::closeInput()
+{
+	delete m_pgnStream;
+	m_pgnStream = nullptr;
+	delete m_input;
+	m_input = nullptr;
+}
+
+bool PositionAnalyzer::readPositions()
+{
+	while (m_fens.isEmpty())
+	{
+		if (m_input == nullptr && !openNextInput())
+			return false;
+
+		if (m_pgnStream != nullptr)
+		{
+			PgnGame game;
+			if (!game.read(*m_pgnStream, INT_MAX - 1, false))
+			{
+				closeInput();
+				continue;
+			}
+
+			Chess::Board* board = game.createBoard();
+			if (board == nullptr)
+				continue;
+			for (const PgnGame::MoveData& md : game.moves())
+			{
+				const Chess::Move move(board->moveFromGenericMove(md.move));
+				if (move.isNull())
+					break;
+				m_fens.enqueue(board->fenString());
+				board->makeMove(move);
+			}
+			delete board;
+		}
+		else
+		{
+			// Blocks until a line is available on the standard input
+			const QByteArray line(m_input->readLine());
+			if (line.isEmpty())
+			{
+				closeInput();
+				continue;
+			}
+
+			EpdRecord record;
+			if (record.parse(line))
+				m_fens.enqueue(record.fen());
+		}
+	}
+
+	return true;
+}
+
+bool PositionAnalyzer::nextSearch(Search* search)
+{
+	if (!readPositions())
+		return false;
+
+	// The engines share the positions
+	search->index = m_nextIndex++;
+	search->engine = search->index % engineCount();
+	search->fen = m_fens.dequeue();
+	return true;
+}
+
+void PositionAnalyzer::searchFinished(const Search& search,
+				      const QString& move,
+				      const MoveEvaluation& eval)
+{
+	// Positions that weren't searched leave an empty result
+	QByteArray record;
+	if (!move.isEmpty())
+	{
+		const QStringList fields(search.fen.split(' '));
+		record = fields.mid(0, 4).join(' ').toUtf8();
+		if (fields.size() >= 6)
+			record += " hmvc " + fields.at(4).toUtf8()
+				+ "; fmvn " + fields.at(5).toUtf8() + ';';
+		if (eval.score() != MoveEvaluation::NULL_SCORE)
+			record += " ce " + QByteArray::number(centipawnEval(eval.score())) + ';';
+		if (eval.depth() > 0)
+			record += " acd " + QByteArray::number(eval.depth()) + ';';
+		if (eval.nodeCount() > 0)
+			record += " acn " + QByteArray::number(eval.nodeCount()) + ';';
+		if (!eval.pv().isEmpty())
+			record += " pv " + eval.pv().toUtf8() + ';';
+		record += " bm " + move.toUtf8() + ";\n";
+		m_analyzedCount++;
+	}
+
+	m_results.insert(search.index, record);
+	writeResults();
+}
+
+void PositionAnalyzer::searchesFinished()
+{
+	// The results after interrupted searches
+	m_nextOutput = m_nextIndex;
+	for (const QByteArray& record : qAsConst(m_results))
+		m_output.write(record);
+	m_results.clear();
+	m_output.flush();
+
+	closeInput();
+}
+
+void PositionAnalyzer::writeResults()
+{
+	auto it = m_results.begin();
+	while (it != m_results.end() && it.key() == m_nextOutput)
+	{
+		m_output.write(it.value());
+		it = m_results.erase(it);
+		m_nextOutput++;
+	}
+	m_output.flush();
+}
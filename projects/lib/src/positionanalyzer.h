@@ -0,0 +1,109 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONANALYZER_H
+#define POSITIONANALYZER_H
+
+#include <QList>
+#include <QMap>
+#include <QQueue>
+#include <QByteArray>
+#include <QFile>
+#include "positionsearcher.h"
+class QIODevice;
+class PgnStream;
+
+/*!
+ * \brief Analyzes a stream of positions with chess engines
+ *
+ * PositionAnalyzer reads positions from EPD (or plain FEN) files,
+ * standard input or the games of PGN files, and lets the engines
+ * search each position once. The positions are shared by the engines
+ * in turn, and every engine can have several instances depending on
+ * the game manager's concurrency.
+ *
+ * The inputs are read as the searches progress, so they can be of
+ * any size. The results are written in the order of the input as
+ * EPD records with the standard analysis opcodes: "ce" (centipawn
+ * evaluation), "acd" (depth), "acn" (node count), "pv" (principal
+ * variation) and "bm" (the move played).
+ */
+class LIB_EXPORT PositionAnalyzer : public PositionSearcher
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new analyzer that plays through \a manager. */
+		explicit PositionAnalyzer(GameManager* manager,
+					  QObject* parent = nullptr);
+		/*! Destroys the analyzer. */
+		virtual ~PositionAnalyzer();
+
+		/*!
+		 * Adds the positions of EPD or FEN file \a fileName, or
+		 * of the standard input if \a fileName is "-".
+		 */
+		void addEpdFile(const QString& fileName);
+		/*!
+		 * Adds the positions before each move of the games in
+		 * PGN file \a fileName, which may be compressed.
+		 */
+		void addPgnFile(const QString& fileName);
+		/*!
+		 * Writes the results to \a fileName, or to the standard
+		 * output if \a fileName is empty (the default).
+		 *
+		 * Returns false if the file can't be opened.
+		 */
+		bool setOutput(const QString& fileName);
+		/*! Returns the number of positions analyzed so far. */
+		int analyzedCount() const;
+
+	protected:
+		// Inherited from PositionSearcher
+		virtual bool nextSearch(Search* search);
+		virtual void searchFinished(const Search& search,
+					    const QString& move,
+					    const MoveEvaluation& eval);
+		virtual void searchesFinished();
+
+	private:
+		struct Input
+		{
+			QString fileName;
+			bool isPgn;
+		};
+
+		bool readPositions();
+		bool openNextInput();
+		void closeInput();
+		void writeResults();
+
+		QQueue<Input> m_inputs;
+		QIODevice* m_input;
+		PgnStream* m_pgnStream;
+		QQueue<QString> m_fens;
+		QFile m_output;
+		// Results that wait for the earlier positions
+		QMap<int, QByteArray> m_results;
+		int m_nextIndex;
+		int m_nextOutput;
+		int m_analyzedCount;
+};
+
+#endif // POSITIONANALYZER_H
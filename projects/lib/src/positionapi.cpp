@@ -0,0 +1,122 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define CUTECHESS_API LIB_EXPORT
+#include "positionapi.h"
+#include "positionbatch.h"
+
+static_assert(sizeof(int) == sizeof(int32_t),
+	      "The C interface needs 32-bit integers");
+static_assert(PositionBatch::Ok == CUTECHESS_POSITION_OK
+	   && PositionBatch::InvalidFen == CUTECHESS_POSITION_INVALID_FEN
+	   && PositionBatch::IllegalMove == CUTECHESS_POSITION_ILLEGAL_MOVE,
+	      "PositionBatch::Status doesn't match the C interface");
+static_assert(PositionBatch::NoResult == CUTECHESS_RESULT_NONE
+	   && PositionBatch::WhiteWins == CUTECHESS_RESULT_WHITE_WINS
+	   && PositionBatch::BlackWins == CUTECHESS_RESULT_BLACK_WINS
+	   && PositionBatch::Draw == CUTECHESS_RESULT_DRAW,
+	      "PositionBatch::GameResult doesn't match the C interface");
+
+// The opaque batch type of the C interface
+struct CuteChessBatch
+{
+	explicit CuteChessBatch(const QString& variant)
+		: batch(variant)
+	{
+	}
+
+	PositionBatch batch;
+};
+
+CuteChessBatch* cutechess_batch_new(const char* variant, int threads)
+{
+	if (variant == nullptr)
+		return nullptr;
+
+	CuteChessBatch* batch = new CuteChessBatch(QString::fromUtf8(variant));
+	if (!batch->batch.isValid())
+	{
+		delete batch;
+		return nullptr;
+	}
+	if (threads > 0)
+		batch->batch.setThreadCount(threads);
+
+	return batch;
+}
+
+void cutechess_batch_free(CuteChessBatch* batch)
+{
+	delete batch;
+}
+
+int cutechess_batch_add(CuteChessBatch* batch, const char* fen, const char* moves)
+{
+	return batch->batch.addPosition(QString::fromUtf8(fen),
+					QString::fromUtf8(moves));
+}
+
+void cutechess_batch_clear(CuteChessBatch* batch)
+{
+	batch->batch.clear();
+}
+
+int cutechess_batch_size(const CuteChessBatch* batch)
+{
+	return batch->batch.size();
+}
+
+int cutechess_batch_run(CuteChessBatch* batch)
+{
+	return batch->batch.run();
+}
+
+const int32_t* cutechess_batch_statuses(const CuteChessBatch* batch)
+{
+	return batch->batch.statuses().constData();
+}
+
+const uint64_t* cutechess_batch_keys(const CuteChessBatch* batch)
+{
+	return reinterpret_cast<const uint64_t*>(batch->batch.keys().constData());
+}
+
+const int32_t* cutechess_batch_results(const CuteChessBatch* batch)
+{
+	return batch->batch.results().constData();
+}
+
+const char* cutechess_batch_fens(const CuteChessBatch* batch)
+{
+	return batch->batch.fens().constData();
+}
+
+const int32_t* cutechess_batch_fen_offsets(const CuteChessBatch* batch)
+{
+	return batch->batch.fenOffsets().constData();
+}
+
+const char* cutechess_batch_legal_moves(const CuteChessBatch* batch)
+{
+	return batch->batch.legalMoves().constData();
+}
+
+const int32_t* cutechess_batch_legal_move_offsets(const CuteChessBatch* batch)
+{
+	return batch->batch.legalMoveOffsets().constData();
+}
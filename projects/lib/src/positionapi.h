@@ -0,0 +1,120 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONAPI_H
+#define POSITIONAPI_H
+
+/*
+ * The C interface of PositionBatch, for replaying positions in bulk
+ * from other languages (eg. with Python's ctypes or Rust's FFI).
+ * The library must be built with "CONFIG+=dynamic" to be loaded
+ * at run time.
+ *
+ * A batch is filled with cutechess_batch_add() and replayed in
+ * parallel with cutechess_batch_run(). The outputs are flat arrays
+ * with one entry per position, in the order the positions were
+ * added. They are owned by the batch, and stay valid until the
+ * next call to cutechess_batch_add(), cutechess_batch_run(),
+ * cutechess_batch_clear() or cutechess_batch_free().
+ *
+ * The text outputs of all positions are stored back to back in one
+ * buffer, each string followed by a null character. The string of
+ * position i starts at offsets[i], and offsets[size] is the size of
+ * the buffer. The strings of positions that failed are empty.
+ *
+ * A batch must not be used by several threads at the same time, but
+ * different batches are independent. This header doesn't depend on
+ * Qt or Cute Chess.
+ */
+
+#include <stdint.h>
+
+#ifndef CUTECHESS_API
+#define CUTECHESS_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The status of a replayed position */
+#define CUTECHESS_POSITION_OK		0
+#define CUTECHESS_POSITION_INVALID_FEN	1
+#define CUTECHESS_POSITION_ILLEGAL_MOVE	2
+
+/* The game result in a final position */
+#define CUTECHESS_RESULT_NONE		0
+#define CUTECHESS_RESULT_WHITE_WINS	1
+#define CUTECHESS_RESULT_BLACK_WINS	2
+#define CUTECHESS_RESULT_DRAW		3
+
+typedef struct CuteChessBatch CuteChessBatch;
+
+/*
+ * Creates a batch of positions in chess variant \a variant, replayed
+ * by \a threads worker threads (0 for the number of CPU cores).
+ * Returns a null pointer if the variant is not supported.
+ */
+CUTECHESS_API CuteChessBatch* cutechess_batch_new(const char* variant,
+						  int threads);
+/* Destroys \a batch and its outputs. */
+CUTECHESS_API void cutechess_batch_free(CuteChessBatch* batch);
+
+/*
+ * Adds the position \a fen to \a batch and returns its index. A null
+ * or empty \a fen selects the starting position. \a moves is a null
+ * pointer or a space-separated list of moves to make from \a fen,
+ * in long algebraic or standard algebraic notation.
+ */
+CUTECHESS_API int cutechess_batch_add(CuteChessBatch* batch,
+				      const char* fen,
+				      const char* moves);
+/* Removes all positions and outputs from \a batch. */
+CUTECHESS_API void cutechess_batch_clear(CuteChessBatch* batch);
+/* Returns the number of positions in \a batch. */
+CUTECHESS_API int cutechess_batch_size(const CuteChessBatch* batch);
+
+/*
+ * Replays every position in \a batch and returns the number of
+ * positions that failed.
+ */
+CUTECHESS_API int cutechess_batch_run(CuteChessBatch* batch);
+
+/* Returns the CUTECHESS_POSITION_* status of each position. */
+CUTECHESS_API const int32_t* cutechess_batch_statuses(const CuteChessBatch* batch);
+/* Returns the Zobrist key of each final position. */
+CUTECHESS_API const uint64_t* cutechess_batch_keys(const CuteChessBatch* batch);
+/* Returns the CUTECHESS_RESULT_* game result of each final position. */
+CUTECHESS_API const int32_t* cutechess_batch_results(const CuteChessBatch* batch);
+/* Returns the FEN strings of the final positions. */
+CUTECHESS_API const char* cutechess_batch_fens(const CuteChessBatch* batch);
+/* Returns the offsets of the FEN strings, with size + 1 entries. */
+CUTECHESS_API const int32_t* cutechess_batch_fen_offsets(const CuteChessBatch* batch);
+/*
+ * Returns the legal moves of the final positions in long algebraic
+ * notation, separated by spaces.
+ */
+CUTECHESS_API const char* cutechess_batch_legal_moves(const CuteChessBatch* batch);
+/* Returns the offsets of the move lists, with size + 1 entries. */
+CUTECHESS_API const int32_t* cutechess_batch_legal_move_offsets(const CuteChessBatch* batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POSITIONAPI_H */
@@ -0,0 +1,282 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "positionbatch.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QScopedPointer>
+#include <QStringList>
+#include "board/board.h"
+#include "board/boardfactory.h"
+
+namespace {
+
+// The number of positions replayed by a task at a time
+const int s_chunkSize = 256;
+
+} // anonymous namespace
+
+/*!
+ * Takes chunks of positions from a shared counter until all of them
+ * have been replayed. The numeric outputs are written straight to
+ * the batch's arrays, and the text outputs to the chunk's Output.
+ */
+class PositionBatch::Task : public QRunnable
+{
+	public:
+		Task(Chess::Board* board,
+		     const QVector<Input>& inputs,
+		     QAtomicInt* nextChunk,
+		     Output* outputs,
+		     int* statuses,
+		     quint64* keys,
+		     int* results)
+			: m_board(board),
+			  m_inputs(inputs),
+			  m_nextChunk(nextChunk),
+			  m_outputs(outputs),
+			  m_statuses(statuses),
+			  m_keys(keys),
+			  m_results(results)
+		{
+		}
+
+		// Inherited from QRunnable
+		virtual void run()
+		{
+			const int size = m_inputs.size();
+			for (;;)
+			{
+				const int begin = m_nextChunk->fetchAndAddRelaxed(1)
+						  * s_chunkSize;
+				if (begin >= size)
+					break;
+
+				Output* output = m_outputs + begin / s_chunkSize;
+				const int end = qMin(size, begin + s_chunkSize);
+				for (int i = begin; i < end; i++)
+					replay(i, output);
+			}
+		}
+
+	private:
+		void replay(int index, Output* output)
+		{
+			Chess::Board* board = m_board.data();
+			const Input& input = m_inputs.at(index);
+			int status = Ok;
+
+			if (!board->setFenString(input.fen.isEmpty()
+						 ? board->defaultFenString()
+						 : input.fen))
+				status = InvalidFen;
+
+			const auto moves = input.moves.splitRef(' ', QString::SkipEmptyParts);
+			for (int i = 0; status == Ok && i < moves.size(); i++)
+			{
+				const Chess::Move move(board->moveFromString(moves.at(i).toString()));
+				if (move.isNull())
+					status = IllegalMove;
+				else
+					board->makeMove(move);
+			}
+
+			m_statuses[index] = status;
+			if (status != Ok)
+			{
+				output->fens += '\0';
+				output->fenLengths.append(1);
+				output->moves += '\0';
+				output->moveLengths.append(1);
+				return;
+			}
+
+			m_keys[index] = board->key();
+
+			const Chess::Result result(board->result());
+			if (result.isDraw())
+				m_results[index] = Draw;
+			else if (result.winner() == Chess::Side::White)
+				m_results[index] = WhiteWins;
+			else if (result.winner() == Chess::Side::Black)
+				m_results[index] = BlackWins;
+
+			const QByteArray fen(board->fenString().toLatin1());
+			output->fens += fen;
+			output->fens += '\0';
+			output->fenLengths.append(fen.size() + 1);
+
+			board->legalMoves(m_moves);
+			const int start = output->moves.size();
+			for (int i = 0; i < m_moves.size(); i++)
+			{
+				if (i > 0)
+					output->moves += ' ';
+				output->moves += board->moveString(m_moves.at(i),
+					Chess::Board::LongAlgebraic).toLatin1();
+			}
+			output->moves += '\0';
+			output->moveLengths.append(output->moves.size() - start);
+		}
+
+		QScopedPointer<Chess::Board> m_board;
+		const QVector<Input>& m_inputs;
+		QAtomicInt* m_nextChunk;
+		Output* m_outputs;
+		int* m_statuses;
+		quint64* m_keys;
+		int* m_results;
+		Chess::MoveList m_moves;
+};
+
+PositionBatch::PositionBatch(const QString& variant)
+	: m_board(Chess::BoardFactory::create(variant)),
+	  m_threadCount(QThread::idealThreadCount())
+{
+	if (m_board != nullptr)
+		m_board->initialize();
+	m_fenOffsets.append(0);
+	m_legalMoveOffsets.append(0);
+}
+
+PositionBatch::~PositionBatch()
+{
+	delete m_board;
+}
+
+bool PositionBatch::isValid() const
+{
+	return m_board != nullptr;
+}
+
+void PositionBatch::setThreadCount(int count)
+{
+	m_threadCount = qMax(1, count);
+}
+
+int PositionBatch::addPosition(const QString& fen, const QString& moves)
+{
+	m_inputs.append({ fen, moves });
+	return m_inputs.size() - 1;
+}
+
+void PositionBatch::clear()
+{
+	m_inputs.clear();
+	m_statuses.clear();
+	m_keys.clear();
+	m_results.clear();
+	m_fens.clear();
+	m_fenOffsets.fill(0, 1);
+	m_legalMoves.clear();
+	m_legalMoveOffsets.fill(0, 1);
+}
+
+int PositionBatch::size() const
+{
+	return m_inputs.size();
+}
+
+int PositionBatch::run()
+{
+	const int size = m_inputs.size();
+	m_statuses.fill(InvalidFen, size);
+	m_keys.fill(0, size);
+	m_results.fill(NoResult, size);
+	if (m_board == nullptr)
+	{
+		m_fens.clear();
+		m_fenOffsets.fill(0, size + 1);
+		m_legalMoves.clear();
+		m_legalMoveOffsets.fill(0, size + 1);
+		return size;
+	}
+
+	QVector<Output> outputs((size + s_chunkSize - 1) / s_chunkSize);
+	QThreadPool pool;
+	pool.setMaxThreadCount(m_threadCount);
+	QAtomicInt nextChunk(0);
+
+	// Detach the arrays before the threads write to them
+	int* statuses = m_statuses.data();
+	quint64* keys = m_keys.data();
+	int* results = m_results.data();
+	Output* chunks = outputs.data();
+
+	const int taskCount = qMin(m_threadCount, outputs.size());
+	for (int i = 0; i < taskCount; i++)
+		pool.start(new Task(m_board->copy(), m_inputs, &nextChunk,
+				    chunks, statuses, keys, results));
+	pool.waitForDone();
+
+	// Join the text outputs of the chunks in order
+	m_fens.clear();
+	m_legalMoves.clear();
+	m_fenOffsets.fill(0, 1);
+	m_legalMoveOffsets.fill(0, 1);
+	m_fenOffsets.reserve(size + 1);
+	m_legalMoveOffsets.reserve(size + 1);
+	for (const Output& output : qAsConst(outputs))
+	{
+		m_fens += output.fens;
+		m_legalMoves += output.moves;
+		for (int length : output.fenLengths)
+			m_fenOffsets.append(m_fenOffsets.last() + length);
+		for (int length : output.moveLengths)
+			m_legalMoveOffsets.append(m_legalMoveOffsets.last() + length);
+	}
+
+	return size - m_statuses.count(Ok);
+}
+
+const QVector<int>& PositionBatch::statuses() const
+{
+	return m_statuses;
+}
+
+const QVector<quint64>& PositionBatch::keys() const
+{
+	return m_keys;
+}
+
+const QVector<int>& PositionBatch::results() const
+{
+	return m_results;
+}
+
+const QByteArray& PositionBatch::fens() const
+{
+	return m_fens;
+}
+
+const QVector<int>& PositionBatch::fenOffsets() const
+{
+	return m_fenOffsets;
+}
+
+const QByteArray& PositionBatch::legalMoves() const
+{
+	return m_legalMoves;
+}
+
+const QVector<int>& PositionBatch::legalMoveOffsets() const
+{
+	return m_legalMoveOffsets;
+}
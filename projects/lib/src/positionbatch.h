@@ -0,0 +1,162 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONBATCH_H
+#define POSITIONBATCH_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QString>
+namespace Chess { class Board; }
+
+/*!
+ * \brief Replays many positions at once
+ *
+ * PositionBatch takes a list of positions, each given as a FEN
+ * string and an optional list of moves to make from it, and
+ * computes the legal moves, the FEN string, the Zobrist key and the
+ * game result of each final position.
+ *
+ * The positions are split between a pool of worker threads, each
+ * with its own copy of the board. The outputs are stored in flat
+ * arrays indexed by the position, so they can be handed to other
+ * languages without conversion. The text outputs are stored back to
+ * back in one buffer, with the start of each position's string in
+ * an offset array that has an extra entry for the end.
+ *
+ * \sa positionapi.h for the C interface
+ */
+class LIB_EXPORT PositionBatch
+{
+	public:
+		/*! The status of a replayed position. */
+		enum Status
+		{
+			Ok,		//!< The position was replayed.
+			InvalidFen,	//!< The FEN string is invalid.
+			IllegalMove	//!< One of the moves is illegal.
+		};
+		/*! The result of the game in a final position. */
+		enum GameResult
+		{
+			NoResult,	//!< The game continues.
+			WhiteWins,	//!< White wins.
+			BlackWins,	//!< Black wins.
+			Draw		//!< The game is drawn.
+		};
+
+		/*!
+		 * Creates a new batch of positions in chess variant
+		 * \a variant.
+		 *
+		 * \sa isValid()
+		 */
+		explicit PositionBatch(const QString& variant);
+		/*! Destroys the batch. */
+		~PositionBatch();
+
+		/*! Returns true if the variant is supported. */
+		bool isValid() const;
+		/*!
+		 * Sets the number of worker threads to \a count.
+		 * The default is the number of CPU cores.
+		 */
+		void setThreadCount(int count);
+
+		/*!
+		 * Adds the position \a fen to the batch, and returns its
+		 * index. An empty \a fen selects the variant's starting
+		 * position.
+		 *
+		 * \a moves is a space-separated list of moves, in any
+		 * notation supported by the board, to make from \a fen.
+		 */
+		int addPosition(const QString& fen,
+				const QString& moves = QString());
+		/*! Removes all positions and outputs. */
+		void clear();
+		/*! Returns the number of positions. */
+		int size() const;
+
+		/*!
+		 * Replays every position in the batch, replacing the
+		 * outputs of the previous call.
+		 *
+		 * Returns the number of positions whose status isn't Ok.
+		 * The outputs of those positions are empty.
+		 */
+		int run();
+
+		/*! Returns the status of each position. */
+		const QVector<int>& statuses() const;
+		/*! Returns the Zobrist key of each final position. */
+		const QVector<quint64>& keys() const;
+		/*! Returns the GameResult of each final position. */
+		const QVector<int>& results() const;
+		/*!
+		 * Returns the FEN strings of the final positions,
+		 * each followed by a null character.
+		 */
+		const QByteArray& fens() const;
+		/*!
+		 * Returns the offsets of the FEN strings in fens(), with
+		 * one more entry for the end of the buffer.
+		 */
+		const QVector<int>& fenOffsets() const;
+		/*!
+		 * Returns the legal moves of the final positions, in
+		 * long algebraic notation. The moves of a position are
+		 * separated by spaces and followed by a null character.
+		 */
+		const QByteArray& legalMoves() const;
+		/*!
+		 * Returns the offsets of the move lists in legalMoves(),
+		 * with one more entry for the end of the buffer.
+		 */
+		const QVector<int>& legalMoveOffsets() const;
+
+	private:
+		Q_DISABLE_COPY(PositionBatch)
+
+		class Task;
+		struct Input
+		{
+			QString fen;
+			QString moves;
+		};
+		struct Output
+		{
+			QByteArray fens;
+			QByteArray moves;
+			QVector<int> fenLengths;
+			QVector<int> moveLengths;
+		};
+
+		Chess::Board* m_board;
+		int m_threadCount;
+		QVector<Input> m_inputs;
+		QVector<int> m_statuses;
+		QVector<quint64> m_keys;
+		QVector<int> m_results;
+		QByteArray m_fens;
+		QVector<int> m_fenOffsets;
+		QByteArray m_legalMoves;
+		QVector<int> m_legalMoveOffsets;
+};
+
+#endif // POSITIONBATCH_H
@@ -0,0 +1,101 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "positionindex.h"
+#include <QFile>
+#include <QDataStream>
+
+PositionIndex::PositionIndex(const QString& fileName)
+	: m_fileName(fileName)
+{
+}
+
+QString PositionIndex::fileName() const
+{
+	return m_fileName;
+}
+
+bool PositionIndex::isValid() const
+{
+	QFile file(m_fileName);
+	return file.exists() && file.size() % EntrySize == 0;
+}
+
+void PositionIndex::readEntry(QDataStream& in, Entry* entry)
+{
+	in >> entry->key >> entry->game >> entry->ply;
+}
+
+void PositionIndex::writeEntry(QDataStream& out, const Entry& entry)
+{
+	out << entry.key << entry.game << entry.ply;
+}
+
+QList<PositionIndex::Entry> PositionIndex::entries(quint64 key) const
+{
+	QList<Entry> entries;
+	QFile file(m_fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return entries;
+	if (file.size() % EntrySize != 0)
+	{
+		qWarning("Invalid size for position index %s",
+			 qUtf8Printable(m_fileName));
+		return entries;
+	}
+	QDataStream in(&file);
+
+	// Binary search for the first entry of the position
+	Entry entry;
+	qint64 first = 0;
+	qint64 last = file.size() / EntrySize;
+	while (first < last)
+	{
+		qint64 middle = (first + last) / 2;
+		file.seek(middle * EntrySize);
+		readEntry(in, &entry);
+		if (entry.key < key)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	file.seek(first * EntrySize);
+	while (!in.atEnd())
+	{
+		readEntry(in, &entry);
+		if (in.status() != QDataStream::Ok || entry.key != key)
+			break;
+		entries << entry;
+	}
+
+	return entries;
+}
+
+QVector<int> PositionIndex::games(quint64 key) const
+{
+	QVector<int> games;
+	const auto posEntries = entries(key);
+	for (const Entry& entry : posEntries)
+	{
+		// The entries are sorted by game
+		if (games.isEmpty() || games.last() != int(entry.game))
+			games.append(int(entry.game));
+	}
+
+	return games;
+}
@@ -0,0 +1,99 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONINDEX_H
+#define POSITIONINDEX_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QList>
+#include <QVector>
+class QDataStream;
+
+/*!
+ * \brief An on-disk index of the positions reached in a game collection.
+ *
+ * A position index file is a table of (Zobrist key, game, ply)
+ * entries sorted by key, so the games that reach a position can be
+ * found with a binary search without loading the index to memory.
+ * Each entry takes EntrySize bytes in the file.
+ *
+ * Index files are created with PositionIndexWriter.
+ *
+ * \sa PositionIndexWriter, Chess::Board::key()
+ */
+class LIB_EXPORT PositionIndex
+{
+	public:
+		/*! The size of an entry in the index file. */
+		static const int EntrySize = 14;
+
+		/*! An entry in the position index. */
+		struct Entry
+		{
+			/*! The Zobrist key of the position. */
+			quint64 key;
+			/*! The number of the game in the collection. */
+			quint32 game;
+			/*! The ply at which the game reaches the position. */
+			quint16 ply;
+		};
+
+		/*! Creates a position index that reads file \a fileName. */
+		explicit PositionIndex(const QString& fileName);
+
+		/*! Returns the file name of the index. */
+		QString fileName() const;
+		/*!
+		 * Returns true if the index file exists and has a valid
+		 * size; otherwise returns false.
+		 */
+		bool isValid() const;
+		/*!
+		 * Returns the entries of the position whose Zobrist key is
+		 * \a key, sorted by game and ply.
+		 */
+		QList<Entry> entries(quint64 key) const;
+		/*!
+		 * Returns the numbers of the games that reach the position
+		 * whose Zobrist key is \a key, in ascending order.
+		 */
+		QVector<int> games(quint64 key) const;
+
+		/*! Reads an entry from \a in to \a entry. */
+		static void readEntry(QDataStream& in, Entry* entry);
+		/*! Writes \a entry to \a out. */
+		static void writeEntry(QDataStream& out, const Entry& entry);
+
+	private:
+		QString m_fileName;
+};
+
+/*! Returns true if \a a comes before \a b in a position index file. */
+inline bool operator<(const PositionIndex::Entry& a,
+		      const PositionIndex::Entry& b)
+{
+	if (a.key != b.key)
+		return a.key < b.key;
+	if (a.game != b.game)
+		return a.game < b.game;
+	return a.ply < b.ply;
+}
+
+Q_DECLARE_TYPEINFO(PositionIndex::Entry, Q_PRIMITIVE_TYPE);
+
+#endif // POSITIONINDEX_H
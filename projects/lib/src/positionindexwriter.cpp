@@ -0,0 +1,175 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "positionindexwriter.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QSharedPointer>
+#include "pgngame.h"
+
+namespace {
+
+struct MergeSource
+{
+	PositionIndex::Entry entry;
+	int source;
+
+	bool operator>(const MergeSource& other) const
+	{
+		return other.entry < entry;
+	}
+};
+
+} // anonymous namespace
+
+PositionIndexWriter::PositionIndexWriter(const QString& fileName,
+					 int bufferSize)
+	: m_fileName(fileName),
+	  m_bufferSize(qMax(1, bufferSize)),
+	  m_ok(true)
+{
+}
+
+PositionIndexWriter::~PositionIndexWriter()
+{
+	qDeleteAll(m_runs);
+}
+
+void PositionIndexWriter::setBaseIndex(const QString& fileName)
+{
+	m_baseFileName = fileName;
+}
+
+void PositionIndexWriter::addPosition(quint64 key, quint32 game, quint16 ply)
+{
+	PositionIndex::Entry entry = { key, game, ply };
+	m_buffer.append(entry);
+
+	if (m_buffer.size() >= m_bufferSize)
+		m_ok = writeRun() && m_ok;
+}
+
+void PositionIndexWriter::addGame(quint32 game,
+				  const PgnGame& pgn,
+				  quint64 finalKey)
+{
+	const QVector<PgnGame::MoveData>& moves = pgn.moves();
+	const int count = qMin(moves.size(), 0xFFFF + 1);
+	for (int i = 0; i < count; i++)
+		addPosition(moves.at(i).key, game, quint16(i));
+	if (count > 0 && count == moves.size() && count <= 0xFFFF)
+		addPosition(finalKey, game, quint16(count));
+}
+
+bool PositionIndexWriter::writeRun()
+{
+	if (m_buffer.isEmpty())
+		return true;
+
+	std::sort(m_buffer.begin(), m_buffer.end());
+
+	QTemporaryFile* run = new QTemporaryFile;
+	m_runs.append(run);
+	if (!run->open())
+	{
+		m_buffer.clear();
+		return false;
+	}
+
+	QDataStream out(run);
+	for (const PositionIndex::Entry& entry : qAsConst(m_buffer))
+		PositionIndex::writeEntry(out, entry);
+	m_buffer.clear();
+
+	return out.status() == QDataStream::Ok && run->flush();
+}
+
+bool PositionIndexWriter::finish()
+{
+	if (!m_ok || !writeRun())
+		return false;
+
+	// Each sorted run and the base index is a merge source
+	QList<QSharedPointer<QFile>> files;
+	for (QTemporaryFile* run : qAsConst(m_runs))
+	{
+		run->seek(0);
+		files.append(QSharedPointer<QFile>(run, [](QFile*) {}));
+	}
+	if (!m_baseFileName.isEmpty() && QFile::exists(m_baseFileName))
+	{
+		QSharedPointer<QFile> base(new QFile(m_baseFileName));
+		if (!base->open(QIODevice::ReadOnly))
+			return false;
+		files.append(base);
+	}
+
+	QSaveFile output(m_fileName);
+	if (!output.open(QIODevice::WriteOnly))
+		return false;
+	QDataStream out(&output);
+
+	QVector<QSharedPointer<QDataStream>> inputs;
+	std::priority_queue<MergeSource, std::vector<MergeSource>,
+			    std::greater<MergeSource>> queue;
+	for (int i = 0; i < files.size(); i++)
+	{
+		inputs.append(QSharedPointer<QDataStream>(
+			new QDataStream(files.at(i).data())));
+		if (!inputs.last()->atEnd())
+		{
+			MergeSource next;
+			next.source = i;
+			PositionIndex::readEntry(*inputs.last(), &next.entry);
+			queue.push(next);
+		}
+	}
+
+	while (!queue.empty())
+	{
+		MergeSource next = queue.top();
+		queue.pop();
+		PositionIndex::writeEntry(out, next.entry);
+
+		QDataStream& in = *inputs.at(next.source);
+		if (!in.atEnd())
+		{
+			PositionIndex::readEntry(in, &next.entry);
+			queue.push(next);
+		}
+	}
+
+	for (const auto& in : qAsConst(inputs))
+	{
+		if (in->status() != QDataStream::Ok)
+			return false;
+	}
+	if (out.status() != QDataStream::Ok)
+		return false;
+
+	// The base index may be the output file, so it
+	// must be closed before the output replaces it
+	inputs.clear();
+	files.clear();
+
+	return output.commit();
+}
@@ -0,0 +1,87 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONINDEXWRITER_H
+#define POSITIONINDEXWRITER_H
+
+#include <QList>
+#include <QVector>
+#include "positionindex.h"
+class QTemporaryFile;
+class PgnGame;
+
+/*!
+ * \brief Creates position index files.
+ *
+ * PositionIndexWriter collects position entries in a buffer of a
+ * fixed size. Whenever the buffer is full it is sorted and written
+ * to a temporary file, and finish() merges the temporary files into
+ * the index. This way indexing a large game collection only takes
+ * memory for the buffer.
+ *
+ * \sa PositionIndex
+ */
+class LIB_EXPORT PositionIndexWriter
+{
+	public:
+		/*!
+		 * Creates a writer for index file \a fileName which
+		 * buffers up to \a bufferSize entries in memory.
+		 */
+		explicit PositionIndexWriter(const QString& fileName,
+					     int bufferSize = 1 << 20);
+		/*! Destroys the writer and its temporary files. */
+		~PositionIndexWriter();
+
+		/*!
+		 * Merges the entries of the existing index file \a fileName
+		 * into the new index. \a fileName may be the file that is
+		 * being written.
+		 */
+		void setBaseIndex(const QString& fileName);
+
+		/*! Adds the position \a key reached by \a game at \a ply. */
+		void addPosition(quint64 key, quint32 game, quint16 ply);
+		/*!
+		 * Adds the positions of \a pgn, which is game number
+		 * \a game of the collection.
+		 *
+		 * The moves of \a pgn only store the positions before
+		 * them, so the final position is given by \a finalKey,
+		 * eg. the key of the PgnStream's board after reading
+		 * the game.
+		 */
+		void addGame(quint32 game, const PgnGame& pgn, quint64 finalKey);
+
+		/*!
+		 * Writes the index file.
+		 * Returns true if successful; otherwise returns false.
+		 */
+		bool finish();
+
+	private:
+		bool writeRun();
+
+		QString m_fileName;
+		QString m_baseFileName;
+		int m_bufferSize;
+		bool m_ok;
+		QVector<PositionIndex::Entry> m_buffer;
+		QList<QTemporaryFile*> m_runs;
+};
+
+#endif // POSITIONINDEXWRITER_H
@@ -0,0 +1,312 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "positionsearcher.h"
+#include <QMetaType>
+#include "board/boardfactory.h"
+#include "chessgame.h"
+#include "chessplayer.h"
+#include "enginebuilder.h"
+#include "engineconfiguration.h"
+#include "gamemanager.h"
+#include "humanbuilder.h"
+#include "pgngame.h"
+#include "uciengine.h"
+
+PositionSearcher::PositionSearcher(GameManager* manager, QObject* parent)
+	: QObject(parent),
+	  m_manager(manager),
+	  m_board(nullptr),
+	  m_opponent(new HumanBuilder()),
+	  m_newGame(true),
+	  m_exhausted(false),
+	  m_stopping(false),
+	  m_finished(false)
+{
+	Q_ASSERT(manager != nullptr);
+
+	// The engines' evaluations are passed from the game threads
+	qRegisterMetaType<MoveEvaluation>("MoveEvaluation");
+	setVariant("standard");
+}
+
+PositionSearcher::~PositionSearcher()
+{
+	for (const Engine& engine : qAsConst(m_engines))
+		delete engine.builder;
+	delete m_opponent;
+	delete m_board;
+}
+
+bool PositionSearcher::setVariant(const QString& variant)
+{
+	Chess::Board* board = Chess::BoardFactory::create(variant);
+	if (board == nullptr)
+		return false;
+
+	delete m_board;
+	m_board = board;
+	m_variant = variant;
+	return true;
+}
+
+QString PositionSearcher::variant() const
+{
+	return m_variant;
+}
+
+void PositionSearcher::addEngine(const EngineConfiguration& config,
+				 const TimeControl& timeControl)
+{
+	Engine engine;
+	engine.builder = new EngineBuilder(config);
+	engine.name = config.name();
+	if (engine.name.isEmpty())
+		engine.name = tr("Engine %1").arg(m_engines.size() + 1);
+	engine.timeControl = timeControl;
+
+	m_engines.append(engine);
+}
+
+int PositionSearcher::engineCount() const
+{
+	return m_engines.size();
+}
+
+QString PositionSearcher::engineName(int engine) const
+{
+	return m_engines.at(engine).name;
+}
+
+void PositionSearcher::setNewGameEnabled(bool enabled)
+{
+	m_newGame = enabled;
+}
+
+QString PositionSearcher::errorString() const
+{
+	return m_error;
+}
+
+Chess::Board* PositionSearcher::board() const
+{
+	return m_board;
+}
+
+void PositionSearcher::setError(const QString& error)
+{
+	m_error = error;
+}
+
+void PositionSearcher::searchUpdated(const Search& search,
+				     const MoveEvaluation& eval)
+{
+	Q_UNUSED(search);
+	Q_UNUSED(eval);
+}
+
+void PositionSearcher::searchesFinished()
+{
+}
+
+void PositionSearcher::start()
+{
+	Q_ASSERT(!m_engines.isEmpty());
+
+	connect(m_manager, SIGNAL(readyForGames(int)),
+		this, SLOT(startNextGames(int)));
+	startNextGames(1);
+}
+
+void PositionSearcher::stop()
+{
+	if (m_stopping || m_finished)
+		return;
+
+	disconnect(m_manager, SIGNAL(readyForGames(int)),
+		   this, SLOT(startNextGames(int)));
+	if (m_searches.isEmpty())
+	{
+		onFinished();
+		return;
+	}
+
+	m_stopping = true;
+	const auto games = m_searches.keys();
+	for (ChessGame* game : games)
+		QMetaObject::invokeMethod(game, "stop", Qt::QueuedConnection);
+}
+
+void PositionSearcher::startNextGames(int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (!startNextGame())
+			break;
+	}
+
+	if (m_exhausted && m_searches.isEmpty())
+		onFinished();
+}
+
+bool PositionSearcher::startNextGame()
+{
+	if (m_stopping || m_exhausted)
+		return false;
+
+	ActiveSearch active;
+	for (;;)
+	{
+		if (!nextSearch(&active.search))
+		{
+			m_exhausted = true;
+			return false;
+		}
+		if (m_board->setFenString(active.search.fen))
+			break;
+
+		// Invalid positions end without a move
+		qWarning("Invalid position: %s",
+			 qUtf8Printable(active.search.fen));
+		searchFinished(active.search, QString(), MoveEvaluation());
+	}
+	Q_ASSERT(active.search.engine >= 0
+		 && active.search.engine < m_engines.size());
+
+	const Search& search = active.search;
+	const Engine& engine = m_engines.at(search.engine);
+
+	Chess::Board* board = Chess::BoardFactory::create(m_variant);
+	Q_ASSERT(board != nullptr);
+	ChessGame* game = new ChessGame(board, new PgnGame());
+	game->setStartingFen(search.fen);
+
+	// The engine plays the side to move against an idle opponent,
+	// and the game ends after the engine's move
+	const Chess::Side side = m_board->sideToMove();
+	TimeControl infinite;
+	infinite.setInfinity(true);
+	game->setTimeControl(engine.timeControl, side);
+	game->setTimeControl(infinite, side.opposite());
+
+	active.context = new QObject(this);
+	QObject* context = active.context;
+	const bool newGame = m_newGame;
+	connect(game, &ChessGame::moveMade, game, [=]()
+	{
+		QMetaObject::invokeMethod(game, "stop", Qt::QueuedConnection);
+	});
+	// Runs in the game thread before the engine starts thinking
+	connect(game, &ChessGame::started, context, [=]()
+	{
+		ChessPlayer* player = game->player(side);
+		if (auto uci = qobject_cast<UciEngine*>(player))
+			uci->setNewGameEnabled(newGame);
+		connect(player, &ChessPlayer::thinking, context,
+			[=](const MoveEvaluation& eval)
+		{
+			onThinking(game, eval);
+		});
+	}, Qt::DirectConnection);
+	connect(game, SIGNAL(finished(ChessGame*)),
+		this, SLOT(onGameFinished(ChessGame*)));
+	connect(game, SIGNAL(startFailed(ChessGame*)),
+		this, SLOT(onGameStartFailed(ChessGame*)));
+
+	m_searches.insert(game, active);
+	const PlayerBuilder* white = side == Chess::Side::White
+				     ? engine.builder : m_opponent;
+	const PlayerBuilder* black = side == Chess::Side::White
+				     ? m_opponent : engine.builder;
+	m_manager->newGame(game, white, black,
+			   GameManager::Enqueue,
+			   GameManager::ReusePlayers);
+	return true;
+}
+
+void PositionSearcher::onThinking(ChessGame* game, const MoveEvaluation& eval)
+{
+	auto it = m_searches.find(game);
+	if (it == m_searches.end() || eval.pvNumber() > 1)
+		return;
+
+	it->eval = eval;
+	searchUpdated(it->search, eval);
+}
+
+void PositionSearcher::onGameFinished(ChessGame* game)
+{
+	auto it = m_searches.find(game);
+	Q_ASSERT(it != m_searches.end());
+	ActiveSearch active = *it;
+	m_searches.erase(it);
+	delete active.context;
+
+	PgnGame* pgn = game->pgn();
+	QString move;
+	if (!pgn->moves().isEmpty())
+	{
+		const PgnGame::MoveData& md = pgn->moves().first();
+		move = md.moveString;
+
+		// Engines that don't report their thinking still have
+		// the evaluation of their move
+		if (active.eval.isEmpty())
+			active.eval = md.evaluation;
+	}
+
+	delete pgn;
+	game->deleteLater();
+
+	// Searches that were interrupted aren't reported
+	if (!m_stopping || !move.isEmpty())
+		searchFinished(active.search, move, active.eval);
+
+	if (m_searches.isEmpty() && (m_stopping || m_exhausted))
+		onFinished();
+}
+
+void PositionSearcher::onGameStartFailed(ChessGame* game)
+{
+	m_error = game->errorString();
+
+	auto it = m_searches.find(game);
+	if (it != m_searches.end())
+	{
+		delete it->context;
+		m_searches.erase(it);
+	}
+	delete game->pgn();
+	game->deleteLater();
+
+	stop();
+}
+
+void PositionSearcher::onFinished()
+{
+	if (m_finished)
+		return;
+
+	disconnect(m_manager, SIGNAL(readyForGames(int)),
+		   this, SLOT(startNextGames(int)));
+	m_finished = true;
+	searchesFinished();
+
+	connect(m_manager, SIGNAL(finished()), this, SIGNAL(finished()));
+	m_manager->finish();
+}
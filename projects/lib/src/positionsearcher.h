@@ -0,0 +1,191 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONSEARCHER_H
+#define POSITIONSEARCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include "moveevaluation.h"
+#include "timecontrol.h"
+class GameManager;
+class ChessGame;
+class EngineConfiguration;
+class PlayerBuilder;
+namespace Chess { class Board; }
+
+/*!
+ * \brief A base class for letting engines search many positions
+ *
+ * PositionSearcher lets engines search positions one move deep, eg.
+ * to run test suites or to analyze positions. The subclass hands out
+ * the searches with nextSearch() and receives the results through
+ * searchUpdated() and searchFinished().
+ *
+ * Each search is played as a one-move game against an idle human
+ * opponent through a GameManager, so as many searches run in parallel
+ * as the manager's concurrency allows, and the engine instances stay
+ * running between searches. The next searches are handed out as soon
+ * as game slots become free. The searches are limited by the engines'
+ * time controls (eg. a fixed time, depth or node count per move).
+ */
+class LIB_EXPORT PositionSearcher : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new searcher that plays through \a manager. */
+		explicit PositionSearcher(GameManager* manager,
+					  QObject* parent = nullptr);
+		/*! Destroys the searcher and its player builders. */
+		virtual ~PositionSearcher();
+
+		/*!
+		 * Sets the chess variant of the positions to \a variant.
+		 * The default is "standard".
+		 *
+		 * Returns false if \a variant is not supported.
+		 */
+		bool setVariant(const QString& variant);
+		/*! Returns the chess variant of the positions. */
+		QString variant() const;
+
+		/*!
+		 * Adds an engine defined by \a config that searches each
+		 * position under \a timeControl.
+		 */
+		void addEngine(const EngineConfiguration& config,
+			       const TimeControl& timeControl);
+		/*! Returns the number of engines. */
+		int engineCount() const;
+		/*! Returns the name of \a engine. */
+		QString engineName(int engine) const;
+
+		/*!
+		 * If \a enabled is true (the default), UCI engines are told
+		 * that a new game starts before each search. Otherwise
+		 * they keep their hash tables and other state between
+		 * searches.
+		 */
+		void setNewGameEnabled(bool enabled);
+
+		/*! Returns the last error, or an empty string. */
+		QString errorString() const;
+
+	public slots:
+		/*! Starts the searches. */
+		void start();
+		/*!
+		 * Stops the searches. The ongoing searches are stopped and
+		 * the finished() signal is emitted when they have ended.
+		 */
+		void stop();
+
+	signals:
+		/*! Emitted when all of the searches have ended. */
+		void finished();
+
+	protected:
+		/*! A search of one position by one engine. */
+		struct Search
+		{
+			/*! The number of the search, chosen by the subclass. */
+			int index;
+			/*! The index of the engine. */
+			int engine;
+			/*! The position as a FEN string. */
+			QString fen;
+		};
+
+		/*!
+		 * Fills \a search with the next search to start.
+		 * Returns false if there are no more searches.
+		 */
+		virtual bool nextSearch(Search* search) = 0;
+		/*!
+		 * Called when the engine of \a search reports its primary
+		 * principal variation in \a eval.
+		 *
+		 * The default implementation does nothing.
+		 */
+		virtual void searchUpdated(const Search& search,
+					   const MoveEvaluation& eval);
+		/*!
+		 * Called when \a search has ended with \a move (in SAN).
+		 * \a eval is the engine's last evaluation of the position.
+		 *
+		 * If the engine didn't move, \a move is empty. Searches
+		 * that are interrupted by stop() are not reported.
+		 */
+		virtual void searchFinished(const Search& search,
+					    const QString& move,
+					    const MoveEvaluation& eval) = 0;
+		/*!
+		 * Called before the finished() signal is emitted.
+		 *
+		 * The default implementation does nothing.
+		 */
+		virtual void searchesFinished();
+
+		/*!
+		 * Returns a board of the chess variant, which the subclass
+		 * can use for validating positions and moves.
+		 */
+		Chess::Board* board() const;
+		/*! Sets the error string to \a error. */
+		void setError(const QString& error);
+
+	private slots:
+		void startNextGames(int count);
+		void onGameFinished(ChessGame* game);
+		void onGameStartFailed(ChessGame* game);
+
+	private:
+		struct Engine
+		{
+			PlayerBuilder* builder;
+			QString name;
+			TimeControl timeControl;
+		};
+		struct ActiveSearch
+		{
+			Search search;
+			QObject* context;
+			MoveEvaluation eval;
+		};
+
+		bool startNextGame();
+		void onThinking(ChessGame* game, const MoveEvaluation& eval);
+		void onFinished();
+
+		GameManager* m_manager;
+		Chess::Board* m_board;
+		PlayerBuilder* m_opponent;
+		QString m_variant;
+		QVector<Engine> m_engines;
+		QHash<ChessGame*, ActiveSearch> m_searches;
+		bool m_newGame;
+		bool m_exhausted;
+		bool m_stopping;
+		bool m_finished;
+		QString m_error;
+};
+
+#endif // POSITIONSEARCHER_H
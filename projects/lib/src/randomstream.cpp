@@ -0,0 +1,79 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "randomstream.h"
+
+namespace {
+
+const quint64 s_gamma = Q_UINT64_C(0x9E3779B97F4A7C15);
+
+thread_local RandomStream* s_current = nullptr;
+
+quint64 mix(quint64 z)
+{
+	z = (z ^ (z >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+	z = (z ^ (z >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+	return z ^ (z >> 31);
+}
+
+} // anonymous namespace
+
+RandomStream::RandomStream()
+	: m_origin(0),
+	  m_position(0),
+	  m_valid(false)
+{
+}
+
+RandomStream::RandomStream(quint64 seed, quint64 stream)
+	: m_origin(mix(mix(seed) + stream * s_gamma)),
+	  m_position(0),
+	  m_valid(true)
+{
+}
+
+bool RandomStream::isValid() const
+{
+	return m_valid;
+}
+
+quint64 RandomStream::position() const
+{
+	return m_position;
+}
+
+void RandomStream::seek(quint64 position)
+{
+	m_position = position;
+}
+
+quint32 RandomStream::next()
+{
+	m_position++;
+	return quint32(mix(m_origin + m_position * s_gamma) >> 32);
+}
+
+RandomStream* RandomStream::current()
+{
+	return s_current;
+}
+
+void RandomStream::setCurrent(RandomStream* stream)
+{
+	s_current = stream;
+}
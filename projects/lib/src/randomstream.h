@@ -0,0 +1,101 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RANDOMSTREAM_H
+#define RANDOMSTREAM_H
+
+#include <QtGlobal>
+
+/*!
+ * \brief A seekable stream of pseudorandom numbers
+ *
+ * RandomStream generates numbers with the SplitMix64 algorithm. The
+ * n-th number depends only on the seed, the stream number and n, so
+ * the stream can jump to any position in constant time, and streams
+ * with different numbers are independent of each other.
+ *
+ * A stream can be made the source of Mersenne::random() in the calling
+ * thread with a Scope object. This gives each game a reproducible
+ * sequence of opening book moves, random start positions and random
+ * opening plies that doesn't depend on the other games running at the
+ * same time, and the games don't contend for Mersenne's global lock.
+ */
+class LIB_EXPORT RandomStream
+{
+	public:
+		/*!
+		 * \brief Makes a stream the calling thread's random source
+		 *
+		 * Mersenne::random() draws from the stream while the
+		 * Scope exists. Scopes can be nested. A Scope with an
+		 * invalid stream changes nothing.
+		 */
+		class Scope
+		{
+			public:
+				/*! Makes \a stream the current stream. */
+				explicit Scope(RandomStream* stream)
+					: m_previous(RandomStream::current()),
+					  m_active(stream->isValid())
+				{
+					if (m_active)
+						RandomStream::setCurrent(stream);
+				}
+				/*! Restores the previous stream. */
+				~Scope()
+				{
+					if (m_active)
+						RandomStream::setCurrent(m_previous);
+				}
+
+			private:
+				Q_DISABLE_COPY(Scope)
+
+				RandomStream* m_previous;
+				bool m_active;
+		};
+
+		/*! Creates an invalid stream. */
+		RandomStream();
+		/*! Creates stream number \a stream of \a seed. */
+		RandomStream(quint64 seed, quint64 stream);
+
+		/*! Returns true if the stream was created with a seed. */
+		bool isValid() const;
+		/*! Returns the number of numbers drawn from the stream. */
+		quint64 position() const;
+		/*! Moves to \a position numbers from the start. */
+		void seek(quint64 position);
+		/*! Returns the next number in the stream. */
+		quint32 next();
+
+		/*!
+		 * Returns the calling thread's current stream, or nullptr
+		 * if there is none.
+		 */
+		static RandomStream* current();
+
+	private:
+		static void setCurrent(RandomStream* stream);
+
+		quint64 m_origin;
+		quint64 m_position;
+		bool m_valid;
+};
+
+#endif // RANDOMSTREAM_H
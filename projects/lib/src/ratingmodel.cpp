@@ -0,0 +1,158 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ratingmodel.h"
+#include <cmath>
+
+namespace {
+
+const int s_maxIterations = 10000;
+const qreal s_tolerance = 1e-9;
+// Elo points per natural logarithm of the strength ratio
+const qreal s_eloScale = 400.0 / std::log(10.0);
+
+} // anonymous namespace
+
+RatingModel::RatingModel(int playerCount)
+	: m_playerCount(playerCount),
+	  m_games(playerCount * playerCount, 0),
+	  m_points(playerCount * playerCount, 0),
+	  m_dirty(false),
+	  m_gammas(playerCount, 1.0),
+	  m_ratings(playerCount, 0.0),
+	  m_errorMargins(playerCount, 0.0)
+{
+}
+
+int RatingModel::playerCount() const
+{
+	return m_playerCount;
+}
+
+void RatingModel::addResult(int first, int second, int firstScore)
+{
+	Q_ASSERT(first >= 0 && first < m_playerCount);
+	Q_ASSERT(second >= 0 && second < m_playerCount);
+	Q_ASSERT(first != second);
+	Q_ASSERT(firstScore >= 0 && firstScore <= 2);
+
+	m_games[first * m_playerCount + second]++;
+	m_games[second * m_playerCount + first]++;
+	m_points[first * m_playerCount + second] += firstScore;
+	m_points[second * m_playerCount + first] += 2 - firstScore;
+	m_dirty = true;
+}
+
+int RatingModel::games(int first, int second) const
+{
+	Q_ASSERT(first >= 0 && first < m_playerCount);
+	Q_ASSERT(second >= 0 && second < m_playerCount);
+
+	return m_games.at(first * m_playerCount + second);
+}
+
+int RatingModel::points(int first, int second) const
+{
+	Q_ASSERT(first >= 0 && first < m_playerCount);
+	Q_ASSERT(second >= 0 && second < m_playerCount);
+
+	return m_points.at(first * m_playerCount + second);
+}
+
+qreal RatingModel::rating(int index) const
+{
+	Q_ASSERT(index >= 0 && index < m_playerCount);
+
+	if (m_dirty)
+		solve();
+	return m_ratings.at(index);
+}
+
+qreal RatingModel::errorMargin(int index) const
+{
+	Q_ASSERT(index >= 0 && index < m_playerCount);
+
+	if (m_dirty)
+		solve();
+	return m_errorMargins.at(index);
+}
+
+void RatingModel::solve() const
+{
+	m_dirty = false;
+	const int n = m_playerCount;
+	if (n == 0)
+		return;
+
+	// Points scored by each player (in full points), plus the
+	// virtual draw against an opponent of strength 1
+	QVector<qreal> wins(n, 0.5);
+	for (int i = 0; i < n; i++)
+	{
+		for (int j = 0; j < n; j++)
+			wins[i] += m_points.at(i * n + j) / 2.0;
+	}
+
+	// Minorization-maximization iterations for the Bradley-Terry
+	// model, warm-started from the previous solution
+	for (int iter = 0; iter < s_maxIterations; iter++)
+	{
+		qreal maxChange = 0.0;
+		for (int i = 0; i < n; i++)
+		{
+			const qreal gamma = m_gammas.at(i);
+			qreal sum = 1.0 / (gamma + 1.0);
+			for (int j = 0; j < n; j++)
+			{
+				const int games = m_games.at(i * n + j);
+				if (games > 0)
+					sum += games / (gamma + m_gammas.at(j));
+			}
+
+			const qreal newGamma = wins.at(i) / sum;
+			maxChange = qMax(maxChange, std::fabs(std::log(newGamma / gamma)));
+			m_gammas[i] = newGamma;
+		}
+
+		if (maxChange < s_tolerance)
+			break;
+	}
+
+	qreal mean = 0.0;
+	for (int i = 0; i < n; i++)
+		mean += std::log(m_gammas.at(i));
+	mean /= n;
+
+	for (int i = 0; i < n; i++)
+	{
+		const qreal gamma = m_gammas.at(i);
+		m_ratings[i] = s_eloScale * (std::log(gamma) - mean);
+
+		// Fisher information of the player's log-strength
+		qreal info = gamma / ((gamma + 1.0) * (gamma + 1.0));
+		for (int j = 0; j < n; j++)
+		{
+			const int games = m_games.at(i * n + j);
+			if (games == 0)
+				continue;
+			const qreal p = gamma / (gamma + m_gammas.at(j));
+			info += games * p * (1.0 - p);
+		}
+		m_errorMargins[i] = 1.96 * s_eloScale / std::sqrt(info);
+	}
+}
@@ -0,0 +1,90 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RATINGMODEL_H
+#define RATINGMODEL_H
+
+#include <QVector>
+
+/*!
+ * \brief Maximum-likelihood Elo ratings of many players
+ *
+ * RatingModel keeps the results of every pair of players in a
+ * tournament and fits logistic Elo ratings to all of them at once,
+ * like BayesElo or Ordo do. Unlike the Elo class it takes the
+ * strength of each player's opponents into account.
+ *
+ * The ratings are solved lazily with minorization-maximization
+ * iterations, starting from the previous solution. A few new games
+ * barely move the ratings, so updating them after each game or each
+ * rating interval takes only a couple of iterations over the pair
+ * matrix.
+ *
+ * A virtual draw against an average opponent is added to every
+ * player's results, so players with no losses or no wins still get
+ * finite ratings.
+ */
+class LIB_EXPORT RatingModel
+{
+	public:
+		/*! Creates a new model for \a playerCount players. */
+		explicit RatingModel(int playerCount = 0);
+
+		/*! Returns the number of players. */
+		int playerCount() const;
+		/*!
+		 * Adds a game between players \a first and \a second
+		 * where \a first scored \a firstScore half points (0 for
+		 * a loss, 1 for a draw and 2 for a win).
+		 */
+		void addResult(int first, int second, int firstScore);
+		/*!
+		 * Returns the number of games played between players
+		 * \a first and \a second.
+		 */
+		int games(int first, int second) const;
+		/*!
+		 * Returns the number of half points that player \a first
+		 * scored against player \a second.
+		 */
+		int points(int first, int second) const;
+
+		/*!
+		 * Returns the rating of player \a index. The ratings are
+		 * relative to the average of all players.
+		 */
+		qreal rating(int index) const;
+		/*! Returns the 95% error margin of player \a index's rating. */
+		qreal errorMargin(int index) const;
+
+	private:
+		void solve() const;
+
+		int m_playerCount;
+		// Games and points (in half points) of every pair of players
+		QVector<int> m_games;
+		QVector<int> m_points;
+
+		// The solution, updated lazily
+		mutable bool m_dirty;
+		mutable QVector<qreal> m_gammas;
+		mutable QVector<qreal> m_ratings;
+		mutable QVector<qreal> m_errorMargins;
+};
+
+#endif // RATINGMODEL_H
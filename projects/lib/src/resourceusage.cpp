@@ -0,0 +1,268 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "resourceusage.h"
+
+#if defined(Q_OS_WIN32)
+  #define PSAPI_VERSION 2
+  #include <windows.h>
+  #include <psapi.h>
+#elif defined(Q_OS_LINUX)
+  #include <unistd.h>
+  #include <QDir>
+  #include <QFile>
+#elif defined(Q_OS_MACOS)
+  #include <libproc.h>
+  #include <mach/mach_time.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// Returns the value of \a key in a /proc status file, or -1
+qint64 statusValue(const QByteArray& status, const QByteArray& key)
+{
+	int pos = status.indexOf("\n" + key + ":");
+	if (pos == -1)
+		return -1;
+	pos += key.size() + 2;
+
+	const int end = status.indexOf('\n', pos);
+	bool ok = false;
+	qint64 value = status.mid(pos, end - pos).simplified()
+			     .split(' ').value(0).toLongLong(&ok);
+	return ok ? value : -1;
+}
+
+QByteArray readProcFile(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+	// The size of /proc files is unknown, so readAll() can't be used
+	return "\n" + file.read(16384);
+}
+#endif // Q_OS_LINUX
+
+#ifdef Q_OS_MACOS
+qint64 machToMicroseconds(quint64 t)
+{
+	static mach_timebase_info_data_t timebase = { 0, 0 };
+	if (timebase.denom == 0)
+		mach_timebase_info(&timebase);
+	return qint64(t * timebase.numer / timebase.denom / 1000);
+}
+#endif // Q_OS_MACOS
+
+} // anonymous namespace
+
+ResourceUsage::ResourceUsage()
+	: m_valid(false),
+	  m_userTime(0),
+	  m_systemTime(0),
+	  m_peakMemory(-1),
+	  m_contextSwitches(-1),
+	  m_involuntarySwitches(-1)
+{
+}
+
+bool ResourceUsage::isValid() const
+{
+	return m_valid;
+}
+
+qint64 ResourceUsage::userTime() const
+{
+	return m_userTime;
+}
+
+qint64 ResourceUsage::systemTime() const
+{
+	return m_systemTime;
+}
+
+qint64 ResourceUsage::cpuTime() const
+{
+	return m_userTime + m_systemTime;
+}
+
+qint64 ResourceUsage::peakMemory() const
+{
+	return m_peakMemory;
+}
+
+qint64 ResourceUsage::contextSwitches() const
+{
+	return m_contextSwitches;
+}
+
+qint64 ResourceUsage::involuntaryContextSwitches() const
+{
+	return m_involuntarySwitches;
+}
+
+ResourceUsage ResourceUsage::since(const ResourceUsage& start) const
+{
+	if (!m_valid || !start.m_valid)
+		return ResourceUsage();
+
+	ResourceUsage usage(*this);
+	usage.m_userTime -= start.m_userTime;
+	usage.m_systemTime -= start.m_systemTime;
+
+	// Threads that exit take their context switches with them
+	if (m_contextSwitches != -1 && start.m_contextSwitches != -1)
+		usage.m_contextSwitches = qMax(qint64(0),
+			m_contextSwitches - start.m_contextSwitches);
+	if (m_involuntarySwitches != -1 && start.m_involuntarySwitches != -1)
+		usage.m_involuntarySwitches = qMax(qint64(0),
+			m_involuntarySwitches - start.m_involuntarySwitches);
+
+	return usage;
+}
+
+void ResourceUsage::add(const ResourceUsage& other)
+{
+	if (!other.m_valid)
+		return;
+	if (!m_valid)
+	{
+		*this = other;
+		return;
+	}
+
+	m_userTime += other.m_userTime;
+	m_systemTime += other.m_systemTime;
+	m_peakMemory = qMax(m_peakMemory, other.m_peakMemory);
+	if (m_contextSwitches != -1 && other.m_contextSwitches != -1)
+		m_contextSwitches += other.m_contextSwitches;
+	if (m_involuntarySwitches != -1 && other.m_involuntarySwitches != -1)
+		m_involuntarySwitches += other.m_involuntarySwitches;
+}
+
+QString ResourceUsage::toString() const
+{
+	if (!m_valid)
+		return QString();
+
+	QString str = QString("user=%1s sys=%2s")
+		      .arg(m_userTime / 1.0e6, 0, 'f', 3)
+		      .arg(m_systemTime / 1.0e6, 0, 'f', 3);
+	if (m_peakMemory != -1)
+		str += QString(" maxrss=%1KiB").arg(m_peakMemory);
+	if (m_contextSwitches != -1)
+		str += QString(" csw=%1").arg(m_contextSwitches);
+	if (m_involuntarySwitches != -1)
+		str += QString(" icsw=%1").arg(m_involuntarySwitches);
+
+	return str;
+}
+
+ResourceUsage ResourceUsage::ofProcess(qint64 pid)
+{
+	ResourceUsage usage;
+	if (pid <= 0)
+		return usage;
+
+#if defined(Q_OS_LINUX)
+	const QString dir = QString("/proc/%1").arg(pid);
+
+	// The command name in parentheses may contain spaces
+	const QByteArray stat = readProcFile(dir + "/stat");
+	const int pos = stat.lastIndexOf(')');
+	if (pos == -1)
+		return usage;
+	const QList<QByteArray> fields = stat.mid(pos + 2).split(' ');
+	if (fields.size() < 13)
+		return usage;
+
+	static const qint64 ticks = sysconf(_SC_CLK_TCK);
+	usage.m_userTime = fields.at(11).toLongLong() * 1000000 / ticks;
+	usage.m_systemTime = fields.at(12).toLongLong() * 1000000 / ticks;
+	usage.m_peakMemory = statusValue(readProcFile(dir + "/status"), "VmHWM");
+
+	const auto tasks = QDir(dir + "/task").entryList(QDir::Dirs
+							 | QDir::NoDotAndDotDot);
+	qint64 voluntary = 0;
+	qint64 involuntary = 0;
+	for (const QString& task : tasks)
+	{
+		const QByteArray status = readProcFile(
+			dir + "/task/" + task + "/status");
+		voluntary += qMax(qint64(0),
+				  statusValue(status, "voluntary_ctxt_switches"));
+		involuntary += qMax(qint64(0),
+				    statusValue(status, "nonvoluntary_ctxt_switches"));
+	}
+	if (!tasks.isEmpty())
+	{
+		usage.m_contextSwitches = voluntary + involuntary;
+		usage.m_involuntarySwitches = involuntary;
+	}
+
+	usage.m_valid = true;
+#elif defined(Q_OS_WIN32)
+	HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION,
+				     FALSE, DWORD(pid));
+	if (process == NULL)
+		return usage;
+
+	FILETIME creationTime;
+	FILETIME exitTime;
+	FILETIME kernelTime;
+	FILETIME userTime;
+	if (GetProcessTimes(process, &creationTime, &exitTime,
+			    &kernelTime, &userTime))
+	{
+		// FILETIME is in 100 nanosecond units
+		auto toUsecs = [](const FILETIME& t)
+		{
+			return ((qint64(t.dwHighDateTime) << 32)
+				| t.dwLowDateTime) / 10;
+		};
+		usage.m_userTime = toUsecs(userTime);
+		usage.m_systemTime = toUsecs(kernelTime);
+		usage.m_valid = true;
+
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(process, &counters, sizeof(counters)))
+			usage.m_peakMemory = qint64(counters.PeakWorkingSetSize) / 1024;
+	}
+
+	CloseHandle(process);
+#elif defined(Q_OS_MACOS)
+	rusage_info_v4 info;
+	if (proc_pid_rusage(int(pid), RUSAGE_INFO_V4,
+			    reinterpret_cast<rusage_info_t*>(&info)) != 0)
+		return usage;
+
+	usage.m_userTime = machToMicroseconds(info.ri_user_time);
+	usage.m_systemTime = machToMicroseconds(info.ri_system_time);
+	usage.m_peakMemory = qint64(info.ri_lifetime_max_phys_footprint) / 1024;
+
+	proc_taskinfo taskInfo;
+	if (proc_pidinfo(int(pid), PROC_PIDTASKINFO, 0,
+			 &taskInfo, sizeof(taskInfo)) == sizeof(taskInfo))
+		usage.m_contextSwitches = taskInfo.pti_csw;
+
+	usage.m_valid = true;
+#endif
+
+	return usage;
+}
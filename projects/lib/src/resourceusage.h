@@ -0,0 +1,95 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef RESOURCEUSAGE_H
+#define RESOURCEUSAGE_H
+
+#include <QString>
+
+/*!
+ * \brief Operating system resource usage of a process
+ *
+ * ResourceUsage is a snapshot of a process' CPU time, peak memory
+ * usage and context switches. The difference of two snapshots of the
+ * same process, eg. at the start and end of a game, is the usage
+ * during that time.
+ *
+ * Values that the platform doesn't provide are -1.
+ */
+class LIB_EXPORT ResourceUsage
+{
+	public:
+		/*! Creates a new invalid ResourceUsage object. */
+		ResourceUsage();
+
+		/*! Returns true if the usage was successfully sampled. */
+		bool isValid() const;
+		/*! Returns the user mode CPU time in microseconds. */
+		qint64 userTime() const;
+		/*! Returns the kernel mode CPU time in microseconds. */
+		qint64 systemTime() const;
+		/*! Returns the total CPU time in microseconds. */
+		qint64 cpuTime() const;
+		/*! Returns the peak resident set size in kibibytes. */
+		qint64 peakMemory() const;
+		/*! Returns the number of context switches. */
+		qint64 contextSwitches() const;
+		/*!
+		 * Returns the number of involuntary context switches,
+		 * ie. the times the process was preempted.
+		 */
+		qint64 involuntaryContextSwitches() const;
+
+		/*!
+		 * Returns the usage between \a start and this snapshot.
+		 *
+		 * The peak memory usage is the process' lifetime peak
+		 * at the time of this snapshot.
+		 */
+		ResourceUsage since(const ResourceUsage& start) const;
+		/*!
+		 * Adds the CPU time and context switches of \a other to
+		 * this object and keeps the larger peak memory usage.
+		 */
+		void add(const ResourceUsage& other);
+
+		/*!
+		 * Returns the usage as a string of space separated
+		 * key=value pairs, eg. for a PGN tag.
+		 */
+		QString toString() const;
+
+		/*!
+		 * Returns the current resource usage of process \a pid.
+		 *
+		 * On Linux the context switches are counted for the
+		 * threads that are still running.
+		 */
+		static ResourceUsage ofProcess(qint64 pid);
+
+	private:
+		bool m_valid;
+		qint64 m_userTime;
+		qint64 m_systemTime;
+		qint64 m_peakMemory;
+		qint64 m_contextSwitches;
+		qint64 m_involuntarySwitches;
+};
+
+#endif // RESOURCEUSAGE_H
@@ -0,0 +1,128 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "resultaggregator.h"
+#include "board/result.h"
+
+namespace {
+
+QAtomicInt s_nextShard;
+
+int currentShard(int shardCount)
+{
+	// Each thread picks its shard once
+	thread_local int shard = -1;
+	if (shard == -1)
+		shard = s_nextShard.fetchAndAddRelaxed(1) % shardCount;
+	return shard;
+}
+
+} // anonymous namespace
+
+ResultAggregator::ResultAggregator(int playerCount)
+	: m_playerCount(playerCount),
+	  m_shardSize(0),
+	  m_counters(nullptr)
+{
+	Q_ASSERT(playerCount >= 0);
+
+	// The counters of the players, and the game count at the end.
+	// Shards are padded to 64-byte cache lines.
+	const int perLine = int(64 / sizeof(QAtomicInt));
+	const int size = playerCount * CounterCount + 1;
+	m_shardSize = (size + perLine - 1) / perLine * perLine;
+	m_counters = new QAtomicInt[ShardCount * m_shardSize];
+}
+
+ResultAggregator::~ResultAggregator()
+{
+	delete[] m_counters;
+}
+
+int ResultAggregator::playerCount() const
+{
+	return m_playerCount;
+}
+
+QAtomicInt& ResultAggregator::counter(int shard, int index)
+{
+	return m_counters[shard * m_shardSize + index];
+}
+
+int ResultAggregator::total(int index) const
+{
+	int sum = 0;
+	for (int i = 0; i < ShardCount; i++)
+		sum += m_counters[i * m_shardSize + index].loadAcquire();
+	return sum;
+}
+
+void ResultAggregator::addResult(int whiteIndex,
+				 int blackIndex,
+				 const Chess::Result& result)
+{
+	Q_ASSERT(whiteIndex >= 0 && whiteIndex < m_playerCount);
+	Q_ASSERT(blackIndex >= 0 && blackIndex < m_playerCount);
+
+	Counter white;
+	Counter black;
+	if (result.winner() == Chess::Side::White)
+	{
+		white = Wins;
+		black = Losses;
+	}
+	else if (result.winner() == Chess::Side::Black)
+	{
+		white = Losses;
+		black = Wins;
+	}
+	else if (result.isDraw())
+		white = black = Draws;
+	else
+		return;
+
+	const int shard = currentShard(ShardCount);
+	counter(shard, whiteIndex * CounterCount + white).fetchAndAddRelease(1);
+	counter(shard, blackIndex * CounterCount + black).fetchAndAddRelease(1);
+	counter(shard, m_playerCount * CounterCount).fetchAndAddRelease(1);
+}
+
+int ResultAggregator::gameCount() const
+{
+	return total(m_playerCount * CounterCount);
+}
+
+ResultAggregator::Score ResultAggregator::score(int index) const
+{
+	Q_ASSERT(index >= 0 && index < m_playerCount);
+
+	Score score;
+	score.wins = total(index * CounterCount + Wins);
+	score.draws = total(index * CounterCount + Draws);
+	score.losses = total(index * CounterCount + Losses);
+	return score;
+}
+
+QVector<ResultAggregator::Score> ResultAggregator::scores() const
+{
+	QVector<Score> scores;
+	scores.reserve(m_playerCount);
+	for (int i = 0; i < m_playerCount; i++)
+		scores.append(score(i));
+	return scores;
+}
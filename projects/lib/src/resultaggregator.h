@@ -0,0 +1,96 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RESULTAGGREGATOR_H
+#define RESULTAGGREGATOR_H
+
+#include <QVector>
+#include <QAtomicInt>
+namespace Chess { class Result; }
+
+/*!
+ * \brief Lock-free game result counters shared by many threads
+ *
+ * ResultAggregator counts the wins, draws and losses of each player of
+ * a tournament. Game threads add their results without locking. Every
+ * thread writes to a shard of its own (shards are shared round-robin
+ * when there are more threads than shards), so the threads don't
+ * fight over the same cache lines. Reading the totals merges the
+ * shards, and can be done from any thread at any time.
+ *
+ * The totals are a snapshot: results added at the same time by other
+ * threads may or may not be included.
+ */
+class LIB_EXPORT ResultAggregator
+{
+	public:
+		/*! The results of one player. */
+		struct Score
+		{
+			int wins;	//!< Number of wins
+			int draws;	//!< Number of draws
+			int losses;	//!< Number of losses
+		};
+
+		/*! Creates a new aggregator for \a playerCount players. */
+		explicit ResultAggregator(int playerCount);
+		/*! Destroys the aggregator. */
+		~ResultAggregator();
+
+		/*! Returns the number of players. */
+		int playerCount() const;
+
+		/*!
+		 * Adds the result of a game between players \a whiteIndex
+		 * and \a blackIndex. Games with no result are ignored.
+		 *
+		 * This function is thread-safe and lock-free.
+		 */
+		void addResult(int whiteIndex,
+			       int blackIndex,
+			       const Chess::Result& result);
+
+		/*! Returns the number of games added. */
+		int gameCount() const;
+		/*! Returns the current results of player \a index. */
+		Score score(int index) const;
+		/*! Returns the current results of all players. */
+		QVector<Score> scores() const;
+
+	private:
+		enum Counter
+		{
+			Wins,
+			Draws,
+			Losses,
+			CounterCount
+		};
+
+		static const int ShardCount = 16;
+
+		QAtomicInt& counter(int shard, int index);
+		int total(int index) const;
+
+		Q_DISABLE_COPY(ResultAggregator)
+
+		int m_playerCount;
+		int m_shardSize;
+		QAtomicInt* m_counters;
+};
+
+#endif // RESULTAGGREGATOR_H
@@ -32,6 +32,11 @@ QString RoundRobinTournament::type() const
 	return "round-robin";
 }
 
+bool RoundRobinTournament::canReorderGames() const
+{
+	return true;
+}
+
 void RoundRobinTournament::initializePairing()
 {
 	m_pairNumber = 0;
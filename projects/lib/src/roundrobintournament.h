@@ -38,6 +38,7 @@ class LIB_EXPORT RoundRobinTournament : public Tournament
 					      QObject *parent = nullptr);
 		// Inherited from Tournament
 		virtual QString type() const;
+		virtual bool canReorderGames() const;
 
 	protected:
 		// Inherited from Tournament
@@ -18,11 +18,30 @@
 
 #include "sprt.h"
 #include <cmath>
+#include <algorithm>
 #include <QtGlobal>
 
 class BayesElo;
 class SprtProbability;
 
+namespace {
+
+// Normalized Elo per standard deviation of the score
+const double s_normalizedEloScale = 800.0 / std::log(10.0);
+
+double logisticScore(double elo)
+{
+	return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double logisticElo(double score)
+{
+	score = qBound(1e-6, score, 1.0 - 1e-6);
+	return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+} // anonymous namespace
+
 class BayesElo
 {
 	public:
@@ -137,8 +156,12 @@ Sprt::Sprt()
 	  m_beta(0),
 	  m_wins(0),
 	  m_losses(0),
-	  m_draws(0)
+	  m_draws(0),
+	  m_model(Trinomial),
+	  m_eloScale(LogisticScale),
+	  m_drawElo(0)
 {
+	std::fill(m_pairs, m_pairs + 5, 0);
 }
 
 bool Sprt::isNull() const
@@ -147,15 +170,43 @@ bool Sprt::isNull() const
 }
 
 void Sprt::initialize(double elo0, double elo1,
-		      double alpha, double beta)
+		      double alpha, double beta,
+		      Model model,
+		      EloScale eloScale,
+		      double drawElo)
 {
 	m_elo0 = elo0;
 	m_elo1 = elo1;
 	m_alpha = alpha;
 	m_beta = beta;
+	m_model = model;
+	m_eloScale = eloScale;
+	m_drawElo = drawElo;
+}
+
+Sprt::Model Sprt::model() const
+{
+	return m_model;
+}
+
+Sprt::EloScale Sprt::eloScale() const
+{
+	return m_eloScale;
+}
+
+double Sprt::drawElo() const
+{
+	return m_drawElo;
 }
 
 Sprt::Status Sprt::status() const
+{
+	if (m_model == Pentanomial)
+		return pentanomialStatus();
+	return status(m_wins, m_losses, m_draws);
+}
+
+Sprt::Status Sprt::status(int wins, int losses, int draws) const
 {
 	Status status = {
 		Continue,
@@ -164,23 +215,118 @@ Sprt::Status Sprt::status() const
 		0.0
 	};
 
-	if (m_wins <= 0 || m_losses <= 0 || m_draws <= 0)
+	if (wins <= 0 || losses <= 0 || draws <= 0)
 		return status;
 
 	// Estimate draw_elo out of sample
-	const SprtProbability p(m_wins, m_losses, m_draws);
-	const BayesElo b(p);
+	const SprtProbability p(wins, losses, draws);
+	const double drawElo = m_drawElo > 0.0 ? m_drawElo : BayesElo(p).drawElo();
+
+	// Standard deviation of a game's score
+	const double mean = p.pWin() + p.pDraw() / 2.0;
+	const double sigma = std::sqrt(p.pWin() * (1.0 - mean) * (1.0 - mean) +
+				       p.pDraw() * (0.5 - mean) * (0.5 - mean) +
+				       p.pLoss() * mean * mean);
 
 	// Probability laws under H0 and H1
-	const double s = b.scale();
-	const BayesElo b0(m_elo0 / s, b.drawElo());
-	const BayesElo b1(m_elo1 / s, b.drawElo());
+	const BayesElo b0(bayesElo(m_elo0, drawElo, sigma), drawElo);
+	const BayesElo b1(bayesElo(m_elo1, drawElo, sigma), drawElo);
 	const SprtProbability p0(b0), p1(b1);
 
 	// Log-Likelyhood Ratio
-	status.llr = m_wins * std::log(p1.pWin() / p0.pWin()) +
-		     m_losses * std::log(p1.pLoss() / p0.pLoss()) +
-		     m_draws * std::log(p1.pDraw() / p0.pDraw());
+	return llrStatus(wins * std::log(p1.pWin() / p0.pWin()) +
+			 losses * std::log(p1.pLoss() / p0.pLoss()) +
+			 draws * std::log(p1.pDraw() / p0.pDraw()));
+}
+
+Sprt::Status Sprt::pentanomialStatus() const
+{
+	Status status = {
+		Continue,
+		0.0,
+		0.0,
+		0.0
+	};
+
+	// Mean and variance of the pair scores, scaled to [0, 1]
+	int count = 0;
+	double mean = 0.0;
+	for (int i = 0; i < 5; i++)
+	{
+		count += m_pairs[i];
+		mean += m_pairs[i] * i / 4.0;
+	}
+	if (count < 2)
+		return status;
+	mean /= count;
+
+	double variance = 0.0;
+	for (int i = 0; i < 5; i++)
+	{
+		const double d = i / 4.0 - mean;
+		variance += m_pairs[i] * d * d;
+	}
+	variance /= count;
+	if (variance <= 0.0)
+		return status;
+
+	// The draw_elo is needed only for BayesElo bounds
+	double drawElo = m_drawElo;
+	if (m_eloScale == BayesScale && drawElo <= 0.0)
+	{
+		if (m_wins <= 0 || m_losses <= 0 || m_draws <= 0)
+			return status;
+		drawElo = BayesElo(SprtProbability(m_wins, m_losses, m_draws)).drawElo();
+	}
+
+	// Expected scores under H0 and H1. The standard deviation of
+	// a game's score is sqrt(2) times that of a pair's mean score.
+	const double sigma = std::sqrt(2.0 * variance);
+	const double s0 = expectedScore(m_elo0, drawElo, sigma);
+	const double s1 = expectedScore(m_elo1, drawElo, sigma);
+
+	// Generalized SPRT: normal approximation of the Log-Likelyhood Ratio
+	return llrStatus(count * (s1 - s0) * (2.0 * mean - s0 - s1)
+			 / (2.0 * variance));
+}
+
+double Sprt::bayesElo(double elo, double drawElo, double sigma) const
+{
+	switch (m_eloScale)
+	{
+	case BayesScale:
+		return elo;
+	case NormalizedScale:
+		elo = logisticElo(0.5 + elo / s_normalizedEloScale * sigma);
+		break;
+	default:
+		break;
+	}
+
+	return elo / BayesElo(0.0, drawElo).scale();
+}
+
+double Sprt::expectedScore(double elo, double drawElo, double sigma) const
+{
+	switch (m_eloScale)
+	{
+	case BayesScale:
+	{
+		const SprtProbability p(BayesElo(elo, drawElo));
+		return p.pWin() + p.pDraw() / 2.0;
+	}
+	case NormalizedScale:
+		return 0.5 + elo / s_normalizedEloScale * sigma;
+	default:
+		return logisticScore(elo);
+	}
+}
+
+Sprt::Status Sprt::llrStatus(double llr) const
+{
+	Status status;
+	status.result = Continue;
+	status.llr = llr;
 
 	// Bounds based on error levels of the test
 	status.lBound = std::log(m_beta / (1.0 - m_alpha));
@@ -203,3 +349,20 @@ void Sprt::addGameResult(GameResult result)
 	else if (result == Loss)
 		m_losses++;
 }
+
+void Sprt::addGamePairResult(GameResult first, GameResult second)
+{
+	if (first == NoResult || second == NoResult)
+		return;
+
+	// Score of the pair in half points
+	int score = 0;
+	for (GameResult result : {first, second})
+	{
+		if (result == Win)
+			score += 2;
+		else if (result == Draw)
+			score += 1;
+	}
+	m_pairs[score]++;
+}
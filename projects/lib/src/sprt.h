@@ -27,6 +27,12 @@
  * players when the Elo difference is known to be outside of the specified
  * interval.
  *
+ * The test can model the results either as independent games (the
+ * trinomial model) or as pairs of games played with the same opening
+ * and reversed colors (the pentanomial model). The games of a pair are
+ * strongly correlated, and the pentanomial model takes that into
+ * account, so it usually needs fewer games to reach a decision.
+ *
  * \sa http://en.wikipedia.org/wiki/Sequential_probability_ratio_test
  */
 class LIB_EXPORT Sprt
@@ -40,6 +46,29 @@ class LIB_EXPORT Sprt
 			AcceptH1	//!< Accept alternative hypothesis H1
 		};
 
+		/*! The statistical model of the game results. */
+		enum Model
+		{
+			Trinomial,	//!< Independent wins, losses and draws
+			Pentanomial	//!< Scores of game pairs
+		};
+
+		/*! The scale of the Elo bounds. */
+		enum EloScale
+		{
+			/*! Logistic Elo, ie. the usual Elo rating scale. */
+			LogisticScale,
+			/*!
+			 * Normalized Elo, which is relative to the standard
+			 * deviation of the game scores. The bounds adapt to
+			 * the observed draw ratio, so a test costs about the
+			 * same number of games at any time control.
+			 */
+			NormalizedScale,
+			/*! BayesElo, which doesn't depend on the draw ratio. */
+			BayesScale
+		};
+
 		/*! The result of a chess game. */
 		enum GameResult
 		{
@@ -75,11 +104,43 @@ class LIB_EXPORT Sprt
 		 *
 		 * \a alpha is the maximum probability for a type I error and
 		 * \a beta for a type II error outside interval [elo0, elo1].
+		 *
+		 * \a model is the statistical model of the results. With
+		 * the Pentanomial model the test is updated with
+		 * addGamePairResult().
+		 *
+		 * \a eloScale is the scale of \a elo0 and \a elo1.
+		 * Converting between the scales needs the draw_elo of the
+		 * players: \a drawElo is used if it's positive; otherwise
+		 * the draw_elo is estimated from the game results every
+		 * time the status is checked.
 		 */
 		void initialize(double elo0, double elo1,
-				double alpha, double beta);
+				double alpha, double beta,
+				Model model = Trinomial,
+				EloScale eloScale = LogisticScale,
+				double drawElo = 0.0);
+		/*! Returns the statistical model of the test. */
+		Model model() const;
+		/*! Returns the scale of the Elo bounds. */
+		EloScale eloScale() const;
+		/*!
+		 * Returns the fixed draw_elo, or 0 if the draw_elo is
+		 * estimated from the game results.
+		 */
+		double drawElo() const;
 		/*! Returns the current status of the test. */
 		Status status() const;
+		/*!
+		 * Returns the status of the test for \a wins, \a losses
+		 * and \a draws of the first player instead of the results
+		 * added with addGameResult(). The trinomial model is used
+		 * regardless of model().
+		 *
+		 * This function doesn't change the object, so it can be
+		 * called from many threads at the same time.
+		 */
+		Status status(int wins, int losses, int draws) const;
 		/*!
 		 * Updates the test with \a result.
 		 *
@@ -87,8 +148,21 @@ class LIB_EXPORT Sprt
 		 * check if H0 or H1 can be accepted.
 		 */
 		void addGameResult(GameResult result);
+		/*!
+		 * Updates the pentanomial test with the results \a first
+		 * and \a second of a game pair.
+		 *
+		 * After calling this function, status() should be called to
+		 * check if H0 or H1 can be accepted.
+		 */
+		void addGamePairResult(GameResult first, GameResult second);
 
 	private:
+		Status pentanomialStatus() const;
+		Status llrStatus(double llr) const;
+		double bayesElo(double elo, double drawElo, double sigma) const;
+		double expectedScore(double elo, double drawElo, double sigma) const;
+
 		double m_elo0;
 		double m_elo1;
 		double m_alpha;
@@ -96,6 +170,10 @@ class LIB_EXPORT Sprt
 		int m_wins;
 		int m_losses;
 		int m_draws;
+		Model m_model;
+		int m_pairs[5];
+		EloScale m_eloScale;
+		double m_drawElo;
 };
 
 #endif // SPRT_H
@@ -0,0 +1,231 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sprtsimulator.h"
+#include <cmath>
+#include <algorithm>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include "randomstream.h"
+
+namespace {
+
+double uniform(RandomStream* stream)
+{
+	return stream->next() / 4294967296.0;
+}
+
+Sprt::GameResult randomResult(double elo,
+			      double drawRatio,
+			      RandomStream* stream)
+{
+	const double score = 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+	// The draws can't outnumber twice the weaker side's score
+	const double draws = qMin(drawRatio, 2.0 * qMin(score, 1.0 - score));
+
+	const double x = uniform(stream);
+	if (x < score - draws / 2.0)
+		return Sprt::Win;
+	if (x < score + draws / 2.0)
+		return Sprt::Draw;
+	return Sprt::Loss;
+}
+
+/*! Takes runs from a shared counter until all of them are done. */
+class SimulationTask : public QRunnable
+{
+	public:
+		struct Setup
+		{
+			Sprt sprt;
+			int runCount;
+			int maxGames;
+			double pairBias;
+			quint64 seed;
+			double elo;
+			double drawRatio;
+		};
+
+		SimulationTask(const Setup& setup,
+			       QAtomicInt* nextRun,
+			       int* games,
+			       Sprt::Result* results)
+			: m_setup(setup),
+			  m_nextRun(nextRun),
+			  m_games(games),
+			  m_results(results)
+		{
+		}
+
+		// Inherited from QRunnable
+		virtual void run()
+		{
+			for (;;)
+			{
+				const int i = m_nextRun->fetchAndAddRelaxed(1);
+				if (i >= m_setup.runCount)
+					break;
+				m_results[i] = simulate(i, &m_games[i]);
+			}
+		}
+
+	private:
+		bool canContinue(int games) const
+		{
+			return m_setup.maxGames <= 0 || games < m_setup.maxGames;
+		}
+
+		Sprt::Result simulate(int index, int* games) const
+		{
+			RandomStream stream(m_setup.seed, quint64(index));
+			Sprt sprt(m_setup.sprt);
+			Sprt::Result result = Sprt::Continue;
+			*games = 0;
+
+			while (result == Sprt::Continue && canContinue(*games))
+			{
+				// The opening favors the first player in one game
+				// of the pair and the opponent in the other
+				const double bias = m_setup.pairBias * uniform(&stream);
+				const Sprt::GameResult first = randomResult(
+					m_setup.elo + bias, m_setup.drawRatio, &stream);
+				const Sprt::GameResult second = randomResult(
+					m_setup.elo - bias, m_setup.drawRatio, &stream);
+
+				// A match adds the games to both models, and the
+				// pentanomial BayesElo bounds need the game counts
+				if (sprt.model() == Sprt::Pentanomial)
+				{
+					sprt.addGameResult(first);
+					sprt.addGameResult(second);
+					sprt.addGamePairResult(first, second);
+					*games += 2;
+					result = sprt.status().result;
+					continue;
+				}
+
+				sprt.addGameResult(first);
+				++*games;
+				result = sprt.status().result;
+				if (result != Sprt::Continue || !canContinue(*games))
+					break;
+
+				sprt.addGameResult(second);
+				++*games;
+				result = sprt.status().result;
+			}
+
+			return result;
+		}
+
+		Setup m_setup;
+		QAtomicInt* m_nextRun;
+		int* m_games;
+		Sprt::Result* m_results;
+};
+
+} // anonymous namespace
+
+int SprtSimulator::Summary::percentile(double percent) const
+{
+	if (games.isEmpty())
+		return 0;
+
+	const int index = qBound(0, int(std::ceil(percent / 100.0 * games.size())) - 1,
+				 games.size() - 1);
+	return games.at(index);
+}
+
+SprtSimulator::SprtSimulator(const Sprt& sprt)
+	: m_sprt(sprt),
+	  m_runCount(1000),
+	  m_maxGames(0),
+	  m_pairBias(0.0),
+	  m_threadCount(QThread::idealThreadCount()),
+	  m_seed(0)
+{
+	Q_ASSERT(!sprt.isNull());
+}
+
+void SprtSimulator::setRunCount(int count)
+{
+	m_runCount = qMax(1, count);
+}
+
+void SprtSimulator::setMaxGames(int games)
+{
+	m_maxGames = qMax(0, games);
+}
+
+void SprtSimulator::setPairBias(double elo)
+{
+	m_pairBias = qMax(0.0, elo);
+}
+
+void SprtSimulator::setThreadCount(int count)
+{
+	m_threadCount = qMax(1, count);
+}
+
+void SprtSimulator::setSeed(quint64 seed)
+{
+	m_seed = seed;
+}
+
+SprtSimulator::Summary SprtSimulator::run(double elo, double drawRatio) const
+{
+	QVector<int> games(m_runCount, 0);
+	QVector<Sprt::Result> results(m_runCount, Sprt::Continue);
+
+	const SimulationTask::Setup setup = {
+		m_sprt, m_runCount, m_maxGames, m_pairBias, m_seed,
+		elo, qBound(0.0, drawRatio, 1.0)
+	};
+	QThreadPool pool;
+	pool.setMaxThreadCount(m_threadCount);
+	QAtomicInt nextRun(0);
+	const int taskCount = qMin(m_threadCount, m_runCount);
+	for (int i = 0; i < taskCount; i++)
+		pool.start(new SimulationTask(setup, &nextRun,
+					      games.data(), results.data()));
+	pool.waitForDone();
+
+	Summary summary;
+	summary.runs = m_runCount;
+	summary.h0 = 0;
+	summary.h1 = 0;
+	summary.truncated = 0;
+	qint64 total = 0;
+	for (int i = 0; i < m_runCount; i++)
+	{
+		if (results.at(i) == Sprt::AcceptH0)
+			summary.h0++;
+		else if (results.at(i) == Sprt::AcceptH1)
+			summary.h1++;
+		else
+			summary.truncated++;
+		total += games.at(i);
+	}
+	summary.meanGames = double(total) / m_runCount;
+
+	std::sort(games.begin(), games.end());
+	summary.games = games;
+	return summary;
+}
@@ -0,0 +1,112 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SPRTSIMULATOR_H
+#define SPRTSIMULATOR_H
+
+#include <QVector>
+#include "sprt.h"
+
+/*!
+ * \brief A Monte Carlo simulator of SPRT runs
+ *
+ * SprtSimulator plays many SPRT runs with random game results to
+ * estimate how often a test accepts each hypothesis and how many games
+ * it takes under an assumed true Elo difference and draw ratio. Every
+ * run feeds a copy of the same Sprt object, so the simulation uses the
+ * exact test of a match, including its model and Elo scale.
+ *
+ * The games are played in pairs with reversed colors. Each pair can
+ * get a random opening bias that favors the first player in one game
+ * and the opponent in the other, which makes the two games of a pair
+ * correlated like in real matches with balanced openings.
+ *
+ * The runs are split between a pool of worker threads. Each run draws
+ * from its own RandomStream, so the results don't depend on the number
+ * of threads.
+ */
+class LIB_EXPORT SprtSimulator
+{
+	public:
+		/*! The outcome of the simulated runs. */
+		struct Summary
+		{
+			/*! The number of runs. */
+			int runs;
+			/*! The number of runs that accepted H0. */
+			int h0;
+			/*! The number of runs that accepted H1. */
+			int h1;
+			/*! The number of runs stopped by the game limit. */
+			int truncated;
+			/*! The mean number of games per run. */
+			double meanGames;
+			/*!
+			 * The number of games of every run, in ascending
+			 * order. Used for the percentiles of the stopping time.
+			 */
+			QVector<int> games;
+
+			/*!
+			 * Returns the number of games that \a percent percent
+			 * of the runs needed at most.
+			 */
+			int percentile(double percent) const;
+		};
+
+		/*! Creates a simulator of \a sprt, which must be initialized. */
+		explicit SprtSimulator(const Sprt& sprt);
+
+		/*! Sets the number of runs to \a count. The default is 1000. */
+		void setRunCount(int count);
+		/*!
+		 * Stops a run after \a games games if the test hasn't
+		 * ended. The default is 0, which means no limit.
+		 */
+		void setMaxGames(int games);
+		/*!
+		 * Sets the largest opening bias of a game pair to \a elo.
+		 * The bias of each pair is uniformly distributed between
+		 * 0 and \a elo. The default is 0.
+		 */
+		void setPairBias(double elo);
+		/*!
+		 * Sets the number of worker threads to \a count.
+		 * The default is the number of CPU cores.
+		 */
+		void setThreadCount(int count);
+		/*! Sets the seed of the random results to \a seed. */
+		void setSeed(quint64 seed);
+
+		/*!
+		 * Simulates the runs between players whose true logistic
+		 * Elo difference is \a elo and whose games are drawn with
+		 * probability \a drawRatio.
+		 */
+		Summary run(double elo, double drawRatio) const;
+
+	private:
+		Sprt m_sprt;
+		int m_runCount;
+		int m_maxGames;
+		double m_pairBias;
+		int m_threadCount;
+		quint64 m_seed;
+};
+
+#endif // SPRTSIMULATOR_H
@@ -5,14 +5,32 @@ HEADERS += $$PWD/chessengine.h \
     $$PWD/chessgame.h \
     $$PWD/chessplayer.h \
     $$PWD/engineconfiguration.h \
+    $$PWD/enginestamp.h \
     $$PWD/openingbook.h \
+    $$PWD/bookprobecache.h \
     $$PWD/pgnstream.h \
+    $$PWD/pgnchunkreader.h \
     $$PWD/pgngame.h \
+    $$PWD/compactpgngame.h \
+    $$PWD/pgnwriter.h \
+    $$PWD/compressedfile.h \
+    $$PWD/compactgamewriter.h \
+    $$PWD/trainingdatawriter.h \
+    $$PWD/compactgamereader.h \
     $$PWD/polyglotbook.h \
+    $$PWD/polyglotbookbuilder.h \
+    $$PWD/epdextractor.h \
+    $$PWD/perft.h \
+    $$PWD/positionbatch.h \
+    $$PWD/positionapi.h \
+    $$PWD/headlessrunner.h \
+    $$PWD/mockengine.h \
+    $$PWD/streamdevice.h \
     $$PWD/timecontrol.h \
     $$PWD/uciengine.h \
     $$PWD/xboardengine.h \
     $$PWD/moveevaluation.h \
+    $$PWD/moveevent.h \
     $$PWD/enginemanager.h \
     $$PWD/humanplayer.h \
     $$PWD/engineoption.h \
@@ -22,42 +40,98 @@ HEADERS += $$PWD/chessengine.h \
     $$PWD/enginetextoption.h \
     $$PWD/enginebuttonoption.h \
     $$PWD/pgngameentry.h \
+    $$PWD/pgngameentryindex.h \
+    $$PWD/pgntagtable.h \
+    $$PWD/positionindex.h \
+    $$PWD/positionindexwriter.h \
     $$PWD/gamemanager.h \
+    $$PWD/gamesink.h \
+    $$PWD/gamesinks.h \
     $$PWD/playerbuilder.h \
     $$PWD/enginebuilder.h \
+    $$PWD/enginelibrary.h \
+    $$PWD/enginesocket.h \
+    $$PWD/enginerelay.h \
+    $$PWD/livegamefeed.h \
+    $$PWD/livegameclient.h \
+    $$PWD/engineapi.h \
     $$PWD/classregistry.h \
     $$PWD/enginefactory.h \
     $$PWD/humanbuilder.h \
     $$PWD/engineoptionfactory.h \
     $$PWD/pgngamefilter.h \
+    $$PWD/pgnextractor.h \
+    $$PWD/pgnmerger.h \
+    $$PWD/pgnverifier.h \
     $$PWD/tournament.h \
     $$PWD/roundrobintournament.h \
     $$PWD/tournamentfactory.h \
     $$PWD/gauntlettournament.h \
     $$PWD/epdrecord.h \
+    $$PWD/epdtest.h \
+    $$PWD/positionsearcher.h \
+    $$PWD/positionanalyzer.h \
+    $$PWD/enginebenchmark.h \
     $$PWD/openingsuite.h \
+    $$PWD/openingindex.h \
+    $$PWD/memoryaccount.h \
+    $$PWD/tracelog.h \
+    $$PWD/openingpool.h \
+    $$PWD/outputqueue.h \
     $$PWD/econode.h \
     $$PWD/mersenne.h \
+    $$PWD/randomstream.h \
     $$PWD/sprt.h \
+    $$PWD/sprtsimulator.h \
+    $$PWD/resultaggregator.h \
     $$PWD/gameadjudicator.h \
+    $$PWD/adjudicationreplay.h \
     $$PWD/elo.h \
+    $$PWD/ratingmodel.h \
+    $$PWD/latencyhistogram.h \
+    $$PWD/adaptivemargin.h \
+    $$PWD/timerwheel.h \
+    $$PWD/cpuallocator.h \
+    $$PWD/resourceusage.h \
+    $$PWD/loadmonitor.h \
     $$PWD/knockouttournament.h \
     $$PWD/pyramidtournament.h \
+    $$PWD/swisstournament.h \
+    $$PWD/adaptivetournament.h \
     $$PWD/tournamentplayer.h \
     $$PWD/tournamentpair.h \
-    $$PWD/worker.h
+    $$PWD/worker.h \
+    $$PWD/cancellationtoken.h
 SOURCES += $$PWD/chessengine.cpp \
     $$PWD/chessgame.cpp \
     $$PWD/chessplayer.cpp \
     $$PWD/engineconfiguration.cpp \
+    $$PWD/enginestamp.cpp \
     $$PWD/openingbook.cpp \
+    $$PWD/bookprobecache.cpp \
     $$PWD/pgnstream.cpp \
+    $$PWD/pgnchunkreader.cpp \
     $$PWD/pgngame.cpp \
+    $$PWD/compactpgngame.cpp \
+    $$PWD/pgnwriter.cpp \
+    $$PWD/compressedfile.cpp \
+    $$PWD/compactgamewriter.cpp \
+    $$PWD/trainingdatawriter.cpp \
+    $$PWD/compactgamereader.cpp \
     $$PWD/polyglotbook.cpp \
+    $$PWD/polyglotbookbuilder.cpp \
+    $$PWD/epdextractor.cpp \
+    $$PWD/perft.cpp \
+    $$PWD/positionbatch.cpp \
+    $$PWD/positionapi.cpp \
+    $$PWD/headlessrunner.cpp \
+    $$PWD/mockengine.cpp \
+    $$PWD/streamdevice.cpp \
     $$PWD/timecontrol.cpp \
     $$PWD/uciengine.cpp \
     $$PWD/xboardengine.cpp \
     $$PWD/moveevaluation.cpp \
+    $$PWD/moveevent.cpp \
     $$PWD/enginemanager.cpp \
     $$PWD/humanplayer.cpp \
     $$PWD/engineoption.cpp \
@@ -67,32 +141,75 @@ SOURCES += $$PWD/chessengine.cpp \
     $$PWD/enginetextoption.cpp \
     $$PWD/enginebuttonoption.cpp \
     $$PWD/pgngameentry.cpp \
+    $$PWD/pgngameentryindex.cpp \
+    $$PWD/pgntagtable.cpp \
+    $$PWD/positionindex.cpp \
+    $$PWD/positionindexwriter.cpp \
     $$PWD/gamemanager.cpp \
+    $$PWD/gamesink.cpp \
+    $$PWD/gamesinks.cpp \
     $$PWD/playerbuilder.cpp \
     $$PWD/enginebuilder.cpp \
+    $$PWD/enginelibrary.cpp \
+    $$PWD/enginesocket.cpp \
+    $$PWD/enginerelay.cpp \
+    $$PWD/livegamefeed.cpp \
+    $$PWD/livegameclient.cpp \
     $$PWD/enginefactory.cpp \
     $$PWD/humanbuilder.cpp \
     $$PWD/engineoptionfactory.cpp \
     $$PWD/pgngamefilter.cpp \
+    $$PWD/pgnextractor.cpp \
+    $$PWD/pgnmerger.cpp \
+    $$PWD/pgnverifier.cpp \
     $$PWD/tournament.cpp \
     $$PWD/roundrobintournament.cpp \
     $$PWD/tournamentfactory.cpp \
     $$PWD/gauntlettournament.cpp \
     $$PWD/epdrecord.cpp \
+    $$PWD/epdtest.cpp \
+    $$PWD/positionsearcher.cpp \
+    $$PWD/positionanalyzer.cpp \
+    $$PWD/enginebenchmark.cpp \
     $$PWD/openingsuite.cpp \
+    $$PWD/openingindex.cpp \
+    $$PWD/memoryaccount.cpp \
+    $$PWD/tracelog.cpp \
+    $$PWD/openingpool.cpp \
+    $$PWD/outputqueue.cpp \
     $$PWD/econode.cpp \
     $$PWD/mersenne.cpp \
+    $$PWD/randomstream.cpp \
     $$PWD/sprt.cpp \
+    $$PWD/sprtsimulator.cpp \
+    $$PWD/resultaggregator.cpp \
     $$PWD/gameadjudicator.cpp \
+    $$PWD/adjudicationreplay.cpp \
     $$PWD/elo.cpp \
+    $$PWD/ratingmodel.cpp \
+    $$PWD/latencyhistogram.cpp \
+    $$PWD/adaptivemargin.cpp \
+    $$PWD/timerwheel.cpp \
+    $$PWD/cpuallocator.cpp \
+    $$PWD/resourceusage.cpp \
+    $$PWD/loadmonitor.cpp \
     $$PWD/knockouttournament.cpp \
     $$PWD/pyramidtournament.cpp \
+    $$PWD/swisstournament.cpp \
+    $$PWD/adaptivetournament.cpp \
     $$PWD/tournamentplayer.cpp \
     $$PWD/tournamentpair.cpp \
-    $$PWD/worker.cpp
+    $$PWD/worker.cpp \
+    $$PWD/cancellationtoken.cpp
 win32 { 
     HEADERS += $$PWD/engineprocess_win.h \
 	$$PWD/pipereader_win.h
     SOURCES += $$PWD/engineprocess_win.cpp \
 	$$PWD/pipereader_win.cpp
 }
+linux|macx {
+    HEADERS += $$PWD/engineprocess_unix.h \
+	$$PWD/pipereader_unix.h
+    SOURCES += $$PWD/engineprocess_unix.cpp \
+	$$PWD/pipereader_unix.cpp
+}
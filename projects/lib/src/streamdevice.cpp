@@ -0,0 +1,329 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "streamdevice.h"
+#include <QThread>
+#include <QFile>
+#include <QFileInfo>
+#include <QTcpSocket>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char TcpPrefix[] = "tcp://";
+// The size of a read from the source
+const int ReadSize = 64 * 1024;
+// How often a reader waiting for a socket checks for a stop request
+const int PollInterval = 100;
+// How long the destructor waits for a reader blocked on a pipe
+const int StopTimeout = 1000;
+
+// QFile keeps reading a pipe until its buffer is full, so the
+// stream is read with the native calls that return what's there
+int openFd(const QString& fileName)
+{
+	#ifdef Q_OS_WIN
+	return _wopen(reinterpret_cast<const wchar_t*>(fileName.utf16()),
+		      _O_RDONLY | _O_BINARY);
+	#else
+	return ::open(QFile::encodeName(fileName).constData(),
+		      O_RDONLY | O_CLOEXEC);
+	#endif
+}
+
+int readFd(int fd, char* data, int size)
+{
+	int n;
+	do
+	{
+		#ifdef Q_OS_WIN
+		n = _read(fd, data, unsigned(size));
+		#else
+		n = int(::read(fd, data, size_t(size)));
+		#endif
+	}
+	while (n == -1 && errno == EINTR);
+
+	return n;
+}
+
+void closeFd(int fd)
+{
+	#ifdef Q_OS_WIN
+	_close(fd);
+	#else
+	::close(fd);
+	#endif
+}
+
+} // anonymous namespace
+
+/*!
+ * Reads the source into the device's buffer. The file or socket is
+ * created by the thread itself, so it's only used by one thread.
+ */
+class StreamDevice::Reader : public QThread
+{
+	public:
+		Reader(StreamDevice* device, const QString& source)
+			: m_device(device),
+			  m_source(source)
+		{
+		}
+
+	protected:
+		// Inherited from QThread
+		virtual void run()
+		{
+			if (m_source.startsWith(TcpPrefix))
+				readSocket();
+			else
+				readFile();
+			m_device->setEnded();
+		}
+
+	private:
+		void readFile()
+		{
+			const int fd = (m_source == "-") ? 0 : openFd(m_source);
+			if (fd == -1)
+			{
+				qWarning("Can't open stream %s: %s",
+					 qUtf8Printable(m_source), strerror(errno));
+				return;
+			}
+
+			QByteArray data(ReadSize, Qt::Uninitialized);
+			for (;;)
+			{
+				const int n = readFd(fd, data.data(), ReadSize);
+				if (n <= 0 || !m_device->append(data.left(n)))
+					break;
+			}
+			if (fd != 0)
+				closeFd(fd);
+		}
+
+		void readSocket()
+		{
+			const QString address(m_source.mid(int(strlen(TcpPrefix))));
+			const int sep = address.lastIndexOf(':');
+			bool ok = false;
+			const int port = address.mid(sep + 1).toInt(&ok);
+			if (sep <= 0 || !ok || port <= 0 || port > 65535)
+			{
+				qWarning("Invalid stream address: %s",
+					 qUtf8Printable(m_source));
+				return;
+			}
+
+			QTcpSocket socket;
+			socket.connectToHost(address.left(sep), quint16(port));
+			while (!socket.waitForConnected(PollInterval))
+			{
+				if (socket.state() == QAbstractSocket::UnconnectedState
+				||  m_device->isStopping())
+				{
+					if (!m_device->isStopping())
+						qWarning("Can't connect to %s: %s",
+							 qUtf8Printable(m_source),
+							 qUtf8Printable(socket.errorString()));
+					return;
+				}
+			}
+
+			for (;;)
+			{
+				if (socket.bytesAvailable() > 0)
+				{
+					if (!m_device->append(socket.read(ReadSize)))
+						break;
+				}
+				else if (socket.state() != QAbstractSocket::ConnectedState)
+					break;
+				else if (!socket.waitForReadyRead(PollInterval)
+				     &&  m_device->isStopping())
+					break;
+			}
+			socket.abort();
+		}
+
+		StreamDevice* m_device;
+		QString m_source;
+};
+
+
+StreamDevice::StreamDevice(QObject* parent)
+	: QIODevice(parent),
+	  m_reader(nullptr),
+	  m_capacity(0),
+	  m_readPos(0),
+	  m_ended(false),
+	  m_stopping(false)
+{
+}
+
+StreamDevice::~StreamDevice()
+{
+	stop();
+}
+
+bool StreamDevice::isStream(const QString& source)
+{
+	if (source == "-" || source.startsWith(TcpPrefix))
+		return true;
+
+	const QFileInfo info(source);
+	return info.exists() && !info.isFile() && !info.isDir();
+}
+
+bool StreamDevice::open(const QString& source, int capacity)
+{
+	stop();
+
+	m_capacity = qMax(ReadSize, capacity);
+	m_buffer.clear();
+	m_buffer.reserve(m_capacity + ReadSize);
+	m_readPos = 0;
+	m_ended = false;
+	m_stopping = false;
+	if (!QIODevice::open(QIODevice::ReadOnly))
+		return false;
+
+	m_reader = new Reader(this, source);
+	m_reader->start();
+	return true;
+}
+
+void StreamDevice::stop()
+{
+	if (m_reader == nullptr)
+		return;
+
+	m_mutex.lock();
+	m_stopping = true;
+	m_notFull.wakeAll();
+	m_mutex.unlock();
+
+	// A read from a pipe can't be interrupted, so a reader that
+	// waits for a writer that's still open is terminated
+	if (!m_reader->wait(StopTimeout))
+	{
+		m_reader->terminate();
+		m_reader->wait();
+	}
+	delete m_reader;
+	m_reader = nullptr;
+
+	m_mutex.lock();
+	m_ended = true;
+	m_notEmpty.wakeAll();
+	m_mutex.unlock();
+}
+
+bool StreamDevice::append(const QByteArray& data)
+{
+	QMutexLocker locker(&m_mutex);
+	while (m_buffer.size() - m_readPos >= m_capacity && !m_stopping)
+		m_notFull.wait(&m_mutex);
+	if (m_stopping)
+		return false;
+
+	// Drop the data that was already read before growing the buffer
+	if (m_readPos > 0 && m_buffer.size() + data.size() > m_buffer.capacity())
+	{
+		m_buffer.remove(0, m_readPos);
+		m_readPos = 0;
+	}
+	m_buffer += data;
+	m_notEmpty.wakeAll();
+	return true;
+}
+
+void StreamDevice::setEnded()
+{
+	QMutexLocker locker(&m_mutex);
+	m_ended = true;
+	m_notEmpty.wakeAll();
+}
+
+bool StreamDevice::isStopping() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_stopping;
+}
+
+bool StreamDevice::atEnd() const
+{
+	if (QIODevice::bytesAvailable() > 0)
+		return false;
+
+	QMutexLocker locker(&m_mutex);
+	return m_ended && m_readPos >= m_buffer.size();
+}
+
+qint64 StreamDevice::bytesAvailable() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_buffer.size() - m_readPos + QIODevice::bytesAvailable();
+}
+
+void StreamDevice::close()
+{
+	stop();
+	QIODevice::close();
+}
+
+bool StreamDevice::isSequential() const
+{
+	return true;
+}
+
+qint64 StreamDevice::readData(char* data, qint64 maxSize)
+{
+	QMutexLocker locker(&m_mutex);
+	while (m_readPos >= m_buffer.size() && !m_ended)
+		m_notEmpty.wait(&m_mutex);
+
+	const int size = int(qMin(maxSize, qint64(m_buffer.size() - m_readPos)));
+	memcpy(data, m_buffer.constData() + m_readPos, size_t(size));
+	m_readPos += size;
+	if (m_readPos >= m_buffer.size())
+	{
+		// The reserved capacity is kept
+		m_buffer.resize(0);
+		m_readPos = 0;
+	}
+	m_notFull.wakeAll();
+
+	return size;
+}
+
+qint64 StreamDevice::writeData(const char* data, qint64 maxSize)
+{
+	Q_UNUSED(data);
+	Q_UNUSED(maxSize);
+	return -1;
+}
@@ -0,0 +1,100 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STREAMDEVICE_H
+#define STREAMDEVICE_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+
+/*!
+ * \brief A read-ahead device for data streamed from a pipe or socket
+ *
+ * StreamDevice reads a stream that can't be seeked, eg. the output of
+ * a generator process, in a thread of its own and keeps a bounded
+ * buffer of the data read ahead. The source can be:
+ * - "-" for the standard input
+ * - the path of a named pipe (FIFO) or another file that isn't a
+ *   regular file
+ * - "tcp://HOST:PORT" for a TCP server that sends the data
+ *
+ * Reads block until data arrives or the stream ends, so the device
+ * can be read without an event loop, eg. by a PgnStream, from any
+ * single thread. atEnd() returns true once the writer has closed the
+ * stream and the buffer is empty.
+ *
+ * \sa OpeningSuite
+ */
+class LIB_EXPORT StreamDevice : public QIODevice
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new StreamDevice. */
+		explicit StreamDevice(QObject* parent = nullptr);
+		/*! Stops reading the stream and destroys the device. */
+		virtual ~StreamDevice();
+
+		/*!
+		 * Returns true if \a source names a stream that must be
+		 * read with StreamDevice instead of a file.
+		 */
+		static bool isStream(const QString& source);
+
+		/*!
+		 * Starts reading the stream \a source, keeping at most
+		 * \a capacity bytes read ahead. The stream is opened by
+		 * the reading thread, so a named pipe doesn't block the
+		 * caller until a writer opens it. Errors are printed with
+		 * qWarning(), and end the stream.
+		 */
+		bool open(const QString& source, int capacity = 1 << 20);
+
+		// Inherited from QIODevice
+		virtual bool atEnd() const;
+		virtual qint64 bytesAvailable() const;
+		virtual void close();
+		virtual bool isSequential() const;
+
+	protected:
+		// Inherited from QIODevice
+		virtual qint64 readData(char* data, qint64 maxSize);
+		virtual qint64 writeData(const char* data, qint64 maxSize);
+
+	private:
+		class Reader;
+
+		bool append(const QByteArray& data);
+		void setEnded();
+		bool isStopping() const;
+		void stop();
+
+		Reader* m_reader;
+		int m_capacity;
+		mutable QMutex m_mutex;
+		QWaitCondition m_notEmpty;
+		QWaitCondition m_notFull;
+		QByteArray m_buffer;
+		int m_readPos;
+		bool m_ended;
+		bool m_stopping;
+};
+
+#endif // STREAMDEVICE_H
@@ -0,0 +1,214 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "swisstournament.h"
+#include <QMap>
+#include <climits>
+#include "tournamentpair.h"
+
+SwissTournament::SwissTournament(GameManager* gameManager,
+				 QObject *parent)
+	: Tournament(gameManager, parent)
+{
+}
+
+QString SwissTournament::type() const
+{
+	return "swiss";
+}
+
+void SwissTournament::initializePairing()
+{
+	const Entry entry = { 0, 0, 0, 0, false, QSet<int>() };
+	m_entries.fill(entry, playerCount());
+	m_nextPairs.clear();
+	setCurrentRound(1);
+}
+
+int SwissTournament::gamesPerCycle() const
+{
+	return playerCount() / 2;
+}
+
+TournamentPair* SwissTournament::nextPair(int gameNumber)
+{
+	if (gameNumber >= finalGameCount())
+		return nullptr;
+	if (gameNumber % gamesPerEncounter() != 0)
+		return currentPair();
+
+	if (m_nextPairs.isEmpty())
+		pairFreePlayers();
+	if (m_nextPairs.isEmpty())
+		return nullptr;
+
+	return m_nextPairs.takeFirst();
+}
+
+void SwissTournament::addScore(int player, int score)
+{
+	Entry& entry = m_entries[player];
+	entry.score += score;
+	entry.gamesLeft--;
+
+	Tournament::addScore(player, score);
+}
+
+void SwissTournament::pairFreePlayers()
+{
+	// The free players by the number of rounds they have played
+	QMap<int, QVector<int>> freePlayers;
+	int minRounds = INT_MAX;
+	int minBusyRounds = INT_MAX;
+	for (int i = 0; i < m_entries.size(); i++)
+	{
+		const Entry& entry = m_entries.at(i);
+		minRounds = qMin(minRounds, entry.rounds);
+		if (entry.gamesLeft > 0)
+			minBusyRounds = qMin(minBusyRounds, entry.rounds);
+		else if (entry.rounds < roundMultiplier())
+			freePlayers[entry.rounds].append(i);
+	}
+
+	// A round is complete when nobody else can join its free players
+	for (auto it = freePlayers.constBegin(); it != freePlayers.constEnd(); ++it)
+	{
+		const bool complete = it.key() == minRounds
+				   && minBusyRounds > it.key();
+		pairRound(it.key() + 1, it.value(), complete);
+	}
+}
+
+void SwissTournament::pairRound(int round,
+				const QVector<int>& players,
+				bool complete)
+{
+	// Score groups in rank order
+	QMap<int, QVector<int>> groups;
+	for (int player : players)
+		groups[m_entries.at(player).score].append(player);
+
+	QVector<int> floaters;
+	for (auto it = groups.end(); it != groups.begin(); )
+	{
+		--it;
+		QVector<int> group(floaters + it.value());
+		if (complete && it == groups.begin() && group.size() % 2 != 0)
+			giveBye(&group);
+
+		floaters = pairGroup(group, round, false);
+		if (!complete)
+			floaters.clear();
+	}
+
+	// The last floaters are paired even if they have met before
+	pairGroup(floaters, round, true);
+
+	if (!m_nextPairs.isEmpty() && round > currentRound())
+		setCurrentRound(round);
+}
+
+void SwissTournament::giveBye(QVector<int>* players)
+{
+	Q_ASSERT(!players->isEmpty());
+
+	// The lowest ranked player who hasn't had a bye yet
+	int index = players->size() - 1;
+	for (int i = index; i >= 0; i--)
+	{
+		if (!m_entries.at(players->at(i)).hadBye)
+		{
+			index = i;
+			break;
+		}
+	}
+
+	Entry& entry = m_entries[players->takeAt(index)];
+	entry.score += 2;
+	entry.rounds++;
+	entry.hadBye = true;
+}
+
+QVector<int> SwissTournament::pairGroup(const QVector<int>& players,
+					int round,
+					bool rematches)
+{
+	// The top half meets the bottom half. If the opponents have met
+	// before, the next player of the bottom half is tried instead.
+	const int half = players.size() / 2;
+	QVector<bool> paired(players.size(), false);
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int i = 0; i < players.size(); i++)
+		{
+			if (paired.at(i) || (pass == 0 && i >= half))
+				continue;
+
+			const int player = players.at(i);
+			const QSet<int>& opponents = m_entries.at(player).opponents;
+			for (int j = (pass == 0 ? half : i + 1); j < players.size(); j++)
+			{
+				const int opponent = players.at(j);
+				if (paired.at(j)
+				||  (!rematches && opponents.contains(opponent)))
+					continue;
+
+				paired[i] = paired[j] = true;
+				addPair(player, opponent, round);
+				break;
+			}
+		}
+	}
+
+	QVector<int> unpaired;
+	for (int i = 0; i < players.size(); i++)
+	{
+		if (!paired.at(i))
+			unpaired.append(players.at(i));
+	}
+	return unpaired;
+}
+
+void SwissTournament::addPair(int player1, int player2, int round)
+{
+	Entry& entry1 = m_entries[player1];
+	Entry& entry2 = m_entries[player2];
+
+	// The player who has had white less often gets white. With equal
+	// colors the higher ranked player alternates between the rounds.
+	int white = player1;
+	int black = player2;
+	if (entry1.colorBalance > entry2.colorBalance
+	||  (entry1.colorBalance == entry2.colorBalance && round % 2 == 0))
+		std::swap(white, black);
+
+	m_entries[white].colorBalance++;
+	m_entries[black].colorBalance--;
+	for (Entry* entry : {&entry1, &entry2})
+	{
+		entry->rounds++;
+		entry->gamesLeft = gamesPerEncounter();
+	}
+	entry1.opponents.insert(player2);
+	entry2.opponents.insert(player1);
+
+	TournamentPair* pair = Tournament::pair(white, black);
+	if (pair->firstPlayer() != white)
+		pair->swapPlayers();
+	m_nextPairs.append(pair);
+}
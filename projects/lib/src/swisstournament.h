@@ -0,0 +1,90 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SWISSTOURNAMENT_H
+#define SWISSTOURNAMENT_H
+
+#include "tournament.h"
+#include <QVector>
+#include <QSet>
+
+/*!
+ * \brief Swiss system chess tournament.
+ *
+ * In a Swiss tournament every round pairs players with equal or
+ * similar scores who haven't met yet, so a large field can be ranked
+ * with a small number of rounds. The number of rounds is set with
+ * setRoundMultiplier().
+ *
+ * The pairings follow the Dutch system: players with the same score
+ * are ordered by rank (the order of the players list), and the top
+ * half meets the bottom half, with the lowest possible transpositions
+ * to avoid rematches. Players who can't be paired in their score
+ * group float down to the next one, and an odd player out gets a bye,
+ * which is worth a win in the pairings.
+ *
+ * The players of a round are paired as soon as they're free: when a
+ * score group of the next round already has two or more players who
+ * finished their games, they are paired without waiting for the rest
+ * of the round. The floaters and the bye are decided when the last
+ * game of the round is over. Each pairing is done with score buckets
+ * in about linear time, so even thousands of players are paired in
+ * milliseconds.
+ */
+class LIB_EXPORT SwissTournament : public Tournament
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new Swiss tournament. */
+		explicit SwissTournament(GameManager* gameManager,
+					 QObject *parent = nullptr);
+		// Inherited from Tournament
+		virtual QString type() const;
+
+	protected:
+		// Inherited from Tournament
+		virtual void initializePairing();
+		virtual int gamesPerCycle() const;
+		virtual TournamentPair* nextPair(int gameNumber);
+		virtual void addScore(int player, int score);
+
+	private:
+		struct Entry
+		{
+			int score;		// Score in half points, with byes
+			int rounds;		// Paired rounds, with byes
+			int colorBalance;	// First games as white minus black
+			int gamesLeft;		// Unfinished games of the encounter
+			bool hadBye;
+			QSet<int> opponents;
+		};
+
+		void pairFreePlayers();
+		void pairRound(int round, const QVector<int>& players, bool complete);
+		void giveBye(QVector<int>* players);
+		QVector<int> pairGroup(const QVector<int>& players,
+				       int round,
+				       bool rematches);
+		void addPair(int player1, int player2, int round);
+
+		QVector<Entry> m_entries;
+		QList<TournamentPair*> m_nextPairs;
+};
+
+#endif // SWISSTOURNAMENT_H
@@ -19,16 +19,23 @@
 #include "timecontrol.h"
 #include <QStringList>
 #include <QSettings>
+#include "adaptivemargin.h"
 
 namespace {
 
-QString s_timeString(int ms)
+// Converts seconds to microseconds
+qint64 s_usecs(double seconds)
 {
-	if (ms == 0 || ms % 60000 != 0)
-		return TimeControl::tr("%1 sec").arg(double(ms) / 1000.0);
-	if (ms % 3600000 != 0)
-		return TimeControl::tr("%1 min").arg(ms / 60000);
-	return TimeControl::tr("%1 h").arg(ms / 3600000);
+	return qRound64(seconds * 1000000.0);
+}
+
+QString s_timeString(qint64 us)
+{
+	if (us == 0 || us % Q_INT64_C(60000000) != 0)
+		return TimeControl::tr("%1 sec").arg(double(us) / 1000000.0);
+	if (us % Q_INT64_C(3600000000) != 0)
+		return TimeControl::tr("%1 min").arg(us / Q_INT64_C(60000000));
+	return TimeControl::tr("%1 h").arg(us / Q_INT64_C(3600000000));
 }
 
 QString s_nodeString(qint64 nodes)
@@ -51,10 +58,13 @@ TimeControl::TimeControl()
 	  m_movesLeft(0),
 	  m_plyLimit(0),
 	  m_nodeLimit(0),
+	  m_nodesPerMs(0),
+	  m_moveNodes(0),
 	  m_lastMoveTime(0),
 	  m_expiryMargin(0),
 	  m_expired(false),
-	  m_infinite(false)
+	  m_infinite(false),
+	  m_stopLatency(0)
 {
 }
 
@@ -67,10 +77,13 @@ TimeControl::TimeControl(const QString& str)
 	  m_movesLeft(0),
 	  m_plyLimit(0),
 	  m_nodeLimit(0),
+	  m_nodesPerMs(0),
+	  m_moveNodes(0),
 	  m_lastMoveTime(0),
 	  m_expiryMargin(0),
 	  m_expired(false),
-	  m_infinite(false)
+	  m_infinite(false),
+	  m_stopLatency(0)
 {
 	if (str == "inf")
 	{
@@ -83,9 +96,9 @@ TimeControl::TimeControl(const QString& str)
 	// increment
 	if (list.size() == 2)
 	{
-		int inc = (int)(list.at(1).toDouble() * 1000);
+		qint64 inc = s_usecs(list.at(1).toDouble());
 		if (inc >= 0)
-			setTimeIncrement(inc);
+			m_increment = inc;
 	}
 
 	list = list.at(0).split('/');
@@ -103,15 +116,15 @@ TimeControl::TimeControl(const QString& str)
 		strTime = list.at(0);
 
 	// time per tc
-	int ms = 0;
+	qint64 us = 0;
 	list = strTime.split(':');
 	if (list.size() == 2)
-		ms = (int)(list.at(0).toDouble() * 60000 + list.at(1).toDouble() * 1000);
+		us = s_usecs(list.at(0).toDouble() * 60 + list.at(1).toDouble());
 	else
-		ms = (int)(list.at(0).toDouble() * 1000);
+		us = s_usecs(list.at(0).toDouble());
 
-	if (ms > 0)
-		setTimePerTc(ms);
+	if (us > 0)
+		m_timePerTc = us;
 }
 
 bool TimeControl::operator==(const TimeControl& other) const
@@ -122,6 +135,7 @@ bool TimeControl::operator==(const TimeControl& other) const
 	&&  m_increment == other.m_increment
 	&&  m_plyLimit == other.m_plyLimit
 	&&  m_nodeLimit == other.m_nodeLimit
+	&&  m_nodesPerMs == other.m_nodesPerMs
 	&&  m_infinite == other.m_infinite)
 		return true;
 	return false;
@@ -135,6 +149,7 @@ bool TimeControl::isValid() const
 	||  m_increment < 0
 	||  m_plyLimit < 0
 	||  m_nodeLimit < 0
+	||  m_nodesPerMs < 0
 	||  m_expiryMargin < 0
 	||  (m_timePerTc == m_timePerMove && !m_infinite))
 		return false;
@@ -150,15 +165,15 @@ QString TimeControl::toString() const
 		return QString("inf");
 
 	if (m_timePerMove != 0)
-		return QString("%1/move").arg((double)m_timePerMove / 1000);
+		return QString("%1/move").arg((double)m_timePerMove / 1000000);
 
 	QString str;
 	if (m_movesPerTc > 0)
 		str += QString::number(m_movesPerTc) + "/";
-	str += QString::number((double)m_timePerTc / 1000);
+	str += QString::number((double)m_timePerTc / 1000000);
 
 	if (m_increment > 0)
-		str += QString("+") + QString::number((double)m_increment / 1000);
+		str += QString("+") + QString::number((double)m_increment / 1000000);
 	return str;
 }
 
@@ -189,8 +204,13 @@ QString TimeControl::toVerboseString() const
 			.arg(s_nodeString(m_nodeLimit));
 	if (m_plyLimit != 0)
 		str += tr(", %1 plies").arg(m_plyLimit);
+	if (m_nodesPerMs != 0)
+		str += tr(", %1 nodes per msec").arg(m_nodesPerMs);
 	if (m_expiryMargin != 0)
-		str += tr(", %1 msec margin").arg(m_expiryMargin);
+		str += tr(", %1 msec margin").arg(m_expiryMargin / 1000);
+	if (m_adaptiveMargin)
+		str += tr(", adaptive margin up to %1 msec")
+			.arg(m_adaptiveMargin->capUsec() / 1000);
 
 	return str;
 }
@@ -216,7 +236,7 @@ bool TimeControl::isInfinite() const
 
 int TimeControl::timePerTc() const
 {
-	return m_timePerTc;
+	return int(m_timePerTc / 1000);
 }
 
 int TimeControl::movesPerTc() const
@@ -226,15 +246,20 @@ int TimeControl::movesPerTc() const
 
 int TimeControl::timeIncrement() const
 {
-	return m_increment;
+	return int(m_increment / 1000);
 }
 
 int TimeControl::timePerMove() const
 {
-	return m_timePerMove;
+	return int(m_timePerMove / 1000);
 }
 
 int TimeControl::timeLeft() const
+{
+	return int(m_timeLeft / 1000);
+}
+
+qint64 TimeControl::timeLeftUsec() const
 {
 	return m_timeLeft;
 }
@@ -254,11 +279,28 @@ qint64 TimeControl::nodeLimit() const
 	return m_nodeLimit;
 }
 
+int TimeControl::nodesPerMs() const
+{
+	return m_nodesPerMs;
+}
+
 int TimeControl::expiryMargin() const
 {
+	return int(expiryMarginUsec() / 1000);
+}
+
+qint64 TimeControl::expiryMarginUsec() const
+{
+	if (m_adaptiveMargin)
+		return m_expiryMargin + m_adaptiveMargin->compensationUsec();
 	return m_expiryMargin;
 }
 
+AdaptiveMargin* TimeControl::adaptiveMargin() const
+{
+	return m_adaptiveMargin.data();
+}
+
 void TimeControl::setInfinity(bool enabled)
 {
 	m_infinite = enabled;
@@ -267,7 +309,7 @@ void TimeControl::setInfinity(bool enabled)
 void TimeControl::setTimePerTc(int timePerTc)
 {
 	Q_ASSERT(timePerTc >= 0);
-	m_timePerTc = timePerTc;
+	m_timePerTc = qint64(timePerTc) * 1000;
 }
 
 void TimeControl::setMovesPerTc(int movesPerTc)
@@ -279,18 +321,18 @@ void TimeControl::setMovesPerTc(int movesPerTc)
 void TimeControl::setTimeIncrement(int increment)
 {
 	Q_ASSERT(increment >= 0);
-	m_increment = increment;
+	m_increment = qint64(increment) * 1000;
 }
 
 void TimeControl::setTimePerMove(int timePerMove)
 {
 	Q_ASSERT(timePerMove >= 0);
-	m_timePerMove = timePerMove;
+	m_timePerMove = qint64(timePerMove) * 1000;
 }
 
 void TimeControl::setTimeLeft(int timeLeft)
 {
-	m_timeLeft = timeLeft;
+	m_timeLeft = qint64(timeLeft) * 1000;
 }
 
 void TimeControl::setMovesLeft(int movesLeft)
@@ -311,55 +353,100 @@ void TimeControl::setNodeLimit(qint64 nodes)
 	m_nodeLimit = nodes;
 }
 
+void TimeControl::setNodesPerMs(int nodesPerMs)
+{
+	Q_ASSERT(nodesPerMs >= 0);
+	m_nodesPerMs = nodesPerMs;
+}
+
+void TimeControl::setMoveNodes(quint64 nodes)
+{
+	m_moveNodes = nodes;
+}
+
 void TimeControl::setExpiryMargin(int expiryMargin)
 {
 	Q_ASSERT(expiryMargin >= 0);
-	m_expiryMargin = expiryMargin;
+	m_expiryMargin = qint64(expiryMargin) * 1000;
+}
+
+void TimeControl::setAdaptiveMargin(int cap)
+{
+	Q_ASSERT(cap >= 0);
+	m_adaptiveMargin.reset(new AdaptiveMargin(qint64(cap) * 1000));
 }
 
 void TimeControl::startTimer()
 {
 	m_time.start();
+	m_stopTime.invalidate();
+	m_stopLatency = 0;
+	m_moveNodes = 0;
+}
+
+void TimeControl::stopTimer(const QElapsedTimer& stopTime, qint64 latency)
+{
+	m_stopTime = stopTime;
+	m_stopLatency = qMax(latency, Q_INT64_C(0));
 }
 
 void TimeControl::update(bool applyIncrement)
 {
-	/*
-	 * This will overflow after roughly 49 days however it's unlikely
-	 * we'll ever hit that limit.
-	 */
-	if (m_time.isValid())
-		m_lastMoveTime = (int)m_time.elapsed();
-	else
+	// The clock is kept in microseconds so that the rounding
+	// errors don't add up over a fast game
+	if (m_nodesPerMs > 0 && m_moveNodes > 0)
+		m_lastMoveTime = qint64(m_moveNodes * 1000 / quint64(m_nodesPerMs));
+	else if (!m_time.isValid())
 		m_lastMoveTime = 0;
+	else if (m_stopTime.isValid())
+	{
+		qint64 ns = m_time.nsecsElapsed() - m_stopTime.nsecsElapsed()
+			    - m_stopLatency * 1000;
+		m_lastMoveTime = qMax(ns, Q_INT64_C(0)) / 1000;
+	}
+	else
+		m_lastMoveTime = m_time.nsecsElapsed() / 1000;
+	m_stopTime.invalidate();
+	m_stopLatency = 0;
+	m_moveNodes = 0;
 
 	if (!m_infinite && m_lastMoveTime > m_timeLeft + m_expiryMargin)
-		m_expired = true;
+	{
+		if (m_adaptiveMargin
+		&&  m_lastMoveTime <= m_timeLeft + expiryMarginUsec())
+			m_adaptiveMargin->addSavedMove();
+		else
+			m_expired = true;
+	}
 
 	if (m_timePerMove != 0)
-		setTimeLeft(m_timePerMove);
+		m_timeLeft = m_timePerMove;
 	else
 	{
-	        int newTimeLeft = m_timeLeft - m_lastMoveTime;
+		m_timeLeft -= m_lastMoveTime;
 		if (applyIncrement)
-			newTimeLeft += m_increment;
-		setTimeLeft(newTimeLeft);
-		
+			m_timeLeft += m_increment;
+
 		if (m_movesPerTc > 0)
 		{
 			setMovesLeft(m_movesLeft - 1);
-			
+
 			// Restart the time control
 			if (m_movesLeft == 0)
 			{
 				setMovesLeft(m_movesPerTc);
-				setTimeLeft(m_timePerTc + m_timeLeft);
+				m_timeLeft += m_timePerTc;
 			}
 		}
 	}
 }
 
 int TimeControl::lastMoveTime() const
+{
+	return int(m_lastMoveTime / 1000);
+}
+
+qint64 TimeControl::lastMoveTimeUsec() const
 {
 	return m_lastMoveTime;
 }
@@ -370,9 +457,14 @@ bool TimeControl::expired() const
 }
 
 int TimeControl::activeTimeLeft() const
+{
+	return int(activeTimeLeftUsec() / 1000);
+}
+
+qint64 TimeControl::activeTimeLeftUsec() const
 {
 	if (m_time.isValid())
-		return m_timeLeft - m_time.elapsed();
+		return m_timeLeft - m_time.nsecsElapsed() / 1000;
 	return m_timeLeft;
 }
 
@@ -381,12 +473,13 @@ void TimeControl::readSettings(QSettings* settings)
 	settings->beginGroup("time_control");
 
 	m_movesPerTc = settings->value("moves_per_tc", m_movesPerTc).toInt();
-	m_timePerTc = settings->value("time_per_tc", m_timePerTc).toInt();
-	m_timePerMove = settings->value("time_per_move", m_timePerMove).toInt();
-	m_increment = settings->value("increment", m_increment).toInt();
+	setTimePerTc(settings->value("time_per_tc", timePerTc()).toInt());
+	setTimePerMove(settings->value("time_per_move", timePerMove()).toInt());
+	setTimeIncrement(settings->value("increment", timeIncrement()).toInt());
 	m_plyLimit = settings->value("ply_limit", m_plyLimit).toInt();
 	m_nodeLimit = settings->value("node_limit", m_nodeLimit).toLongLong();
-	m_expiryMargin = settings->value("expiry_margin", m_expiryMargin).toInt();
+	m_nodesPerMs = settings->value("nodes_per_ms", m_nodesPerMs).toInt();
+	setExpiryMargin(settings->value("expiry_margin", expiryMargin()).toInt());
 	m_infinite = settings->value("infinite", m_infinite).toBool();
 
 	settings->endGroup();
@@ -397,11 +490,12 @@ void TimeControl::writeSettings(QSettings* settings)
 	settings->beginGroup("time_control");
 
 	settings->setValue("moves_per_tc", m_movesPerTc);
-	settings->setValue("time_per_tc", m_timePerTc);
-	settings->setValue("time_per_move", m_timePerMove);
-	settings->setValue("increment", m_increment);
+	settings->setValue("time_per_tc", timePerTc());
+	settings->setValue("time_per_move", timePerMove());
+	settings->setValue("increment", timeIncrement());
 	settings->setValue("ply_limit", m_plyLimit);
 	settings->setValue("node_limit", m_nodeLimit);
-	settings->setValue("expiry_margin", m_expiryMargin);
+	settings->setValue("nodes_per_ms", m_nodesPerMs);
+	settings->setValue("expiry_margin", int(m_expiryMargin / 1000));
 	settings->setValue("infinite", m_infinite);
 }
@@ -22,7 +22,9 @@
 #include <QElapsedTimer>
 #include <QString>
 #include <QCoreApplication>
+#include <QSharedPointer>
 class QSettings;
+class AdaptiveMargin;
 
 /*!
  * \brief Time controls of a chess game.
@@ -30,7 +32,9 @@ class QSettings;
  * TimeControl is used for telling the chess players how much time
  * they can spend thinking of their moves.
  *
- * \note All time handling is done in milliseconds.
+ * \note The times are given in milliseconds. Internally the clock
+ * is kept in microseconds, which the functions with a Usec suffix
+ * expose.
  */
 class LIB_EXPORT TimeControl
 {
@@ -114,6 +118,8 @@ class LIB_EXPORT TimeControl
 
 		/*! Returns the time left in the time control. */
 		int timeLeft() const;
+		/*! Returns the time left in microseconds. */
+		qint64 timeLeftUsec() const;
 
 		/*!
 		 * Returns the number of full moves left in the time control,
@@ -126,6 +132,13 @@ class LIB_EXPORT TimeControl
 
 		/*! Returns the node limit for each move. */
 		qint64 nodeLimit() const;
+		/*!
+		 * Returns the virtual clock rate in nodes per millisecond,
+		 * or 0 if the clock runs on wall time.
+		 *
+		 * \sa setNodesPerMs()
+		 */
+		int nodesPerMs() const;
 
 		/*!
 		 * Returns the expiry margin.
@@ -133,8 +146,18 @@ class LIB_EXPORT TimeControl
 		 * Expiry margin is the amount of time a player can go over
 		 * the time limit without losing on time.
 		 * The default value is 0.
+		 *
+		 * The margin includes the current compensation of the
+		 * adaptive margin, if there is one.
 		 */
 		int expiryMargin() const;
+		/*! Returns the expiry margin in microseconds. */
+		qint64 expiryMarginUsec() const;
+		/*!
+		 * Returns the adaptive margin, or a null pointer if the
+		 * margin is fixed.
+		 */
+		AdaptiveMargin* adaptiveMargin() const;
 
 
 		/*!
@@ -166,13 +189,52 @@ class LIB_EXPORT TimeControl
 
 		/*! Sets the node limit. */
 		void setNodeLimit(qint64 nodes);
+		/*!
+		 * Charges the player's clock by nodes instead of wall time.
+		 *
+		 * Each move costs the nodes searched, as set with
+		 * setMoveNodes(), divided by \a nodesPerMs milliseconds.
+		 * This makes the results independent of the host's speed
+		 * and load. The player still gets its time left as usual.
+		 * Moves without a node count are charged wall time.
+		 * If \a nodesPerMs is 0 (the default), only wall time is
+		 * used.
+		 */
+		void setNodesPerMs(int nodesPerMs);
+		/*!
+		 * Sets the number of nodes the player searched for the
+		 * current move to \a nodes.
+		 *
+		 * The next call to update() charges the nodes if
+		 * nodesPerMs() isn't 0.
+		 */
+		void setMoveNodes(quint64 nodes);
 
 		/*! Sets the expiry margin. */
 		void setExpiryMargin(int expiryMargin);
+		/*!
+		 * Adds an adaptive margin of at most \a cap milliseconds
+		 * on top of the fixed expiry margin.
+		 *
+		 * The adaptive margin is shared by the copies of this
+		 * time control, so it learns from all games of a player.
+		 * \sa AdaptiveMargin
+		 */
+		void setAdaptiveMargin(int cap);
 
 		
 		/*! Start the timer. */
 		void startTimer();
+		/*!
+		 * Stops the timer at the moment when \a stopTime was started.
+		 *
+		 * The next call to update() uses this moment instead of the
+		 * current time, e.g. to not charge the player for the time
+		 * it took to process its move. \a latency microseconds of
+		 * network latency, measured for a remote engine, are also
+		 * left out of the move time.
+		 */
+		void stopTimer(const QElapsedTimer& stopTime, qint64 latency = 0);
 		
 		/*!
 		 * Update the time control with the elapsed time.
@@ -185,6 +247,8 @@ class LIB_EXPORT TimeControl
 
 		/*! Returns the last elapsed move time. */
 		int lastMoveTime() const;
+		/*! Returns the last elapsed move time in microseconds. */
+		qint64 lastMoveTimeUsec() const;
 
 		/*! Returns true if the allotted time has expired. */
 		bool expired() const;
@@ -197,6 +261,8 @@ class LIB_EXPORT TimeControl
 		 * state first to verify that it's in the thinking state.
 		 */
 		int activeTimeLeft() const;
+		/*! Returns the time left in an active clock in microseconds. */
+		qint64 activeTimeLeftUsec() const;
 
 		/*! Reads time control settings from \a settings. */
 		void readSettings(QSettings* settings);
@@ -206,18 +272,23 @@ class LIB_EXPORT TimeControl
 
 	private:
 		int m_movesPerTc;
-		int m_timePerTc;
-		int m_timePerMove;
-		int m_increment;
-		int m_timeLeft;
+		qint64 m_timePerTc;
+		qint64 m_timePerMove;
+		qint64 m_increment;
+		qint64 m_timeLeft;
 		int m_movesLeft;
 		int m_plyLimit;
 		qint64 m_nodeLimit;
-		int m_lastMoveTime;
-		int m_expiryMargin;
+		int m_nodesPerMs;
+		quint64 m_moveNodes;
+		qint64 m_lastMoveTime;
+		qint64 m_expiryMargin;
+		QSharedPointer<AdaptiveMargin> m_adaptiveMargin;
 		bool m_expired;
 		bool m_infinite;
 		QElapsedTimer m_time;
+		QElapsedTimer m_stopTime;
+		qint64 m_stopLatency;
 };
 
 #endif // TIMECONTROL_H
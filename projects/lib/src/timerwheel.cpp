@@ -0,0 +1,372 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "timerwheel.h"
+#include <QThread>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QTimerEvent>
+
+/*
+ * The timers of one thread, in three levels of 256 slots. A timer that
+ * expires within 256 ticks is in the first level, one that expires
+ * within 65536 ticks is in the second level, and so on. When the first
+ * level wraps around, the matching slot of the second level is emptied
+ * into the first level, and likewise for the third level. Timers that
+ * were restarted lazily are put back instead of being fired.
+ */
+class TimerWheel : public QObject
+{
+	public:
+		static TimerWheel* instance();
+
+		TimerWheel();
+		virtual ~TimerWheel();
+
+		qint64 deadline(int msec) const;
+		int remainingTime(const WheelTimer* timer) const;
+		void add(WheelTimer* timer);
+		void remove(WheelTimer* timer);
+
+	protected:
+		virtual void timerEvent(QTimerEvent* event);
+
+	private:
+		enum
+		{
+			Resolution = 50,
+			SlotBits = 8,
+			SlotCount = 1 << SlotBits,
+			LevelCount = 3
+		};
+
+		static void initList(WheelTimer::Link* list);
+		static void unlink(WheelTimer::Link* link);
+		static void takeList(WheelTimer::Link* list,
+				     WheelTimer::Link* target);
+		void insert(WheelTimer* timer);
+		void cascade(int level);
+		void processTick();
+
+		QElapsedTimer m_clock;
+		qint64 m_tick;
+		int m_count;
+		int m_timerId;
+		WheelTimer::Link m_slots[LevelCount][SlotCount];
+};
+
+namespace {
+
+thread_local TimerWheel* s_wheel = nullptr;
+
+} // anonymous namespace
+
+TimerWheel* TimerWheel::instance()
+{
+	if (s_wheel == nullptr)
+	{
+		s_wheel = new TimerWheel();
+		connect(QThread::currentThread(), &QThread::finished,
+			s_wheel, &QObject::deleteLater);
+	}
+	return s_wheel;
+}
+
+TimerWheel::TimerWheel()
+	: m_tick(0),
+	  m_count(0),
+	  m_timerId(0)
+{
+	m_clock.start();
+	for (int i = 0; i < LevelCount; i++)
+	{
+		for (int j = 0; j < SlotCount; j++)
+			initList(&m_slots[i][j]);
+	}
+}
+
+TimerWheel::~TimerWheel()
+{
+	for (int i = 0; i < LevelCount; i++)
+	{
+		for (int j = 0; j < SlotCount; j++)
+		{
+			WheelTimer::Link* list = &m_slots[i][j];
+			while (list->next != list)
+			{
+				WheelTimer::Link* link = list->next;
+				unlink(link);
+				link->timer->m_wheel = nullptr;
+			}
+		}
+	}
+	if (s_wheel == this)
+		s_wheel = nullptr;
+}
+
+void TimerWheel::initList(WheelTimer::Link* list)
+{
+	list->prev = list;
+	list->next = list;
+	list->timer = nullptr;
+}
+
+void TimerWheel::unlink(WheelTimer::Link* link)
+{
+	link->prev->next = link->next;
+	link->next->prev = link->prev;
+	link->prev = link;
+	link->next = link;
+}
+
+void TimerWheel::takeList(WheelTimer::Link* list, WheelTimer::Link* target)
+{
+	initList(target);
+	if (list->next == list)
+		return;
+
+	target->next = list->next;
+	target->prev = list->prev;
+	target->next->prev = target;
+	target->prev->next = target;
+	initList(list);
+}
+
+qint64 TimerWheel::deadline(int msec) const
+{
+	// Round up so that the timer never expires early
+	qint64 t = m_clock.elapsed() + qMax(msec, 0);
+	return (t + Resolution - 1) / Resolution;
+}
+
+int TimerWheel::remainingTime(const WheelTimer* timer) const
+{
+	qint64 t = timer->m_deadline * Resolution - m_clock.elapsed();
+	return int(qMax(t, Q_INT64_C(0)));
+}
+
+void TimerWheel::add(WheelTimer* timer)
+{
+	Q_ASSERT(timer->m_wheel == nullptr);
+
+	// Nothing was pending, so no ticks need to be processed
+	if (m_count++ == 0)
+		m_tick = m_clock.elapsed() / Resolution;
+	if (m_timerId == 0)
+		m_timerId = startTimer(Resolution, Qt::CoarseTimer);
+	timer->m_wheel = this;
+	insert(timer);
+}
+
+void TimerWheel::remove(WheelTimer* timer)
+{
+	Q_ASSERT(timer->m_wheel == this);
+
+	unlink(&timer->m_link);
+	timer->m_wheel = nullptr;
+	if (--m_count == 0 && m_timerId != 0)
+	{
+		killTimer(m_timerId);
+		m_timerId = 0;
+	}
+}
+
+void TimerWheel::insert(WheelTimer* timer)
+{
+	qint64 t = qMax(timer->m_deadline, m_tick);
+	qint64 delta = t - m_tick;
+
+	int level = 0;
+	while (level < LevelCount - 1
+	&&     delta >= Q_INT64_C(1) << (SlotBits * (level + 1)))
+		level++;
+
+	// Very long timeouts wait in the last level for another round
+	const qint64 maxDelta = Q_INT64_C(1) << (SlotBits * LevelCount);
+	if (delta >= maxDelta)
+		t = m_tick + maxDelta - 1;
+
+	timer->m_slotTick = t;
+	int index = int((t >> (SlotBits * level)) & (SlotCount - 1));
+	WheelTimer::Link* list = &m_slots[level][index];
+	WheelTimer::Link* link = &timer->m_link;
+
+	link->prev = list->prev;
+	link->next = list;
+	list->prev->next = link;
+	list->prev = link;
+}
+
+void TimerWheel::cascade(int level)
+{
+	int index = int((m_tick >> (SlotBits * level)) & (SlotCount - 1));
+	WheelTimer::Link* list = &m_slots[level][index];
+
+	WheelTimer::Link pending;
+	takeList(list, &pending);
+
+	while (pending.next != &pending)
+	{
+		WheelTimer::Link* link = pending.next;
+		unlink(link);
+		insert(link->timer);
+	}
+}
+
+void TimerWheel::processTick()
+{
+	const qint64 mask = (Q_INT64_C(1) << (SlotBits * 2)) - 1;
+	if ((m_tick & mask) == 0)
+		cascade(2);
+	if ((m_tick & (SlotCount - 1)) == 0)
+		cascade(1);
+
+	WheelTimer::Link* list = &m_slots[0][m_tick & (SlotCount - 1)];
+	WheelTimer::Link expired;
+	takeList(list, &expired);
+	m_tick++;
+
+	// The slots of the timeout() signals may start, stop or destroy
+	// any timer, so take the timers one at a time
+	while (expired.next != &expired)
+	{
+		WheelTimer* timer = expired.next->timer;
+		unlink(&timer->m_link);
+		if (timer->m_deadline >= m_tick)
+		{
+			insert(timer);
+			continue;
+		}
+
+		timer->m_wheel = nullptr;
+		m_count--;
+		emit timer->timeout();
+	}
+}
+
+void TimerWheel::timerEvent(QTimerEvent* event)
+{
+	if (event->timerId() != m_timerId)
+		return;
+
+	const qint64 now = m_clock.elapsed() / Resolution;
+	while (m_tick <= now && m_count > 0)
+		processTick();
+
+	if (m_count == 0 && m_timerId != 0)
+	{
+		killTimer(m_timerId);
+		m_timerId = 0;
+	}
+}
+
+
+WheelTimer::WheelTimer(QObject* parent)
+	: QObject(parent),
+	  m_interval(0),
+	  m_resumePending(false),
+	  m_wheel(nullptr),
+	  m_deadline(0),
+	  m_slotTick(0)
+{
+	m_link.prev = &m_link;
+	m_link.next = &m_link;
+	m_link.timer = this;
+}
+
+WheelTimer::~WheelTimer()
+{
+	stop();
+}
+
+int WheelTimer::interval() const
+{
+	return m_interval;
+}
+
+void WheelTimer::setInterval(int msec)
+{
+	m_interval = msec;
+}
+
+bool WheelTimer::isActive() const
+{
+	return m_wheel != nullptr || m_resumePending;
+}
+
+void WheelTimer::start()
+{
+	schedule(m_interval);
+}
+
+void WheelTimer::start(int msec)
+{
+	m_interval = msec;
+	schedule(msec);
+}
+
+void WheelTimer::stop()
+{
+	m_resumePending = false;
+	if (m_wheel != nullptr)
+		m_wheel->remove(this);
+}
+
+void WheelTimer::schedule(int msec)
+{
+	m_resumePending = false;
+	TimerWheel* wheel = TimerWheel::instance();
+	qint64 deadline = wheel->deadline(msec);
+
+	if (m_wheel == wheel)
+	{
+		// A later deadline is noticed when the slot is reached
+		if (deadline >= m_slotTick)
+		{
+			m_deadline = deadline;
+			return;
+		}
+		m_wheel->remove(this);
+	}
+	else if (m_wheel != nullptr)
+		m_wheel->remove(this);
+
+	m_deadline = deadline;
+	wheel->add(this);
+}
+
+bool WheelTimer::event(QEvent* event)
+{
+	// The wheel belongs to the old thread, so restart the timer
+	// in the new thread with the time that was left
+	if (event->type() == QEvent::ThreadChange && m_wheel != nullptr)
+	{
+		int msec = m_wheel->remainingTime(this);
+		m_wheel->remove(this);
+		m_resumePending = true;
+		QMetaObject::invokeMethod(this, "resume", Qt::QueuedConnection,
+					  Q_ARG(int, msec));
+	}
+	return QObject::event(event);
+}
+
+void WheelTimer::resume(int msec)
+{
+	if (m_resumePending)
+		schedule(msec);
+}
@@ -0,0 +1,101 @@
+/*
+    This file is part of Cute Chess.
+    Copyright (C) 2008-2018 Cute Chess authors
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QObject>
+class TimerWheel;
+
+/*!
+ * \brief A coarse single-shot timer for timeouts
+ *
+ * WheelTimer has the same interface as a single-shot QTimer, but it
+ * doesn't register a timer with the event dispatcher. All WheelTimers
+ * of a thread share a hierarchical timer wheel that is driven by one
+ * Qt timer, which only runs while some WheelTimer is active.
+ *
+ * Starting, restarting and stopping a timer take constant time, and
+ * restarting an active timer with a later deadline only updates the
+ * deadline. This makes WheelTimer suitable for timeouts that are reset
+ * very often, eg. on every line of engine output.
+ *
+ * The timer has a resolution of 50 milliseconds. The timeout() signal
+ * is never sent early, but it may be late by up to one tick, so
+ * precise deadlines like flag fall should use QTimer instead.
+ *
+ * Like QTimer, a WheelTimer can only be used from its own thread. An
+ * active timer moved to another thread keeps running there.
+ */
+class LIB_EXPORT WheelTimer : public QObject
+{
+	Q_OBJECT
+
+	public:
+		/*! Creates a new inactive timer. */
+		explicit WheelTimer(QObject* parent = nullptr);
+		/*! Stops and destroys the timer. */
+		virtual ~WheelTimer();
+
+		/*! Returns the timeout interval in milliseconds. */
+		int interval() const;
+		/*! Sets the timeout interval to \a msec milliseconds. */
+		void setInterval(int msec);
+		/*! Returns true if the timer is running. */
+		bool isActive() const;
+
+	public slots:
+		/*! Starts or restarts the timer with interval(). */
+		void start();
+		/*! Starts or restarts the timer with a \a msec interval. */
+		void start(int msec);
+		/*! Stops the timer. */
+		void stop();
+
+	signals:
+		/*! The timer expired. */
+		void timeout();
+
+	protected:
+		// Inherited from QObject
+		virtual bool event(QEvent* event);
+
+	private slots:
+		void resume(int msec);
+
+	private:
+		friend class TimerWheel;
+
+		struct Link
+		{
+			Link* prev;
+			Link* next;
+			WheelTimer* timer;
+		};
+
+		void schedule(int msec);
+
+		int m_interval;
+		bool m_resumePending;
+		TimerWheel* m_wheel;
+		Link m_link;
+		qint64 m_deadline;
+		qint64 m_slotTick;
+};
+
+#endif // TIMERWHEEL_H
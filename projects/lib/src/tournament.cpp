@@ -18,6 +18,8 @@
 
 #include "tournament.h"
 #include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
 #include <QMultiMap>
 #include <QSet>
 #include "gamemanager.h"
@@ -27,9 +29,92 @@
 #include "chessgame.h"
 #include "pgnstream.h"
 #include "openingsuite.h"
+#include "openingpool.h"
 #include "openingbook.h"
 #include "sprt.h"
+#include "resultaggregator.h"
+#include "memoryaccount.h"
+#include "tracelog.h"
+#include "gamesinks.h"
 #include "elo.h"
+#include "mersenne.h"
+
+namespace {
+
+// The number of moves a player makes in a typical game
+const int TypicalMoveCount = 60;
+
+// The number of tournament pairs allocated at a time
+const int PairBlockSize = 256;
+
+// Returns a rough estimate of the time a player with time
+// control \a tc uses in a game, in milliseconds
+qint64 expectedTime(const TimeControl& tc)
+{
+	if (tc.isInfinite())
+		return 0;
+	if (tc.timePerMove() > 0)
+		return qint64(tc.timePerMove()) * TypicalMoveCount;
+
+	qint64 time = tc.timePerTc();
+	if (tc.movesPerTc() > 0)
+		time = time * TypicalMoveCount / tc.movesPerTc();
+	return time + qint64(tc.timeIncrement()) * TypicalMoveCount;
+}
+
+// The first bytes of a checkpoint file
+const char CheckpointMagic[] = "CCCHECK1";
+const int CheckpointMagicSize = 8;
+
+// Result codes of the checkpoint records
+enum CheckpointResult
+{
+	WhiteWins,
+	BlackWins,
+	Drawn,
+	Unfinished
+};
+
+qint8 checkpointResult(const Chess::Result& result)
+{
+	if (result.winner() == Chess::Side::White)
+		return WhiteWins;
+	if (result.winner() == Chess::Side::Black)
+		return BlackWins;
+	if (result.isDraw())
+		return Drawn;
+	return Unfinished;
+}
+
+Chess::Result fromCheckpointResult(qint8 code)
+{
+	switch (code)
+	{
+	case WhiteWins:
+		return Chess::Result(Chess::Result::Win, Chess::Side::White);
+	case BlackWins:
+		return Chess::Result(Chess::Result::Win, Chess::Side::Black);
+	case Drawn:
+		return Chess::Result(Chess::Result::Draw);
+	default:
+		return Chess::Result();
+	}
+}
+
+// Returns the name of PGN output shard \a shard, eg. "games.2.pgn.gz"
+// for shard 2 of "games.pgn.gz"
+QString shardFileName(const QString& fileName, int shard)
+{
+	const QFileInfo info(fileName);
+	QString name(fileName.left(fileName.size() - info.fileName().size()));
+	name += info.baseName() + "." + QString::number(shard);
+	if (!info.completeSuffix().isEmpty())
+		name += "." + info.completeSuffix();
+
+	return name;
+}
+
+} // anonymous namespace
 
 Tournament::Tournament(GameManager* gameManager, QObject *parent)
 	: QObject(parent),
@@ -46,6 +131,7 @@ Tournament::Tournament(GameManager* gameManager, QObject *parent)
 	  m_roundMultiplier(1),
 	  m_startDelay(0),
 	  m_openingDepth(1024),
+	  m_randomOpeningPlies(0),
 	  m_seedCount(0),
 	  m_stopping(false),
 	  m_openingRepetitions(1),
@@ -55,14 +141,29 @@ Tournament::Tournament(GameManager* gameManager, QObject *parent)
 	  m_pgnWriteUnfinishedGames(true),
 	  m_finished(false),
 	  m_bookOwnership(false),
+	  m_externalScheduling(false),
+	  m_remoteGames(false),
+	  m_lookahead(0),
 	  m_openingSuite(nullptr),
+	  m_openingPool(nullptr),
 	  m_sprt(new Sprt),
+	  m_results(nullptr),
+	  m_resume(false),
 	  m_repetitionCounter(0),
+	  m_openingNumber(0),
 	  m_swapSides(true),
 	  m_pgnOutMode(PgnGame::Verbose),
-	  m_pair(nullptr)
+	  m_pgnBacklogLimit(1024),
+	  m_pgnShardCount(1),
+	  m_engineLogSize(0),
+	  m_pair(nullptr),
+	  m_pairCount(0),
+	  m_output(new OutputQueue(256))
 {
 	Q_ASSERT(gameManager != nullptr);
+
+	// The games released by one finished game are written at once
+	m_pgnWriter.setBatchSize(INT_MAX);
 }
 
 Tournament::~Tournament()
@@ -71,7 +172,10 @@ Tournament::~Tournament()
 		qWarning("Tournament: Destroyed while games are still running.");
 
 	qDeleteAll(m_gameData);
-	qDeleteAll(m_pairs);
+	qDeleteAll(m_remoteGameData);
+	discardPreparedGames();
+	for (TournamentPair* block : qAsConst(m_pairBlocks))
+		delete[] block;
 
 	QSet<const OpeningBook*> books;
 	for (const TournamentPlayer& player : qAsConst(m_players))
@@ -83,14 +187,28 @@ Tournament::~Tournament()
 	if (m_bookOwnership)
 		qDeleteAll(books);
 
+	// The pool's thread must stop using the suite first
+	delete m_openingPool;
 	delete m_openingSuite;
 	delete m_sprt;
+	delete m_results;
+	clearPgnGames();
+
+	// The output threads finish their writes first. The shards
+	// post their checkpoints to the main output thread.
+	qDeleteAll(m_pgnShards);
+	delete m_output;
+	for (const SinkQueue& sink : qAsConst(m_sinks))
+	{
+		delete sink.queue;
+		delete sink.sink;
+	}
 
 	if (m_pgnFile.isOpen())
 		m_pgnFile.close();
 
-	if (m_epdFile.isOpen())
-		m_epdFile.close();
+	if (m_checkpointFile.isOpen())
+		m_checkpointFile.close();
 }
 
 GameManager* Tournament::gameManager() const
@@ -143,11 +261,27 @@ int Tournament::finishedGameCount() const
 	return m_finishedGameCount;
 }
 
+int Tournament::activeGameCount() const
+{
+	return m_gameData.size() + m_remoteGameData.size();
+}
+
 int Tournament::finalGameCount() const
 {
 	return m_finalGameCount;
 }
 
+int Tournament::openingCount() const
+{
+	// The other policies use at most one opening per encounter
+	const int encounters = gamesPerCycle() * roundMultiplier();
+	if (m_openingPolicy != DefaultPolicy)
+		return encounters;
+
+	const int games = encounters * gamesPerEncounter();
+	return (games + m_openingRepetitions - 1) / m_openingRepetitions;
+}
+
 const TournamentPlayer& Tournament::playerAt(int index) const
 {
 	return m_players.at(index);
@@ -168,6 +302,26 @@ Sprt* Tournament::sprt() const
 	return m_sprt;
 }
 
+const ResultAggregator* Tournament::resultAggregator() const
+{
+	return m_results;
+}
+
+const GameAdjudicator& Tournament::adjudicator() const
+{
+	return m_adjudicator;
+}
+
+const RatingModel& Tournament::ratingModel() const
+{
+	return m_ratings;
+}
+
+OutputQueue::Statistics Tournament::outputStatistics() const
+{
+	return m_output->statistics();
+}
+
 bool Tournament::canSetRoundMultiplier() const
 {
 	return true;
@@ -185,7 +339,7 @@ void Tournament::setSite(const QString& site)
 
 void Tournament::setVariant(const QString& variant)
 {
-	Q_ASSERT(Chess::BoardFactory::variants().contains(variant));
+	Q_ASSERT(Chess::BoardFactory::isVariant(variant));
 	m_variant = variant;
 }
 
@@ -231,6 +385,8 @@ void Tournament::setAdjudicator(const GameAdjudicator& adjudicator)
 
 void Tournament::setOpeningSuite(OpeningSuite *suite)
 {
+	delete m_openingPool;
+	m_openingPool = nullptr;
 	delete m_openingSuite;
 	m_openingSuite = suite;
 }
@@ -240,11 +396,37 @@ void Tournament::setOpeningDepth(int plies)
 	m_openingDepth = plies;
 }
 
+void Tournament::setRandomOpeningPlies(int plies)
+{
+	m_randomOpeningPlies = plies;
+}
+
 void Tournament::setSeedCount(int seedCount)
 {
 	m_seedCount = seedCount;
 }
 
+void Tournament::setExternalScheduling(bool enabled)
+{
+	m_externalScheduling = enabled;
+}
+
+void Tournament::setRemoteGames(bool enabled)
+{
+	m_remoteGames = enabled;
+}
+
+bool Tournament::canReorderGames() const
+{
+	return false;
+}
+
+void Tournament::setLookahead(int games)
+{
+	Q_ASSERT(games >= 0);
+	m_lookahead = games;
+}
+
 void Tournament::setPgnOutput(const QString& fileName, PgnGame::PgnMode mode)
 {
 	if (fileName != m_pgnFile.fileName())
@@ -260,6 +442,28 @@ void Tournament::setPgnWriteUnfinishedGames(bool enabled)
 	m_pgnWriteUnfinishedGames = enabled;
 }
 
+void Tournament::setPgnSyncInterval(int games)
+{
+	m_pgnWriter.setSyncInterval(games);
+}
+
+void Tournament::setPgnBacklogLimit(int games)
+{
+	Q_ASSERT(games >= 0);
+	m_pgnBacklogLimit = games;
+}
+
+void Tournament::setPgnCompressionLevel(int level)
+{
+	m_pgnFile.setCompressionLevel(level);
+}
+
+void Tournament::setPgnShardCount(int shards)
+{
+	Q_ASSERT(shards >= 1);
+	m_pgnShardCount = shards;
+}
+
 void Tournament::setPgnCleanupEnabled(bool enabled)
 {
 	m_pgnCleanup = enabled;
@@ -267,11 +471,79 @@ void Tournament::setPgnCleanupEnabled(bool enabled)
 
 void Tournament::setEpdOutput(const QString& fileName)
 {
-	if (fileName != m_epdFile.fileName())
+	if (fileName.isEmpty())
+		removeGameSink("EPD");
+	else
+		addGameSink(new EpdSink(fileName));
+}
+
+void Tournament::setCompactOutput(const QString& fileName)
+{
+	if (fileName.isEmpty())
+		removeGameSink("compact game");
+	else
+		addGameSink(new CompactGameSink(fileName));
+}
+
+void Tournament::setTrainingOutput(const QString& fileName,
+				   const TrainingDataWriter::Filter& filter)
+{
+	if (fileName.isEmpty())
+		removeGameSink("training data");
+	else
+		addGameSink(new TrainingDataSink(fileName, filter));
+}
+
+void Tournament::setEngineLogOutput(const QString& directory,
+				    const QString& suffix,
+				    int bufferSize)
+{
+	Q_ASSERT(bufferSize > 0);
+
+	if (directory.isEmpty())
 	{
-		m_epdFile.close();
-		m_epdFile.setFileName(fileName);
+		removeGameSink("engine log");
+		m_engineLogSize = 0;
 	}
+	else
+	{
+		addGameSink(new EngineLogSink(directory, suffix));
+		m_engineLogSize = bufferSize;
+	}
+}
+
+void Tournament::addGameSink(GameSink* sink)
+{
+	Q_ASSERT(sink != nullptr);
+
+	removeGameSink(sink->name());
+	const SinkQueue entry = { sink, new OutputQueue(256) };
+	m_sinks.append(entry);
+}
+
+void Tournament::removeGameSink(const QString& name)
+{
+	for (int i = 0; i < m_sinks.size(); i++)
+	{
+		const SinkQueue entry(m_sinks.at(i));
+		if (entry.sink->name() != name)
+			continue;
+
+		delete entry.queue;
+		delete entry.sink;
+		m_sinks.removeAt(i);
+		return;
+	}
+}
+
+void Tournament::setCheckpointFile(const QString& fileName)
+{
+	m_checkpointFile.setFileName(fileName);
+}
+
+void Tournament::setResumeEnabled(bool enabled)
+{
+	m_resume = enabled;
 }
 
 void Tournament::setOpeningRepetitions(int count)
@@ -310,24 +582,71 @@ TournamentPair* Tournament::currentPair() const
 	return m_pair;
 }
 
+TournamentPair* Tournament::pairAt(int index) const
+{
+	return m_pairBlocks.at(index / PairBlockSize) + index % PairBlockSize;
+}
+
+int* Tournament::pairIndex(int player1, int player2)
+{
+	Q_ASSERT(player1 != player2);
+
+	const int low = qMin(player1, player2);
+	const int high = qMax(player1, player2);
+	const int n = m_players.size();
+
+	// Rebuild the matrix if players were added after the first pair
+	if (m_pairIndexes.size() != n * (n - 1) / 2)
+	{
+		m_pairIndexes.fill(-1, n * (n - 1) / 2);
+		for (int i = 0; i < m_pairCount; i++)
+		{
+			const TournamentPair* pair = pairAt(i);
+			if (pair->isValid())
+				*pairIndex(pair->firstPlayer(),
+					   pair->secondPlayer()) = i;
+		}
+	}
+
+	return &m_pairIndexes[high * (high - 1) / 2 + low];
+}
+
 TournamentPair* Tournament::pair(int player1, int player2)
 {
 	Q_ASSERT(player1 || player2);
 
-	const QPair<int,int> pairs[] = {
-		qMakePair(player1, player2),
-		qMakePair(player2, player1)
-	};
-
-	for (const auto& p: pairs)
+	// Pairs with a BYE player are few, so they're searched linearly
+	int* index = nullptr;
+	if (player1 >= 0 && player2 >= 0)
+	{
+		index = pairIndex(player1, player2);
+		if (*index != -1)
+			return pairAt(*index);
+	}
+	else
 	{
-		if (m_pairs.contains(p))
-			return m_pairs[p];
+		for (int i : qAsConst(m_byePairs))
+		{
+			TournamentPair* pair = pairAt(i);
+			if ((pair->firstPlayer() == player1
+			&&   pair->secondPlayer() == player2)
+			||  (pair->firstPlayer() == player2
+			&&   pair->secondPlayer() == player1))
+				return pair;
+		}
 	}
 
 	// Existing pair not found -> create a new one
-	auto ret = new TournamentPair(player1, player2);
-	m_pairs[pairs[0]] = ret;
+	if (m_pairCount == m_pairBlocks.size() * PairBlockSize)
+		m_pairBlocks.append(new TournamentPair[PairBlockSize]);
+
+	const int newIndex = m_pairCount++;
+	TournamentPair* ret = pairAt(newIndex);
+	*ret = TournamentPair(player1, player2);
+	if (index != nullptr)
+		*index = newIndex;
+	else
+		m_byePairs.append(newIndex);
 
 	return ret;
 }
@@ -343,6 +662,12 @@ bool Tournament::hasGauntletRatingsOrder() const
 }
 
 void Tournament::startGame(TournamentPair* pair)
+{
+	const PreparedGame prepared(prepareGame(pair));
+	playGame(prepared.game, prepared.data);
+}
+
+Tournament::PreparedGame Tournament::prepareGame(TournamentPair* pair)
 {
 	Q_ASSERT(pair->isValid());
 	m_pair = pair;
@@ -355,51 +680,76 @@ void Tournament::startGame(TournamentPair* pair)
 	Q_ASSERT(board != nullptr);
 	ChessGame* game = new ChessGame(board, new PgnGame());
 
+	// The game's random choices depend only on the seed and the
+	// game number, not on the other games
+	game->setRandomStream(RandomStream(Mersenne::seed(),
+					   quint64(m_nextGameNumber + 1)));
+
 	connect(game, SIGNAL(started(ChessGame*)),
 		this, SLOT(onGameStarted(ChessGame*)));
 	connect(game, SIGNAL(finished(ChessGame*)),
 		this, SLOT(onGameFinished(ChessGame*)));
 
+	game->setEngineLogLimit(m_engineLogSize);
 	game->setTimeControl(white.timeControl(), Chess::Side::White);
 	game->setTimeControl(black.timeControl(), Chess::Side::Black);
 
 	game->setOpeningBook(white.book(), Chess::Side::White, white.bookDepth());
 	game->setOpeningBook(black.book(), Chess::Side::Black, black.bookDepth());
 
-	if (!m_startFen.isEmpty() || !m_openingMoves.isEmpty())
+	const qint64 openingStart = TraceLog::isEnabled() ? TraceLog::timestamp() : -1;
+	// A repeated opening is shared with the earlier game, so it
+	// doesn't have to be replayed and formatted again
+	const bool repeated = !m_opening.isNull();
+	if (repeated)
 	{
-		game->setStartingFen(m_startFen);
-		game->setMoves(m_openingMoves);
-		m_startFen.clear();
-		m_openingMoves.clear();
+		game->setOpening(m_opening);
+		m_opening.clear();
 		m_repetitionCounter++;
 	}
 	else
 	{
 		m_repetitionCounter = 1;
-		if (m_openingSuite != nullptr)
+		if (m_openingPool != nullptr)
 		{
-			if (!game->setMoves(m_openingSuite->nextGame(m_openingDepth)))
+			const OpeningPool::Opening opening(m_openingPool->take());
+			m_openingNumber = opening.number;
+			bool ok = opening.isValid;
+			if (opening.isValidated)
+			{
+				game->setStartingFen(opening.fen);
+				game->setMoves(opening.moves);
+			}
+			else
+				ok = game->setMoves(opening.game);
+
+			if (!ok)
 				qWarning("The opening suite is incompatible with the "
 				"current chess variant");
 		}
 	}
 
-	game->generateOpening();
+	// The books can only add moves to a repeated opening if the
+	// players use different books
+	if (!repeated
+	||  white.book() != black.book()
+	||  white.bookDepth() != black.bookDepth())
+		game->generateOpening();
+	if (m_repetitionCounter == 1)
+		game->generateRandomMoves(m_randomOpeningPlies);
 	if (m_repetitionCounter < m_openingRepetitions)
-	{
-		m_startFen = game->startingFen();
-		if (m_startFen.isEmpty() && board->isRandomVariant())
-		{
-			m_startFen = board->defaultFenString();
-			game->setStartingFen(m_startFen);
-		}
-		m_openingMoves = game->moves();
-	}
+		m_opening = game->sharedOpening();
+	if (openingStart >= 0)
+		TraceLog::addEventSince("opening", "Opening", openingStart);
 
 	game->pgn()->setEvent(m_name);
 	game->pgn()->setSite(m_site);
 	game->pgn()->setRound(m_round);
+	// Streamed openings can't be found again by their position in
+	// a file, so the games record their number in the stream
+	if (m_openingNumber > 0)
+		game->pgn()->setTag("OpeningNumber",
+				    QString::number(m_openingNumber));
 
 	if (m_finishedGameCount > 0)
 		game->setStartDelay(m_startDelay);
@@ -409,7 +759,9 @@ void Tournament::startGame(TournamentPair* pair)
 	data->number = ++m_nextGameNumber;
 	data->whiteIndex = m_pair->firstPlayer();
 	data->blackIndex = m_pair->secondPlayer();
-	m_gameData[game] = data;
+	data->pair = m_pair;
+	data->pairGame = m_pair->gamesStarted() - 1;
+	data->startTime = 0;
 
 	// Some tournament types may require more games than expected
 	if (m_nextGameNumber > m_finalGameCount)
@@ -420,8 +772,33 @@ void Tournament::startGame(TournamentPair* pair)
 	if (m_swapSides)
 		m_pair->swapPlayers();
 
-	auto whiteBuilder = white.builder();
-	auto blackBuilder = black.builder();
+	PreparedGame prepared;
+	prepared.game = game;
+	prepared.data = data;
+	return prepared;
+}
+
+void Tournament::playGame(ChessGame* game, GameData* data)
+{
+	if (m_remoteGames)
+	{
+		data->startTime = m_clock.elapsed();
+		m_remoteGameData[data->number] = data;
+		dispatchGame(game, data);
+		return;
+	}
+	m_gameData[game] = data;
+
+	// The result is counted right away in the game's thread
+	const int whiteIndex = data->whiteIndex;
+	const int blackIndex = data->blackIndex;
+	connect(game, &ChessGame::finished, game, [=](ChessGame* game)
+	{
+		publishResult(whiteIndex, blackIndex, game->result());
+	}, Qt::DirectConnection);
+
+	auto whiteBuilder = m_players[data->whiteIndex].builder();
+	auto blackBuilder = m_players[data->blackIndex].builder();
 	onGameAboutToStart(game, whiteBuilder, blackBuilder);
 	connect(game, SIGNAL(startFailed(ChessGame*)),
 		this, SLOT(onGameStartFailed(ChessGame*)));
@@ -432,6 +809,33 @@ void Tournament::startGame(TournamentPair* pair)
 			       GameManager::ReusePlayers);
 }
 
+void Tournament::dispatchGame(ChessGame* game, const GameData* data)
+{
+	QString fen(game->startingFen());
+	Chess::Board* board = game->board();
+	if (fen.isEmpty() && board->isRandomVariant())
+		fen = board->defaultFenString();
+	board->setFenString(fen.isEmpty() ? board->defaultFenString() : fen);
+
+	// The moves are sent in coordinate notation because it doesn't
+	// depend on the rest of the position like SAN does
+	QStringList moves;
+	for (const Chess::Move& move : game->moves())
+	{
+		moves << board->moveString(move, Chess::Board::LongAlgebraic);
+		board->makeMove(move);
+	}
+
+	delete game->pgn();
+	delete game;
+
+	emit gameDispatched(data->number,
+			    data->whiteIndex,
+			    data->blackIndex,
+			    fen,
+			    moves);
+}
+
 void Tournament::onGameAboutToStart(ChessGame *game,
 				    const PlayerBuilder* white,
 				    const PlayerBuilder* black)
@@ -449,25 +853,98 @@ int Tournament::playerIndex(ChessGame* game, Chess::Side side) const
 
 void Tournament::startNextGame()
 {
-	if (m_stopping)
-		return;
+	startNextGames(1);
+}
 
-	TournamentPair* pair(nextPair(m_nextGameNumber));
-	if (!pair || !pair->isValid())
+void Tournament::startNextGames(int count)
+{
+	if (m_stopping || count <= 0)
 		return;
 
-	if ((!pair->hasSamePlayers(m_pair) && m_players.size() > 2
-	     && m_openingPolicy != OpeningPolicy::RoundPolicy)
-	|| (m_round > m_oldRound
-	     && m_openingPolicy == OpeningPolicy::RoundPolicy))
+	// The games are prepared in pairing order so that they get the
+	// same openings and colors as without looking ahead
+	const int lookahead = canReorderGames() ? m_lookahead : 0;
+	bool restored = false;
+	while (m_preparedGames.size() < count + lookahead)
 	{
-		m_startFen.clear();
-		m_openingMoves.clear();
-		m_repetitionCounter = 1;
-		m_oldRound = m_round;
+		TournamentPair* pair(nextPair(m_nextGameNumber));
+		if (!pair || !pair->isValid())
+			break;
+
+		if ((!pair->hasSamePlayers(m_pair) && m_players.size() > 2
+		     && m_openingPolicy != OpeningPolicy::RoundPolicy)
+		|| (m_round > m_oldRound
+		     && m_openingPolicy == OpeningPolicy::RoundPolicy))
+		{
+			m_opening.clear();
+			m_repetitionCounter = 1;
+			m_oldRound = m_round;
+		}
+
+		const PreparedGame prepared(prepareGame(pair));
+		if (restoreGame(prepared))
+		{
+			restored = true;
+			continue;
+		}
+		m_preparedGames.append(prepared);
 	}
 
-	startGame(pair);
+	// Start the longest games first so that the short ones fill
+	// the free slots at the end of the tournament
+	QList<PreparedGame> batch;
+	while (batch.size() < count && !m_preparedGames.isEmpty())
+	{
+		int next = 0;
+		qint64 longest = expectedGameTime(m_preparedGames.first().data);
+		for (int i = 1; i < m_preparedGames.size(); i++)
+		{
+			const qint64 time = expectedGameTime(m_preparedGames.at(i).data);
+			if (time > longest)
+			{
+				longest = time;
+				next = i;
+			}
+		}
+		batch.append(m_preparedGames.takeAt(next));
+	}
+
+	for (const PreparedGame& prepared : qAsConst(batch))
+		playGame(prepared.game, prepared.data);
+
+	// All of the remaining games were finished before resuming
+	if (restored && !m_finished && batch.isEmpty()
+	&&  m_gameData.isEmpty() && m_remoteGameData.isEmpty()
+	&&  areAllGamesFinished())
+		onFinished();
+}
+
+qint64 Tournament::expectedGameTime(const GameData* data) const
+{
+	qint64 total = 0;
+	for (int index : {data->whiteIndex, data->blackIndex})
+	{
+		// The player's finished games are a better estimate than
+		// the time control. Each game is shared by two players.
+		const GameTime& history = m_gameTimes.at(index);
+		if (history.count > 0)
+			total += history.total / history.count / 2;
+		else
+			total += expectedTime(m_players.at(index).timeControl());
+	}
+
+	return total;
+}
+
+void Tournament::discardPreparedGames()
+{
+	for (const PreparedGame& prepared : qAsConst(m_preparedGames))
+	{
+		delete prepared.game->pgn();
+		delete prepared.game;
+		delete prepared.data;
+	}
+	m_preparedGames.clear();
 }
 
 inline bool faulty(const Chess::Result::Type& type)
@@ -478,7 +955,46 @@ inline bool faulty(const Chess::Result::Type& type)
 	    || type == Chess::Result::StalledConnection;
 }
 
-bool Tournament::writePgn(PgnGame* pgn, int gameNumber)
+bool Tournament::writePendingPgn(int gameNumber,
+				 const PendingPgn& pgn,
+				 PgnBatch* batch)
+{
+	Chess::Result::Type type = pgn.result.type();
+	if (!m_pgnWriteUnfinishedGames
+	&&  (pgn.result.isNone() || (m_stopping && faulty(type))))
+	{
+		qWarning("Omitted incomplete game %d", gameNumber);
+		return true;
+	}
+	if (pgn.data.isEmpty())
+	{
+		qWarning("Could not write PGN game %d", gameNumber);
+		return false;
+	}
+
+	batch->games.append(pgn.data);
+	if (m_checkpointFile.isOpen())
+	{
+		CheckpointGame game = { gameNumber, pgn.whiteIndex,
+					pgn.blackIndex, pgn.result };
+		batch->checkpoints.append(game);
+	}
+	return true;
+}
+
+void Tournament::clearPgnGames()
+{
+	qint64 bytes = 0;
+	for (const PendingPgn& pgn : qAsConst(m_pgnGames))
+		bytes += pgn.data.size();
+	MemoryAccount::add(MemoryAccount::PgnBuffer, -bytes);
+	m_pgnGames.clear();
+}
+
+bool Tournament::writePgn(PgnGame* pgn,
+			  int gameNumber,
+			  int whiteIndex,
+			  int blackIndex)
 {
 	Q_ASSERT(pgn != nullptr);
 	Q_ASSERT(gameNumber > 0);
@@ -486,85 +1002,171 @@ bool Tournament::writePgn(PgnGame* pgn, int gameNumber)
 	if (m_pgnFile.fileName().isEmpty())
 		return true;
 
-	bool isOpen = m_pgnFile.isOpen();
-	if (!isOpen || !m_pgnFile.exists())
+	// Games saved as they finish can be sorted by their number
+	if (m_pgnBacklogLimit == 0 || !m_pgnShards.isEmpty())
+		pgn->setTag(PgnGame::GameNumberTag, QString::number(gameNumber));
+
+	// The shards aren't kept in order, they're merged later
+	if (!m_pgnShards.isEmpty())
 	{
-		if (isOpen)
+		PendingPgn pending;
+		pending.result = pgn->result();
+		pending.whiteIndex = whiteIndex;
+		pending.blackIndex = blackIndex;
 		{
-			qWarning("PGN file %s does not exist. Reopening...",
-				 qUtf8Printable(m_pgnFile.fileName()));
-			m_pgnFile.close();
+			TraceLog::Scope scope("pgn", "PGN formatting");
+			pgn->write(&pending.data, m_pgnOutMode);
 		}
 
-		if (!m_pgnFile.open(QIODevice::WriteOnly | QIODevice::Append))
+		PgnBatch batch;
+		const bool ok = writePendingPgn(gameNumber, pending, &batch);
+		if (!batch.games.isEmpty())
 		{
-			qWarning("Could not open PGN file %s",
-				 qUtf8Printable(m_pgnFile.fileName()));
-			return false;
+			PgnShard* shard = m_pgnShards.at((gameNumber - 1) % m_pgnShards.size());
+			shard->queue.post([=]() { savePgnShard(shard, batch); });
 		}
-		m_pgnOut.setDevice(&m_pgnFile);
+		return ok;
+	}
+
+	// The game is formatted right away, so the games that wait
+	// for an earlier game to finish take little memory
+	PendingPgn& pending = m_pgnGames[gameNumber];
+	pending.result = pgn->result();
+	pending.whiteIndex = whiteIndex;
+	pending.blackIndex = blackIndex;
+	{
+		TraceLog::Scope scope("pgn", "PGN formatting");
+		pgn->write(&pending.data, m_pgnOutMode);
 	}
+	MemoryAccount::add(MemoryAccount::PgnBuffer, pending.data.size());
 
 	bool ok = true;
-	m_pgnGames[gameNumber] = *pgn;
-	while (m_pgnGames.contains(m_savedGameCount + 1))
+	PgnBatch batch;
+	for (;;)
 	{
-		PgnGame tmp = m_pgnGames.take(++m_savedGameCount);
-		Chess::Result::Type type = tmp.result().type();
-		if (!m_pgnWriteUnfinishedGames
-		&&  (tmp.result().isNone() || (m_stopping && faulty(type))))
+		int next = m_savedGameCount + 1;
+		if (m_pgnWrittenAhead.remove(next))
 		{
-			qWarning("Omitted incomplete game %d", m_savedGameCount);
+			m_savedGameCount++;
 			continue;
 		}
-		if (!tmp.write(m_pgnOut, m_pgnOutMode)
-		||  m_pgnFile.error() != QFile::NoError)
+
+		auto it = m_pgnGames.find(next);
+		if (it == m_pgnGames.end())
+			break;
+
+		m_savedGameCount++;
+		ok = writePendingPgn(next, it.value(), &batch) && ok;
+		MemoryAccount::add(MemoryAccount::PgnBuffer, -it->data.size());
+		m_pgnGames.erase(it);
+	}
+
+	// Don't let one long game hold back an unbounded number
+	// of finished games, or more than the memory budget allows
+	if (m_pgnGames.size() > m_pgnBacklogLimit
+	||  (!m_pgnGames.isEmpty() && MemoryAccount::exceedsBudget()))
+	{
+		if (m_pgnBacklogLimit > 0)
+			qWarning("Game %d is still running, saving later games out of order",
+				 m_savedGameCount + 1);
+		for (auto it = m_pgnGames.constBegin(); it != m_pgnGames.constEnd(); ++it)
 		{
-			ok = false;
-			qWarning("Could not write PGN game %d", m_savedGameCount);
+			ok = writePendingPgn(it.key(), it.value(), &batch) && ok;
+			m_pgnWrittenAhead.insert(it.key());
 		}
+		clearPgnGames();
 	}
 
+	if (!batch.games.isEmpty())
+		m_output->post([=]() { savePgn(batch); });
+
 	return ok;
 }
 
-bool Tournament::writeEpd(ChessGame *game)
+bool Tournament::writePgnFile(CompressedFile* file,
+			      PgnWriter* writer,
+			      const QVector<QByteArray>& games)
 {
-	Q_ASSERT(game != nullptr);
-
-	if (m_epdFile.fileName().isEmpty())
-		return true;
-
-	bool isOpen = m_epdFile.isOpen();
-	if (!isOpen || !m_epdFile.exists())
+	bool isOpen = file->isOpen();
+	if (!isOpen || !file->exists())
 	{
 		if (isOpen)
 		{
-			qWarning("EPD file %s does not exist. Reopening...",
-				 qUtf8Printable(m_epdFile.fileName()));
-			m_epdFile.close();
+			qWarning("PGN file %s does not exist. Reopening...",
+				 qUtf8Printable(file->fileName()));
+			file->close();
 		}
 
-		if (!m_epdFile.open(QIODevice::WriteOnly | QIODevice::Append))
+		if (!file->open(QIODevice::WriteOnly | QIODevice::Append))
 		{
-			qWarning("Could not open EPD file %s",
-				 qUtf8Printable(m_epdFile.fileName()));
+			qWarning("Could not open PGN file %s",
+				 qUtf8Printable(file->fileName()));
 			return false;
 		}
-		m_epdOut.setDevice(&m_epdFile);
+		writer->setDevice(file);
 	}
 
-	const QString& epdPos = game->board()->fenString();
-	m_epdOut << epdPos << "\n";
-	m_epdOut.flush();
 	bool ok = true;
-	if (m_epdFile.error() != QFile::NoError)
+	for (const QByteArray& data : games)
+		ok = writer->writeFormatted(data) && ok;
+
+	if (!writer->flush() || !ok || file->error() != QFile::NoError)
 	{
-		ok = false;
-		qWarning("Could not write EPD position");
+		qWarning("Could not write to PGN file %s",
+			 qUtf8Printable(file->fileName()));
+		return false;
 	}
+	return true;
+}
 
-	return ok;
+void Tournament::savePgn(const PgnBatch& batch)
+{
+	TraceLog::Scope scope("pgn", "PGN write");
+	if (writePgnFile(&m_pgnFile, &m_pgnWriter, batch.games)
+	&&  !batch.checkpoints.isEmpty())
+		saveCheckpoint(batch.checkpoints,
+			       QFileInfo(m_pgnFile.fileName()).size());
+}
+
+void Tournament::savePgnShard(PgnShard* shard, const PgnBatch& batch)
+{
+	TraceLog::Scope scope("pgn", "PGN write");
+	if (!writePgnFile(&shard->file, &shard->writer, batch.games)
+	||  batch.checkpoints.isEmpty())
+		return;
+
+	// A shard can't be truncated to the checkpoint, so the games
+	// saved after it are saved again and dropped by PgnMerger
+	const QVector<CheckpointGame> games(batch.checkpoints);
+	m_output->post([=]() { saveCheckpoint(games, -1); });
+}
+
+void Tournament::publishGame(ChessGame* game, int gameNumber)
+{
+	Q_ASSERT(game != nullptr);
+
+	if (m_sinks.isEmpty())
+		return;
+
+	// One record is shared by all sinks
+	GameRecord* record = new GameRecord;
+	record->number = gameNumber;
+	record->pgn = *game->pgn();
+	record->evaluations = game->evaluations();
+	record->endFen = game->board()->fenString();
+	record->result = game->result();
+	record->engineLog = game->engineLog();
+	const SharedGameRecord shared(record);
+
+	for (const SinkQueue& entry : qAsConst(m_sinks))
+	{
+		GameSink* sink = entry.sink;
+		entry.queue->post([=]()
+		{
+			if (!sink->write(*shared))
+				qWarning("%s", qUtf8Printable(sink->errorString()));
+		});
+	}
 }
 
 void Tournament::addScore(int player, int score)
@@ -578,6 +1180,7 @@ void Tournament::onGameStarted(ChessGame* game)
 	Q_ASSERT(m_gameData.contains(game));
 
 	GameData* data = m_gameData[game];
+	data->startTime = m_clock.elapsed();
 	int iWhite = data->whiteIndex;
 	int iBlack = data->blackIndex;
 	m_players[iWhite].setName(game->player(Chess::Side::White)->name());
@@ -586,21 +1189,19 @@ void Tournament::onGameStarted(ChessGame* game)
 	emit gameStarted(game, data->number, iWhite, iBlack);
 }
 
-void Tournament::onGameFinished(ChessGame* game)
+void Tournament::addGameResult(const GameData* data,
+				PgnGame* pgn,
+				const Chess::Result& result)
 {
-	Q_ASSERT(game != nullptr);
-
-	PgnGame* pgn(game->pgn());
-
-	m_finishedGameCount++;
+	const int iWhite = data->whiteIndex;
+	const int iBlack = data->blackIndex;
 
-	Q_ASSERT(m_gameData.contains(game));
-	GameData* data = m_gameData.take(game);
-	int gameNumber = data->number;
-	Sprt::GameResult sprtResult = Sprt::NoResult;
-
-	int iWhite = data->whiteIndex;
-	int iBlack = data->blackIndex;
+	const qint64 duration = m_clock.elapsed() - data->startTime;
+	for (int index : {iWhite, iBlack})
+	{
+		m_gameTimes[index].total += duration;
+		m_gameTimes[index].count++;
+	}
 	const auto whiteName = pgn->playerName(Chess::Side::White);
 	if (!whiteName.isEmpty())
 		m_players[iWhite].setName(whiteName);
@@ -608,45 +1209,271 @@ void Tournament::onGameFinished(ChessGame* game)
 	if (!blackName.isEmpty())
 		m_players[iBlack].setName(blackName);
 
-	switch (game->result().winner())
+	countResult(data, result);
+
+	writePgn(pgn, data->number, iWhite, iBlack);
+	if (m_pgnFile.fileName().isEmpty() && m_checkpointFile.isOpen())
+	{
+		CheckpointGame game = { data->number, iWhite, iBlack, result };
+		const QVector<CheckpointGame> games(1, game);
+		m_output->post([=]() { saveCheckpoint(games, -1); });
+	}
+
+	Chess::Result::Type resultType(result.type());
+	bool crashed = (resultType == Chess::Result::Disconnection ||
+			resultType == Chess::Result::StalledConnection);
+	if (!m_recover && crashed)
+		stop();
+}
+
+void Tournament::countResult(const GameData* data,
+			     const Chess::Result& result)
+{
+	m_finishedGameCount++;
+
+	Sprt::GameResult sprtResult = Sprt::NoResult;
+	const int iWhite = data->whiteIndex;
+	const int iBlack = data->blackIndex;
+
+	switch (result.winner())
 	{
 	case Chess::Side::White:
 		addScore(iWhite, 2);
 		addScore(iBlack, 0);
+		m_ratings.addResult(iWhite, iBlack, 2);
 		sprtResult = (iWhite == 0) ? Sprt::Win : Sprt::Loss;
 		break;
 	case Chess::Side::Black:
 		addScore(iBlack, 2);
 		addScore(iWhite, 0);
+		m_ratings.addResult(iWhite, iBlack, 0);
 		sprtResult = (iBlack == 0) ? Sprt::Win : Sprt::Loss;
 		break;
 	default:
-		if (game->result().isDraw())
+		if (result.isDraw())
 		{
 			addScore(iWhite, 1);
 			addScore(iBlack, 1);
+			m_ratings.addResult(iWhite, iBlack, 1);
 			sprtResult = Sprt::Draw;
 		}
 		break;
 	}
 
-	writeEpd(game);
-	writePgn(pgn, gameNumber);
+	Sprt* sprt = pairSprt(data->pair);
+	if (sprt == nullptr || sprt->isNull())
+		return;
 
-	Chess::Result::Type resultType(game->result().type());
-	bool crashed = (resultType == Chess::Result::Disconnection ||
-			resultType == Chess::Result::StalledConnection);
-	if (!m_recover && crashed)
-		stop();
+	if (sprtResult != Sprt::NoResult)
+		sprt->addGameResult(sprtResult);
 
-	if (!m_sprt->isNull() && sprtResult != Sprt::NoResult)
+	if (sprt->model() == Sprt::Pentanomial)
 	{
-		m_sprt->addGameResult(sprtResult);
-		if (m_sprt->status().result != Sprt::Continue)
-			QMetaObject::invokeMethod(this, "stop", Qt::QueuedConnection);
+		int other = data->pair->addPairedResult(data->pairGame,
+							sprtResult);
+		if (other == -1)
+			return;
+
+		sprt->addGamePairResult(Sprt::GameResult(other), sprtResult);
+	}
+	// The trinomial stopping decision of the tournament's own
+	// test was made by publishResult()
+	else if (sprt == m_sprt)
+		return;
+
+	if (sprt->status().result != Sprt::Continue)
+		onSprtFinished(data->pair);
+}
+
+Sprt* Tournament::pairSprt(const TournamentPair* pair)
+{
+	Q_UNUSED(pair);
+	return m_sprt;
+}
+
+void Tournament::onSprtFinished(const TournamentPair* pair)
+{
+	Q_UNUSED(pair);
+	QMetaObject::invokeMethod(this, "stop", Qt::QueuedConnection);
+}
+
+QString Tournament::sprtStatusString(const Sprt& sprt)
+{
+	const Sprt::Status status = sprt.status();
+	if (status.llr == 0.0 && status.lBound == 0.0 && status.uBound == 0.0)
+		return QString();
+
+	QString str = QString("llr %1 (%2%), lbound %3, ubound %4")
+		.arg(status.llr, 0, 'g', 3)
+		.arg(status.llr / status.uBound * 100, 0, 'f', 1)
+		.arg(status.lBound, 0, 'g', 3)
+		.arg(status.uBound, 0, 'g', 3);
+	if (status.result == Sprt::AcceptH0)
+		str.append(" - H0 was accepted");
+	else if (status.result == Sprt::AcceptH1)
+		str.append(" - H1 was accepted");
+
+	return str;
+}
+
+void Tournament::publishResult(int whiteIndex,
+			       int blackIndex,
+			       const Chess::Result& result)
+{
+	// Called from the game threads: only the thread-safe result
+	// counters and the SPRT's constant parameters are used
+	m_results->addResult(whiteIndex, blackIndex, result);
+	if (m_sprt->isNull() || m_sprt->model() != Sprt::Trinomial)
+		return;
+
+	const ResultAggregator::Score score(m_results->score(0));
+	if (m_sprt->status(score.wins, score.losses, score.draws).result != Sprt::Continue)
+		QMetaObject::invokeMethod(this, "stop", Qt::QueuedConnection);
+}
+
+bool Tournament::openCheckpoint()
+{
+	if (m_checkpointFile.isOpen())
+		m_checkpointFile.close();
+	if (m_resume && !readCheckpoint())
+		return false;
+
+	QIODevice::OpenMode mode = QIODevice::WriteOnly;
+	mode |= m_resume ? QIODevice::Append : QIODevice::Truncate;
+	if (!m_checkpointFile.open(mode)
+	||  (m_checkpointFile.size() == 0
+	     && m_checkpointFile.write(CheckpointMagic, CheckpointMagicSize) != CheckpointMagicSize))
+	{
+		m_error = tr("Could not open checkpoint file %1")
+			  .arg(m_checkpointFile.fileName());
+		m_checkpointFile.close();
+		return false;
+	}
+
+	return m_checkpointFile.flush();
+}
+
+bool Tournament::readCheckpoint()
+{
+	// Without a checkpoint the tournament starts from the beginning
+	if (!m_checkpointFile.exists())
+		return true;
+
+	if (!m_checkpointFile.open(QIODevice::ReadOnly))
+	{
+		m_error = tr("Could not open checkpoint file %1")
+			  .arg(m_checkpointFile.fileName());
+		return false;
+	}
+	if (m_checkpointFile.read(CheckpointMagicSize)
+	!=  QByteArray(CheckpointMagic, CheckpointMagicSize))
+	{
+		m_error = tr("%1 is not a checkpoint file")
+			  .arg(m_checkpointFile.fileName());
+		m_checkpointFile.close();
+		return false;
+	}
+
+	QDataStream in(&m_checkpointFile);
+	qint64 pgnOffset = -1;
+	qint64 validSize = m_checkpointFile.pos();
+	for (;;)
+	{
+		qint32 number;
+		qint16 whiteIndex;
+		qint16 blackIndex;
+		qint8 result;
+		qint64 offset;
+		in >> number >> whiteIndex >> blackIndex >> result >> offset;
+
+		// A record that was cut short by a crash is ignored
+		if (in.status() != QDataStream::Ok)
+			break;
+
+		CheckpointGame game = { number, whiteIndex, blackIndex,
+					fromCheckpointResult(result) };
+		m_restoredGames[number] = game;
+		pgnOffset = qMax(pgnOffset, offset);
+		validSize = m_checkpointFile.pos();
+	}
+	m_checkpointFile.close();
+	if (m_checkpointFile.size() > validSize)
+		m_checkpointFile.resize(validSize);
+
+	// Games saved after the last checkpoint are played again
+	const QString pgnFileName(m_pgnFile.fileName());
+	if (pgnOffset < 0 || pgnFileName.isEmpty() || !QFile::exists(pgnFileName))
+		return true;
+	if (CompressedFile::compressionForFileName(pgnFileName) != CompressedFile::NoCompression)
+		qWarning("Can't truncate compressed PGN file %s, games played "
+			 "after the checkpoint may be saved twice",
+			 qUtf8Printable(pgnFileName));
+	else if (QFileInfo(pgnFileName).size() > pgnOffset
+	     &&  !QFile::resize(pgnFileName, pgnOffset))
+		qWarning("Could not truncate PGN file %s",
+			 qUtf8Printable(pgnFileName));
+
+	return true;
+}
+
+void Tournament::saveCheckpoint(const QVector<CheckpointGame>& games,
+				qint64 pgnOffset)
+{
+	QByteArray data;
+	QDataStream out(&data, QIODevice::WriteOnly);
+	for (const CheckpointGame& game : games)
+	{
+		out << qint32(game.number)
+		    << qint16(game.whiteIndex)
+		    << qint16(game.blackIndex)
+		    << checkpointResult(game.result)
+		    << pgnOffset;
 	}
 
-	emit gameFinished(game, gameNumber, iWhite, iBlack);
+	if (m_checkpointFile.write(data) != data.size()
+	||  !m_checkpointFile.flush())
+		qWarning("Could not write to checkpoint file %s",
+			 qUtf8Printable(m_checkpointFile.fileName()));
+}
+
+bool Tournament::restoreGame(const PreparedGame& prepared)
+{
+	auto it = m_restoredGames.find(prepared.data->number);
+	if (it == m_restoredGames.end())
+		return false;
+
+	const GameData* data = prepared.data;
+	if (it->whiteIndex != data->whiteIndex || it->blackIndex != data->blackIndex)
+		qWarning("The players of game %d don't match the checkpoint",
+			 data->number);
+
+	publishResult(data->whiteIndex, data->blackIndex, it->result);
+	countResult(data, it->result);
+	m_restoredGames.erase(it);
+
+	// The game is already in the PGN file
+	if (!m_pgnFile.fileName().isEmpty())
+		m_pgnWrittenAhead.insert(data->number);
+
+	delete prepared.game->pgn();
+	delete prepared.game;
+	delete prepared.data;
+	return true;
+}
+
+void Tournament::onGameFinished(ChessGame* game)
+{
+	Q_ASSERT(game != nullptr);
+
+	PgnGame* pgn(game->pgn());
+
+	Q_ASSERT(m_gameData.contains(game));
+	GameData* data = m_gameData.take(game);
+
+	publishGame(game, data->number);
+	addGameResult(data, pgn, game->result());
+
+	emit gameFinished(game, data->number, data->whiteIndex, data->blackIndex);
 
 	if (m_pgnCleanup)
 		delete pgn;
@@ -663,6 +1490,23 @@ void Tournament::onGameFinished(ChessGame* game)
 	game->deleteLater();
 }
 
+void Tournament::finishRemoteGame(int number, PgnGame* pgn)
+{
+	Q_ASSERT(pgn != nullptr);
+
+	GameData* data = m_remoteGameData.take(number);
+	if (data == nullptr)
+		return;
+
+	publishResult(data->whiteIndex, data->blackIndex, pgn->result());
+	addGameResult(data, pgn, pgn->result());
+	emit remoteGameFinished(pgn, number, data->whiteIndex, data->blackIndex);
+	delete data;
+
+	if (!m_finished && areAllGamesFinished() && m_gameData.isEmpty())
+		onFinished();
+}
+
 void Tournament::onGameDestroyed(ChessGame* game)
 {
 	if (game != m_lastGame)
@@ -685,6 +1529,16 @@ void Tournament::onGameStartFailed(ChessGame* game)
 
 void Tournament::onFinished()
 {
+	// The games are in the output files when the tournament ends
+	for (PgnShard* shard : qAsConst(m_pgnShards))
+		shard->queue.waitForDone();
+	m_output->waitForDone();
+	for (const SinkQueue& entry : qAsConst(m_sinks))
+		entry.queue->waitForDone();
+
+	delete m_openingPool;
+	m_openingPool = nullptr;
+
 	m_gameManager->cleanupIdleThreads();
 	m_finished = true;
 	emit finished();
@@ -705,12 +1559,55 @@ void Tournament::start()
 		setOpeningRepetitions(INT_MAX);
 
 	m_gameData.clear();
-	m_pgnGames.clear();
-	m_startFen.clear();
-	m_openingMoves.clear();
+	qDeleteAll(m_remoteGameData);
+	m_remoteGameData.clear();
+	discardPreparedGames();
+	m_gameTimes.fill(GameTime(), m_players.size());
+	m_ratings = RatingModel(m_players.size());
+	delete m_results;
+	m_results = new ResultAggregator(m_players.size());
+	m_clock.start();
+	clearPgnGames();
+	m_pgnWrittenAhead.clear();
+	m_opening.clear();
+	m_restoredGames.clear();
+
+	if (!m_checkpointFile.fileName().isEmpty() && !openCheckpoint())
+	{
+		onFinished();
+		return;
+	}
 
-	connect(m_gameManager, SIGNAL(ready()),
-		this, SLOT(startNextGame()));
+	qDeleteAll(m_pgnShards);
+	m_pgnShards.clear();
+	if (m_pgnShardCount > 1 && !m_pgnFile.fileName().isEmpty())
+	{
+		for (int i = 1; i <= m_pgnShardCount; i++)
+		{
+			PgnShard* shard = new PgnShard;
+			shard->file.setFileName(shardFileName(m_pgnFile.fileName(), i));
+			shard->file.setCompressionLevel(m_pgnFile.compressionLevel());
+			shard->writer.setBatchSize(INT_MAX);
+			shard->writer.setSyncInterval(m_pgnWriter.syncInterval());
+			m_pgnShards.append(shard);
+		}
+	}
+
+	// Openings are read and validated ahead of the games so that
+	// starting a game doesn't wait for the suite
+	delete m_openingPool;
+	m_openingPool = nullptr;
+	if (m_openingSuite != nullptr)
+	{
+		const int capacity = 2 * m_gameManager->concurrency();
+		m_openingPool = new OpeningPool(m_openingSuite, m_variant,
+						m_openingDepth, capacity);
+		m_openingPool->start();
+	}
+
+	if (!m_externalScheduling)
+		connect(m_gameManager, SIGNAL(readyForGames(int)),
+			this, SLOT(startNextGames(int)));
 
 	initializePairing();
 	m_finalGameCount = gamesPerCycle() * gamesPerEncounter() * roundMultiplier();
@@ -720,11 +1617,16 @@ void Tournament::start()
 
 void Tournament::stop()
 {
-	if (m_stopping)
+	if (m_stopping || m_finished)
 		return;
 
-	disconnect(m_gameManager, SIGNAL(ready()),
-		   this, SLOT(startNextGame()));
+	disconnect(m_gameManager, SIGNAL(readyForGames(int)),
+		   this, SLOT(startNextGames(int)));
+
+	// The results of remote games would arrive too late
+	qDeleteAll(m_remoteGameData);
+	m_remoteGameData.clear();
+	discardPreparedGames();
 
 	if (m_gameData.isEmpty())
 	{
@@ -758,12 +1660,15 @@ QString Tournament::results() const
 			break;
 		}
 
+		// The maximum-likelihood ratings account for the
+		// strength of each player's opponents
+		const bool rated = (i < m_ratings.playerCount());
 		RankingData data = { player.name(),
 				     player.gamesFinished(),
 				     elo.pointRatio(),
 				     elo.drawRatio(),
-				     elo.errorMargin(),
-				     elo.diff() };
+				     rated ? m_ratings.errorMargin(i) : elo.errorMargin(),
+				     rated ? m_ratings.rating(i) : elo.diff() };
 		// Order players like this:
 		// 1. Gauntlet player (if any)
 		// 2. Players with finished games, sorted by point ratio
@@ -803,23 +1708,9 @@ QString Tournament::results() const
 			.arg(data.draws * 100.0, 6, 'f', 1);
 	}
 
-	Sprt::Status sprtStatus = sprt()->status();
-	if (sprtStatus.llr != 0.0
-	||  sprtStatus.lBound != 0.0
-	||  sprtStatus.uBound != 0.0)
-	{
-		QString sprtStr = QString("SPRT: llr %1 (%2%), lbound %3, ubound %4")
-			.arg(sprtStatus.llr, 0, 'g', 3)
-			.arg(sprtStatus.llr / sprtStatus.uBound * 100, 0, 'f', 1)
-			.arg(sprtStatus.lBound, 0, 'g', 3)
-			.arg(sprtStatus.uBound, 0, 'g', 3);
-		if (sprtStatus.result == Sprt::AcceptH0)
-			sprtStr.append(" - H0 was accepted");
-		else if (sprtStatus.result == Sprt::AcceptH1)
-			sprtStr.append(" - H1 was accepted");
-
-		ret += "\n" + sprtStr;
-	}
+	const QString sprtStr(sprtStatusString(*sprt()));
+	if (!sprtStr.isEmpty())
+		ret += "\nSPRT: " + sprtStr;
 
 	return ret;
 }
@@ -23,20 +23,30 @@
 #include <QList>
 #include <QVector>
 #include <QMap>
+#include <QSet>
+#include <QStringList>
 #include <QFile>
-#include <QTextStream>
+#include <QElapsedTimer>
 #include "board/move.h"
 #include "timecontrol.h"
 #include "pgngame.h"
+#include "pgnwriter.h"
+#include "compressedfile.h"
+#include "trainingdatawriter.h"
 #include "gameadjudicator.h"
 #include "tournamentplayer.h"
 #include "tournamentpair.h"
+#include "ratingmodel.h"
+#include "outputqueue.h"
+#include "gamesink.h"
+#include "chessgame.h"
 class GameManager;
 class PlayerBuilder;
-class ChessGame;
 class OpeningBook;
 class OpeningSuite;
+class OpeningPool;
 class Sprt;
+class ResultAggregator;
 
 /*!
  * \brief Base class for chess tournaments
@@ -107,8 +117,17 @@ class LIB_EXPORT Tournament : public QObject
 		int roundMultiplier() const;
 		/*! Returns the number of games finished so far. */
 		int finishedGameCount() const;
+		/*! Returns the number of games started but not finished. */
+		int activeGameCount() const;
 		/*! Returns the total number of games that will be played. */
 		int finalGameCount() const;
+		/*!
+		 * Returns the largest number of openings from the opening
+		 * suite that the tournament will use, given the current
+		 * players and opening settings. Tournaments that need
+		 * extra games (eg. knockout tie-breaks) may use more.
+		 */
+		int openingCount() const;
 		/*! Returns player data for the player at \a index. */
 		const TournamentPlayer& playerAt(int index) const;
 		/*! Returns the number of participants in the tournament. */
@@ -125,6 +144,28 @@ class LIB_EXPORT Tournament : public QObject
 		 * stopping criterion.
 		 */
 		Sprt* sprt() const;
+		/*!
+		 * Returns the results of the players' games.
+		 *
+		 * The results are counted in the game threads as soon as
+		 * the games end, so they can be ahead of the results seen
+		 * in the gameFinished() signal. The SPRT stopping criterion
+		 * is checked from these results. The object is thread-safe
+		 * and exists after start() has been called.
+		 */
+		const ResultAggregator* resultAggregator() const;
+		/*! Returns the adjudicator used in the tournament's games. */
+		const GameAdjudicator& adjudicator() const;
+		/*!
+		 * Returns the ratings and the pair results of the players
+		 * in the games finished so far.
+		 */
+		const RatingModel& ratingModel() const;
+		/*!
+		 * Returns the statistics of the queue of writes to the
+		 * PGN and checkpoint files.
+		 */
+		OutputQueue::Statistics outputStatistics() const;
 
 		/*! Sets the tournament's name to \a name. */
 		void setName(const QString& name);
@@ -143,6 +184,14 @@ class LIB_EXPORT Tournament : public QObject
 		 * user-defined round multiplier; otherwise returns false.
 		 */
 		virtual bool canSetRoundMultiplier() const;
+		/*!
+		 * Returns true if the pairings don't depend on the results,
+		 * so that games can be started ahead of their turn;
+		 * otherwise returns false (default).
+		 *
+		 * \sa setLookahead()
+		 */
+		virtual bool canReorderGames() const;
 		/*!
 		 * Sets the multiplier for the number of rounds to \a factor.
 		 *
@@ -177,6 +226,15 @@ class LIB_EXPORT Tournament : public QObject
 		 * to \a plies (halfmoves).
 		 */
 		void setOpeningDepth(int plies);
+		/*!
+		 * Sets the number of random plies (halfmoves) played after
+		 * each new opening to \a plies.
+		 *
+		 * The random moves are legal moves picked with Mersenne::random(),
+		 * and they become part of the opening, so repeated openings
+		 * keep them. The default is 0.
+		 */
+		void setRandomOpeningPlies(int plies);
 		/*!
 		 * Sets the PGN output file for the games to \a fileName.
 		 *
@@ -194,6 +252,46 @@ class LIB_EXPORT Tournament : public QObject
 		 * are saved even if they have no result.
 		 */
 		void setPgnWriteUnfinishedGames(bool enabled);
+		/*!
+		 * Makes the PGN output file to be synchronized to disk
+		 * after every \a games saved games.
+		 *
+		 * If \a games is 0 (the default) then the file is never
+		 * explicitly synchronized.
+		 */
+		void setPgnSyncInterval(int games);
+		/*!
+		 * Sets the maximum number of finished games that wait for
+		 * an earlier game to finish before they are saved to the
+		 * PGN file, to \a games. When the limit is exceeded, the
+		 * waiting games are saved out of order. The default is 1024.
+		 *
+		 * If \a games is 0, every game is saved as soon as it
+		 * finishes, and its number is saved in a "GameNumber" tag
+		 * so that the games can be sorted later.
+		 */
+		void setPgnBacklogLimit(int games);
+		/*!
+		 * Sets the compression level of the PGN output file to
+		 * \a level.
+		 *
+		 * The output is compressed if the file name ends with ".gz"
+		 * or ".zst". If \a level is -1 (the default) then the default
+		 * level of the compression format is used.
+		 */
+		void setPgnCompressionLevel(int level);
+		/*!
+		 * Splits the PGN output into \a shards files, each written
+		 * by its own thread. The default is 1.
+		 *
+		 * With more than one shard, game number N is saved to shard
+		 * (N - 1) % \a shards + 1 as soon as it finishes, with its
+		 * number in a "GameNumber" tag. The shard files are named
+		 * after the PGN output file, eg. "games.1.pgn" and
+		 * "games.2.pgn" for "games.pgn", and they can be merged into
+		 * one file in game order with PgnMerger.
+		 */
+		void setPgnShardCount(int shards);
 
 		/*!
 		 * Sets PgnGame cleanup mode to \a enabled.
@@ -202,6 +300,27 @@ class LIB_EXPORT Tournament : public QObject
 		 * objects are destroyed automatically once the games are finished.
 		 */
 		void setPgnCleanupEnabled(bool enabled);
+		/*!
+		 * Sets the checkpoint file to \a fileName.
+		 *
+		 * The players and results of the finished games are appended
+		 * to the file in a compact binary format as soon as their
+		 * PGN has been saved, so that an interrupted tournament can
+		 * be resumed. By default no checkpoints are written.
+		 */
+		void setCheckpointFile(const QString& fileName);
+		/*!
+		 * Sets resume mode to \a enabled.
+		 *
+		 * In resume mode start() reads the checkpoint file and
+		 * counts the results of the games in it, truncates the PGN
+		 * output file after the last checkpointed game, and plays
+		 * only the remaining games. The pairings and openings are
+		 * generated in the same order as in the interrupted
+		 * tournament, so the settings (including the random seed)
+		 * must be the same.
+		 */
+		void setResumeEnabled(bool enabled);
 
 		/*!
 		 * Sets the EPD output file for the end positions to \a fileName.
@@ -210,6 +329,56 @@ class LIB_EXPORT Tournament : public QObject
 		 * will not be saved.
 		 */
 		void setEpdOutput(const QString& fileName);
+		/*!
+		 * Sets the output file for games in the compact binary
+		 * format to \a fileName.
+		 *
+		 * If no compact output file is set (default) then the games
+		 * are only saved in PGN format.
+		 *
+		 * \sa CompactGameWriter
+		 */
+		void setCompactOutput(const QString& fileName);
+		/*!
+		 * Sets the output file for training data to \a fileName.
+		 *
+		 * The positions of the finished games that pass \a filter
+		 * are appended to the file with their scores and the game
+		 * results. If no training data file is set (default) then
+		 * no training data is written.
+		 *
+		 * \sa TrainingDataWriter
+		 */
+		void setTrainingOutput(const QString& fileName,
+				       const TrainingDataWriter::Filter& filter =
+					TrainingDataWriter::Filter());
+		/*!
+		 * Saves the engine logs of failed games in \a directory.
+		 *
+		 * The debug messages of the players, which include all of
+		 * the engine traffic, are kept in memory for every game,
+		 * but only the last \a bufferSize bytes.
+		 *
+		 * If \a directory is empty (default) no logs are kept.
+		 *
+		 * \sa EngineLogSink
+		 */
+		void setEngineLogOutput(const QString& directory,
+					const QString& suffix = QString(),
+					int bufferSize = 1024 * 1024);
+		/*!
+		 * Adds \a sink to the outputs of the finished games, and
+		 * takes its ownership.
+		 *
+		 * A sink with the same name as \a sink is replaced. Each sink
+		 * writes the games on a thread of its own, so a slow sink
+		 * doesn't delay the start of the games until its queue of
+		 * unwritten games is full.
+		 *
+		 * \note The PGN output and the checkpoint file are written
+		 * in the order of the game numbers, and not by a sink.
+		 */
+		void addGameSink(GameSink* sink);
 
 		/*!
 		 * Sets the number of opening repetitions to \a count.
@@ -250,6 +419,48 @@ class LIB_EXPORT Tournament : public QObject
 		 * the tournament.
 		 */
 		void setSeedCount(int seedCount);
+		/*!
+		 * Sets external scheduling to \a enabled.
+		 *
+		 * By default the tournament starts a new game whenever the
+		 * game manager has a free game slot. With external
+		 * scheduling only the first game is started that way, and
+		 * a scheduler shared by several tournaments calls
+		 * startNextGame() to fill the free slots.
+		 */
+		void setExternalScheduling(bool enabled);
+		/*!
+		 * Sets remote games to \a enabled.
+		 *
+		 * With remote games the tournament still does the pairing,
+		 * picks the openings and keeps the score, but the games are
+		 * played elsewhere. Each game is announced with the
+		 * gameDispatched() signal instead of being played by the game
+		 * manager, and its outcome must be reported back with
+		 * finishRemoteGame().
+		 *
+		 * The default value is false.
+		 */
+		void setRemoteGames(bool enabled);
+		/*!
+		 * Sets the number of upcoming games to look ahead to \a games.
+		 *
+		 * When a game slot is free, the next \a games games in the
+		 * pairing are considered too, and the one expected to take
+		 * the longest is started first. The estimate comes from the
+		 * players' finished games, or from their time controls
+		 * before that. This keeps the slots busy when the last long
+		 * games of a tournament would otherwise run alone.
+		 *
+		 * The openings and colors are the same as without looking
+		 * ahead. Only tournaments that can reorder their games
+		 * look ahead.
+		 *
+		 * The default value is 0 (the games start in order).
+		 *
+		 * \sa canReorderGames()
+		 */
+		void setLookahead(int games);
 		/*!
 		 * Adds player \a builder to the tournament.
 		 *
@@ -268,14 +479,41 @@ class LIB_EXPORT Tournament : public QObject
 		 * The default implementation works for most tournament types.
 		 */
 		virtual QString results() const;
+		/*!
+		 * Finishes remote game \a number with \a pgn.
+		 *
+		 * The result of the game is read from \a pgn, which is
+		 * written to the PGN output file. The tournament does not
+		 * take ownership of \a pgn. Games that are no longer in
+		 * progress, eg. because the tournament was stopped, are
+		 * ignored.
+		 *
+		 * \sa setRemoteGames()
+		 */
+		void finishRemoteGame(int number, PgnGame* pgn);
 
 	public slots:
 		/*! Starts the tournament. */
 		void start();
+		/*!
+		 * Starts the next game if there is one that can be
+		 * started now.
+		 */
+		void startNextGame();
+		/*!
+		 * Starts up to \a count next games in one batch.
+		 *
+		 * The games' pairings, openings and ChessGame objects are
+		 * prepared together before they're handed to the game
+		 * manager. The tournament calls this function when the
+		 * game manager has free game slots.
+		 */
+		void startNextGames(int count);
 		/*!
 		 * Stops the tournament.
 		 *
 		 * Any running games will have an unterminated result.
+		 * Remote games are abandoned.
 		 * The finished() signal is emitted when the tournament
 		 * is fully stopped.
 		 */
@@ -319,6 +557,32 @@ class LIB_EXPORT Tournament : public QObject
 		 * is sent.
 		 */
 		void finished();
+		/*!
+		 * This signal is emitted when remote game \a number is ready
+		 * to be played between players \a whiteIndex and
+		 * \a blackIndex.
+		 *
+		 * The game starts from \a startingFen, or from the default
+		 * position if it's empty, after the opening \a moves in long
+		 * algebraic notation.
+		 *
+		 * \sa setRemoteGames()
+		 */
+		void gameDispatched(int number,
+				    int whiteIndex,
+				    int blackIndex,
+				    const QString& startingFen,
+				    const QStringList& moves);
+		/*!
+		 * This signal is emitted when remote game \a number with
+		 * \a pgn is finished.
+		 *
+		 * \sa finishRemoteGame()
+		 */
+		void remoteGameFinished(PgnGame* pgn,
+					int number,
+					int whiteIndex,
+					int blackIndex);
 
 	protected:
 		/*! Sets the currently executing tournament round to \a round. */
@@ -335,8 +599,7 @@ class LIB_EXPORT Tournament : public QObject
 		 */
 		TournamentPair* pair(int player1, int player2);
 		/*!
-		 * This member function is called by \a startNextGame() to
-		 * start a new tournament game between \a pair.
+		 * Starts a new tournament game between \a pair.
 		 *
 		 * Reimplementations should call the base implementation.
 		 */
@@ -414,11 +677,31 @@ class LIB_EXPORT Tournament : public QObject
 		 * The default implementation always returns false.
 		 */
 		virtual bool hasGauntletRatingsOrder() const;
+		/*!
+		 * Returns the SPRT that is updated with the results of the
+		 * games between \a pair, or nullptr if the games aren't
+		 * tested.
+		 *
+		 * The default implementation returns sprt() for every pair.
+		 */
+		virtual Sprt* pairSprt(const TournamentPair* pair);
+		/*!
+		 * This member function is called when the SPRT of \a pair,
+		 * as returned by pairSprt(), accepts H0 or H1.
+		 *
+		 * The default implementation stops the tournament.
+		 */
+		virtual void onSprtFinished(const TournamentPair* pair);
+		/*!
+		 * Returns the status of \a sprt as a line of text, or an
+		 * empty string if the test has no results.
+		 */
+		static QString sprtStatusString(const Sprt& sprt);
 
 	private slots:
-		void startNextGame();
-		bool writePgn(PgnGame* pgn, int gameNumber);
-		bool writeEpd(ChessGame* game);
+		bool writePgn(PgnGame* pgn, int gameNumber,
+			      int whiteIndex, int blackIndex);
+		void publishGame(ChessGame* game, int gameNumber);
 		void onGameStarted(ChessGame* game);
 		void onGameFinished(ChessGame* game);
 		void onGameDestroyed(ChessGame* game);
@@ -430,6 +713,58 @@ class LIB_EXPORT Tournament : public QObject
 			int number;
 			int whiteIndex;
 			int blackIndex;
+			TournamentPair* pair;
+			int pairGame;
+			qint64 startTime;
+		};
+		struct PreparedGame
+		{
+			ChessGame* game;
+			GameData* data;
+		};
+		struct GameTime
+		{
+			GameTime() : total(0), count(0) {}
+
+			qint64 total;
+			int count;
+		};
+		struct PendingPgn
+		{
+			QByteArray data;
+			Chess::Result result;
+			int whiteIndex;
+			int blackIndex;
+		};
+		// A finished game in the checkpoint file
+		struct CheckpointGame
+		{
+			int number;
+			int whiteIndex;
+			int blackIndex;
+			Chess::Result result;
+		};
+		// Formatted games to be saved by the output thread
+		struct PgnBatch
+		{
+			QVector<QByteArray> games;
+			QVector<CheckpointGame> checkpoints;
+		};
+		// A PGN output shard and the thread that writes it
+		struct PgnShard
+		{
+			PgnShard() : queue(256) {}
+
+			CompressedFile file;
+			PgnWriter writer;
+			// Destroyed first, so that it finishes its writes
+			OutputQueue queue;
+		};
+		// A game sink and the queue of its thread
+		struct SinkQueue
+		{
+			GameSink* sink;
+			OutputQueue* queue;
 		};
 		struct RankingData
 		{
@@ -441,6 +776,38 @@ class LIB_EXPORT Tournament : public QObject
 			qreal eloDiff;
 		};
 
+		bool writePendingPgn(int gameNumber,
+				     const PendingPgn& pgn,
+				     PgnBatch* batch);
+		void clearPgnGames();
+		void removeGameSink(const QString& name);
+		// These are run by the output thread
+		void savePgn(const PgnBatch& batch);
+		void savePgnShard(PgnShard* shard, const PgnBatch& batch);
+		bool writePgnFile(CompressedFile* file,
+				  PgnWriter* writer,
+				  const QVector<QByteArray>& games);
+		void saveCheckpoint(const QVector<CheckpointGame>& games,
+				    qint64 pgnOffset);
+		TournamentPair* pairAt(int index) const;
+		int* pairIndex(int player1, int player2);
+		PreparedGame prepareGame(TournamentPair* pair);
+		void playGame(ChessGame* game, GameData* data);
+		void discardPreparedGames();
+		qint64 expectedGameTime(const GameData* data) const;
+		void dispatchGame(ChessGame* game, const GameData* data);
+		void addGameResult(const GameData* data,
+				   PgnGame* pgn,
+				   const Chess::Result& result);
+		void publishResult(int whiteIndex,
+				   int blackIndex,
+				   const Chess::Result& result);
+		void countResult(const GameData* data,
+				 const Chess::Result& result);
+		bool openCheckpoint();
+		bool readCheckpoint();
+		bool restoreGame(const PreparedGame& prepared);
+
 		GameManager* m_gameManager;
 		ChessGame* m_lastGame;
 		QString m_error;
@@ -457,6 +824,7 @@ class LIB_EXPORT Tournament : public QObject
 		int m_roundMultiplier;
 		int m_startDelay;
 		int m_openingDepth;
+		int m_randomOpeningPlies;
 		int m_seedCount;
 		bool m_stopping;
 		int m_openingRepetitions;
@@ -466,23 +834,47 @@ class LIB_EXPORT Tournament : public QObject
 		bool m_pgnWriteUnfinishedGames;
 		bool m_finished;
 		bool m_bookOwnership;
+		bool m_externalScheduling;
+		bool m_remoteGames;
+		int m_lookahead;
 		GameAdjudicator m_adjudicator;
 		OpeningSuite* m_openingSuite;
+		OpeningPool* m_openingPool;
 		Sprt* m_sprt;
-		QFile m_pgnFile;
-		QTextStream m_pgnOut;
-		QFile m_epdFile;
-		QTextStream m_epdOut;
-		QString m_startFen;
+		ResultAggregator* m_results;
+		CompressedFile m_pgnFile;
+		PgnWriter m_pgnWriter;
+		QList<SinkQueue> m_sinks;
+		int m_engineLogSize;
+		QFile m_checkpointFile;
+		bool m_resume;
+		QMap<int, CheckpointGame> m_restoredGames;
 		int m_repetitionCounter;
+		int m_openingNumber;
 		int m_swapSides;
 		PgnGame::PgnMode m_pgnOutMode;
+		int m_pgnBacklogLimit;
+		int m_pgnShardCount;
+		QVector<PgnShard*> m_pgnShards;
 		TournamentPair* m_pair;
-		QMap< QPair<int, int>, TournamentPair* > m_pairs;
+		// The pairs are allocated in blocks, so that their addresses
+		// don't change, and found through a triangular matrix of
+		// indexes for every two players
+		QVector<TournamentPair*> m_pairBlocks;
+		int m_pairCount;
+		QVector<int> m_pairIndexes;
+		QVector<int> m_byePairs;
 		QList<TournamentPlayer> m_players;
-		QMap<int, PgnGame> m_pgnGames;
+		QMap<int, PendingPgn> m_pgnGames;
+		QSet<int> m_pgnWrittenAhead;
 		QMap<ChessGame*, GameData*> m_gameData;
-		QVector<Chess::Move> m_openingMoves;
+		QMap<int, GameData*> m_remoteGameData;
+		QList<PreparedGame> m_preparedGames;
+		QVector<GameTime> m_gameTimes;
+		RatingModel m_ratings;
+		QElapsedTimer m_clock;
+		ChessGame::SharedOpening m_opening;
+		OutputQueue* m_output;
 };
 
 #endif // TOURNAMENT_H
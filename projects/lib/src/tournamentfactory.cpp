@@ -21,6 +21,8 @@
 #include "gauntlettournament.h"
 #include "knockouttournament.h"
 #include "pyramidtournament.h"
+#include "swisstournament.h"
+#include "adaptivetournament.h"
 
 Tournament* TournamentFactory::create(const QString& type,
 				      GameManager* manager,
@@ -34,6 +36,10 @@ Tournament* TournamentFactory::create(const QString& type,
 		return new KnockoutTournament(manager, parent);
 	if (type == "pyramid")
 		return new PyramidTournament(manager, parent);
+	if (type == "swiss")
+		return new SwissTournament(manager, parent);
+	if (type == "adaptive")
+		return new AdaptiveTournament(manager, parent);
 
 	return nullptr;
 }
@@ -134,3 +134,18 @@ void TournamentPair::swapPlayers()
 	std::swap(m_first, m_second);
 	m_hasOriginalOrder = !m_hasOriginalOrder;
 }
+
+int TournamentPair::addPairedResult(int game, int result)
+{
+	const int key = game / 2;
+	auto it = m_pairedResults.find(key);
+	if (it == m_pairedResults.end())
+	{
+		m_pairedResults.insert(key, result);
+		return -1;
+	}
+
+	const int other = it.value();
+	m_pairedResults.erase(it);
+	return other;
+}
@@ -19,6 +19,8 @@
 #ifndef TOURNAMENTPAIR_H
 #define TOURNAMENTPAIR_H
 
+#include <QMap>
+
 /*!
  * \brief A single encounter in a tournament
  *
@@ -111,6 +113,19 @@ class LIB_EXPORT TournamentPair
 		 * second player and vice versa.
 		 */
 		void swapPlayers();
+		/*!
+		 * Stores \a result for game number \a game of the encounter.
+		 *
+		 * \a game is the zero-based index of the game in the order
+		 * the games were started. Games 2n and 2n+1 form a game
+		 * pair, which is played with the same opening and reversed
+		 * colors when openings are repeated.
+		 *
+		 * If the result of the other game of the pair was stored
+		 * earlier, it is removed and returned. Otherwise \a result
+		 * is kept and -1 is returned.
+		 */
+		int addPairedResult(int game, int result);
 
 	private:
 		struct Player
@@ -123,6 +138,7 @@ class LIB_EXPORT TournamentPair
 		Player m_second;
 		int m_gamesStarted;
 		bool m_hasOriginalOrder;
+		QMap<int, int> m_pairedResults;
 };
 
 #endif // TOURNAMENTPAIR_H
@@ -0,0 +1,178 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "tracelog.h"
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QThread>
+
+namespace {
+
+QAtomicInt s_enabled(0);
+QAtomicInt s_nextThreadId(0);
+QMutex s_mutex;
+QFile s_file;
+QByteArray s_buffer;
+QElapsedTimer s_clock;
+
+const int s_bufferSize = 256 * 1024;
+
+// Appends an event to the buffer. The mutex must be locked.
+void appendEvent(const QJsonObject& event)
+{
+	if (!s_buffer.isEmpty() || s_file.pos() > 2)
+		s_buffer += ",\n";
+	s_buffer += QJsonDocument(event).toJson(QJsonDocument::Compact);
+	if (s_buffer.size() >= s_bufferSize)
+	{
+		s_file.write(s_buffer);
+		s_buffer.clear();
+	}
+}
+
+// Returns the track of the current thread, and names the track
+// when the thread records its first event
+int threadId()
+{
+	thread_local int id = -1;
+	if (id != -1)
+		return id;
+
+	id = s_nextThreadId.fetchAndAddRelaxed(1) + 1;
+	QThread* thread = QThread::currentThread();
+	QString name(thread->objectName());
+	if (name.isEmpty())
+	{
+		if (QCoreApplication::instance() != nullptr
+		&&  thread == QCoreApplication::instance()->thread())
+			name = "Main thread";
+		else
+			name = QString("Thread %1").arg(id);
+	}
+
+	QJsonObject args;
+	args["name"] = name;
+	QJsonObject event;
+	event["name"] = "thread_name";
+	event["ph"] = "M";
+	event["pid"] = 1;
+	event["tid"] = id;
+	event["args"] = args;
+
+	QMutexLocker locker(&s_mutex);
+	if (s_file.isOpen())
+		appendEvent(event);
+	return id;
+}
+
+} // anonymous namespace
+
+bool TraceLog::open(const QString& fileName)
+{
+	QMutexLocker locker(&s_mutex);
+	if (s_file.isOpen())
+		return false;
+
+	s_file.setFileName(fileName);
+	if (!s_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("Can't open trace file %s: %s",
+			 qUtf8Printable(fileName),
+			 qUtf8Printable(s_file.errorString()));
+		return false;
+	}
+
+	s_file.write("[\n");
+	s_clock.start();
+	s_enabled.storeRelease(1);
+	qAddPostRoutine(&TraceLog::close);
+	return true;
+}
+
+void TraceLog::close()
+{
+	QMutexLocker locker(&s_mutex);
+	if (!s_file.isOpen())
+		return;
+
+	s_enabled.storeRelease(0);
+	s_buffer += "\n]\n";
+	s_file.write(s_buffer);
+	s_buffer.clear();
+	s_file.close();
+}
+
+bool TraceLog::isEnabled()
+{
+	return s_enabled.loadAcquire() != 0;
+}
+
+qint64 TraceLog::timestamp()
+{
+	return s_clock.nsecsElapsed() / 1000;
+}
+
+void TraceLog::addEvent(const char* category,
+			const QString& name,
+			qint64 start,
+			qint64 duration,
+			const QJsonObject& args)
+{
+	if (!isEnabled())
+		return;
+
+	QJsonObject event;
+	event["name"] = name;
+	event["cat"] = category;
+	event["ph"] = "X";
+	event["ts"] = start;
+	event["dur"] = qMax(duration, Q_INT64_C(0));
+	event["pid"] = 1;
+	event["tid"] = threadId();
+	if (!args.isEmpty())
+		event["args"] = args;
+
+	QMutexLocker locker(&s_mutex);
+	if (s_file.isOpen())
+		appendEvent(event);
+}
+
+void TraceLog::addEventSince(const char* category,
+			     const QString& name,
+			     qint64 start,
+			     const QJsonObject& args)
+{
+	addEvent(category, name, start, timestamp() - start, args);
+}
+
+TraceLog::Scope::Scope(const char* category, const char* name)
+	: m_category(category),
+	  m_name(name),
+	  m_start(TraceLog::isEnabled() ? TraceLog::timestamp() : -1)
+{
+}
+
+TraceLog::Scope::~Scope()
+{
+	if (m_start >= 0)
+		TraceLog::addEventSince(m_category, m_name, m_start);
+}
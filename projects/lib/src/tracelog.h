@@ -0,0 +1,106 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef TRACELOG_H
+#define TRACELOG_H
+
+#include <QtGlobal>
+#include <QJsonObject>
+class QString;
+
+/*!
+ * \brief Records a timeline of a match in the Chrome trace event format
+ *
+ * TraceLog writes "complete" events (a name, a start time and a
+ * duration) to a JSON file that can be opened in chrome://tracing or
+ * the Perfetto UI. Every thread gets its own track, named after the
+ * QThread's object name, so the games of each game thread, the
+ * engines' thinking and the time spent by Cute Chess itself can be
+ * compared side by side.
+ *
+ * Recording is off until open() is called, and the instrumented code
+ * checks isEnabled() first, so tracing costs nothing when it's off.
+ * Events are buffered and written in large blocks. The file is closed
+ * when the application exits.
+ *
+ * All functions are thread-safe.
+ */
+class LIB_EXPORT TraceLog
+{
+	public:
+		/*!
+		 * Starts recording to \a fileName. Returns false if the
+		 * file can't be opened.
+		 */
+		static bool open(const QString& fileName);
+		/*! Writes the remaining events and closes the file. */
+		static void close();
+		/*! Returns true if events are being recorded. */
+		static bool isEnabled();
+
+		/*!
+		 * Returns the current time in microseconds since open(),
+		 * the time base of the events.
+		 */
+		static qint64 timestamp();
+		/*!
+		 * Adds an event named \a name in category \a category
+		 * that started at \a start and lasted \a duration
+		 * microseconds, in the current thread's track.
+		 */
+		static void addEvent(const char* category,
+				     const QString& name,
+				     qint64 start,
+				     qint64 duration,
+				     const QJsonObject& args = QJsonObject());
+		/*!
+		 * Adds an event from \a start to now.
+		 * \sa addEvent()
+		 */
+		static void addEventSince(const char* category,
+					  const QString& name,
+					  qint64 start,
+					  const QJsonObject& args = QJsonObject());
+
+		/*!
+		 * \brief Records the lifetime of a scope as an event
+		 *
+		 * Nothing is recorded if tracing was off when the scope
+		 * was entered.
+		 */
+		class LIB_EXPORT Scope
+		{
+			public:
+				/*! Starts an event in \a category named \a name. */
+				Scope(const char* category, const char* name);
+				/*! Ends the event. */
+				~Scope();
+
+			private:
+				Q_DISABLE_COPY(Scope)
+
+				const char* m_category;
+				const char* m_name;
+				qint64 m_start;
+		};
+
+	private:
+		TraceLog();
+};
+
+#endif // TRACELOG_H
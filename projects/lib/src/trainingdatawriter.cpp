@@ -0,0 +1,153 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "trainingdatawriter.h"
+#include <QIODevice>
+#include <QScopedPointer>
+#include "pgngame.h"
+#include "board/board.h"
+
+namespace {
+
+void writeVarint(QByteArray* out, quint64 value)
+{
+	while (value >= 0x80)
+	{
+		out->append(char((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out->append(char(value));
+}
+
+bool givesCheck(const QString& san)
+{
+	return san.endsWith('+') || san.endsWith('#');
+}
+
+} // anonymous namespace
+
+TrainingDataWriter::Filter::Filter()
+	: skipCaptures(false),
+	  skipChecks(false),
+	  minDepth(0)
+{
+}
+
+QByteArray TrainingDataWriter::fileHeader()
+{
+	QByteArray header("CCTD");
+	header.append(char(FormatVersion));
+	return header;
+}
+
+TrainingDataWriter::TrainingDataWriter(QIODevice* device)
+	: m_device(nullptr),
+	  m_headerWritten(false)
+{
+	setDevice(device);
+}
+
+QIODevice* TrainingDataWriter::device() const
+{
+	return m_device;
+}
+
+void TrainingDataWriter::setDevice(QIODevice* device)
+{
+	m_device = device;
+	m_headerWritten = false;
+}
+
+TrainingDataWriter::Filter TrainingDataWriter::filter() const
+{
+	return m_filter;
+}
+
+void TrainingDataWriter::setFilter(const Filter& filter)
+{
+	m_filter = filter;
+}
+
+int TrainingDataWriter::write(const PgnGame& game,
+			      const QVector<MoveEvaluation>& evaluations)
+{
+	if (m_device == nullptr)
+		return -1;
+
+	const Chess::Result result(game.result());
+	if (result.winner().isNull() && !result.isDraw())
+		return 0;
+
+	QScopedPointer<Chess::Board> board(game.createBoard());
+	if (board.isNull())
+		return -1;
+
+	m_data.resize(0);
+	if (!m_headerWritten && m_device->size() == 0)
+		m_data = fileHeader();
+
+	int count = 0;
+	const QVector<PgnGame::MoveData>& moves = game.moves();
+	const int size = qMin(moves.size(), evaluations.size());
+	for (int i = 0; i < size; i++)
+	{
+		const PgnGame::MoveData& md = moves.at(i);
+		const MoveEvaluation& eval = evaluations.at(i);
+
+		bool keep = !eval.isBookEval()
+			 && eval.score() != MoveEvaluation::NULL_SCORE
+			 && eval.depth() >= m_filter.minDepth;
+		if (keep && m_filter.skipCaptures && md.moveString.contains('x'))
+			keep = false;
+		if (keep && m_filter.skipChecks && i > 0
+		&&  givesCheck(moves.at(i - 1).moveString))
+			keep = false;
+
+		if (keep)
+		{
+			const Chess::Side side(board->sideToMove());
+			const QByteArray fen(board->fenString().toLatin1());
+			writeVarint(&m_data, quint64(fen.size()));
+			m_data.append(fen);
+
+			const qint64 score = eval.score();
+			writeVarint(&m_data, (quint64(score) << 1) ^ quint64(score >> 63));
+
+			qint8 points = 0;
+			if (result.winner() == side)
+				points = 1;
+			else if (result.loser() == side)
+				points = -1;
+			m_data.append(char(points));
+			count++;
+		}
+
+		const Chess::Move move(board->moveFromGenericMove(md.move));
+		if (move.isNull())
+			return -1;
+		board->makeMove(move);
+	}
+
+	if (count == 0)
+		return 0;
+	if (m_device->write(m_data) != m_data.size())
+		return -1;
+	m_headerWritten = true;
+
+	return count;
+}
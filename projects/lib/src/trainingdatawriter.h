@@ -0,0 +1,104 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef TRAININGDATAWRITER_H
+#define TRAININGDATAWRITER_H
+
+#include <QByteArray>
+#include <QVector>
+#include "moveevaluation.h"
+class QIODevice;
+class PgnGame;
+
+/*!
+ * \brief Writes the positions of games as training data.
+ *
+ * A training data file starts with the bytes "CCTD" and a format
+ * version, followed by one record per position. Each record contains:
+ * - the FEN string of the position as a length-prefixed string
+ * - the score of the engine to move, as a zigzag varint in the
+ *   units of MoveEvaluation::score()
+ * - the result of the game for the side to move as a signed byte:
+ *   1 for a win, 0 for a draw and -1 for a loss
+ *
+ * Only positions where an engine made a move with a score are written,
+ * so book moves and opening moves are skipped, and so are games that
+ * have no result. The Filter can skip more positions.
+ *
+ * \sa CompactGameWriter
+ */
+class LIB_EXPORT TrainingDataWriter
+{
+	public:
+		/*! The current version of the format. */
+		static const int FormatVersion = 1;
+
+		/*! Rules for skipping positions. */
+		struct Filter
+		{
+			/*! Creates a filter that keeps every position. */
+			Filter();
+
+			/*! Skip positions where the move played is a capture. */
+			bool skipCaptures;
+			/*! Skip positions where the side to move is in check. */
+			bool skipChecks;
+			/*! Skip positions searched to less than this depth. */
+			int minDepth;
+		};
+
+		/*! Returns the header of a training data file. */
+		static QByteArray fileHeader();
+
+		/*! Creates a new writer that writes to \a device. */
+		explicit TrainingDataWriter(QIODevice* device = nullptr);
+
+		/*! Returns the output device. */
+		QIODevice* device() const;
+		/*!
+		 * Sets the output device to \a device.
+		 *
+		 * The file header is written first if the device is empty.
+		 */
+		void setDevice(QIODevice* device);
+
+		/*! Returns the position filter. */
+		Filter filter() const;
+		/*! Sets the position filter to \a filter. */
+		void setFilter(const Filter& filter);
+
+		/*!
+		 * Writes the positions of \a game with the move evaluations
+		 * \a evaluations, where evaluations[N] is the evaluation of
+		 * move N.
+		 *
+		 * Captures and checks are recognized from the SAN moves of
+		 * the game. Returns the number of positions written, or -1
+		 * if the positions could not be written.
+		 */
+		int write(const PgnGame& game,
+			  const QVector<MoveEvaluation>& evaluations);
+
+	private:
+		QIODevice* m_device;
+		bool m_headerWritten;
+		Filter m_filter;
+		QByteArray m_data;
+};
+
+#endif // TRAININGDATAWRITER_H
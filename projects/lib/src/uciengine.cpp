@@ -19,6 +19,7 @@
 
 #include <QString>
 #include <QStringList>
+#include <QMetaMethod>
 
 #include "board/board.h"
 #include "board/boardfactory.h"
@@ -32,6 +33,29 @@
 
 namespace {
 
+// The keywords of an info line
+const QString s_infoTypes[] =
+{
+	"depth",
+	"seldepth",
+	"time",
+	"nodes",
+	"pv",
+	"multipv",
+	"score",
+	"currmove",
+	"currmovenumber",
+	"hashfull",
+	"nps",
+	"tbhits",
+	"cpuload",
+	"string",
+	"refutation",
+	"currline"
+};
+// The index of "pv" in s_infoTypes
+const int InfoPvType = 4;
+
 QString variantFromUci(QString str, bool uciPrefix = true)
 {
 	if (uciPrefix)
@@ -47,7 +71,7 @@ QString variantFromUci(QString str, bool uciPrefix = true)
 	if (str == "chess960")
 		str = "fischerandom";
 
-	if (!Chess::BoardFactory::variants().contains(str))
+	if (!Chess::BoardFactory::isVariant(str))
 		return QString();
 	return str;
 }
@@ -84,8 +108,11 @@ QStringRef joinTokens(const QVarLengthArray<QStringRef>& tokens)
 
 UciEngine::UciEngine(QObject* parent)
 	: ChessEngine(parent),
+	  m_sentMovesLength(-1),
+	  m_canSendIncremental(false),
 	  m_useDirectPv(false),
 	  m_sendOpponentsName(false),
+	  m_sendNewGame(true),
 	  m_canPonder(false),
 	  m_ponderState(NotPondering),
 	  m_movesPondered(0),
@@ -95,6 +122,17 @@ UciEngine::UciEngine(QObject* parent)
 {
 	addVariant("standard");
 	setName("UciEngine");
+
+	// Debug output and the root move being searched
+	addOptionalPrefix("info string");
+	addOptionalPrefix("info currmove");
+	addOptionalPrefix("info currline");
+	addOptionalPrefix("info refutation");
+}
+
+void UciEngine::setNewGameEnabled(bool enabled)
+{
+	m_sendNewGame = enabled;
 }
 
 void UciEngine::startProtocol()
@@ -105,16 +143,37 @@ void UciEngine::startProtocol()
 
 QString UciEngine::positionString()
 {
-	QString str("position");
+	QString str;
+	const int newLength = m_moveStrings.size() - m_sentMovesLength;
 
-	if (board()->isRandomVariant() || m_startFen != board()->defaultFenString())
-		str += QString(" fen ") + m_startFen;
+	if (m_canSendIncremental && m_sentMovesLength != -1 && newLength > 0)
+	{
+		str.reserve(14 + newLength);
+		str += "position moves";
+		str += m_moveStrings.midRef(m_sentMovesLength);
+	}
 	else
-		str += " startpos";
+	{
+		// Reserve the whole command to build it without reallocations
+		str.reserve(m_startFen.size() + m_moveStrings.size() + 20);
+		str += "position";
 
-	if (!m_moveStrings.isEmpty())
-		str += QString(" moves") + m_moveStrings;
+		if (board()->isRandomVariant() || m_startFen != board()->defaultFenString())
+		{
+			str += " fen ";
+			str += m_startFen;
+		}
+		else
+			str += " startpos";
 
+		if (!m_moveStrings.isEmpty())
+		{
+			str += " moves";
+			str += m_moveStrings;
+		}
+	}
+
+	m_sentMovesLength = m_moveStrings.size();
 	return str;
 }
 
@@ -123,6 +182,21 @@ void UciEngine::sendPosition()
 	write(positionString());
 }
 
+void UciEngine::appendMove(const QString& moveString)
+{
+	m_moveStrings += ' ';
+	m_moveStrings += moveString;
+}
+
+void UciEngine::removeLastMove()
+{
+	m_moveStrings.truncate(m_moveStrings.lastIndexOf(' '));
+
+	// The engine can't take back a move it already received
+	if (m_sentMovesLength > m_moveStrings.size())
+		m_sentMovesLength = -1;
+}
+
 void UciEngine::startGame()
 {
 	Q_ASSERT(supportsVariant(board()->variant()));
@@ -131,12 +205,15 @@ void UciEngine::startGame()
 	m_ignoreThinking = false;
 	m_rePing = false;
 	m_ponderState = NotPondering;
+	m_ponderTimer.invalidate();
 	m_ponderMove = Chess::Move();
 	m_ponderMoveSan.clear();
 	m_movesPondered = 0;
 	m_ponderHits = 0;
 	m_bmBuffer.clear();
 	m_moveStrings.clear();
+	m_moveStrings.reserve(1024);
+	m_sentMovesLength = -1;
 	m_useDirectPv = directPvList.contains(board()->variant());
 
 	if (board()->isRandomVariant())
@@ -145,10 +222,13 @@ void UciEngine::startGame()
 		m_startFen = board()->fenString(Chess::Board::XFen);
 	setVariant(board()->variant());
 
-	write("ucinewgame");
+	if (m_sendNewGame)
+		write("ucinewgame");
 
 	if (m_canPonder)
 		sendOption("Ponder", pondering());
+	if (m_canSendIncremental)
+		sendOption("UCI_IncrementalPosition", true);
 
 	if (m_sendOpponentsName)
 	{
@@ -183,11 +263,16 @@ void UciEngine::makeMove(const Chess::Move& move)
 			if (gotPonderHit)
 				m_ponderState = PonderHit;
 
+			// The timer isn't running if no ponder search was started
+			addPonderResult(gotPonderHit, m_ponderTimer.isValid()
+						       ? m_ponderTimer.nsecsElapsed() : 0);
+			m_ponderTimer.invalidate();
+
 			m_ponderMove = Chess::Move();
 			m_ponderMoveSan.clear();
 			if (m_ponderState != PonderHit)
 			{
-				m_moveStrings.truncate(m_moveStrings.lastIndexOf(' '));
+				removeLastMove();
 				if (isReady())
 				{
 					m_ignoreThinking = true;
@@ -207,7 +292,7 @@ void UciEngine::makeMove(const Chess::Move& move)
 	if (m_ponderState != PonderHit)
 	{
 		m_ponderState = NotPondering;
-		m_moveStrings += " " + board()->moveString(move, Chess::Board::LongAlgebraic);
+		appendMove(board()->moveString(move, Chess::Board::LongAlgebraic));
 		if (m_ignoreThinking)
 			m_bmBuffer << positionString() << "isready";
 		else
@@ -226,10 +311,15 @@ void UciEngine::makeBookMove(const Chess::Move& move)
 
 void UciEngine::startThinking()
 {
+	m_pvInfo.clear();
+
 	if (m_ponderState == PonderHit)
 	{
+		// The engine's clock is already running, so the command
+		// doesn't wait for the end of the event
 		m_ponderState = NotPondering;
 		write("ponderhit");
+		flush();
 		return;
 	}
 
@@ -254,6 +344,7 @@ void UciEngine::startThinking()
 	{
 		command += " ponder";
 		m_ponderState = Pondering;
+		m_ponderTimer.start();
 	}
 	else
 		m_ponderState = NotPondering;
@@ -288,7 +379,7 @@ void UciEngine::startPondering()
 	if (!pondering() || m_ponderMove.isNull())
 		return;
 
-	m_moveStrings += " " + board()->moveString(m_ponderMove, Chess::Board::LongAlgebraic);
+	appendMove(board()->moveString(m_ponderMove, Chess::Board::LongAlgebraic));
 	sendPosition();
 	ping();
 	startThinking();
@@ -447,26 +538,6 @@ void UciEngine::parseInfo(const QVarLengthArray<QStringRef>& tokens,
 
 void UciEngine::parseInfo(const QStringRef& line)
 {
-	static const QString types[] =
-	{
-		"depth",
-		"seldepth",
-		"time",
-		"nodes",
-		"pv",
-		"multipv",
-		"score",
-		"currmove",
-		"currmovenumber",
-		"hashfull",
-		"nps",
-		"tbhits",
-		"cpuload",
-		"string",
-		"refutation",
-		"currline"
-	};
-
 	int type = -1;
 	QStringRef token(nextToken(line));
 	QVarLengthArray<QStringRef> tokens;
@@ -477,12 +548,33 @@ void UciEngine::parseInfo(const QStringRef& line)
 	if (token == "string")
 		return;
 
+	// Without a receiver for thinking() only the primary PV of the
+	// last info line is needed, and only when the engine moves
+	static const QMetaMethod thinkingSignal(
+		QMetaMethod::fromSignal(&ChessPlayer::thinking));
+	const bool lazy = !isSignalConnected(thinkingSignal);
+	bool hasPv = false;
+
 	while (!token.isNull())
 	{
-		token = parseUciTokens(token, types, 16, tokens, type);
+		token = parseUciTokens(token, s_infoTypes, 16, tokens, type);
+		if (type == InfoPvType)
+		{
+			hasPv = true;
+			if (lazy)
+				continue;
+		}
 		parseInfo(tokens, type, &eval);
 	}
-	if (eval.isEmpty())
+
+	if (hasPv && eval.pvNumber() <= 1)
+	{
+		if (lazy && state() == Thinking)
+			m_pvInfo = *line.string();
+		else
+			m_pvInfo.clear();
+	}
+	if (eval.isEmpty() || (lazy && eval.pvNumber() > 1))
 		return;
 
 	if (!m_ponderMove.isNull())
@@ -491,7 +583,9 @@ void UciEngine::parseInfo(const QStringRef& line)
 		eval.setPonderhitRate((m_ponderHits * 1000) / m_movesPondered);
 
 	// Only the primary PV can be considered the current eval
-	if (eval.pvNumber() <= 1)
+	if (lazy)
+		m_eval.merge(eval);
+	else if (eval.pvNumber() <= 1)
 	{
 		m_eval.merge(eval);
 		if (eval.depth() && eval.depth() != m_currentEval.depth())
@@ -504,6 +598,22 @@ void UciEngine::parseInfo(const QStringRef& line)
 		emit thinking(eval);
 }
 
+QString UciEngine::pvFromInfo(const QString& line)
+{
+	int type = -1;
+	QStringRef token(nextToken(firstToken(line)));
+	QVarLengthArray<QStringRef> tokens;
+
+	while (!token.isNull())
+	{
+		token = parseUciTokens(token, s_infoTypes, 16, tokens, type);
+		if (type == InfoPvType && !tokens.isEmpty())
+			return m_useDirectPv ? directPv(tokens) : sanPv(tokens);
+	}
+
+	return QString();
+}
+
 EngineOption* UciEngine::parseOption(const QStringRef& line)
 {
 	enum Keyword
@@ -625,7 +735,7 @@ void UciEngine::parseLine(const QString& line)
 				 qUtf8Printable(name()));
 			m_ponderMove = Chess::Move();
 			m_ponderMoveSan.clear();
-			m_moveStrings.truncate(m_moveStrings.lastIndexOf(' '));
+			removeLastMove();
 			pong();
 			return;
 		}
@@ -641,7 +751,7 @@ void UciEngine::parseLine(const QString& line)
 
 		QStringRef token(nextToken(command));
 		QString moveString(token.toString());
-		m_moveStrings += " " + moveString;
+		appendMove(moveString);
 		Chess::Move move = board()->moveFromString(moveString);
 		if (move.isNull())
 		{
@@ -656,6 +766,13 @@ void UciEngine::parseLine(const QString& line)
 			board()->undoMove();
 		}
 
+		// The PV was skipped by lazy info parsing
+		if (!m_pvInfo.isEmpty())
+		{
+			m_eval.setPv(pvFromInfo(m_pvInfo));
+			m_pvInfo.clear();
+		}
+
 		emitMove(move);
 	}
 	else if (command == "readyok")
@@ -708,6 +825,9 @@ void UciEngine::parseLine(const QString& line)
 			m_sendOpponentsName = true;
 		else if (option->name() == "Ponder")
 			m_canPonder = true;
+		else if (option->name() == "UCI_IncrementalPosition"
+		     &&  dynamic_cast<EngineCheckOption*>(option) != nullptr)
+			m_canSendIncremental = true;
 		else if (option->name().startsWith("UCI_") &&
 			 option->name() != "UCI_LimitStrength" &&
 			 option->name() != "UCI_Elo")
@@ -849,7 +969,7 @@ QString UciEngine::sanPv(const QVarLengthArray<QStringRef>& tokens)
 	return pv;
 }
 
-void UciEngine::sendOption(const QString& name, const QVariant& value)
+void UciEngine::writeOption(const QString& name, const QVariant& value)
 {
 	if (!value.isNull())
 		write(QString("setoption name %1 value %2").arg(name, value.toString()));
@@ -26,6 +26,13 @@
  * \brief A chess engine which uses the UCI chess interface.
  *
  * UCI's specifications: http://wbec-ridderkerk.nl/html/UCIProtocol.html
+ *
+ * Engines that advertise the check option "UCI_IncrementalPosition" get
+ * it set to true at the start of each game. After that only the moves
+ * made since the previous "position" command are sent, in the form
+ * "position moves <move1> ... <moveN>". A full position is sent at the
+ * start of a game and whenever a move the engine already received is
+ * taken back, eg. after a ponder miss.
  */
 class LIB_EXPORT UciEngine : public ChessEngine
 {
@@ -43,6 +50,14 @@ class LIB_EXPORT UciEngine : public ChessEngine
 		virtual void startPondering();
 		virtual void clearPonderState();
 
+		/*!
+		 * If \a enabled is true (the default), the "ucinewgame"
+		 * command is sent at the start of each game. Otherwise the
+		 * engine can keep its state from the previous game, which
+		 * helps when the "games" are searches of related positions.
+		 */
+		void setNewGameEnabled(bool enabled);
+
 	protected:
 		// Inherited from ChessEngine
 		virtual bool sendPing();
@@ -52,7 +67,7 @@ class LIB_EXPORT UciEngine : public ChessEngine
 		virtual void startGame();
 		virtual void startThinking();
 		virtual void parseLine(const QString& line);
-		virtual void sendOption(const QString& name, const QVariant& value);
+		virtual void writeOption(const QString& name, const QVariant& value);
 		virtual bool isPondering() const;
 		
 	private:
@@ -72,11 +87,14 @@ class LIB_EXPORT UciEngine : public ChessEngine
 			       int type,
 			       MoveEvaluation* eval);
 		void parseInfo(const QStringRef& line);
+		QString pvFromInfo(const QString& line);
 		EngineOption* parseOption(const QStringRef& line);
 		void addVariantsFromOption(const EngineOption* option);
 		void setVariant(const QString& variant);
 		QString positionString();
 		void sendPosition();
+		void appendMove(const QString& moveString);
+		void removeLastMove();
 		void setPonderMove(const QString& moveString);
 		QString directPv(const QVarLengthArray<QStringRef>& tokens);
 		QString sanPv(const QVarLengthArray<QStringRef>& tokens);
@@ -84,13 +102,19 @@ class LIB_EXPORT UciEngine : public ChessEngine
 		QString m_variantOption;
 		QString m_startFen;
 		QString m_moveStrings;
+		// Length of m_moveStrings when the last position was sent,
+		// or -1 if the next position must be sent in full
+		int m_sentMovesLength;
+		bool m_canSendIncremental;
 		bool m_useDirectPv;
 		// Write buffer for messages that will be flushed to the engine
 		// after it sends a "bestmove"
 		QStringList m_bmBuffer;
 		bool m_sendOpponentsName;
+		bool m_sendNewGame;
 		bool m_canPonder;
 		PonderState m_ponderState;
+		QElapsedTimer m_ponderTimer;
 		Chess::Move m_ponderMove;
 		QString m_ponderMoveSan;
 		int m_movesPondered;
@@ -98,6 +122,8 @@ class LIB_EXPORT UciEngine : public ChessEngine
 		bool m_ignoreThinking;
 		bool m_rePing;
 		MoveEvaluation m_currentEval;
+		// The last primary PV info line whose PV hasn't been parsed
+		QString m_pvInfo;
 		QStringList m_comboVariants;
 };
 
@@ -18,7 +18,7 @@
 #include "worker.h"
 
 Worker::Worker(const QString& title)
-	: QObject(nullptr), QRunnable(), m_cancel(false), m_title(title)
+	: QObject(nullptr), QRunnable(), m_title(title)
 {
 }
 
@@ -28,12 +28,12 @@ Worker::~Worker()
 
 void Worker::cancel()
 {
-	m_cancel = true;
+	m_cancellationToken.cancel();
 }
 
 bool Worker::cancelRequested() const
 {
-	return m_cancel;
+	return m_cancellationToken.isCancelled();
 }
 
 QTime Worker::startTime() const
@@ -46,13 +46,18 @@ QString Worker::title() const
 	return m_title;
 }
 
+CancellationToken Worker::cancellationToken() const
+{
+	return m_cancellationToken;
+}
+
 void Worker::run()
 {
 	m_startTime = QTime::currentTime();
 	emit started();
 
 	work();
-	if (m_cancel)
+	if (cancelRequested())
 		emit cancelled();
 
 	emit finished();
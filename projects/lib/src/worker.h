@@ -22,6 +22,7 @@
 #include <QRunnable>
 #include <QTime>
 #include <QString>
+#include "cancellationtoken.h"
 
 /*!
  * An abstraction of a long-running task.
@@ -43,6 +44,13 @@ class LIB_EXPORT Worker : public QObject, public QRunnable
 		QTime startTime() const;
 		/*! Returns the title of the worker. */
 		QString title() const;
+		/*!
+		 * Returns the worker's cancellation token.
+		 *
+		 * Helper jobs started by the worker can poll a copy of
+		 * the token to stop when the worker is cancelled.
+		 */
+		CancellationToken cancellationToken() const;
 
 		// Inherited from QRunnable
 		void run() override;
@@ -115,7 +123,7 @@ class LIB_EXPORT Worker : public QObject, public QRunnable
 		bool cancelRequested() const;
 
 	private:
-		bool m_cancel;
+		CancellationToken m_cancellationToken;
 		QString m_title;
 		QTime m_startTime;
 };
@@ -22,10 +22,12 @@
 #include <QString>
 #include <QStringList>
 #include <QTimer>
+#include <QMetaMethod>
 
 #include <climits>
 
 #include "timecontrol.h"
+#include "timerwheel.h"
 #include "enginebuttonoption.h"
 #include "enginecheckoption.h"
 #include "enginecombooption.h"
@@ -63,6 +65,20 @@ QString variantToXboard(const QString& str)
 
 const int s_infiniteSec = 86400;
 
+// The search depth that starts a line of thinking output: digits with
+// an optional one-character suffix. Old engines' moves ("1. ... e2e4")
+// and results ("1-0") don't qualify.
+bool isDepthToken(const QStringRef& token)
+{
+	int i = 0;
+	while (i < token.size() && token.at(i).isDigit())
+		i++;
+	if (i == 0)
+		return false;
+	return i == token.size()
+	    || (i == token.size() - 1 && token.at(i) != '.');
+}
+
 } // anonymous namespace
 
 XboardEngine::XboardEngine(QObject* parent)
@@ -79,14 +95,16 @@ XboardEngine::XboardEngine(QObject* parent)
 	  m_gotResult(false),
 	  m_lastPing(0),
 	  m_notation(Chess::Board::LongAlgebraic),
-	  m_initTimer(new QTimer(this))
+	  m_initTimer(new WheelTimer(this))
 {
-	m_initTimer->setSingleShot(true);
 	m_initTimer->setInterval(8000);
 	connect(m_initTimer, SIGNAL(timeout()), this, SLOT(initialize()));
 
 	addVariant("standard");
 	setName("XboardEngine");
+
+	// Debug output
+	addOptionalPrefix("#");
 }
 
 void XboardEngine::startProtocol()
@@ -116,6 +134,7 @@ void XboardEngine::startGame()
 	m_gotResult = false;
 	m_forceMode = false;
 	m_nextMove = Chess::Move();
+	m_pvLine.clear();
 	write("new");
 	
 	if (board()->variant() != "standard")
@@ -349,6 +368,7 @@ void XboardEngine::startThinking()
 {
 	setForceMode(false);
 	sendTimeLeft();
+	m_pvLine.clear();
 
 	if (m_nextMove.isNull())
 		write("go");
@@ -356,6 +376,70 @@ void XboardEngine::startThinking()
 		makeMove(m_nextMove);
 }
 
+void XboardEngine::parseThinking(const QString& line, QStringRef token)
+{
+	bool ok = false;
+
+	// Search depth
+	QStringRef depth(token);
+	if (!depth.at(depth.size() - 1).isDigit())
+		depth = depth.left(depth.size() - 1);
+	m_eval.setDepth(depth.toInt());
+
+	// Evaluation
+	if ((token = nextToken(token)).isNull())
+		return;
+	int score = token.toInt(&ok);
+	if (ok)
+	{
+		if (whiteEvalPov() && side() == Chess::Side::Black)
+			score = -score;
+		m_eval.setScore(adaptScore(score));
+	}
+
+	// Search time in centiseconds
+	if ((token = nextToken(token)).isNull())
+		return;
+	int time = token.toInt(&ok);
+	if (ok)
+		m_eval.setTime(time * 10);
+
+	// Node count
+	if ((token = nextToken(token)).isNull())
+		return;
+	quint64 nodes = token.toULongLong(&ok);
+	if (ok)
+		m_eval.setNodeCount(nodes);
+
+	// Principal variation
+	if ((token = nextToken(token, true)).isNull())
+		return;
+
+	// Without a receiver for thinking() the PV is only needed when
+	// the engine moves. Keeping the line shares its data.
+	static const QMetaMethod thinkingSignal(
+		QMetaMethod::fromSignal(&ChessPlayer::thinking));
+	if (!isSignalConnected(thinkingSignal))
+	{
+		if (state() == Thinking)
+			m_pvLine = line;
+		return;
+	}
+
+	m_eval.setPv(token.toString());
+	emit thinking(m_eval);
+}
+
+QString XboardEngine::pvFromThinking(const QString& line) const
+{
+	// The PV follows the depth, score, time and node count
+	QStringRef token(firstToken(line));
+	for (int i = 0; i < 3 && !token.isNull(); i++)
+		token = nextToken(token);
+
+	return nextToken(token, true).toString();
+}
+
 void XboardEngine::onTimeout()
 {
 	if (m_drawOnNextMove)
@@ -596,6 +680,14 @@ void XboardEngine::parseLine(const QString& line)
 	if (command.isEmpty())
 		return;
 
+	// Thinking output is by far the most common line, so it's
+	// recognized first and parsed without copying the tokens
+	if (isDepthToken(command))
+	{
+		parseThinking(line, command);
+		return;
+	}
+
 	if (command == "1-0" || command == "0-1"
 	||  command == "*" || command == "1/2-1/2" || command == "resign")
 	{
@@ -636,53 +728,6 @@ void XboardEngine::parseLine(const QString& line)
 
 		return;
 	}
-	else if (command.at(0).isDigit()
-	     && !command.contains("."))	// principal variation
-	{
-		bool ok = false;
-		int val = 0;
-		QStringRef ref(command);
-		
-		// Search depth
-		QString depth(ref.toString());
-		if (!(depth.cend() - 1)->isDigit())
-			depth.chop(1);
-		m_eval.setDepth(depth.toInt());
-
-		// Evaluation
-		if ((ref = nextToken(ref)).isNull())
-			return;
-		val = ref.toString().toInt(&ok);
-		if (ok)
-		{
-			if (whiteEvalPov() && side() == Chess::Side::Black)
-				val = -val;
-			m_eval.setScore(adaptScore(val));
-		}
-
-		// Search time
-		if ((ref = nextToken(ref)).isNull())
-			return;
-		val = ref.toString().toInt(&ok);
-		if (ok)
-			m_eval.setTime(val * 10);
-
-		// Node count
-		if ((ref = nextToken(ref)).isNull())
-			return;
-		val = ref.toString().toULongLong(&ok);
-		if (ok)
-			m_eval.setNodeCount(val);
-
-		// Principal variation
-		if ((ref = nextToken(ref, true)).isNull())
-			return;
-		m_eval.setPv(ref.toString());
-
-		emit thinking(m_eval);
-
-		return;
-	}
 
 	// move format of old CECP engines: 1. ... e2e4
 	bool testDigitAndDot = command.at(0).isDigit() && command.contains(".");
@@ -729,6 +774,13 @@ void XboardEngine::parseLine(const QString& line)
 			}
 		}
 
+		// The PV was skipped by lazy thinking output parsing
+		if (!m_pvLine.isEmpty())
+		{
+			m_eval.setPv(pvFromThinking(m_pvLine));
+			m_pvLine.clear();
+		}
+
 		emitMove(move);
 	}
 	else if (command == "pong")
@@ -775,7 +827,7 @@ void XboardEngine::parseLine(const QString& line)
 	}
 }
 
-void XboardEngine::sendOption(const QString& name, const QVariant& value)
+void XboardEngine::writeOption(const QString& name, const QVariant& value)
 {
 	if (name == "memory" || name == "cores" || name.startsWith("egtpath "))
 		write(name + " " + value.toString());
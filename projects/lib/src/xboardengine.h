@@ -49,7 +49,7 @@ class LIB_EXPORT XboardEngine : public ChessEngine
 		virtual void startGame();
 		virtual void startThinking();
 		virtual void parseLine(const QString& line);
-		virtual void sendOption(const QString& name, const QVariant& value);
+		virtual void writeOption(const QString& name, const QVariant& value);
 		virtual bool restartsBetweenGames() const;
 
 	protected slots:
@@ -66,6 +66,8 @@ class LIB_EXPORT XboardEngine : public ChessEngine
 		void setForceMode(bool enable);
 		void sendTimeLeft();
 		void finishGame();
+		void parseThinking(const QString& line, QStringRef token);
+		QString pvFromThinking(const QString& line) const;
 		QString moveString(const Chess::Move& move);
 		int adaptScore(int score) const;
 		const QString transformMove(const QString& str, int height, int shift) const;
@@ -86,8 +88,9 @@ class LIB_EXPORT XboardEngine : public ChessEngine
 		int m_lastPing;
 		Chess::Move m_nextMove;
 		QString m_nextMoveString;
+		QString m_pvLine;
 		Chess::Board::MoveNotation m_notation;
-		QTimer* m_initTimer;
+		WheelTimer* m_initTimer;
 };
 
 #endif // XBOARDENGINE_H
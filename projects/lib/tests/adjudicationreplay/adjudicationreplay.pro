@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_adjudicationreplay
+SOURCES += tst_adjudicationreplay.cpp
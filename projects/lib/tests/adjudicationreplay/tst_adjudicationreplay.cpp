@@ -0,0 +1,104 @@
+#include <QtTest/QtTest>
+#include <adjudicationreplay.h>
+#include <moveevaluation.h>
+#include <pgngame.h>
+#include <pgnstream.h>
+
+
+class tst_AdjudicationReplay: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void pgnComment_data() const;
+		void pgnComment() const;
+		void replayGame() const;
+};
+
+
+void tst_AdjudicationReplay::pgnComment_data() const
+{
+	QTest::addColumn<QString>("comment");
+	QTest::addColumn<int>("score");
+	QTest::addColumn<int>("depth");
+	QTest::addColumn<int>("time");
+
+	const int nullScore = MoveEvaluation::NULL_SCORE;
+	const int mate = MoveEvaluation::MATE_SCORE;
+
+	QTest::newRow("positive") << "+0.31/13 4.5s" << 31 << 13 << 4500;
+	QTest::newRow("negative") << "-1.05/20 0.120s" << -105 << 20 << 120;
+	QTest::newRow("mate") << "+M5/30 1s" << mate - 5 << 30 << 1000;
+	QTest::newRow("mated") << "-M6/30 1s" << -(mate - 6) << 30 << 1000;
+	QTest::newRow("result") << "0.00/9 2.1s, Draw by 3-fold repetition"
+				<< 0 << 9 << 2100;
+	QTest::newRow("no depth") << "0s" << nullScore << 0 << 0;
+	QTest::newRow("text") << "a nice move" << nullScore << 0 << 0;
+}
+
+void tst_AdjudicationReplay::pgnComment() const
+{
+	QFETCH(QString, comment);
+	QFETCH(int, score);
+	QFETCH(int, depth);
+	QFETCH(int, time);
+
+	const MoveEvaluation eval(MoveEvaluation::fromPgnComment(comment));
+	QCOMPARE(eval.score(), score);
+	QCOMPARE(eval.depth(), depth);
+	QCOMPARE(eval.time(), time);
+
+	if (depth > 0)
+	{
+		QCOMPARE(MoveEvaluation::fromPgnComment(eval.pgnComment()), eval);
+	}
+
+	QVERIFY(MoveEvaluation::fromPgnComment("book").isBookEval());
+}
+
+void tst_AdjudicationReplay::replayGame() const
+{
+	QByteArray pgn(
+		"[Result \"1-0\"]\n\n"
+		"1. e4 {+0.30/10 1s} e5 {-0.20/10 1s} "
+		"2. Qh5 {-5.00/10 1s} Nc6 {+5.10/10 1s} "
+		"3. Bc4 {-5.00/10 1s} Nf6 {+5.00/10 1s} "
+		"4. Qxf7# {+M1/10 1s, White mates} 1-0\n");
+	PgnStream in(&pgn);
+	PgnGame game;
+	QVERIFY(game.read(in));
+	QCOMPARE(game.moves().size(), 7);
+
+	AdjudicationReplay replay;
+	GameAdjudicator resign;
+	resign.setResignThreshold(2, -400);
+	replay.addCandidate("resign", resign);
+	GameAdjudicator draw;
+	draw.setDrawThreshold(1, 1, 50);
+	replay.addCandidate("draw", draw);
+	replay.addCandidate("none", GameAdjudicator());
+	QCOMPARE(replay.candidateCount(), 3);
+	QCOMPARE(replay.candidateName(1), QString("draw"));
+
+	const AdjudicationReplay::Statistics empty = { 0, 0, 0, 0 };
+	QVector<AdjudicationReplay::Statistics> stats(3, empty);
+	replay.replayGame(game, &stats);
+
+	// White "resigns" after 3. Bc4
+	QCOMPARE(stats[0].games, Q_INT64_C(1));
+	QCOMPARE(stats[0].adjudicated, Q_INT64_C(1));
+	QCOMPARE(stats[0].pliesSaved, Q_INT64_C(2));
+	QCOMPARE(stats[0].wrongResults, Q_INT64_C(1));
+
+	// Drawn after 1... e5
+	QCOMPARE(stats[1].adjudicated, Q_INT64_C(1));
+	QCOMPARE(stats[1].pliesSaved, Q_INT64_C(5));
+	QCOMPARE(stats[1].wrongResults, Q_INT64_C(1));
+
+	QCOMPARE(stats[2].games, Q_INT64_C(1));
+	QCOMPARE(stats[2].adjudicated, Q_INT64_C(0));
+	QCOMPARE(stats[2].pliesSaved, Q_INT64_C(0));
+}
+
+QTEST_MAIN(tst_AdjudicationReplay)
+#include "tst_adjudicationreplay.moc"
@@ -21,6 +21,10 @@ class tst_Board: public QObject
 		void results_data() const;
 		void results();
 
+		void pieceCounts();
+
+		void variantInfo();
+
 		void perft_data() const;
 		void perft();
 
@@ -1001,6 +1005,88 @@ void tst_Board::results()
 	QCOMPARE(m_board->result().toShortString(), result);
 }
 
+void tst_Board::pieceCounts()
+{
+	setVariant("standard");
+	QVERIFY(m_board->setFenString(m_board->defaultFenString()));
+	QCOMPARE(m_board->pieceCount(), 32);
+	QCOMPARE(m_board->pieceCount(Chess::Side::White), 16);
+	QCOMPARE(m_board->pieceCount(Chess::Side::NoSide, 1), 16);
+	QCOMPARE(m_board->pieceCount(Chess::Side::Black, 5), 1);
+	const quint64 startKey = m_board->materialKey();
+
+	// 1. e4 d5 2. exd5
+	const QStringList moves = { "e4", "d5", "exd5" };
+	for (const QString& str : moves)
+	{
+		auto move = m_board->moveFromString(str);
+		QVERIFY(!move.isNull());
+		m_board->makeMove(move);
+	}
+	QCOMPARE(m_board->pieceCount(), 31);
+	QCOMPARE(m_board->pieceCount(Chess::Side::Black, 1), 7);
+	const quint64 captureKey = m_board->materialKey();
+	QVERIFY(captureKey != startKey);
+
+	// The same material on another board has the same key
+	Chess::Board* board = m_board->copy();
+	QVERIFY(board->setFenString(
+		"rnbqkbnr/ppp2ppp/8/4p3/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 0 1"));
+	QCOMPARE(board->pieceCount(), 31);
+	QCOMPARE(board->materialKey(), captureKey);
+	delete board;
+
+	for (int i = 0; i < moves.size(); i++)
+		m_board->undoMove();
+	QCOMPARE(m_board->pieceCount(), 32);
+	QCOMPARE(m_board->materialKey(), startKey);
+
+	// Knights out and back twice
+	const QStringList shuffle = { "Nf3", "Nf6", "Ng1", "Ng8" };
+	for (int i = 1; i <= 2; i++)
+	{
+		for (const QString& str : shuffle)
+			m_board->makeMove(m_board->moveFromString(str));
+		QCOMPARE(m_board->repeatCount(), i);
+	}
+	m_board->undoMove();
+	QCOMPARE(m_board->repeatCount(), 1);
+}
+
+void tst_Board::variantInfo()
+{
+	using Chess::BoardFactory;
+
+	QVERIFY(BoardFactory::isVariant("crazyhouse"));
+	QVERIFY(!BoardFactory::isVariant("nonexistent"));
+	QCOMPARE(BoardFactory::variantId("nonexistent"), -1);
+	QVERIFY(BoardFactory::variantInfo("nonexistent") == nullptr);
+
+	const QStringList variants = BoardFactory::variants();
+	for (int i = 0; i < variants.size(); i++)
+	{
+		auto info = BoardFactory::variantInfo(variants.at(i));
+		QVERIFY(info != nullptr);
+		QCOMPARE(info->id, i);
+		QCOMPARE(info->name, variants.at(i));
+		QCOMPARE(BoardFactory::variantId(variants.at(i)), i);
+	}
+
+	auto info = BoardFactory::variantInfo("crazyhouse");
+	QCOMPARE(info->width, 8);
+	QCOMPARE(info->height, 8);
+	QVERIFY(info->hasDrops);
+	QVERIFY(!info->isRandom);
+	QCOMPARE(info->reservePieceTypes.size(), 10);
+
+	info = BoardFactory::variantInfo("fischerandom");
+	QVERIFY(info->isRandom);
+	QVERIFY(!info->hasDrops);
+
+	info = BoardFactory::variantInfo("capablanca");
+	QCOMPARE(info->width, 10);
+}
+
 void tst_Board::perft_data() const
 {
 	QTest::addColumn<QString>("variant");
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_compactpgngame
+SOURCES += tst_compactpgngame.cpp
@@ -0,0 +1,124 @@
+/*
+    This file is part of Cute Chess.
+
+    Cute Chess is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Cute Chess is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Cute Chess.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QtTest/QtTest>
+#include <compactpgngame.h>
+#include <moveevaluation.h>
+#include <board/board.h>
+#include <board/boardfactory.h>
+
+class tst_CompactPgnGame: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void roundTrip_data() const;
+		void roundTrip() const;
+		void nullGame() const;
+};
+
+void tst_CompactPgnGame::roundTrip_data() const
+{
+	QTest::addColumn<QString>("variant");
+	QTest::addColumn<QStringList>("moves");
+	QTest::addColumn<QStringList>("comments");
+
+	QTest::newRow("standard")
+		<< "standard"
+		<< (QStringList() << "e4" << "e5" << "Nf3" << "Nc6" << "Bb5")
+		<< (QStringList() << "book" << "book" << "+0.31/13 4.5s"
+				  << "-1.05/20 0.120s" << "+M5/30 1.0s");
+	QTest::newRow("text comments")
+		<< "standard"
+		<< (QStringList() << "d4" << "d5" << "c4" << "dxc4")
+		<< (QStringList() << "" << "a nice move"
+				  << "0.00/9 2.1s, Draw by 3-fold repetition"
+				  << "+M5/30 1s");
+	QTest::newRow("promotion")
+		<< "standard"
+		<< (QStringList() << "a4" << "h5" << "a5" << "h4" << "a6" << "h3"
+				  << "axb7" << "hxg2" << "bxa8=Q" << "gxh1=N")
+		<< QStringList();
+	QTest::newRow("crazyhouse drop")
+		<< "crazyhouse"
+		<< (QStringList() << "e4" << "d5" << "exd5" << "Qxd5"
+				  << "P@e4" << "Qd8")
+		<< (QStringList() << "" << "" << "" << "" << "+0.20/5 0.010s");
+}
+
+void tst_CompactPgnGame::roundTrip() const
+{
+	QFETCH(QString, variant);
+	QFETCH(QStringList, moves);
+	QFETCH(QStringList, comments);
+
+	Chess::Board* board = Chess::BoardFactory::create(variant);
+	QVERIFY(board != nullptr);
+	board->reset();
+
+	PgnGame game;
+	game.setEvent("Test");
+	game.setVariant(variant);
+	game.setPlayerName(Chess::Side::White, "white");
+	game.setPlayerName(Chess::Side::Black, "black");
+
+	for (int i = 0; i < moves.size(); i++)
+	{
+		Chess::Move move(board->moveFromString(moves.at(i)));
+		QVERIFY(!move.isNull());
+
+		PgnGame::MoveData md;
+		md.key = board->key();
+		md.move = board->genericMove(move);
+		md.moveString = board->moveString(move,
+			Chess::Board::StandardAlgebraic);
+		md.comment = comments.value(i);
+		game.addMove(md);
+		board->makeMove(move);
+	}
+	delete board;
+
+	const CompactPgnGame compactGame(game);
+	QVERIFY(!compactGame.isNull());
+	QCOMPARE(compactGame.moveCount(), moves.size());
+
+	const PgnGame expanded(compactGame.toPgnGame());
+	QCOMPARE(expanded.tags(), game.tags());
+	QCOMPARE(expanded.startingSide(), game.startingSide());
+	QCOMPARE(expanded.moves().size(), game.moves().size());
+	for (int i = 0; i < game.moves().size(); i++)
+	{
+		const PgnGame::MoveData& a = expanded.moves().at(i);
+		const PgnGame::MoveData& b = game.moves().at(i);
+		QCOMPARE(a.key, b.key);
+		QVERIFY(a.move == b.move);
+		QCOMPARE(a.moveString, b.moveString);
+		QCOMPARE(a.comment, b.comment);
+	}
+}
+
+void tst_CompactPgnGame::nullGame() const
+{
+	const CompactPgnGame compactGame;
+	QVERIFY(compactGame.isNull());
+	QCOMPARE(compactGame.moveCount(), 0);
+	QVERIFY(compactGame.toPgnGame().isNull());
+}
+
+QTEST_MAIN(tst_CompactPgnGame)
+#include "tst_compactpgngame.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_cpuallocator
+SOURCES += tst_cpuallocator.cpp
@@ -0,0 +1,78 @@
+#include <QtTest/QtTest>
+#include <cpuallocator.h>
+
+
+class tst_CpuAllocator: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void singleGroup() const;
+		void numaGroups() const;
+		void roundRobin() const;
+		void sharedSlots() const;
+};
+
+
+static QList<int> range(int first, int count)
+{
+	QList<int> list;
+	for (int i = 0; i < count; i++)
+		list << first + i;
+	return list;
+}
+
+void tst_CpuAllocator::singleGroup() const
+{
+	CpuAllocator allocator(2, QList< QList<int> >() << range(0, 8));
+
+	QCOMPARE(allocator.slotCount(), 2);
+	QCOMPARE(allocator.cpus(0, 0), range(0, 2));
+	QCOMPARE(allocator.cpus(0, 1), range(2, 2));
+	QCOMPARE(allocator.cpus(1, 0), range(4, 2));
+	QCOMPARE(allocator.cpus(1, 1), range(6, 2));
+}
+
+void tst_CpuAllocator::numaGroups() const
+{
+	QList< QList<int> > nodes;
+	nodes << range(0, 4) << range(4, 4);
+	CpuAllocator allocator(1, nodes);
+
+	// Consecutive slots alternate between the nodes
+	QCOMPARE(allocator.slotCount(), 4);
+	QCOMPARE(allocator.cpus(0, 0), range(0, 1));
+	QCOMPARE(allocator.cpus(0, 1), range(1, 1));
+	QCOMPARE(allocator.cpus(1, 0), range(4, 1));
+	QCOMPARE(allocator.cpus(1, 1), range(5, 1));
+	QCOMPARE(allocator.cpus(2, 0), range(2, 1));
+	QCOMPARE(allocator.cpus(3, 1), range(7, 1));
+}
+
+void tst_CpuAllocator::roundRobin() const
+{
+	CpuAllocator allocator(1, QList< QList<int> >() << range(0, 6));
+
+	QCOMPARE(allocator.acquire(), 0);
+	QCOMPARE(allocator.acquire(), 1);
+	allocator.release(0);
+
+	// A released slot is reused only after the unused ones
+	QCOMPARE(allocator.acquire(), 2);
+	QCOMPARE(allocator.acquire(), 0);
+}
+
+void tst_CpuAllocator::sharedSlots() const
+{
+	CpuAllocator allocator(4, QList< QList<int> >() << range(0, 6));
+
+	// A group smaller than a game gets one slot with shared cores
+	QCOMPARE(allocator.slotCount(), 1);
+	QCOMPARE(allocator.cpus(0, 1), QList<int>() << 4 << 5 << 0 << 1);
+
+	QCOMPARE(allocator.acquire(), 0);
+	QCOMPARE(allocator.acquire(), 0);
+}
+
+QTEST_MAIN(tst_CpuAllocator)
+#include "tst_cpuallocator.moc"
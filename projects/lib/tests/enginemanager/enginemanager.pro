@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_enginemanager
+SOURCES += tst_enginemanager.cpp
@@ -0,0 +1,73 @@
+#include <QtTest/QtTest>
+#include <enginemanager.h>
+
+
+class tst_EngineManager: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void lookup() const;
+		void variants() const;
+};
+
+static EngineConfiguration engine(const QString& name,
+				  const QStringList& variants = QStringList() << "standard")
+{
+	EngineConfiguration config(name, "./" + name, "uci");
+	config.setSupportedVariants(variants);
+	return config;
+}
+
+void tst_EngineManager::lookup() const
+{
+	EngineManager manager;
+	QCOMPARE(manager.engineIndex("a"), -1);
+
+	manager.addEngine(engine("a"));
+	manager.addEngine(engine("b"));
+	manager.addEngine(engine("a"));
+	manager.addEngine(engine("c"));
+
+	QCOMPARE(manager.engineIndex("a"), 0);
+	QCOMPARE(manager.engineIndex("b"), 1);
+	QCOMPARE(manager.engineIndex("c"), 3);
+	QCOMPARE(manager.engineNameCount("a"), 2);
+	QCOMPARE(manager.engineNameCount("d"), 0);
+	QCOMPARE(manager.engineNames(), QSet<QString>() << "a" << "b" << "c");
+
+	manager.removeEngineAt(0);
+	QCOMPARE(manager.engineIndex("a"), 1);
+	QCOMPARE(manager.engineIndex("b"), 0);
+	QCOMPARE(manager.engineIndex("c"), 2);
+	QCOMPARE(manager.engineNameCount("a"), 1);
+
+	manager.updateEngineAt(1, engine("d"));
+	QCOMPARE(manager.engineIndex("a"), -1);
+	QCOMPARE(manager.engineIndex("d"), 1);
+
+	manager.setEngines(QList<EngineConfiguration>() << engine("e"));
+	QCOMPARE(manager.engineIndex("b"), -1);
+	QCOMPARE(manager.engineIndex("e"), 0);
+}
+
+void tst_EngineManager::variants() const
+{
+	EngineManager manager;
+	QVERIFY(!manager.supportsVariant("standard"));
+
+	manager.addEngine(engine("a", QStringList() << "standard" << "atomic"));
+	manager.addEngine(engine("b", QStringList() << "standard" << "standard"));
+	QVERIFY(manager.supportsVariant("standard"));
+	QVERIFY(!manager.supportsVariant("atomic"));
+
+	manager.updateEngineAt(1, engine("b", QStringList() << "atomic"));
+	QVERIFY(!manager.supportsVariant("standard"));
+	QVERIFY(manager.supportsVariant("atomic"));
+
+	manager.removeEngineAt(1);
+	QVERIFY(manager.supportsVariant("standard"));
+}
+
+QTEST_MAIN(tst_EngineManager)
+#include "tst_enginemanager.moc"
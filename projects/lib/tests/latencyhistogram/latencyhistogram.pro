@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_latencyhistogram
+SOURCES += tst_latencyhistogram.cpp
@@ -0,0 +1,94 @@
+#include <QtTest/QtTest>
+#include <latencyhistogram.h>
+
+
+class tst_LatencyHistogram: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void empty() const;
+		void smallValues() const;
+		void percentiles() const;
+		void accuracy() const;
+		void merge() const;
+};
+
+
+void tst_LatencyHistogram::empty() const
+{
+	LatencyHistogram latency;
+
+	QVERIFY(latency.isEmpty());
+	QCOMPARE(latency.count(), qint64(0));
+	QCOMPARE(latency.max(), qint64(0));
+	QCOMPARE(latency.sum(), qint64(0));
+	QCOMPARE(latency.percentile(50), qint64(0));
+}
+
+void tst_LatencyHistogram::smallValues() const
+{
+	LatencyHistogram latency;
+	latency.add(3);
+	latency.add(7);
+	latency.add(3);
+
+	QCOMPARE(latency.count(), qint64(3));
+	QCOMPARE(latency.percentile(50), qint64(3));
+	QCOMPARE(latency.percentile(100), qint64(7));
+	QCOMPARE(latency.max(), qint64(7));
+	QCOMPARE(latency.sum(), qint64(13));
+}
+
+void tst_LatencyHistogram::percentiles() const
+{
+	LatencyHistogram latency;
+	for (int i = 1; i <= 100; i++)
+		latency.add(i);
+
+	QCOMPARE(latency.count(), qint64(100));
+	QCOMPARE(latency.percentile(50), qint64(51));
+	QCOMPARE(latency.percentile(99), qint64(99));
+	QCOMPARE(latency.percentile(100), qint64(100));
+	QCOMPARE(latency.max(), qint64(100));
+}
+
+void tst_LatencyHistogram::accuracy() const
+{
+	const qint64 values[] = { 1234, 56789, 1000000, 987654321 };
+
+	for (qint64 value : values)
+	{
+		LatencyHistogram latency;
+		latency.add(value);
+		latency.add(value * 2);
+
+		qint64 p50 = latency.percentile(50);
+		QVERIFY(p50 >= value);
+		QVERIFY(p50 <= value + value / 16);
+	}
+}
+
+void tst_LatencyHistogram::merge() const
+{
+	LatencyHistogram latency1;
+	latency1.add(10);
+	latency1.add(20000);
+
+	LatencyHistogram latency2;
+	latency2.add(5);
+
+	latency1.merge(latency2);
+	QCOMPARE(latency1.count(), qint64(3));
+	QCOMPARE(latency1.max(), qint64(20000));
+	QCOMPARE(latency1.sum(), qint64(20015));
+	QCOMPARE(latency1.percentile(1), qint64(5));
+	QCOMPARE(latency1.percentile(50), qint64(10));
+
+	latency1.clear();
+	QVERIFY(latency1.isEmpty());
+	QCOMPARE(latency1.sum(), qint64(0));
+}
+
+QTEST_MAIN(tst_LatencyHistogram)
+#include "tst_latencyhistogram.moc"
@@ -1,5 +1,6 @@
 #include <QtTest/QtTest>
 #include <mersenne.h>
+#include <randomstream.h>
 
 class tst_Mersenne: public QObject
 {
@@ -8,6 +9,8 @@ class tst_Mersenne: public QObject
 	private slots:
 		void numbers_data();
 		void numbers();
+		void streams();
+		void streamScope();
 };
 
 void tst_Mersenne::numbers_data()
@@ -38,6 +41,54 @@ void tst_Mersenne::numbers()
 	QCOMPARE(Mersenne::random(), random2);
 }
 
+void tst_Mersenne::streams()
+{
+	RandomStream stream1(1234, 1);
+	RandomStream stream2(1234, 1);
+	RandomStream other(1234, 2);
+
+	QVERIFY(stream1.isValid());
+	QVERIFY(!RandomStream().isValid());
+
+	QVector<quint32> numbers;
+	for (int i = 0; i < 10; i++)
+		numbers << stream1.next();
+	QCOMPARE(stream1.position(), quint64(10));
+
+	bool differs = false;
+	for (int i = 0; i < 10; i++)
+	{
+		QCOMPARE(stream2.next(), numbers.at(i));
+		if (other.next() != numbers.at(i))
+			differs = true;
+	}
+	QVERIFY(differs);
+
+	stream1.seek(4);
+	QCOMPARE(stream1.next(), numbers.at(4));
+}
+
+void tst_Mersenne::streamScope()
+{
+	RandomStream stream(99, 7);
+	RandomStream copy(stream);
+
+	{
+		RandomStream::Scope scope(&stream);
+		QCOMPARE(RandomStream::current(), &stream);
+		QCOMPARE(Mersenne::random(), copy.next());
+		QCOMPARE(Mersenne::random(), copy.next());
+	}
+	QVERIFY(RandomStream::current() == nullptr);
+
+	// An invalid stream leaves the global generator in use
+	RandomStream invalid;
+	RandomStream::Scope scope(&invalid);
+	QVERIFY(RandomStream::current() == nullptr);
+
+	Mersenne::initialize(5);
+	QCOMPARE(Mersenne::seed(), quint32(5));
+}
 
 QTEST_MAIN(tst_Mersenne)
 #include "tst_mersenne.moc"
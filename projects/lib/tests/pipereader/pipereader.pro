@@ -1,4 +1,5 @@
 include(../tests.pri)
 
 TARGET = tst_pipereader
-SOURCES += tst_pipereader.cpp
+win32:SOURCES += tst_pipereader.cpp
+linux|macx:SOURCES += tst_pipereader_unix.cpp
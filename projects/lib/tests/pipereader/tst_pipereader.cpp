@@ -29,15 +29,8 @@ void tst_Pipereader::initTestCase()
 	m_read = INVALID_HANDLE_VALUE;
 	m_write = INVALID_HANDLE_VALUE;
 
-	SECURITY_ATTRIBUTES sa;
-	sa.nLength = sizeof(SECURITY_ATTRIBUTES);
-	sa.bInheritHandle = TRUE;
-	sa.lpSecurityDescriptor = NULL;
-
-	CreatePipe(&m_read, &m_write, &sa, 0);
-
+	QVERIFY(PipeReader::createPipe(&m_read, &m_write, false));
 	m_reader = new PipeReader(m_read, this);
-	m_reader->start();
 }
 
 void tst_Pipereader::cleanupTestCase()
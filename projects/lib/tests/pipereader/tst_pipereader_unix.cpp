@@ -0,0 +1,212 @@
+#include <QtTest/QtTest>
+#include <pipereader_unix.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+class tst_PipeReader: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void init();
+		void cleanup();
+
+		void initialized();
+		void partialLine();
+		void wholeLines();
+		void compaction();
+		void largeInput_data();
+		void largeInput();
+		void finished();
+
+	private:
+		bool write(const QByteArray& data);
+		QByteArray read(qint64 maxSize);
+
+		int m_read;
+		int m_write;
+		PipeReader* m_reader;
+		int m_readyReadCount;
+		int m_finishedCount;
+};
+
+
+void tst_PipeReader::init()
+{
+	m_read = -1;
+	m_write = -1;
+	m_reader = nullptr;
+
+	int fds[2];
+	QVERIFY(pipe(fds) == 0);
+	m_read = fds[0];
+	m_write = fds[1];
+	QVERIFY(fcntl(m_read, F_SETFL, fcntl(m_read, F_GETFL) | O_NONBLOCK) == 0);
+
+	// The signals are sent by the reactor thread and queued to
+	// this thread, so the counters need no locking
+	m_readyReadCount = 0;
+	m_finishedCount = 0;
+	m_reader = new PipeReader(m_read);
+	connect(m_reader, &PipeReader::readyRead,
+		this, [this]() { m_readyReadCount++; });
+	connect(m_reader, &PipeReader::finished,
+		this, [this]() { m_finishedCount++; });
+}
+
+void tst_PipeReader::cleanup()
+{
+	delete m_reader;
+	m_reader = nullptr;
+	if (m_write != -1)
+		::close(m_write);
+	if (m_read != -1)
+		::close(m_read);
+}
+
+bool tst_PipeReader::write(const QByteArray& data)
+{
+	// The reactor thread empties the pipe while this blocks
+	const char* p = data.constData();
+	qint64 left = data.size();
+	while (left > 0)
+	{
+		ssize_t n = ::write(m_write, p, size_t(left));
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n == -1)
+			return false;
+		p += n;
+		left -= n;
+	}
+	return true;
+}
+
+QByteArray tst_PipeReader::read(qint64 maxSize)
+{
+	QByteArray data(int(maxSize), 0);
+	qint64 n = m_reader->readData(data.data(), maxSize);
+	data.resize(n < 0 ? 0 : int(n));
+	return data;
+}
+
+void tst_PipeReader::initialized()
+{
+	QCOMPARE(m_reader->bytesAvailable(), qint64(0));
+	QCOMPARE(m_reader->canReadLine(), false);
+	QCOMPARE(m_reader->isFinished(), false);
+	QVERIFY(!m_reader->lineTimer().isValid());
+}
+
+void tst_PipeReader::partialLine()
+{
+	QVERIFY(write("go depth"));
+	QTRY_COMPARE(m_reader->bytesAvailable(), qint64(8));
+	QTest::qWait(50);
+	QCOMPARE(m_reader->canReadLine(), false);
+	QCOMPARE(m_readyReadCount, 0);
+
+	QVERIFY(write(" 10\n"));
+	QTRY_COMPARE(m_readyReadCount, 1);
+	QVERIFY(m_reader->canReadLine());
+	QVERIFY(m_reader->lineTimer().isValid());
+	QCOMPARE(m_reader->bytesAvailable(), qint64(12));
+	QCOMPARE(read(100), QByteArray("go depth 10\n"));
+	QCOMPARE(m_reader->canReadLine(), false);
+}
+
+void tst_PipeReader::wholeLines()
+{
+	QVERIFY(write("line 1\nline 2\n"));
+	QTRY_COMPARE(m_reader->bytesAvailable(), qint64(14));
+	QVERIFY(m_reader->canReadLine());
+
+	QCOMPARE(read(7), QByteArray("line 1\n"));
+	QVERIFY(m_reader->canReadLine());
+	QCOMPARE(read(7), QByteArray("line 2\n"));
+	QCOMPARE(m_reader->canReadLine(), false);
+	QCOMPARE(m_reader->bytesAvailable(), qint64(0));
+	QCOMPARE(m_reader->readData(nullptr, 100), qint64(-1));
+}
+
+void tst_PipeReader::compaction()
+{
+	QVERIFY(write("first line\nsecond"));
+	QTRY_COMPARE(m_reader->bytesAvailable(), qint64(17));
+
+	// Reading more than half of the buffer compacts it, and the
+	// remaining partial line isn't a line yet
+	QCOMPARE(read(11), QByteArray("first line\n"));
+	QCOMPARE(m_reader->canReadLine(), false);
+	QCOMPARE(m_reader->bytesAvailable(), qint64(6));
+
+	QVERIFY(write(" line\nthird line\n"));
+	QTRY_COMPARE(m_reader->bytesAvailable(), qint64(23));
+	QVERIFY(m_reader->canReadLine());
+
+	// A short read doesn't compact the buffer
+	QCOMPARE(read(3), QByteArray("sec"));
+	QVERIFY(m_reader->canReadLine());
+	QCOMPARE(read(9), QByteArray("ond line\n"));
+	QVERIFY(m_reader->canReadLine());
+	QCOMPARE(read(100), QByteArray("third line\n"));
+	QCOMPARE(m_reader->canReadLine(), false);
+}
+
+void tst_PipeReader::largeInput_data()
+{
+	QTest::addColumn<QByteArray>("data");
+	QTest::addColumn<int>("chunkSize");
+
+	QByteArray lines;
+	for (int i = 0; i < 1000; i++)
+		lines += "info depth " + QByteArray::number(i)
+		       + " pv " + QByteArray(80, 'x') + '\n';
+	QTest::newRow("many lines") << lines << 4096;
+
+	// The end of the line comes in a later read() from the pipe
+	QTest::newRow("long line") << QByteArray(40000, 'y') + '\n' << 1000;
+}
+
+void tst_PipeReader::largeInput()
+{
+	QFETCH(QByteArray, data);
+	QFETCH(int, chunkSize);
+	QVERIFY(data.size() > 0x8000);
+
+	QVERIFY(write(data));
+	QTRY_COMPARE(m_reader->bytesAvailable(), qint64(data.size()));
+	QVERIFY(m_reader->canReadLine());
+
+	QByteArray received;
+	while (m_reader->bytesAvailable() > 0)
+	{
+		QVERIFY(m_reader->canReadLine());
+		received += read(chunkSize);
+	}
+	QCOMPARE(received, data);
+	QCOMPARE(m_reader->canReadLine(), false);
+}
+
+void tst_PipeReader::finished()
+{
+	QVERIFY(write("bestmove e2e4\nquit"));
+	::close(m_write);
+	m_write = -1;
+
+	QTRY_COMPARE(m_finishedCount, 1);
+	QVERIFY(m_reader->isFinished());
+
+	// The data written before the pipe was closed is still there
+	QCOMPARE(m_reader->bytesAvailable(), qint64(18));
+	QCOMPARE(read(14), QByteArray("bestmove e2e4\n"));
+	QCOMPARE(read(100), QByteArray("quit"));
+
+	QTest::qWait(50);
+	QCOMPARE(m_finishedCount, 1);
+}
+
+
+QTEST_MAIN(tst_PipeReader)
+#include "tst_pipereader_unix.moc"
@@ -10,6 +10,8 @@ class tst_PolyglotBook: public QObject
 	private slots:
 		void initialValues();
 		void startPos();
+		void statistics();
+		void probeCache();
 
 	private:
 		QMap<QString,quint16> entries(const OpeningBook* book,
@@ -74,5 +76,57 @@ void tst_PolyglotBook::startPos()
 	QCOMPARE(entries, expect);
 }
 
+void tst_PolyglotBook::statistics()
+{
+	auto book = PolyglotBook(OpeningBook::Ram);
+	QVERIFY(book.read("book_small.bin"));
+	QCOMPARE(book.statistics().probes, Q_INT64_C(0));
+
+	QVERIFY(!book.move(Q_UINT64_C(0x463b96181691fc9c)).isNull());
+	QVERIFY(book.move(1234).isNull());
+
+	auto stats = book.statistics();
+	QCOMPARE(stats.probes, Q_INT64_C(2));
+	QCOMPARE(stats.hits, Q_INT64_C(1));
+	QCOMPARE(stats.entries, Q_INT64_C(11));
+	QVERIFY(stats.probeTime >= 0);
+
+	book.resetStatistics();
+	QCOMPARE(book.statistics().probes, Q_INT64_C(0));
+}
+
+void tst_PolyglotBook::probeCache()
+{
+	const quint64 key = Q_UINT64_C(0x463b96181691fc9c);
+
+	auto book = PolyglotBook(OpeningBook::Ram);
+	QVERIFY(book.read("book_small.bin"));
+	const auto expected = book.entries(key);
+
+	book.setProbeCacheSize(16);
+	QCOMPARE(book.probeCacheSize(), 16);
+	QVERIFY(!book.move(key).isNull());
+	QVERIFY(!book.move(key).isNull());
+	QVERIFY(book.move(1234).isNull());
+	QVERIFY(book.move(1234).isNull());
+
+	auto stats = book.statistics();
+	QCOMPARE(stats.probes, Q_INT64_C(4));
+	QCOMPARE(stats.hits, Q_INT64_C(2));
+	QCOMPARE(stats.cacheHits, Q_INT64_C(2));
+
+	const auto cached = book.entries(key);
+	QCOMPARE(cached.size(), expected.size());
+	for (int i = 0; i < cached.size(); i++)
+	{
+		QCOMPARE(cached.at(i).move, expected.at(i).move);
+		QCOMPARE(cached.at(i).weight, expected.at(i).weight);
+	}
+
+	book.setProbeCacheSize(0);
+	QCOMPARE(book.probeCacheSize(), 0);
+	QCOMPARE(book.entries(key).size(), expected.size());
+}
+
 QTEST_MAIN(tst_PolyglotBook)
 #include "tst_polyglotbook.moc"
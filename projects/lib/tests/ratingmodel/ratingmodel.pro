@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_ratingmodel
+SOURCES += tst_ratingmodel.cpp
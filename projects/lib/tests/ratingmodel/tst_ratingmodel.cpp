@@ -0,0 +1,66 @@
+#include <QtTest/QtTest>
+#include <ratingmodel.h>
+
+
+class tst_RatingModel: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void twoPlayers() const;
+		void opponentStrength() const;
+		void perfectScore() const;
+};
+
+
+void tst_RatingModel::twoPlayers() const
+{
+	// A 60% score is about 70 Elo points
+	RatingModel ratings(2);
+	for (int i = 0; i < 300; i++)
+	{
+		ratings.addResult(0, 1, 2);
+		ratings.addResult(0, 1, 1);
+		ratings.addResult(1, 0, 1);
+	}
+	for (int i = 0; i < 100; i++)
+		ratings.addResult(1, 0, 2);
+
+	QVERIFY(qAbs(ratings.rating(0) - ratings.rating(1) - 70.4) < 0.5);
+	QVERIFY(qAbs(ratings.rating(0) + ratings.rating(1)) < 0.001);
+	QVERIFY(ratings.errorMargin(0) > 15.0);
+	QVERIFY(ratings.errorMargin(0) < 30.0);
+}
+
+void tst_RatingModel::opponentStrength() const
+{
+	// Player 1 scores 50% like player 2, but against a much
+	// stronger opponent
+	RatingModel ratings(3);
+	for (int i = 0; i < 100; i++)
+	{
+		ratings.addResult(0, 1, 2);
+		ratings.addResult(1, 2, 2);
+		ratings.addResult(0, 2, 1);
+	}
+	QVERIFY(ratings.rating(0) > ratings.rating(1));
+	QVERIFY(ratings.rating(1) > ratings.rating(2));
+
+	// More games update the warm-started solution
+	const qreal before = ratings.rating(2);
+	for (int i = 0; i < 100; i++)
+		ratings.addResult(2, 1, 2);
+	QVERIFY(ratings.rating(2) > before);
+}
+
+void tst_RatingModel::perfectScore() const
+{
+	RatingModel ratings(2);
+	ratings.addResult(0, 1, 2);
+
+	QVERIFY(qIsFinite(ratings.rating(0)));
+	QVERIFY(ratings.rating(0) > 0.0);
+}
+
+QTEST_MAIN(tst_RatingModel)
+#include "tst_ratingmodel.moc"
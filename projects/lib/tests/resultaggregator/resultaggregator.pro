@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_resultaggregator
+SOURCES += tst_resultaggregator.cpp
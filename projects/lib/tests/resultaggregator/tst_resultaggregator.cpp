@@ -0,0 +1,73 @@
+#include <QtTest/QtTest>
+#include <thread>
+#include <vector>
+#include <resultaggregator.h>
+#include <board/result.h>
+
+
+class tst_ResultAggregator: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void results() const;
+		void threads() const;
+};
+
+
+void tst_ResultAggregator::results() const
+{
+	ResultAggregator results(3);
+	QCOMPARE(results.playerCount(), 3);
+	QCOMPARE(results.gameCount(), 0);
+
+	results.addResult(0, 1, Chess::Result(Chess::Result::Win, Chess::Side::White));
+	results.addResult(1, 2, Chess::Result(Chess::Result::Win, Chess::Side::Black));
+	results.addResult(2, 0, Chess::Result(Chess::Result::Draw));
+	results.addResult(0, 2, Chess::Result());
+
+	QCOMPARE(results.gameCount(), 3);
+
+	auto score = results.score(0);
+	QCOMPARE(score.wins, 1);
+	QCOMPARE(score.draws, 1);
+	QCOMPARE(score.losses, 0);
+
+	score = results.score(1);
+	QCOMPARE(score.wins, 0);
+	QCOMPARE(score.draws, 0);
+	QCOMPARE(score.losses, 2);
+
+	score = results.scores().at(2);
+	QCOMPARE(score.wins, 1);
+	QCOMPARE(score.draws, 1);
+	QCOMPARE(score.losses, 0);
+}
+
+void tst_ResultAggregator::threads() const
+{
+	const int threadCount = 8;
+	static const int gameCount = 10000;
+	ResultAggregator results(2);
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < threadCount; i++)
+	{
+		threads.emplace_back([&results]()
+		{
+			const Chess::Result win(Chess::Result::Win,
+						Chess::Side::White);
+			for (int j = 0; j < gameCount; j++)
+				results.addResult(0, 1, win);
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+
+	QCOMPARE(results.gameCount(), threadCount * gameCount);
+	QCOMPARE(results.score(0).wins, threadCount * gameCount);
+	QCOMPARE(results.score(1).losses, threadCount * gameCount);
+}
+
+QTEST_MAIN(tst_ResultAggregator)
+#include "tst_resultaggregator.moc"
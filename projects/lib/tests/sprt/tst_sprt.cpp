@@ -9,6 +9,9 @@ class tst_Sprt: public QObject
 	private slots:
 		void sprt_data() const;
 		void sprt();
+		void pentanomial();
+		void eloScale_data() const;
+		void eloScale();
 
 	private:
 		bool fuzzyCompare(double val1, double val2);
@@ -100,5 +103,57 @@ void tst_Sprt::sprt()
 	QVERIFY(fuzzyCompare(status.uBound, ubound));
 }
 
+void tst_Sprt::pentanomial()
+{
+	Sprt sprt;
+	sprt.initialize(0.0, 5.0, 0.05, 0.05, Sprt::Pentanomial);
+	QCOMPARE(sprt.model(), Sprt::Pentanomial);
+
+	for (int i = 0; i < 50; i++)
+		sprt.addGamePairResult(Sprt::Loss, Sprt::Loss);
+	for (int i = 0; i < 400; i++)
+		sprt.addGamePairResult(Sprt::Draw, Sprt::Loss);
+	for (int i = 0; i < 500; i++)
+	{
+		sprt.addGamePairResult(Sprt::Draw, Sprt::Draw);
+		sprt.addGamePairResult(Sprt::Loss, Sprt::Win);
+	}
+	for (int i = 0; i < 450; i++)
+		sprt.addGamePairResult(Sprt::Win, Sprt::Draw);
+	for (int i = 0; i < 60; i++)
+		sprt.addGamePairResult(Sprt::Win, Sprt::Win);
+	sprt.addGamePairResult(Sprt::Win, Sprt::NoResult);
+
+	Sprt::Status status = sprt.status();
+	QCOMPARE(status.result, Sprt::Continue);
+	QVERIFY(fuzzyCompare(status.llr, 1.83));
+	QVERIFY(fuzzyCompare(status.lBound, -2.94));
+	QVERIFY(fuzzyCompare(status.uBound, 2.94));
+}
+
+void tst_Sprt::eloScale_data() const
+{
+	QTest::addColumn<int>("eloScale");
+	QTest::addColumn<double>("llr");
+
+	QTest::newRow("logistic") << int(Sprt::LogisticScale) << 2.52;
+	QTest::newRow("normalized") << int(Sprt::NormalizedScale) << 2.79;
+	QTest::newRow("bayes") << int(Sprt::BayesScale) << 2.81;
+}
+
+void tst_Sprt::eloScale()
+{
+	QFETCH(int, eloScale);
+	QFETCH(double, llr);
+
+	Sprt sprt;
+	sprt.initialize(0.0, 10.0, 0.01, 0.01, Sprt::Trinomial,
+			Sprt::EloScale(eloScale));
+	QCOMPARE(sprt.eloScale(), Sprt::EloScale(eloScale));
+
+	Sprt::Status status = sprt.status(1477, 1351, 2942);
+	QVERIFY(fuzzyCompare(status.llr, llr));
+}
+
 QTEST_MAIN(tst_Sprt)
 #include "tst_sprt.moc"
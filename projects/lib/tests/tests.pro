@@ -1,5 +1,5 @@
 TEMPLATE = subdirs
-SUBDIRS = chessboard tb sprt mersenne tournamentplayer tournamentpair polyglotbook
-win32 {
+SUBDIRS = chessboard tb sprt mersenne tournamentplayer tournamentpair polyglotbook latencyhistogram cpuallocator resultaggregator ratingmodel adjudicationreplay enginemanager compactpgngame timerwheel
+win32|linux|macx {
     SUBDIRS += pipereader
 }
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_timerwheel
+SOURCES += tst_timerwheel.cpp
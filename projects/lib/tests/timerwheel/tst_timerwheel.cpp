@@ -0,0 +1,88 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <timerwheel.h>
+
+
+class tst_TimerWheel: public QObject
+{
+	Q_OBJECT
+
+	private slots:
+		void singleShot();
+		void stop();
+		void restart();
+		void order();
+};
+
+
+void tst_TimerWheel::singleShot()
+{
+	WheelTimer timer;
+	QSignalSpy spy(&timer, SIGNAL(timeout()));
+	QElapsedTimer elapsed;
+
+	elapsed.start();
+	timer.start(100);
+	QVERIFY(timer.isActive());
+
+	QVERIFY(spy.wait(2000));
+	QVERIFY(elapsed.elapsed() >= 100);
+	QVERIFY(!timer.isActive());
+
+	QTest::qWait(300);
+	QCOMPARE(spy.count(), 1);
+}
+
+void tst_TimerWheel::stop()
+{
+	WheelTimer timer;
+	QSignalSpy spy(&timer, SIGNAL(timeout()));
+
+	timer.start(100);
+	timer.stop();
+	QVERIFY(!timer.isActive());
+
+	QTest::qWait(300);
+	QCOMPARE(spy.count(), 0);
+}
+
+void tst_TimerWheel::restart()
+{
+	WheelTimer timer;
+	timer.setInterval(200);
+	QSignalSpy spy(&timer, SIGNAL(timeout()));
+	QElapsedTimer elapsed;
+
+	// Restarting pushes the deadline back every time
+	elapsed.start();
+	timer.start();
+	for (int i = 0; i < 5; i++)
+	{
+		QTest::qWait(100);
+		timer.start();
+	}
+	QCOMPARE(spy.count(), 0);
+
+	QVERIFY(spy.wait(2000));
+	QVERIFY(elapsed.elapsed() >= 700);
+	QCOMPARE(spy.count(), 1);
+}
+
+void tst_TimerWheel::order()
+{
+	WheelTimer timer1;
+	WheelTimer timer2;
+	QSignalSpy spy1(&timer1, SIGNAL(timeout()));
+	QSignalSpy spy2(&timer2, SIGNAL(timeout()));
+
+	timer1.start(400);
+	timer2.start(100);
+
+	QVERIFY(spy2.wait(2000));
+	QCOMPARE(spy1.count(), 0);
+	QVERIFY(spy1.wait(2000));
+	QCOMPARE(spy2.count(), 1);
+}
+
+QTEST_MAIN(tst_TimerWheel)
+#include "tst_timerwheel.moc"